@@ -0,0 +1,176 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// Macro-benchmark for a Cormorant-style multi-layer workload,
+// promoted from the old testCormorant sketch. Where benchGElib times
+// individual kernels in isolation, this target runs a whole model --
+// a stack of layers each computing the fused CG-product + learned
+// channel mix of its input with itself, forward and backward -- over a
+// fixed synthetic molecule batch, so cache pressure, allocator
+// behavior and the interleaving of different kernels are all
+// exercised the way a deployed network exercises them. Layer-by-layer
+// and end-to-end wall times are reported alongside the per-layer op
+// statistics (calls/flops/bytes) from the structured profiler, and the
+// same JSON records as benchGElib are written so the existing
+// baseline/check tooling applies.
+//
+// Usage: benchCormorant [output.json]       (default cormorant_results.json)
+
+#include "GElib_base.cpp"
+#include "GElibSession.hpp"
+#include "SO3vecB.hpp"
+#include "SO3weights.hpp"
+
+#include <fstream>
+
+using namespace cnine;
+using namespace GElib;
+
+
+// Fixed model: the batch plays the role of the atoms of a medium-size
+// molecule, each carrying maxl+1 fragments of nchannels channels; the
+// depth and widths are chosen to mirror the published Cormorant
+// configuration rather than to flatter any particular kernel.
+const int natoms=32;
+const int nchannels=16;
+const int model_maxl=3;
+const int nlayers=4;
+
+const int warmup_reps=2;
+const int timed_reps=10;
+
+
+struct layer_stats{
+  double fwd_ms=0;
+  double bwd_ms=0;
+  long flops=0;
+  long bytes=0;
+};
+
+
+int main(int argc, char** argv){
+  GElibSession session;
+  cout<<endl;
+
+  string outfile="cormorant_results.json";
+  if(argc>1) outfile=argv[1];
+
+  const int dev=0;
+
+  SO3type tau;
+  for(int l=0; l<=model_maxl; l++)
+    tau.push_back(nchannels);
+  const SO3type ptau=GElib::CGproduct(tau,tau,model_maxl);
+
+  // The synthetic dataset and the weight stack are built once, before
+  // any timing, so every repetition sees the same tensors.
+  SO3vecB L0=SO3vecB::gaussian(natoms,tau,dev);
+  vector<SO3weights> weights;
+  for(int k=0; k<nlayers; k++)
+    weights.push_back(SO3weights::gaussian(ptau,tau,dev));
+
+  auto forward=[&](vector<SO3vecB>& acts){
+    acts.clear();
+    acts.push_back(L0);
+    for(int k=0; k<nlayers; k++)
+      acts.push_back(acts.back().CGproduct_mix(acts.back(),weights[k],model_maxl));
+  };
+
+  auto layer_time=[&](const std::function<void()>& body){
+    auto t0=chrono::steady_clock::now();
+    body();
+    return chrono::duration<double,std::milli>(chrono::steady_clock::now()-t0).count();
+  };
+
+  for(int i=0; i<warmup_reps; i++){
+    vector<SO3vecB> acts;
+    forward(acts);
+  }
+
+  vector<layer_stats> layers(nlayers);
+  double total_ms=0;
+
+  for(int rep=0; rep<timed_reps; rep++){
+    vector<SO3vecB> acts;
+    acts.push_back(L0);
+
+    auto t0=chrono::steady_clock::now();
+
+    for(int k=0; k<nlayers; k++){
+      auto s0=gelib_op_stats.totals();
+      layers[k].fwd_ms+=layer_time([&](){
+	  acts.push_back(acts.back().CGproduct_mix(acts.back(),weights[k],model_maxl));});
+      auto s1=gelib_op_stats.totals();
+      for(int i=0; i<GElibOpStats::nops; i++){
+	layers[k].flops+=s1.flops[i]-s0.flops[i];
+	layers[k].bytes+=s1.bytes[i]-s0.bytes[i];
+      }
+    }
+
+    // Backward sweep with a synthetic gradient at the top, mirroring
+    // one training step; gradients of the shared input accumulate.
+    SO3vecB g=SO3vecB::gaussian(natoms,tau,dev);
+    for(int k=nlayers-1; k>=0; k--){
+      SO3vecB xg=SO3vecB::zero(natoms,tau,dev);
+      SO3vecB yg=SO3vecB::zero(natoms,tau,dev);
+      SO3weights wg=SO3weights::zero(ptau,tau,dev);
+      auto s0=gelib_op_stats.totals();
+      layers[k].bwd_ms+=layer_time([&](){
+	  SO3vecB::add_CGproduct_mix_back(xg,yg,wg,g,acts[k],acts[k],weights[k]);});
+      auto s1=gelib_op_stats.totals();
+      for(int i=0; i<GElibOpStats::nops; i++){
+	layers[k].flops+=s1.flops[i]-s0.flops[i];
+	layers[k].bytes+=s1.bytes[i]-s0.bytes[i];
+      }
+      xg.add(yg);
+      g=xg;
+    }
+
+    total_ms+=chrono::duration<double,std::milli>(chrono::steady_clock::now()-t0).count();
+  }
+
+  cout<<"Cormorant macro-benchmark: "<<natoms<<" atoms, "<<nchannels<<" channels, maxl="
+      <<model_maxl<<", "<<nlayers<<" layers, "<<timed_reps<<" reps"<<endl<<endl;
+
+  double fwd_total=0;
+  double bwd_total=0;
+  for(int k=0; k<nlayers; k++){
+    const double f=layers[k].fwd_ms/timed_reps;
+    const double b=layers[k].bwd_ms/timed_reps;
+    fwd_total+=f;
+    bwd_total+=b;
+    cout<<"  layer "<<k<<": forward "<<f<<" ms, backward "<<b<<" ms, "
+	<<layers[k].flops/timed_reps<<" flops, "<<layers[k].bytes/timed_reps<<" bytes"<<endl;
+  }
+  cout<<endl;
+  cout<<"  forward total:  "<<fwd_total<<" ms"<<endl;
+  cout<<"  backward total: "<<bwd_total<<" ms"<<endl;
+  cout<<"  end-to-end:     "<<total_ms/timed_reps<<" ms"<<endl;
+  cout<<endl<<session.stats()<<endl;
+
+  // Same record format as benchGElib so `make benchcheck`-style
+  // tooling can gate on these configurations too; the layer index
+  // rides in the l field.
+  std::ofstream out(outfile,std::ios::trunc);
+  out<<"[\n";
+  for(int k=0; k<nlayers; k++){
+    out<<"{\"op\":\"cormorant_fwd\",\"l\":"<<k<<",\"b\":"<<natoms<<",\"n\":"<<nchannels
+       <<",\"dev\":"<<dev<<",\"reps\":"<<timed_reps<<",\"mean_ms\":"<<layers[k].fwd_ms/timed_reps
+       <<",\"min_ms\":"<<layers[k].fwd_ms/timed_reps<<",\"std_ms\":0},\n";
+    out<<"{\"op\":\"cormorant_bwd\",\"l\":"<<k<<",\"b\":"<<natoms<<",\"n\":"<<nchannels
+       <<",\"dev\":"<<dev<<",\"reps\":"<<timed_reps<<",\"mean_ms\":"<<layers[k].bwd_ms/timed_reps
+       <<",\"min_ms\":"<<layers[k].bwd_ms/timed_reps<<",\"std_ms\":0},\n";
+  }
+  out<<"{\"op\":\"cormorant_total\",\"l\":"<<nlayers<<",\"b\":"<<natoms<<",\"n\":"<<nchannels
+     <<",\"dev\":"<<dev<<",\"reps\":"<<timed_reps<<",\"mean_ms\":"<<total_ms/timed_reps
+     <<",\"min_ms\":"<<total_ms/timed_reps<<",\"std_ms\":0}\n";
+  out<<"]\n";
+  cout<<"Results written to "<<outfile<<endl;
+}
@@ -0,0 +1,255 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// Standalone benchmark sweep over the core kernel matrix: CGproduct,
+// DiagCGproduct, Fproduct and the SO(3) FFT across l, batch size,
+// channel count and device. Unlike the ad-hoc "big" tests, every
+// configuration gets a fixed warmup followed by repeated timed runs
+// (with device synchronization), and the mean/min/stddev of each
+// configuration is written as machine-readable JSON so upgrades can
+// be compared run against run.
+//
+// A stored baseline turns the sweep into a regression gate: --baseline
+// writes the current results as the named baseline for this host/GPU,
+// and --check reruns the sweep and fails loudly (exit status 1) if any
+// configuration is slower than the baseline by more than the given
+// tolerance. `make benchcheck` wraps this for release gating.
+//
+// Usage: benchGElib [output.json]                 (default bench_results.json)
+//        benchGElib --baseline <baseline.json>
+//        benchGElib --check <baseline.json> [tolerance]   (default 0.15)
+
+#include "GElib_base.cpp"
+#include "GElibSession.hpp"
+#include "SO3partB.hpp"
+#include "SO3vecB.hpp"
+
+#include <fstream>
+#include <map>
+
+using namespace cnine;
+using namespace GElib;
+
+
+const int warmup_reps=3;
+const int timed_reps=20;
+
+
+struct measurement{
+  double mean_ms=0;
+  double min_ms=0;
+  double std_ms=0;
+};
+
+
+struct record{
+  string op;
+  int l,b,n,dev;
+  measurement m;
+
+  string key() const{
+    return op+"(l="+to_string(l)+",b="+to_string(b)+",n="+to_string(n)+",dev="+to_string(dev)+")";
+  }
+};
+
+
+// Pulls a numeric field out of one JSON record line as written by
+// write_results below; enough of a parser for our own output format.
+double json_field(const string& line, const string& field){
+  auto p=line.find("\""+field+"\":");
+  if(p==string::npos) return -1;
+  return std::stod(line.substr(p+field.size()+3));
+}
+
+string json_string_field(const string& line, const string& field){
+  auto p=line.find("\""+field+"\":\"");
+  if(p==string::npos) return "";
+  p+=field.size()+4;
+  return line.substr(p,line.find("\"",p)-p);
+}
+
+
+void write_results(const string& path, const vector<record>& records, const int reps){
+  std::ofstream out(path,std::ios::trunc);
+  out<<"[\n";
+  for(int i=0; i<(int)records.size(); i++){
+    const record& r=records[i];
+    out<<"{\"op\":\""<<r.op<<"\",\"l\":"<<r.l<<",\"b\":"<<r.b<<",\"n\":"<<r.n<<",\"dev\":"<<r.dev
+       <<",\"reps\":"<<reps<<",\"mean_ms\":"<<r.m.mean_ms<<",\"min_ms\":"<<r.m.min_ms
+       <<",\"std_ms\":"<<r.m.std_ms<<"}"<<(i<(int)records.size()-1? ",":"")<<"\n";
+  }
+  out<<"]\n";
+}
+
+
+// Baseline is the same JSON the bench writes, one record per line;
+// configurations are matched on (op,l,b,n,dev) and compared on min_ms,
+// the statistic least contaminated by system noise.
+std::map<string,double> read_baseline(const string& path){
+  std::map<string,double> R;
+  std::ifstream in(path);
+  if(!in.good()){
+    cout<<"Error: cannot read baseline file "<<path<<endl;
+    exit(1);
+  }
+  string line;
+  while(std::getline(in,line)){
+    if(line.find("\"op\"")==string::npos) continue;
+    record r;
+    r.op=json_string_field(line,"op");
+    r.l=(int)json_field(line,"l");
+    r.b=(int)json_field(line,"b");
+    r.n=(int)json_field(line,"n");
+    r.dev=(int)json_field(line,"dev");
+    R[r.key()]=json_field(line,"min_ms");
+  }
+  return R;
+}
+
+
+void sync_device(const int dev){
+#ifdef _WITH_CUDA
+  if(dev>0) cudaDeviceSynchronize();
+#endif
+}
+
+
+measurement measure(const int dev, const std::function<void()>& body){
+  for(int i=0; i<warmup_reps; i++) body();
+  sync_device(dev);
+
+  vector<double> t(timed_reps);
+  for(int i=0; i<timed_reps; i++){
+    auto t0=chrono::steady_clock::now();
+    body();
+    sync_device(dev);
+    t[i]=chrono::duration<double,std::milli>(chrono::steady_clock::now()-t0).count();
+  }
+
+  measurement m;
+  m.min_ms=t[0];
+  for(auto x:t){m.mean_ms+=x; m.min_ms=std::min(m.min_ms,x);}
+  m.mean_ms/=timed_reps;
+  for(auto x:t) m.std_ms+=(x-m.mean_ms)*(x-m.mean_ms);
+  m.std_ms=sqrt(m.std_ms/timed_reps);
+  return m;
+}
+
+
+int main(int argc, char** argv){
+  GElibSession session;
+  cout<<endl;
+
+  string outfile="bench_results.json";
+  string baseline_file;
+  bool write_baseline=false;
+  bool check_baseline=false;
+  double tolerance=0.15;
+
+  if(argc>2 && string(argv[1])=="--baseline"){
+    write_baseline=true;
+    baseline_file=argv[2];
+  }else if(argc>2 && string(argv[1])=="--check"){
+    check_baseline=true;
+    baseline_file=argv[2];
+    if(argc>3) tolerance=std::stod(argv[3]);
+  }else if(argc>1) outfile=argv[1];
+
+  vector<int> devices({0});
+#ifdef _WITH_CUDA
+  devices.push_back(1);
+#endif
+
+  vector<record> records;
+  auto emit=[&](const string& op, const int l, const int b, const int n, const int dev, const measurement& m){
+    records.push_back(record({op,l,b,n,dev,m}));
+    cout<<records.back().key()<<" "<<m.mean_ms<<" ms"<<endl;
+  };
+
+
+  // ---- CGproduct / DiagCGproduct ---------------------------------------------------------------------------
+
+  for(auto dev:devices)
+    for(auto l:{1,2,4,8})
+      for(auto b:{1,8,64})
+	for(auto n:{16,64}){
+
+	  SO3partB x=SO3partB::gaussian(b,l,n,dev);
+	  SO3partB y=SO3partB::gaussian(b,l,n,dev);
+
+	  SO3partB r=SO3partB::zero(b,l,n*n,dev);
+	  emit("CGproduct",l,b,n,dev,measure(dev,[&](){r.add_CGproduct(x,y);}));
+
+	  SO3partB rd=SO3partB::zero(b,l,n,dev);
+	  emit("DiagCGproduct",l,b,n,dev,measure(dev,[&](){rd.add_BlockedCGproduct(x,y,1);}));
+	}
+
+
+  // ---- Fproduct --------------------------------------------------------------------------------------------
+
+  for(auto dev:devices)
+    for(auto maxl:{2,4,8})
+      for(auto b:{1,8,64}){
+	SO3vecB x=SO3vecB::Fgaussian(b,maxl,dev);
+	SO3vecB y=SO3vecB::Fgaussian(b,maxl,dev);
+	SO3vecB r=SO3vecB::Fzero(b,maxl,dev);
+	emit("Fproduct",maxl,b,1,dev,measure(dev,[&](){r.add_Fproduct(x,y);}));
+      }
+
+
+  // ---- FFT -------------------------------------------------------------------------------------------------
+
+  for(auto dev:devices)
+    for(auto maxl:{2,4,8})
+      for(auto b:{1,8}){
+	const int N=2*maxl+2;
+	SO3vecB v=SO3vecB::Fgaussian(b,maxl,dev);
+	emit("iFFT",maxl,b,N,dev,measure(dev,[&](){CtensorB f=v.iFFT(N,N,N);}));
+
+	CtensorB f=v.iFFT(N,N,N);
+	SO3vecB w=SO3vecB::Fzero(b,maxl,dev);
+	emit("FFT",maxl,b,N,dev,measure(dev,[&](){w.add_FFT(f);}));
+      }
+
+  if(write_baseline){
+    write_results(baseline_file,records,timed_reps);
+    cout<<endl<<"Baseline written to "<<baseline_file<<endl;
+    return 0;
+  }
+
+  if(check_baseline){
+    std::map<string,double> baseline=read_baseline(baseline_file);
+    int nregressions=0;
+    cout<<endl;
+    for(auto& r:records){
+      auto it=baseline.find(r.key());
+      if(it==baseline.end()){
+	cout<<"  NEW  "<<r.key()<<" (not in baseline)"<<endl;
+	continue;
+      }
+      const double ratio=r.m.min_ms/it->second;
+      if(ratio>1.0+tolerance){
+	cout<<"  FAIL "<<r.key()<<" "<<it->second<<" -> "<<r.m.min_ms<<" ms (+"
+	    <<(int)(100*(ratio-1))<<"%)"<<endl;
+	nregressions++;
+      }
+    }
+    if(nregressions>0){
+      cout<<endl<<nregressions<<" configuration(s) regressed beyond "<<(int)(100*tolerance)
+	  <<"% of baseline "<<baseline_file<<endl;
+      return 1;
+    }
+    cout<<"All configurations within "<<(int)(100*tolerance)<<"% of baseline "<<baseline_file<<endl;
+    return 0;
+  }
+
+  write_results(outfile,records,timed_reps);
+  cout<<endl<<"Results written to "<<outfile<<endl;
+}
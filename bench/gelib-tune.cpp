@@ -0,0 +1,201 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// Offline autotuning and warmup artifact builder. gelib-tune takes a
+// warm-up manifest recorded by a previous session (GELIB_WARMUP), runs
+// the shapes it lists through the kernel sweeps on THIS machine --
+// dispatch thresholds, tile sizes, stream counts, Fproduct kernel
+// variants -- and emits a self-contained artifact directory:
+//
+//   config.txt    tuned knob registry        (GElibConfig)
+//   warmup.txt    bank preload manifest      (GElibWarmupManifest)
+//   fproduct.txt  Fproduct decision table    (SO3FproductTuner)
+//   sph.bin       spherical coefficient tables (SO3_SphCoeffs)
+//   jit/          compiled CG kernel cache   (SO3CGjitKernelBank)
+//
+// A session started with GELIB_ARTIFACT pointing at the directory loads
+// all of it before the first operation, so every host of the same SKU
+// runs at tuned steady-state speed from its first batch, with no
+// in-process benchmarking or lazy table generation.
+//
+// Usage: gelib-tune <manifest.txt> <artifact-dir> [channels] [maxbatch]
+//
+// channels (default 32) is the per-part channel count the sweeps are
+// run at, since the manifest records l-shapes but not widths; maxbatch
+// (default 8192) bounds the large-batch sweeps.
+
+#include <sys/stat.h>
+
+#include "GElib_base.cpp"
+#include "GElibSession.hpp"
+#include "SO3partB.hpp"
+#include "SO3vecB.hpp"
+
+using namespace cnine;
+using namespace GElib;
+
+
+// One warmup pass followed by a few timed repetitions; the sweeps
+// compare candidates on the same workload, so total time is enough.
+double timed(const int dev, const std::function<void()>& body){
+  const int reps=3;
+  body();
+#ifdef _WITH_CUDA
+  if(dev>0) cudaDeviceSynchronize();
+#endif
+  auto t0=chrono::steady_clock::now();
+  for(int i=0; i<reps; i++) body();
+#ifdef _WITH_CUDA
+  if(dev>0) cudaDeviceSynchronize();
+#endif
+  return chrono::duration<double,std::milli>(chrono::steady_clock::now()-t0).count();
+}
+
+
+// Times the workload with the named knob set to each candidate and
+// leaves the winner installed in the registry.
+void sweep_knob(const string& name, const vector<int>& candidates, const std::function<double()>& workload){
+  int best=candidates[0];
+  double best_t=0;
+  for(int i=0; i<(int)candidates.size(); i++){
+    gelib_config->set(name,to_string(candidates[i]));
+    double t=workload();
+    cout<<"  "<<name<<"="<<candidates[i]<<": "<<t<<" ms"<<endl;
+    if(i==0 || t<best_t){best=candidates[i]; best_t=t;}
+  }
+  gelib_config->set(name,to_string(best));
+  cout<<"  -> "<<name<<"="<<best<<endl<<endl;
+}
+
+
+int main(int argc, char** argv){
+
+  if(argc<3){
+    cout<<"Usage: gelib-tune <manifest.txt> <artifact-dir> [channels] [maxbatch]"<<endl;
+    return 1;
+  }
+  const string manifest_file=argv[1];
+  const string artifact=argv[2];
+  const int nch=(argc>3? std::stoi(argv[3]) : 32);
+  const int maxB=(argc>4? std::stoi(argv[4]) : 8192);
+
+  mkdir(artifact.c_str(),0755);
+  mkdir((artifact+"/jit").c_str(),0755);
+  // Kernels JIT-compiled during the device sweeps land straight in the
+  // artifact; setenv before the session so the bank sees it.
+  setenv("GELIB_CG_JIT_CACHE",(artifact+"/jit").c_str(),0);
+
+  GElibSession session;
+  cout<<endl;
+
+  GElibWarmupManifest manifest(manifest_file);
+  if(manifest.cg.size()==0){
+    cout<<"Manifest lists no CG shapes; sweeping a default set."<<endl;
+    for(auto l:{1,2,4}) manifest.cg.push_back(CGindex(l,l,l));
+  }
+  manifest.preload();
+
+  int maxl=0;
+  for(auto& ix:manifest.cg) maxl=std::max(maxl,std::max(ix.l,std::max(ix.l1,ix.l2)));
+  maxl=std::max(maxl,manifest.sphL);
+
+  // The part-level CG workload the CPU sweeps are timed on: every
+  // (l1,l2,l) triple of the manifest at the given batch and width.
+  auto time_cg=[&](const int b, const int n, const int dev){
+    double t=0;
+    for(auto& ix:manifest.cg){
+      SO3partB x=SO3partB::gaussian(b,ix.l1,n,dev);
+      SO3partB y=SO3partB::gaussian(b,ix.l2,n,dev);
+      SO3partB r=SO3partB::zero(b,ix.l,n*n,dev);
+      t+=timed(dev,[&](){r.add_CGproduct(x,y);});
+    }
+    return t;
+  };
+
+
+  // ---- CPU dispatch thresholds and tile sizes --------------------------------------------------------------
+
+  cout<<"Sweeping CPU CG dispatch thresholds..."<<endl;
+  sweep_knob("SO3part_CGproduct_gemm_threshold",{256,1024,4096,16384,1<<30},
+    [&](){return time_cg(64,nch,0);});
+  sweep_knob("SO3part_CGproduct_largeB_threshold",{maxB/8,maxB/2,maxB,1<<30},
+    [&](){return time_cg(maxB,8,0);});
+
+  cout<<"Sweeping blocked-kernel tile sizes..."<<endl;
+  auto time_blocked=[&](){
+    double t=0;
+    for(auto& ix:manifest.cg){
+      const int l=std::min(ix.l1,ix.l2);
+      SO3partB x=SO3partB::gaussian(64,l,nch,0);
+      SO3partB y=SO3partB::gaussian(64,l,nch,0);
+      SO3partB r=SO3partB::zero(64,l,nch,0);
+      t+=timed(0,[&](){r.add_BlockedCGproduct(x,y,1);});
+    }
+    return t;
+  };
+  sweep_knob("SO3part_CGtile_channels",{16,32,64},time_blocked);
+  sweep_knob("SO3part_CGtile_nonzeros",{32,64,128},time_blocked);
+
+
+#ifdef _WITH_CUDA
+
+  // ---- Device sweeps ---------------------------------------------------------------------------------------
+
+  gelib_config->SO3part_CGjit_kernels=true;
+
+  SO3type tau;
+  for(int l=0; l<=maxl; l++) tau.push_back(nch);
+  auto time_vec=[&](const int b){
+    SO3vecB x=SO3vecB::gaussian(b,tau,1);
+    SO3vecB y=SO3vecB::gaussian(b,tau,1);
+    SO3vecB r=SO3vecB::zero(b,GElib::CGproduct(tau,tau,maxl),1);
+    return timed(1,[&](){r.add_CGproduct(x,y);});
+  };
+
+  cout<<"Sweeping CUDA stream count..."<<endl;
+  sweep_knob("cuda_nstreams",{1,2,4,8},[&](){return time_vec(64);});
+
+  cout<<"Sweeping persistent-kernel batch threshold..."<<endl;
+  sweep_knob("SO3vec_CGproduct_persistent_batch",{maxB/8,maxB/2,maxB,1<<30},
+    [&](){return time_vec(maxB);});
+
+  // The Fproduct tuner benchmarks on first lookup; walking the
+  // manifest's triples at representative batch sizes bakes the full
+  // decision table into the artifact.
+  cout<<"Recording Fproduct kernel decisions..."<<endl;
+  for(auto& ix:manifest.cg)
+    for(auto b:{1,8,64,maxB})
+      for(auto kind:{SO3FproductTuner::FWD,SO3FproductTuner::BACK0,SO3FproductTuner::BACK1})
+	SO3Fproduct_tuner.method(kind,ix.l1,ix.l2,ix.l,b,1);
+  cout<<endl;
+
+  // The sweeps above registered constant-memory tables in first-touch
+  // order and accumulated per-shape call counts; repack cg_cmem hottest
+  // first so the manifest's busiest shapes hold the fast tier for the
+  // rest of the process (and for anything run in-process after tuning).
+  cout<<"Rebalancing constant-memory CG tables..."<<endl;
+  SO3_cgbank.rebalance_cmem();
+  cout<<endl;
+
+#endif
+
+
+  // ---- Emit the artifact -----------------------------------------------------------------------------------
+
+  SO3_sphCoeffs.precompute(maxl);
+
+  gelib_config->save(artifact+"/config.txt");
+  GElibWarmupManifest::record().save(artifact+"/warmup.txt");
+  SO3Fproduct_tuner.save(artifact+"/fproduct.txt");
+  SO3_sphCoeffs.save(artifact+"/sph.bin");
+
+  cout<<"Artifact written to "<<artifact<<"/."<<endl;
+  cout<<"Load it with GELIB_ARTIFACT="<<artifact<<"."<<endl;
+}
@@ -0,0 +1,56 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// Batched Legendre polynomial evaluation, see LegendreGen. One thread
+// carries the three-term recurrence for one argument in registers and
+// writes P_0..P_L into the R[l*N+n] layout, so each step is a coalesced
+// row write. The recurrence coefficients are the rationals (2l-1)/l and
+// -(l-1)/l, cheap enough to form in-kernel, so unlike the spherical
+// harmonic kernel no host-side table upload is needed.
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include "GElib_base.hpp"
+
+
+namespace GElib{
+
+  namespace{
+
+    __global__ void Legendre_batched_kernel(const int L, const int N, const float* x, float* R){
+      const int n=blockIdx.x*blockDim.x+threadIdx.x;
+      if(n>=N) return;
+
+      const float xv=x[n];
+      float p0=1;
+      R[n]=p0;
+      if(L<1) return;
+      float p1=xv;
+      R[N+n]=p1;
+
+      for(int l=2; l<=L; l++){
+	const float p=(((float)(2*l-1))*xv*p1-((float)(l-1))*p0)/l;
+	R[l*N+n]=p;
+	p0=p1;
+	p1=p;
+      }
+    }
+
+  }
+
+
+  void Legendre_batched_cu(const int L, const int N, const float* x, float* R, const cudaStream_t& stream){
+    const int nthreads=256;
+    const int nblocks=(N+nthreads-1)/nthreads;
+    Legendre_batched_kernel<<<nblocks,nthreads,0,stream>>>(L,N,x,R);
+  }
+
+}
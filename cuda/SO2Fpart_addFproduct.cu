@@ -0,0 +1,92 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// SO2 Fourier-space pointwise product (mode-wise convolution), see
+// SO2Fpart_addFproduct_Fn. One thread accumulates one (batch, mode,
+// channel) output entry over the diagonal of contributing mode pairs,
+// so adjacent threads read and write adjacent channel entries and all
+// accesses coalesce; with conj set the second factor is conjugated and
+// the constraint k1+k2=k becomes k1-k2=k.
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include "GElib_base.hpp"
+#include "Ctensor3_view.hpp"
+
+
+namespace GElib{
+
+  namespace{
+
+    __global__ void SO2Fpart_addFproduct_kernel(
+      float* rarr, float* rarrc, const int rs0, const int rs1, const int rs2,
+      const float* xarr, const float* xarrc, const int xs0, const int xs1, const int xs2,
+      const float* yarr, const float* yarrc, const int ys0, const int ys1, const int ys2,
+      const int B, const int M, const int Nx, const int Ny, const int nc, const int conj){
+
+      const int t=blockIdx.x*blockDim.x+threadIdx.x;
+      if(t>=B*M*nc) return;
+      const int b=t/(M*nc);
+      const int k=(t/nc)%M;
+      const int c=t%nc;
+
+      float accr=0;
+      float acci=0;
+
+      if(conj==0){
+	const int k1min=(k-Ny+1>0? k-Ny+1 : 0);
+	const int k1max=(k<Nx-1? k : Nx-1);
+	for(int k1=k1min; k1<=k1max; k1++){
+	  const int k2=k-k1;
+	  const float xr=xarr[b*xs0+k1*xs1+c*xs2];
+	  const float xi=xarrc[b*xs0+k1*xs1+c*xs2];
+	  const float yr=yarr[b*ys0+k2*ys1+c*ys2];
+	  const float yi=yarrc[b*ys0+k2*ys1+c*ys2];
+	  accr+=xr*yr-xi*yi;
+	  acci+=xr*yi+xi*yr;
+	}
+      }else{
+	const int k2max=(Ny-1<Nx-1-k? Ny-1 : Nx-1-k);
+	for(int k2=0; k2<=k2max; k2++){
+	  const int k1=k+k2;
+	  const float xr=xarr[b*xs0+k1*xs1+c*xs2];
+	  const float xi=xarrc[b*xs0+k1*xs1+c*xs2];
+	  const float yr=yarr[b*ys0+k2*ys1+c*ys2];
+	  const float yi=-yarrc[b*ys0+k2*ys1+c*ys2];
+	  accr+=xr*yr-xi*yi;
+	  acci+=xr*yi+xi*yr;
+	}
+      }
+
+      rarr[b*rs0+k*rs1+c*rs2]+=accr;
+      rarrc[b*rs0+k*rs1+c*rs2]+=acci;
+    }
+
+  }
+
+
+  void SO2Fpart_addFproduct_cu(const cnine::Ctensor3_view& r, const cnine::Ctensor3_view& x,
+    const cnine::Ctensor3_view& y, const int conj, const cudaStream_t& stream){
+
+    const int B=r.n0;
+    const int M=r.n1;
+    const int nc=r.n2;
+
+    const int nthreads=256;
+    const int nblocks=(B*M*nc+nthreads-1)/nthreads;
+    SO2Fpart_addFproduct_kernel<<<nblocks,nthreads,0,stream>>>
+      (r.arr,r.arrc,r.s0,r.s1,r.s2,
+	x.arr,x.arrc,x.s0,x.s1,x.s2,
+	y.arr,y.arrc,y.s0,y.s1,y.s2,
+	B,M,x.n1,y.n1,nc,conj);
+  }
+
+}
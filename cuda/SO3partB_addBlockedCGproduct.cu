@@ -0,0 +1,267 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// Blocked CG product kernels for bsize>1, the generalization of the
+// diagonal (bsize==1) kernels: block n of the x channels is multiplied
+// against block n of the y channels, writing the bsize*bsize column
+// products of each block to offs+(n*bsize+n1)*bsize+n2. The forward
+// kernel assigns one thread per output column, the backward kernels one
+// thread per gradient input column, each sweeping the packed
+// nonzeros-only coefficient list with the modes carried in registers;
+// adjacent threads own adjacent channel entries, so all global accesses
+// coalesce. The packed tables are uploaded once per (l1,l2,l) into a
+// device-side cache owned by this translation unit.
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include <map>
+#include <mutex>
+
+#include "GElib_base.hpp"
+#include "Ctensor3_view.hpp"
+#include "SO3_CGbank.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+
+#define GELIB_BLOCKEDCG_MAXL 16
+
+
+namespace GElib{
+
+  namespace{
+
+    __global__ void SO3partB_addBlockedCGproduct_kernel(
+      float* rarr, float* rarrc, const int rs0, const int rs1, const int rs2,
+      const float* xarr, const float* xarrc, const int xs0, const int xs1, const int xs2,
+      const float* yarr, const float* yarrc, const int ys0, const int ys1, const int ys2,
+      const int B, const int N, const int bsize, const int l, const int offs,
+      const int32_t* nzix, const float* nzc, const int nnz){
+
+      const int t=blockIdx.x*blockDim.x+threadIdx.x;
+      if(t>=B*N*bsize*bsize) return;
+      const int b=t/(N*bsize*bsize);
+      const int j=t-b*N*bsize*bsize;
+      const int n=j/(bsize*bsize);
+      const int n1=(j/bsize)%bsize;
+      const int n2=j%bsize;
+
+      const int cx=n*bsize+n1;
+      const int cy=n*bsize+n2;
+
+      float2 acc[2*GELIB_BLOCKEDCG_MAXL+1];
+      for(int m=0; m<2*l+1; m++) acc[m]=make_float2(0,0);
+
+      for(int k=0; k<nnz; k++){
+	const int32_t ix=nzix[k];
+	const int m1=(ix>>16)&255;
+	const int m2=(ix>>8)&255;
+	const int m=ix&255;
+	const float c=nzc[k];
+	const float xr=xarr[b*xs0+m1*xs1+cx*xs2];
+	const float xi=xarrc[b*xs0+m1*xs1+cx*xs2];
+	const float yr=yarr[b*ys0+m2*ys1+cy*ys2];
+	const float yi=yarrc[b*ys0+m2*ys1+cy*ys2];
+	acc[m].x+=c*(xr*yr-xi*yi);
+	acc[m].y+=c*(xr*yi+xi*yr);
+      }
+
+      const int col=offs+j;
+      for(int m=0; m<2*l+1; m++){
+	rarr[b*rs0+m*rs1+col*rs2]+=acc[m].x;
+	rarrc[b*rs0+m*rs1+col*rs2]+=acc[m].y;
+      }
+    }
+
+
+    __global__ void SO3partB_addBlockedCGproduct_back0_kernel(
+      float* xarr, float* xarrc, const int xs0, const int xs1, const int xs2,
+      const float* garr, const float* garrc, const int gs0, const int gs1, const int gs2,
+      const float* yarr, const float* yarrc, const int ys0, const int ys1, const int ys2,
+      const int B, const int N, const int bsize, const int l1, const int offs,
+      const int32_t* nzix, const float* nzc, const int nnz){
+
+      const int t=blockIdx.x*blockDim.x+threadIdx.x;
+      if(t>=B*N*bsize) return;
+      const int b=t/(N*bsize);
+      const int cx=t-b*N*bsize;
+      const int n=cx/bsize;
+      const int n1=cx%bsize;
+
+      float2 acc[2*GELIB_BLOCKEDCG_MAXL+1];
+      for(int m1=0; m1<2*l1+1; m1++) acc[m1]=make_float2(0,0);
+
+      for(int k=0; k<nnz; k++){
+	const int32_t ix=nzix[k];
+	const int m1=(ix>>16)&255;
+	const int m2=(ix>>8)&255;
+	const int m=ix&255;
+	const float c=nzc[k];
+	for(int n2=0; n2<bsize; n2++){
+	  const int col=offs+(n*bsize+n1)*bsize+n2;
+	  const float gr=garr[b*gs0+m*gs1+col*gs2];
+	  const float gi=garrc[b*gs0+m*gs1+col*gs2];
+	  const int cy=n*bsize+n2;
+	  const float yr=yarr[b*ys0+m2*ys1+cy*ys2];
+	  const float yi=-yarrc[b*ys0+m2*ys1+cy*ys2];
+	  acc[m1].x+=c*(gr*yr-gi*yi);
+	  acc[m1].y+=c*(gr*yi+gi*yr);
+	}
+      }
+
+      for(int m1=0; m1<2*l1+1; m1++){
+	xarr[b*xs0+m1*xs1+cx*xs2]+=acc[m1].x;
+	xarrc[b*xs0+m1*xs1+cx*xs2]+=acc[m1].y;
+      }
+    }
+
+
+    __global__ void SO3partB_addBlockedCGproduct_back1_kernel(
+      float* yarr, float* yarrc, const int ys0, const int ys1, const int ys2,
+      const float* garr, const float* garrc, const int gs0, const int gs1, const int gs2,
+      const float* xarr, const float* xarrc, const int xs0, const int xs1, const int xs2,
+      const int B, const int N, const int bsize, const int l2, const int offs,
+      const int32_t* nzix, const float* nzc, const int nnz){
+
+      const int t=blockIdx.x*blockDim.x+threadIdx.x;
+      if(t>=B*N*bsize) return;
+      const int b=t/(N*bsize);
+      const int cy=t-b*N*bsize;
+      const int n=cy/bsize;
+      const int n2=cy%bsize;
+
+      float2 acc[2*GELIB_BLOCKEDCG_MAXL+1];
+      for(int m2=0; m2<2*l2+1; m2++) acc[m2]=make_float2(0,0);
+
+      for(int k=0; k<nnz; k++){
+	const int32_t ix=nzix[k];
+	const int m1=(ix>>16)&255;
+	const int m2=(ix>>8)&255;
+	const int m=ix&255;
+	const float c=nzc[k];
+	for(int n1=0; n1<bsize; n1++){
+	  const int col=offs+(n*bsize+n1)*bsize+n2;
+	  const float gr=garr[b*gs0+m*gs1+col*gs2];
+	  const float gi=garrc[b*gs0+m*gs1+col*gs2];
+	  const int cx=n*bsize+n1;
+	  const float xr=xarr[b*xs0+m1*xs1+cx*xs2];
+	  const float xi=-xarrc[b*xs0+m1*xs1+cx*xs2];
+	  acc[m2].x+=c*(gr*xr-gi*xi);
+	  acc[m2].y+=c*(gr*xi+gi*xr);
+	}
+      }
+
+      for(int m2=0; m2<2*l2+1; m2++){
+	yarr[b*ys0+m2*ys1+cy*ys2]+=acc[m2].x;
+	yarrc[b*ys0+m2*ys1+cy*ys2]+=acc[m2].y;
+      }
+    }
+
+
+    // Device-side cache of the packed CG tables, keyed by the current
+    // device and (l1,l2,l) so multi-GPU runs never reuse pointers
+    // cudaMalloc'd on another device. Uploads happen at most once per
+    // (device,triple).
+
+    std::mutex cg_dev_mx;
+    std::map<int,std::pair<int32_t*,float*> > cg_dev_cache;
+
+    void get_cg_dev(const int l1, const int l2, const int l, int32_t*& dix, float*& dc, int& nnz){
+      const SO3_CGcoeffs<float>& coeffs=SO3_cgbank.getf(CGindex(l1,l2,l));
+      nnz=coeffs.packed_ix.size();
+      int dev=0;
+      cudaGetDevice(&dev);
+      std::lock_guard<std::mutex> lock(cg_dev_mx);
+      const int key=(dev<<24)|(l1<<16)|(l2<<8)|l;
+      auto it=cg_dev_cache.find(key);
+      if(it==cg_dev_cache.end()){
+	cudaMalloc(&dix,nnz*sizeof(int32_t));
+	cudaMalloc(&dc,nnz*sizeof(float));
+	cudaMemcpy(dix,coeffs.packed_ix.data(),nnz*sizeof(int32_t),cudaMemcpyHostToDevice);
+	cudaMemcpy(dc,coeffs.packed_c.data(),nnz*sizeof(float),cudaMemcpyHostToDevice);
+	cg_dev_cache[key]=std::make_pair(dix,dc);
+      }else{
+	dix=it->second.first;
+	dc=it->second.second;
+      }
+    }
+
+  }
+
+
+  void SO3partB_addBlockedCGproduct_cu(cnine::Ctensor3_view r, const cnine::Ctensor3_view& x,
+    const cnine::Ctensor3_view& y, const int bsize, const int offs, const cudaStream_t& stream){
+
+    const int l=(r.n1-1)/2;
+    const int l1=(x.n1-1)/2;
+    const int l2=(y.n1-1)/2;
+    const int B=x.n0;
+    const int N=x.n2/bsize;
+    assert(l<=GELIB_BLOCKEDCG_MAXL);
+
+    int32_t* dix; float* dc; int nnz;
+    get_cg_dev(l1,l2,l,dix,dc,nnz);
+
+    const int nthreads=256;
+    const int nblocks=(B*N*bsize*bsize+nthreads-1)/nthreads;
+    SO3partB_addBlockedCGproduct_kernel<<<nblocks,nthreads,0,stream>>>
+      (r.arr,r.arrc,r.s0,r.s1,r.s2,
+	x.arr,x.arrc,x.s0,x.s1,x.s2,
+	y.arr,y.arrc,y.s0,y.s1,y.s2,
+	B,N,bsize,l,offs,dix,dc,nnz);
+  }
+
+
+  void SO3partB_addBlockedCGproduct_back0_cu(cnine::Ctensor3_view xg, const cnine::Ctensor3_view& g,
+    const cnine::Ctensor3_view& y, const int bsize, const int offs, const cudaStream_t& stream){
+
+    const int l=(g.n1-1)/2;
+    const int l1=(xg.n1-1)/2;
+    const int l2=(y.n1-1)/2;
+    const int B=xg.n0;
+    const int N=xg.n2/bsize;
+    assert(l1<=GELIB_BLOCKEDCG_MAXL);
+
+    int32_t* dix; float* dc; int nnz;
+    get_cg_dev(l1,l2,l,dix,dc,nnz);
+
+    const int nthreads=256;
+    const int nblocks=(B*N*bsize+nthreads-1)/nthreads;
+    SO3partB_addBlockedCGproduct_back0_kernel<<<nblocks,nthreads,0,stream>>>
+      (xg.arr,xg.arrc,xg.s0,xg.s1,xg.s2,
+	g.arr,g.arrc,g.s0,g.s1,g.s2,
+	y.arr,y.arrc,y.s0,y.s1,y.s2,
+	B,N,bsize,l1,offs,dix,dc,nnz);
+  }
+
+
+  void SO3partB_addBlockedCGproduct_back1_cu(cnine::Ctensor3_view yg, const cnine::Ctensor3_view& g,
+    const cnine::Ctensor3_view& x, const int bsize, const int offs, const cudaStream_t& stream){
+
+    const int l=(g.n1-1)/2;
+    const int l1=(x.n1-1)/2;
+    const int l2=(yg.n1-1)/2;
+    const int B=yg.n0;
+    const int N=yg.n2/bsize;
+    assert(l2<=GELIB_BLOCKEDCG_MAXL);
+
+    int32_t* dix; float* dc; int nnz;
+    get_cg_dev(l1,l2,l,dix,dc,nnz);
+
+    const int nthreads=256;
+    const int nblocks=(B*N*bsize+nthreads-1)/nthreads;
+    SO3partB_addBlockedCGproduct_back1_kernel<<<nblocks,nthreads,0,stream>>>
+      (yg.arr,yg.arrc,yg.s0,yg.s1,yg.s2,
+	g.arr,g.arrc,g.s0,g.s1,g.s2,
+	x.arr,x.arrc,x.s0,x.s1,x.s2,
+	B,N,bsize,l2,offs,dix,dc,nnz);
+  }
+
+}
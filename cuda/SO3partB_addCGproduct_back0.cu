@@ -0,0 +1,150 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// Backward (x gradient) of the generic CG product. One warp owns one
+// (batch,x-channel) gradient column: the lanes stride over the y
+// channels of the inner reduction, sweep the packed nonzeros-only
+// coefficient list with their partial sums in registers, and the warp
+// then reduces each of the 2*l1+1 accumulators with __shfl_down_sync so
+// lane 0 writes every output entry exactly once. No global-memory
+// atomics are involved, so backward results are bitwise reproducible
+// run to run. The packed tables are uploaded once per (l1,l2,l) into a
+// device-side cache owned by this translation unit.
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include <map>
+#include <mutex>
+
+#include "GElib_base.hpp"
+#include "Ctensor3_view.hpp"
+#include "SO3_CGbank.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+
+#define GELIB_CGBACK_MAXL 16
+
+
+namespace GElib{
+
+  namespace{
+
+    __global__ void SO3partB_addCGproduct_back0_kernel(
+      float* xarr, float* xarrc, const int xs0, const int xs1, const int xs2,
+      const float* garr, const float* garrc, const int gs0, const int gs1, const int gs2,
+      const float* yarr, const float* yarrc, const int ys0, const int ys1, const int ys2,
+      const int B, const int N1, const int N2, const int l1, const int offs,
+      const int32_t* nzix, const float* nzc, const int nnz, const int m1lo){
+
+      const int w=(blockIdx.x*blockDim.x+threadIdx.x)/32;
+      const int lane=threadIdx.x%32;
+      if(w>=B*N1) return;
+      const int b=w/N1;
+      const int n1=w%N1;
+
+      // The register array covers the m1 window [m1lo,m1lo+span); for
+      // l1<=GELIB_CGBACK_MAXL a single window spans all of [0,2*l1+1).
+      const int span=min(2*l1+1-m1lo,2*GELIB_CGBACK_MAXL+1);
+      float2 acc[2*GELIB_CGBACK_MAXL+1];
+      for(int i=0; i<span; i++) acc[i]=make_float2(0,0);
+
+      for(int k=0; k<nnz; k++){
+	const int32_t ix=nzix[k];
+	const int m1=(ix>>16)&255;
+	if(m1<m1lo || m1>=m1lo+span) continue;
+	const int m2=(ix>>8)&255;
+	const int m=ix&255;
+	const float c=nzc[k];
+	for(int n2=lane; n2<N2; n2+=32){
+	  const int col=offs+n1*N2+n2;
+	  const float gr=garr[b*gs0+m*gs1+col*gs2];
+	  const float gi=garrc[b*gs0+m*gs1+col*gs2];
+	  const float yr=yarr[b*ys0+m2*ys1+n2*ys2];
+	  const float yi=-yarrc[b*ys0+m2*ys1+n2*ys2];
+	  acc[m1-m1lo].x+=c*(gr*yr-gi*yi);
+	  acc[m1-m1lo].y+=c*(gr*yi+gi*yr);
+	}
+      }
+
+      for(int i=0; i<span; i++){
+	float sr=acc[i].x;
+	float si=acc[i].y;
+	for(int d=16; d>0; d>>=1){
+	  sr+=__shfl_down_sync(0xffffffff,sr,d,32);
+	  si+=__shfl_down_sync(0xffffffff,si,d,32);
+	}
+	if(lane==0){
+	  const int m1=m1lo+i;
+	  xarr[b*xs0+m1*xs1+n1*xs2]+=sr;
+	  xarrc[b*xs0+m1*xs1+n1*xs2]+=si;
+	}
+      }
+    }
+
+
+    // Device-side cache of the packed CG tables, keyed by the current
+    // device and (l1,l2,l): the pointers come from cudaMalloc on one
+    // specific GPU, so on multi-GPU runs each device gets its own
+    // upload. Uploads happen at most once per (device,triple).
+
+    std::mutex cg_dev_mx;
+    std::map<int,std::pair<int32_t*,float*> > cg_dev_cache;
+
+    void get_cg_dev(const int l1, const int l2, const int l, int32_t*& dix, float*& dc, int& nnz){
+      const SO3_CGcoeffs<float>& coeffs=SO3_cgbank.getf(CGindex(l1,l2,l));
+      nnz=coeffs.packed_ix.size();
+      int dev=0;
+      cudaGetDevice(&dev);
+      std::lock_guard<std::mutex> lock(cg_dev_mx);
+      const int key=(dev<<24)|(l1<<16)|(l2<<8)|l;
+      auto it=cg_dev_cache.find(key);
+      if(it==cg_dev_cache.end()){
+	cudaMalloc(&dix,nnz*sizeof(int32_t));
+	cudaMalloc(&dc,nnz*sizeof(float));
+	cudaMemcpy(dix,coeffs.packed_ix.data(),nnz*sizeof(int32_t),cudaMemcpyHostToDevice);
+	cudaMemcpy(dc,coeffs.packed_c.data(),nnz*sizeof(float),cudaMemcpyHostToDevice);
+	cg_dev_cache[key]=std::make_pair(dix,dc);
+      }else{
+	dix=it->second.first;
+	dc=it->second.second;
+      }
+    }
+
+  }
+
+
+  void SO3partB_addCGproduct_back0_cu(const cnine::Ctensor3_view& xg, cnine::Ctensor3_view g,
+    const cnine::Ctensor3_view& y, const int offs, const cudaStream_t& stream){
+
+    const int l=(g.n1-1)/2;
+    const int l1=(xg.n1-1)/2;
+    const int l2=(y.n1-1)/2;
+    const int B=xg.n0;
+    const int N1=xg.n2;
+    const int N2=y.n2;
+
+    int32_t* dix; float* dc; int nnz;
+    get_cg_dev(l1,l2,l,dix,dc,nnz);
+
+    const int nthreads=256;
+    const int nblocks=(B*N1*32+nthreads-1)/nthreads;
+    // One launch covers l1<=GELIB_CGBACK_MAXL; beyond that the m1 range
+    // is processed in register-array-sized windows, each launch
+    // sweeping the nonzero list for its window.
+    for(int m1lo=0; m1lo<2*l1+1; m1lo+=2*GELIB_CGBACK_MAXL+1)
+      SO3partB_addCGproduct_back0_kernel<<<nblocks,nthreads,0,stream>>>
+	(xg.arr,xg.arrc,xg.s0,xg.s1,xg.s2,
+	  g.arr,g.arrc,g.s0,g.s1,g.s2,
+	  y.arr,y.arrc,y.s0,y.s1,y.s2,
+	  B,N1,N2,l1,offs,dix,dc,nnz,m1lo);
+  }
+
+}
@@ -0,0 +1,147 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// Backward (y gradient) of the generic CG product, the mirror image of
+// SO3partB_addCGproduct_back0.cu: one warp owns one (batch,y-channel)
+// gradient column, the lanes stride over the x channels of the inner
+// reduction, and the 2*l2+1 accumulators are reduced with
+// __shfl_down_sync so lane 0 writes every output entry exactly once --
+// no global-memory atomics, bitwise reproducible results.
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include <map>
+#include <mutex>
+
+#include "GElib_base.hpp"
+#include "Ctensor3_view.hpp"
+#include "SO3_CGbank.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+
+#define GELIB_CGBACK_MAXL 16
+
+
+namespace GElib{
+
+  namespace{
+
+    __global__ void SO3partB_addCGproduct_back1_kernel(
+      float* yarr, float* yarrc, const int ys0, const int ys1, const int ys2,
+      const float* garr, const float* garrc, const int gs0, const int gs1, const int gs2,
+      const float* xarr, const float* xarrc, const int xs0, const int xs1, const int xs2,
+      const int B, const int N1, const int N2, const int l2, const int offs,
+      const int32_t* nzix, const float* nzc, const int nnz, const int m2lo){
+
+      const int w=(blockIdx.x*blockDim.x+threadIdx.x)/32;
+      const int lane=threadIdx.x%32;
+      if(w>=B*N2) return;
+      const int b=w/N2;
+      const int n2=w%N2;
+
+      // The register array covers the m2 window [m2lo,m2lo+span); for
+      // l2<=GELIB_CGBACK_MAXL a single window spans all of [0,2*l2+1).
+      const int span=min(2*l2+1-m2lo,2*GELIB_CGBACK_MAXL+1);
+      float2 acc[2*GELIB_CGBACK_MAXL+1];
+      for(int i=0; i<span; i++) acc[i]=make_float2(0,0);
+
+      for(int k=0; k<nnz; k++){
+	const int32_t ix=nzix[k];
+	const int m1=(ix>>16)&255;
+	const int m2=(ix>>8)&255;
+	if(m2<m2lo || m2>=m2lo+span) continue;
+	const int m=ix&255;
+	const float c=nzc[k];
+	for(int n1=lane; n1<N1; n1+=32){
+	  const int col=offs+n1*N2+n2;
+	  const float gr=garr[b*gs0+m*gs1+col*gs2];
+	  const float gi=garrc[b*gs0+m*gs1+col*gs2];
+	  const float xr=xarr[b*xs0+m1*xs1+n1*xs2];
+	  const float xi=-xarrc[b*xs0+m1*xs1+n1*xs2];
+	  acc[m2-m2lo].x+=c*(gr*xr-gi*xi);
+	  acc[m2-m2lo].y+=c*(gr*xi+gi*xr);
+	}
+      }
+
+      for(int i=0; i<span; i++){
+	float sr=acc[i].x;
+	float si=acc[i].y;
+	for(int d=16; d>0; d>>=1){
+	  sr+=__shfl_down_sync(0xffffffff,sr,d,32);
+	  si+=__shfl_down_sync(0xffffffff,si,d,32);
+	}
+	if(lane==0){
+	  const int m2=m2lo+i;
+	  yarr[b*ys0+m2*ys1+n2*ys2]+=sr;
+	  yarrc[b*ys0+m2*ys1+n2*ys2]+=si;
+	}
+      }
+    }
+
+
+    // Device-side cache of the packed CG tables, keyed by the current
+    // device and (l1,l2,l): the pointers come from cudaMalloc on one
+    // specific GPU, so on multi-GPU runs each device gets its own
+    // upload. Uploads happen at most once per (device,triple).
+
+    std::mutex cg_dev_mx;
+    std::map<int,std::pair<int32_t*,float*> > cg_dev_cache;
+
+    void get_cg_dev(const int l1, const int l2, const int l, int32_t*& dix, float*& dc, int& nnz){
+      const SO3_CGcoeffs<float>& coeffs=SO3_cgbank.getf(CGindex(l1,l2,l));
+      nnz=coeffs.packed_ix.size();
+      int dev=0;
+      cudaGetDevice(&dev);
+      std::lock_guard<std::mutex> lock(cg_dev_mx);
+      const int key=(dev<<24)|(l1<<16)|(l2<<8)|l;
+      auto it=cg_dev_cache.find(key);
+      if(it==cg_dev_cache.end()){
+	cudaMalloc(&dix,nnz*sizeof(int32_t));
+	cudaMalloc(&dc,nnz*sizeof(float));
+	cudaMemcpy(dix,coeffs.packed_ix.data(),nnz*sizeof(int32_t),cudaMemcpyHostToDevice);
+	cudaMemcpy(dc,coeffs.packed_c.data(),nnz*sizeof(float),cudaMemcpyHostToDevice);
+	cg_dev_cache[key]=std::make_pair(dix,dc);
+      }else{
+	dix=it->second.first;
+	dc=it->second.second;
+      }
+    }
+
+  }
+
+
+  void SO3partB_addCGproduct_back1_cu(const cnine::Ctensor3_view& yg, cnine::Ctensor3_view g,
+    const cnine::Ctensor3_view& x, const int offs, const cudaStream_t& stream){
+
+    const int l=(g.n1-1)/2;
+    const int l1=(x.n1-1)/2;
+    const int l2=(yg.n1-1)/2;
+    const int B=yg.n0;
+    const int N1=x.n2;
+    const int N2=yg.n2;
+
+    int32_t* dix; float* dc; int nnz;
+    get_cg_dev(l1,l2,l,dix,dc,nnz);
+
+    const int nthreads=256;
+    const int nblocks=(B*N2*32+nthreads-1)/nthreads;
+    // One launch covers l2<=GELIB_CGBACK_MAXL; beyond that the m2 range
+    // is processed in register-array-sized windows, each launch
+    // sweeping the nonzero list for its window.
+    for(int m2lo=0; m2lo<2*l2+1; m2lo+=2*GELIB_CGBACK_MAXL+1)
+      SO3partB_addCGproduct_back1_kernel<<<nblocks,nthreads,0,stream>>>
+	(yg.arr,yg.arrc,yg.s0,yg.s1,yg.s2,
+	  g.arr,g.arrc,g.s0,g.s1,g.s2,
+	  x.arr,x.arrc,x.s0,x.s1,x.s2,
+	  B,N1,N2,l2,offs,dix,dc,nnz,m2lo);
+  }
+
+}
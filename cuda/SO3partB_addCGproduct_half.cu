@@ -0,0 +1,328 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// Reduced-precision (fp16/bf16) variants of the batched CG product
+// kernel. Operands and results are stored in half precision with
+// interleaved re/im pairs; all multiply-accumulate is carried out in
+// fp32 registers and the result is rounded once on the final store, so
+// accuracy matches an fp32 kernel up to the storage rounding while the
+// memory traffic of the bandwidth-bound contraction is halved.
+//
+// The CG coefficients are taken in the packed (packed_ix,packed_c) form
+// built by SO3_CGcoeffs and uploaded once per (l1,l2,l) into a
+// device-side cache owned by this translation unit.
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+#include <cuda_fp16.h>
+#include <cuda_bf16.h>
+#include <mma.h>
+
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#define GELIB_HALFCG_MAXL 16
+
+
+namespace GElib{
+
+  namespace{
+
+    __device__ __forceinline__ float to_float(const __half x){return __half2float(x);}
+    __device__ __forceinline__ float to_float(const __nv_bfloat16 x){return __bfloat162float(x);}
+
+    template<typename T> __device__ __forceinline__ T from_float(const float x);
+    template<> __device__ __forceinline__ __half from_float<__half>(const float x){return __float2half(x);}
+    template<> __device__ __forceinline__ __nv_bfloat16 from_float<__nv_bfloat16>(const float x){return __float2bfloat16(x);}
+
+
+    template<typename T>
+    __global__ void SO3partB_addCGproduct_half_kernel(T* rarr, const T* xarr, const T* yarr,
+      const int N1, const int N2, const int rn2, const int l1, const int l2, const int l,
+      const int offs, const int32_t* nzix, const float* nzc, const int nnz, const int mlo){
+
+      const int b=blockIdx.x;
+      const T* x=xarr+((size_t)b)*(2*l1+1)*N1*2;
+      const T* y=yarr+((size_t)b)*(2*l2+1)*N2*2;
+      T* r=rarr+((size_t)b)*(2*l+1)*rn2*2;
+
+      // The register array covers the output-row window [mlo,mlo+span);
+      // for l<=GELIB_HALFCG_MAXL a single window spans all of [0,2*l+1).
+      const int span=min(2*l+1-mlo,2*GELIB_HALFCG_MAXL+1);
+
+      for(int t=threadIdx.x; t<N1*N2; t+=blockDim.x){
+	const int n1=t/N2;
+	const int n2=t-n1*N2;
+
+	float2 acc[2*GELIB_HALFCG_MAXL+1];
+	for(int i=0; i<span; i++) acc[i]=make_float2(0,0);
+
+	for(int k=0; k<nnz; k++){
+	  const int32_t ix=nzix[k];
+	  const int m1=(ix>>16)&255;
+	  const int m2=(ix>>8)&255;
+	  const int m=ix&255;
+	  if(m<mlo || m>=mlo+span) continue;
+	  const float c=nzc[k];
+	  const float xr=to_float(x[(m1*N1+n1)*2]);
+	  const float xi=to_float(x[(m1*N1+n1)*2+1]);
+	  const float yr=to_float(y[(m2*N2+n2)*2]);
+	  const float yi=to_float(y[(m2*N2+n2)*2+1]);
+	  acc[m-mlo].x+=c*(xr*yr-xi*yi);
+	  acc[m-mlo].y+=c*(xr*yi+xi*yr);
+	}
+
+	const int col=offs+n1*N2+n2;
+	for(int i=0; i<span; i++){
+	  T* p=r+((mlo+i)*rn2+col)*2;
+	  p[0]=from_float<T>(to_float(p[0])+acc[i].x);
+	  p[1]=from_float<T>(to_float(p[1])+acc[i].y);
+	}
+      }
+    }
+
+
+    // Tensor-core (WMMA) variant for GEMM-shaped problems. The CG
+    // contraction is lowered to r = C_unrolled * (x (x) y): the
+    // coefficient matrix is unrolled to (2l+1) x (2l1+1)(2l2+1) and the
+    // Kronecker operand tile is built on the fly in shared memory, with
+    // the complex multiply done in fp32 scalar code during tile
+    // construction so the matrix units only ever see the real
+    // coefficient GEMM. Accumulation is in fp32 wmma accumulator
+    // fragments; selected when the column count N1*N2 is a multiple of
+    // the 16-wide fragment size on sm_70+ devices. One warp per block
+    // computes one 16-column tile across all row tiles.
+
+    __global__ void SO3partB_addCGproduct_half_wmma_kernel(__half* rarr, const __half* xarr, const __half* yarr,
+      const int N1, const int N2, const int rn2, const int l1, const int l2, const int l,
+      const int offs, const __half* Cmat, const int Kpad, const int Mtiles){
+#if __CUDA_ARCH__>=700
+      using namespace nvcuda;
+
+      const int b=blockIdx.x;
+      const int j=blockIdx.y;
+      const __half* x=xarr+((size_t)b)*(2*l1+1)*N1*2;
+      const __half* y=yarr+((size_t)b)*(2*l2+1)*N2*2;
+      __half* r=rarr+((size_t)b)*(2*l+1)*rn2*2;
+
+      __shared__ __half Xre[16][16];
+      __shared__ __half Xim[16][16];
+      __shared__ float out[16][16];
+
+      wmma::fragment<wmma::accumulator,16,16,16,float> acc_re[3];
+      wmma::fragment<wmma::accumulator,16,16,16,float> acc_im[3];
+      for(int mt=0; mt<Mtiles; mt++){
+	wmma::fill_fragment(acc_re[mt],0);
+	wmma::fill_fragment(acc_im[mt],0);
+      }
+
+      const int K=(2*l1+1)*(2*l2+1);
+      for(int kt=0; kt<Kpad/16; kt++){
+
+	for(int t=threadIdx.x; t<256; t+=blockDim.x){
+	  const int rr=t/16;
+	  const int cc=t-rr*16;
+	  const int kk=kt*16+rr;
+	  float re=0;
+	  float im=0;
+	  if(kk<K){
+	    const int m1=kk/(2*l2+1);
+	    const int m2=kk-m1*(2*l2+1);
+	    const int n=j*16+cc;
+	    const int n1=n/N2;
+	    const int n2=n-n1*N2;
+	    const float xr=__half2float(x[(m1*N1+n1)*2]);
+	    const float xi=__half2float(x[(m1*N1+n1)*2+1]);
+	    const float yr=__half2float(y[(m2*N2+n2)*2]);
+	    const float yi=__half2float(y[(m2*N2+n2)*2+1]);
+	    re=xr*yr-xi*yi;
+	    im=xr*yi+xi*yr;
+	  }
+	  Xre[rr][cc]=__float2half(re);
+	  Xim[rr][cc]=__float2half(im);
+	}
+	__syncthreads();
+
+	wmma::fragment<wmma::matrix_b,16,16,16,__half,wmma::row_major> bre;
+	wmma::fragment<wmma::matrix_b,16,16,16,__half,wmma::row_major> bim;
+	wmma::load_matrix_sync(bre,&Xre[0][0],16);
+	wmma::load_matrix_sync(bim,&Xim[0][0],16);
+	for(int mt=0; mt<Mtiles; mt++){
+	  wmma::fragment<wmma::matrix_a,16,16,16,__half,wmma::row_major> a;
+	  wmma::load_matrix_sync(a,Cmat+(mt*16)*Kpad+kt*16,Kpad);
+	  wmma::mma_sync(acc_re[mt],a,bre,acc_re[mt]);
+	  wmma::mma_sync(acc_im[mt],a,bim,acc_im[mt]);
+	}
+	__syncthreads();
+      }
+
+      for(int mt=0; mt<Mtiles; mt++){
+	wmma::store_matrix_sync(&out[0][0],acc_re[mt],16,wmma::mem_row_major);
+	__syncthreads();
+	for(int t=threadIdx.x; t<256; t+=blockDim.x){
+	  const int rr=t/16;
+	  const int cc=t-rr*16;
+	  const int m=mt*16+rr;
+	  if(m<2*l+1){
+	    __half* p=r+(m*rn2+offs+j*16+cc)*2;
+	    p[0]=__float2half(__half2float(p[0])+out[rr][cc]);
+	  }
+	}
+	__syncthreads();
+	wmma::store_matrix_sync(&out[0][0],acc_im[mt],16,wmma::mem_row_major);
+	__syncthreads();
+	for(int t=threadIdx.x; t<256; t+=blockDim.x){
+	  const int rr=t/16;
+	  const int cc=t-rr*16;
+	  const int m=mt*16+rr;
+	  if(m<2*l+1){
+	    __half* p=r+(m*rn2+offs+j*16+cc)*2;
+	    p[1]=__float2half(__half2float(p[1])+out[rr][cc]);
+	  }
+	}
+	__syncthreads();
+      }
+#endif
+    }
+
+
+    // Device-side cache of the packed CG tables, keyed by the current
+    // device and (l1,l2,l) so multi-GPU runs never reuse pointers
+    // cudaMalloc'd on another device. Uploads happen at most once per
+    // (device,triple) and never from inside a graph capture (the
+    // callers warm the cache up front).
+
+    std::mutex cg_dev_mx;
+    std::map<int,std::pair<int32_t*,float*> > cg_dev_cache;
+
+    void get_cg_dev(const int l1, const int l2, const int l,
+      const int32_t* hix, const float* hc, const int nnz, int32_t*& dix, float*& dc){
+      int dev=0;
+      cudaGetDevice(&dev);
+      std::lock_guard<std::mutex> lock(cg_dev_mx);
+      const int key=(dev<<24)|(l1<<16)|(l2<<8)|l;
+      auto it=cg_dev_cache.find(key);
+      if(it==cg_dev_cache.end()){
+	cudaMalloc(&dix,nnz*sizeof(int32_t));
+	cudaMalloc(&dc,nnz*sizeof(float));
+	cudaMemcpy(dix,hix,nnz*sizeof(int32_t),cudaMemcpyHostToDevice);
+	cudaMemcpy(dc,hc,nnz*sizeof(float),cudaMemcpyHostToDevice);
+	cg_dev_cache[key]=std::make_pair(dix,dc);
+      }else{
+	dix=it->second.first;
+	dc=it->second.second;
+      }
+    }
+
+
+    // Dense unrolled half-precision coefficient matrices for the WMMA
+    // path, (Mtiles*16) x Kpad row-major with zero padding, cached per
+    // (device,l1,l2,l) alongside the packed tables.
+
+    std::map<int,__half*> cg_wmma_cache;
+
+    const __half* get_cg_wmma(const int l1, const int l2, const int l,
+      const int32_t* hix, const float* hc, const int nnz, int& Kpad, int& Mtiles){
+      int dev=0;
+      cudaGetDevice(&dev);
+      std::lock_guard<std::mutex> lock(cg_dev_mx);
+      Mtiles=(2*l+1+15)/16;
+      Kpad=(((2*l1+1)*(2*l2+1))+15)/16*16;
+      const int key=(dev<<24)|(l1<<16)|(l2<<8)|l;
+      auto it=cg_wmma_cache.find(key);
+      if(it!=cg_wmma_cache.end()) return it->second;
+      std::vector<__half> Cmat(Mtiles*16*Kpad,__float2half(0.0f));
+      for(int k=0; k<nnz; k++){
+	const int32_t ix=hix[k];
+	const int m1=(ix>>16)&255;
+	const int m2=(ix>>8)&255;
+	const int m=ix&255;
+	Cmat[m*Kpad+m1*(2*l2+1)+m2]=__float2half(hc[k]);
+      }
+      __half* d;
+      cudaMalloc(&d,Cmat.size()*sizeof(__half));
+      cudaMemcpy(d,Cmat.data(),Cmat.size()*sizeof(__half),cudaMemcpyHostToDevice);
+      cg_wmma_cache[key]=d;
+      return d;
+    }
+
+    int device_sm_major(){
+      static int major=[](){
+	int dev=0; cudaGetDevice(&dev);
+	cudaDeviceProp prop;
+	cudaGetDeviceProperties(&prop,dev);
+	return prop.major;
+      }();
+      return major;
+    }
+
+
+    template<typename T>
+    void launch(T* rarr, const T* xarr, const T* yarr,
+      const int b, const int N1, const int N2, const int rn2,
+      const int l1, const int l2, const int l, const int offs,
+      const int32_t* nzix, const float* nzc, const int nnz, const cudaStream_t& stream){
+      int32_t* dix; float* dc;
+      get_cg_dev(l1,l2,l,nzix,nzc,nnz,dix,dc);
+      const int nthreads=std::min(N1*N2,256);
+      // One launch covers l<=GELIB_HALFCG_MAXL; beyond that the output
+      // rows are processed in register-array-sized windows.
+      for(int mlo=0; mlo<2*l+1; mlo+=2*GELIB_HALFCG_MAXL+1)
+	SO3partB_addCGproduct_half_kernel<T><<<b,nthreads,0,stream>>>
+	  (rarr,xarr,yarr,N1,N2,rn2,l1,l2,l,offs,dix,dc,nnz,mlo);
+    }
+
+    template<>
+    void launch<__half>(__half* rarr, const __half* xarr, const __half* yarr,
+      const int b, const int N1, const int N2, const int rn2,
+      const int l1, const int l2, const int l, const int offs,
+      const int32_t* nzix, const float* nzc, const int nnz, const cudaStream_t& stream){
+
+      // The WMMA kernel holds one accumulator fragment pair per row
+      // tile in a fixed array of 3, so it only serves 2*l+1<=48; larger
+      // l falls through to the windowed scalar kernel.
+      if((N1*N2)%16==0 && (2*l+1+15)/16<=3 && device_sm_major()>=7){
+	int Kpad, Mtiles;
+	const __half* Cmat=get_cg_wmma(l1,l2,l,nzix,nzc,nnz,Kpad,Mtiles);
+	dim3 grid(b,(N1*N2)/16);
+	SO3partB_addCGproduct_half_wmma_kernel<<<grid,32,0,stream>>>
+	  (rarr,xarr,yarr,N1,N2,rn2,l1,l2,l,offs,Cmat,Kpad,Mtiles);
+	return;
+      }
+
+      int32_t* dix; float* dc;
+      get_cg_dev(l1,l2,l,nzix,nzc,nnz,dix,dc);
+      const int nthreads=std::min(N1*N2,256);
+      for(int mlo=0; mlo<2*l+1; mlo+=2*GELIB_HALFCG_MAXL+1)
+	SO3partB_addCGproduct_half_kernel<__half><<<b,nthreads,0,stream>>>
+	  (rarr,xarr,yarr,N1,N2,rn2,l1,l2,l,offs,dix,dc,nnz,mlo);
+    }
+
+  }
+
+
+  void SO3partB_addCGproduct_half_cu(__half* rarr, const __half* xarr, const __half* yarr,
+    const int b, const int N1, const int N2, const int rn2,
+    const int l1, const int l2, const int l, const int offs,
+    const int32_t* nzix, const float* nzc, const int nnz, const cudaStream_t& stream){
+    launch(rarr,xarr,yarr,b,N1,N2,rn2,l1,l2,l,offs,nzix,nzc,nnz,stream);
+  }
+
+  void SO3partB_addCGproduct_bf16_cu(__nv_bfloat16* rarr, const __nv_bfloat16* xarr, const __nv_bfloat16* yarr,
+    const int b, const int N1, const int N2, const int rn2,
+    const int l1, const int l2, const int l, const int offs,
+    const int32_t* nzix, const float* nzc, const int nnz, const cudaStream_t& stream){
+    launch(rarr,xarr,yarr,b,N1,N2,rn2,l1,l2,l,offs,nzix,nzc,nnz,stream);
+  }
+
+}
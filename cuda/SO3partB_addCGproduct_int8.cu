@@ -0,0 +1,137 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// Int8 variant of the batched CG product kernel for quantized
+// inference. Operands and results are interleaved re/im int8 pairs
+// with one float scale per part; the CG coefficients arrive quantized
+// to 8.8 fixed point and all accumulation is in int32, so the result
+// is exact up to the input quantization until the single requantizing
+// store (r += requant*acc, requant=sx*sy/(256*sr), clamped to
+// [-127,127]).
+//
+// Each complex multiply-accumulate runs as two DP4A byte-dot
+// instructions: with the operands packed as [re,im,0,0] bytes,
+// dp4a(x,[yr,-yi]) is the real part and dp4a(x,[yi,yr]) the imaginary
+// part of x*y. Quantization never produces -128, so negating yi is
+// safe. On pre-sm_61 devices the same arithmetic runs in scalar int32.
+//
+// The fixed-point CG tables are cached on the device per (l1,l2,l) by
+// this translation unit, as in the other CG kernels.
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#define GELIB_I8CG_MAXL 16
+
+
+namespace GElib{
+
+  namespace{
+
+    __device__ __forceinline__ int pack2(const int8_t a, const int8_t b){
+      return (((int)(unsigned char)a))|(((int)(unsigned char)b)<<8);
+    }
+
+    __global__ void SO3partB_addCGproduct_int8_kernel(int8_t* rarr, const int8_t* xarr, const int8_t* yarr,
+      const int N1, const int N2, const int rn2, const int l1, const int l2, const int l,
+      const int offs, const float requant, const int32_t* nzix, const int32_t* nzc, const int nnz){
+
+      const int b=blockIdx.x;
+      const int8_t* x=xarr+((size_t)b)*(2*l1+1)*N1*2;
+      const int8_t* y=yarr+((size_t)b)*(2*l2+1)*N2*2;
+      int8_t* r=rarr+((size_t)b)*(2*l+1)*rn2*2;
+
+      for(int t=threadIdx.x; t<N1*N2; t+=blockDim.x){
+	const int n1=t/N2;
+	const int n2=t-n1*N2;
+
+	int2 acc[2*GELIB_I8CG_MAXL+1];
+	for(int m=0; m<2*l+1; m++) acc[m]=make_int2(0,0);
+
+	for(int k=0; k<nnz; k++){
+	  const int32_t ix=nzix[k];
+	  const int m1=(ix>>16)&255;
+	  const int m2=(ix>>8)&255;
+	  const int m=ix&255;
+	  const int32_t c=nzc[k];
+	  const int8_t xr=x[(m1*N1+n1)*2];
+	  const int8_t xi=x[(m1*N1+n1)*2+1];
+	  const int8_t yr=y[(m2*N2+n2)*2];
+	  const int8_t yi=y[(m2*N2+n2)*2+1];
+#if __CUDA_ARCH__>=610
+	  const int xp=pack2(xr,xi);
+	  acc[m].x+=c*__dp4a(xp,pack2(yr,(int8_t)(-yi)),0);
+	  acc[m].y+=c*__dp4a(xp,pack2(yi,yr),0);
+#else
+	  acc[m].x+=c*((int)xr*yr-(int)xi*yi);
+	  acc[m].y+=c*((int)xr*yi+(int)xi*yr);
+#endif
+	}
+
+	const int col=offs+n1*N2+n2;
+	for(int m=0; m<2*l+1; m++){
+	  int8_t* p=r+(m*rn2+col)*2;
+	  const float re=p[0]+requant*acc[m].x;
+	  const float im=p[1]+requant*acc[m].y;
+	  p[0]=(int8_t)max(-127.0f,min(127.0f,rintf(re)));
+	  p[1]=(int8_t)max(-127.0f,min(127.0f,rintf(im)));
+	}
+      }
+    }
+
+
+    // Device-side cache of the fixed-point CG tables, keyed by the
+    // current device and (l1,l2,l) so multi-GPU runs never reuse
+    // pointers cudaMalloc'd on another device.
+
+    std::mutex cg_dev_mx;
+    std::map<int,std::pair<int32_t*,int32_t*> > cg_dev_cache;
+
+    void get_cg_dev(const int l1, const int l2, const int l,
+      const int32_t* hix, const int32_t* hc, const int nnz, int32_t*& dix, int32_t*& dc){
+      int dev=0;
+      cudaGetDevice(&dev);
+      std::lock_guard<std::mutex> lock(cg_dev_mx);
+      const int key=(dev<<24)|(l1<<16)|(l2<<8)|l;
+      auto it=cg_dev_cache.find(key);
+      if(it==cg_dev_cache.end()){
+	cudaMalloc(&dix,nnz*sizeof(int32_t));
+	cudaMalloc(&dc,nnz*sizeof(int32_t));
+	cudaMemcpy(dix,hix,nnz*sizeof(int32_t),cudaMemcpyHostToDevice);
+	cudaMemcpy(dc,hc,nnz*sizeof(int32_t),cudaMemcpyHostToDevice);
+	cg_dev_cache[key]=std::make_pair(dix,dc);
+      }else{
+	dix=it->second.first;
+	dc=it->second.second;
+      }
+    }
+
+  }
+
+
+  void SO3partB_addCGproduct_int8_cu(int8_t* rarr, const int8_t* xarr, const int8_t* yarr,
+    const int b, const int N1, const int N2, const int rn2,
+    const int l1, const int l2, const int l, const int offs, const float requant,
+    const int32_t* nzix, const int32_t* nzc, const int nnz, const cudaStream_t& stream){
+    assert(l<=GELIB_I8CG_MAXL);
+    int32_t* dix; int32_t* dc;
+    get_cg_dev(l1,l2,l,nzix,nzc,nnz,dix,dc);
+    const int nthreads=std::min(N1*N2,256);
+    SO3partB_addCGproduct_int8_kernel<<<b,nthreads,0,stream>>>
+      (rarr,xarr,yarr,N1,N2,rn2,l1,l2,l,offs,requant,dix,dc,nnz);
+  }
+
+}
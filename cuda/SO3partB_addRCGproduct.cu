@@ -0,0 +1,327 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// Cellwise (irregular-stride) CG product and its two backward passes.
+// The RCGproduct Fns see the operands as a grid of 2D cells sharing
+// one (l1,l2,l,N1,N2) shape and one set of strides, differing only in
+// their base pointers, so instead of launching the flat kernel once
+// per cell the Fns collect the cell views and every cell goes out in
+// a single launch: the cell index simply takes the place of the batch
+// index of the flat kernels. The thread mapping is otherwise the same
+// as in SO3partB_addCGproduct_back0/1.cu -- one warp per
+// (cell,channel) with the lanes striding over the inner channel
+// dimension, register accumulators swept over the packed nonzeros-only
+// coefficient list, and warp shuffle reductions in the backward
+// kernels so no global-memory atomics are involved. The cell pointer
+// array is staged through a grow-only device buffer on the launch
+// stream; the packed tables are uploaded once per (l1,l2,l) into a
+// device-side cache owned by this translation unit.
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "GElib_base.hpp"
+#include "Ctensor2_view.hpp"
+#include "SO3_CGbank.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+
+#define GELIB_RCG_MAXL 16
+
+
+namespace GElib{
+
+  namespace{
+
+    // One cell triple; the slots hold the (r|g), x-side and y-side base
+    // pointers in that order, whichever of the three is the output.
+    struct SO3RCGcell{
+      float* arr0; float* arr0c;
+      float* arr1; float* arr1c;
+      float* arr2; float* arr2c;
+    };
+
+
+    __global__ void SO3partB_addRCGproduct_kernel(const SO3RCGcell* cells, const int ncells,
+      const int rs0, const int rs1, const int xs0, const int xs1, const int ys0, const int ys1,
+      const int N1, const int N2, const int l, const int offs,
+      const int32_t* nzix, const float* nzc, const int nnz){
+
+      const int w=(blockIdx.x*blockDim.x+threadIdx.x)/32;
+      const int lane=threadIdx.x%32;
+      if(w>=ncells*N1) return;
+      const SO3RCGcell cell=cells[w/N1];
+      const int n1=w%N1;
+
+      for(int n2=lane; n2<N2; n2+=32){
+	float2 acc[2*GELIB_RCG_MAXL+1];
+	for(int m=0; m<2*l+1; m++) acc[m]=make_float2(0,0);
+
+	for(int k=0; k<nnz; k++){
+	  const int32_t ix=nzix[k];
+	  const int m1=(ix>>16)&255;
+	  const int m2=(ix>>8)&255;
+	  const int m=ix&255;
+	  const float c=nzc[k];
+	  const float xr=cell.arr1[m1*xs0+n1*xs1];
+	  const float xi=cell.arr1c[m1*xs0+n1*xs1];
+	  const float yr=cell.arr2[m2*ys0+n2*ys1];
+	  const float yi=cell.arr2c[m2*ys0+n2*ys1];
+	  acc[m].x+=c*(xr*yr-xi*yi);
+	  acc[m].y+=c*(xr*yi+xi*yr);
+	}
+
+	const int col=offs+n1*N2+n2;
+	for(int m=0; m<2*l+1; m++){
+	  cell.arr0[m*rs0+col*rs1]+=acc[m].x;
+	  cell.arr0c[m*rs0+col*rs1]+=acc[m].y;
+	}
+      }
+    }
+
+
+    __global__ void SO3partB_addRCGproduct_back0_kernel(const SO3RCGcell* cells, const int ncells,
+      const int xs0, const int xs1, const int gs0, const int gs1, const int ys0, const int ys1,
+      const int N1, const int N2, const int l1, const int offs,
+      const int32_t* nzix, const float* nzc, const int nnz){
+
+      const int w=(blockIdx.x*blockDim.x+threadIdx.x)/32;
+      const int lane=threadIdx.x%32;
+      if(w>=ncells*N1) return;
+      const SO3RCGcell cell=cells[w/N1];
+      const int n1=w%N1;
+
+      float2 acc[2*GELIB_RCG_MAXL+1];
+      for(int m1=0; m1<2*l1+1; m1++) acc[m1]=make_float2(0,0);
+
+      for(int k=0; k<nnz; k++){
+	const int32_t ix=nzix[k];
+	const int m1=(ix>>16)&255;
+	const int m2=(ix>>8)&255;
+	const int m=ix&255;
+	const float c=nzc[k];
+	for(int n2=lane; n2<N2; n2+=32){
+	  const int col=offs+n1*N2+n2;
+	  const float gr=cell.arr0[m*gs0+col*gs1];
+	  const float gi=cell.arr0c[m*gs0+col*gs1];
+	  const float yr=cell.arr2[m2*ys0+n2*ys1];
+	  const float yi=-cell.arr2c[m2*ys0+n2*ys1];
+	  acc[m1].x+=c*(gr*yr-gi*yi);
+	  acc[m1].y+=c*(gr*yi+gi*yr);
+	}
+      }
+
+      for(int m1=0; m1<2*l1+1; m1++){
+	float sr=acc[m1].x;
+	float si=acc[m1].y;
+	for(int d=16; d>0; d>>=1){
+	  sr+=__shfl_down_sync(0xffffffff,sr,d,32);
+	  si+=__shfl_down_sync(0xffffffff,si,d,32);
+	}
+	if(lane==0){
+	  cell.arr1[m1*xs0+n1*xs1]+=sr;
+	  cell.arr1c[m1*xs0+n1*xs1]+=si;
+	}
+      }
+    }
+
+
+    __global__ void SO3partB_addRCGproduct_back1_kernel(const SO3RCGcell* cells, const int ncells,
+      const int ys0, const int ys1, const int gs0, const int gs1, const int xs0, const int xs1,
+      const int N1, const int N2, const int l2, const int offs,
+      const int32_t* nzix, const float* nzc, const int nnz){
+
+      const int w=(blockIdx.x*blockDim.x+threadIdx.x)/32;
+      const int lane=threadIdx.x%32;
+      if(w>=ncells*N2) return;
+      const SO3RCGcell cell=cells[w/N2];
+      const int n2=w%N2;
+
+      float2 acc[2*GELIB_RCG_MAXL+1];
+      for(int m2=0; m2<2*l2+1; m2++) acc[m2]=make_float2(0,0);
+
+      for(int k=0; k<nnz; k++){
+	const int32_t ix=nzix[k];
+	const int m1=(ix>>16)&255;
+	const int m2=(ix>>8)&255;
+	const int m=ix&255;
+	const float c=nzc[k];
+	for(int n1=lane; n1<N1; n1+=32){
+	  const int col=offs+n1*N2+n2;
+	  const float gr=cell.arr0[m*gs0+col*gs1];
+	  const float gi=cell.arr0c[m*gs0+col*gs1];
+	  const float xr=cell.arr1[m1*xs0+n1*xs1];
+	  const float xi=-cell.arr1c[m1*xs0+n1*xs1];
+	  acc[m2].x+=c*(gr*xr-gi*xi);
+	  acc[m2].y+=c*(gr*xi+gi*xr);
+	}
+      }
+
+      for(int m2=0; m2<2*l2+1; m2++){
+	float sr=acc[m2].x;
+	float si=acc[m2].y;
+	for(int d=16; d>0; d>>=1){
+	  sr+=__shfl_down_sync(0xffffffff,sr,d,32);
+	  si+=__shfl_down_sync(0xffffffff,si,d,32);
+	}
+	if(lane==0){
+	  cell.arr2[m2*ys0+n2*ys1]+=sr;
+	  cell.arr2c[m2*ys0+n2*ys1]+=si;
+	}
+      }
+    }
+
+
+    // Device-side cache of the packed CG tables, keyed by the current
+    // device and (l1,l2,l) so multi-GPU runs never reuse pointers
+    // cudaMalloc'd on another device. Uploads happen at most once per
+    // (device,triple).
+
+    std::mutex cg_dev_mx;
+    std::map<int,std::pair<int32_t*,float*> > cg_dev_cache;
+
+    void get_cg_dev(const int l1, const int l2, const int l, int32_t*& dix, float*& dc, int& nnz){
+      const SO3_CGcoeffs<float>& coeffs=SO3_cgbank.getf(CGindex(l1,l2,l));
+      nnz=coeffs.packed_ix.size();
+      int dev=0;
+      cudaGetDevice(&dev);
+      std::lock_guard<std::mutex> lock(cg_dev_mx);
+      const int key=(dev<<24)|(l1<<16)|(l2<<8)|l;
+      auto it=cg_dev_cache.find(key);
+      if(it==cg_dev_cache.end()){
+	cudaMalloc(&dix,nnz*sizeof(int32_t));
+	cudaMalloc(&dc,nnz*sizeof(float));
+	cudaMemcpy(dix,coeffs.packed_ix.data(),nnz*sizeof(int32_t),cudaMemcpyHostToDevice);
+	cudaMemcpy(dc,coeffs.packed_c.data(),nnz*sizeof(float),cudaMemcpyHostToDevice);
+	cg_dev_cache[key]=std::make_pair(dix,dc);
+      }else{
+	dix=it->second.first;
+	dc=it->second.second;
+      }
+    }
+
+
+    // Grow-only staging buffer for the cell pointer array, reused
+    // across launches on the same stream.
+
+    SO3RCGcell* cells_dev=nullptr;
+    size_t cells_cap=0;
+
+    const SO3RCGcell* upload_cells(const std::vector<SO3RCGcell>& cells, const cudaStream_t& stream){
+      if(cells.size()>cells_cap){
+	if(cells_dev) cudaFree(cells_dev);
+	cells_cap=cells.size();
+	cudaMalloc(&cells_dev,cells_cap*sizeof(SO3RCGcell));
+      }
+      cudaMemcpyAsync(cells_dev,cells.data(),cells.size()*sizeof(SO3RCGcell),
+	cudaMemcpyHostToDevice,stream);
+      return cells_dev;
+    }
+
+    std::vector<SO3RCGcell> pack_cells(const std::vector<cnine::Ctensor2_view>& a0,
+      const std::vector<cnine::Ctensor2_view>& a1, const std::vector<cnine::Ctensor2_view>& a2){
+      std::vector<SO3RCGcell> cells(a0.size());
+      for(std::size_t i=0; i<a0.size(); i++){
+	assert(a0[i].s0==a0[0].s0 && a0[i].s1==a0[0].s1);
+	assert(a1[i].s0==a1[0].s0 && a1[i].s1==a1[0].s1);
+	assert(a2[i].s0==a2[0].s0 && a2[i].s1==a2[0].s1);
+	cells[i]=SO3RCGcell{a0[i].arr,a0[i].arrc,a1[i].arr,a1[i].arrc,a2[i].arr,a2[i].arrc};
+      }
+      return cells;
+    }
+
+  }
+
+
+  void SO3partB_addRCGproduct_cu(const std::vector<cnine::Ctensor2_view>& r,
+    const std::vector<cnine::Ctensor2_view>& x, const std::vector<cnine::Ctensor2_view>& y,
+    const int offs, const cudaStream_t& stream){
+
+    if(r.size()==0) return;
+    const int l=(r[0].n0-1)/2;
+    const int l1=(x[0].n0-1)/2;
+    const int l2=(y[0].n0-1)/2;
+    const int N1=x[0].n1;
+    const int N2=y[0].n1;
+    assert(l<=GELIB_RCG_MAXL);
+
+    int32_t* dix; float* dc; int nnz;
+    get_cg_dev(l1,l2,l,dix,dc,nnz);
+
+    const std::vector<SO3RCGcell> cells=pack_cells(r,x,y);
+    const SO3RCGcell* dcells=upload_cells(cells,stream);
+
+    const int nthreads=256;
+    const int nblocks=((int)cells.size()*N1*32+nthreads-1)/nthreads;
+    SO3partB_addRCGproduct_kernel<<<nblocks,nthreads,0,stream>>>
+      (dcells,cells.size(),
+	r[0].s0,r[0].s1,x[0].s0,x[0].s1,y[0].s0,y[0].s1,
+	N1,N2,l,offs,dix,dc,nnz);
+  }
+
+
+  void SO3partB_addRCGproduct_back0_cu(const std::vector<cnine::Ctensor2_view>& xg,
+    const std::vector<cnine::Ctensor2_view>& g, const std::vector<cnine::Ctensor2_view>& y,
+    const int offs, const cudaStream_t& stream){
+
+    if(xg.size()==0) return;
+    const int l=(g[0].n0-1)/2;
+    const int l1=(xg[0].n0-1)/2;
+    const int l2=(y[0].n0-1)/2;
+    const int N1=xg[0].n1;
+    const int N2=y[0].n1;
+    assert(l1<=GELIB_RCG_MAXL);
+
+    int32_t* dix; float* dc; int nnz;
+    get_cg_dev(l1,l2,l,dix,dc,nnz);
+
+    const std::vector<SO3RCGcell> cells=pack_cells(g,xg,y);
+    const SO3RCGcell* dcells=upload_cells(cells,stream);
+
+    const int nthreads=256;
+    const int nblocks=((int)cells.size()*N1*32+nthreads-1)/nthreads;
+    SO3partB_addRCGproduct_back0_kernel<<<nblocks,nthreads,0,stream>>>
+      (dcells,cells.size(),
+	xg[0].s0,xg[0].s1,g[0].s0,g[0].s1,y[0].s0,y[0].s1,
+	N1,N2,l1,offs,dix,dc,nnz);
+  }
+
+
+  void SO3partB_addRCGproduct_back1_cu(const std::vector<cnine::Ctensor2_view>& yg,
+    const std::vector<cnine::Ctensor2_view>& g, const std::vector<cnine::Ctensor2_view>& x,
+    const int offs, const cudaStream_t& stream){
+
+    if(yg.size()==0) return;
+    const int l=(g[0].n0-1)/2;
+    const int l1=(x[0].n0-1)/2;
+    const int l2=(yg[0].n0-1)/2;
+    const int N1=x[0].n1;
+    const int N2=yg[0].n1;
+    assert(l2<=GELIB_RCG_MAXL);
+
+    int32_t* dix; float* dc; int nnz;
+    get_cg_dev(l1,l2,l,dix,dc,nnz);
+
+    const std::vector<SO3RCGcell> cells=pack_cells(g,x,yg);
+    const SO3RCGcell* dcells=upload_cells(cells,stream);
+
+    const int nthreads=256;
+    const int nblocks=((int)cells.size()*N2*32+nthreads-1)/nthreads;
+    SO3partB_addRCGproduct_back1_kernel<<<nblocks,nthreads,0,stream>>>
+      (dcells,cells.size(),
+	yg[0].s0,yg[0].s1,g[0].s0,g[0].s1,x[0].s0,x[0].s1,
+	N1,N2,l2,offs,dix,dc,nnz);
+  }
+
+}
@@ -0,0 +1,141 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// GPU kernel for the reducing CG product used in edge aggregation:
+// r(b,j) += sum_k x(b,j,k) (x)_CG y(b,k), i.e. each output cell reduces
+// over the K edge/neighbor axis while applying the CG contraction. One
+// CTA handles one (b,j) cell with threads striding over the channel
+// columns; the K reduction stays in fp32 registers, so nothing is
+// written to global memory until the full sum is formed.
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include <map>
+#include <mutex>
+
+#include "GElib_base.hpp"
+#include "Ctensor4_view.hpp"
+#include "Ctensor5_view.hpp"
+#include "SO3_CGbank.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+
+#define GELIB_REDUCING_CG_MAXL 16
+
+
+namespace GElib{
+
+  namespace{
+
+    __global__ void SO3partB_addReducingCGproduct_kernel(
+      float* rarr, float* rarrc, const int rs0, const int rs1, const int rs2, const int rs3,
+      const float* xarr, const float* xarrc, const int xs0, const int xs1, const int xs2, const int xs3, const int xs4,
+      const float* yarr, const float* yarrc, const int ys0, const int ys1, const int ys2, const int ys3,
+      const int K, const int N1, const int N2, const int l, const int offs,
+      const int32_t* nzix, const float* nzc, const int nnz){
+
+      const int b=blockIdx.x;
+      const int j=blockIdx.y;
+
+      for(int t=threadIdx.x; t<N1*N2; t+=blockDim.x){
+	const int n1=t/N2;
+	const int n2=t-n1*N2;
+
+	float accr[2*GELIB_REDUCING_CG_MAXL+1];
+	float acci[2*GELIB_REDUCING_CG_MAXL+1];
+	for(int m=0; m<2*l+1; m++){accr[m]=0; acci[m]=0;}
+
+	for(int k=0; k<K; k++){
+	  const float* x=xarr+b*xs0+j*xs1+k*xs2;
+	  const float* xc=xarrc+b*xs0+j*xs1+k*xs2;
+	  const float* y=yarr+b*ys0+k*ys1;
+	  const float* yc=yarrc+b*ys0+k*ys1;
+	  for(int p=0; p<nnz; p++){
+	    const int32_t ix=nzix[p];
+	    const int m1=(ix>>16)&255;
+	    const int m2=(ix>>8)&255;
+	    const int m=ix&255;
+	    const float c=nzc[p];
+	    const float xr=x[m1*xs3+n1*xs4];
+	    const float xi=xc[m1*xs3+n1*xs4];
+	    const float yr=y[m2*ys2+n2*ys3];
+	    const float yi=yc[m2*ys2+n2*ys3];
+	    accr[m]+=c*(xr*yr-xi*yi);
+	    acci[m]+=c*(xr*yi+xi*yr);
+	  }
+	}
+
+	const int col=offs+n1*N2+n2;
+	for(int m=0; m<2*l+1; m++){
+	  rarr[b*rs0+j*rs1+m*rs2+col*rs3]+=accr[m];
+	  rarrc[b*rs0+j*rs1+m*rs2+col*rs3]+=acci[m];
+	}
+      }
+    }
+
+
+    // Global-memory copies of the packed CG tables, uploaded once per
+    // (device,l1,l2,l) and owned by this translation unit; the device
+    // is part of the key so multi-GPU runs never reuse pointers
+    // cudaMalloc'd on another device.
+
+    std::mutex reducing_cg_mx;
+    std::map<int,std::pair<int32_t*,float*> > reducing_cg_cache;
+
+    void get_cg_dev(const GElib::SO3_CGcoeffs<float>& C, const int l1, const int l2, const int l,
+      const int32_t*& dix, const float*& dc){
+      int dev=0;
+      cudaGetDevice(&dev);
+      std::lock_guard<std::mutex> lock(reducing_cg_mx);
+      const int key=(dev<<24)|(l1<<16)|(l2<<8)|l;
+      auto it=reducing_cg_cache.find(key);
+      if(it==reducing_cg_cache.end()){
+	const int n=C.packed_ix.size();
+	int32_t* _dix; float* _dc;
+	CUDA_SAFE(cudaMalloc(&_dix,n*sizeof(int32_t)));
+	CUDA_SAFE(cudaMalloc(&_dc,n*sizeof(float)));
+	CUDA_SAFE(cudaMemcpy(_dix,C.packed_ix.data(),n*sizeof(int32_t),cudaMemcpyHostToDevice));
+	CUDA_SAFE(cudaMemcpy(_dc,C.packed_c.data(),n*sizeof(float),cudaMemcpyHostToDevice));
+	it=reducing_cg_cache.insert(std::make_pair(key,std::make_pair(_dix,_dc))).first;
+      }
+      dix=it->second.first;
+      dc=it->second.second;
+    }
+
+  }
+
+
+  void SO3partB_addReducingCGproduct_cu(const cnine::Ctensor4_view& r, const cnine::Ctensor5_view& x,
+    const cnine::Ctensor4_view& y, const int offs, const cudaStream_t& stream){
+
+    const int l=(r.n2-1)/2;
+    const int l1=(x.n3-1)/2;
+    const int l2=(y.n2-1)/2;
+    const int N1=x.n4;
+    const int N2=y.n3;
+    const int K=x.n2;
+    assert(l<=GELIB_REDUCING_CG_MAXL);
+
+    const SO3_CGcoeffs<float>& C=SO3_cgbank.getf(CGindex(l1,l2,l));
+    const int32_t* dix;
+    const float* dc;
+    get_cg_dev(C,l1,l2,l,dix,dc);
+
+    dim3 grid(x.n0,x.n1);
+    const int nthreads=std::min(N1*N2,256);
+    SO3partB_addReducingCGproduct_kernel<<<grid,nthreads,0,stream>>>
+      (r.arr,r.arrc,r.s0,r.s1,r.s2,r.s3,
+	x.arr,x.arrc,x.s0,x.s1,x.s2,x.s3,x.s4,
+	y.arr,y.arrc,y.s0,y.s1,y.s2,y.s3,
+	K,N1,N2,l,offs,dix,dc,C.packed_ix.size());
+  }
+
+}
@@ -0,0 +1,166 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// Device-side spherical harmonics: evaluates the associated Legendre
+// recurrence of SO3_SPHgen per point directly on the GPU, writing
+// straight into a device-resident SO3partB, so geometry updates no
+// longer bounce the coordinates through the host. One thread handles
+// one (batch, point) column, carrying the two previous recurrence rows
+// in registers; the c1/c2 recurrence coefficient tables are generated
+// on the host by SO3_sphGen and uploaded once per maximum l.
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "GElib_base.hpp"
+#include "SO3part3_view.hpp"
+#include "Rtensor3_view.hpp"
+#include "SO3_SPHgen.hpp"
+
+extern GElib::SO3_SPHgen SO3_sphGen;
+
+#define GELIB_SPHARM_MAXL 16
+
+
+namespace GElib{
+
+  namespace{
+
+    __global__ void SO3partB_addSpharm_kernel(
+      float* rarr, float* rarrc, const int rs0, const int rs1, const int rs2,
+      const float* xarr, const int xs0, const int xs1, const int xs2,
+      const int B, const int n, const int l, const float* c1, const float* c2, const int ld){
+
+      const int t=blockIdx.x*blockDim.x+threadIdx.x;
+      if(t>=B*n) return;
+      const int b=t/n;
+      const int j=t-b*n;
+
+      const float vx=xarr[b*xs0+j*xs2];
+      const float vy=xarr[b*xs0+xs1+j*xs2];
+      const float vz=xarr[b*xs0+2*xs1+j*xs2];
+      const float length=sqrtf(vx*vx+vy*vy+vz*vz);
+      const float len2=sqrtf(vx*vx+vy*vy);
+
+      float* r=rarr+b*rs0+l*rs1+j*rs2;
+      float* rc=rarrc+b*rs0+l*rs1+j*rs2;
+
+      if(len2==0 || isnan(vx/len2) || isnan(vy/len2)){
+	r[0]+=sqrtf(((float)(2*l+1))/(M_PI*4.0));
+	return;
+      }
+
+      const float x=vz/length;
+      const float xfact=sqrtf((1.0f-x)*(1.0f+x));
+
+      // Rows l-1 and l-2 of the recurrence, kept in registers.
+      float prev[GELIB_SPHARM_MAXL+1];
+      float prev2[GELIB_SPHARM_MAXL+1];
+      float cur[GELIB_SPHARM_MAXL+1];
+
+      prev[0]=sqrtf(1.0f/(M_PI*4.0));
+      cur[0]=prev[0];
+      for(int ll=1; ll<=l; ll++){
+	cur[ll]=c1[ll*ld+ll]*prev[ll-1]*xfact;
+	cur[ll-1]=c1[ll*ld+ll-1]*prev[ll-1]*x;
+	for(int m=0; m<ll-1; m++)
+	  cur[m]=c1[ll*ld+m]*prev[m]*x+c2[ll*ld+m]*prev2[m];
+	for(int m=0; m<=ll; m++){
+	  prev2[m]=prev[m];
+	  prev[m]=cur[m];
+	}
+      }
+
+      const float cphr=vx/len2;
+      const float cphi=vy/len2;
+      float phr=1;
+      float phi=0;
+      for(int m=0; m<=l; m++){
+	const float ar=phr*cur[m];
+	const float ai=phi*cur[m];
+	r[m*rs1]+=ar;
+	rc[m*rs1]+=ai;
+	if(m>0){
+	  const float s=1-2*(m%2);
+	  r[-m*rs1]+=s*ar;
+	  rc[-m*rs1]-=s*ai;
+	}
+	const float nphr=cphr*phr-cphi*phi;
+	phi=cphr*phi+cphi*phr;
+	phr=nphr;
+      }
+    }
+
+
+    // Device copies of the c1/c2 recurrence tables, kept per device
+    // and re-uploaded when a larger maximum l is requested. A
+    // superseded table is retired rather than freed: kernels launched
+    // earlier on other streams may still be reading it, so it is kept
+    // for the lifetime of the process -- the same snapshot discipline
+    // the host-side SO3_SPHgen uses for its tables.
+
+    struct spharm_tables{
+      float* c1=nullptr;
+      float* c2=nullptr;
+      int L=-1;
+    };
+
+    std::mutex spharm_mx;
+    std::map<int,spharm_tables> spharm_cache;
+    std::vector<float*> spharm_retired;
+
+    void get_sph_tables(const int l, const float*& c1, const float*& c2, int& ld){
+      int dev=0;
+      cudaGetDevice(&dev);
+      std::lock_guard<std::mutex> lock(spharm_mx);
+      spharm_tables& T=spharm_cache[dev];
+      if(l>T.L){
+	SO3_SPHgen::snapshot& S=SO3_sphGen.ensure(l);   // tables may already extend past l
+	if(T.c1) spharm_retired.push_back(T.c1);
+	if(T.c2) spharm_retired.push_back(T.c2);
+	const int L=S.L;
+	const int n=(L+1)*(L+1);
+	CUDA_SAFE(cudaMalloc(&T.c1,n*sizeof(float)));
+	CUDA_SAFE(cudaMalloc(&T.c2,n*sizeof(float)));
+	CUDA_SAFE(cudaMemcpy(T.c1,S.c1.arr,n*sizeof(float),cudaMemcpyHostToDevice));
+	CUDA_SAFE(cudaMemcpy(T.c2,S.c2.arr,n*sizeof(float),cudaMemcpyHostToDevice));
+	T.L=L;
+      }
+      c1=T.c1;
+      c2=T.c2;
+      ld=T.L+1;
+    }
+
+  }
+
+
+  void SO3partB_addSpharm_cu(const SO3part3_view& r, const cnine::Rtensor3_view& x, const cudaStream_t& stream){
+
+    const int l=r.getl();
+    const int B=r.n0;
+    const int n=r.n2;
+    assert(l<=GELIB_SPHARM_MAXL);
+
+    const float* c1;
+    const float* c2;
+    int ld;
+    get_sph_tables(l,c1,c2,ld);
+
+    const int nthreads=256;
+    const int nblocks=(B*n+nthreads-1)/nthreads;
+    SO3partB_addSpharm_kernel<<<nblocks,nthreads,0,stream>>>
+      (r.arr,r.arrc,r.s0,r.s1,r.s2,x.arr,x.s0,x.s1,x.s2,B,n,l,c1,c2,ld);
+  }
+
+}
@@ -0,0 +1,177 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// CG transform kernels for the bipart classes: contracts the (m1,m2)
+// plane of a bipart fragment x(b,m1,m2,n) against the Clebsch-Gordan
+// coefficients into r(b,m,n) (forward), or broadcasts the gradient of r
+// back over the plane (backward). One thread owns one (batch,channel)
+// column and sweeps the packed nonzeros-only coefficient list, carrying
+// the 2l+1 output modes in registers on the forward pass, so adjacent
+// threads touch adjacent channel entries and every access coalesces.
+// The packed tables are uploaded once per (l1,l2,l) into a device-side
+// cache owned by this translation unit.
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include <map>
+#include <mutex>
+
+#include "GElib_base.hpp"
+#include "Ctensor3_view.hpp"
+#include "Ctensor4_view.hpp"
+#include "SO3_CGbank.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+
+#define GELIB_CGTRANSFORM_MAXL 16
+
+
+namespace GElib{
+
+  namespace{
+
+    __global__ void SO3part_addCGtransform_kernel(
+      float* rarr, float* rarrc, const int rs0, const int rs1, const int rs2,
+      const float* xarr, const float* xarrc, const int xs0, const int xs1, const int xs2, const int xs3,
+      const int B, const int N, const int l, const int offs,
+      const int32_t* nzix, const float* nzc, const int nnz){
+
+      const int t=blockIdx.x*blockDim.x+threadIdx.x;
+      if(t>=B*N) return;
+      const int b=t/N;
+      const int n=t-b*N;
+
+      float2 acc[2*GELIB_CGTRANSFORM_MAXL+1];
+      for(int m=0; m<2*l+1; m++) acc[m]=make_float2(0,0);
+
+      const float* x=xarr+b*xs0+n*xs3;
+      const float* xc=xarrc+b*xs0+n*xs3;
+      for(int k=0; k<nnz; k++){
+	const int32_t ix=nzix[k];
+	const int m1=(ix>>16)&255;
+	const int m2=(ix>>8)&255;
+	const int m=ix&255;
+	const float c=nzc[k];
+	acc[m].x+=c*x[m1*xs1+m2*xs2];
+	acc[m].y+=c*xc[m1*xs1+m2*xs2];
+      }
+
+      float* r=rarr+b*rs0+(offs+n)*rs2;
+      float* rc=rarrc+b*rs0+(offs+n)*rs2;
+      for(int m=0; m<2*l+1; m++){
+	r[m*rs1]+=acc[m].x;
+	rc[m*rs1]+=acc[m].y;
+      }
+    }
+
+
+    __global__ void SO3part_addCGtransform_back_kernel(
+      float* xarr, float* xarrc, const int xs0, const int xs1, const int xs2, const int xs3,
+      const float* rarr, const float* rarrc, const int rs0, const int rs1, const int rs2,
+      const int B, const int N, const int offs,
+      const int32_t* nzix, const float* nzc, const int nnz){
+
+      const int t=blockIdx.x*blockDim.x+threadIdx.x;
+      if(t>=B*N) return;
+      const int b=t/N;
+      const int n=t-b*N;
+
+      const float* r=rarr+b*rs0+(offs+n)*rs2;
+      const float* rc=rarrc+b*rs0+(offs+n)*rs2;
+      float* x=xarr+b*xs0+n*xs3;
+      float* xc=xarrc+b*xs0+n*xs3;
+
+      // Each (m1,m2) cell is visited by exactly one nonzero, so the
+      // accumulations are race-free within the thread's column.
+      for(int k=0; k<nnz; k++){
+	const int32_t ix=nzix[k];
+	const int m1=(ix>>16)&255;
+	const int m2=(ix>>8)&255;
+	const int m=ix&255;
+	const float c=nzc[k];
+	x[m1*xs1+m2*xs2]+=c*r[m*rs1];
+	xc[m1*xs1+m2*xs2]+=c*rc[m*rs1];
+      }
+    }
+
+
+    // Device-side cache of the packed CG tables, keyed by the current
+    // device and (l1,l2,l) so multi-GPU runs never reuse pointers
+    // cudaMalloc'd on another device. Uploads happen at most once per
+    // (device,triple).
+
+    std::mutex cg_dev_mx;
+    std::map<int,std::pair<int32_t*,float*> > cg_dev_cache;
+
+    void get_cg_dev(const int l1, const int l2, const int l, int32_t*& dix, float*& dc, int& nnz){
+      const SO3_CGcoeffs<float>& coeffs=SO3_cgbank.getf(CGindex(l1,l2,l));
+      nnz=coeffs.packed_ix.size();
+      int dev=0;
+      cudaGetDevice(&dev);
+      std::lock_guard<std::mutex> lock(cg_dev_mx);
+      const int key=(dev<<24)|(l1<<16)|(l2<<8)|l;
+      auto it=cg_dev_cache.find(key);
+      if(it==cg_dev_cache.end()){
+	cudaMalloc(&dix,nnz*sizeof(int32_t));
+	cudaMalloc(&dc,nnz*sizeof(float));
+	cudaMemcpy(dix,coeffs.packed_ix.data(),nnz*sizeof(int32_t),cudaMemcpyHostToDevice);
+	cudaMemcpy(dc,coeffs.packed_c.data(),nnz*sizeof(float),cudaMemcpyHostToDevice);
+	cg_dev_cache[key]=std::make_pair(dix,dc);
+      }else{
+	dix=it->second.first;
+	dc=it->second.second;
+      }
+    }
+
+  }
+
+
+  void SO3part_addCGtransform_cu(cnine::Ctensor3_view r, cnine::Ctensor4_view x, const int offs, const cudaStream_t& stream){
+
+    const int l=(r.n1-1)/2;
+    const int l1=(x.n1-1)/2;
+    const int l2=(x.n2-1)/2;
+    const int B=x.n0;
+    const int N=x.n3;
+    assert(l<=GELIB_CGTRANSFORM_MAXL);
+
+    int32_t* dix; float* dc; int nnz;
+    get_cg_dev(l1,l2,l,dix,dc,nnz);
+
+    const int nthreads=256;
+    const int nblocks=(B*N+nthreads-1)/nthreads;
+    SO3part_addCGtransform_kernel<<<nblocks,nthreads,0,stream>>>
+      (r.arr,r.arrc,r.s0,r.s1,r.s2,
+	x.arr,x.arrc,x.s0,x.s1,x.s2,x.s3,
+	B,N,l,offs,dix,dc,nnz);
+  }
+
+
+  void SO3part_addCGtransform_back_cu(cnine::Ctensor4_view x, cnine::Ctensor3_view r, const int offs, const cudaStream_t& stream){
+
+    const int l=(r.n1-1)/2;
+    const int l1=(x.n1-1)/2;
+    const int l2=(x.n2-1)/2;
+    const int B=x.n0;
+    const int N=x.n3;
+
+    int32_t* dix; float* dc; int nnz;
+    get_cg_dev(l1,l2,l,dix,dc,nnz);
+
+    const int nthreads=256;
+    const int nblocks=(B*N+nthreads-1)/nthreads;
+    SO3part_addCGtransform_back_kernel<<<nblocks,nthreads,0,stream>>>
+      (x.arr,x.arrc,x.s0,x.s1,x.s2,x.s3,
+	r.arr,r.arrc,r.s0,r.s1,r.s2,
+	B,N,offs,dix,dc,nnz);
+  }
+
+}
@@ -0,0 +1,145 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// Persistent-kernel CG product: a fixed grid of CTAs drains a work
+// queue of (batch-chunk, l-combination) items through a device-side
+// atomic counter, covering a whole vec-level product in one launch.
+// Intended for small l and very large batch, where launch overhead and
+// tail effects dominate the individual per-combination kernels.
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "GElib_base.hpp"
+#include "SO3vec_addCGproduct_persistentFn.hpp"
+
+#define GELIB_PERSISTENT_MAXL 2
+
+
+namespace GElib{
+
+  namespace{
+
+    __global__ void SO3vecB_addCGproduct_persistent_kernel(const SO3CGworkItem* items,
+      const int nitems, int* counter){
+
+      __shared__ int cur;
+
+      while(true){
+	__syncthreads();
+	if(threadIdx.x==0) cur=atomicAdd(counter,1);
+	__syncthreads();
+	const int it=cur;
+	if(it>=nitems) return;
+
+	const SO3CGworkItem w=items[it];
+	const int nt=w.nb*w.N1*w.N2;
+
+	for(int t=threadIdx.x; t<nt; t+=blockDim.x){
+	  const int b=w.b0+t/(w.N1*w.N2);
+	  const int n1=(t/w.N2)%w.N1;
+	  const int n2=t%w.N2;
+
+	  float accr[2*GELIB_PERSISTENT_MAXL+1];
+	  float acci[2*GELIB_PERSISTENT_MAXL+1];
+	  for(int m=0; m<2*w.l+1; m++){accr[m]=0; acci[m]=0;}
+
+	  for(int k=0; k<w.nnz; k++){
+	    const int32_t ix=w.nzix[k];
+	    const int m1=(ix>>16)&255;
+	    const int m2=(ix>>8)&255;
+	    const int m=ix&255;
+	    const float c=w.nzc[k];
+	    const float xr=w.xarr[b*w.xs0+m1*w.xs1+n1*w.xs2];
+	    const float xi=w.xarrc[b*w.xs0+m1*w.xs1+n1*w.xs2];
+	    const float yr=w.yarr[b*w.ys0+m2*w.ys1+n2*w.ys2];
+	    const float yi=w.yarrc[b*w.ys0+m2*w.ys1+n2*w.ys2];
+	    accr[m]+=c*(xr*yr-xi*yi);
+	    acci[m]+=c*(xr*yi+xi*yr);
+	  }
+
+	  const int col=w.offs+n1*w.N2+n2;
+	  for(int m=0; m<2*w.l+1; m++){
+	    w.rarr[b*w.rs0+m*w.rs1+col*w.rs2]+=accr[m];
+	    w.rarrc[b*w.rs0+m*w.rs1+col*w.rs2]+=acci[m];
+	  }
+	}
+      }
+    }
+
+
+    // Device-side state owned by this translation unit: the packed CG
+    // tables, the work item buffer (grown monotonically and reused
+    // across launches) and the queue counter.
+
+    std::mutex persistent_mx;
+    std::map<int,std::pair<int32_t*,float*> > cgtable_cache;
+    SO3CGworkItem* items_dev=nullptr;
+    size_t items_cap=0;
+    int* counter_dev=nullptr;
+
+    int persistent_grid(){
+      static int nblocks=[](){
+	int dev=0; cudaGetDevice(&dev);
+	cudaDeviceProp prop;
+	cudaGetDeviceProperties(&prop,dev);
+	return 4*prop.multiProcessorCount;
+      }();
+      return nblocks;
+    }
+
+  }
+
+
+  void SO3vecB_persistent_cgtable(const int l1, const int l2, const int l,
+    const int32_t* hix, const float* hc, const int nnz, const int32_t** dix, const float** dc){
+    std::lock_guard<std::mutex> lock(persistent_mx);
+    const int key=(l1<<16)|(l2<<8)|l;
+    auto it=cgtable_cache.find(key);
+    if(it==cgtable_cache.end()){
+      int32_t* _dix; float* _dc;
+      CUDA_SAFE(cudaMalloc(&_dix,nnz*sizeof(int32_t)));
+      CUDA_SAFE(cudaMalloc(&_dc,nnz*sizeof(float)));
+      CUDA_SAFE(cudaMemcpy(_dix,hix,nnz*sizeof(int32_t),cudaMemcpyHostToDevice));
+      CUDA_SAFE(cudaMemcpy(_dc,hc,nnz*sizeof(float),cudaMemcpyHostToDevice));
+      it=cgtable_cache.insert(std::make_pair(key,std::make_pair(_dix,_dc))).first;
+    }
+    *dix=it->second.first;
+    *dc=it->second.second;
+  }
+
+
+  void SO3vecB_addCGproduct_persistent_cu(const std::vector<SO3CGworkItem>& items, const cudaStream_t& stream){
+    std::lock_guard<std::mutex> lock(persistent_mx);
+
+    if(items.size()>items_cap){
+      if(items_dev) cudaFree(items_dev);
+      items_cap=items.size();
+      CUDA_SAFE(cudaMalloc(&items_dev,items_cap*sizeof(SO3CGworkItem)));
+    }
+    if(!counter_dev) CUDA_SAFE(cudaMalloc(&counter_dev,sizeof(int)));
+
+    CUDA_SAFE(cudaMemcpyAsync(items_dev,items.data(),items.size()*sizeof(SO3CGworkItem),
+	cudaMemcpyHostToDevice,stream));
+    CUDA_SAFE(cudaMemsetAsync(counter_dev,0,sizeof(int),stream));
+
+    SO3vecB_addCGproduct_persistent_kernel<<<persistent_grid(),256,0,stream>>>
+      (items_dev,items.size(),counter_dev);
+
+    // The item buffer is reused by the next launch, so the queue must
+    // be drained before returning.
+    CUDA_SAFE(cudaStreamSynchronize(stream));
+  }
+
+}
@@ -0,0 +1,91 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// Fused invariant reduction over a whole SO3vecB: one launch fills the
+// complete per-(l,channel) inner-product table instead of one
+// synchronized per-part reduction per l. The grid is two-dimensional,
+// one y-slot per part; each thread owns one (batch,channel) column and
+// reduces its 2l+1 components in registers, so consecutive threads
+// read consecutive channels and the loads coalesce.
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include <mutex>
+#include <vector>
+
+#include "GElib_base.hpp"
+#include "SO3vec_inpTableFn.hpp"
+
+
+namespace GElib{
+
+  namespace{
+
+    __global__ void SO3vecB_inp_table_kernel(float* rarr, float* rarrc, const int rs0, const int rs1,
+      const int B, const SO3redItem* items){
+
+      const SO3redItem w=items[blockIdx.y];
+      const int t=blockIdx.x*blockDim.x+threadIdx.x;
+      if(t>=B*w.n) return;
+      const int b=t/w.n;
+      const int c=t%w.n;
+
+      float sr=0;
+      float si=0;
+      for(int m=0; m<w.m21; m++){
+	const float ar=w.xr[b*w.xs0+m*w.xs1+c*w.xs2];
+	const float ai=w.xi[b*w.xs0+m*w.xs1+c*w.xs2];
+	const float br=w.yr[b*w.ys0+m*w.ys1+c*w.ys2];
+	const float bi=w.yi[b*w.ys0+m*w.ys1+c*w.ys2];
+	sr+=ar*br+ai*bi;
+	si+=ar*bi-ai*br;
+      }
+
+      rarr[b*rs0+(w.offs+c)*rs1]=sr;
+      rarrc[b*rs0+(w.offs+c)*rs1]=si;
+    }
+
+
+    // Device-side item buffer owned by this translation unit, grown
+    // monotonically and reused across launches.
+    std::mutex inp_table_mx;
+    SO3redItem* items_dev=nullptr;
+    size_t items_cap=0;
+
+  }
+
+
+  void SO3vecB_inp_table_cu(const cnine::Ctensor2_view& r, const std::vector<SO3redItem>& items,
+    const cudaStream_t& stream){
+    if(items.size()==0) return;
+    std::lock_guard<std::mutex> lock(inp_table_mx);
+
+    if(items.size()>items_cap){
+      if(items_dev) cudaFree(items_dev);
+      items_cap=items.size();
+      CUDA_SAFE(cudaMalloc(&items_dev,items_cap*sizeof(SO3redItem)));
+    }
+    CUDA_SAFE(cudaMemcpyAsync(items_dev,items.data(),items.size()*sizeof(SO3redItem),
+	cudaMemcpyHostToDevice,stream));
+
+    const int B=r.n0;
+    int maxwork=0;
+    for(auto& w:items) maxwork=std::max(maxwork,B*w.n);
+
+    dim3 grid((maxwork+255)/256,items.size());
+    SO3vecB_inp_table_kernel<<<grid,256,0,stream>>>(r.arr,r.arrc,r.s0,r.s1,B,items_dev);
+
+    // The item buffer is reused by the next launch, so this one must be
+    // drained before returning.
+    CUDA_SAFE(cudaStreamSynchronize(stream));
+  }
+
+}
@@ -0,0 +1,80 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// Fused Adam step over a whole SO3weights pack: one launch covers every
+// weight tensor, and each thread performs both moment updates and the
+// parameter step on its element while it is in registers, instead of
+// one pass (and one kernel) per quantity per part. The grid is
+// two-dimensional, one y-slot per part.
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include <mutex>
+#include <vector>
+
+#include "GElib_base.hpp"
+#include "SO3weightsOptimizer.hpp"
+
+
+namespace GElib{
+
+  namespace{
+
+    __global__ void SO3weights_adam_kernel(const SO3adamItem* items, const float a,
+      const float beta1, const float beta2, const float eps){
+
+      const SO3adamItem w=items[blockIdx.y];
+      const long j=((long)blockIdx.x)*blockDim.x+threadIdx.x;
+      if(j>=w.n) return;
+
+      const float gj=w.g[j];
+      const float mj=beta1*w.m[j]+(1.0f-beta1)*gj;
+      const float vj=beta2*w.v[j]+(1.0f-beta2)*gj*gj;
+      w.m[j]=mj;
+      w.v[j]=vj;
+      w.w[j]-=a*mj/(sqrtf(vj)+eps);
+    }
+
+
+    // Device-side item buffer owned by this translation unit, grown
+    // monotonically and reused across launches.
+    std::mutex adam_mx;
+    SO3adamItem* items_dev=nullptr;
+    size_t items_cap=0;
+
+  }
+
+
+  void SO3weights_adam_cu(const std::vector<SO3adamItem>& items, const float a,
+    const float beta1, const float beta2, const float eps, const cudaStream_t& stream){
+    if(items.size()==0) return;
+    std::lock_guard<std::mutex> lock(adam_mx);
+
+    if(items.size()>items_cap){
+      if(items_dev) cudaFree(items_dev);
+      items_cap=items.size();
+      CUDA_SAFE(cudaMalloc(&items_dev,items_cap*sizeof(SO3adamItem)));
+    }
+    CUDA_SAFE(cudaMemcpyAsync(items_dev,items.data(),items.size()*sizeof(SO3adamItem),
+	cudaMemcpyHostToDevice,stream));
+
+    long maxn=0;
+    for(auto& w:items) maxn=std::max(maxn,w.n);
+
+    dim3 grid((maxn+255)/256,items.size());
+    SO3weights_adam_kernel<<<grid,256,0,stream>>>(items_dev,a,beta1,beta2,eps);
+
+    // The item buffer is reused by the next launch, so this one must be
+    // drained before returning.
+    CUDA_SAFE(cudaStreamSynchronize(stream));
+  }
+
+}
@@ -120,6 +120,102 @@ namespace GElib{
   };
 
 
+  // ---- Lazy linear expressions -----------------------------------------------------------------------------
+
+
+  // A lazily evaluated linear combination c0*x0+c1*x1+... over
+  // vector-like objects such as SO3vecB. Building the expression
+  // allocates nothing: scaling, addition and subtraction only
+  // manipulate the coefficient list, and the whole chain is fused into
+  // a single accumulation sweep when the expression is assigned to (or
+  // converted into) the object type, so a+2.0*b-c materializes one
+  // result instead of one temporary per node. The referenced operands
+  // must outlive the expression; OBJ must provide zeros_like and the
+  // fused add_linear primitive.
+  template<typename OBJ>
+  class LinearVecExpr{
+  public:
+
+    std::vector<std::pair<complex<float>,const OBJ*> > terms;
+
+    LinearVecExpr(){}
+
+    LinearVecExpr(const OBJ& x, const complex<float> c=1.0){
+      terms.push_back(std::make_pair(c,&x));
+    }
+
+
+  public: // ---- Composition ---------------------------------------------------------------------------------
+
+
+    LinearVecExpr operator+(const OBJ& y) const{
+      LinearVecExpr R(*this);
+      R.terms.push_back(std::make_pair(complex<float>(1.0),&y));
+      return R;
+    }
+
+    LinearVecExpr operator-(const OBJ& y) const{
+      LinearVecExpr R(*this);
+      R.terms.push_back(std::make_pair(complex<float>(-1.0),&y));
+      return R;
+    }
+
+    LinearVecExpr operator+(const LinearVecExpr& y) const{
+      LinearVecExpr R(*this);
+      for(auto& t:y.terms) R.terms.push_back(t);
+      return R;
+    }
+
+    LinearVecExpr operator-(const LinearVecExpr& y) const{
+      LinearVecExpr R(*this);
+      for(auto& t:y.terms) R.terms.push_back(std::make_pair(-t.first,t.second));
+      return R;
+    }
+
+    LinearVecExpr operator*(const complex<float> c) const{
+      LinearVecExpr R(*this);
+      for(auto& t:R.terms) t.first*=c;
+      return R;
+    }
+
+    friend LinearVecExpr operator*(const complex<float> c, const LinearVecExpr& x){
+      return x*c;
+    }
+
+
+  public: // ---- Evaluation ----------------------------------------------------------------------------------
+
+
+    // Accumulates the whole combination into r in one sweep, with no
+    // intermediate objects: the terms are handed to the object's fused
+    // add_linear primitive, which walks the output once across all
+    // operands instead of once per term.
+    void add_into(OBJ& r) const{
+      r.add_linear(terms);
+    }
+
+    operator OBJ() const{
+      GELIB_ASSRT(terms.size()>0);
+      OBJ R=OBJ::zeros_like(*terms[0].second);
+      add_into(R);
+      return R;
+    }
+
+
+  public: // ---- I/O -----------------------------------------------------------------------------------------
+
+
+    string str() const{
+      return OBJ(*this).str();
+    }
+
+    friend ostream& operator<<(ostream& stream, const LinearVecExpr& x){
+      stream<<x.str(); return stream;
+    }
+
+  };
+
+
 }
 
-#endif 
+#endif
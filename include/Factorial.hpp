@@ -10,10 +10,18 @@
 
 
 #ifndef _Factorial
-#define _Factorial 
+#define _Factorial
+
+#include <array>
 
 #include "GElib_base.hpp"
 
+// Largest l the compile-time log-factorial table covers; arguments
+// arising in the CG and Wigner generators are bounded by l1+l2+l+1,
+// hence the 4L+2 table size below.
+#ifndef GELIB_LOGFACT_MAXL
+#define GELIB_LOGFACT_MAXL 64
+#endif
 
 
 namespace GElib{
@@ -21,7 +29,7 @@ namespace GElib{
   class factorial{
   public:
     static vector<int> fact;
-    int value; 
+    int value;
     operator int(){
       return value;
     }
@@ -36,6 +44,63 @@ namespace GElib{
     }
   };
 
+
+  // std::log and lgamma are not constexpr in C++17, so the table below
+  // is generated with a small constexpr natural log: argument reduction
+  // to [1,2) followed by the atanh series, which converges to double
+  // precision in under twenty terms on that interval.
+  namespace constexpr_math{
+
+    constexpr double ln2=0.6931471805599453094172321;
+
+    constexpr double ln(double x){
+      int k=0;
+      while(x>=2.0){x*=0.5; k++;}
+      while(x<1.0){x*=2.0; k--;}
+      const double t=(x-1.0)/(x+1.0);
+      const double t2=t*t;
+      double term=t;
+      double sum=0;
+      for(int i=1; i<40; i+=2){
+	sum+=term/i;
+	term*=t2;
+      }
+      return 2.0*sum+k*ln2;
+    }
+
+    template<int N>
+    constexpr std::array<double,N+1> logfact_table(){
+      std::array<double,N+1> R{};
+      R[0]=0;
+      for(int n=1; n<=N; n++) R[n]=R[n-1]+ln((double)n);
+      return R;
+    }
+
+  }
+
+
+  // Compile-time table of log(n!). The CG and Wigner generators
+  // evaluate factorial-ratio prefactors as sums of log-factorials in
+  // their innermost loops; looking those up here turns each lgamma
+  // call into one table load. Arguments beyond the table (l above
+  // GELIB_LOGFACT_MAXL) fall back to lgamma.
+  class logfactorial{
+  public:
+    static constexpr int maxn=4*GELIB_LOGFACT_MAXL+2;
+    static constexpr std::array<double,maxn+1> table=constexpr_math::logfact_table<maxn>();
+  };
+
+  inline double logfact(const int n){
+    if(n>=0 && n<=logfactorial::maxn) return logfactorial::table[n];
+    return std::lgamma((double)n+1);
+  }
+
+  // log of the Wigner triangle coefficient Delta(l1,l2,l), the
+  // (m1,m2)-independent part of every CG prefactor.
+  inline double logtriangle(const int l1, const int l2, const int l){
+    return (logfact(l1+l2-l)+logfact(l1-l2+l)+logfact(-l1+l2+l)-logfact(l1+l2+l+1))/2;
+  }
+
 }
 
 #endif
@@ -0,0 +1,99 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibCellMask
+#define _GElibCellMask
+
+#include "GElib_base.hpp"
+#include "GElibCellOffsets.hpp"
+
+
+namespace GElib{
+
+  // Validity bitmask over the flat cell grid of an SO3partB_array /
+  // SO3vecB_array: in padded batches many cells are all-zero and every
+  // flop spent on them is wasted, so the masked cellwise ops iterate
+  // the compact index list of valid cells instead of the full grid.
+  // The mask is immutable once handed to an array; the index list is
+  // built eagerly so the hot paths never touch the bit words.
+
+  class GElibCellMask{
+  private:
+
+    int ncells=0;
+    vector<uint64_t> words;
+    vector<int> active_list;
+
+  public:
+
+    GElibCellMask(){}
+
+    GElibCellMask(const int _ncells, const vector<int>& _active):
+      ncells(_ncells), words((_ncells+63)/64,0){
+      for(auto i:_active){
+	GELIB_ASSRT(i>=0 && i<ncells);
+	words[i/64]|=(((uint64_t)1)<<(i%64));
+      }
+      rebuild();
+    }
+
+    // Mask marking the real cells of a padded rectangular grid with
+    // maxcells cells per sample, from the same CSR offsets used for
+    // the ragged layout.
+    static GElibCellMask from_offsets(const GElibCellOffsets& offsets, const int maxcells){
+      return GElibCellMask(offsets.nsamples()*maxcells,offsets.pack_indices(maxcells));
+    }
+
+
+  public: // ---- Access -------------------------------------------------------------------------------------
+
+
+    int size() const{
+      return ncells;
+    }
+
+    bool operator()(const int i) const{
+      return (words[i/64]>>(i%64))&1;
+    }
+
+    int n_active() const{
+      return active_list.size();
+    }
+
+    const vector<int>& active() const{
+      return active_list;
+    }
+
+
+  public: // ---- I/O ----------------------------------------------------------------------------------------
+
+
+    string str() const{
+      return "GElibCellMask("+to_string(n_active())+"/"+to_string(ncells)+")";
+    }
+
+    friend ostream& operator<<(ostream& stream, const GElibCellMask& x){
+      stream<<x.str(); return stream;
+    }
+
+
+  private:
+
+    void rebuild(){
+      active_list.clear();
+      for(int i=0; i<ncells; i++)
+	if((*this)(i)) active_list.push_back(i);
+    }
+
+  };
+
+}
+
+#endif
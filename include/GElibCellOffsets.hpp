@@ -0,0 +1,115 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibCellOffsets
+#define _GElibCellOffsets
+
+#include "GElib_base.hpp"
+
+
+namespace GElib{
+
+  // CSR-style per-sample offsets into the flat cell grid of an
+  // SO3partB_array / SO3vecB_array. A ragged batch -- samples with
+  // different cell counts, e.g. molecules with different numbers of
+  // atoms -- is stored by packing all samples' cells back to back into
+  // one flat array and describing the boundaries here: sample i owns
+  // cells [offs[i],offs[i+1]). The cellwise kernels (CG products,
+  // spherical harmonics, rotations) never look across cells, so they
+  // run on the packed array unchanged and spend no arithmetic on
+  // padding; only the per-sample reductions and broadcasts need the
+  // offsets.
+
+  class GElibCellOffsets{
+  public:
+
+    vector<int> offs;
+
+    GElibCellOffsets(){}
+
+    GElibCellOffsets(const vector<int>& _offs): offs(_offs){
+      GELIB_ASSRT(offs.size()>=1 && offs[0]==0);
+      for(int i=1; i<(int)offs.size(); i++)
+	GELIB_ASSRT(offs[i]>=offs[i-1]);
+    }
+
+    static GElibCellOffsets from_sizes(const vector<int>& sizes){
+      vector<int> r(sizes.size()+1);
+      r[0]=0;
+      for(int i=0; i<(int)sizes.size(); i++)
+	r[i+1]=r[i]+sizes[i];
+      return GElibCellOffsets(r);
+    }
+
+
+  public: // ---- Access -------------------------------------------------------------------------------------
+
+
+    int nsamples() const{
+      return offs.size()-1;
+    }
+
+    int ncells() const{
+      return offs.back();
+    }
+
+    int start(const int i) const{
+      return offs[i];
+    }
+
+    int size(const int i) const{
+      return offs[i+1]-offs[i];
+    }
+
+    // Flat indices of every real cell of a padded rectangular grid
+    // with maxcells cells per sample, in packed order: gather_rows
+    // with this list converts the padded array to the ragged layout.
+    vector<int> pack_indices(const int maxcells) const{
+      vector<int> r;
+      r.reserve(ncells());
+      for(int i=0; i<nsamples(); i++){
+	GELIB_ASSRT(size(i)<=maxcells);
+	for(int c=0; c<size(i); c++)
+	  r.push_back(i*maxcells+c);
+      }
+      return r;
+    }
+
+    // Sample index owning each flat cell, for scatter-style ops.
+    vector<int> cell_to_sample() const{
+      vector<int> r(ncells());
+      for(int i=0; i<nsamples(); i++)
+	for(int c=offs[i]; c<offs[i+1]; c++)
+	  r[c]=i;
+      return r;
+    }
+
+
+  public: // ---- I/O ----------------------------------------------------------------------------------------
+
+
+    string str() const{
+      ostringstream oss;
+      oss<<"GElibCellOffsets(";
+      for(int i=0; i<(int)offs.size(); i++)
+	oss<<offs[i]<<((i<(int)offs.size()-1)?",":"");
+      oss<<")";
+      return oss.str();
+    }
+
+    friend ostream& operator<<(ostream& stream, const GElibCellOffsets& x){
+      stream<<x.str(); return stream;
+    }
+
+  };
+
+}
+
+#endif
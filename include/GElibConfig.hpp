@@ -11,8 +11,34 @@
 #ifndef _GElibConfig
 #define _GElibConfig
 
+#include <fstream>
+#include <cctype>
+
 #include "GElib_base.hpp"
 
+// Byte threshold up to which SO3partB_small keeps its data in an
+// embedded buffer instead of a heap allocation. The default covers an
+// l<=1 part with a handful of channels (both complex planes); override
+// at compile time for models with wider small parts.
+#ifndef GELIB_SO3PART_SMALL_BYTES
+#define GELIB_SO3PART_SMALL_BYTES 256
+#endif
+
+// Whitelist of (l1,l2,l) triples for which fully unrolled kernels are
+// stamped out at compile time (see GElibFnTemplates.hpp): l1,l2 range
+// up to GELIB_SMALL_L_MAX and GELIB_SMALL_L_ADMIT prunes individual
+// triples from the instantiation. The defaults cover every admissible
+// triple with l1,l2<=3; deployments with a fixed model can raise the
+// bound or restrict the predicate to exactly the triples the model
+// uses, trading compile time and code size for unrolled hot paths.
+#ifndef GELIB_SMALL_L_MAX
+#define GELIB_SMALL_L_MAX 3
+#endif
+
+#ifndef GELIB_SMALL_L_ADMIT
+#define GELIB_SMALL_L_ADMIT(l1,l2,l) ((l1)<=GELIB_SMALL_L_MAX && (l2)<=GELIB_SMALL_L_MAX)
+#endif
+
 
 namespace GElib{
 
@@ -21,7 +47,191 @@ namespace GElib{
 
     bool SO3part_CGkernels_explicit=true;
 
-    
+    // Channel count N1*N2 beyond which the CPU CG product is lowered to
+    // a GEMM on the unrolled coefficient matrix instead of the direct
+    // loop kernels.
+    int SO3part_CGproduct_gemm_threshold=4096;
+
+    // Batch size beyond which the CPU CG product switches to the
+    // streaming kernel in SO3part_addCGproduct_largeB.hpp, which
+    // prefetches upcoming batch slices and writes the output with
+    // non-temporal stores. Set to the batch size at which the
+    // operands stop fitting in the last-level cache.
+    int SO3part_CGproduct_largeB_threshold=16384;
+
+    // Tile sizes for the cache-blocked kernel in
+    // SO3part_addBlockedCGproductFn: number of n1 channels and number of
+    // CG nonzeros processed per tile. Tune per deployment target so that
+    // one tile of x rows plus the touched r/y rows fits in L1/L2.
+    int SO3part_CGtile_channels=32;
+    int SO3part_CGtile_nonzeros=64;
+
+    // Number of CUDA streams a vec-level product fans its part-level
+    // kernels out over; 1 keeps the old single-stream behavior.
+    int cuda_nstreams=4;
+
+    // Batch size beyond which a small-l vec-level GPU CG product is run
+    // by the persistent work-queue kernel in a single launch.
+    int SO3vec_CGproduct_persistent_batch=16384;
+
+    // Route GPU CG products through NVRTC-compiled kernels specialized
+    // per (l1,l2,l) with the coefficients baked into immediates (see
+    // SO3CGjitKernelBank); requires a WITH_NVRTC build. Also settable
+    // through the GELIB_JIT_CG environment variable.
+    bool SO3part_CGjit_kernels=false;
+
+    // Tag every op of this session latency-critical: kernel launches
+    // go onto high-priority CUDA streams, so they preempt queued bulk
+    // work from other processes or sessions sharing the device. For
+    // per-call tagging use the scoped GElibLatencyCritical guard
+    // instead (see GElibCudaGraphs.hpp). Also settable through the
+    // GELIB_LATENCY_CRITICAL environment variable.
+    bool latency_critical=false;
+
+    // Split the (l1,l2,l) fragments of a vec-level GPU CG product
+    // between the host and the device: fragments too small to fill the
+    // GPU are staged to the host and computed on the thread pool while
+    // the large ones run on the stream pool, overlapping both
+    // processors within one call. The split comes from a cost model fed
+    // by the timing history in gelib_roofline; see
+    // SO3vec_addCGproductFn. Also settable through the GELIB_COSCHEDULE
+    // environment variable.
+    bool hetero_coschedule=false;
+
+    // Pin the session's thread pool workers round-robin over the NUMA
+    // nodes of the machine (also settable through the GELIB_NUMA_PIN
+    // environment variable). Only meaningful on multi-socket hosts.
+    bool numa_pin_threads=false;
+
+    // Allocate device storage in the GElib-owned allocators with
+    // cudaMallocManaged instead of cudaMalloc, and have the dispatch
+    // sites issue cudaMemPrefetchAsync hints for managed operands
+    // ahead of their kernel launches (see GElibManagedMemory.hpp), so
+    // datasets moderately oversubscribing the GPU run without
+    // explicit staging logic. Also settable through the
+    // GELIB_MANAGED_MEMORY environment variable.
+    bool managed_memory=false;
+
+    // Back large host buffers with 2MB huge pages (see
+    // GElibHugePages.hpp): allocations of at least
+    // huge_page_threshold_mb megabytes that go through the arena
+    // allocators are served by mmap with MAP_HUGETLB, or transparent
+    // huge pages when no hugetlb pool is reserved, cutting the TLB
+    // entry count of the cell-loop kernels by 512x. Also settable
+    // through the GELIB_HUGE_PAGES environment variable.
+    bool huge_pages=false;
+    int huge_page_threshold_mb=64;
+
+    // Deterministic-reduction mode (also settable through the
+    // GELIB_DETERMINISTIC environment variable): accumulations whose
+    // order would otherwise depend on thread scheduling are routed
+    // through the fixed-order tree schedule of GElibTreeReduce, so two
+    // runs of the same program produce bitwise identical results.
+    // Parallelism is retained -- only the combining order is pinned --
+    // at the cost of per-task partial buffers and one extra combining
+    // pass, a few percent on the reductions measured. Loops whose tasks
+    // write disjoint outputs are already deterministic and are not
+    // affected.
+    bool deterministic=false;
+
+
+  public: // ---- Runtime tuning registry ----------------------------------------------------------------
+
+
+    // Every knob above, by name. The registry gives each knob three
+    // access paths without further per-knob code: a GELIB_<NAME>
+    // environment variable (name upper-cased), a key=value config file
+    // loaded at session startup (GELIB_CONFIG, see GElibSession), and
+    // save(), which persists the current values -- including any
+    // adjusted by the autotuners during the run -- so a tuned
+    // configuration can follow a model between hosts of the same SKU.
+    // The file records the device it was tuned on; a mismatch is
+    // reported at load but the values are still applied.
+
+    map<string,bool*> bool_knobs;
+    map<string,int*> int_knobs;
+
+    GElibConfig(){
+      bool_knobs["SO3part_CGkernels_explicit"]=&SO3part_CGkernels_explicit;
+      bool_knobs["SO3part_CGjit_kernels"]=&SO3part_CGjit_kernels;
+      bool_knobs["latency_critical"]=&latency_critical;
+      bool_knobs["hetero_coschedule"]=&hetero_coschedule;
+      bool_knobs["numa_pin_threads"]=&numa_pin_threads;
+      bool_knobs["deterministic"]=&deterministic;
+      bool_knobs["huge_pages"]=&huge_pages;
+      bool_knobs["managed_memory"]=&managed_memory;
+      int_knobs["huge_page_threshold_mb"]=&huge_page_threshold_mb;
+      int_knobs["SO3part_CGproduct_gemm_threshold"]=&SO3part_CGproduct_gemm_threshold;
+      int_knobs["SO3part_CGproduct_largeB_threshold"]=&SO3part_CGproduct_largeB_threshold;
+      int_knobs["SO3part_CGtile_channels"]=&SO3part_CGtile_channels;
+      int_knobs["SO3part_CGtile_nonzeros"]=&SO3part_CGtile_nonzeros;
+      int_knobs["cuda_nstreams"]=&cuda_nstreams;
+      int_knobs["SO3vec_CGproduct_persistent_batch"]=&SO3vec_CGproduct_persistent_batch;
+    }
+
+    bool set(const string& key, const string& value){
+      auto it=int_knobs.find(key);
+      if(it!=int_knobs.end()){*it->second=std::stoi(value); return true;}
+      auto bt=bool_knobs.find(key);
+      if(bt!=bool_knobs.end()){*bt->second=(value!="0" && value!="false"); return true;}
+      return false;
+    }
+
+    void load_env(){
+      for(auto& p:int_knobs)
+	if(const char* e=std::getenv(env_name(p.first).c_str())) *p.second=std::stoi(e);
+      for(auto& p:bool_knobs)
+	if(const char* e=std::getenv(env_name(p.first).c_str())) *p.second=(string(e)!="0" && string(e)!="false");
+    }
+
+    // A missing file is not an error: the first run starts from the
+    // defaults and writes the file at shutdown.
+    void load(const string& filename){
+      std::ifstream f(filename);
+      if(!f.is_open()) return;
+      string line;
+      while(std::getline(f,line)){
+	if(line.size()==0 || line[0]=='#') continue;
+	auto p=line.find('=');
+	if(p==string::npos) continue;
+	string key=line.substr(0,p);
+	string value=line.substr(p+1);
+	if(key=="device"){
+	  if(value!=device_tag())
+	    cout<<"GElib config: "<<filename<<" was tuned on "<<value<<", running on "<<device_tag()<<"."<<endl;
+	  continue;
+	}
+	if(!set(key,value))
+	  cout<<"GElib config: unrecognized knob "<<key<<" in "<<filename<<"."<<endl;
+      }
+    }
+
+    void save(const string& filename) const{
+      std::ofstream f(filename);
+      f<<"# GElib runtime tuning registry; see GElibConfig.hpp."<<endl;
+      f<<"device="<<device_tag()<<endl;
+      for(auto& p:int_knobs) f<<p.first<<"="<<*p.second<<endl;
+      for(auto& p:bool_knobs) f<<p.first<<"="<<(*p.second? 1 : 0)<<endl;
+    }
+
+    // SKU tag the tuned values are keyed to: the name of device 0 on
+    // CUDA builds, "cpu" otherwise.
+    string device_tag() const{
+      #ifdef _WITH_CUDA
+      cudaDeviceProp prop;
+      if(cudaGetDeviceProperties(&prop,0)==cudaSuccess) return prop.name;
+      #endif
+      return "cpu";
+    }
+
+  private:
+
+    static string env_name(const string& key){
+      string R="GELIB_";
+      for(char c:key) R+=(char)std::toupper(c);
+      return R;
+    }
+
   };
 
 }
@@ -0,0 +1,183 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibCudaArena
+#define _GElibCudaArena
+
+#include <map>
+#include <unordered_map>
+
+#include "GElib_base.hpp"
+
+
+namespace GElib{
+
+#ifdef _WITH_CUDA
+
+  // Arena for device memory. cudaMalloc and cudaFree implicitly
+  // synchronize the device, so allocating temporaries through them from
+  // inside a multi-stream step serializes the streams. On runtimes with
+  // stream-ordered allocation (11.2+) the arena is a thin shim over
+  // cudaMallocAsync/cudaFreeAsync: GElibSession raises the release
+  // threshold of the device's default memory pool at startup, so freed
+  // blocks are retained by the pool and allocations are ordered on the
+  // requesting stream with no device-wide sync. On older runtimes (or
+  // devices without pool support) it falls back to a size-bucketed
+  // cache of cudaMalloc'ed blocks: each request is rounded up to the
+  // next power of two and freed blocks are recycled from a per-bucket
+  // free list, so after warm-up a training loop never touches the CUDA
+  // allocator again. Either way pooled memory is only returned to the
+  // driver by clear(), which GElibSession calls at shutdown.
+
+  class GElibCudaArena{
+  public:
+
+    GElibCudaArena(){}
+    GElibCudaArena(const GElibCudaArena& x)=delete;
+    GElibCudaArena& operator=(const GElibCudaArena& x)=delete;
+
+    ~GElibCudaArena(){
+      clear();
+    }
+
+
+    // Called once by GElibSession: switches the arena to stream-ordered
+    // allocation if the device supports memory pools, and configures
+    // the default pool to hold on to freed blocks instead of returning
+    // them to the driver eagerly.
+    void configure_pool(){
+#if CUDART_VERSION>=11020
+      int dev=0;
+      cudaGetDevice(&dev);
+      int supported=0;
+      cudaDeviceGetAttribute(&supported,cudaDevAttrMemoryPoolsSupported,dev);
+      if(!supported) return;
+      cudaMemPool_t pool;
+      CUDA_SAFE(cudaDeviceGetDefaultMemPool(&pool,dev));
+      uint64_t threshold=UINT64_MAX;
+      CUDA_SAFE(cudaMemPoolSetAttribute(pool,cudaMemPoolAttrReleaseThreshold,&threshold));
+      use_async=true;
+#endif
+    }
+
+
+    // Allocations and frees are ordered on the given stream in async
+    // mode; callers without a stream in scope get legacy-stream
+    // ordering, which matches the synchronous behavior they had before.
+    void* alloc(const size_t bytes, const cudaStream_t stream=0){
+#if CUDART_VERSION>=11020
+      if(use_async){
+	void* p;
+	CUDA_SAFE(cudaMallocAsync(&p,bytes,stream));
+	return p;
+      }
+#endif
+      lock_guard<mutex> lock(mx);
+      const size_t b=bucket(bytes);
+      auto& fl=free_lists[b];
+      void* p;
+      if(fl.size()>0){
+	p=fl.back();
+	fl.pop_back();
+      }else{
+	CUDA_SAFE(cudaMalloc(&p,b));
+	nallocated+=b;
+      }
+      block_size[p]=b;
+      return p;
+    }
+
+    void free(void* p, const cudaStream_t stream=0){
+      if(!p) return;
+#if CUDART_VERSION>=11020
+      if(use_async){
+	CUDA_SAFE(cudaFreeAsync(p,stream));
+	return;
+      }
+#endif
+      lock_guard<mutex> lock(mx);
+      auto it=block_size.find(p);
+      GELIB_ASSRT(it!=block_size.end());
+      free_lists[it->second].push_back(p);
+      block_size.erase(it);
+    }
+
+    // Returns all pooled memory to the driver. Outstanding blocks stay
+    // valid; they are handed back to the driver when freed after this.
+    void clear(){
+#if CUDART_VERSION>=11020
+      if(use_async){
+	int dev=0;
+	cudaGetDevice(&dev);
+	cudaMemPool_t pool;
+	CUDA_SAFE(cudaDeviceGetDefaultMemPool(&pool,dev));
+	CUDA_SAFE(cudaMemPoolTrimTo(pool,0));
+	return;
+      }
+#endif
+      lock_guard<mutex> lock(mx);
+      for(auto& fl:free_lists)
+	for(auto p:fl.second){
+	  cudaFree(p);
+	  nallocated-=fl.first;
+	}
+      free_lists.clear();
+    }
+
+    size_t allocated() const{
+#if CUDART_VERSION>=11020
+      if(use_async){
+	int dev=0;
+	cudaGetDevice(&dev);
+	cudaMemPool_t pool;
+	CUDA_SAFE(cudaDeviceGetDefaultMemPool(&pool,dev));
+	uint64_t reserved=0;
+	CUDA_SAFE(cudaMemPoolGetAttribute(pool,cudaMemPoolAttrReservedMemCurrent,&reserved));
+	return reserved;
+      }
+#endif
+      return nallocated;
+    }
+
+
+  private:
+
+    static size_t bucket(const size_t bytes){
+      size_t b=256;
+      while(b<bytes) b<<=1;
+      return b;
+    }
+
+#if CUDART_VERSION>=11020
+    bool use_async=false;
+#endif
+
+    mutex mx;
+    std::map<size_t,vector<void*> > free_lists;
+    std::unordered_map<void*,size_t> block_size;
+    size_t nallocated=0;
+
+  };
+
+#else
+
+  class GElibCudaArena{
+  public:
+    void clear(){}
+  };
+
+#endif
+
+}
+
+
+extern GElib::GElibCudaArena gelib_cuda_arena;
+
+#endif
@@ -0,0 +1,224 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibCudaGraphs
+#define _GElibCudaGraphs
+
+#include <functional>
+#include <unordered_map>
+
+#include "GElib_base.hpp"
+#include "GElibConfig.hpp"
+
+extern GElib::GElibConfig* gelib_config;
+
+
+namespace GElib{
+
+#ifdef _WITH_CUDA
+  // Externally supplied stream for this thread: nonzero while a CUDA
+  // graph is being captured or while a vec-level op is fanning its
+  // part-level kernels out over a stream pool. The GELIB_CUDA_STREAM
+  // macro below routes kernel launches onto it without synchronizing;
+  // whoever set the stream is responsible for the final join.
+  inline thread_local cudaStream_t gelib_cuda_current_stream=0;
+
+  // Latency-critical tag for this thread: while set, kernel launches
+  // from the Fn dispatch path go onto high-priority streams, so an
+  // inference call co-located with bulk training on the same device
+  // jumps ahead of the queued training kernels. Set session-wide
+  // through GElibConfig::latency_critical or per call with the scoped
+  // GElibLatencyCritical guard below.
+  inline thread_local bool gelib_latency_critical=false;
+
+  inline bool gelib_is_latency_critical(){
+    return gelib_latency_critical || (gelib_config && gelib_config->latency_critical);
+  }
+
+  // Scope guard tagging the ops issued inside it latency-critical.
+  class GElibLatencyCritical{
+  public:
+    bool prev;
+    GElibLatencyCritical(){
+      prev=gelib_latency_critical;
+      gelib_latency_critical=true;
+    }
+    ~GElibLatencyCritical(){
+      gelib_latency_critical=prev;
+    }
+  };
+#endif
+
+
+  // A small pool of long-lived streams for fanning independent kernels
+  // out; see SO3vec_addCGproductFn. Streams are created on first use
+  // and live for the duration of the process.
+  class GElibCudaStreamPool{
+  public:
+
+    GElibCudaStreamPool(){}
+    GElibCudaStreamPool(const GElibCudaStreamPool& x)=delete;
+    GElibCudaStreamPool& operator=(const GElibCudaStreamPool& x)=delete;
+
+#ifdef _WITH_CUDA
+
+    ~GElibCudaStreamPool(){
+      for(auto s:streams) cudaStreamDestroy(s);
+      for(auto s:hp_streams) cudaStreamDestroy(s);
+    }
+
+    // While the calling thread is tagged latency-critical the pool
+    // hands out high-priority streams instead, so a whole vec-level
+    // fan-out inherits the tag without its call sites changing.
+    cudaStream_t get(const int i, const int nstreams){
+      lock_guard<mutex> lock(mx);
+      if(gelib_is_latency_critical()) return hp(i,nstreams);
+      while((int)streams.size()<nstreams){
+	cudaStream_t s;
+	CUDA_SAFE(cudaStreamCreate(&s));
+	streams.push_back(s);
+      }
+      return streams[i%nstreams];
+    }
+
+    // High-priority companion stream for latency-critical launches
+    // outside the fan-out path; see GELIB_CUDA_STREAM.
+    cudaStream_t priority(const int i, const int nstreams=1){
+      lock_guard<mutex> lock(mx);
+      return hp(i,nstreams);
+    }
+
+    void sync(const int nstreams){
+      lock_guard<mutex> lock(mx);
+      for(int i=0; i<nstreams && i<(int)streams.size(); i++)
+	CUDA_SAFE(cudaStreamSynchronize(streams[i]));
+      for(int i=0; i<nstreams && i<(int)hp_streams.size(); i++)
+	CUDA_SAFE(cudaStreamSynchronize(hp_streams[i]));
+    }
+
+  private:
+
+    cudaStream_t hp(const int i, const int nstreams){
+      while((int)hp_streams.size()<nstreams){
+	int least=0;
+	int greatest=0;
+	CUDA_SAFE(cudaDeviceGetStreamPriorityRange(&least,&greatest));
+	cudaStream_t s;
+	CUDA_SAFE(cudaStreamCreateWithPriority(&s,cudaStreamDefault,greatest));
+	hp_streams.push_back(s);
+      }
+      return hp_streams[i%nstreams];
+    }
+
+    mutex mx;
+    vector<cudaStream_t> streams;
+    vector<cudaStream_t> hp_streams;
+
+#endif
+
+  };
+
+
+  // Caches the GPU kernel sequence of a repeated call pattern as a CUDA
+  // graph. The first run(signature,fn) with a given signature executes
+  // fn while capturing its kernel launches; later calls with the same
+  // signature replay the instantiated graph with a single launch,
+  // eliminating the per-kernel launch overhead that dominates small
+  // batch steps. Replay re-issues the captured launches verbatim, so it
+  // is only valid when the step touches the same device buffers at the
+  // same addresses and with the same shapes every time; warm up the CG
+  // bank (e.g. with the session warm-up manifest) before the first
+  // capture, since constant-memory uploads cannot be captured. Without
+  // CUDA support run() simply executes fn.
+
+  class GElibCudaGraphCache{
+  public:
+
+    GElibCudaGraphCache(){}
+    GElibCudaGraphCache(const GElibCudaGraphCache& x)=delete;
+    GElibCudaGraphCache& operator=(const GElibCudaGraphCache& x)=delete;
+
+#ifndef _WITH_CUDA
+
+    void run(const string& signature, const std::function<void()>& fn){
+      fn();
+    }
+
+#else
+
+    ~GElibCudaGraphCache(){
+      for(auto& p:graphs)
+	cudaGraphExecDestroy(p.second);
+      if(stream) cudaStreamDestroy(stream);
+    }
+
+    void run(const string& signature, const std::function<void()>& fn){
+      lock_guard<mutex> lock(mx);
+      if(!stream) CUDA_SAFE(cudaStreamCreate(&stream));
+
+      auto it=graphs.find(signature);
+      if(it!=graphs.end()){
+	CUDA_SAFE(cudaGraphLaunch(it->second,stream));
+	CUDA_SAFE(cudaStreamSynchronize(stream));
+	return;
+      }
+
+      CUDA_SAFE(cudaStreamBeginCapture(stream,cudaStreamCaptureModeThreadLocal));
+      gelib_cuda_current_stream=stream;
+      fn();
+      gelib_cuda_current_stream=0;
+      cudaGraph_t graph;
+      CUDA_SAFE(cudaStreamEndCapture(stream,&graph));
+      cudaGraphExec_t exec;
+      CUDA_SAFE(cudaGraphInstantiate(&exec,graph,nullptr,nullptr,0));
+      CUDA_SAFE(cudaGraphDestroy(graph));
+      graphs[signature]=exec;
+
+      CUDA_SAFE(cudaGraphLaunch(exec,stream));
+      CUDA_SAFE(cudaStreamSynchronize(stream));
+    }
+
+
+  private:
+
+    mutex mx;
+    unordered_map<string,cudaGraphExec_t> graphs;
+    cudaStream_t stream=0;
+
+#endif
+
+  };
+
+}
+
+
+// Stream wrapper for the Fn kernels: during graph capture the launch
+// goes onto the capturing stream without synchronization (which is
+// illegal inside a capture); for latency-critical work it goes onto a
+// high-priority pool stream; otherwise it behaves like CUDA_STREAM.
+#ifdef _WITH_CUDA
+#define GELIB_CUDA_STREAM(cmd) do{\
+    if(GElib::gelib_cuda_current_stream!=0){\
+      const cudaStream_t& stream=GElib::gelib_cuda_current_stream; cmd;}\
+    else if(GElib::gelib_is_latency_critical()){\
+      const cudaStream_t& stream=gelib_cuda_streams.priority(0);\
+      cmd;\
+      CUDA_SAFE(cudaStreamSynchronize(stream));}\
+    else {CUDA_STREAM(cmd);}\
+  }while(0)
+#else
+#define GELIB_CUDA_STREAM(cmd)
+#endif
+
+
+extern GElib::GElibCudaGraphCache gelib_cuda_graphs;
+extern GElib::GElibCudaStreamPool gelib_cuda_streams;
+
+#endif
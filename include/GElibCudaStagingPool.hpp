@@ -0,0 +1,127 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibCudaStagingPool
+#define _GElibCudaStagingPool
+
+#include <cstring>
+
+#include "GElib_base.hpp"
+#include "GElibCudaArena.hpp"
+
+
+namespace GElib{
+
+#ifdef _WITH_CUDA
+
+  // Reusable staging buffers for the host<->device streaming paths: a
+  // set of device buffers for the x/y/r chunks plus pinned host mirrors
+  // to stage the transfers through. cudaMemcpyAsync from pageable
+  // memory is silently synchronous, so without the pinned hop the
+  // streaming pipeline serializes; and reallocating the device buffers
+  // on every call costs a cudaMalloc/cudaFree round trip each time.
+  // Buffer sets are leased with acquire()/release() so concurrent
+  // streaming calls each get their own set, and grow monotonically to
+  // the largest size requested.
+
+  class GElibCudaStagingPool{
+  public:
+
+    class BufferSet{
+    public:
+      float* xbuf=nullptr;  // device
+      float* ybuf=nullptr;
+      float* rbuf=nullptr;
+      float* xstage=nullptr; // pinned host
+      float* ystage=nullptr;
+      float* rstage=nullptr;
+      size_t xcap=0;
+      size_t ycap=0;
+      size_t rcap=0;
+      bool in_use=false;
+
+      ~BufferSet(){
+	gelib_cuda_arena.free(xbuf);
+	gelib_cuda_arena.free(ybuf);
+	gelib_cuda_arena.free(rbuf);
+	if(xstage) cudaFreeHost(xstage);
+	if(ystage) cudaFreeHost(ystage);
+	if(rstage) cudaFreeHost(rstage);
+      }
+
+      void reserve(const size_t xn, const size_t yn, const size_t rn){
+	grow(xbuf,xstage,xcap,xn);
+	grow(ybuf,ystage,ycap,yn);
+	grow(rbuf,rstage,rcap,rn);
+      }
+
+    private:
+      // Device buffers come from the caching arena so that growing a
+      // set mid-run does not hit cudaMalloc/cudaFree and their implicit
+      // device synchronization.
+      static void grow(float*& buf, float*& stage, size_t& cap, const size_t n){
+	if(n<=cap) return;
+	gelib_cuda_arena.free(buf);
+	if(stage) cudaFreeHost(stage);
+	buf=(float*)gelib_cuda_arena.alloc(n*sizeof(float));
+	CUDA_SAFE(cudaMallocHost(&stage,n*sizeof(float)));
+	cap=n;
+      }
+    };
+
+
+    GElibCudaStagingPool(){}
+    GElibCudaStagingPool(const GElibCudaStagingPool& x)=delete;
+    GElibCudaStagingPool& operator=(const GElibCudaStagingPool& x)=delete;
+
+    ~GElibCudaStagingPool(){
+      for(auto p:sets) delete p;
+    }
+
+
+    BufferSet* acquire(const size_t xn, const size_t yn, const size_t rn){
+      lock_guard<mutex> lock(mx);
+      BufferSet* r=nullptr;
+      for(auto p:sets)
+	if(!p->in_use){r=p; break;}
+      if(!r){
+	r=new BufferSet();
+	sets.push_back(r);
+      }
+      r->in_use=true;
+      r->reserve(xn,yn,rn);
+      return r;
+    }
+
+    void release(BufferSet* set){
+      lock_guard<mutex> lock(mx);
+      set->in_use=false;
+    }
+
+
+  private:
+
+    mutex mx;
+    vector<BufferSet*> sets;
+
+  };
+
+#else
+
+  class GElibCudaStagingPool{};
+
+#endif
+
+}
+
+
+extern GElib::GElibCudaStagingPool gelib_cuda_staging;
+
+#endif
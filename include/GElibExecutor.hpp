@@ -0,0 +1,177 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibExecutor
+#define _GElibExecutor
+
+#include <functional>
+
+#include "GElib_base.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibTaskGraph.hpp"
+
+
+namespace GElib{
+
+  // Asynchronous executor for part-level operations. submit() records
+  // an operation with the tensor regions it reads and writes and
+  // returns a lightweight future immediately; the operation starts on
+  // the thread pool as soon as every earlier conflicting operation has
+  // finished, so independent products submitted back-to-back overlap
+  // instead of paying their latencies serially. Ordering between
+  // conflicting operations follows submission order, which keeps the
+  // semantics of the equivalent synchronous program.
+
+  class GElibExecutor{
+  public:
+
+    typedef GElibTaskGraph::Region Region;
+
+    class Op{
+    public:
+      std::function<void()> fn;
+      vector<Region> reads;
+      vector<Region> writes;
+      vector<shared_ptr<Op> > successors;
+      int ndeps=0;
+      bool finished=false;
+      mutex mx;
+      condition_variable cv;
+    };
+
+
+    // Handle on a submitted operation. Copies share the same state;
+    // destroying a future does not cancel or wait for the operation.
+    class Future{
+    public:
+      Future(){}
+      Future(shared_ptr<Op> _op): op(std::move(_op)){}
+
+      void wait() const{
+	if(!op) return;
+	unique_lock<mutex> lock(op->mx);
+	op->cv.wait(lock,[&](){return op->finished;});
+      }
+
+      bool ready() const{
+	if(!op) return true;
+	lock_guard<mutex> lock(op->mx);
+	return op->finished;
+      }
+
+    private:
+      shared_ptr<Op> op;
+    };
+
+
+  private:
+
+    mutex mx;
+    condition_variable idle_cv;
+    vector<weak_ptr<Op> > window;
+    int inflight=0;
+
+
+  public:
+
+    GElibExecutor(){}
+    GElibExecutor(const GElibExecutor& x)=delete;
+    GElibExecutor& operator=(const GElibExecutor& x)=delete;
+
+    ~GElibExecutor(){
+      sync();
+    }
+
+
+    Future submit(std::function<void()> fn, vector<Region> reads, vector<Region> writes){
+      auto op=make_shared<Op>();
+      op->fn=std::move(fn);
+      op->reads=std::move(reads);
+      op->writes=std::move(writes);
+
+      bool no_deps;
+      {
+	lock_guard<mutex> lock(mx);
+	vector<weak_ptr<Op> > live;
+	for(auto& w:window){
+	  auto e=w.lock();
+	  if(!e) continue;
+	  {
+	    lock_guard<mutex> elock(e->mx);
+	    if(e->finished) continue;
+	  }
+	  if(conflicts(*e,*op)){
+	    e->successors.push_back(op);
+	    op->ndeps++;
+	  }
+	  live.push_back(w);
+	}
+	live.push_back(op);
+	window=std::move(live);
+	inflight++;
+	no_deps=(op->ndeps==0);
+      }
+
+      if(no_deps) dispatch(op);
+      return Future(op);
+    }
+
+
+    // Blocks until every submitted operation has finished.
+    void sync(){
+      unique_lock<mutex> lock(mx);
+      idle_cv.wait(lock,[&](){return inflight==0;});
+    }
+
+
+  private:
+
+    void dispatch(shared_ptr<Op> op){
+      if(gelib_threadpool) gelib_threadpool->submit([this,op](){run(op);});
+      else run(op);
+    }
+
+    void run(shared_ptr<Op> op){
+      op->fn();
+      vector<shared_ptr<Op> > ready;
+      {
+	lock_guard<mutex> lock(mx);
+	{
+	  lock_guard<mutex> oplock(op->mx);
+	  op->finished=true;
+	}
+	op->cv.notify_all();
+	for(auto& s:op->successors)
+	  if(--s->ndeps==0) ready.push_back(s);
+	op->successors.clear();
+	inflight--;
+	if(inflight==0) idle_cv.notify_all();
+      }
+      for(auto& s:ready) dispatch(s);
+    }
+
+    static bool conflicts(const Op& x, const Op& y){
+      for(auto& w:y.writes){
+	for(auto& r:x.reads) if(w.overlaps(r)) return true;
+	for(auto& r:x.writes) if(w.overlaps(r)) return true;
+      }
+      for(auto& w:x.writes)
+	for(auto& r:y.reads) if(w.overlaps(r)) return true;
+      return false;
+    }
+
+  };
+
+}
+
+
+extern GElib::GElibExecutor* gelib_executor;
+
+#endif
@@ -0,0 +1,53 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibExterns
+#define _GElibExterns
+
+// Declaration-only counterpart of lib/GElib_instantiations.cpp.
+// Including this header in a translation unit compiled with
+// _GELIB_EXTERN_TEMPLATES (set by WITH_LIBGELIB in config.txt, which
+// also links lib/libgelib.a) suppresses local instantiation of the
+// listed classes, so each of a project's translation units parses
+// their declarations but compiles none of their bodies. Without the
+// macro the header is a no-op and the build behaves exactly as
+// header-only, so it is always safe to include.
+
+#include "SO3_CGcoeffs.hpp"
+#include "SO3partC.hpp"
+#include "SO3vecC.hpp"
+#include "SO3partArrayC.hpp"
+#include "SO3vecArrayC.hpp"
+#include "SO3bipart.hpp"
+#include "SO3bivec.hpp"
+
+#ifdef _GELIB_EXTERN_TEMPLATES
+
+extern template class GElib::SO3_CGcoeffs<float>;
+extern template class GElib::SO3_CGcoeffs<double>;
+
+extern template class GElib::SO3partView<float>;
+extern template class GElib::SO3part<float>;
+extern template class GElib::SO3vecView<float>;
+extern template class GElib::SO3vec<float>;
+
+extern template class GElib::SO3partArrayView<float>;
+extern template class GElib::SO3partArray<float>;
+extern template class GElib::SO3vecArrayView<float>;
+extern template class GElib::SO3vecArray<float>;
+
+extern template class GElib::SO3bipartView<float>;
+extern template class GElib::SO3bipart<float>;
+extern template class GElib::SO3bivecView<float>;
+extern template class GElib::SO3bivec<float>;
+
+#endif
+
+#endif
@@ -1,7 +1,6 @@
-
 // This file is part of GElib, a C++/CUDA library for group
-// equivariant tensor operations. 
-// 
+// equivariant tensor operations.
+//
 // Copyright (c) 2021, Imre Risi Kondor and Erik H Thiede
 //
 // This Source Code Form is subject to the terms of the Mozilla
@@ -12,10 +11,61 @@
 #ifndef _GElibFnTemplates
 #define _GElibFnTemplates
 
+#include "GElibConfig.hpp"
+
 namespace GElib{
 
-  //template<typename FN>
-  
+  // Routes a runtime (l1,l2,l) triple to a kernel class templated on
+  // compile-time l-indices, instantiating FN<l1,l2,l> for every triple
+  // admitted by the whitelist in GElibConfig.hpp (GELIB_SMALL_L_MAX
+  // bounds l1,l2 and GELIB_SMALL_L_ADMIT prunes individual triples).
+  // Used to give small-l hot shapes fully unrolled kernels, with loop
+  // bounds and CG sparsity known to the compiler, while larger shapes
+  // stay on the generic path (the dispatcher then returns false).
+
+  template<template<int,int,int> class FN, int A, int B, int C>
+  struct small_l_lloop{
+    template<typename... ARGS>
+    static bool apply(const int l, ARGS&&... args){
+      if(l==C){
+	if constexpr(GELIB_SMALL_L_ADMIT(A,B,C)){
+	  FN<A,B,C>()(std::forward<ARGS>(args)...); return true;}
+	else return false;
+      }
+      if constexpr(C>(A>B? A-B : B-A))
+	return small_l_lloop<FN,A,B,(C>0? C-1 : 0)>::apply(l,std::forward<ARGS>(args)...);
+      return false;
+    }
+  };
+
+  template<template<int,int,int> class FN, int A, int B>
+  struct small_l_bloop{
+    template<typename... ARGS>
+    static bool apply(const int l2, const int l, ARGS&&... args){
+      if(l2==B) return small_l_lloop<FN,A,B,A+B>::apply(l,std::forward<ARGS>(args)...);
+      if constexpr(B>0)
+	return small_l_bloop<FN,A,B-1>::apply(l2,l,std::forward<ARGS>(args)...);
+      return false;
+    }
+  };
+
+  template<template<int,int,int> class FN, int A>
+  struct small_l_aloop{
+    template<typename... ARGS>
+    static bool apply(const int l1, const int l2, const int l, ARGS&&... args){
+      if(l1==A) return small_l_bloop<FN,A,GELIB_SMALL_L_MAX>::apply(l2,l,std::forward<ARGS>(args)...);
+      if constexpr(A>0)
+	return small_l_aloop<FN,A-1>::apply(l1,l2,l,std::forward<ARGS>(args)...);
+      return false;
+    }
+  };
+
+  template<template<int,int,int> class FN, typename... ARGS>
+  inline bool dispatch_small_l(const int l1, const int l2, const int l, ARGS&&... args){
+    if(l1<0 || l2<0 || l1>GELIB_SMALL_L_MAX || l2>GELIB_SMALL_L_MAX) return false;
+    if(l<std::abs(l1-l2) || l>l1+l2) return false;
+    return small_l_aloop<FN,GELIB_SMALL_L_MAX>::apply(l1,l2,l,std::forward<ARGS>(args)...);
+  }
 
 }
 
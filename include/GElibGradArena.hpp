@@ -0,0 +1,133 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibGradArena
+#define _GElibGradArena
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#include "GElib_base.hpp"
+#include "GElibMemoryMonitor.hpp"
+#include "GElibThreadPool.hpp"
+
+
+namespace GElib{
+
+  // Session-owned arena for gradient storage under WITH_FAKE_GRAD.
+  // Without it every vec lazily heap-allocates a separate grad object
+  // and zeroing the gradients of a model walks every part of every
+  // vec; with the arena installed (GElibSession::install_grad_arena)
+  // all grad buffers are carved contiguously from one zero-filled
+  // block, so zero_grad is a single memset over the carved range and
+  // gradient accumulation across microbatches a single fused axpy.
+  // Carves are permanent for the lifetime of the arena -- gradients of
+  // a model are allocated once and reused every step -- so there is no
+  // free list.
+
+  class GElibGradArena{
+  public:
+
+    static constexpr size_t alignment=64;
+
+    float* arr=nullptr;
+    size_t capacity=0;   // floats
+    size_t head=0;       // floats carved so far
+    int dev=0;
+    std::mutex mx;
+    GElibMemoryHold mem_hold;
+
+
+    GElibGradArena(const size_t nfloats, const int _dev=0):
+      capacity(nfloats), dev(_dev){
+      if(dev==0){
+	arr=(float*)std::aligned_alloc(alignment,((capacity*sizeof(float)+alignment-1)/alignment)*alignment);
+	std::memset(arr,0,capacity*sizeof(float));
+      }
+#ifdef _WITH_CUDA
+      else{
+	CUDA_SAFE(cudaMalloc(&arr,capacity*sizeof(float)));
+	CUDA_SAFE(cudaMemset(arr,0,capacity*sizeof(float)));
+      }
+#endif
+      mem_hold.set("GElibGradArena",dev,((long long)capacity)*sizeof(float));
+    }
+
+    ~GElibGradArena(){
+      if(!arr) return;
+      if(dev==0) std::free(arr);
+#ifdef _WITH_CUDA
+      else cudaFree(arr);
+#endif
+    }
+
+    GElibGradArena(const GElibGradArena& x)=delete;
+    GElibGradArena& operator=(const GElibGradArena& x)=delete;
+
+
+  public: // ---- Carving ------------------------------------------------------------------------------------
+
+
+    // Carves n zero-filled floats; the returned block stays owned by
+    // the arena for its whole lifetime.
+    float* alloc(const size_t n){
+      std::lock_guard<std::mutex> lock(mx);
+      const size_t afloats=alignment/sizeof(float);
+      head=((head+afloats-1)/afloats)*afloats;
+      if(head+n>capacity)
+	GELIB_ERROR("GElibGradArena exhausted: "+std::to_string(head+n)+" floats requested, capacity "+
+	  std::to_string(capacity)+".");
+      float* R=arr+head;
+      head+=n;
+      return R;
+    }
+
+
+  public: // ---- Fused whole-arena operations ---------------------------------------------------------------
+
+
+    // Zeroes every gradient carved so far in one memset.
+    void zero_grad(){
+      if(dev==0){
+	std::memset(arr,0,head*sizeof(float));
+	return;
+      }
+#ifdef _WITH_CUDA
+      CUDA_SAFE(cudaMemset(arr,0,head*sizeof(float)));
+#endif
+    }
+
+    // Fused accumulation of another arena holding the gradients of the
+    // same model (e.g. a microbatch replica): one axpy sweep over the
+    // carved range instead of one add per part per vec. Host only.
+    void add(const GElibGradArena& x, const float c=1.0){
+      GELIB_ASSRT(x.head==head);
+      GELIB_ASSRT(dev==0 && x.dev==0);
+      float* a=arr;
+      const float* xa=x.arr;
+      const long page_floats=4096/sizeof(float);
+      const long npages=(head+page_floats-1)/page_floats;
+      GElibMultiLoopStatic(npages,[&](const int i){
+	  const long beg=((long)i)*page_floats;
+	  const long end=std::min<long>(beg+page_floats,head);
+	  for(long j=beg; j<end; j++) a[j]+=c*xa[j];
+	});
+    }
+
+  };
+
+}
+
+
+extern GElib::GElibGradArena* gelib_grad_arena;
+
+
+#endif
@@ -0,0 +1,90 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibHip
+#define _GElibHip
+
+// HIP/ROCm backend shim. A WITH_HIP build defines both _WITH_HIP and
+// _WITH_CUDA, so every device dispatch path in the tree stays active,
+// and this header -- included before anything else by GElib_base.hpp --
+// maps the CUDA runtime API names the host code uses onto their HIP
+// equivalents. The kernel translation units in cuda/ are hipified and
+// compiled by hipcc through hip/Makefile; HIP supports __constant__
+// plus hipMemcpyToSymbol, so the cg_cmem constant-memory scheme in
+// SO3_CGbank carries over unchanged.
+//
+// Two deliberate differences from the native CUDA build:
+//  - CUDART_VERSION is not defined, so GElibCudaArena keeps its
+//    size-bucketed free-list path instead of the stream-ordered
+//    allocator (hipMallocAsync exists but the pool-attribute surface
+//    differs; the free-list path is portable and equivalent in effect).
+//  - The warp-shuffle reductions pass an explicit width of 32, so on
+//    64-wide AMD wavefronts each 32-lane group reduces independently,
+//    matching the kernels' one-warp-per-column indexing.
+
+#ifdef _WITH_HIP
+
+#include <hip/hip_runtime.h>
+
+#define cudaError_t hipError_t
+#define cudaSuccess hipSuccess
+#define cudaGetErrorString hipGetErrorString
+#define cudaGetLastError hipGetLastError
+
+#define cudaMalloc hipMalloc
+#define cudaFree hipFree
+#define cudaMallocHost hipHostMalloc
+#define cudaFreeHost hipHostFree
+#define cudaMemset hipMemset
+#define cudaMemsetAsync hipMemsetAsync
+#define cudaMemcpy hipMemcpy
+#define cudaMemcpyAsync hipMemcpyAsync
+#define cudaMemcpy2D hipMemcpy2D
+#define cudaMemcpy2DAsync hipMemcpy2DAsync
+#define cudaMemcpyToSymbol hipMemcpyToSymbol
+#define cudaMemcpyHostToDevice hipMemcpyHostToDevice
+#define cudaMemcpyDeviceToHost hipMemcpyDeviceToHost
+#define cudaMemcpyDeviceToDevice hipMemcpyDeviceToDevice
+
+#define cudaStream_t hipStream_t
+#define cudaStreamCreate hipStreamCreate
+#define cudaStreamCreateWithPriority hipStreamCreateWithPriority
+#define cudaStreamDefault hipStreamDefault
+#define cudaStreamNonBlocking hipStreamNonBlocking
+#define cudaStreamSynchronize hipStreamSynchronize
+#define cudaStreamDestroy hipStreamDestroy
+#define cudaDeviceGetStreamPriorityRange hipDeviceGetStreamPriorityRange
+#define cudaDeviceSynchronize hipDeviceSynchronize
+
+#define cudaEvent_t hipEvent_t
+#define cudaEventCreate hipEventCreate
+#define cudaEventRecord hipEventRecord
+#define cudaEventSynchronize hipEventSynchronize
+#define cudaEventQuery hipEventQuery
+#define cudaEventElapsedTime hipEventElapsedTime
+#define cudaEventDestroy hipEventDestroy
+
+#define cudaGetDevice hipGetDevice
+#define cudaSetDevice hipSetDevice
+#define cudaDeviceGetAttribute hipDeviceGetAttribute
+
+#define cudaGraph_t hipGraph_t
+#define cudaGraphExec_t hipGraphExec_t
+#define cudaStreamBeginCapture hipStreamBeginCapture
+#define cudaStreamEndCapture hipStreamEndCapture
+#define cudaStreamCaptureModeThreadLocal hipStreamCaptureModeThreadLocal
+#define cudaGraphInstantiate hipGraphInstantiate
+#define cudaGraphLaunch hipGraphLaunch
+#define cudaGraphDestroy hipGraphDestroy
+#define cudaGraphExecDestroy hipGraphExecDestroy
+
+#endif
+
+#endif
@@ -0,0 +1,108 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibHugePages
+#define _GElibHugePages
+
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include "GElib_base.hpp"
+#include "GElibConfig.hpp"
+#include "GElibLog.hpp"
+
+extern GElib::GElibConfig* gelib_config;
+extern GElib::GElibLog* gelib_log;
+
+
+namespace GElib{
+
+  // Huge-page backed allocation for large host buffers. A multi-GB
+  // array on 4K pages needs a TLB entry per 4K of data, and the
+  // cell-loop kernels, which stride through many cells per task, miss
+  // the TLB on nearly every line; backing the buffer with 2MB pages
+  // cuts the entry count five-hundredfold. When the huge_pages session
+  // knob is on, allocations at or above huge_page_threshold_mb are
+  // served by mmap: MAP_HUGETLB from the reserved hugetlb pool when
+  // the machine has one, otherwise an ordinary anonymous mapping with
+  // madvise(MADV_HUGEPAGE) so transparent huge pages assemble it. The
+  // mmap'd regions are tracked so that free() can tell them apart from
+  // malloc'd storage; allocations below the threshold, on non-Linux
+  // hosts, or with the knob off fall through to aligned_alloc. The
+  // arena allocators (GElibScratchArena, GElibProgram,
+  // GElibOwnedWorkspace) route their host slabs through here, so any
+  // large buffer placed in an arena picks the option up automatically.
+
+  class GElibHugePageAllocator{
+  public:
+
+    static constexpr size_t huge_page_bytes=size_t(2)<<20;
+
+    std::mutex mx;
+    std::unordered_map<void*,size_t> mapped;   // mmap'd regions -> length
+    bool hugetlb_warned=false;
+
+
+    void* alloc(const size_t bytes){
+#ifdef __linux__
+      if(gelib_config && gelib_config->huge_pages &&
+	bytes>=((size_t)gelib_config->huge_page_threshold_mb<<20)){
+	const size_t n=(bytes+huge_page_bytes-1)/huge_page_bytes*huge_page_bytes;
+	void* p=mmap(nullptr,n,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB,-1,0);
+	if(p==MAP_FAILED){
+	  {
+	    std::lock_guard<std::mutex> lock(mx);
+	    if(!hugetlb_warned && gelib_log){
+	      (*gelib_log)("No hugetlb pool available, falling back to transparent huge pages.");
+	      hugetlb_warned=true;
+	    }
+	  }
+	  p=mmap(nullptr,n,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+	  if(p==MAP_FAILED) return std::aligned_alloc(64,(bytes+63)/64*64);
+	  madvise(p,n,MADV_HUGEPAGE);
+	}
+	std::lock_guard<std::mutex> lock(mx);
+	mapped[p]=n;
+	return p;
+      }
+#endif
+      return std::aligned_alloc(64,(bytes+63)/64*64);
+    }
+
+    void free(void* p){
+      if(!p) return;
+#ifdef __linux__
+      {
+	std::lock_guard<std::mutex> lock(mx);
+	auto it=mapped.find(p);
+	if(it!=mapped.end()){
+	  const size_t n=it->second;
+	  mapped.erase(it);
+	  munmap(p,n);
+	  return;
+	}
+      }
+#endif
+      std::free(p);
+    }
+
+  };
+
+
+  inline GElibHugePageAllocator gelib_huge_pages;
+
+}
+
+#endif
@@ -1,6 +1,6 @@
 // This file is part of GElib, a C++/CUDA library for group
-// equivariant tensor operations. 
-// 
+// equivariant tensor operations.
+//
 // Copyright (c) 2023, Imre Risi Kondor
 //
 // This Source Code Form is subject to the terms of the Mozilla
@@ -14,25 +14,112 @@
 #include <fstream>
 #include <chrono>
 #include <ctime>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <vector>
 
 namespace GElib{
 
+  // Asynchronous logger. Hot threads only format their message into a
+  // slot of a fixed-size lock-free ring buffer (bounded MPMC queue with
+  // per-slot sequence numbers); a dedicated logger thread drains the
+  // ring to the files, so enabling timing telemetry no longer blocks
+  // the threads being measured on stream I/O. If producers outrun the
+  // drainer the surplus lines are dropped and counted rather than ever
+  // stalling a hot path; the drop count is reported when the log closes.
+  //
+  // Besides formatted lines the log also carries structured telemetry:
+  // the timers post TelemetryEvent records (op kind, shape, duration,
+  // device) through the same ring, and external code can subscribe() a
+  // callback to receive them in-process instead of parsing the log
+  // files. Subscribers run on the logger thread, so a slow subscriber
+  // delays log draining but never the threads being measured; when
+  // nobody is subscribed the events are not even posted.
+
   class GElibLog{
   public:
 
+    // One structured timing/counter record. POD so that it can travel
+    // through a ring slot by memcpy; fields that do not apply to a given
+    // op are -1.
+    struct TelemetryEvent{
+      char op[40];
+      int l1,l2,l;
+      int b,n1,n2,dev;
+      long long n_ops;
+      double ms;
+    };
+
+    typedef std::function<void(const TelemetryEvent&)> subscriber_t;
+
+
+  private:
+
+    static const int ring_size=8192; // power of 2
+    static const int text_size=232;
+
+    struct Entry{
+      std::atomic<size_t> seq;
+      char channel;
+      std::time_t time;
+      char text[text_size];
+    };
+
+    static_assert(sizeof(TelemetryEvent)<=text_size,
+      "TelemetryEvent must fit in a ring slot");
+
     ofstream ofs;
     ofstream ofs2;
 
-    GElibLog(const string filename="GElib.log"){
+    std::unique_ptr<Entry[]> ring;
+    std::atomic<size_t> enqueue_pos;
+    size_t dequeue_pos=0; // only touched by the logger thread
+    std::atomic<long> dropped;
+    std::atomic<bool> closing;
+    std::thread drainer;
+
+    std::mutex subscriber_mx;
+    std::vector<std::pair<int,subscriber_t> > subscribers;
+    std::atomic<int> nsubscribers{0};
+    int next_subscriber_id=0;
+
+  public:
+
+    // Invoked by the drainer between passes over the ring; used to piggyback
+    // deferred work on the logger thread, such as harvesting completed CUDA
+    // event pairs (see GElibCudaEventPool). Must be set before producers
+    // start posting, i.e. right after the log is constructed.
+    std::function<void()> idle_hook;
+
+
+  public:
+
+    GElibLog(const string filename="GElib.log"):
+      ring(new Entry[ring_size]), enqueue_pos(0), dropped(0), closing(false){
+      for(size_t i=0; i<ring_size; i++)
+	ring[i].seq.store(i,std::memory_order_relaxed);
+
       ofs.open(filename);
       auto time = std::chrono::system_clock::now();
       std::time_t timet = std::chrono::system_clock::to_time_t(time);
       ofs<<"GElib log opened "<<std::ctime(&timet)<<endl;
 
       ofs2.open("CGproducts.csv");
+
+      drainer=std::thread([this](){drain_loop();});
     }
 
     ~GElibLog(){
+      closing.store(true);
+      drainer.join();
+      const long ndropped=dropped.load();
+      if(ndropped>0)
+	ofs<<"["<<ndropped<<" log lines dropped]"<<endl;
       ofs.close();
       ofs2.close();
     }
@@ -44,24 +131,159 @@ namespace GElib{
     void operator()(){}
 
     void operator()(const string msg){
-      //auto time = std::chrono::system_clock::now();
-      //std::time_t timet = std::chrono::system_clock::to_time_t(time);
-      std::time_t timet = std::time(nullptr);
-      char os[30];
-      strftime(os,30,"%H:%M:%S ",std::localtime(&timet));
-      //ofs<<std::asctime(std::localtime(&timet))<<"  ";
-      ofs<<os<<msg<<endl;
+      post('L',msg);
+    }
+
+    // Lines destined for the CGproducts.csv side channel.
+    void csv(const string msg){
+      post('C',msg);
     }
 
     void error(const string fn, const string str){
-      ofs<<"Error in "<<fn<<": "<<str<<endl;
+      post('L',"Error in "+fn+": "+str);
       cnine::CoutLock lk;
       cout<<"Error in "<<fn<<": "<<str<<endl;
     }
 
+
+  public: // ---- Telemetry subscribers ----------------------------------------------------------------------
+
+
+    // Register a callback to receive structured telemetry events; returns
+    // a handle for unsubscribe(). The callback is invoked on the logger
+    // thread, not on the thread that performed the op.
+    int subscribe(const subscriber_t& fn){
+      std::lock_guard<std::mutex> lock(subscriber_mx);
+      subscribers.push_back(std::make_pair(next_subscriber_id,fn));
+      nsubscribers.store((int)subscribers.size(),std::memory_order_release);
+      return next_subscriber_id++;
+    }
+
+    void unsubscribe(const int id){
+      std::lock_guard<std::mutex> lock(subscriber_mx);
+      for(int i=0; i<(int)subscribers.size(); i++)
+	if(subscribers[i].first==id){
+	  subscribers.erase(subscribers.begin()+i);
+	  break;
+	}
+      nsubscribers.store((int)subscribers.size(),std::memory_order_release);
+    }
+
+    // Cheap enough to gate event construction on the hot path.
+    bool has_subscribers() const{
+      return nsubscribers.load(std::memory_order_acquire)>0;
+    }
+
+    void event(const string& op, const int l1, const int l2, const int l, const int b,
+      const int n1, const int n2, const int dev, const long long n_ops, const double ms){
+      if(!has_subscribers()) return;
+      TelemetryEvent e;
+      std::snprintf(e.op,sizeof(e.op),"%s",op.c_str());
+      e.l1=l1; e.l2=l2; e.l=l;
+      e.b=b; e.n1=n1; e.n2=n2; e.dev=dev;
+      e.n_ops=n_ops; e.ms=ms;
+      post_event(e);
+    }
+
+
+  private: // ------------------------------------------------------------------------------------------------
+
+
+    void post(const char channel, const string& msg){
+      size_t pos=enqueue_pos.load(std::memory_order_relaxed);
+      for(;;){
+	Entry& e=ring[pos&(ring_size-1)];
+	const size_t seq=e.seq.load(std::memory_order_acquire);
+	const intptr_t dif=(intptr_t)seq-(intptr_t)pos;
+	if(dif==0){
+	  if(enqueue_pos.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed)){
+	    e.channel=channel;
+	    e.time=std::time(nullptr);
+	    std::snprintf(e.text,text_size,"%s",msg.c_str());
+	    e.seq.store(pos+1,std::memory_order_release);
+	    return;
+	  }
+	}else if(dif<0){ // ring full: drop rather than block the caller
+	  dropped.fetch_add(1,std::memory_order_relaxed);
+	  return;
+	}else{
+	  pos=enqueue_pos.load(std::memory_order_relaxed);
+	}
+      }
+    }
+
+    // Same claim protocol as post(), but the slot carries a binary
+    // TelemetryEvent instead of a formatted line.
+    void post_event(const TelemetryEvent& ev){
+      size_t pos=enqueue_pos.load(std::memory_order_relaxed);
+      for(;;){
+	Entry& e=ring[pos&(ring_size-1)];
+	const size_t seq=e.seq.load(std::memory_order_acquire);
+	const intptr_t dif=(intptr_t)seq-(intptr_t)pos;
+	if(dif==0){
+	  if(enqueue_pos.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed)){
+	    e.channel='E';
+	    e.time=std::time(nullptr);
+	    std::memcpy(e.text,&ev,sizeof(ev));
+	    e.seq.store(pos+1,std::memory_order_release);
+	    return;
+	  }
+	}else if(dif<0){
+	  dropped.fetch_add(1,std::memory_order_relaxed);
+	  return;
+	}else{
+	  pos=enqueue_pos.load(std::memory_order_relaxed);
+	}
+      }
+    }
+
+    void dispatch(const TelemetryEvent& ev){
+      std::lock_guard<std::mutex> lock(subscriber_mx);
+      for(auto& p: subscribers)
+	p.second(ev);
+    }
+
+    bool drain_one(){
+      Entry& e=ring[dequeue_pos&(ring_size-1)];
+      const size_t seq=e.seq.load(std::memory_order_acquire);
+      if((intptr_t)seq-(intptr_t)(dequeue_pos+1)<0) return false;
+
+      if(e.channel=='E'){
+	TelemetryEvent ev;
+	std::memcpy(&ev,e.text,sizeof(ev));
+	dispatch(ev);
+      }else if(e.channel=='C'){
+	ofs2<<e.text<<"\n";
+      }else{
+	char os[30];
+	strftime(os,30,"%H:%M:%S ",std::localtime(&e.time));
+	ofs<<os<<e.text<<"\n";
+      }
+
+      e.seq.store(dequeue_pos+ring_size,std::memory_order_release);
+      dequeue_pos++;
+      return true;
+    }
+
+    void drain_loop(){
+      while(true){
+	bool drained=false;
+	while(drain_one()) drained=true;
+	if(idle_hook) idle_hook();
+	if(drained){
+	  ofs.flush();
+	  ofs2.flush();
+	  continue;
+	}
+	if(closing.load()) break;
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      while(drain_one()){}
+    }
+
   };
 
 
 }
 
-#endif 
+#endif
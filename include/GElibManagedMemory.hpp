@@ -0,0 +1,68 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibManagedMemory
+#define _GElibManagedMemory
+
+#include "GElib_base.hpp"
+#include "GElibConfig.hpp"
+
+extern GElib::GElibConfig* gelib_config;
+
+
+namespace GElib{
+
+  // Unified-memory mode for workloads slightly larger than the device.
+  // With the managed_memory session knob on, the device branches of the
+  // GElib-owned allocators (GElibOwnedWorkspace, the GElibProgram
+  // arena) switch from cudaMalloc to cudaMallocManaged, so a dataset
+  // moderately oversubscribing the GPU runs with the driver paging in
+  // place of explicit staging logic. Demand paging alone stalls each
+  // kernel on its first touch of every absent page, so the dispatch
+  // sites issue cudaMemPrefetchAsync hints for the operands onto the
+  // op's stream ahead of the launch: the migration overlaps the
+  // preceding work and the kernel finds its pages resident. The helper
+  // below checks the pointer's attributes and is a no-op for ordinary
+  // device allocations, so the dispatch sites can call it
+  // unconditionally on operands of unknown provenance (including
+  // managed tensors adopted from the Python side).
+
+#ifdef _WITH_CUDA
+
+  inline void GElib_prefetch_managed(const void* p, const size_t bytes, const int dev, const cudaStream_t& stream){
+    if(!p || bytes==0) return;
+    if(!gelib_config || !gelib_config->managed_memory) return;
+    cudaPointerAttributes attr;
+    if(cudaPointerGetAttributes(&attr,p)!=cudaSuccess){cudaGetLastError(); return;}
+    if(attr.type!=cudaMemoryTypeManaged) return;
+    cudaMemPrefetchAsync(p,bytes,dev-1,stream);
+  }
+
+#endif
+
+}
+
+
+// Prefetches both complex planes of three operand views onto the op's
+// stream; the dispatch sites place this at the head of their
+// GELIB_CUDA_STREAM body, right before the launch.
+#ifdef _WITH_CUDA
+#define GELIB_PREFETCH_MANAGED3(r,x,y,dev,stream)\
+  GElib::GElib_prefetch_managed(r.arr,((size_t)r.n0)*r.s0*sizeof(float),dev,stream);\
+  GElib::GElib_prefetch_managed(r.arrc,((size_t)r.n0)*r.s0*sizeof(float),dev,stream);\
+  GElib::GElib_prefetch_managed(x.arr,((size_t)x.n0)*x.s0*sizeof(float),dev,stream);\
+  GElib::GElib_prefetch_managed(x.arrc,((size_t)x.n0)*x.s0*sizeof(float),dev,stream);\
+  GElib::GElib_prefetch_managed(y.arr,((size_t)y.n0)*y.s0*sizeof(float),dev,stream);\
+  GElib::GElib_prefetch_managed(y.arrc,((size_t)y.n0)*y.s0*sizeof(float),dev,stream)
+#else
+#define GELIB_PREFETCH_MANAGED3(r,x,y,dev,stream)
+#endif
+
+#endif
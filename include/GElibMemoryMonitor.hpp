@@ -0,0 +1,293 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibMemoryMonitor
+#define _GElibMemoryMonitor
+
+#include <map>
+#include <mutex>
+#include <vector>
+#include <fstream>
+
+#include "GElib_base.hpp"
+
+
+namespace GElib{
+
+  // Live-memory accounting registry. The constructors and destructors
+  // of the storage-owning classes in objects/SO3/ report their buffer
+  // sizes here, keyed by class name and device, so that when a run
+  // approaches an OOM it can be asked which class is holding the
+  // memory and what the peak usage was:
+  //
+  //   cout<<gelib_memory.str();           // all classes, all devices
+  //   gelib_memory.live("SO3partB",1);    // current bytes on GPU 0
+  //
+  // GElibSession prints the same report at shutdown whenever the
+  // GELIB_MEMORY_REPORT environment variable is set. Container
+  // classes whose storage lives in their parts (SO3vecB and the
+  // vec-level arrays) are accounted through those parts. Objects
+  // created through inherited cnine constructors or adopted as
+  // non-owning views are not counted.
+
+  // Optional creation-site label for the top-allocations list below:
+  // wrapping a region in a GElibMemoryContext tags every allocation
+  // made by the thread inside it, so the report can say which layer or
+  // phase created the largest tensors rather than just their class.
+  inline thread_local const char* gelib_memory_context=nullptr;
+
+
+  class GElibMemoryMonitor{
+  public:
+
+    struct Entry{
+      long long live=0;
+      long long hwm=0;
+    };
+
+    struct BigAlloc{
+      long long bytes=0;
+      std::string clsname;
+      int dev=0;
+      std::string site;
+    };
+
+    static const int ntop=10;
+
+    mutable std::mutex mx;
+    std::map<std::string,std::map<int,Entry> > entries;
+    std::map<int,Entry> dev_totals;
+    std::vector<BigAlloc> top; // descending by bytes, at most ntop
+
+
+    GElibMemoryMonitor(){}
+    GElibMemoryMonitor(const GElibMemoryMonitor& x)=delete;
+    GElibMemoryMonitor& operator=(const GElibMemoryMonitor& x)=delete;
+
+
+    void alloc(const char* clsname, const int dev, const long long bytes){
+      std::lock_guard<std::mutex> lock(mx);
+      Entry& e=entries[clsname][dev];
+      e.live+=bytes;
+      if(e.live>e.hwm) e.hwm=e.live;
+      Entry& d=dev_totals[dev];
+      d.live+=bytes;
+      if(d.live>d.hwm) d.hwm=d.live;
+
+      if((int)top.size()<ntop || bytes>top.back().bytes){
+	BigAlloc a;
+	a.bytes=bytes;
+	a.clsname=clsname;
+	a.dev=dev;
+	if(gelib_memory_context) a.site=gelib_memory_context;
+	auto it=top.begin();
+	while(it!=top.end() && it->bytes>=bytes) it++;
+	top.insert(it,a);
+	if((int)top.size()>ntop) top.pop_back();
+      }
+    }
+
+    void free(const char* clsname, const int dev, const long long bytes){
+      std::lock_guard<std::mutex> lock(mx);
+      entries[clsname][dev].live-=bytes;
+      dev_totals[dev].live-=bytes;
+    }
+
+
+  public: // ---- Queries ------------------------------------------------------------------------------------
+
+
+    long long live(const std::string& clsname, const int dev=0) const{
+      std::lock_guard<std::mutex> lock(mx);
+      auto it=entries.find(clsname);
+      if(it==entries.end()) return 0;
+      auto it2=it->second.find(dev);
+      if(it2==it->second.end()) return 0;
+      return it2->second.live;
+    }
+
+    long long hwm(const std::string& clsname, const int dev=0) const{
+      std::lock_guard<std::mutex> lock(mx);
+      auto it=entries.find(clsname);
+      if(it==entries.end()) return 0;
+      auto it2=it->second.find(dev);
+      if(it2==it->second.end()) return 0;
+      return it2->second.hwm;
+    }
+
+    long long total_live(const int dev) const{
+      std::lock_guard<std::mutex> lock(mx);
+      long long t=0;
+      for(auto& p:entries){
+	auto it=p.second.find(dev);
+	if(it!=p.second.end()) t+=it->second.live;
+      }
+      return t;
+    }
+
+
+  public: // ---- I/O ----------------------------------------------------------------------------------------
+
+
+    string str(const string indent="") const{
+      std::lock_guard<std::mutex> lock(mx);
+      ostringstream oss;
+      oss<<indent<<"Live memory by class and device:"<<endl;
+      for(auto& p:entries)
+	for(auto& q:p.second)
+	  oss<<indent<<"  "<<p.first<<" [dev="<<q.first<<"]: live="<<q.second.live<<
+	    " bytes, peak="<<q.second.hwm<<" bytes"<<endl;
+      oss<<indent<<"Peak total by device:"<<endl;
+      for(auto& p:dev_totals)
+	oss<<indent<<"  dev="<<p.first<<": peak="<<p.second.hwm<<" bytes (live="<<
+	  p.second.live<<")"<<endl;
+      if(top.size()>0){
+	oss<<indent<<"Largest single allocations:"<<endl;
+	for(auto& a:top){
+	  oss<<indent<<"  "<<a.bytes<<" bytes "<<a.clsname<<" [dev="<<a.dev<<"]";
+	  if(a.site.size()>0) oss<<" at "<<a.site;
+	  oss<<endl;
+	}
+      }
+      return oss.str();
+    }
+
+    // Same breakdown as machine-readable JSON, for postmortem tooling;
+    // written at shutdown when GELIB_MEMORY_JSON names a file.
+    void save_json(const string& path) const{
+      std::lock_guard<std::mutex> lock(mx);
+      std::ofstream out(path,std::ios::trunc);
+      if(!out.good()) return;
+      out<<"{\"classes\":[";
+      bool first=true;
+      for(auto& p:entries)
+	for(auto& q:p.second){
+	  if(!first) out<<",";
+	  first=false;
+	  out<<"\n{\"class\":\""<<p.first<<"\",\"dev\":"<<q.first<<",\"live\":"<<
+	    q.second.live<<",\"peak\":"<<q.second.hwm<<"}";
+	}
+      out<<"\n],\"devices\":[";
+      first=true;
+      for(auto& p:dev_totals){
+	if(!first) out<<",";
+	first=false;
+	out<<"\n{\"dev\":"<<p.first<<",\"live\":"<<p.second.live<<",\"peak\":"<<p.second.hwm<<"}";
+      }
+      out<<"\n],\"top_allocations\":[";
+      first=true;
+      for(auto& a:top){
+	if(!first) out<<",";
+	first=false;
+	out<<"\n{\"bytes\":"<<a.bytes<<",\"class\":\""<<a.clsname<<"\",\"dev\":"<<a.dev<<
+	  ",\"site\":\""<<a.site<<"\"}";
+      }
+      out<<"\n]}\n";
+    }
+
+    friend ostream& operator<<(ostream& stream, const GElibMemoryMonitor& x){
+      stream<<x.str(); return stream;
+    }
+
+  };
+
+}
+
+
+extern GElib::GElibMemoryMonitor gelib_memory;
+
+
+namespace GElib{
+
+  // RAII handle through which the tracked classes report to
+  // gelib_memory: a member of each storage-owning class, activated by
+  // set(...) in the constructors that allocate. Copying the handle
+  // registers a second allocation (a copied tensor is one), moving
+  // transfers it, and destruction deregisters, so the bookkeeping
+  // follows the object through every special member function without
+  // the classes touching their destructors.
+
+  class GElibMemoryHold{
+  public:
+
+    const char* clsname=nullptr;
+    int dev=0;
+    long long bytes=0;
+
+    GElibMemoryHold(){}
+
+    void set(const char* _clsname, const int _dev, const long long _bytes){
+      release();
+      clsname=_clsname;
+      dev=_dev;
+      bytes=_bytes;
+      gelib_memory.alloc(clsname,dev,bytes);
+    }
+
+    void release(){
+      if(clsname) gelib_memory.free(clsname,dev,bytes);
+      clsname=nullptr;
+    }
+
+    GElibMemoryHold(const GElibMemoryHold& x){
+      if(x.clsname) set(x.clsname,x.dev,x.bytes);
+    }
+
+    GElibMemoryHold(GElibMemoryHold&& x):
+      clsname(x.clsname), dev(x.dev), bytes(x.bytes){
+      x.clsname=nullptr;
+    }
+
+    GElibMemoryHold& operator=(const GElibMemoryHold& x){
+      release();
+      if(x.clsname) set(x.clsname,x.dev,x.bytes);
+      return *this;
+    }
+
+    GElibMemoryHold& operator=(GElibMemoryHold&& x){
+      release();
+      clsname=x.clsname;
+      dev=x.dev;
+      bytes=x.bytes;
+      x.clsname=nullptr;
+      return *this;
+    }
+
+    ~GElibMemoryHold(){
+      release();
+    }
+
+  };
+
+
+  // Scoped creation-site label: allocations made by this thread while
+  // the object is alive are tagged with the label in the
+  // largest-allocations report. Nests; the label must outlive the scope
+  // (string literals do).
+
+  class GElibMemoryContext{
+  public:
+
+    const char* prev;
+
+    GElibMemoryContext(const char* label): prev(gelib_memory_context){
+      gelib_memory_context=label;
+    }
+
+    ~GElibMemoryContext(){
+      gelib_memory_context=prev;
+    }
+
+  };
+
+}
+
+
+#endif
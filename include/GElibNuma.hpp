@@ -0,0 +1,98 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibNuma
+#define _GElibNuma
+
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "GElib_base.hpp"
+
+
+namespace GElib{
+
+  // Minimal NUMA topology support, read straight from sysfs so that no
+  // dependency on libnuma is introduced. On non-Linux platforms (or
+  // machines without the sysfs nodes) everything collapses to a single
+  // node containing all CPUs and pinning becomes a no-op.
+
+  class GElibNuma{
+  public:
+
+    // CPU ids per NUMA node, e.g. {{0-15,32-47},{16-31,48-63}} on a
+    // dual socket machine with SMT.
+    static const vector<vector<int> >& nodes(){
+      static vector<vector<int> > r=read_topology();
+      return r;
+    }
+
+    static int nnodes(){
+      return nodes().size();
+    }
+
+    static void pin_current_thread_to_node(const int node){
+#ifdef __linux__
+      const auto& cpus=nodes()[node%nnodes()];
+      if(cpus.size()==0) return;
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      for(auto c:cpus) CPU_SET(c,&cpuset);
+      pthread_setaffinity_np(pthread_self(),sizeof(cpu_set_t),&cpuset);
+#endif
+    }
+
+
+  private:
+
+    static vector<vector<int> > read_topology(){
+      vector<vector<int> > r;
+#ifdef __linux__
+      for(int node=0; ; node++){
+	ifstream ifs("/sys/devices/system/node/node"+to_string(node)+"/cpulist");
+	if(!ifs.good()) break;
+	string line;
+	std::getline(ifs,line);
+	r.push_back(parse_cpulist(line));
+      }
+#endif
+      if(r.size()==0) r.push_back(vector<int>());
+      return r;
+    }
+
+    // Parses the sysfs range format, e.g. "0-15,32-47".
+    static vector<int> parse_cpulist(const string& s){
+      vector<int> r;
+      std::istringstream iss(s);
+      string range;
+      while(std::getline(iss,range,',')){
+	if(range.size()==0) continue;
+	const auto dash=range.find('-');
+	if(dash==string::npos){
+	  r.push_back(std::stoi(range));
+	}else{
+	  const int beg=std::stoi(range.substr(0,dash));
+	  const int end=std::stoi(range.substr(dash+1));
+	  for(int i=beg; i<=end; i++) r.push_back(i);
+	}
+      }
+      return r;
+    }
+
+  };
+
+}
+
+#endif
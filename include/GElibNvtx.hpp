@@ -0,0 +1,54 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibNvtx
+#define _GElibNvtx
+
+// Scoped NVTX ranges around the Fn entry points, so Nsight Systems
+// timelines show GElib ops by name and CG shape instead of anonymous
+// kernels. Compiled out entirely unless WITH_NVTX is set; in production
+// builds the macro expands to nothing.
+
+#ifdef _WITH_NVTX
+
+#include <nvToolsExt.h>
+#include <string>
+
+namespace GElib{
+
+  class GElibNvtxRange{
+  public:
+
+    GElibNvtxRange(const char* name){
+      nvtxRangePushA(name);
+    }
+
+    GElibNvtxRange(const char* op, const int l1, const int l2, const int l, const int b){
+      nvtxRangePushA((std::string(op)+"("+std::to_string(l1)+","+std::to_string(l2)+","+
+	  std::to_string(l)+")[b="+std::to_string(b)+"]").c_str());
+    }
+
+    ~GElibNvtxRange(){
+      nvtxRangePop();
+    }
+
+  };
+
+}
+
+#define GELIB_NVTX_RANGE(...) GElib::GElibNvtxRange _gelib_nvtx_range(__VA_ARGS__)
+
+#else
+
+#define GELIB_NVTX_RANGE(...)
+
+#endif
+
+#endif
@@ -0,0 +1,127 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibOpStats
+#define _GElibOpStats
+
+#include <mutex>
+#include <memory>
+#include <sstream>
+
+#include "GElib_base.hpp"
+
+
+namespace GElib{
+
+  class GElibOpStats;
+
+}
+
+extern GElib::GElibOpStats gelib_op_stats;
+
+
+namespace GElib{
+
+  // Always-on operation statistics: op counts, flops and bytes moved by
+  // kernel type, collected even when logging is off. Each thread
+  // increments its own plain (non-atomic) counter struct, registered
+  // here on first use, so the per-call cost is a thread_local lookup
+  // and three additions; aggregation sums the per-thread structs on
+  // demand through GElibSession::stats(). Increments racing with an
+  // aggregation may or may not be included in the sums, which is
+  // acceptable for telemetry.
+
+  class GElibOpStats{
+  public:
+
+    enum op_t{CGproduct=0, DiagCGproduct=1, Fproduct=2, FFT=3, nops=4};
+
+    struct counters{
+      long calls[nops]={};
+      long flops[nops]={};
+      long bytes[nops]={};
+    };
+
+  private:
+
+    mutex safety_mx;
+    vector<std::unique_ptr<counters> > thread_counters;
+
+  public:
+
+    GElibOpStats(){}
+
+    GElibOpStats(const GElibOpStats& x)=delete;
+    GElibOpStats& operator=(const GElibOpStats& x)=delete;
+
+
+  public: // ---- Recording ----------------------------------------------------------------------------------
+
+
+    void count(const int op, const long _flops, const long _bytes){
+      counters& c=local_counters();
+      c.calls[op]++;
+      c.flops[op]+=_flops;
+      c.bytes[op]+=_bytes;
+    }
+
+
+  public: // ---- Aggregation --------------------------------------------------------------------------------
+
+
+    counters totals(){
+      lock_guard<mutex> lock(safety_mx);
+      counters R;
+      for(auto& p:thread_counters)
+	for(int i=0; i<nops; i++){
+	  R.calls[i]+=p->calls[i];
+	  R.flops[i]+=p->flops[i];
+	  R.bytes[i]+=p->bytes[i];
+	}
+      return R;
+    }
+
+    static const char* op_name(const int op){
+      const char* names[nops]={"CGproduct","DiagCGproduct","Fproduct","FFT"};
+      return names[op];
+    }
+
+    string str(){
+      counters t=totals();
+      ostringstream oss;
+      oss<<"GElib op statistics:"<<endl;
+      for(int i=0; i<nops; i++){
+	if(t.calls[i]==0) continue;
+	oss<<"  "<<op_name(i)<<": "<<t.calls[i]<<" calls, "<<t.flops[i]<<" flops, "
+	   <<t.bytes[i]<<" bytes"<<endl;
+      }
+      return oss.str();
+    }
+
+
+  private:
+
+    // One counter struct per thread, registered on first use; owned
+    // here so the structs outlive their threads.
+    counters& local_counters(){
+      thread_local counters* c=nullptr;
+      if(!c){
+	lock_guard<mutex> lock(safety_mx);
+	thread_counters.push_back(std::unique_ptr<counters>(new counters()));
+	c=thread_counters.back().get();
+      }
+      return *c;
+    }
+
+  };
+
+}
+
+#endif
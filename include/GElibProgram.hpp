@@ -0,0 +1,332 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibProgram
+#define _GElibProgram
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+
+#include "GElib_base.hpp"
+#include "GElibCudaGraphs.hpp"
+#include "GElibHugePages.hpp"
+#include "GElibManagedMemory.hpp"
+
+
+namespace GElib{
+
+  // Ahead-of-time compiled program for a fixed DAG of GElib operations.
+  // A deployed forward pass runs the same op sequence with the same
+  // shapes every step; this facility pays the per-call overheads once:
+  //
+  //   GElibProgram prog(dev);
+  //   int x=prog.add_input(nx);                 // sizes in floats
+  //   int t=prog.add_temp(nt);
+  //   int y=prog.add_output(ny);
+  //   prog.add_op([=](const GElibProgram::resolver& buf){
+  //       ... build views over buf(x),buf(t) and call the Fn ...
+  //     },{x},{t});                             // reads, writes
+  //   ...
+  //   prog.compile();
+  //   prog.execute({xptr},{yptr});              // every step
+  //
+  // compile() computes each buffer's live range from the recorded op
+  // order, packs the temporaries into one arena with liveness-based
+  // offset reuse (buffers whose lifetimes do not overlap share
+  // storage), and allocates the arena once on the program's device, so
+  // execute() never touches an allocator and its working set is the
+  // packed peak rather than the sum of all temporaries. Inputs and
+  // outputs also live at fixed arena addresses: execute() copies the
+  // caller's data in, runs the ops, and copies results out. On the
+  // device the first execute() captures the whole op sequence as one
+  // CUDA graph -- valid precisely because the plan fixed every address
+  // at compile time -- and later calls replay it with a single launch.
+  // Anything cached outside the graph (CG banks, Wigner matrices)
+  // must be warm before the first execute(); record a warmup hook for
+  // that, it runs once at compile().
+
+  class GElibProgram{
+  public:
+
+    typedef std::function<float*(const int)> resolver;
+
+    // Runs once at compile(), before any capture: put bank-priming
+    // calls here (see GElibWarmupManifest).
+    std::function<void()> warmup;
+
+
+  private:
+
+    struct Buffer{
+      size_t floats;
+      int kind;          // 0=temp, 1=input, 2=output
+      int first=-1;      // op index of first access
+      int last=-1;       // op index of last access
+      size_t offset=0;   // into the arena, in floats
+    };
+
+    struct Op{
+      std::function<void(const resolver&)> fn;
+      vector<int> reads;
+      vector<int> writes;
+    };
+
+    int dev;
+    vector<Buffer> buffers;
+    vector<Op> ops;
+    vector<int> inputs;
+    vector<int> outputs;
+
+    bool compiled=false;
+    size_t arena_floats=0;
+    float* arena=nullptr;
+
+#ifdef _WITH_CUDA
+    bool captured=false;
+    cudaGraphExec_t graph_exec;
+    cudaStream_t stream=0;
+#endif
+
+
+  public:
+
+    GElibProgram(const int _dev=0): dev(_dev){}
+
+    GElibProgram(const GElibProgram& x)=delete;
+    GElibProgram& operator=(const GElibProgram& x)=delete;
+
+    ~GElibProgram(){
+      if(arena){
+	if(dev==0) gelib_huge_pages.free(arena);
+#ifdef _WITH_CUDA
+	else cudaFree(arena);
+#endif
+      }
+#ifdef _WITH_CUDA
+      if(captured) cudaGraphExecDestroy(graph_exec);
+      if(stream) cudaStreamDestroy(stream);
+#endif
+    }
+
+
+  public: // ---- Recording ----------------------------------------------------------------------------------
+
+
+    int add_input(const size_t floats){
+      GELIB_ASSRT(!compiled);
+      buffers.push_back(Buffer{floats,1});
+      inputs.push_back(buffers.size()-1);
+      return buffers.size()-1;
+    }
+
+    int add_output(const size_t floats){
+      GELIB_ASSRT(!compiled);
+      buffers.push_back(Buffer{floats,2});
+      outputs.push_back(buffers.size()-1);
+      return buffers.size()-1;
+    }
+
+    int add_temp(const size_t floats){
+      GELIB_ASSRT(!compiled);
+      buffers.push_back(Buffer{floats,0});
+      return buffers.size()-1;
+    }
+
+    void add_op(const std::function<void(const resolver&)>& fn,
+      const vector<int>& reads, const vector<int>& writes){
+      GELIB_ASSRT(!compiled);
+      const int i=ops.size();
+      for(auto b:reads) touch(b,i);
+      for(auto b:writes) touch(b,i);
+      ops.push_back(Op{fn,reads,writes});
+    }
+
+
+  public: // ---- Access -------------------------------------------------------------------------------------
+
+
+    int n_ops() const{
+      return ops.size();
+    }
+
+    // Arena footprint of the compiled plan, in floats.
+    size_t footprint() const{
+      GELIB_ASSRT(compiled);
+      return arena_floats;
+    }
+
+
+  public: // ---- Compilation --------------------------------------------------------------------------------
+
+
+    // Assigns every buffer a fixed arena offset. Inputs and outputs
+    // are live for the whole program; temporaries are live from their
+    // first to their last access, and a freed temporary's interval is
+    // handed to the next buffer that fits (first fit, adjacent holes
+    // merged), which is what makes the footprint the packed peak.
+    void compile(){
+      GELIB_ASSRT(!compiled);
+
+      // allocation events in order of first access; whole-program
+      // buffers first
+      vector<int> order;
+      for(int b=0; b<(int)buffers.size(); b++)
+	if(buffers[b].kind!=0) order.push_back(b);
+      vector<int> temps;
+      for(int b=0; b<(int)buffers.size(); b++)
+	if(buffers[b].kind==0 && buffers[b].first>=0) temps.push_back(b);
+      std::sort(temps.begin(),temps.end(),[&](const int a, const int b){
+	  return buffers[a].first<buffers[b].first;});
+      for(auto b:temps) order.push_back(b);
+
+      std::map<size_t,size_t> holes;   // offset -> size, all in floats
+      std::multimap<int,int> active;   // last access -> buffer, for freeing
+      arena_floats=0;
+
+      for(auto b:order){
+	// free every temporary whose live range ended before this one starts
+	if(buffers[b].kind==0){
+	  for(auto it=active.begin(); it!=active.end() && it->first<buffers[b].first;){
+	    free_hole(holes,buffers[it->second].offset,buffers[it->second].floats);
+	    it=active.erase(it);
+	  }
+	}
+	buffers[b].offset=take_hole(holes,buffers[b].floats);
+	if(buffers[b].kind==0) active.insert({buffers[b].last,b});
+      }
+
+      if(arena_floats>0){
+	if(dev==0) arena=(float*)gelib_huge_pages.alloc(arena_floats*sizeof(float));
+#ifdef _WITH_CUDA
+	else if(gelib_config && gelib_config->managed_memory)
+	  CUDA_SAFE(cudaMallocManaged(&arena,arena_floats*sizeof(float)));
+	else CUDA_SAFE(cudaMalloc(&arena,arena_floats*sizeof(float)));
+#else
+	else GELIB_ASSRT(dev==0);
+#endif
+      }
+
+      compiled=true;
+      if(warmup) warmup();
+    }
+
+
+  public: // ---- Execution ----------------------------------------------------------------------------------
+
+
+    // Copies the inputs to their arena slots, runs the recorded ops and
+    // copies the outputs out. On the device the op sequence is captured
+    // as a CUDA graph on the first call and replayed afterwards; the
+    // in/out copies stay outside the graph, so the caller's pointers
+    // may change between calls.
+    void execute(const vector<float*>& in, const vector<float*>& out){
+      GELIB_ASSRT(compiled);
+      GELIB_ASSRT(in.size()==inputs.size());
+      GELIB_ASSRT(out.size()==outputs.size());
+
+      for(int i=0; i<(int)inputs.size(); i++)
+	copy_in(arena+buffers[inputs[i]].offset,in[i],buffers[inputs[i]].floats);
+
+      resolver buf=[&](const int b){
+	return arena+buffers[b].offset;};
+
+#ifdef _WITH_CUDA
+      if(dev>0){
+	if(!stream) CUDA_SAFE(cudaStreamCreate(&stream));
+	if(!captured){
+	  CUDA_SAFE(cudaStreamBeginCapture(stream,cudaStreamCaptureModeThreadLocal));
+	  gelib_cuda_current_stream=stream;
+	  for(auto& op:ops) op.fn(buf);
+	  gelib_cuda_current_stream=0;
+	  cudaGraph_t graph;
+	  CUDA_SAFE(cudaStreamEndCapture(stream,&graph));
+	  CUDA_SAFE(cudaGraphInstantiate(&graph_exec,graph,nullptr,nullptr,0));
+	  CUDA_SAFE(cudaGraphDestroy(graph));
+	  captured=true;
+	}
+	CUDA_SAFE(cudaGraphLaunch(graph_exec,stream));
+	CUDA_SAFE(cudaStreamSynchronize(stream));
+      }
+      else
+	for(auto& op:ops) op.fn(buf);
+#else
+      for(auto& op:ops) op.fn(buf);
+#endif
+
+      for(int i=0; i<(int)outputs.size(); i++)
+	copy_out(out[i],arena+buffers[outputs[i]].offset,buffers[outputs[i]].floats);
+    }
+
+
+  private:
+
+    void touch(const int b, const int i){
+      GELIB_ASSRT(b>=0 && b<(int)buffers.size());
+      if(buffers[b].first<0) buffers[b].first=i;
+      buffers[b].last=i;
+    }
+
+    // First-fit allocation from the hole list, growing the arena when
+    // nothing fits.
+    size_t take_hole(std::map<size_t,size_t>& holes, const size_t floats){
+      for(auto it=holes.begin(); it!=holes.end(); it++){
+	if(it->second<floats) continue;
+	const size_t offs=it->first;
+	const size_t rest=it->second-floats;
+	holes.erase(it);
+	if(rest>0) holes[offs+floats]=rest;
+	return offs;
+      }
+      const size_t offs=arena_floats;
+      arena_floats+=floats;
+      return offs;
+    }
+
+    void free_hole(std::map<size_t,size_t>& holes, size_t offs, size_t floats){
+      auto next=holes.lower_bound(offs);
+      if(next!=holes.end() && offs+floats==next->first){
+	floats+=next->second;
+	holes.erase(next);
+      }
+      if(!holes.empty()){
+	auto prev=holes.lower_bound(offs);
+	if(prev!=holes.begin()){
+	  prev--;
+	  if(prev->first+prev->second==offs){
+	    prev->second+=floats;
+	    return;
+	  }
+	}
+      }
+      holes[offs]=floats;
+    }
+
+    void copy_in(float* dst, const float* src, const size_t floats){
+      if(dev==0) std::memcpy(dst,src,floats*sizeof(float));
+#ifdef _WITH_CUDA
+      else CUDA_SAFE(cudaMemcpy(dst,src,floats*sizeof(float),cudaMemcpyDefault));
+#endif
+    }
+
+    void copy_out(float* dst, const float* src, const size_t floats){
+      if(dev==0) std::memcpy(dst,src,floats*sizeof(float));
+#ifdef _WITH_CUDA
+      else CUDA_SAFE(cudaMemcpy(dst,src,floats*sizeof(float),cudaMemcpyDefault));
+#endif
+    }
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,161 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibRoofline
+#define _GElibRoofline
+
+#include <mutex>
+#include <map>
+#include <sstream>
+#include <iomanip>
+
+#include "GElib_base.hpp"
+
+
+namespace GElib{
+
+  class GElibRoofline;
+
+}
+
+extern GElib::GElibRoofline gelib_roofline;
+
+
+namespace GElib{
+
+  // Roofline-style efficiency accounting per CG shape class. Every timed
+  // CG product feeds its (l1,l2,l,B,N1,N2,dev) shape and elapsed time in
+  // here; bytes moved are estimated from the shape (complex float
+  // operands read once, result written once). The session-end summary
+  // reports achieved flops and bandwidth against the peak figures for
+  // each device and classifies each shape as launch-bound (mean time
+  // below the launch floor), bandwidth-bound or compute-bound, so the
+  // shapes worth tuning stand out at a glance. Peaks default to
+  // conservative figures and should be set for the actual hardware via
+  // GELIB_PEAK_CPU_GFLOPS, GELIB_PEAK_CPU_GBPS, GELIB_PEAK_GPU_GFLOPS
+  // and GELIB_PEAK_GPU_GBPS; the table is printed at shutdown when
+  // GELIB_ROOFLINE is set.
+
+  class GElibRoofline{
+  public:
+
+    struct entry{
+      long calls=0;
+      double total_ms=0;
+      double total_flops=0;
+      double total_bytes=0;
+    };
+
+  private:
+
+    mutex mx;
+    std::map<array<int,7>,entry> table; // (l1,l2,l,B,N1,N2,dev)
+
+    // [0]=host, [1]=device
+    double peak_gflops[2]={50,5000};
+    double peak_gbps[2]={30,500};
+
+    // Below this mean time per call the launch/dispatch overhead
+    // dominates whatever the kernel does.
+    double launch_floor_us=10;
+
+  public:
+
+    GElibRoofline(){
+      if(const char* e=std::getenv("GELIB_PEAK_CPU_GFLOPS")) peak_gflops[0]=std::stod(e);
+      if(const char* e=std::getenv("GELIB_PEAK_CPU_GBPS")) peak_gbps[0]=std::stod(e);
+      if(const char* e=std::getenv("GELIB_PEAK_GPU_GFLOPS")) peak_gflops[1]=std::stod(e);
+      if(const char* e=std::getenv("GELIB_PEAK_GPU_GBPS")) peak_gbps[1]=std::stod(e);
+    }
+
+    GElibRoofline(const GElibRoofline& x)=delete;
+    GElibRoofline& operator=(const GElibRoofline& x)=delete;
+
+
+  public: // ---- Recording ----------------------------------------------------------------------------------
+
+
+    void add(const int l1, const int l2, const int l, const int b, const int n1, const int n2,
+      const int dev, const double ms, const long n_ops){
+      lock_guard<mutex> lock(mx);
+      entry& e=table[array<int,7>({l1,l2,l,b,n1,n2,dev})];
+      e.calls++;
+      e.total_ms+=ms;
+      e.total_flops+=n_ops;
+      e.total_bytes+=8.0*b*((2*l1+1)*n1+(2*l2+1)*n2+(2*l+1)*n1*n2);
+    }
+
+
+  public: // ---- Queries ------------------------------------------------------------------------------------
+
+
+    // Observed throughput in flops/ms for a shape on the host (dev=0)
+    // or the device, used by the co-scheduling cost model (see
+    // SO3vec_addCGproductFn): the shape's own history if it has any,
+    // otherwise the aggregate over all timed shapes on that processor,
+    // otherwise the configured peak.
+    double rate(const int l1, const int l2, const int l, const int b, const int n1, const int n2, const int dev){
+      lock_guard<mutex> lock(mx);
+      auto it=table.find(array<int,7>({l1,l2,l,b,n1,n2,dev}));
+      if(it!=table.end() && it->second.total_ms>0)
+	return it->second.total_flops/it->second.total_ms;
+      double fl=0;
+      double ms=0;
+      for(auto& p:table)
+	if((p.first[6]>0)==(dev>0)){
+	  fl+=p.second.total_flops;
+	  ms+=p.second.total_ms;
+	}
+      if(ms>0) return fl/ms;
+      return 1.0e6*peak_gflops[dev>0];
+    }
+
+
+  public: // ---- Reporting ----------------------------------------------------------------------------------
+
+
+    bool empty(){
+      lock_guard<mutex> lock(mx);
+      return table.size()==0;
+    }
+
+    string str(){
+      lock_guard<mutex> lock(mx);
+      ostringstream oss;
+      oss<<"CG shape roofline (peaks: CPU "<<peak_gflops[0]<<" Gflops/"<<peak_gbps[0]
+	 <<" GB/s, GPU "<<peak_gflops[1]<<" Gflops/"<<peak_gbps[1]<<" GB/s):"<<endl;
+      for(auto& p:table){
+	const int dev=(p.first[6]>0);
+	const entry& e=p.second;
+	const double us_per_call=1000.0*e.total_ms/e.calls;
+	const double gflops=e.total_flops/e.total_ms/1.0e6;
+	const double gbps=e.total_bytes/e.total_ms/1.0e6;
+	const double flop_frac=gflops/peak_gflops[dev];
+	const double bw_frac=gbps/peak_gbps[dev];
+
+	const char* bound="compute-bound";
+	if(us_per_call<launch_floor_us) bound="launch-bound";
+	else if(bw_frac>flop_frac) bound="bandwidth-bound";
+
+	oss<<"  ("<<p.first[0]<<","<<p.first[1]<<","<<p.first[2]<<")[b="<<p.first[3]
+	   <<",n1="<<p.first[4]<<",n2="<<p.first[5]<<",dev="<<p.first[6]<<"] "
+	   <<e.calls<<" calls, "<<std::fixed<<std::setprecision(1)<<us_per_call<<" us/call, "
+	   <<gflops<<" Gflops ("<<(int)(100*flop_frac)<<"%), "
+	   <<gbps<<" GB/s ("<<(int)(100*bw_frac)<<"%) "<<bound<<endl;
+	oss<<std::defaultfloat;
+      }
+      return oss.str();
+    }
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,114 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibScratchArena
+#define _GElibScratchArena
+
+#include <cstdlib>
+
+#include "GElib_base.hpp"
+#include "GElibHugePages.hpp"
+
+
+namespace GElib{
+
+  // Thread-local slab arena for short-lived host-side storage. Chains
+  // of SO(3) operations construct and destroy temporaries at high
+  // frequency; the arena replaces their per-object malloc/free with a
+  // bump-pointer allocation into slabs, released wholesale when a
+  // scope object goes out of scope:
+  //
+  //   { GElibScratchArena::scope s;
+  //     ... scratch allocations ...
+  //   }            // everything allocated inside is released here
+  //
+  // GElibSession exposes this as GElibSession::scratch_scope. Scopes
+  // nest; slabs themselves are retained and reused across scopes, so
+  // after warm-up a steady-state loop never touches the allocator.
+  // Only storage that does not escape its scope may come from here.
+
+  class GElibScratchArena{
+  public:
+
+    static constexpr size_t slab_bytes=1<<22;
+    static constexpr size_t alignment=64;
+
+    struct Slab{
+      char* mem;
+      size_t cap;
+      size_t used;
+    };
+
+    vector<Slab> slabs;
+    int cur=-1;
+
+
+    GElibScratchArena(){}
+    GElibScratchArena(const GElibScratchArena& x)=delete;
+    GElibScratchArena& operator=(const GElibScratchArena& x)=delete;
+
+    ~GElibScratchArena(){
+      for(auto& s:slabs) gelib_huge_pages.free(s.mem);
+    }
+
+
+    void* alloc(const size_t bytes){
+      const size_t n=(bytes+alignment-1)/alignment*alignment;
+      while(cur<0 || slabs[cur].used+n>slabs[cur].cap){
+	if(cur+1<(int)slabs.size()){
+	  cur++;
+	  continue;
+	}
+	Slab s;
+	s.cap=std::max(n,slab_bytes);
+	s.mem=(char*)gelib_huge_pages.alloc(s.cap);
+	s.used=0;
+	slabs.push_back(s);
+	cur=slabs.size()-1;
+      }
+      void* p=slabs[cur].mem+slabs[cur].used;
+      slabs[cur].used+=n;
+      return p;
+    }
+
+
+    class scope{
+    public:
+      int saved_cur;
+      size_t saved_used;
+
+      scope();
+      ~scope();
+      scope(const scope&)=delete;
+      scope& operator=(const scope&)=delete;
+    };
+
+  };
+
+
+  inline thread_local GElibScratchArena gelib_scratch;
+
+
+  inline GElibScratchArena::scope::scope(){
+    saved_cur=gelib_scratch.cur;
+    saved_used=saved_cur>=0? gelib_scratch.slabs[saved_cur].used : 0;
+  }
+
+  inline GElibScratchArena::scope::~scope(){
+    auto& a=gelib_scratch;
+    for(int i=std::max(saved_cur,0); i<=a.cur && i<(int)a.slabs.size(); i++)
+      a.slabs[i].used=0;
+    if(saved_cur>=0) a.slabs[saved_cur].used=saved_used;
+    a.cur=saved_cur;
+  }
+
+}
+
+#endif
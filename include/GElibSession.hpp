@@ -15,9 +15,24 @@
 #include "CnineSession.hpp"
 #include "GElibConfig.hpp"
 #include "GElibLog.hpp"
+#include "GElibTimer.hpp"
+#include "GElibProfiler.hpp"
+#include "GElibOpStats.hpp"
+#include "GElibWarmupManifest.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibExecutor.hpp"
+#include "GElibCudaArena.hpp"
+#include "GElibMemoryMonitor.hpp"
+#include "GElibScratchArena.hpp"
+#include "GElibGradArena.hpp"
+#include "SO3FproductTuner.hpp"
+#include "SO3_SphCoeffs.hpp"
 
 extern GElib::GElibConfig* gelib_config;
 extern GElib::GElibLog* gelib_log;
+extern GElib::GElibProfiler* gelib_profiler;
+extern GElib::GElibThreadPool* gelib_threadpool;
+extern GElib::GElibExecutor* gelib_executor;
 
 namespace GElib{
 
@@ -26,6 +41,22 @@ namespace GElib{
 
     cnine::cnine_session* cnine_session=nullptr;
 
+    // If set, the banks are snapshotted into this file at shutdown, so
+    // the next run can warm up with the same manifest.
+    string record_warmup_file;
+
+    // If set, the Fproduct tuning table is re-recorded into this file
+    // at shutdown.
+    string record_tuning_file;
+
+    // If set, the spherical coefficient tables are re-recorded into
+    // this file at shutdown when precompute() extended them.
+    string record_sph_file;
+
+    // If set, the tuning registry is re-recorded into this file at
+    // shutdown, capturing any knobs the autotuners adjusted.
+    string record_config_file;
+
 
     GElibSession(const int _nthreads=1){
 
@@ -38,16 +69,164 @@ namespace GElib{
       cnine_session=new cnine::cnine_session(_nthreads);
       gelib_config=new GElibConfig();
       gelib_log=new GElibLog();
+      #ifdef _WITH_CUDA
+      gelib_log->idle_hook=[](){gelib_cuda_timings.collect();};
+      #endif
+      // GELIB_ARTIFACT names a directory built offline by gelib-tune
+      // (see bench/gelib-tune.cpp): tuned config, warm-up manifest,
+      // Fproduct decision table, spherical coefficient tables and the
+      // JIT kernel cache in one bundle. The config is loaded first so
+      // that GELIB_CONFIG and the individual environment variables
+      // below still override it; the remaining pieces are loaded once
+      // the pools are up. The artifact is treated as read-only -- none
+      // of the record_* files point into it.
+      string artifact_dir;
+      if(const char* e=std::getenv("GELIB_ARTIFACT")){
+	artifact_dir=e;
+	gelib_config->load(artifact_dir+"/config.txt");
+      }
+      // Runtime tuning registry: GELIB_CONFIG names a key=value file
+      // covering every knob in GElibConfig, loaded here and re-recorded
+      // at shutdown so autotuned values follow the model to other hosts
+      // of the same SKU. Individual GELIB_<KNOB> environment variables
+      // override the file.
+      if(const char* e=std::getenv("GELIB_CONFIG")){
+	gelib_config->load(e);
+	record_config_file=e;
+      }
+      gelib_config->load_env();
+      if(std::getenv("GELIB_NUMA_PIN")) gelib_config->numa_pin_threads=true;
+      if(std::getenv("GELIB_JIT_CG")) gelib_config->SO3part_CGjit_kernels=true;
+      if(std::getenv("GELIB_DETERMINISTIC")) gelib_config->deterministic=true;
+      if(std::getenv("GELIB_COSCHEDULE")) gelib_config->hetero_coschedule=true;
+      if(std::getenv("GELIB_LATENCY_CRITICAL")) gelib_config->latency_critical=true;
+      gelib_threadpool=new GElibThreadPool(_nthreads,gelib_config->numa_pin_threads);
+      gelib_executor=new GElibExecutor();
+      #ifdef _WITH_CUDA
+      // Switch device temporaries to stream-ordered allocation where
+      // the runtime supports it; see GElibCudaArena.
+      gelib_cuda_arena.configure_pool();
+      #endif
+
+      if(artifact_dir.size()>0){
+	warmup(artifact_dir+"/warmup.txt");
+	SO3Fproduct_tuner.load(artifact_dir+"/fproduct.txt");
+	SO3_sphCoeffs.load(artifact_dir+"/sph.bin");
+	#ifdef _WITH_CUDA
+	setenv("GELIB_CG_JIT_CACHE",(artifact_dir+"/jit").c_str(),0);
+	#endif
+      }
+
+      // If GELIB_WARMUP names a manifest file, preload it now and
+      // re-record it at shutdown: the first run of a workload populates
+      // the banks lazily, every later run pays the cost at startup
+      // instead of on its first requests.
+      if(const char* e=std::getenv("GELIB_WARMUP")){
+	warmup(e);
+	record_warmup_file=e;
+      }
+
+      // Likewise, GELIB_FPRODUCT_TUNING names a persisted Fproduct
+      // tuning table: decisions benchmarked in earlier runs are reused
+      // and any new shapes tuned in this run are added at shutdown.
+      if(const char* e=std::getenv("GELIB_FPRODUCT_TUNING")){
+	SO3Fproduct_tuner.load(e);
+	record_tuning_file=e;
+      }
+
+      // GELIB_TRACE names a Chrome trace-event JSON file: the
+      // structured profiler records every timed region for the whole
+      // session and writes the trace at shutdown (see GElibProfiler).
+      if(const char* e=std::getenv("GELIB_TRACE"))
+	gelib_profiler=new GElibProfiler(e);
+
+      // GELIB_SPH_CACHE names the serialized spherical coefficient
+      // tables (see SO3_SphCoeffs); loading replaces per-process table
+      // generation with an mmap.
+      if(const char* e=std::getenv("GELIB_SPH_CACHE")){
+	SO3_sphCoeffs.load(e);
+	record_sph_file=e;
+      }
+    }
+
+    GElibSession(const string& warmup_file, const int _nthreads=1):
+      GElibSession(_nthreads){
+      warmup(warmup_file);
+    }
+
+
+    // Scope-based release for the thread-local scratch arena; see
+    // GElibScratchArena.
+    typedef GElibScratchArena::scope scratch_scope;
+
+
+    // Installs the session-owned gradient arena for the WITH_FAKE_GRAD
+    // path: grad buffers created while it is installed are carved
+    // contiguously from one block, making zero_grad a single memset and
+    // microbatch gradient accumulation a single fused axpy (see
+    // GElibGradArena).
+    void install_grad_arena(const size_t nfloats, const int dev=0){
+      GELIB_ASSRT(gelib_grad_arena==nullptr);
+      gelib_grad_arena=new GElibGradArena(nfloats,dev);
     }
 
 
     ~GElibSession(){
       cout<<"Shutting down GElib."<<endl;
+      if(std::getenv("GELIB_MEMORY_REPORT"))
+	cout<<gelib_memory.str();
+      // Peak breakdown as JSON for postmortem tooling; see
+      // GElibMemoryMonitor::save_json.
+      if(const char* e=std::getenv("GELIB_MEMORY_JSON"))
+	gelib_memory.save_json(e);
+      if(record_warmup_file.size()>0)
+	GElibWarmupManifest::record().save(record_warmup_file);
+      if(record_tuning_file.size()>0)
+	SO3Fproduct_tuner.save(record_tuning_file);
+      if(record_sph_file.size()>0 && SO3_sphCoeffs.dirty())
+	SO3_sphCoeffs.save(record_sph_file);
+      if(record_config_file.size()>0)
+	gelib_config->save(record_config_file);
+      delete gelib_grad_arena;
+      gelib_grad_arena=nullptr;
+      delete gelib_profiler;
+      gelib_profiler=nullptr;
+      delete gelib_executor;
+      gelib_executor=nullptr;
+      delete gelib_threadpool;
+      gelib_threadpool=nullptr;
+      gelib_cuda_arena.clear();
+      #ifdef _WITH_CUDA
+      gelib_cuda_timings.collect(true);
+      #endif
+      // After the CUDA event flush so GPU shapes are included.
+      if(std::getenv("GELIB_ROOFLINE") && !gelib_roofline.empty())
+	cout<<gelib_roofline.str();
       delete gelib_log;
       delete gelib_config;
       delete cnine_session;
     }
-    
+
+
+    // Aggregated always-on op counters (calls/flops/bytes by kernel
+    // type); see GElibOpStats.
+    GElibOpStats::counters stats_totals() const{
+      return gelib_op_stats.totals();
+    }
+
+    string stats() const{
+      return gelib_op_stats.str();
+    }
+
+
+    void warmup(const GElibWarmupManifest& manifest){
+      manifest.preload();
+    }
+
+    void warmup(const string& filename){
+      GElibWarmupManifest(filename).preload();
+    }
+
   };
 
 }
@@ -0,0 +1,112 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibTaskGraph
+#define _GElibTaskGraph
+
+#include <functional>
+#include <climits>
+
+#include "GElib_base.hpp"
+#include "GElibThreadPool.hpp"
+
+
+namespace GElib{
+
+  // A small dependency graph for the part-level operations making up a
+  // vec-level call. Each task is recorded with the tensor regions it
+  // reads and writes; two tasks conflict if one writes a region the
+  // other touches. run() executes the graph in waves of mutually
+  // independent tasks on the session's thread pool, so e.g. the
+  // (l1,l2,l) triples of a CGproduct backward pass, which are serialized
+  // today only because several of them accumulate into the same gradient
+  // part, run concurrently whenever their write sets are disjoint.
+
+  class GElibTaskGraph{
+  public:
+
+    class Region{
+    public:
+      const void* tensor;
+      int beg;
+      int end;
+      Region(const void* _tensor): tensor(_tensor), beg(0), end(INT_MAX){}
+      Region(const void* _tensor, const int _beg, const int _end):
+	tensor(_tensor), beg(_beg), end(_end){}
+      bool overlaps(const Region& y) const{
+	return tensor==y.tensor && beg<y.end && y.beg<end;
+      }
+    };
+
+
+  private:
+
+    class Task{
+    public:
+      std::function<void()> fn;
+      vector<Region> reads;
+      vector<Region> writes;
+    };
+
+    vector<Task> tasks;
+
+
+  public:
+
+    void add(std::function<void()> fn, vector<Region> reads, vector<Region> writes){
+      tasks.push_back(Task{std::move(fn),std::move(reads),std::move(writes)});
+    }
+
+
+    void run(){
+      const int T=tasks.size();
+      if(T==0) return;
+      if(T==1){tasks[0].fn(); return;}
+
+      vector<vector<int> > deps(T);
+      for(int j=0; j<T; j++)
+	for(int i=0; i<j; i++)
+	  if(conflicts(tasks[i],tasks[j])) deps[j].push_back(i);
+
+      vector<bool> done(T,false);
+      int ndone=0;
+      while(ndone<T){
+	vector<int> wave;
+	for(int j=0; j<T; j++){
+	  if(done[j]) continue;
+	  bool ready=true;
+	  for(auto i:deps[j])
+	    if(!done[i]){ready=false; break;}
+	  if(ready) wave.push_back(j);
+	}
+	GElibMultiLoop(wave.size(),[&](const int i){tasks[wave[i]].fn();});
+	for(auto j:wave) done[j]=true;
+	ndone+=wave.size();
+      }
+    }
+
+
+  private:
+
+    static bool conflicts(const Task& x, const Task& y){
+      for(auto& w:y.writes){
+	for(auto& r:x.reads) if(w.overlaps(r)) return true;
+	for(auto& r:x.writes) if(w.overlaps(r)) return true;
+      }
+      for(auto& w:x.writes)
+	for(auto& r:y.reads) if(w.overlaps(r)) return true;
+      return false;
+    }
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,319 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibThreadPool
+#define _GElibThreadPool
+
+#include <thread>
+#include <deque>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+
+#ifdef _WITH_OPENMP
+#include <omp.h>
+#endif
+#ifdef _WITH_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#endif
+
+#include "GElib_base.hpp"
+#include "MultiLoop.hpp"
+#include "GElibNuma.hpp"
+
+
+namespace GElib{
+
+  // Persistent thread pool shared by all Fn kernels. cnine::MultiLoop
+  // spins threads up and down on every call, which on the thousands of
+  // small CG products in a typical forward pass costs more than the
+  // loop bodies themselves. Here the workers are created once per
+  // session and loops are posted to a shared queue of iteration ranges:
+  // every worker claims iterations from the front task, so a loop with
+  // a small batch dimension no longer caps parallelism — tasks posted
+  // concurrently from several application threads interleave on the
+  // same workers.
+
+  class GElibThreadPool{
+  public:
+
+    class Task{
+    public:
+      const int n;
+      const int grain;
+      const std::function<void(const int)>* lambda;
+      std::atomic<int> next;
+      int done=0;
+      mutex mx;
+      condition_variable cv;
+      Task(const int _n, const int _grain, const std::function<void(const int)>* _lambda):
+	n(_n), grain(_grain), lambda(_lambda), next(0){}
+      Task(std::function<void(const int)> _owned):
+	n(1), grain(1), owned(std::move(_owned)), next(0){
+	lambda=&owned;
+      }
+    private:
+      std::function<void(const int)> owned;
+    };
+
+
+  private:
+
+    vector<thread> workers;
+    std::deque<shared_ptr<Task> > queue;
+    mutex mx;
+    condition_variable cv;
+    bool shutting_down=false;
+
+    inline static thread_local bool on_worker_thread=false;
+
+    // Stable participant rank: 0 for the application thread, 1..W for
+    // the workers. Used by parallel_for_static for locality-preferring
+    // chunk assignment.
+    inline static thread_local int thread_rank=0;
+
+
+  public:
+
+    // With _pin_numa set, worker i is pinned to NUMA node i%nnodes, so
+    // on a multi-socket machine the pool is spread evenly over the
+    // sockets and parallel_for_static keeps chunk->socket assignments
+    // stable between a first-touch pass and later compute passes.
+    GElibThreadPool(const int _nthreads=1, const bool _pin_numa=false){
+      for(int i=0; i<_nthreads-1; i++)
+	workers.push_back(thread([this,i,_pin_numa](){
+	      thread_rank=i+1;
+	      if(_pin_numa) GElibNuma::pin_current_thread_to_node((i+1)%GElibNuma::nnodes());
+	      worker_loop();
+	    }));
+      if(_pin_numa) GElibNuma::pin_current_thread_to_node(0);
+    }
+
+    GElibThreadPool(const GElibThreadPool& x)=delete;
+    GElibThreadPool& operator=(const GElibThreadPool& x)=delete;
+
+    ~GElibThreadPool(){
+      {
+	lock_guard<mutex> lock(mx);
+	shutting_down=true;
+      }
+      cv.notify_all();
+      for(auto& w:workers) w.join();
+    }
+
+    int nworkers() const{
+      return workers.size()+1;
+    }
+
+
+  public:
+
+    // Runs lambda(0),...,lambda(n-1) on the pool and blocks until all
+    // iterations have finished. The calling thread participates, so a
+    // single-threaded pool degenerates to a plain loop. Nested calls
+    // from inside a pool task run inline: the outer loop already owns
+    // the workers.
+    //
+    // grain controls how many consecutive iterations are claimed per
+    // atomic operation: 1 for coarse loop bodies, larger values for
+    // loops over many small cells. The default grain<=0 picks
+    // n/(8*nworkers), which keeps claiming overhead negligible on a
+    // 10k-cell grid while still load balancing 8 chunks per thread.
+    void parallel_for(const int n, const std::function<void(const int)>& lambda, const int _grain=0){
+      if(n<=0) return;
+      if(n==1 || workers.size()==0 || on_worker_thread){
+	for(int i=0; i<n; i++) lambda(i);
+	return;
+      }
+      const int grain=_grain>0? _grain : std::max(1,n/(8*nworkers()));
+
+      auto task=make_shared<Task>(n,grain,&lambda);
+      {
+	lock_guard<mutex> lock(mx);
+	queue.push_back(task);
+      }
+      cv.notify_all();
+
+      run_share(*task);
+      {
+	lock_guard<mutex> lock(mx);
+	for(auto it=queue.begin(); it!=queue.end(); it++)
+	  if(*it==task){queue.erase(it); break;}
+      }
+
+      unique_lock<mutex> lock(task->mx);
+      task->cv.wait(lock,[&](){return task->done==n;});
+    }
+
+
+    // Like parallel_for, but splits the range into one contiguous chunk
+    // per participant and lets each participant claim the chunk matching
+    // its own rank first, stealing other chunks only when its own is
+    // taken. On an idle pool this yields the same iteration->thread (and
+    // with NUMA pinning, iteration->socket) mapping on every call, so a
+    // first-touch pass and the compute passes that follow it see the
+    // same page placement.
+    void parallel_for_static(const int n, const std::function<void(const int)>& lambda){
+      if(n<=0) return;
+      const int P=std::min(nworkers(),n);
+      if(P==1 || on_worker_thread){
+	for(int i=0; i<n; i++) lambda(i);
+	return;
+      }
+
+      std::unique_ptr<std::atomic<char>[]> claimed(new std::atomic<char>[P]);
+      for(int i=0; i<P; i++) claimed[i]=0;
+
+      parallel_for(P,[&](const int dummy){
+	  (void)dummy;
+	  const int r=thread_rank%P;
+	  for(int t=0; t<P; t++){
+	    const int c=(r+t)%P;
+	    char expected=0;
+	    if(!claimed[c].compare_exchange_strong(expected,1)) continue;
+	    const int beg=((long)n*c)/P;
+	    const int end=((long)n*(c+1))/P;
+	    for(int i=beg; i<end; i++) lambda(i);
+	    return;
+	  }
+	});
+    }
+
+
+    // Fire-and-forget: queues fn for execution on a worker and returns
+    // immediately. Completion signalling is the caller's business
+    // (GElibExecutor layers futures on top of this). If the pool has no
+    // workers, fn runs inline.
+    void submit(std::function<void()> fn){
+      if(workers.size()==0){fn(); return;}
+      auto task=make_shared<Task>([fn=std::move(fn)](const int){fn();});
+      {
+	lock_guard<mutex> lock(mx);
+	queue.push_back(task);
+      }
+      cv.notify_one();
+    }
+
+
+  private:
+
+    void worker_loop(){
+      on_worker_thread=true;
+      while(true){
+	shared_ptr<Task> task;
+	{
+	  unique_lock<mutex> lock(mx);
+	  cv.wait(lock,[&](){return shutting_down || queue.size()>0;});
+	  if(queue.size()==0) return;
+	  task=queue.front();
+	}
+	run_share(*task);
+	{
+	  lock_guard<mutex> lock(mx);
+	  if(queue.size()>0 && queue.front()==task && task->next.load()>=task->n)
+	    queue.pop_front();
+	}
+      }
+    }
+
+    // Claims blocks of grain iterations from task until none remain,
+    // then reports how many this thread executed and wakes the owner if
+    // the task is done.
+    void run_share(Task& task){
+      int ndone=0;
+      while(true){
+	const int i0=task.next.fetch_add(task.grain);
+	if(i0>=task.n) break;
+	const int i1=std::min(i0+task.grain,task.n);
+	for(int i=i0; i<i1; i++) (*task.lambda)(i);
+	ndone+=i1-i0;
+      }
+      if(ndone>0){
+	lock_guard<mutex> lock(task.mx);
+	task.done+=ndone;
+	task.cv.notify_all();
+      }
+    }
+
+  };
+
+}
+
+
+extern GElib::GElibThreadPool* gelib_threadpool;
+
+
+namespace GElib{
+
+  // Drop-in replacement for cnine::MultiLoop in the Fn kernels. With
+  // WITH_OPENMP or WITH_TBB set in config.txt the loops run on that
+  // runtime instead of GElib's own pool, so a host application that
+  // already manages an OpenMP thread team or a TBB arena is not
+  // oversubscribed by a second set of library threads. Otherwise the
+  // loop runs on the session's persistent pool, falling back to
+  // cnine::MultiLoop before a GElibSession has been constructed.
+  inline void GElibMultiLoop(const int n, const std::function<void(const int)>& lambda, const int grain=0){
+#if defined(_WITH_OPENMP)
+    const int chunk=grain>0? grain : std::max(1,n/64);
+    #pragma omp parallel for schedule(dynamic,chunk)
+    for(int i=0; i<n; i++) lambda(i);
+#elif defined(_WITH_TBB)
+    tbb::parallel_for(tbb::blocked_range<int>(0,n,grain>0? grain : 1),
+      [&](const tbb::blocked_range<int>& r){
+	for(int i=r.begin(); i<r.end(); i++) lambda(i);
+      });
+#else
+    if(gelib_threadpool) gelib_threadpool->parallel_for(n,lambda,grain);
+    else cnine::MultiLoop(n,lambda);
+#endif
+  }
+
+  // Statically partitioned variant for NUMA-sensitive loops; see
+  // GElibThreadPool::parallel_for_static.
+  inline void GElibMultiLoopStatic(const int n, const std::function<void(const int)>& lambda){
+#if defined(_WITH_OPENMP)
+    #pragma omp parallel for schedule(static)
+    for(int i=0; i<n; i++) lambda(i);
+#elif defined(_WITH_TBB)
+    tbb::parallel_for(tbb::blocked_range<int>(0,n),
+      [&](const tbb::blocked_range<int>& r){
+	for(int i=r.begin(); i<r.end(); i++) lambda(i);
+      },tbb::static_partitioner());
+#else
+    if(gelib_threadpool) gelib_threadpool->parallel_for_static(n,lambda);
+    else cnine::MultiLoop(n,lambda);
+#endif
+  }
+
+  // Fixed-order pairwise tree reduction over n indexed partials:
+  // combine(a,b) must fold partial b into partial a, leaving the total
+  // in partial 0. Level s combines the pairs (2si,2si+s), so the
+  // combining schedule is a function of n alone -- not of thread count
+  // or completion order -- and each level is a barrier, which makes the
+  // result bitwise identical from run to run while the combines within
+  // a level still execute in parallel. This is what the deterministic
+  // mode (GElibConfig::deterministic) routes shared-output
+  // accumulations through.
+  inline void GElibTreeReduce(const int n, const std::function<void(const int, const int)>& combine){
+    for(int s=1; s<n; s*=2){
+      const int npairs=(n+2*s-1)/(2*s);
+      GElibMultiLoop(npairs,[&](const int i){
+	  const int a=2*s*i;
+	  const int b=a+s;
+	  if(b<n) combine(a,b);
+	});
+    }
+  }
+
+}
+
+#endif
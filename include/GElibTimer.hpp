@@ -12,15 +12,131 @@
 #define _GElibTimer
 
 #include "GElibLog.hpp"
+#include "GElibProfiler.hpp"
+#include "GElibRoofline.hpp"
 
 #include <fstream>
 #include <chrono>
 #include <ctime>
 
 extern GElib::GElibLog* gelib_log;
+extern GElib::GElibProfiler* gelib_profiler;
 
 namespace GElib{
 
+  // Deferred CUDA event timing. Wall-clock around an asynchronous launch
+  // measures launch overhead, not execution, so GPU figures taken that way
+  // are fiction. Instead a cudaEvent pair is recorded on the op's own
+  // stream and parked here; collect(), run from the gelib_log drainer
+  // thread via its idle_hook, harvests the pairs whose end event has
+  // completed and posts the true device-side elapsed times. The measured
+  // stream is never synchronized on behalf of telemetry.
+
+  class GElibCudaEventPool{
+  public:
+#ifdef _WITH_CUDA
+
+    struct pending{
+      cudaEvent_t beg;
+      cudaEvent_t end;
+      string task;
+      string csv_prefix;
+      int n_ops;
+      int l1=-1,l2=-1,l=-1; // shape tag for the roofline table
+      int b=0,n1=0,n2=0,dev=0;
+      string op; // op kind for telemetry subscribers
+    };
+
+  private:
+
+    mutex mx;
+    vector<pending> pendings;
+
+  public:
+
+    ~GElibCudaEventPool(){
+      collect(true);
+    }
+
+    void add(const pending& p){
+      lock_guard<mutex> lock(mx);
+      pendings.push_back(p);
+    }
+
+    void collect(const bool sync=false){
+      lock_guard<mutex> lock(mx);
+      for(int i=0; i<(int)pendings.size(); i++){
+	pending& p=pendings[i];
+	if(sync) cudaEventSynchronize(p.end);
+	else if(cudaEventQuery(p.end)!=cudaSuccess) continue;
+	float ms=0;
+	cudaEventElapsedTime(&ms,p.beg,p.end);
+	if(p.l1>=0)
+	  gelib_roofline.add(p.l1,p.l2,p.l,p.b,p.n1,p.n2,p.dev,ms,p.n_ops);
+	if(gelib_log){
+	  const int mflops=ms>0? (int)(((float)p.n_ops)/ms/1000.0) : 0;
+	  (*gelib_log)(p.task+" "+to_string(ms)+" ms"+" ["+to_string(mflops)+" Mflops]");
+	  if(p.csv_prefix.size()>0)
+	    gelib_log->csv(p.csv_prefix+to_string(ms)+","+to_string(mflops));
+	  if(p.op.size()>0)
+	    gelib_log->event(p.op,p.l1,p.l2,p.l,p.b,p.n1,p.n2,p.dev,p.n_ops,ms);
+	}
+	cudaEventDestroy(p.beg);
+	cudaEventDestroy(p.end);
+	pendings.erase(pendings.begin()+i);
+	i--;
+      }
+    }
+
+#endif
+  };
+
+}
+
+extern GElib::GElibCudaEventPool gelib_cuda_timings;
+
+
+namespace GElib{
+
+#ifdef _WITH_CUDA
+
+  // Scoped recorder for one asynchronous CG product: brackets the launches
+  // between a cudaEvent pair on the op's stream and parks the pair in
+  // gelib_cuda_timings for deferred collection.
+
+  class CGproductEventTimer{
+  public:
+
+    int l1,l2,l;
+    int b,n1,n2,dev;
+    int n_ops;
+    const cudaStream_t& stream;
+    cudaEvent_t beg;
+
+    CGproductEventTimer(const int _l1, const int _l2, const int _l, const int _b,
+      const int _n1, const int _n2, const int _dev, const int _ops, const cudaStream_t& _stream):
+      l1(_l1),l2(_l2),l(_l),b(_b),n1(_n1),n2(_n2),dev(_dev),n_ops(_ops),stream(_stream){
+      CUDA_SAFE(cudaEventCreate(&beg));
+      CUDA_SAFE(cudaEventRecord(beg,stream));
+    }
+
+    ~CGproductEventTimer(){
+      cudaEvent_t end;
+      CUDA_SAFE(cudaEventCreate(&end));
+      CUDA_SAFE(cudaEventRecord(end,stream));
+      gelib_cuda_timings.add(GElibCudaEventPool::pending({beg,end,
+	    "CGproduct("+to_string(l1)+","+to_string(l2)+","+to_string(l)+")[b="+
+	    to_string(b)+",n1="+to_string(n1)+",n2="+to_string(n2)+",dev="+to_string(dev)+"]",
+	    to_string(l1)+","+to_string(l2)+","+to_string(l)+","+to_string(b)+","+
+	    to_string(n1)+","+to_string(n2)+","+to_string(dev)+",",n_ops,
+	    l1,l2,l,b,n1,n2,dev,"CGproduct"}));
+    }
+
+  };
+
+#endif
+
+
   class LoggedTimer{
   public:
 
@@ -41,9 +157,13 @@ namespace GElib{
 
     ~LoggedTimer(){
       auto elapsed=chrono::duration<double,std::milli>(chrono::system_clock::now()-t0).count();
+      if(gelib_profiler)
+	gelib_profiler->record(GElibProfiler::event({task,gelib_profiler->now()-1000.0*elapsed,
+	      1000.0*elapsed,-1,-1,-1,-1,-1,-1}));
       if(gelib_log){
 	if(n_ops>0) (*gelib_log)(task+" "+to_string(elapsed)+" ms"+" ["+to_string((int)(((float)n_ops)/elapsed/1000.0))+" Mflops]");
 	else (*gelib_log)(task+" "+to_string(elapsed)+" ms");
+	gelib_log->event(task,-1,-1,-1,-1,-1,-1,-1,n_ops,elapsed);
       }
     }
 
@@ -78,16 +198,19 @@ namespace GElib{
 
     ~CGproductTimer(){
       auto elapsed=chrono::duration<double,std::milli>(chrono::system_clock::now()-t0).count();
+      gelib_roofline.add(l1,l2,l,b,n1,n2,dev,elapsed,n_ops);
+      if(gelib_profiler)
+	gelib_profiler->record(GElibProfiler::event({"CGproduct",gelib_profiler->now()-1000.0*elapsed,
+	      1000.0*elapsed,-1,l1,l2,l,b,dev}));
       if(gelib_log){
 	(*gelib_log)("CGproduct("+to_string(l1)+","+to_string(l2)+","+to_string(l)+")[b="+
 	  to_string(b)+",n1="+to_string(n1)+",n2="+to_string(n2)+",dev="+to_string(dev)+"] "+
 	  to_string(elapsed)+" ms"+" ["+to_string((int)(((float)n_ops)/elapsed/1000.0))+" Mflops]");
-	if(elapsed>0)
-	  gelib_log->ofs2<<l1<<","<<l2<<","<<l<<","<<b<<","<<n1<<","<<n2<<","<<dev<<","<<elapsed<<","<<
-	    (int)(((float)n_ops)/elapsed/1000.0)<<endl;
-	else
-	  gelib_log->ofs2<<l1<<","<<l2<<","<<l<<","<<b<<","<<n1<<","<<n2<<","<<dev<<","<<elapsed<<","<<0<<endl;
-	
+	const int mflops=elapsed>0? (int)(((float)n_ops)/elapsed/1000.0) : 0;
+	gelib_log->csv(to_string(l1)+","+to_string(l2)+","+to_string(l)+","+to_string(b)+","+
+	  to_string(n1)+","+to_string(n2)+","+to_string(dev)+","+to_string(elapsed)+","+to_string(mflops));
+	gelib_log->event("CGproduct",l1,l2,l,b,n1,n2,dev,n_ops,elapsed);
+
       }
     }
 
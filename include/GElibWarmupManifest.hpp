@@ -0,0 +1,136 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibWarmupManifest
+#define _GElibWarmupManifest
+
+#include <fstream>
+#include <sstream>
+
+#include "GElib_base.hpp"
+#include "SO3_CGbank.hpp"
+#include "SO3_SPHgen.hpp"
+#include "SO3FourierMatrixBank.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+extern GElib::SO3_SPHgen SO3_sphGen;
+extern GElib::SO3FourierMatrixBank SO3FourierMxBank;
+
+
+namespace GElib{
+
+  // A warm-up manifest is a list of the coefficient tables a run is
+  // going to need: CG indices for SO3_cgbank, the maximal spherical
+  // harmonic order for SO3_sphGen and (l,n) sizes for the Fourier and
+  // Wigner matrices in SO3FourierMxBank. Preloading it at session
+  // construction moves all lazy bank population to startup, so the
+  // first operation of the run already sees steady-state latency.
+  //
+  // A manifest can be written by hand or recorded from the banks at the
+  // end of a previous run. The file format is plain text, one entry per
+  // line: "cg l1 l2 l", "sph L", "fourier l n", "wigner l n"; lines
+  // starting with '#' are ignored.
+
+  class GElibWarmupManifest{
+  public:
+
+    vector<CGindex> cg;
+    int sphL=0;
+    vector<pair<int,int> > fourier;
+    vector<pair<int,int> > wigner;
+
+
+    GElibWarmupManifest(){}
+
+    GElibWarmupManifest(const string& filename){
+      load(filename);
+    }
+
+
+  public: // ---- Recording ----------------------------------------------------------------------------------
+
+
+    // Snapshots the tables currently held by the global banks.
+    static GElibWarmupManifest record(){
+      GElibWarmupManifest r;
+      r.cg=SO3_cgbank.loaded_indices();
+      r.sphL=SO3_sphGen.get_L();
+      r.fourier=SO3FourierMxBank.loaded_Findices();
+      r.wigner=SO3FourierMxBank.loaded_Dindices();
+      return r;
+    }
+
+
+  public: // ---- I/O ----------------------------------------------------------------------------------------
+
+
+    void load(const string& filename){
+      ifstream ifs(filename);
+      if(!ifs.good()) return;
+      string line;
+      while(std::getline(ifs,line)){
+	if(line.size()==0 || line[0]=='#') continue;
+	std::istringstream iss(line);
+	string key;
+	iss>>key;
+	if(key=="cg"){
+	  int l1,l2,l;
+	  if(iss>>l1>>l2>>l) cg.push_back(CGindex(l1,l2,l));
+	}
+	if(key=="sph"){
+	  int L;
+	  if(iss>>L) sphL=std::max(sphL,L);
+	}
+	if(key=="fourier"){
+	  int l,n;
+	  if(iss>>l>>n) fourier.push_back(pair<int,int>(l,n));
+	}
+	if(key=="wigner"){
+	  int l,n;
+	  if(iss>>l>>n) wigner.push_back(pair<int,int>(l,n));
+	}
+      }
+    }
+
+
+    void save(const string& filename) const{
+      ofstream ofs(filename);
+      if(!ofs.good()) return;
+      ofs<<"# GElib warm-up manifest"<<endl;
+      for(auto& ix:cg)
+	ofs<<"cg "<<ix.l1<<" "<<ix.l2<<" "<<ix.l<<endl;
+      if(sphL>0) ofs<<"sph "<<sphL<<endl;
+      for(auto& p:fourier)
+	ofs<<"fourier "<<p.first<<" "<<p.second<<endl;
+      for(auto& p:wigner)
+	ofs<<"wigner "<<p.first<<" "<<p.second<<endl;
+    }
+
+
+  public: // ---- Preloading ---------------------------------------------------------------------------------
+
+
+    void preload() const{
+      for(auto& ix:cg)
+	SO3_cgbank.getf(ix);
+      if(sphL>0) SO3_sphGen(sphL,0);
+      for(auto& p:fourier){
+	SO3FourierMxBank.Fmatrix(p.first,p.second);
+	SO3FourierMxBank.iFmatrix(p.first,p.second);
+      }
+      for(auto& p:wigner)
+	SO3FourierMxBank.Dmatrix(p.first,p.second);
+    }
+
+  };
+
+}
+
+#endif
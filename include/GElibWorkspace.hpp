@@ -0,0 +1,117 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElibWorkspace
+#define _GElibWorkspace
+
+#include <cstdlib>
+#include <cstring>
+
+#include "GElib_base.hpp"
+#include "GElibHugePages.hpp"
+#include "GElibManagedMemory.hpp"
+
+
+namespace GElib{
+
+  // Caller-owned workspace for kernel temporaries. Fn classes that
+  // need scratch storage expose a static workspace_size(shape...)
+  // returning the float count they require for a given shape and
+  // accept an optional GElibWorkspace*; when one is supplied the
+  // temporaries are carved out of it with take() instead of being
+  // allocated, so a steady-state loop that preallocates one workspace
+  // per shape keeps the allocator entirely off the op path. The
+  // workspace is a non-owning descriptor -- the buffer may live on the
+  // host or on a device (dev field) and must match the operands'
+  // device. take() is a bump allocation; the Fn resets the cursor on
+  // entry, so one workspace can be handed to the same Fn repeatedly
+  // but must not be shared by concurrently running ops.
+
+  class GElibWorkspace{
+  public:
+
+    float* arr=nullptr;
+    size_t capacity=0;   // in floats
+    size_t used=0;
+    int dev=0;
+
+    GElibWorkspace(){}
+
+    GElibWorkspace(float* _arr, const size_t _capacity, const int _dev=0):
+      arr(_arr), capacity(_capacity), dev(_dev){}
+
+
+  public: // ---- Access -------------------------------------------------------------------------------------
+
+
+    size_t remaining() const{
+      return capacity-used;
+    }
+
+    void reset(){
+      used=0;
+    }
+
+    float* take(const size_t nfloats){
+      GELIB_ASSRT(used+nfloats<=capacity);
+      float* p=arr+used;
+      used+=nfloats;
+      return p;
+    }
+
+    // take() followed by a zero fill, for temporaries that are
+    // accumulated into.
+    float* take_zeroed(const size_t nfloats){
+      float* p=take(nfloats);
+      if(dev==0) std::memset(p,0,nfloats*sizeof(float));
+#ifdef _WITH_CUDA
+      else CUDA_SAFE(cudaMemset(p,0,nfloats*sizeof(float)));
+#endif
+      return p;
+    }
+
+  };
+
+
+  // Owning convenience: allocates the buffer on construction (host or
+  // device) and frees it on destruction; use the base-class interface
+  // to pass it to ops.
+
+  class GElibOwnedWorkspace: public GElibWorkspace{
+  public:
+
+    GElibOwnedWorkspace(const size_t _capacity, const int _dev=0){
+      capacity=_capacity;
+      dev=_dev;
+      if(dev==0) arr=(float*)gelib_huge_pages.alloc(_capacity*sizeof(float));
+#ifdef _WITH_CUDA
+      else if(gelib_config && gelib_config->managed_memory)
+	CUDA_SAFE(cudaMallocManaged(&arr,_capacity*sizeof(float)));
+      else CUDA_SAFE(cudaMalloc(&arr,_capacity*sizeof(float)));
+#else
+      else GELIB_ASSRT(dev==0);
+#endif
+    }
+
+    ~GElibOwnedWorkspace(){
+      if(dev==0) gelib_huge_pages.free(arr);
+#ifdef _WITH_CUDA
+      else cudaFree(arr);
+#endif
+    }
+
+    GElibOwnedWorkspace(const GElibOwnedWorkspace& x)=delete;
+    GElibOwnedWorkspace& operator=(const GElibOwnedWorkspace& x)=delete;
+
+  };
+
+}
+
+#endif
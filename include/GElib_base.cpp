@@ -17,12 +17,29 @@
 #endif 
 
 #include "SO3_CGbank.hpp"
+#include "SO3CGkernelDispatcher.hpp"
 #include "SO3_SPHgen.hpp"
+#include "SO3_SphCoeffs.hpp"
 #include "SO2FourierMatrixBank.hpp"
 #include "SO3FourierMatrixBank.hpp"
+#include "SO3FFTPlan.hpp"
+#include "SO3CGproductPlan.hpp"
+#include "SO3CGjitKernelBank.hpp"
+#include "SO3FproductTuner.hpp"
+#include "WignerBank.hpp"
 #include "Factorial.hpp"
 #include "GElibConfig.hpp"
 #include "GElibLog.hpp"
+#include "GElibTimer.hpp"
+#include "GElibProfiler.hpp"
+#include "GElibOpStats.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibExecutor.hpp"
+#include "GElibCudaGraphs.hpp"
+#include "GElibCudaArena.hpp"
+#include "GElibCudaStagingPool.hpp"
+#include "GElibMemoryMonitor.hpp"
+#include "GElibGradArena.hpp"
 //#include "SO3CGprogramBank.hpp"
 
 
@@ -38,10 +55,31 @@ vector<int> GElib::factorial::fact;
 
 GElib::GElibConfig* gelib_config=nullptr;
 GElib::GElibLog* gelib_log=nullptr;
+GElib::GElibProfiler* gelib_profiler=nullptr;
+GElib::GElibThreadPool* gelib_threadpool=nullptr;
+GElib::GElibExecutor* gelib_executor=nullptr;
+GElib::GElibGradArena* gelib_grad_arena=nullptr;
+GElib::GElibCudaGraphCache gelib_cuda_graphs;
+GElib::GElibCudaStreamPool gelib_cuda_streams;
+GElib::GElibCudaArena gelib_cuda_arena;
+GElib::GElibCudaStagingPool gelib_cuda_staging;
+GElib::GElibRoofline gelib_roofline;
+GElib::GElibCudaEventPool gelib_cuda_timings;
+GElib::GElibOpStats gelib_op_stats;
+GElib::GElibMemoryMonitor gelib_memory;
 GElib::SO3_CGbank SO3_cgbank;
+#if defined(_WITH_CUDA) && defined(_WITH_NVRTC)
+GElib::SO3CGjitKernelBank SO3CGjit_bank;
+#endif
+GElib::SO3CGkernelDispatcher SO3_CGdispatcher;
 GElib::SO3_SPHgen SO3_sphGen;
+GElib::SO3_SphCoeffs SO3_sphCoeffs;
 GElib::SO2FourierMatrixBank SO2FmatrixBank;
 GElib::SO3FourierMatrixBank SO3FourierMxBank;
+GElib::SO3FFTplanBank SO3FFTplans;
+GElib::SO3CGplanBank SO3CGplans;
+GElib::SO3FproductTuner SO3Fproduct_tuner;
+GElib::WignerBank SO3_wignerBank;
 
 //GElib::SO3CGprogramBank SO3_CGprogram_bank;
 
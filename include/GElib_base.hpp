@@ -12,6 +12,10 @@
 #ifndef _GElib_base
 #define _GElib_base
 
+// Must precede Cnine_base.hpp so the CUDA->HIP name mapping covers the
+// cnine headers as well; a no-op outside WITH_HIP builds.
+#include "GElibHip.hpp"
+
 #include "Cnine_base.hpp"
 
 using namespace std; 
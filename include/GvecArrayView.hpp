@@ -12,6 +12,7 @@
 #define _GElibGvecArrayView
 
 #include "GElib_base.hpp"
+#include "GElibThreadPool.hpp"
 
 
 namespace GElib{
@@ -146,6 +147,45 @@ namespace GElib{
     }
 
 
+  public: // ---- Layout adapters ----------------------------------------------------------------------------
+
+
+    // Zero-copy layout adapters applied uniformly to every part: each
+    // returns a new view over the same buffers with transformed cell
+    // grid dims/strides (see the part-array level methods), so layout
+    // adaptation between pipeline stages -- merging cell dims,
+    // reordering them, or splitting channels into heads -- never
+    // repacks the data.
+
+    GvecArrayView reshape_adims(const Gdims& adims) const{
+      GvecArrayView R;
+      for(auto& p:parts)
+	R.parts[p.first]=new PAview(p.second->reshape_adims(adims));
+      return R;
+    }
+
+    GvecArrayView fuse_cells() const{
+      GvecArrayView R;
+      for(auto& p:parts)
+	R.parts[p.first]=new PAview(p.second->fuse_cells());
+      return R;
+    }
+
+    GvecArrayView permute_adims(const vector<int>& pi) const{
+      GvecArrayView R;
+      for(auto& p:parts)
+	R.parts[p.first]=new PAview(p.second->permute_adims(pi));
+      return R;
+    }
+
+    GvecArrayView split_channels(const int h) const{
+      GvecArrayView R;
+      for(auto& p:parts)
+	R.parts[p.first]=new PAview(p.second->split_channels(h));
+      return R;
+    }
+
+
   public: // ---- Lambdas ------------------------------------------------------------------------------------
 
 
@@ -166,6 +206,42 @@ namespace GElib{
     }
 
 
+  public: // ---- Map-reduce ---------------------------------------------------------------------------------
+
+
+    // Fused map-reduce over the cell grid: mapfn is evaluated on every
+    // cell in one parallel pass and the results are folded with
+    // combine, which must be associative. Composite statistics that
+    // would otherwise need several full traversals orchestrated from
+    // user code -- per-cell norms feeding a gate, picking the max-norm
+    // cell -- become a single pass over the array storage. The fold
+    // runs as a pairwise tree (GElibTreeReduce), so the result does not
+    // depend on how the map pass was scheduled across workers.
+
+    template<typename T>
+    T map_reduce(const std::function<T(const Gindex&, const Vview&)>& mapfn,
+      const std::function<T(const T&, const T&)>& combine) const{
+      const Gdims adims=get_adims();
+      const int N=adims.total();
+      GELIB_ASSRT(N>0);
+      vector<T> vals(N);
+      GElibMultiLoop(N,[&](const int i){
+	  Gindex ix(i,adims);
+	  vals[i]=mapfn(ix,cell(ix));
+	});
+      GElibTreeReduce(N,[&](const int a, const int b){
+	  vals[a]=combine(vals[a],vals[b]);
+	});
+      return vals[0];
+    }
+
+    template<typename T>
+    T map_reduce(const std::function<T(const Vview&)>& mapfn,
+      const std::function<T(const T&, const T&)>& combine) const{
+      return map_reduce<T>([&](const Gindex& ix, const Vview& v){return mapfn(v);},combine);
+    }
+
+
   public: // ---- Cumulative operations ----------------------------------------------------------------------
 
 
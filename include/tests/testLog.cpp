@@ -9,7 +9,14 @@ using namespace GElib;
 
 int main(int argc, char** argv){
   GElibSession session(4);
-  GElibLog gelib_log;
+
+  // Subscribe to the session's logger: each timed op below should also
+  // arrive here as a structured TelemetryEvent.
+  std::atomic<int> nevents(0);
+  int sub=gelib_log->subscribe([&](const GElibLog::TelemetryEvent& e){
+      nevents++;
+      cout<<"event: "<<e.op<<" "<<e.ms<<" ms (dev="<<e.dev<<")"<<endl;
+    });
 
   {
     LoggedTimer timer("Input from user");
@@ -18,4 +25,5 @@ int main(int argc, char** argv){
   }
   LoggedTimer t;
 
+  gelib_log->unsubscribe(sub);
 }
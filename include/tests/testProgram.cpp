@@ -0,0 +1,88 @@
+#include "GElib_base.cpp"
+#include "SO3partB.hpp"
+#include "GElibSession.hpp"
+#include "GElibProgram.hpp"
+
+using namespace cnine;
+using namespace GElib;
+
+
+// Liveness packing of the GElibProgram arena. The plan hands a freed
+// temporary's interval to the next buffer that fits (first fit,
+// adjacent holes merged), so the footprint must be the packed peak, not
+// the sum of all temporaries -- and reused storage must not corrupt the
+// computed results.
+
+int main(int argc, char** argv){
+  GElibSession session;
+  cout<<endl;
+
+  bool failed=false;
+
+  // Three chained temporaries of equal size: t0 dies before t2 is
+  // allocated, so t2 reuses its slot and only two temp slots are paid
+  // for.
+  {
+    const size_t n=64;
+    GElibProgram prog;
+    int x=prog.add_input(n);
+    int t0=prog.add_temp(n);
+    int t1=prog.add_temp(n);
+    int t2=prog.add_temp(n);
+    int y=prog.add_output(n);
+
+    auto shift=[n](float* dst, const float* src){
+      for(size_t i=0; i<n; i++) dst[i]=src[i]+1;};
+
+    prog.add_op([=](const GElibProgram::resolver& buf){shift(buf(t0),buf(x));},{x},{t0});
+    prog.add_op([=](const GElibProgram::resolver& buf){shift(buf(t1),buf(t0));},{t0},{t1});
+    prog.add_op([=](const GElibProgram::resolver& buf){shift(buf(t2),buf(t1));},{t1},{t2});
+    prog.add_op([=](const GElibProgram::resolver& buf){shift(buf(y),buf(t2));},{t2},{y});
+    prog.compile();
+
+    cout<<"chain footprint="<<prog.footprint()<<" (expect "<<4*n<<")"<<endl;
+    if(prog.footprint()!=4*n) failed=true;
+
+    vector<float> in(n), out(n,0);
+    for(size_t i=0; i<n; i++) in[i]=i;
+    prog.execute({in.data()},{out.data()});
+    for(size_t i=0; i<n; i++)
+      if(out[i]!=in[i]+4) failed=true;
+  }
+
+  // Hole merging: two adjacent temporaries die together and a larger
+  // one arrives; it must fit in the merged hole, so the arena does not
+  // grow beyond the packed peak.
+  {
+    const size_t n=32;
+    GElibProgram prog;
+    int x=prog.add_input(n);
+    int a=prog.add_temp(n);
+    int b=prog.add_temp(n);
+    int s=prog.add_temp(n/2);
+    int c=prog.add_temp(2*n);
+    int y=prog.add_output(n);
+
+    auto copy=[](float* dst, const float* src, const size_t m){
+      for(size_t i=0; i<m; i++) dst[i]=src[i];};
+
+    prog.add_op([=](const GElibProgram::resolver& buf){copy(buf(a),buf(x),n);},{x},{a});
+    prog.add_op([=](const GElibProgram::resolver& buf){copy(buf(b),buf(x),n);},{x},{b});
+    prog.add_op([=](const GElibProgram::resolver& buf){copy(buf(s),buf(a),n/2); copy(buf(s),buf(b),n/2);},{a,b},{s});
+    prog.add_op([=](const GElibProgram::resolver& buf){copy(buf(c),buf(s),n/2);},{s},{c});
+    prog.add_op([=](const GElibProgram::resolver& buf){copy(buf(y),buf(c),n);},{c},{y});
+    prog.compile();
+
+    // input + output + merged a/b hole serving c + s
+    const size_t expect=n+n+2*n+n/2;
+    cout<<"merge footprint="<<prog.footprint()<<" (expect "<<expect<<")"<<endl;
+    if(prog.footprint()!=expect) failed=true;
+  }
+  cout<<endl;
+
+  if(failed){
+    cout<<"FAILED"<<endl;
+    return 1;
+  }
+  cout<<endl;
+}
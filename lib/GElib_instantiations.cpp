@@ -0,0 +1,50 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+// Translation unit of the optional precompiled library (lib/Makefile,
+// WITH_LIBGELIB in config.txt). It holds explicit instantiations of
+// the templated class surface for the standard scalar types, so that
+// consumer translation units compiled with _GELIB_EXTERN_TEMPLATES
+// (see GElibExterns.hpp) only parse declarations instead of each
+// re-instantiating the same bodies. The globals of GElib_base.cpp are
+// deliberately not compiled here: consumers keep including that file
+// in one translation unit exactly as in a header-only build, so the
+// library can be dropped in and out without other changes.
+
+#include "GElib_base.hpp"
+#include "SO3_CGcoeffs.hpp"
+#include "SO3partC.hpp"
+#include "SO3vecC.hpp"
+#include "SO3partArrayC.hpp"
+#include "SO3vecArrayC.hpp"
+#include "SO3bipart.hpp"
+#include "SO3bivec.hpp"
+
+namespace GElib{
+
+  template class SO3_CGcoeffs<float>;
+  template class SO3_CGcoeffs<double>;
+
+  template class SO3partView<float>;
+  template class SO3part<float>;
+  template class SO3vecView<float>;
+  template class SO3vec<float>;
+
+  template class SO3partArrayView<float>;
+  template class SO3partArray<float>;
+  template class SO3vecArrayView<float>;
+  template class SO3vecArray<float>;
+
+  template class SO3bipartView<float>;
+  template class SO3bipart<float>;
+  template class SO3bivecView<float>;
+  template class SO3bivec<float>;
+
+}
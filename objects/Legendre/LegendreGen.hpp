@@ -0,0 +1,215 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _LegendreGen
+#define _LegendreGen
+
+#include <atomic>
+
+#include "Gtensor.hpp"
+#include "GElibConfig.hpp"
+
+
+namespace GElib{
+
+  #ifdef _WITH_CUDA
+  void Legendre_batched_cu(const int L, const int N, const float* x, float* R, const cudaStream_t& stream);
+  #endif
+
+
+  // Generator for the Legendre polynomials P_0..P_L via the three-term
+  // recurrence l*P_l(x)=(2l-1)*x*P_{l-1}(x)-(l-1)*P_{l-2}(x). The
+  // recurrence coefficients are cached in immutable snapshots published
+  // with a release store, the same design as SO3_SPHgen: the read path
+  // is a single acquire load with no lock and a snapshot a reader holds
+  // is never mutated or freed under it, so concurrent featurizer
+  // threads never serialize on the generator.
+
+  class LegendreGen{
+  public:
+
+    class snapshot{
+    public:
+      int L;
+      vector<float> c1;    // c1[l]=(2l-1)/l
+      vector<float> c2;    // c2[l]=-(l-1)/l
+
+      snapshot(const int _L): L(_L), c1(_L+1,0), c2(_L+1,0){
+	for(int l=1; l<=_L; l++){
+	  c1[l]=((float)(2*l-1))/l;
+	  c2[l]=-((float)(l-1))/l;
+	}
+      }
+    };
+
+
+  private:
+
+    std::atomic<snapshot*> current;
+    mutex mx; // serializes extend() only
+    vector<snapshot*> retired;
+
+
+  public:
+
+    LegendreGen(){
+      current.store(new snapshot(0));
+    }
+
+    LegendreGen(const LegendreGen& x)=delete;
+    LegendreGen& operator=(const LegendreGen& x)=delete;
+
+    ~LegendreGen(){
+      delete current.load();
+      for(auto p:retired) delete p;
+    }
+
+
+  public: // ---- Access -------------------------------------------------------------------------------------
+
+
+    int get_L() const{
+      return current.load(std::memory_order_acquire)->L;
+    }
+
+    // Returns a snapshot covering at least _L, extending the tables if
+    // necessary. Wait-free once the tables cover _L.
+    snapshot& ensure(const int _L){
+      snapshot* s=current.load(std::memory_order_acquire);
+      if(s->L>=_L) return *s;
+      return extend(_L);
+    }
+
+
+  public: // ---- Evaluation ---------------------------------------------------------------------------------
+
+
+    cnine::Gtensor<float> operator()(const int _L, const float x){
+      snapshot& S=ensure(_L);
+      cnine::Gtensor<float> R({_L+1},cnine::fill::raw);
+      R(0)=1;
+      if(_L>=1) R(1)=x;
+      for(int l=2; l<=_L; l++)
+	R(l)=S.c1[l]*x*R(l-1)+S.c2[l]*R(l-2);
+      return R;
+    }
+
+
+    // Batched evaluation: computes P_0..P_L for N arguments at once,
+    // writing into caller-provided storage R of size (_L+1)*N laid out
+    // as R[l*N+n], i.e. with the point index innermost so each step of
+    // the recurrence is a contiguous fused multiply-add sweep that
+    // vectorizes. No allocation or locking per call.
+    void operator()(const int _L, const int N, const float* x, float* R){
+      snapshot& S=ensure(_L);
+
+      for(int n=0; n<N; n++)
+	R[n]=1;
+      if(_L>=1)
+	for(int n=0; n<N; n++)
+	  R[N+n]=x[n];
+
+      for(int l=2; l<=_L; l++){
+	const float a=S.c1[l];
+	const float b=S.c2[l];
+	const float* R1=R+(l-1)*N;
+	const float* R2=R+(l-2)*N;
+	float* Rt=R+l*N;
+	for(int n=0; n<N; n++)
+	  Rt[n]=a*x[n]*R1[n]+b*R2[n];
+      }
+    }
+
+
+    #ifdef _WITH_CUDA
+    // Device-side batched evaluation into R[l*N+n] on the GPU; one
+    // thread carries the recurrence for one argument in registers.
+    void operator()(const int _L, const int N, const float* x, float* R, const cudaStream_t& stream){
+      Legendre_batched_cu(_L,N,x,R,stream);
+    }
+    #endif
+
+
+  private:
+
+    snapshot& extend(const int _L){
+      lock_guard<mutex> lock(mx);
+      snapshot* old=current.load(std::memory_order_relaxed);
+      if(old->L>=_L) return *old; // another writer got there first
+      snapshot* S=new snapshot(_L);
+      retired.push_back(old);
+      current.store(S,std::memory_order_release);
+      return *S;
+    }
+
+  };
+
+
+  // ---- Fixed-order evaluation -----------------------------------------------------------------------------
+
+
+  // Compile-time specializations for models whose Legendre order is
+  // fixed: the recurrence is fully unrolled with the coefficients folded
+  // into the instruction stream, so the inner loop over points carries
+  // no table loads. Legendre_fixed<L>::apply writes the same R[l*N+n]
+  // layout as the batched generator above.
+
+  template<int L>
+  struct Legendre_fixed{
+
+    static void apply(const int N, const float* x, float* R){
+      for(int n=0; n<N; n++)
+	R[n]=1;
+      if constexpr(L>=1)
+	for(int n=0; n<N; n++)
+	  R[N+n]=x[n];
+      lloop<2>(N,x,R);
+    }
+
+  private:
+
+    template<int l>
+    static void lloop(const int N, const float* x, float* R){
+      if constexpr(l<=L){
+	constexpr float a=((float)(2*l-1))/l;
+	constexpr float b=-((float)(l-1))/l;
+	const float* R1=R+(l-1)*N;
+	const float* R2=R+(l-2)*N;
+	float* Rt=R+l*N;
+	for(int n=0; n<N; n++)
+	  Rt[n]=a*x[n]*R1[n]+b*R2[n];
+	lloop<l+1>(N,x,R);
+      }
+    }
+
+  };
+
+
+  // Routes a runtime order to the fixed specializations up to
+  // GELIB_SMALL_L_MAX, in the manner of dispatch_small_l; returns false
+  // for larger orders, which stay on the generator's generic path.
+  namespace{
+    template<int A>
+    inline bool Legendre_fixed_dispatch(const int _L, const int N, const float* x, float* R){
+      if(_L==A){Legendre_fixed<A>::apply(N,x,R); return true;}
+      if constexpr(A>0)
+	return Legendre_fixed_dispatch<A-1>(_L,N,x,R);
+      return false;
+    }
+  }
+
+  inline bool Legendre_eval_fixed(const int _L, const int N, const float* x, float* R){
+    if(_L<0 || _L>GELIB_SMALL_L_MAX) return false;
+    return Legendre_fixed_dispatch<GELIB_SMALL_L_MAX>(_L,N,x,R);
+  }
+
+}
+
+#endif
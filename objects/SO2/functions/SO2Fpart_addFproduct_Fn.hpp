@@ -0,0 +1,152 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO2Fpart_addFproduct_Fn
+#define _SO2Fpart_addFproduct_Fn
+
+#include "GElib_base.hpp"
+#include "CtensorB.hpp"
+#include "Ctensor3_view.hpp"
+#include "GElibThreadPool.hpp"
+#include "SO3part_addCGproduct_simd.hpp"
+
+
+namespace GElib{
+
+  #ifdef _WITH_CUDA
+  void SO2Fpart_addFproduct_cu(const cnine::Ctensor3_view& r, const cnine::Ctensor3_view& x,
+    const cnine::Ctensor3_view& y, const int conj, const cudaStream_t& stream);
+  #endif
+
+
+  // Elementwise complex multiply-accumulate over a channel vector:
+  // r[c]+=x[c]*y[c] on separate real/imaginary planes. This is the
+  // inner kernel of the SO2 Fourier product, where unlike in the SO3 CG
+  // product both factors vary along the channel axis, so the broadcast
+  // kernels of SO3part_addCGproduct_simd do not apply.
+
+#if defined(__x86_64__) && defined(__AVX2__)
+
+  inline void SO2_cvmadd_planar_avx2(float* rr, float* ri, const float* xr, const float* xi,
+    const float* yr, const float* yi, const int n, const float ysign){
+    const __m256 vs=_mm256_set1_ps(ysign);
+    int i=0;
+    for(; i+8<=n; i+=8){
+      __m256 vxr=_mm256_loadu_ps(xr+i);
+      __m256 vxi=_mm256_loadu_ps(xi+i);
+      __m256 vyr=_mm256_loadu_ps(yr+i);
+      __m256 vyi=_mm256_mul_ps(vs,_mm256_loadu_ps(yi+i));
+      __m256 tr=_mm256_fmsub_ps(vxr,vyr,_mm256_mul_ps(vxi,vyi));
+      __m256 ti=_mm256_fmadd_ps(vxr,vyi,_mm256_mul_ps(vxi,vyr));
+      _mm256_storeu_ps(rr+i,_mm256_add_ps(_mm256_loadu_ps(rr+i),tr));
+      _mm256_storeu_ps(ri+i,_mm256_add_ps(_mm256_loadu_ps(ri+i),ti));
+    }
+    for(; i<n; i++){
+      const float byi=ysign*yi[i];
+      rr[i]+=xr[i]*yr[i]-xi[i]*byi;
+      ri[i]+=xr[i]*byi+xi[i]*yr[i];
+    }
+  }
+
+#endif
+
+  inline void SO2_cvmadd_planar(float* rr, float* ri, const float* xr, const float* xi,
+    const float* yr, const float* yi, const int n, const float ysign=1.0){
+#if defined(__x86_64__) && defined(__AVX2__)
+    if(SO3part_simd_level()>=1){SO2_cvmadd_planar_avx2(rr,ri,xr,xi,yr,yi,n,ysign); return;}
+#endif
+    for(int i=0; i<n; i++){
+      const float byi=ysign*yi[i];
+      rr[i]+=xr[i]*yr[i]-xi[i]*byi;
+      ri[i]+=xr[i]*byi+xi[i]*yr[i];
+    }
+  }
+
+
+  // Pointwise product of functions on the circle in Fourier space:
+  // mode-wise convolution r(b,k,c)+=x(b,k1,c)*y(b,k2,c) over k1+k2=k,
+  // keeping the M=r.n1 modes of the SO2_addFFTFn convention (modes
+  // 0..M-1). With conj set, the second factor is conjugated and the
+  // mode constraint becomes k1-k2=k, which is the correlation product.
+  // Channels vectorize: on the CPU the planar fast path runs the AVX2
+  // channel kernel above inside a batch-parallel GElibMultiLoop, and on
+  // the GPU one thread accumulates one (b,k,c) output over the diagonal
+  // of contributing mode pairs.
+  class SO2Fpart_addFproduct_Fn{
+  public:
+
+    int conj=0;
+
+    SO2Fpart_addFproduct_Fn(){}
+    SO2Fpart_addFproduct_Fn(const int _conj): conj(_conj){}
+
+  public:
+
+    void operator()(const cnine::Ctensor3_view& _r, const cnine::Ctensor3_view& _x, const cnine::Ctensor3_view& _y){
+
+      const int B=_r.n0;
+      const int M=_r.n1;
+      const int Nx=_x.n1;
+      const int Ny=_y.n1;
+      const int nc=_r.n2;
+      const int dev=_r.dev;
+
+      CNINE_CHECK_DEV3(_r,_x,_y)
+      CNINE_CHECK_BATCH3(_r,_x,_y)
+      CNINE_ASSRT(_x.n2==nc);
+      CNINE_ASSRT(_y.n2==nc);
+
+      if(dev>0){
+	#ifdef _WITH_CUDA
+	CUDA_STREAM(SO2Fpart_addFproduct_cu(_r,_x,_y,conj,stream));
+	#endif
+	return;
+      }
+
+      const bool planar=(_r.s2==1 && _x.s2==1 && _y.s2==1);
+
+      GElibMultiLoop(B,[&](const int b){
+
+	  if(planar){
+	    for(int k1=0; k1<Nx; k1++){
+	      const float* xr=_x.arr+b*_x.s0+k1*_x.s1;
+	      const float* xi=_x.arrc+b*_x.s0+k1*_x.s1;
+	      if(conj==0){
+		for(int k2=0; k2<std::min(Ny,M-k1); k2++)
+		  SO2_cvmadd_planar(_r.arr+b*_r.s0+(k1+k2)*_r.s1,_r.arrc+b*_r.s0+(k1+k2)*_r.s1,
+		    xr,xi,_y.arr+b*_y.s0+k2*_y.s1,_y.arrc+b*_y.s0+k2*_y.s1,nc);
+	      }else{
+		for(int k2=std::max(0,k1-M+1); k2<std::min(Ny,k1+1); k2++)
+		  SO2_cvmadd_planar(_r.arr+b*_r.s0+(k1-k2)*_r.s1,_r.arrc+b*_r.s0+(k1-k2)*_r.s1,
+		    xr,xi,_y.arr+b*_y.s0+k2*_y.s1,_y.arrc+b*_y.s0+k2*_y.s1,nc,-1.0);
+	      }
+	    }
+	    return;
+	  }
+
+	  for(int k1=0; k1<Nx; k1++){
+	    if(conj==0){
+	      for(int k2=0; k2<std::min(Ny,M-k1); k2++)
+		for(int c=0; c<nc; c++)
+		  _r.inc(b,k1+k2,c,_x(b,k1,c)*_y(b,k2,c));
+	    }else{
+	      for(int k2=std::max(0,k1-M+1); k2<std::min(Ny,k1+1); k2++)
+		for(int c=0; c<nc; c++)
+		  _r.inc(b,k1-k2,c,_x(b,k1,c)*std::conj(_y(b,k2,c)));
+	    }
+	  }
+	});
+    }
+
+  };
+
+}
+
+#endif
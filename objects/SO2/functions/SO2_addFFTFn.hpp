@@ -1,6 +1,6 @@
 // This file is part of GElib, a C++/CUDA library for group
-// equivariant tensor operations. 
-// 
+// equivariant tensor operations.
+//
 // Copyright (c) 2022, Imre Risi Kondor
 //
 // This Source Code Form is subject to the terms of the Mozilla
@@ -11,25 +11,188 @@
 #ifndef _SO2_addFFTFn
 #define _SO2_addFFTFn
 
+#include <map>
+#include <mutex>
+
 #include "GElib_base.hpp"
 #include "CtensorB.hpp"
 #include "MultiLoop.hpp"
+#include "GElibLog.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibScratchArena.hpp"
+#include "SO2FourierMatrixBank.hpp"
+
+#ifdef _WITH_FFTW
+#include <fftw3.h>
+#endif
+
+#if defined(_WITH_CUDA) && defined(_WITH_CUFFT)
+#include <cufft.h>
+#include "GElibCudaArena.hpp"
+#endif
 
 extern GElib::SO2FourierMatrixBank SO2FmatrixBank;
+extern GElib::GElibLog* gelib_log;
 
 
 namespace GElib{
 
+  // Circle Fourier transform: accumulates into r(b,k,c) the sum over
+  // the N azimuthal sample points j of x(b,j,c)*exp(2*pi*i*k*j/N),
+  // i.e. a dense product against the SO2FmatrixBank matrix, keeping
+  // the first M=r.n1 modes. The dense product is O(N^2) per column; at
+  // the azimuthal resolutions our models run (512+ points) this is a
+  // visible hotspot, so when the build enables them (WITH_FFTW /
+  // WITH_CUFFT in config.txt) the transform is instead computed by
+  // FFTW on the host or cuFFT on the device in O(N log N), through
+  // cached plans. All three paths use the same unnormalized +i sign
+  // convention as the bank matrices.
+
   class SO2_addFFTFn{
   public:
 
     void operator()(const cnine::Ctensor3_view& _r, const cnine::Ctensor3_view& _x){
 
+      const int b=_x.n0;
+      const int N=_x.n1;    // sample points on the circle
+      const int M=_r.n1;    // Fourier modes retained
+      const int nc=_x.n2;
+
+      CNINE_ASSRT(_r.n0==b);
+      CNINE_ASSRT(_r.n2==nc);
+      CNINE_ASSRT(M<=N);
+      CNINE_ASSRT(_r.dev==_x.dev);
+
+#if defined(_WITH_CUDA) && defined(_WITH_CUFFT)
+      if(_r.dev>0){
+	cufft(_r,_x,b,N,M,nc);
+	return;
+      }
+#endif
+      if(_r.dev>0){
+	gelib_log->error(__PRETTY_FUNCTION__,"GPU SO2 FFT requires a WITH_CUFFT build. Skipping this operation.");
+	return;
+      }
+
+#ifdef _WITH_FFTW
+      fftw(_r,_x,b,N,M,nc);
+      return;
+#endif
+
+      // Dense fallback: straight product against the bank matrix.
+      auto& F=SO2FmatrixBank.get(N,N);
+      const cnine::Ctensor2_view Fv=F.view2();
+      GElibMultiLoop(b,[&](const int ib){
+	  for(int k=0; k<M; k++)
+	    for(int j=0; j<N; j++){
+	      const complex<float> w=Fv(k,j);
+	      for(int c=0; c<nc; c++)
+		_r.inc(ib,k,c,w*_x(ib,j,c));
+	    }
+	});
+    }
+
+
+  private: // ---- FFTW backend ------------------------------------------------------------------------------
+
+
+#ifdef _WITH_FFTW
+
+    // One guru split-format plan per (N,nc,b,strides) signature. The
+    // split interface operates directly on cnine's separate real and
+    // imaginary planes, so no interleaving pass is needed; the +i sign
+    // is obtained by handing the planes in swapped order. Output goes
+    // to contiguous scratch, from which the first M modes are
+    // accumulated into r.
+    void fftw(const cnine::Ctensor3_view& _r, const cnine::Ctensor3_view& _x,
+      const int b, const int N, const int M, const int nc){
+
+      GElibScratchArena::scope scratch_scope;
+      float* out_re=(float*)gelib_scratch.alloc(((size_t)b)*N*nc*sizeof(float));
+      float* out_im=(float*)gelib_scratch.alloc(((size_t)b)*N*nc*sizeof(float));
+
+      fftwf_plan plan;
+      {
+	static std::mutex mx;
+	static std::map<array<int,6>,fftwf_plan> plans;
+	std::lock_guard<std::mutex> lock(mx);
+	array<int,6> ix({N,nc,b,_x.s0,_x.s1,_x.s2});
+	auto it=plans.find(ix);
+	if(it!=plans.end()) plan=it->second;
+	else{
+	  fftwf_iodim dims[1];
+	  dims[0].n=N; dims[0].is=_x.s1; dims[0].os=nc;
+	  fftwf_iodim loop[2];
+	  loop[0].n=b; loop[0].is=_x.s0; loop[0].os=N*nc;
+	  loop[1].n=nc; loop[1].is=_x.s2; loop[1].os=1;
+	  // Swapped re/im pairs give the unnormalized +i (backward) sign.
+	  plan=fftwf_plan_guru_split_dft(1,dims,2,loop,
+	    _x.arrc,_x.arr,out_im,out_re,FFTW_ESTIMATE);
+	  plans[ix]=plan;
+	}
+      }
+      fftwf_execute_split_dft(plan,_x.arrc,_x.arr,out_im,out_re);
+
+      GElibMultiLoop(b,[&](const int ib){
+	  for(int k=0; k<M; k++)
+	    for(int c=0; c<nc; c++)
+	      _r.inc(ib,k,c,complex<float>(out_re[(ib*N+k)*nc+c],out_im[(ib*N+k)*nc+c]));
+	});
+    }
+
+#endif
+
+
+  private: // ---- cuFFT backend -----------------------------------------------------------------------------
+
+
+#if defined(_WITH_CUDA) && defined(_WITH_CUFFT)
+
+    // cuFFT only accepts interleaved complex data, so the planar input
+    // is packed into an interleaved scratch buffer from the arena, the
+    // batched transform runs in place, and the first M modes are
+    // accumulated into r through an interleaved view of the result.
+    void cufft(const cnine::Ctensor3_view& _r, const cnine::Ctensor3_view& _x,
+      const int b, const int N, const int M, const int nc){
+
+      CNINE_ASSRT(_x.is_regular());
+
+      float* scratch=(float*)gelib_cuda_arena.alloc(2*((size_t)b)*N*nc*sizeof(float));
+      const size_t ncols=((size_t)b)*N*nc;
+      CUDA_SAFE(cudaMemcpy2D(scratch,2*sizeof(float),_x.arr,sizeof(float),
+	  sizeof(float),ncols,cudaMemcpyDeviceToDevice));
+      CUDA_SAFE(cudaMemcpy2D(scratch+1,2*sizeof(float),_x.arrc,sizeof(float),
+	  sizeof(float),ncols,cudaMemcpyDeviceToDevice));
+
+      cufftHandle plan;
+      {
+	static std::mutex mx;
+	static std::map<pair<int,int>,cufftHandle> plans;
+	std::lock_guard<std::mutex> lock(mx);
+	auto it=plans.find(pair<int,int>(N,nc));
+	if(it!=plans.end()) plan=it->second;
+	else{
+	  int n[1]={N};
+	  GELIB_ASSRT(cufftPlanMany(&plan,1,n,n,nc,1,n,nc,1,CUFFT_C2C,nc)==CUFFT_SUCCESS);
+	  plans[pair<int,int>(N,nc)]=plan;
+	}
+      }
+      for(int ib=0; ib<b; ib++){
+	cufftComplex* p=(cufftComplex*)(scratch+2*((size_t)ib)*N*nc);
+	GELIB_ASSRT(cufftExecC2C(plan,p,p,CUFFT_INVERSE)==CUFFT_SUCCESS);
+      }
+
+      cnine::Ctensor3_view coeffs(scratch,scratch+1,b,M,nc,2*N*nc,2*nc,2,_r.dev);
+      _r.add(coeffs);
+
+      CUDA_SAFE(cudaDeviceSynchronize());
+      gelib_cuda_arena.free(scratch);
     }
 
+#endif
+
   };
 
 }
 
-#endif 
-
+#endif
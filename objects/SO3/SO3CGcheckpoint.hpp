@@ -0,0 +1,89 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3CGcheckpoint
+#define _SO3CGcheckpoint
+
+#include "GElib_base.hpp"
+#include "SO3vecB.hpp"
+
+
+namespace GElib{
+
+  // Rematerialization checkpoint for a vec-level CG product. The
+  // product is often the largest activation held for backward: its
+  // channel dimension is the product of the operand widths, while the
+  // operands themselves are comparatively small. A checkpoint keeps
+  // only references to the operands. The operand gradients never need
+  // the product (SO3part_addCGproduct_back0/1Fn read only g, x and y),
+  // and a consumer that does need it in its own backward -- a following
+  // mix or nonlinearity -- calls materialize(), which re-runs the cheap
+  // forward from the saved inputs, and release() when done, so the full
+  // product tensor is alive only inside that window instead of for the
+  // whole backward sweep. The operands must outlive the checkpoint.
+
+  class SO3CGcheckpoint{
+  public:
+
+    const SO3vecB* x;
+    const SO3vecB* y;
+    int maxl;
+
+    SO3vecB* remat=nullptr;
+
+
+    SO3CGcheckpoint(const SO3vecB& _x, const SO3vecB& _y, const int _maxl=-1):
+      x(&_x), y(&_y), maxl(_maxl){}
+
+    ~SO3CGcheckpoint(){
+      release();
+    }
+
+    SO3CGcheckpoint(const SO3CGcheckpoint&)=delete;
+    SO3CGcheckpoint& operator=(const SO3CGcheckpoint&)=delete;
+
+
+  public: // ---- Forward ------------------------------------------------------------------------------------
+
+
+    // Checkpointed forward: computes the product and hands it to the
+    // caller without retaining anything. The caller is free to consume
+    // and drop it immediately.
+    SO3vecB forward() const{
+      return x->CGproduct(*y,maxl);
+    }
+
+
+  public: // ---- Backward -----------------------------------------------------------------------------------
+
+
+    // Operand gradients; needs only g and the saved inputs.
+    void backward(SO3vecB& xg, SO3vecB& yg, const SO3vecB& g) const{
+      SO3vecB::add_CGproduct_back(xg,yg,g,*x,*y);
+    }
+
+    // Rematerialized product for consumers whose backward reads the
+    // forward output. The recomputation is cached until release(), so
+    // several consumers in one backward sweep pay for it once.
+    SO3vecB& materialize(){
+      if(!remat) remat=new SO3vecB(x->CGproduct(*y,maxl));
+      return *remat;
+    }
+
+    void release(){
+      if(remat) delete remat;
+      remat=nullptr;
+    }
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,259 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3CGjitKernelBank
+#define _SO3CGjitKernelBank
+
+#if defined(_WITH_CUDA) && defined(_WITH_NVRTC)
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+#include <nvrtc.h>
+
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+#include "GElib_base.hpp"
+#include "GElibLog.hpp"
+#include "SO3_CGbank.hpp"
+#include "SO3part3_view.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+extern GElib::GElibLog* gelib_log;
+
+
+namespace GElib{
+
+  // Runtime-specialized CG product kernels. The shipped kernels are
+  // generic over (l1,l2,l) and fetch their coefficients indirectly from
+  // constant or global memory; for a deployment that runs a fixed small
+  // shape set for days it pays to JIT-compile, once per shape, a fully
+  // unrolled kernel with the CG nonzeros baked into floating point
+  // immediates. Compiled kernels are cached in memory for the process
+  // and, if GELIB_CG_JIT_CACHE names a directory, as PTX on disk keyed
+  // by shape and compute capability, so later runs skip the NVRTC
+  // invocation too. Enabled through GElibConfig::SO3part_CGjit_kernels
+  // (or the GELIB_JIT_CG environment variable); any compilation failure
+  // is logged once and the shape falls back to the generic kernel.
+
+  class SO3CGjitKernelBank{
+  private:
+
+    std::mutex mx;
+    map<vector<int>,CUfunction> kernels;   // nullptr marks a failed compile
+    vector<CUmodule> modules;
+
+  public:
+
+    SO3CGjitKernelBank(){}
+
+    SO3CGjitKernelBank(const SO3CGjitKernelBank&)=delete;
+    SO3CGjitKernelBank& operator=(const SO3CGjitKernelBank&)=delete;
+
+    ~SO3CGjitKernelBank(){
+      for(auto m:modules) cuModuleUnload(m);
+    }
+
+
+  public: // ---- Launching ----------------------------------------------------------------------------------
+
+
+    // Returns false if no specialized kernel could be built for this
+    // shape, in which case the caller runs the generic path.
+    bool operator()(const cnine::Ctensor3_view& r, const cnine::Ctensor3_view& x, const cnine::Ctensor3_view& y,
+      const int offs, const cudaStream_t& stream){
+
+      const int l1=(x.n1-1)/2;
+      const int l2=(y.n1-1)/2;
+      const int l=(r.n1-1)/2;
+      CUfunction f=get(l1,l2,l);
+      if(!f) return false;
+
+      const int N1=x.n2;
+      const int N2=y.n2;
+      const int B=x.n0;
+      if(B*N1*N2==0) return true;
+
+      void* rr=(void*)r.arr; void* ri=(void*)r.arrc;
+      void* xr=(void*)x.arr; void* xi=(void*)x.arrc;
+      void* yr=(void*)y.arr; void* yi=(void*)y.arrc;
+      int rs0=r.s0, rs1=r.s1, rs2=r.s2;
+      int xs0=x.s0, xs1=x.s1, xs2=x.s2;
+      int ys0=y.s0, ys1=y.s1, ys2=y.s2;
+      int _N1=N1, _N2=N2, _B=B, _offs=offs;
+      void* args[]={&rr,&ri,&rs0,&rs1,&rs2,&xr,&xi,&xs0,&xs1,&xs2,
+		    &yr,&yi,&ys0,&ys1,&ys2,&_N1,&_N2,&_B,&_offs};
+
+      const int nthreads=256;
+      if(cuLaunchKernel(f,(B*N1*N2+nthreads-1)/nthreads,1,1,nthreads,1,1,0,
+	  (CUstream)stream,args,nullptr)!=CUDA_SUCCESS){
+	gelib_log->error(__PRETTY_FUNCTION__,"cuLaunchKernel failed for JIT-compiled CG kernel.");
+	return false;
+      }
+      return true;
+    }
+
+
+  private: // ---- Compilation -------------------------------------------------------------------------------
+
+
+    CUfunction get(const int l1, const int l2, const int l){
+      lock_guard<mutex> lock(mx);
+      vector<int> key({l1,l2,l});
+      auto it=kernels.find(key);
+      if(it!=kernels.end()) return it->second;
+
+      int cdev=0;
+      CUDA_SAFE(cudaGetDevice(&cdev));
+      int major=0, minor=0;
+      CUDA_SAFE(cudaDeviceGetAttribute(&major,cudaDevAttrComputeCapabilityMajor,cdev));
+      CUDA_SAFE(cudaDeviceGetAttribute(&minor,cudaDevAttrComputeCapabilityMinor,cdev));
+
+      string ptx=from_disk(l1,l2,l,major,minor);
+      if(ptx.size()==0){
+	ptx=compile(l1,l2,l,major,minor);
+	if(ptx.size()==0){
+	  kernels[key]=nullptr;
+	  return nullptr;
+	}
+	to_disk(l1,l2,l,major,minor,ptx);
+      }
+
+      CUmodule module;
+      CUfunction f=nullptr;
+      if(cuModuleLoadData(&module,ptx.c_str())!=CUDA_SUCCESS ||
+	cuModuleGetFunction(&f,module,"gelib_jit_cgproduct")!=CUDA_SUCCESS){
+	gelib_log->error(__PRETTY_FUNCTION__,"Failed to load JIT-compiled CG kernel for shape ("+
+	  to_string(l1)+","+to_string(l2)+","+to_string(l)+").");
+	kernels[key]=nullptr;
+	return nullptr;
+      }
+      modules.push_back(module);
+      kernels[key]=f;
+      return f;
+    }
+
+
+    string compile(const int l1, const int l2, const int l, const int major, const int minor){
+      const string src=source(l1,l2,l);
+
+      nvrtcProgram prog;
+      if(nvrtcCreateProgram(&prog,src.c_str(),"gelib_jit_cgproduct.cu",0,nullptr,nullptr)!=NVRTC_SUCCESS)
+	return "";
+
+      const string arch="--gpu-architecture=compute_"+to_string(major)+to_string(minor);
+      const char* opts[]={arch.c_str(),"--use_fast_math"};
+      if(nvrtcCompileProgram(prog,2,opts)!=NVRTC_SUCCESS){
+	size_t logn=0;
+	nvrtcGetProgramLogSize(prog,&logn);
+	string log(logn,'\0');
+	nvrtcGetProgramLog(prog,&log[0]);
+	gelib_log->error(__PRETTY_FUNCTION__,"NVRTC compilation failed for shape ("+
+	  to_string(l1)+","+to_string(l2)+","+to_string(l)+"): "+log);
+	nvrtcDestroyProgram(&prog);
+	return "";
+      }
+
+      size_t n=0;
+      nvrtcGetPTXSize(prog,&n);
+      string ptx(n,'\0');
+      nvrtcGetPTX(prog,&ptx[0]);
+      nvrtcDestroyProgram(&prog);
+      return ptx;
+    }
+
+
+    // One thread per (batch,n1,n2) output column: the 2l+1 accumulators
+    // live in registers, every coefficient is a literal and the loops
+    // over the nonzeros are unrolled textually, so the emitted kernel
+    // contains only fused multiply-adds and the final strided writes.
+    string source(const int l1, const int l2, const int l){
+      auto& C=SO3_cgbank.getf(CGindex(l1,l2,l));
+      std::ostringstream oss;
+      oss.precision(9);
+      oss<<std::scientific;
+
+      oss<<"extern \"C\" __global__ void gelib_jit_cgproduct(\n";
+      oss<<"  float* rr, float* ri, int rs0, int rs1, int rs2,\n";
+      oss<<"  const float* xr, const float* xi, int xs0, int xs1, int xs2,\n";
+      oss<<"  const float* yr, const float* yi, int ys0, int ys1, int ys2,\n";
+      oss<<"  int N1, int N2, int B, int offs){\n";
+      oss<<"  int t=blockIdx.x*blockDim.x+threadIdx.x;\n";
+      oss<<"  if(t>=B*N1*N2) return;\n";
+      oss<<"  int b=t/(N1*N2);\n";
+      oss<<"  int j=t%(N1*N2);\n";
+      oss<<"  int n1=j/N2;\n";
+      oss<<"  int n2=j%N2;\n";
+
+      for(int m1=0; m1<2*l1+1; m1++){
+	oss<<"  float xr"<<m1<<"=xr[b*xs0+"<<m1<<"*xs1+n1*xs2];\n";
+	oss<<"  float xi"<<m1<<"=xi[b*xs0+"<<m1<<"*xs1+n1*xs2];\n";
+      }
+      for(int m2=0; m2<2*l2+1; m2++){
+	oss<<"  float yr"<<m2<<"=yr[b*ys0+"<<m2<<"*ys1+n2*ys2];\n";
+	oss<<"  float yi"<<m2<<"=yi[b*ys0+"<<m2<<"*ys1+n2*ys2];\n";
+      }
+      for(int m=0; m<2*l+1; m++){
+	oss<<"  float ar"<<m<<"=0;\n";
+	oss<<"  float ai"<<m<<"=0;\n";
+      }
+
+      for(auto& e:C.nonzeros){
+	oss<<"  ar"<<e.m<<"+="<<e.c<<"f*(xr"<<e.m1<<"*yr"<<e.m2<<"-xi"<<e.m1<<"*yi"<<e.m2<<");\n";
+	oss<<"  ai"<<e.m<<"+="<<e.c<<"f*(xr"<<e.m1<<"*yi"<<e.m2<<"+xi"<<e.m1<<"*yr"<<e.m2<<");\n";
+      }
+
+      for(int m=0; m<2*l+1; m++){
+	oss<<"  rr[b*rs0+"<<m<<"*rs1+(offs+j)*rs2]+=ar"<<m<<";\n";
+	oss<<"  ri[b*rs0+"<<m<<"*rs1+(offs+j)*rs2]+=ai"<<m<<";\n";
+      }
+      oss<<"}\n";
+      return oss.str();
+    }
+
+
+  private: // ---- On-disk cache -----------------------------------------------------------------------------
+
+
+    string cache_path(const int l1, const int l2, const int l, const int major, const int minor){
+      const char* dir=getenv("GELIB_CG_JIT_CACHE");
+      if(!dir) return "";
+      return string(dir)+"/cg_"+to_string(l1)+"_"+to_string(l2)+"_"+to_string(l)+
+	"_cc"+to_string(major)+to_string(minor)+".ptx";
+    }
+
+    string from_disk(const int l1, const int l2, const int l, const int major, const int minor){
+      const string path=cache_path(l1,l2,l,major,minor);
+      if(path.size()==0) return "";
+      std::ifstream in(path,std::ios::binary);
+      if(!in.good()) return "";
+      std::ostringstream oss;
+      oss<<in.rdbuf();
+      return oss.str();
+    }
+
+    void to_disk(const int l1, const int l2, const int l, const int major, const int minor, const string& ptx){
+      const string path=cache_path(l1,l2,l,major,minor);
+      if(path.size()==0) return;
+      std::ofstream out(path,std::ios::binary);
+      if(out.good()) out.write(ptx.data(),ptx.size());
+    }
+
+  };
+
+}
+
+
+extern GElib::SO3CGjitKernelBank SO3CGjit_bank;
+
+#endif
+
+#endif
@@ -0,0 +1,117 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3CGkernelDispatcher
+#define _SO3CGkernelDispatcher
+
+#include <mutex>
+#include <unordered_map>
+#include "GElib_base.hpp"
+#include "GElibConfig.hpp"
+#include "SO3CGproductSignature.hpp"
+
+extern GElib::GElibConfig* gelib_config;
+
+
+namespace GElib{
+
+  enum class SO3CGkernel{scalar,simd,gemm,gpu};
+
+
+  // Full shape of one CG product call: the (l1,l2,l) signature of
+  // SO3CGproductSignature extended with the batch/channel dimensions and
+  // device that determine which kernel variant runs fastest.
+  class SO3CGproductShape{
+  public:
+
+    int l1,l2,l;
+    int B,N1,N2;
+    int dev;
+
+    SO3CGproductShape(const int _l1, const int _l2, const int _l,
+      const int _B, const int _N1, const int _N2, const int _dev):
+      l1(_l1), l2(_l2), l(_l), B(_B), N1(_N1), N2(_N2), dev(_dev){}
+
+    bool operator==(const SO3CGproductShape& x) const{
+      return l1==x.l1 && l2==x.l2 && l==x.l && B==x.B && N1==x.N1 && N2==x.N2 && dev==x.dev;
+    }
+
+    string str() const{
+      ostringstream oss;
+      oss<<"("<<l1<<","<<l2<<","<<l<<")[b="<<B<<",n1="<<N1<<",n2="<<N2<<",dev="<<dev<<"]";
+      return oss.str();
+    }
+
+  };
+
+
+  // Memoized shape -> kernel variant dispatch. Production workloads
+  // repeat the same few dozen shapes millions of times, so the routing
+  // decision is made once per shape and then served from a cache that is
+  // only locked briefly around the map probe.
+  class SO3CGkernelDispatcher{
+  private:
+
+    unordered_map<SO3CGproductShape,SO3CGkernel> cache;
+    mutex safety_mx;
+
+  public:
+
+    SO3CGkernel operator()(const SO3CGproductShape& shape){
+      {
+	lock_guard<mutex> lock(safety_mx);
+	auto it=cache.find(shape);
+	if(it!=cache.end()) return it->second;
+      }
+      SO3CGkernel r=choose(shape);
+      lock_guard<mutex> lock(safety_mx);
+      cache[shape]=r;
+      return r;
+    }
+
+    // Overrides the memoized decision for a shape; used by autotuning.
+    void set(const SO3CGproductShape& shape, const SO3CGkernel k){
+      lock_guard<mutex> lock(safety_mx);
+      cache[shape]=k;
+    }
+
+  private:
+
+    SO3CGkernel choose(const SO3CGproductShape& shape) const{
+      if(shape.dev>0) return SO3CGkernel::gpu;
+      const int gemm_threshold=gelib_config? gelib_config->SO3part_CGproduct_gemm_threshold : 4096;
+      if(shape.N1*shape.N2>=gemm_threshold) return SO3CGkernel::gemm;
+      return SO3CGkernel::simd;
+    }
+
+  };
+
+}
+
+
+namespace std{
+  template<>
+  struct hash<GElib::SO3CGproductShape>{
+  public:
+    size_t operator()(const GElib::SO3CGproductShape& x) const{
+      size_t h=hash<int>()(x.l1);
+      h=(h<<5)^hash<int>()(x.l2);
+      h=(h<<5)^hash<int>()(x.l);
+      h=(h<<5)^hash<int>()(x.B);
+      h=(h<<5)^hash<int>()(x.N1);
+      h=(h<<5)^hash<int>()(x.N2);
+      h=(h<<5)^hash<int>()(x.dev);
+      return h;
+    }
+  };
+}
+
+
+#endif
@@ -0,0 +1,123 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3CGproductPlan
+#define _SO3CGproductPlan
+
+#include <map>
+#include <mutex>
+
+#include "GElib_base.hpp"
+#include "SO3type.hpp"
+#include "SO3vec_addCGproductFn.hpp"
+
+
+namespace GElib{
+
+  // Memoized traversal plan for the vec-level CG product, mirroring the
+  // SO3FFTPlan model. Every SO3vecB::CGproduct call re-derives the
+  // output SO3type, the per-(l1,l2,l) output offsets and the CG table
+  // pointers before touching data; a plan captures all of this once for
+  // a (tau1,tau2,maxl) signature, so the millions of structurally
+  // identical calls in a training run reduce to a walk over the stored
+  // triple table. Unlike SO3FFTPlan a CG plan owns no workspaces and is
+  // safe to share between threads; obtain plans from SO3CGplanBank.
+
+  class SO3CGproductPlan{
+  public:
+
+    SO3type tau1;
+    SO3type tau2;
+    SO3type tau;
+    int maxl;
+
+    vector<SO3CGtriple> triples;
+
+
+    SO3CGproductPlan(const SO3type& _tau1, const SO3type& _tau2, const int _maxl=-1):
+      tau1(_tau1), tau2(_tau2), maxl(_maxl){
+      tau=GElib::CGproduct(tau1,tau2,maxl);
+
+      const int L1=tau1.size()-1;
+      const int L2=tau2.size()-1;
+      const int L=tau.size()-1;
+      vector<int> offs(tau.size(),0);
+      for(int l1=0; l1<=L1; l1++)
+	for(int l2=0; l2<=L2; l2++)
+	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
+	    triples.push_back(SO3CGtriple{l1,l2,l,offs[l],&SO3_cgbank_cached<float>(CGindex(l1,l2,l))});
+	    offs[l]+=tau1[l1]*tau2[l2];
+	  }
+    }
+
+    SO3CGproductPlan(const SO3CGproductPlan& x)=delete;
+    SO3CGproductPlan& operator=(const SO3CGproductPlan& x)=delete;
+
+
+  public: // ---- Execution ----------------------------------------------------------------------------------
+
+
+    void operator()(const vector<SO3part3_view>& r, const vector<SO3part3_view>& x,
+      const vector<SO3part3_view>& y) const{
+      SO3vec_addCGproductFn()(r,x,y,triples);
+    }
+
+  };
+
+
+  // Bank of plans keyed by their signature, in the mold of
+  // SO3FFTplanBank: the first request for a signature builds the plan,
+  // later requests return the same object.
+
+  class SO3CGplanBank{
+  private:
+
+    typedef vector<int> Pindex;
+
+    mutex safety_mx;
+    std::map<Pindex,SO3CGproductPlan*> plans;
+
+
+  public:
+
+    SO3CGplanBank(){}
+
+    SO3CGplanBank(const SO3CGplanBank& x)=delete;
+    SO3CGplanBank& operator=(const SO3CGplanBank& x)=delete;
+
+    ~SO3CGplanBank(){
+      for(auto p:plans) delete p.second;
+    }
+
+
+    SO3CGproductPlan& operator()(const SO3type& tau1, const SO3type& tau2, const int maxl=-1){
+      lock_guard<mutex> lock(safety_mx);
+      Pindex ix;
+      ix.push_back(maxl);
+      ix.push_back(-2);
+      for(auto p:tau1) ix.push_back(p);
+      ix.push_back(-2);
+      for(auto p:tau2) ix.push_back(p);
+      auto it=plans.find(ix);
+      if(it!=plans.end()) return *it->second;
+      SO3CGproductPlan* P=new SO3CGproductPlan(tau1,tau2,maxl);
+      plans[ix]=P;
+      return *P;
+    }
+
+  };
+
+}
+
+
+extern GElib::SO3CGplanBank SO3CGplans;
+
+
+#endif
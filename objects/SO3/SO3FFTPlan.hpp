@@ -0,0 +1,171 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3FFTPlan
+#define _SO3FFTPlan
+
+#include <map>
+#include <mutex>
+
+#include "GElib_base.hpp"
+#include "CtensorB.hpp"
+#include "Ctensor4_view.hpp"
+#include "SO3FourierMatrixBank.hpp"
+
+extern GElib::SO3FourierMatrixBank SO3FourierMxBank;
+
+
+namespace GElib{
+
+  // Reusable plan for the batched SO(3) Fourier transform, mirroring
+  // the FFTW plan model. SO3part_addFFT_Fn/SO3part_addIFFT_Fn resolve
+  // their Fourier and Wigner-d matrices from the bank and allocate two
+  // intermediate tensors on every call; a plan does both once for a
+  // given (batch, maxl, grid) signature, so a spectral-convolution
+  // layer that transforms the same shapes every step pays only the
+  // three contractions per part. Obtain plans from SO3FFTplanBank
+  // rather than constructing them directly; a plan is not thread-safe
+  // (it owns its workspaces), so concurrent layers should request one
+  // plan each.
+
+  class SO3FFTPlan{
+  public:
+
+    typedef cnine::CtensorB Ctensor;
+
+    int b;
+    int maxl;
+    int Nphi;
+    int Ntheta;
+    int Npsi;
+    int dev;
+
+    // Per-l tables resolved from SO3FourierMxBank at plan time, and
+    // the two intermediate workspaces reused by every execute.
+    vector<const Ctensor*> iFpsi;
+    vector<const Ctensor*> iFphi;
+    vector<const Ctensor*> Fpsi;
+    vector<const Ctensor*> Fphi;
+    vector<const Ctensor*> D;
+    vector<Ctensor*> Aws;
+    vector<Ctensor*> Bws;
+
+
+    SO3FFTPlan(const int _b, const int _maxl, const int _Nphi, const int _Ntheta, const int _Npsi, const int _dev=0):
+      b(_b), maxl(_maxl), Nphi(_Nphi), Ntheta(_Ntheta), Npsi(_Npsi), dev(_dev){
+      SO3FourierMatrixBank& bank=SO3FourierMxBank;
+      for(int l=0; l<=maxl; l++){
+	const int L=2*l+1;
+	iFpsi.push_back(&bank.iFmatrix(l,Npsi,dev));
+	iFphi.push_back(&bank.iFmatrix(l,Nphi,dev));
+	Fpsi.push_back(&bank.Fmatrix(l,Npsi,dev));
+	Fphi.push_back(&bank.Fmatrix(l,Nphi,dev));
+	D.push_back(&bank.Dmatrix(l,Ntheta,dev));
+	Aws.push_back(new Ctensor(Ctensor::zero(cnine::Gdims(b,Nphi,Ntheta,L),dev)));
+	Bws.push_back(new Ctensor(Ctensor::zero(cnine::Gdims(b,L,Ntheta,L),dev)));
+      }
+    }
+
+    ~SO3FFTPlan(){
+      for(auto p:Aws) delete p;
+      for(auto p:Bws) delete p;
+    }
+
+    SO3FFTPlan(const SO3FFTPlan& x)=delete;
+    SO3FFTPlan& operator=(const SO3FFTPlan& x)=delete;
+
+
+  public: // ---- Execution ----------------------------------------------------------------------------------
+
+
+    // Forward transform of one part: accumulates the l'th Fourier
+    // component of the function sampled on the (Nphi,Ntheta,Npsi) grid
+    // f into p. Same contraction sequence as SO3part_addFFT_Fn, on the
+    // plan's workspaces.
+    void execute(const cnine::Ctensor3_view& p, const cnine::Ctensor4_view& f){
+      const int l=(p.n1-1)/2;
+      GELIB_ASSRT(p.n1==p.n2);
+      GELIB_ASSRT(l<=maxl);
+      GELIB_ASSRT(p.n0==b && f.n0==b);
+      GELIB_ASSRT(f.n1==Nphi && f.n2==Ntheta && f.n3==Npsi);
+      Ctensor& A=*Aws[l];
+      Ctensor& B=*Bws[l];
+      A.set_zero();
+      A.view4().add_mix_3_0(f,iFpsi[l]->view2());
+      B.set_zero();
+      B.view4().add_mix_1_0(A.view4(),iFphi[l]->view2());
+      B.view4().add_contract_abic_bic_abc_to(p,D[l]->view3());
+    }
+
+    // Inverse transform of one part: accumulates the contribution of
+    // the Fourier component p onto the sample grid f. Same contraction
+    // sequence as SO3part_addIFFT_Fn.
+    void execute_inverse(const cnine::Ctensor4_view& f, const cnine::Ctensor3_view& p){
+      const int l=(p.n1-1)/2;
+      GELIB_ASSRT(p.n1==p.n2);
+      GELIB_ASSRT(l<=maxl);
+      GELIB_ASSRT(p.n0==b && f.n0==b);
+      GELIB_ASSRT(f.n1==Nphi && f.n2==Ntheta && f.n3==Npsi);
+      Ctensor& A=*Bws[l];
+      Ctensor& B=*Aws[l];
+      A.set_zero();
+      A.view4().add_expand_2(p,D[l]->view3());
+      B.set_zero();
+      B.view4().add_mix_1_0(A.view4(),Fphi[l]->view2());
+      f.add_mix_3_0(B.view4(),Fpsi[l]->view2());
+    }
+
+  };
+
+
+  // Bank of plans keyed by their full signature, in the mold of
+  // SO3FourierMatrixBank: the first request for a signature builds the
+  // plan, later requests return the same object.
+
+  class SO3FFTplanBank{
+  private:
+
+    typedef array<int,6> Pindex;
+
+    mutex safety_mx;
+    std::map<Pindex,SO3FFTPlan*> plans;
+
+
+  public:
+
+    SO3FFTplanBank(){}
+
+    SO3FFTplanBank(const SO3FFTplanBank& x)=delete;
+    SO3FFTplanBank& operator=(const SO3FFTplanBank& x)=delete;
+
+    ~SO3FFTplanBank(){
+      for(auto p:plans) delete p.second;
+    }
+
+
+    SO3FFTPlan& operator()(const int b, const int maxl, const int Nphi, const int Ntheta, const int Npsi, const int dev=0){
+      lock_guard<mutex> lock(safety_mx);
+      Pindex ix({b,maxl,Nphi,Ntheta,Npsi,dev});
+      auto it=plans.find(ix);
+      if(it!=plans.end()) return *it->second;
+      SO3FFTPlan* P=new SO3FFTPlan(b,maxl,Nphi,Ntheta,Npsi,dev);
+      plans[ix]=P;
+      return *P;
+    }
+
+  };
+
+}
+
+
+extern GElib::SO3FFTplanBank SO3FFTplans;
+
+
+#endif
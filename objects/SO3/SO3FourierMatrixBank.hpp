@@ -19,6 +19,12 @@
 
 namespace GElib{
 
+  #ifdef _WITH_CUDA
+  void SO3_Wignerd_batched_cu(float* arr, const int s0, const int s1, const int s2,
+    const int l, const float* beta, const float* scale, const int N, const cudaStream_t& stream);
+  #endif
+
+
   class SO3FourierMatrixBank{
   private:
 
@@ -55,6 +61,25 @@ namespace GElib{
 
   public:
 
+    // Snapshots of the CPU-side matrices currently in the bank, used by
+    // GElibWarmupManifest to record a warm-up set at the end of a run.
+    vector<pair<int,int> > loaded_Findices(){
+      lock_guard<mutex> lock(safety_mx);
+      vector<pair<int,int> > r;
+      for(auto& p:Fmatrices) r.push_back(p.first);
+      for(auto& p:iFmatrices)
+	if(Fmatrices.find(p.first)==Fmatrices.end()) r.push_back(p.first);
+      return r;
+    }
+
+    vector<pair<int,int> > loaded_Dindices(){
+      lock_guard<mutex> lock(safety_mx);
+      vector<pair<int,int> > r;
+      for(auto& p:Dmatrices) r.push_back(p.first);
+      return r;
+    }
+
+
     const Ctensor& Fmatrix(const int l, const int n, const int dev=0){
 
       if(dev==1){
@@ -120,10 +145,28 @@ namespace GElib{
 	lock_guard<mutex> lock(safety_mxC);
 	auto it=DmatricesC.find(ix);
 	if(it!=DmatricesC.end()) return *it->second;
-      
+
+#ifdef _WITH_CUDA
+	// Built directly on the device by the batched Wigner-d kernel:
+	// only the n-point beta/scale arrays cross the bus, not the
+	// (2l+1)^2 x n matrix, and the host never runs the recursion.
+	Ctensor* D=new Ctensor(cnine::Gdims(2*l+1,n,2*l+1),cnine::fill_zero(),1);
+	vector<float> aux(2*n);
+	const float fact=sqrt(2*l+1)/sqrt(n);
+	for(int i=0; i<n; i++){
+	  aux[i]=M_PI*i/n;
+	  aux[n+i]=fact*sqrt(sin(aux[i]));
+	}
+	float* auxg=nullptr;
+	CUDA_SAFE(cudaMalloc(&auxg,2*n*sizeof(float)));
+	CUDA_SAFE(cudaMemcpy(auxg,aux.data(),2*n*sizeof(float),cudaMemcpyHostToDevice));
+	CUDA_STREAM(SO3_Wignerd_batched_cu(D->arrg,(2*l+1)*n,2*l+1,1,l,auxg,auxg+n,n,stream));
+	CUDA_SAFE(cudaFree(auxg));
+#else
 	Ctensor* D=new Ctensor(Dmatrix(l,n,0),dev);
+#endif
 	DmatricesC[ix]=D;
-	return *D;      
+	return *D;
       }
 
       lock_guard<mutex> lock(safety_mx);
@@ -144,9 +187,79 @@ namespace GElib{
       return *D;
     }
 
+
+  public: // ---- Preloading ---------------------------------------------------------------------------------
+
+
+    // Materializes the F/iF/D matrices for every l<=maxl on the given
+    // grid, host side and (dev=1) device side, so that in GPU runs no
+    // first use of a spectral layer stalls mid-step on a
+    // compute-plus-upload of a missing matrix.
+    void preload(const int maxl, const int Nphi, const int Ntheta, const int Npsi, const int dev=0){
+      for(int l=0; l<=maxl; l++){
+	for(int n:{Nphi,Npsi}){
+	  Fmatrix(l,n,0);
+	  iFmatrix(l,n,0);
+	  if(dev>0){
+	    Fmatrix(l,n,1);
+	    iFmatrix(l,n,1);
+	  }
+	}
+	Dmatrix(l,Ntheta,0);
+	if(dev>0) Dmatrix(l,Ntheta,1);
+      }
+    }
+
+    void preload(const int maxl, const int N, const int dev=0){
+      preload(maxl,N,N,N,dev);
+    }
+
   };
 
 }
 
 
+extern GElib::SO3FourierMatrixBank SO3FourierMxBank;
+
+namespace GElib{
+
+  // Thread-local direct-mapped caches in front of the global bank,
+  // mirroring SO3_cgbank_cached: a spectral layer requests the same
+  // few (l,n,dev) matrices every step, and the locked bank lookup
+  // costs a lock and a map probe per call. Entries are stable because
+  // the bank never frees matrices.
+
+  namespace{
+    template<int SLOT>
+    inline const cnine::CtensorB& SO3FourierMx_cached(const int l, const int n, const int dev,
+      const cnine::CtensorB& (SO3FourierMatrixBank::*getter)(const int, const int, const int)){
+      constexpr int N=32;
+      struct entry{
+	int l=-1,n=-1,dev=-1;
+	const cnine::CtensorB* p=nullptr;
+      };
+      thread_local entry cache[N];
+      entry& e=cache[(std::hash<int>()(l*1024+n)+dev)%N];
+      if(e.l==l && e.n==n && e.dev==dev) return *e.p;
+      const cnine::CtensorB* p=&(SO3FourierMxBank.*getter)(l,n,dev);
+      e.l=l; e.n=n; e.dev=dev; e.p=p;
+      return *p;
+    }
+  }
+
+  inline const cnine::CtensorB& SO3Fmatrix_cached(const int l, const int n, const int dev=0){
+    return SO3FourierMx_cached<0>(l,n,dev,&SO3FourierMatrixBank::Fmatrix);
+  }
+
+  inline const cnine::CtensorB& SO3iFmatrix_cached(const int l, const int n, const int dev=0){
+    return SO3FourierMx_cached<1>(l,n,dev,&SO3FourierMatrixBank::iFmatrix);
+  }
+
+  inline const cnine::CtensorB& SO3Dmatrix_cached(const int l, const int n, const int dev=0){
+    return SO3FourierMx_cached<2>(l,n,dev,&SO3FourierMatrixBank::Dmatrix);
+  }
+
+}
+
+
 #endif 
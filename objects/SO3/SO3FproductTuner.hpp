@@ -0,0 +1,173 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3FproductTuner
+#define _SO3FproductTuner
+
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#include "GElib_base.hpp"
+#include "CtensorB.hpp"
+#include "SO3part_addFproduct_Fn.hpp"
+#include "SO3part_addFproduct_back0Fn.hpp"
+#include "SO3part_addFproduct_back1Fn.hpp"
+
+
+namespace GElib{
+
+  // The Fproduct GPU kernels accept a 'method' integer selecting among
+  // kernel strategies, and which strategy wins depends on the shape:
+  // the blocked variant (method=1) amortizes shared memory loads for
+  // large (l1,l2,l) but loses to the straight kernel on small parts or
+  // small batches. Rather than have callers hardwire the choice, this
+  // tuner benchmarks the candidate methods on scratch tensors the first
+  // time each (kind,l1,l2,l,B) shape is seen on a device and caches the
+  // winner, so every later call with that shape dispatches directly.
+  //
+  // The decision table can be persisted: if GELIB_FPRODUCT_TUNING names
+  // a file, GElibSession loads it at startup and re-records it at
+  // shutdown, so later runs skip the benchmarking entirely. The format
+  // is plain text, one "fproduct kind l1 l2 l B dev method" entry per
+  // line; lines starting with '#' are ignored.
+
+  class SO3FproductTuner{
+  public:
+
+    // Fn kinds sharing the method parameter but with distinct kernels.
+    enum FKIND{FWD=0,BACK0=1,BACK1=2};
+
+    static const int n_methods=2;
+
+  private:
+
+    typedef cnine::CtensorB Ctensor;
+    typedef array<int,6> Tindex; // (kind,l1,l2,l,B,dev)
+
+    mutex safety_mx;
+    map<Tindex,int> table;
+    int reps=3;
+
+
+  public:
+
+    SO3FproductTuner(){}
+
+    SO3FproductTuner(const SO3FproductTuner& x)=delete;
+    SO3FproductTuner& operator=(const SO3FproductTuner& x)=delete;
+
+
+  public: // ---- Lookup -------------------------------------------------------------------------------------
+
+
+    int method(const int kind, const int l1, const int l2, const int l, const int B, const int dev){
+      if(dev==0) return 0; // the host path has a single implementation
+      Tindex ix({kind,l1,l2,l,B,dev});
+      {
+	lock_guard<mutex> lock(safety_mx);
+	auto it=table.find(ix);
+	if(it!=table.end()) return it->second;
+      }
+      int m=benchmark(kind,l1,l2,l,B,dev);
+      lock_guard<mutex> lock(safety_mx);
+      table[ix]=m;
+      return m;
+    }
+
+
+  public: // ---- I/O ----------------------------------------------------------------------------------------
+
+
+    void load(const string& filename){
+      ifstream ifs(filename);
+      if(!ifs.good()) return;
+      lock_guard<mutex> lock(safety_mx);
+      string line;
+      while(std::getline(ifs,line)){
+	if(line.size()==0 || line[0]=='#') continue;
+	std::istringstream iss(line);
+	string key;
+	iss>>key;
+	if(key=="fproduct"){
+	  int kind,l1,l2,l,B,dev,m;
+	  if(iss>>kind>>l1>>l2>>l>>B>>dev>>m)
+	    table[Tindex({kind,l1,l2,l,B,dev})]=m;
+	}
+      }
+    }
+
+    void save(const string& filename){
+      ofstream ofs(filename);
+      if(!ofs.good()) return;
+      lock_guard<mutex> lock(safety_mx);
+      ofs<<"# GElib Fproduct tuning table"<<endl;
+      for(auto& p:table)
+	ofs<<"fproduct "<<p.first[0]<<" "<<p.first[1]<<" "<<p.first[2]<<" "<<p.first[3]<<" "
+	   <<p.first[4]<<" "<<p.first[5]<<" "<<p.second<<endl;
+    }
+
+
+  private: // ---- Benchmarking ------------------------------------------------------------------------------
+
+
+#ifdef _WITH_CUDA
+
+    // Times each candidate method on gaussian scratch tensors of the
+    // given shape and returns the fastest. Each method gets one warm-up
+    // call (which also triggers any lazy CG table uploads) before the
+    // timed repetitions.
+    int benchmark(const int kind, const int l1, const int l2, const int l, const int B, const int dev){
+      Ctensor x(cnine::Gdims(B,2*l1+1,2*l1+1),cnine::fill_gaussian(),dev);
+      Ctensor y(cnine::Gdims(B,2*l2+1,2*l2+1),cnine::fill_gaussian(),dev);
+      Ctensor r(cnine::Gdims(B,2*l+1,2*l+1),cnine::fill_zero(),dev);
+
+      int best=0;
+      double best_t=0;
+      for(int m=0; m<n_methods; m++){
+	run(kind,r,x,y,m);
+	CUDA_SAFE(cudaDeviceSynchronize());
+	auto t0=chrono::system_clock::now();
+	for(int i=0; i<reps; i++)
+	  run(kind,r,x,y,m);
+	CUDA_SAFE(cudaDeviceSynchronize());
+	double t=chrono::duration<double,std::milli>(chrono::system_clock::now()-t0).count();
+	if(m==0 || t<best_t){best=m; best_t=t;}
+      }
+      return best;
+    }
+
+    // r carries the l-shaped part, x the l1-shaped and y the l2-shaped
+    // one; the backward kernels write into the operand slots.
+    void run(const int kind, Ctensor& r, Ctensor& x, Ctensor& y, const int m){
+      if(kind==FWD) SO3part_addFproduct_Fn(0,m)(r.view3(),x.view3(),y.view3());
+      if(kind==BACK0) SO3part_addFproduct_back0Fn(0,m)(x.view3(),r.view3(),y.view3());
+      if(kind==BACK1) SO3part_addFproduct_back1Fn(0,m)(y.view3(),r.view3(),x.view3());
+    }
+
+#else
+
+    int benchmark(const int kind, const int l1, const int l2, const int l, const int B, const int dev){
+      return 0;
+    }
+
+#endif
+
+  };
+
+}
+
+
+extern GElib::SO3FproductTuner SO3Fproduct_tuner;
+
+
+#endif
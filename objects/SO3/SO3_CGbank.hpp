@@ -13,7 +13,17 @@
 #define _SO3_CGbank
 
 #include <mutex>
+#include <shared_mutex>
+#include <fstream>
+#include <cstring>
+#ifdef __unix__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 #include "SO3_CGcoeffs.hpp"
+#include "MultiLoop.hpp"
 
 #define CG_CMEM_DATA_OFFS 4096
 
@@ -31,20 +41,52 @@ namespace GElib{
   class SO3_CGbank{
   private:
 
+    static const int max_devices=16;
+
     unordered_map<CGindex,SO3_CGcoeffs<float>*> cgcoeffsf;
     unordered_map<CGindex,SO3_CGcoeffs<double>*> cgcoeffsd;
-    unordered_map<CGindex,SO3_CGcoeffs<float>*> cgcoeffsfG;
-    unordered_map<CGindex,SO3_CGcoeffs<double>*> cgcoeffsdG;
-    unordered_map<CGindex,int> cgcoeffsfC;
-    
-    mutex safety_mx;
+    // Device-resident tables are kept per device: an upload is a copy
+    // onto one specific GPU, so on multi-GPU nodes each device gets its
+    // own map (and its own lock below) and every GPU ends up with
+    // exactly one resident copy of each table it uses.
+    unordered_map<CGindex,SO3_CGcoeffs<float>*> cgcoeffsfG[max_devices];
+    unordered_map<CGindex,SO3_CGcoeffs<double>*> cgcoeffsdG[max_devices];
+    // Constant-memory bookkeeping is likewise per device: cg_cmem is a
+    // separate symbol instance on each GPU, so each device has its own
+    // offset map and tails and the hot coefficient set is replicated
+    // into whichever device the calling kernel is launched on.
+    unordered_map<CGindex,int> cgcoeffsfC[max_devices];
+    unordered_map<CGindex,long> cg_callcounts;
+
+    // Reads vastly outnumber inserts: the steady-state lookup takes only
+    // a shared lock, so concurrent CG product calls no longer serialize
+    // on the bank once their tables exist. The exclusive lock is taken
+    // only around the rare insert. The device caches are locked
+    // per device, so an upload to one GPU never stalls lookups on
+    // another.
+    shared_mutex safety_mx;
+    shared_mutex safety_mxG[max_devices];
     mutex safety_mxC;
-    int cmem_index_tail=0;
-    int cmem_data_tail=CG_CMEM_DATA_OFFS;
-  
+    int cmem_index_tail[max_devices]={};
+    int cmem_data_tail[max_devices];
+
+    // Optional on-disk cache, enabled by pointing GELIB_CG_CACHE at a
+    // file. The file is memory-mapped on first use and each table is
+    // copied out of the mapping only when it is actually requested;
+    // tables computed from scratch are appended so later runs warm-start
+    // with zero coefficient computation.
+    bool disk_cache_probed=false;
+    const char* disk_map=nullptr;
+    size_t disk_map_size=0;
+    unordered_map<CGindex,pair<const char*,int> > diskf;
+    unordered_map<CGindex,pair<const char*,int> > diskd;
+
   public:
 
-    SO3_CGbank(){}
+    SO3_CGbank(){
+      for(int d=0; d<max_devices; d++)
+	cmem_data_tail[d]=CG_CMEM_DATA_OFFS;
+    }
     
     SO3_CGbank(const SO3_CGbank& x)=delete;
     SO3_CGbank& operator=(const SO3_CGbank& x)=delete;
@@ -52,101 +94,260 @@ namespace GElib{
     ~SO3_CGbank(){
       for(auto p:cgcoeffsf) delete p.second;
       for(auto p:cgcoeffsd) delete p.second;
-      //for(auto p:cgcoeffsfG) delete p.second; // why is this a problem?
-      for(auto p:cgcoeffsdG) delete p.second;
+      //for(int d=0; d<max_devices; d++)
+      //for(auto p:cgcoeffsfG[d]) delete p.second; // why is this a problem?
+      for(int d=0; d<max_devices; d++)
+	for(auto p:cgcoeffsdG[d]) delete p.second;
+#ifdef __unix__
+      if(disk_map) munmap(const_cast<char*>(disk_map),disk_map_size);
+#endif
     }
     
     const SO3_CGcoeffs<float>& getf(const CGindex& ix, const int dev=0){
       if(dev==0){
-	lock_guard<mutex> lock(safety_mx);
+	{
+	  shared_lock<shared_mutex> lock(safety_mx);
+	  auto it=cgcoeffsf.find(ix);
+	  if(it!=cgcoeffsf.end()) return *it->second;
+	}
+	unique_lock<shared_mutex> lock(safety_mx);
 	auto it=cgcoeffsf.find(ix);
 	if(it!=cgcoeffsf.end()) return *it->second;
-	SO3CG_DEBUG("Computing CG coefficients for "<<ix.str()<<"...");
-	SO3_CGcoeffs<float>* r=new SO3_CGcoeffs<float>(ix);
-	//lock_guard<mutex> lock(safety_mx);
-	//it=cgcoeffsf.find(ix);
-	//if(it!=cgcoeffsf.end()) return *it->second;
+	SO3_CGcoeffs<float>* r=from_disk<float>(ix,diskf);
+	if(!r){
+	  SO3CG_DEBUG("Computing CG coefficients for "<<ix.str()<<"...");
+	  r=new SO3_CGcoeffs<float>(ix);
+	  append_to_disk(ix,0,reinterpret_cast<const char*>(r->arr),r->asize*sizeof(float));
+	}
 	cgcoeffsf[ix]=r;
 	return *r;
       }else{
+	if(dev>=max_devices){
+	  cerr<<"SO3_CGbank: device index "<<dev<<" exceeds max_devices."<<endl; exit(-1);}
 	{
-	  lock_guard<mutex> lock(safety_mx);
-	  auto it=cgcoeffsfG.find(ix);
-	  if(it!=cgcoeffsfG.end()) return *it->second;
+	  shared_lock<shared_mutex> lock(safety_mxG[dev]);
+	  auto it=cgcoeffsfG[dev].find(ix);
+	  if(it!=cgcoeffsfG[dev].end()) return *it->second;
 	}
 	SO3_CGcoeffs<float>* r=new SO3_CGcoeffs<float>(getf(ix));
 	r->to_device(dev);
 	{
-	  lock_guard<mutex> lock(safety_mx);
-	  auto it=cgcoeffsfG.find(ix);
-	  if(it!=cgcoeffsfG.end()) {delete r; return *it->second;}
-	  cgcoeffsfG[ix]=r;
+	  unique_lock<shared_mutex> lock(safety_mxG[dev]);
+	  auto it=cgcoeffsfG[dev].find(ix);
+	  if(it!=cgcoeffsfG[dev].end()) {delete r; return *it->second;}
+	  cgcoeffsfG[dev][ix]=r;
 	  return *r;
 	}
       }
     }
 
     const SO3_CGcoeffs<double>& getd(const CGindex& ix, const cnine::device& dev=0){
-      lock_guard<mutex> lock(safety_mx);
       if(dev.id()==0){
+	{
+	  shared_lock<shared_mutex> lock(safety_mx);
+	  auto it=cgcoeffsd.find(ix);
+	  if(it!=cgcoeffsd.end()) return *it->second;
+	}
+	unique_lock<shared_mutex> lock(safety_mx);
 	auto it=cgcoeffsd.find(ix);
 	if(it!=cgcoeffsd.end()) return *it->second;
-	SO3_CGcoeffs<double>* r=new SO3_CGcoeffs<double>(ix);
-	lock_guard<mutex> lock(safety_mx);
-	it=cgcoeffsd.find(ix);
-	if(it!=cgcoeffsd.end()) return *it->second;
+	SO3_CGcoeffs<double>* r=from_disk<double>(ix,diskd);
+	if(!r){
+	  r=new SO3_CGcoeffs<double>(ix);
+	  append_to_disk(ix,1,reinterpret_cast<const char*>(r->arr),r->asize*sizeof(double));
+	}
 	cgcoeffsd[ix]=r;
 	return *r;
       }else{
-	auto it=cgcoeffsdG.find(ix);
-	if(it!=cgcoeffsdG.end()) return *it->second;
+	const int d=dev.id();
+	if(d>=max_devices){
+	  cerr<<"SO3_CGbank: device index "<<d<<" exceeds max_devices."<<endl; exit(-1);}
+	{
+	  shared_lock<shared_mutex> lock(safety_mxG[d]);
+	  auto it=cgcoeffsdG[d].find(ix);
+	  if(it!=cgcoeffsdG[d].end()) return *it->second;
+	}
 	SO3_CGcoeffs<double>* r=new SO3_CGcoeffs<double>(getd(ix));
 	r->to_device(dev);
-	lock_guard<mutex> lock(safety_mx);
-	it=cgcoeffsdG.find(ix);
-	if(it!=cgcoeffsdG.end()) return *it->second;
-	cgcoeffsdG[ix]=r;
+	unique_lock<shared_mutex> lock(safety_mxG[d]);
+	auto it=cgcoeffsdG[d].find(ix);
+	if(it!=cgcoeffsdG[d].end()){delete r; return *it->second;}
+	cgcoeffsdG[d][ix]=r;
 	return *r;
       }
     }
 
 
+    // Bulk precompute: fills every admissible CGindex for operands of
+    // types tau1 and tau2 (capped at maxl) in parallel, so the first
+    // forward pass of a model pays steady-state latency instead of a
+    // lazy mutex-guarded insert per shape. tau arguments can be SO3type
+    // or anything else with vector<int> semantics.
+    template<typename TAU>
+    void precompute(const TAU& tau1, const TAU& tau2, const int maxl=-1){
+      precompute((int)tau1.size()-1,(int)tau2.size()-1,maxl);
+    }
+
+    void precompute(const int L1, const int L2, const int maxl=-1){
+      {
+	unique_lock<shared_mutex> lock(safety_mx);
+	probe_disk_cache();
+      }
+
+      vector<CGindex> missing;
+      {
+	shared_lock<shared_mutex> lock(safety_mx);
+	for(int l1=0; l1<=L1; l1++)
+	  for(int l2=0; l2<=L2; l2++)
+	    for(int l=std::abs(l1-l2); l<=l1+l2 && (maxl<0 || l<=maxl); l++){
+	      CGindex ix(l1,l2,l);
+	      if(cgcoeffsf.find(ix)==cgcoeffsf.end()) missing.push_back(ix);
+	    }
+      }
+      if(missing.size()==0) return;
+
+      vector<SO3_CGcoeffs<float>*> computed(missing.size(),nullptr);
+      vector<bool> fresh(missing.size(),false);
+      cnine::MultiLoop(missing.size(),[&](const int i){
+	  SO3_CGcoeffs<float>* r=from_disk<float>(missing[i],diskf);
+	  if(!r){
+	    r=new SO3_CGcoeffs<float>(missing[i]);
+	    fresh[i]=true;
+	  }
+	  computed[i]=r;
+	});
+
+      unique_lock<shared_mutex> lock(safety_mx);
+      for(int i=0; i<(int)missing.size(); i++){
+	if(cgcoeffsf.find(missing[i])!=cgcoeffsf.end()){delete computed[i]; continue;}
+	if(fresh[i])
+	  append_to_disk(missing[i],0,reinterpret_cast<const char*>(computed[i]->arr),
+	    computed[i]->asize*sizeof(float));
+	cgcoeffsf[missing[i]]=computed[i];
+      }
+    }
+
+
+    // Snapshot of the CPU-side tables currently in the bank, used by
+    // GElibWarmupManifest to record a warm-up set at the end of a run.
+    vector<CGindex> loaded_indices(){
+      shared_lock<shared_mutex> lock(safety_mx);
+      vector<CGindex> r;
+      for(auto& p:cgcoeffsf) r.push_back(p.first);
+      for(auto& p:cgcoeffsd)
+	if(cgcoeffsf.find(p.first)==cgcoeffsf.end()) r.push_back(p.first);
+      return r;
+    }
+
+
 #ifdef _WITH_CUDA
+    // cudaMemcpyToSymbol writes the cg_cmem instance of the current
+    // device, so the offsets handed out here are valid for the device
+    // the calling kernel is about to launch on; each device fills its
+    // own copy lazily from its own calls.
+    int current_cmem_device() const{
+      int d=0;
+      CUDA_SAFE(cudaGetDevice(&d));
+      if(d>=max_devices){
+	cerr<<"SO3_CGbank: device index "<<d<<" exceeds max_devices."<<endl; exit(-1);}
+      return d;
+    }
+
     int getfC(const int l1, const int l2, const int l){
       lock_guard<mutex> lock(safety_mxC);
+      const int cdev=current_cmem_device();
       CGindex ix(l1,l2,l);
-      auto it=cgcoeffsfC.find(ix);
-      if(it!=cgcoeffsfC.end()) return it->second;
+      cg_callcounts[ix]++;
+      auto it=cgcoeffsfC[cdev].find(ix);
+      if(it!=cgcoeffsfC[cdev].end()) return it->second;
       const SO3_CGcoeffs<float>& coeffs=getf(ix);
-      //cout<<cmem_index_tail<<": "<<l1<<" "<<l2<<" "<<l<<endl;
+      //cout<<cmem_index_tail[cdev]<<": "<<l1<<" "<<l2<<" "<<l<<endl;
 
-      if(cmem_index_tail+4*sizeof(int)>CG_CMEM_DATA_OFFS || cmem_data_tail+sizeof(float)*coeffs.asize>CNINE_CONST_MEM_SIZE){
-	//SO3CG_DEBUG("GPU constant memory full. Reverting to storing CG coefficients in global memory.");
+      if(cmem_index_tail[cdev]+4*sizeof(int)>CG_CMEM_DATA_OFFS || cmem_data_tail[cdev]+sizeof(float)*coeffs.asize>CNINE_CONST_MEM_SIZE){
+	SO3CG_DEBUG("GPU constant memory full. Reverting to storing CG coefficients in global memory.");
+	cgcoeffsfC[cdev][ix]=-128;
+	getfGptr(l1,l2,l,cdev+1);
 	return -128;
       }
 
-      if(cmem_index_tail+4*sizeof(int)>CG_CMEM_DATA_OFFS){
+      if(cmem_index_tail[cdev]+4*sizeof(int)>CG_CMEM_DATA_OFFS){
 	cerr<<"SO3_CGbank: no room to store index entry in constant memory."<<endl; exit(-1);}
       int ix_entry[4];
       ix_entry[0]=l1;
       ix_entry[1]=l2;
       ix_entry[2]=l;
-      ix_entry[3]=cmem_data_tail;
+      ix_entry[3]=cmem_data_tail[cdev];
       CUDA_SAFE(cudaMemcpyToSymbol(cg_cmem,reinterpret_cast<void*>(ix_entry),
-	  4*sizeof(int),cmem_index_tail,cudaMemcpyHostToDevice));
-      cmem_index_tail+=4*sizeof(int);
-      cgcoeffsfC[ix]=cmem_data_tail; 
-      if(cmem_data_tail+sizeof(float)*coeffs.asize>CNINE_CONST_MEM_SIZE){
+	  4*sizeof(int),cmem_index_tail[cdev],cudaMemcpyHostToDevice));
+      cmem_index_tail[cdev]+=4*sizeof(int);
+      cgcoeffsfC[cdev][ix]=cmem_data_tail[cdev];
+      if(cmem_data_tail[cdev]+sizeof(float)*coeffs.asize>CNINE_CONST_MEM_SIZE){
 	cerr<<"SO3_CGbank: no room to store CG matrix in constant memory."<<endl; exit(-1);}
       //cout<<l1<<l2<<l<<coeffs.arr[0]<<endl;
       CUDA_SAFE(cudaMemcpyToSymbol(cg_cmem,reinterpret_cast<void*>(coeffs.arr),
-	  coeffs.asize*sizeof(float),cmem_data_tail,cudaMemcpyHostToDevice));
-      int r=cmem_data_tail;
-      cmem_data_tail+=sizeof(float)*coeffs.asize;
-      SO3CG_DEBUG("GPU constant memory tail: "<<cmem_data_tail);
+	  coeffs.asize*sizeof(float),cmem_data_tail[cdev],cudaMemcpyHostToDevice));
+      int r=cmem_data_tail[cdev];
+      cmem_data_tail[cdev]+=sizeof(float)*coeffs.asize;
+      SO3CG_DEBUG("GPU constant memory tail: "<<cmem_data_tail[cdev]);
       return r;
     }
-#endif 
+
+
+    // Tier-2 store: a deterministic global-memory device copy of the
+    // table, for shapes that no longer fit in constant memory. The
+    // returned pointer stays valid for the lifetime of the bank and is
+    // read through __ldg in the kernels, so high-l models get stable
+    // near-cmem performance instead of whichever shapes registered first
+    // winning the fast path. getfC stages this copy whenever it hands
+    // out a -128 verdict, so by the time a launcher falls back to the
+    // global tier the table is already resident on the device.
+    const float* getfGptr(const int l1, const int l2, const int l, const int dev=1){
+      return getf(CGindex(l1,l2,l),dev).arrg;
+    }
+
+    // Re-derives the constant-memory population of the current device
+    // from observed call counts: clears its cg_cmem bookkeeping and
+    // re-uploads tables hottest first until it is full, demoting the
+    // rest to the global-memory tier. Call counts are shared across
+    // devices, so rebalancing each device in turn replicates the same
+    // hot set everywhere. Callers re-query getfC per launch, so the new
+    // offsets take effect from the next kernel call.
+    void rebalance_cmem(){
+      lock_guard<mutex> lock(safety_mxC);
+      const int cdev=current_cmem_device();
+      vector<pair<long,CGindex> > ranked;
+      for(auto& p:cg_callcounts) ranked.push_back(make_pair(p.second,p.first));
+      std::sort(ranked.begin(),ranked.end(),[](const pair<long,CGindex>& a, const pair<long,CGindex>& b){
+	  return a.first>b.first;});
+
+      cgcoeffsfC[cdev].clear();
+      cmem_index_tail[cdev]=0;
+      cmem_data_tail[cdev]=CG_CMEM_DATA_OFFS;
+
+      for(auto& p:ranked){
+	const CGindex& ix=p.second;
+	const SO3_CGcoeffs<float>& coeffs=getf(ix);
+	if(cmem_index_tail[cdev]+4*sizeof(int)>CG_CMEM_DATA_OFFS ||
+	  cmem_data_tail[cdev]+sizeof(float)*coeffs.asize>CNINE_CONST_MEM_SIZE){
+	  cgcoeffsfC[cdev][ix]=-128;
+	  getfGptr(ix.l1,ix.l2,ix.l,cdev+1);
+	  continue;
+	}
+	int ix_entry[4];
+	ix_entry[0]=ix.l1;
+	ix_entry[1]=ix.l2;
+	ix_entry[2]=ix.l;
+	ix_entry[3]=cmem_data_tail[cdev];
+	CUDA_SAFE(cudaMemcpyToSymbol(cg_cmem,reinterpret_cast<void*>(ix_entry),
+	    4*sizeof(int),cmem_index_tail[cdev],cudaMemcpyHostToDevice));
+	cmem_index_tail[cdev]+=4*sizeof(int);
+	CUDA_SAFE(cudaMemcpyToSymbol(cg_cmem,reinterpret_cast<void*>(coeffs.arr),
+	    coeffs.asize*sizeof(float),cmem_data_tail[cdev],cudaMemcpyHostToDevice));
+	cgcoeffsfC[cdev][ix]=cmem_data_tail[cdev];
+	cmem_data_tail[cdev]+=sizeof(float)*coeffs.asize;
+      }
+    }
+#endif
 
 
 #ifdef _WITH_CUDA
@@ -181,6 +382,86 @@ namespace GElib{
     */
 #endif 
 
+  private: // ---- On-disk cache ----------------------------------------------------------------------------
+
+
+    // File layout: 8 byte magic "GELIBCGC", uint32 version, then a
+    // sequence of records (int32 l1,l2,l,type; int64 nbytes; raw table
+    // data), type 0 for float and 1 for double. Unknown versions are
+    // ignored wholesale so stale caches degrade to cold starts.
+    void probe_disk_cache(){
+      if(disk_cache_probed) return;
+      disk_cache_probed=true;
+#ifdef __unix__
+      const char* path=getenv("GELIB_CG_CACHE");
+      if(!path) return;
+      int fd=open(path,O_RDONLY);
+      if(fd<0) return;
+      struct stat st;
+      if(fstat(fd,&st)<0 || st.st_size<12){close(fd); return;}
+      void* map=mmap(nullptr,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+      close(fd);
+      if(map==MAP_FAILED) return;
+      const char* p=static_cast<const char*>(map);
+      uint32_t version; std::memcpy(&version,p+8,4);
+      if(std::memcmp(p,"GELIBCGC",8)!=0 || version!=1){munmap(map,st.st_size); return;}
+      disk_map=p;
+      disk_map_size=st.st_size;
+      size_t offs=12;
+      while(offs+24<=disk_map_size){
+	int32_t l1,l2,l,type; int64_t nbytes;
+	std::memcpy(&l1,p+offs,4);
+	std::memcpy(&l2,p+offs+4,4);
+	std::memcpy(&l,p+offs+8,4);
+	std::memcpy(&type,p+offs+12,4);
+	std::memcpy(&nbytes,p+offs+16,8);
+	if(offs+24+nbytes>disk_map_size) break;
+	if(type==0) diskf.emplace(CGindex(l1,l2,l),make_pair(p+offs+24,(int)nbytes));
+	if(type==1) diskd.emplace(CGindex(l1,l2,l),make_pair(p+offs+24,(int)nbytes));
+	offs+=24+nbytes;
+      }
+#endif
+    }
+
+    template<class TYPE>
+    SO3_CGcoeffs<TYPE>* from_disk(const CGindex& ix, const unordered_map<CGindex,pair<const char*,int> >& cache){
+      probe_disk_cache();
+      auto it=cache.find(ix);
+      if(it==cache.end()) return nullptr;
+      const int asize=(2*ix.l1+1)*(2*ix.l2+1);
+      if(it->second.second!=(int)(asize*sizeof(TYPE))) return nullptr;
+      cnine::Gtensor<TYPE> T({2*ix.l1+1,2*ix.l2+1},cnine::fill::raw,0);
+      std::memcpy(T.arr,it->second.first,asize*sizeof(TYPE));
+      return new SO3_CGcoeffs<TYPE>(std::move(T),ix.l,ix.l1,ix.l2);
+    }
+
+    void append_to_disk(const CGindex& ix, const int type, const char* data, const size_t nbytes){
+#ifdef __unix__
+      const char* path=getenv("GELIB_CG_CACHE");
+      if(!path) return;
+      bool fresh=true;
+      {
+	std::ifstream probe(path,std::ios::binary|std::ios::ate);
+	fresh=(!probe.good() || probe.tellg()<(std::streamoff)12);
+      }
+      std::ofstream out(path,std::ios::binary|std::ios::app);
+      if(!out.good()) return;
+      if(fresh){
+	const uint32_t version=1;
+	out.write("GELIBCGC",8);
+	out.write(reinterpret_cast<const char*>(&version),4);
+      }
+      int32_t rec[4]={(int32_t)ix.l1,(int32_t)ix.l2,(int32_t)ix.l,(int32_t)type};
+      int64_t n=nbytes;
+      out.write(reinterpret_cast<const char*>(rec),16);
+      out.write(reinterpret_cast<const char*>(&n),8);
+      out.write(data,nbytes);
+#endif
+    }
+
+
+  public:
+
     template<class TYPE>
     const SO3_CGcoeffs<TYPE>& get(const int l1, const int l2, const int l);
 
@@ -209,6 +490,46 @@ namespace GElib{
   */
     
 
-} 
+}
+
+
+extern GElib::SO3_CGbank SO3_cgbank;
+
+namespace GElib{
+
+  // Thread-local flat pointer table in front of the global bank. A
+  // training step calls the same few shapes tens of millions of times,
+  // and even the shared-locked bank lookup costs a hash, a lock and a
+  // map probe per call. Since (l1,l2,l) is dense and bounded by the
+  // largest l a model uses, a (L+1)^3 array of pointers indexed directly
+  // by the triple resolves the steady-state lookup with a single
+  // predictable load -- no hashing, no tag comparison, no shared
+  // structure. The table is grown (geometrically, so growth is rare and
+  // amortized away) whenever a larger l than any seen before appears,
+  // and misses fall through to the bank as before. Entries are stable
+  // because the bank never frees tables.
+  template<typename TYPE>
+  inline const SO3_CGcoeffs<TYPE>& SO3_cgbank_cached(const CGindex& ix){
+    thread_local int L=-1;
+    thread_local vector<const SO3_CGcoeffs<TYPE>*> table;
+    const int m=std::max(std::max(ix.l1,ix.l2),ix.l);
+    if(m>L){
+      const int newL=std::max(2*L,m);
+      vector<const SO3_CGcoeffs<TYPE>*> newtable(((size_t)newL+1)*(newL+1)*(newL+1),nullptr);
+      for(int l1=0; l1<=L; l1++)
+	for(int l2=0; l2<=L; l2++)
+	  for(int l=0; l<=L; l++)
+	    newtable[((size_t)l1*(newL+1)+l2)*(newL+1)+l]=table[((size_t)l1*(L+1)+l2)*(L+1)+l];
+      table=std::move(newtable);
+      L=newL;
+    }
+    const SO3_CGcoeffs<TYPE>*& p=table[((size_t)ix.l1*(L+1)+ix.l2)*(L+1)+ix.l];
+    if(p) return *p;
+    if constexpr(std::is_same<TYPE,double>::value) p=&SO3_cgbank.getd(ix);
+    else p=&SO3_cgbank.getf(ix);
+    return *p;
+  }
+
+}
 
 #endif
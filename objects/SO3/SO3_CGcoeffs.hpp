@@ -14,8 +14,10 @@
 
 #include "SO3_CGindex.hpp" 
 #include "SO3_CGcoeffs.hpp" 
-#include "SO3_CGbank.hpp" 
+#include "SO3_CGbank.hpp"
 #include "Gtensor.hpp"
+#include "MultiLoop.hpp"
+#include "Factorial.hpp"
 
 #define _SO3_CGcoeff_TYPE double 
 
@@ -29,28 +31,68 @@ namespace GElib{
   //using Gtensor=cnine::Gtensor<TYPE>;
 
 
+  // A single nonzero Clebsch-Gordan coefficient together with its input
+  // and output m-indices, stored zero-based so that kernels can index
+  // straight into views without further shifting.
   template<class TYPE>
-  class SO3_CGcoeffs: public cnine::Gtensor<TYPE>{ 
+  struct SO3_CGnonzero{
+    int m1;
+    int m2;
+    int m;
+    TYPE c;
+  };
+
+
+  template<class TYPE>
+  class SO3_CGcoeffs: public cnine::Gtensor<TYPE>{
   public:
 
     template<class TYPE2>
     using Gtensor=cnine::Gtensor<TYPE2>;
 
-    using Gtensor<TYPE>::arr; 
-    using Gtensor<TYPE>::arrg; 
+    using Gtensor<TYPE>::arr;
+    using Gtensor<TYPE>::arrg;
 
     int l,l1,l2;
 
+    // Flat list of the nonzero entries of the dense table, in (m1,m2)
+    // lexicographic order. Built once at construction so that the hot
+    // kernels can run a single linear sweep instead of recomputing loop
+    // bounds and probing the dense table.
+    vector<SO3_CGnonzero<TYPE> > nonzeros;
+
+    // Packed device-upload form of the same list: one index word per
+    // nonzero with (m1,m2,m) in bits 16-23/8-15/0-7, parallel to a flat
+    // coefficient array. For high (l1,l2) and low l this is much smaller
+    // than the dense (2l1+1)(2l2+1) table.
+    vector<int32_t> packed_ix;
+    vector<TYPE> packed_c;
+
     SO3_CGcoeffs(const CGindex& ix):
-      Gtensor<TYPE>({2*ix.l1+1,2*ix.l2+1},cnine::fill::zero,0), 
+      Gtensor<TYPE>({2*ix.l1+1,2*ix.l2+1},cnine::fill::zero,0),
       l(ix.l), l1(ix.l1), l2(ix.l2){
-      for(int m1=-l1; m1<=l1; m1++)
-	for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++)
-	  this->element(m1,m2)=slowCG(m1,m2);
+      // Each entry is an independent closed-form sum, so the m1-columns
+      // of the few big tables that dominate cold start (l1,l2 in the
+      // thirties take seconds single-threaded) are filled in parallel;
+      // small tables stay serial to avoid the dispatch overhead.
+      if((2*l1+1)*(2*l2+1)>=1024){
+	cnine::MultiLoop(2*l1+1,[&](const int i){
+	    const int m1=i-l1;
+	    for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++)
+	      this->element(m1,m2)=slowCG(m1,m2);
+	  });
+      }else{
+	for(int m1=-l1; m1<=l1; m1++)
+	  for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++)
+	    this->element(m1,m2)=slowCG(m1,m2);
+      }
+      make_nonzeros();
     }
 
-    SO3_CGcoeffs(Gtensor<TYPE>&& T, const int _l, const int _l1, const int _l2): 
-      Gtensor<TYPE>(std::move(T)), l(_l), l1(_l1), l2(_l2){}
+    SO3_CGcoeffs(Gtensor<TYPE>&& T, const int _l, const int _l1, const int _l2):
+      Gtensor<TYPE>(std::move(T)), l(_l), l1(_l1), l2(_l2){
+      make_nonzeros();
+    }
     
     ~SO3_CGcoeffs(){
     }
@@ -58,8 +100,9 @@ namespace GElib{
 
   public:
     
-    SO3_CGcoeffs(const SO3_CGcoeffs<TYPE>&  x): 
-      cnine::Gtensor<TYPE>(x,cnine::nowarn), l(x.l), l1(x.l1), l2(x.l2){};
+    SO3_CGcoeffs(const SO3_CGcoeffs<TYPE>&  x):
+      cnine::Gtensor<TYPE>(x,cnine::nowarn), l(x.l), l1(x.l1), l2(x.l2),
+      nonzeros(x.nonzeros), packed_ix(x.packed_ix), packed_c(x.packed_c){};
 
     SO3_CGcoeffs& operator=(const SO3_CGcoeffs<TYPE>& x)=delete;
     
@@ -72,8 +115,24 @@ namespace GElib{
 
   private:
 
+    void make_nonzeros(){
+      nonzeros.clear();
+      packed_ix.clear();
+      packed_c.clear();
+      for(int m1=-l1; m1<=l1; m1++)
+	for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++){
+	  const TYPE c=this->element(m1,m2);
+	  if(c!=TYPE(0)){
+	    nonzeros.push_back(SO3_CGnonzero<TYPE>{m1+l1,m2+l2,m1+m2+l,c});
+	    packed_ix.push_back(((m1+l1)<<16)|((m2+l2)<<8)|(m1+m2+l));
+	    packed_c.push_back(c);
+	  }
+	}
+    }
+
+    // Constexpr table lookup; lgamma only beyond GELIB_LOGFACT_MAXL.
     double logfact(double n){
-      return lgamma(n+1);
+      return GElib::logfact((int)n);
     }
     
     _SO3_CGcoeff_TYPE plusminus(int k){ if(k%2==1) return -1; else return +1; }
@@ -91,7 +150,7 @@ namespace GElib{
       int tmin=std::max(0,std::max(t1,t2));
       int tmax=std::min(t3,std::min(t4,t5));
 
-      _SO3_CGcoeff_TYPE logA=(logfact(l1+l2-l)+logfact(l1-l2+l)+logfact(-l1+l2+l)-logfact(l1+l2+l+1))/2;
+      _SO3_CGcoeff_TYPE logA=logtriangle(l1,l2,l);
       logA+=(logfact(l1+m1)+logfact(l1-m1)+logfact(l2+m2)+logfact(l2-m2)+logfact(l+m3)+logfact(l-m3))/2;
 
       _SO3_CGcoeff_TYPE wigner=0;
@@ -1,7 +1,7 @@
 
 // This file is part of GElib, a C++/CUDA library for group
-// equivariant tensor operations. 
-// 
+// equivariant tensor operations.
+//
 // Copyright (c) 2021, Imre Risi Kondor and Erik H Thiede
 //
 // This Source Code Form is subject to the terms of the Mozilla
@@ -12,6 +12,8 @@
 #ifndef _SO3_SPHgen
 #define _SO3_SPHgen
 
+#include <atomic>
+
 #include "Gtensor.hpp"
 
 
@@ -24,68 +26,161 @@ namespace GElib{
     template<class TYPE2>
     using Gtensor=cnine::Gtensor<TYPE2>;
 
-    int L;
-    Gtensor<float> c1;
-    Gtensor<float> c2;
-    mutex mx;
+    // The recurrence coefficients are published as immutable
+    // snapshots: extend() builds a larger table, publishes it with a
+    // release store and retains the superseded one for the lifetime of
+    // the generator, so a snapshot a reader has obtained can never be
+    // mutated or freed under it. The read path is a single acquire
+    // load with no lock; the mutex only serializes writers. Before
+    // this, even cached evaluations took the lock, which serialized
+    // multi-threaded spherical harmonic featurization.
+
+    class snapshot{
+    public:
+      int L;
+      Gtensor<float> c1;
+      Gtensor<float> c2;
+
+      snapshot(const int _L):
+	L(_L), c1({_L+1,_L+1},cnine::fill::zero), c2({_L+1,_L+1},cnine::fill::zero){}
+    };
+
+
+  private:
+
+    std::atomic<snapshot*> current;
+    mutex mx; // serializes extend() only
+    vector<snapshot*> retired;
+
+
+  public:
+
+    SO3_SPHgen(){
+      current.store(new snapshot(0));
+    }
+
+    SO3_SPHgen(const SO3_SPHgen& x)=delete;
+    SO3_SPHgen& operator=(const SO3_SPHgen& x)=delete;
+
+    ~SO3_SPHgen(){
+      delete current.load();
+      for(auto p:retired) delete p;
+    }
+
 
-    
-    SO3_SPHgen(): L(0), c1({1,1},cnine::fill::zero), c2({1,1},cnine::fill::zero){}
+  public: // ---- Access -------------------------------------------------------------------------------------
+
+
+    int get_L() const{
+      return current.load(std::memory_order_acquire)->L;
+    }
+
+    // Returns a snapshot covering at least _L, extending the tables if
+    // necessary. Wait-free once the tables cover _L.
+    snapshot& ensure(const int _L){
+      snapshot* s=current.load(std::memory_order_acquire);
+      if(s->L>=_L) return *s;
+      return extend(_L);
+    }
+
+
+  public: // ---- Evaluation ---------------------------------------------------------------------------------
 
 
     Gtensor<float> operator()(const int _L, const float x){
-      lock_guard<mutex> lock(mx);
-      if(_L>L) extend(_L);
+      snapshot& S=ensure(_L);
 
       Gtensor<float> R({_L+1,_L+1},cnine::fill::raw);
       R(0,0)=sqrt(1.0/(M_PI*4.0));
       float xfact=sqrt((1.0-x)*(1.0+x));
-      
+
       for(int l=1; l<=_L; l++){
-	R(l,l)=c1(l,l)*R(l-1,l-1)*xfact;
-	R(l,l-1)=c1(l,l-1)*R(l-1,l-1)*x;
+	R(l,l)=S.c1(l,l)*R(l-1,l-1)*xfact;
+	R(l,l-1)=S.c1(l,l-1)*R(l-1,l-1)*x;
 	for(int m=0; m<l-1; m++)
-	  R(l,m)=c1(l,m)*R(l-1,m)*x+c2(l,m)*R(l-2,m);
+	  R(l,m)=S.c1(l,m)*R(l-1,m)*x+S.c2(l,m)*R(l-2,m);
       }
 
-      return R; 
+      return R;
    }
 
 
+    // Batched evaluation: computes the harmonics for N points at once,
+    // writing into caller-provided storage R of size (_L+1)*(_L+1)*N
+    // laid out as R[(l*(_L+1)+m)*N+n], i.e. with the point index
+    // innermost so the recurrence runs contiguously across points and
+    // vectorizes. No allocation or locking per call; a featurizer
+    // evaluating millions of points per step should prefer this over
+    // the scalar operator() above.
+    void operator()(const int _L, const int N, const float* x, float* R){
+      snapshot& S=ensure(_L);
+      const int stride=_L+1;
+
+      vector<float> xfact(N);
+      for(int n=0; n<N; n++)
+	xfact[n]=sqrt((1.0-x[n])*(1.0+x[n]));
+
+      const float r00=sqrt(1.0/(M_PI*4.0));
+      for(int n=0; n<N; n++)
+	R[n]=r00;
+
+      for(int l=1; l<=_L; l++){
+	const float* Rp=R+((l-1)*stride+l-1)*N;
+	float* Rll=R+(l*stride+l)*N;
+	float* Rlm=R+(l*stride+l-1)*N;
+	const float a=S.c1(l,l);
+	const float b=S.c1(l,l-1);
+	for(int n=0; n<N; n++)
+	  Rll[n]=a*Rp[n]*xfact[n];
+	for(int n=0; n<N; n++)
+	  Rlm[n]=b*Rp[n]*x[n];
+	for(int m=0; m<l-1; m++){
+	  const float u=S.c1(l,m);
+	  const float v=S.c2(l,m);
+	  const float* R1=R+((l-1)*stride+m)*N;
+	  const float* R2=R+((l-2)*stride+m)*N;
+	  float* Rt=R+(l*stride+m)*N;
+	  for(int n=0; n<N; n++)
+	    Rt[n]=u*R1[n]*x[n]+v*R2[n];
+	}
+      }
+    }
+
+
   private:
 
-    void extend(const int _L){
-
-      Gtensor<float> newc1({_L+1,_L+1},cnine::fill::zero);
-      for(int i=0; i<=L; i++)
-	for(int j=0; j<=L; j++)
-	  newc1(i,j)=c1(i,j);
-      c1=move(newc1);
-	
-      Gtensor<float> newc2({_L+1,_L+1},cnine::fill::zero);
-      for(int i=0; i<=L; i++)
-	for(int j=0; j<=L; j++)
-	  newc2(i,j)=c2(i,j);
-      c2=move(newc2);
-
-      for(int l=L+1; l<=_L; l++)
-	//c1(l,l)=-sqrt(((float)(2.0*l+1))/(2.0*l-1))*sqrt(((float)(2*l-2+(l==1)))/(2*l))*(2.0*l-1);
-	c1(l,l)=-sqrt(((float)(2.0*l+1))/(2.0*l-1))*sqrt(1.0/(2.0*l)/(2.0*l-1))*(2.0*l-1);
-      
-      for(int l=L+1; l<=_L; l++)
+    snapshot& extend(const int _L){
+      lock_guard<mutex> lock(mx);
+      snapshot* old=current.load(std::memory_order_relaxed);
+      if(old->L>=_L) return *old; // another writer got there first
+
+      snapshot* S=new snapshot(_L);
+      for(int i=0; i<=old->L; i++)
+	for(int j=0; j<=old->L; j++){
+	  S->c1(i,j)=old->c1(i,j);
+	  S->c2(i,j)=old->c2(i,j);
+	}
+
+      for(int l=old->L+1; l<=_L; l++)
+	//S->c1(l,l)=-sqrt(((float)(2.0*l+1))/(2.0*l-1))*sqrt(((float)(2*l-2+(l==1)))/(2*l))*(2.0*l-1);
+	S->c1(l,l)=-sqrt(((float)(2.0*l+1))/(2.0*l-1))*sqrt(1.0/(2.0*l)/(2.0*l-1))*(2.0*l-1);
+
+      for(int l=old->L+1; l<=_L; l++)
 	for(int m=0; m<l; m++){
 	  float prefact0=sqrt(((float)(2.0*l+1))/(2.0*l-1));
 	  //float prefact1=sqrt(((float)(l-m)!)/(l-m-1.0+(l-m==1)!))*sqrt(((float)(l+m-1.0+(l+m==1)))/(l+m));
 	  float prefact1=sqrt((float)(l-m))*sqrt(1.0/(l+m));
-	  c1(l,m)=prefact0*prefact1*(2.0*l-1)/(l-m);
+	  S->c1(l,m)=prefact0*prefact1*(2.0*l-1)/(l-m);
 	  if(m<l-1){
 	    float prefact0b=sqrt(((float)(2.0*l+1))/(2.0*l-3));
 	    float prefact2=sqrt((float)(l-m)*(l-m-1))*sqrt(1.0/((l+m)*(l+m-1.0)));
-	    c2(l,m)=-prefact0b*prefact2*((float)(l+m-1.0))/(l-m);
+	    S->c2(l,m)=-prefact0b*prefact2*((float)(l+m-1.0))/(l-m);
 	  }
 	}
 
-      L=_L;
+      retired.push_back(old);
+      current.store(S,std::memory_order_release);
+      return *S;
     }
 
 
@@ -1,15 +1,15 @@
 /*
  * This file is part of GElib, a C++/CUDA library for group
- * equivariant tensor operations. 
- * This file is part of cnine, a lightweight C++ tensor library. 
- *  
+ * equivariant tensor operations.
+ * This file is part of cnine, a lightweight C++ tensor library.
+ *
  * Copyright (c) 2023, Imre Risi Kondor
  *
- * This source code file is subject to the terms of the noncommercial 
- * license distributed with cnine in the file LICENSE.TXT. Commercial 
- * use is prohibited. All redistributed versions of this file (in 
- * original or modified form) must retain this copyright notice and 
- * must be accompanied by a verbatim copy of the license. 
+ * This source code file is subject to the terms of the noncommercial
+ * license distributed with cnine in the file LICENSE.TXT. Commercial
+ * use is prohibited. All redistributed versions of this file (in
+ * original or modified form) must retain this copyright notice and
+ * must be accompanied by a verbatim copy of the license.
  *
  */
 
@@ -17,24 +17,150 @@
 #ifndef _SO3_SphCoeffs
 #define _SO3_SphCoeffs
 
-#include "Rtensor.hpp"
+#include <fstream>
+#include <cstring>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "Gtensor.hpp"
+#include "GElibThreadPool.hpp"
 
 
 namespace GElib{
 
+  // Precomputed spherical harmonic recurrence coefficients: the same
+  // c1/c2 tables SO3_SPHgen builds lazily, held as one contiguous
+  // block with a binary on-disk form. Unlike the generator's
+  // incremental extend(), precompute() fills each l row from the
+  // closed-form prefactors independently, so the rows are distributed
+  // over the thread pool; load() maps a previously saved file, so jobs
+  // with large maxl start from the serialized table instead of
+  // regenerating it per process. GElibSession loads and re-records the
+  // file named by GELIB_SPH_CACHE, following the GELIB_CG_CACHE
+  // pattern.
+  //
+  // File layout: 8 byte magic "GELIBSPH", uint32 version, int32 L,
+  // then 2*(L+1)*(L+1) raw floats (the c1 plane followed by the c2
+  // plane). Unknown versions are ignored so stale caches degrade to
+  // cold starts.
 
-  class SO3_SPHgen{
+  class SO3_SphCoeffs{
   public:
 
-    using rtensor=cnine::RtensorA;
+    template<class TYPE2>
+    using Gtensor=cnine::Gtensor<TYPE2>;
+
+    int L=-1;
+    int loaded_L=-1;
+    Gtensor<float> coeffs;
+
+    SO3_SphCoeffs(){}
+
+
+  public: // ---- Access -------------------------------------------------------------------------------------
+
+
+    float c1(const int l, const int m) const{
+      return coeffs(0,l,m);
+    }
+
+    float c2(const int l, const int m) const{
+      return coeffs(1,l,m);
+    }
+
+
+  public: // ---- Precompute ---------------------------------------------------------------------------------
+
 
-    RtensorA coeffs;
+    void precompute(const int maxl){
+      if(maxl<=L) return;
+      Gtensor<float> T({2,maxl+1,maxl+1},cnine::fill::zero);
 
-    SO3_SPHgen(){
+      GElibMultiLoop(maxl+1,[&](const int l){
+	  if(l==0) return;
+	  T(0,l,l)=-sqrt(((float)(2.0*l+1))/(2.0*l-1))*sqrt(1.0/(2.0*l)/(2.0*l-1))*(2.0*l-1);
+	  for(int m=0; m<l; m++){
+	    float prefact0=sqrt(((float)(2.0*l+1))/(2.0*l-1));
+	    float prefact1=sqrt((float)(l-m))*sqrt(1.0/(l+m));
+	    T(0,l,m)=prefact0*prefact1*(2.0*l-1)/(l-m);
+	    if(m<l-1){
+	      float prefact0b=sqrt(((float)(2.0*l+1))/(2.0*l-3));
+	      float prefact2=sqrt((float)(l-m)*(l-m-1))*sqrt(1.0/((l+m)*(l+m-1.0)));
+	      T(1,l,m)=-prefact0b*prefact2*((float)(l+m-1.0))/(l-m);
+	    }
+	  }
+	});
+
+      coeffs=std::move(T);
+      L=maxl;
     }
 
 
+  public: // ---- I/O ----------------------------------------------------------------------------------------
+
+
+    bool load(const string& path){
+#ifdef __unix__
+      int fd=open(path.c_str(),O_RDONLY);
+      if(fd<0) return false;
+      struct stat st;
+      if(fstat(fd,&st)<0 || st.st_size<16){close(fd); return false;}
+      void* map=mmap(nullptr,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+      close(fd);
+      if(map==MAP_FAILED) return false;
+      const char* p=static_cast<const char*>(map);
+
+      uint32_t version; std::memcpy(&version,p+8,4);
+      int32_t _L; std::memcpy(&_L,p+12,4);
+      const size_t nbytes=2*((size_t)(_L+1))*(_L+1)*sizeof(float);
+      if(std::memcmp(p,"GELIBSPH",8)!=0 || version!=1 || _L<0 ||
+	(size_t)st.st_size<16+nbytes){
+	munmap(map,st.st_size);
+	return false;
+      }
+
+      Gtensor<float> T({2,_L+1,_L+1},cnine::fill::raw);
+      std::memcpy(T.arr,p+16,nbytes);
+      munmap(map,st.st_size);
+
+      coeffs=std::move(T);
+      L=_L;
+      loaded_L=_L;
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    void save(const string& path) const{
+      if(L<0) return;
+      std::ofstream out(path,std::ios::binary|std::ios::trunc);
+      if(!out.good()) return;
+      const uint32_t version=1;
+      const int32_t _L=L;
+      out.write("GELIBSPH",8);
+      out.write(reinterpret_cast<const char*>(&version),4);
+      out.write(reinterpret_cast<const char*>(&_L),4);
+      out.write(reinterpret_cast<const char*>(coeffs.arr),2*((size_t)(L+1))*(L+1)*sizeof(float));
+    }
+
+    // True if precompute() has taken the tables past what load() saw,
+    // i.e. the on-disk cache is worth rewriting.
+    bool dirty() const{
+      return L>loaded_L;
+    }
+
   };
 
 }
 
+
+extern GElib::SO3_SphCoeffs SO3_sphCoeffs;
+
+
+#endif
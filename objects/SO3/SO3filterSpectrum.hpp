@@ -0,0 +1,114 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3filterSpectrum
+#define _SO3filterSpectrum
+
+#include "GElib_base.hpp"
+#include "CtensorB.hpp"
+#include "Ctensor4_view.hpp"
+#include "SO3FFTPlan.hpp"
+
+
+namespace GElib{
+
+  // Version-tagged spectrum cache for fixed convolution filters. At
+  // inference time the filter grids never change, yet the spectral
+  // pipeline recomputed their SO(3) Fourier transform every batch --
+  // one of the three transforms of every conv layer. An
+  // SO3filterSpectrum owns the filter's grid samples together with the
+  // per-l Fourier blocks computed from them; the blocks are computed
+  // lazily through the layer's SO3FFTPlan on first use and reused
+  // until the grid is mutated. All mutation goes through grid() /
+  // set_grid(), which bump the version tag and invalidate the cache,
+  // so a training loop that updates its filters stays correct while
+  // steady-state inference pays for the filter transform exactly once.
+
+  class SO3filterSpectrum{
+  public:
+
+    typedef cnine::CtensorB Ctensor;
+
+    int maxl;
+
+    SO3filterSpectrum(const Ctensor& _G, const int _maxl): maxl(_maxl), G(_G){}
+
+    SO3filterSpectrum(const SO3filterSpectrum& x)=delete;
+    SO3filterSpectrum& operator=(const SO3filterSpectrum& x)=delete;
+
+    ~SO3filterSpectrum(){
+      purge();
+    }
+
+
+  public: // ---- Access -------------------------------------------------------------------------------------
+
+
+    // Read access to the (b,Nphi,Ntheta,Npsi) grid samples.
+    const Ctensor& grid() const{
+      return G;
+    }
+
+    // Mutable access bumps the version tag, invalidating the cached
+    // spectrum; so does replacing the grid wholesale.
+    Ctensor& grid(){
+      version++;
+      return G;
+    }
+
+    void set_grid(const Ctensor& _G){
+      G=_G;
+      version++;
+    }
+
+    int get_version() const{
+      return version;
+    }
+
+
+  public: // ---- Spectrum -----------------------------------------------------------------------------------
+
+
+    // The filter's per-l Fourier blocks, transformed through the
+    // caller's plan on the first call after any mutation and served
+    // from the cache afterwards. The plan carries the transform's
+    // shape signature, so no separate shape state is kept here; like
+    // the plan itself this object is owned by one layer and is not
+    // thread-safe.
+    const vector<Ctensor*>& spectrum(SO3FFTPlan& plan){
+      if(cached_version!=version){
+	purge();
+	for(int l=0; l<=maxl; l++){
+	  blocks.push_back(new Ctensor(Ctensor::zero(cnine::Gdims(plan.b,2*l+1,2*l+1),plan.dev)));
+	  plan.execute(blocks[l]->view3(),G.view4());
+	}
+	cached_version=version;
+      }
+      return blocks;
+    }
+
+
+  private:
+
+    Ctensor G;
+    int version=0;
+    int cached_version=-1;
+    vector<Ctensor*> blocks;
+
+    void purge(){
+      for(auto p:blocks) delete p;
+      blocks.clear();
+    }
+
+  };
+
+}
+
+#endif
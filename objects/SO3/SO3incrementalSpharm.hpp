@@ -0,0 +1,178 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3incrementalSpharm
+#define _SO3incrementalSpharm
+
+#include "GElib_base.hpp"
+#include "SO3partB.hpp"
+#include "GElibThreadPool.hpp"
+
+#include <atomic>
+
+extern GElib::SO3_SPHgen SO3_sphGen;
+
+
+namespace GElib{
+
+  // Incremental spherical harmonics for time-coherent point sets. In
+  // MD-coupled inference the positions fed to add_spharm move only
+  // slightly between steps, yet the harmonics are recomputed from
+  // scratch for every point every time. This object keeps the last
+  // positions and the last computed (b,2l+1,n) part; on each call it
+  // recomputes only the columns whose displacement since their last
+  // refresh exceeds the tolerance and reuses the cached values for the
+  // rest, so with typical MD step sizes most points skip the
+  // associated-Legendre evaluation entirely. The refresh pass runs in
+  // parallel over the batch dimension. Host-side only: on the device
+  // the full recompute is a single batched kernel and the
+  // cache-management traffic would cost more than it saves.
+  //
+  // The tolerance is a bound on the POSITION displacement, so the
+  // error it admits in the harmonics scales with l; callers working at
+  // high l should tighten it accordingly (or set it to 0 to make the
+  // cache exact for unchanged points only).
+
+  class SO3incrementalSpharm{
+  private:
+
+    int l;
+    float tol2;
+
+    int B=0;
+    int n=0;
+    bool primed=false;
+
+    vector<float> pos;   // positions at last refresh, (B,3,n) flattened
+    SO3partB* cache=nullptr;
+
+    int n_refreshed=0;   // columns recomputed by the last call
+
+
+  public:
+
+    SO3incrementalSpharm(const int _l, const float tol):
+      l(_l), tol2(tol*tol){}
+
+    ~SO3incrementalSpharm(){
+      delete cache;
+    }
+
+    SO3incrementalSpharm(const SO3incrementalSpharm& x)=delete;
+    SO3incrementalSpharm& operator=(const SO3incrementalSpharm& x)=delete;
+
+
+  public: // ---- Access -------------------------------------------------------------------------------------
+
+
+    int getl() const{
+      return l;
+    }
+
+    // Number of columns recomputed by the most recent call.
+    int refreshed() const{
+      return n_refreshed;
+    }
+
+
+  public: // ---- Operations ---------------------------------------------------------------------------------
+
+
+    // Returns Y^l of every point in x ((B,3,n), host). The first call
+    // computes everything; subsequent calls with the same shape only
+    // refresh the columns that moved more than the tolerance.
+    const SO3partB& operator()(const cnine::RtensorA& x){
+      GELIB_ASSRT(x.get_dev()==0);
+      GELIB_ASSRT(x.dims.size()==3);
+      GELIB_ASSRT(x.dims[1]==3);
+
+      if(!primed || x.dims[0]!=B || x.dims[2]!=n){
+	B=x.dims[0];
+	n=x.dims[2];
+	pos.resize(B*3*n);
+	delete cache;
+	cache=new SO3partB(SO3partB::zero(B,l,n,0));
+	auto v=cache->view3();
+	GElibMultiLoop(B,[&](const int b){
+	    for(int j=0; j<n; j++)
+	      refresh_column(v,x,b,j);
+	  });
+	n_refreshed=B*n;
+	primed=true;
+	return *cache;
+      }
+
+      std::atomic<int> nref(0);
+      auto v=cache->view3();
+      GElibMultiLoop(B,[&](const int b){
+	  int local=0;
+	  for(int j=0; j<n; j++){
+	    const float dx=x(b,0,j)-pos[(b*3)*n+j];
+	    const float dy=x(b,1,j)-pos[(b*3+1)*n+j];
+	    const float dz=x(b,2,j)-pos[(b*3+2)*n+j];
+	    if(dx*dx+dy*dy+dz*dz<=tol2) continue;
+	    for(int m=0; m<2*l+1; m++)
+	      v.set(b,m,j,complex<float>(0,0));
+	    refresh_column(v,x,b,j);
+	    local++;
+	  }
+	  nref+=local;
+	});
+      n_refreshed=nref;
+      return *cache;
+    }
+
+    // Drop all cached state; the next call recomputes everything.
+    void invalidate(){
+      primed=false;
+    }
+
+
+  private:
+
+    // Full evaluation of one point's column, same math as
+    // SO3part_addSpharmFn, and records its position as the new
+    // reference for the displacement test.
+    void refresh_column(cnine::Ctensor3_view& v, const cnine::RtensorA& x, const int b, const int j){
+      const float vx=x(b,0,j);
+      const float vy=x(b,1,j);
+      const float vz=x(b,2,j);
+      pos[(b*3)*n+j]=vx;
+      pos[(b*3+1)*n+j]=vy;
+      pos[(b*3+2)*n+j]=vz;
+
+      const float length=sqrt(vx*vx+vy*vy+vz*vz);
+      const float len2=sqrt(vx*vx+vy*vy);
+
+      if(len2==0 || std::isnan(vx/len2) || std::isnan(vy/len2)){
+	v.inc(b,l,j,sqrt(((float)(2*l+1))/(M_PI*4.0)));
+	return;
+      }
+
+      complex<float> cphi(vx/len2,vy/len2);
+      cnine::Gtensor<float> P=SO3_sphGen(l,vz/length);
+      vector<complex<float> > phase(l+1);
+      phase[0]=complex<float>(1.0,0);
+      for(int m=1; m<=l; m++)
+	phase[m]=cphi*phase[m-1];
+
+      for(int m=0; m<=l; m++){
+	complex<float> a=phase[m]*complex<float>(P(l,m));
+	complex<float> aa=complex<float>(1-2*(m%2))*std::conj(a);
+	v.inc(b,l+m,j,a);
+	if(m>0) v.inc(b,l-m,j,aa);
+      }
+    }
+
+  };
+
+}
+
+#endif
@@ -1,6 +1,6 @@
 // This file is part of GElib, a C++/CUDA library for group
-// equivariant tensor operations. 
-// 
+// equivariant tensor operations.
+//
 // Copyright (c) 2021, Imre Risi Kondor and Erik H Thiede
 //
 // This Source Code Form is subject to the terms of the Mozilla
@@ -15,23 +15,73 @@
 #include "CtensorB.hpp"
 #include "SO3element.hpp"
 #include "WignerMatrix.hpp"
+#include "WignerBank.hpp"
+#include "SO3part_addRotateFn.hpp"
 
 
 namespace GElib{
 
+  // Action of the l'th irrep on stacks of fragments. A fragment stack
+  // is a (B,2l+1,n) tensor (B parts of n channels each, or a single
+  // part as the 2D special case); apply() left-multiplies every slice
+  // by the Wigner matrix D^l(r). The matrices come from SO3_wignerBank
+  // so repeated elements cost one construction, and the application
+  // itself is SO3part_addRotateFn -- on the device a single
+  // strided-batched GEMM over the whole stack, which is what the
+  // equivariance-testing and canonicalization loops need instead of a
+  // per-part host loop.
+
   class SO3irrepAction{
   public:
 
     int l;
-    
+
     SO3irrepAction(const int _l):
       l(_l){}
 
-    CtensorB operator(const CtensorB& x, const SO3element& r, const int d=0){
-      inte dev=x.dev;
-      CtensorB D(WignerMatrix<float>(getl(),r),dev);
-      CtensorB R=CtensorB::zeros_like(x);
-      R.add_matmul(x,D,d);
+
+    // One group element applied to every slice of the stack.
+    cnine::CtensorB apply(const cnine::CtensorB& x, const SO3element& r) const{
+      GELIB_ASSRT(x.dims.size()==3);
+      GELIB_ASSRT(x.dims(1)==2*l+1);
+      const cnine::CtensorB& D=SO3_wignerBank(l,r,x.dev);
+      cnine::CtensorB R=cnine::CtensorB::zeros_like(x);
+      SO3part_addRotateFn()(R.view3(),x.view3(),const_cast<cnine::CtensorB&>(D).view2());
+      return R;
+    }
+
+    // One group element per slice: slice b is acted on by rs[b]. The
+    // slices with the same element are grouped per call site upstream
+    // when that matters; here each runs as a one-slice instance of the
+    // same GEMM against its bank-resident matrix.
+    cnine::CtensorB apply(const cnine::CtensorB& x, const vector<SO3element>& rs) const{
+      GELIB_ASSRT(x.dims.size()==3);
+      GELIB_ASSRT(x.dims(1)==2*l+1);
+      GELIB_ASSRT((int)rs.size()==x.dims(0));
+      cnine::CtensorB R=cnine::CtensorB::zeros_like(x);
+      cnine::Ctensor3_view xv=x.view3();
+      cnine::Ctensor3_view rv=R.view3();
+      for(int b=0; b<xv.n0; b++){
+	const cnine::CtensorB& D=SO3_wignerBank(l,rs[b],x.dev);
+	cnine::Ctensor3_view xb=xv; xb.n0=1; xb.arr+=b*xv.s0; xb.arrc+=b*xv.s0;
+	cnine::Ctensor3_view rb=rv; rb.n0=1; rb.arr+=b*rv.s0; rb.arrc+=b*rv.s0;
+	SO3part_addRotateFn()(rb,xb,const_cast<cnine::CtensorB&>(D).view2());
+      }
+      return R;
+    }
+
+    // Single-part convenience.
+    cnine::CtensorB operator()(const cnine::CtensorB& x, const SO3element& r) const{
+      if(x.dims.size()==3) return apply(x,r);
+      GELIB_ASSRT(x.dims.size()==2);
+      GELIB_ASSRT(x.dims(0)==2*l+1);
+      const cnine::CtensorB& D=SO3_wignerBank(l,r,x.dev);
+      cnine::CtensorB R=cnine::CtensorB::zeros_like(x);
+      cnine::Ctensor2_view rv=R.view2();
+      cnine::Ctensor3_view r3(rv.arr,rv.arrc,1,rv.n0,rv.n1,0,rv.s0,rv.s1,rv.dev);
+      cnine::Ctensor2_view xv=const_cast<cnine::CtensorB&>(x).view2();
+      cnine::Ctensor3_view x3(xv.arr,xv.arrc,1,xv.n0,xv.n1,0,xv.s0,xv.s1,xv.dev);
+      SO3part_addRotateFn()(r3,x3,const_cast<cnine::CtensorB&>(D).view2());
       return R;
     }
 
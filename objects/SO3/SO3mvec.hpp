@@ -14,6 +14,8 @@
 #include "GElib_base.hpp"
 #include "SO3vecB_array.hpp"
 #include "CtensorEinsumFn.hpp"
+#include "SO3mvec_addMprodFn.hpp"
+#include "SO3mvec_addMprod_backFn.hpp"
 #include "FakeGrad.hpp"
 
 namespace GElib{
@@ -187,15 +189,30 @@ public: // ---- Views ----------------------------------------------------------
     }
 
 
+    // The per-l products below are grouped batched GEMMs (see
+    // SO3mvec_addMprodFn): the fused (batch,m) rows of each part are
+    // applied in one sweep rather than as a per-m loop of small matrix
+    // products, and on the device each m slot is a single
+    // strided-batched SGEMM over the whole sample dimension. On GPU
+    // builds without cuBLAS the per-l einsum path is kept as the
+    // fallback.
+
     void add_mprod(const SO3mvec& x, const cnine::CtensorPackObj& y){
       CNINE_DEVICE_SAMEB(x);
       CNINE_DEVICE_SAMEB(y);
       assert(x.getk()==getk());
       assert(x.parts.size()==y.tensors.size());
       assert(x.parts.size()<=parts.size());
-      cnine::CtensorEinsumFn<float> fn("adbi,dic->adbc");
+      #if defined(_WITH_CUDA) && !defined(_WITH_CUBLAS)
+      if(get_dev()>0){
+	cnine::CtensorEinsumFn<float> fn("adbi,dic->adbc");
+	for(int l=0; l<x.parts.size(); l++)
+	  fn(parts[l]->viewx(),x.parts[l]->viewx(),y.tensors[l]->viewx());
+	return;
+      }
+      #endif
       for(int l=0; l<x.parts.size(); l++)
-	fn(parts[l]->viewx(),x.parts[l]->viewx(),y.tensors[l]->viewx());
+	SO3mvec_addMprodFn()(parts[l]->part3_view(),x.parts[l]->part3_view(),y.tensors[l]->view3(),getk());
     }
 
 
@@ -204,9 +221,16 @@ public: // ---- Views ----------------------------------------------------------
       CNINE_DEVICE_SAMEB(y);
       assert(parts.size()==y.tensors.size());
       assert(parts.size()==g.parts.size());
-      cnine::CtensorEinsumFn<float> fn("adbc,dic*->adbi");
+      #if defined(_WITH_CUDA) && !defined(_WITH_CUBLAS)
+      if(get_dev()>0){
+	cnine::CtensorEinsumFn<float> fn("adbc,dic*->adbi");
+	for(int l=0; l<parts.size(); l++)
+	  fn(parts[l]->viewx(),g.parts[l]->viewx(),y.tensors[l]->viewx());
+	return;
+      }
+      #endif
       for(int l=0; l<parts.size(); l++)
-	fn(parts[l]->viewx(),g.parts[l]->viewx(),y.tensors[l]->viewx());
+	SO3mvec_addMprod_back0Fn()(parts[l]->part3_view(),g.parts[l]->part3_view(),y.tensors[l]->view3(),getk());
     }
 
 
@@ -215,9 +239,16 @@ public: // ---- Views ----------------------------------------------------------
       CNINE_DEVICE_SAMEB(x);
       assert(parts.size()==yg.tensors.size());
       assert(parts.size()==x.parts.size());
-      cnine::CtensorEinsumFn<float> fn("adbi*,adbc->dic");
+      #if defined(_WITH_CUDA) && !defined(_WITH_CUBLAS)
+      if(get_dev()>0){
+	cnine::CtensorEinsumFn<float> fn("adbi*,adbc->dic");
+	for(int l=0; l<parts.size(); l++)
+	  fn(yg.tensors[l]->viewx(),x.parts[l]->viewx(),parts[l]->viewx());
+	return;
+      }
+      #endif
       for(int l=0; l<parts.size(); l++)
-	fn(yg.tensors[l]->viewx(),x.parts[l]->viewx(),parts[l]->viewx());
+	SO3mvec_addMprod_back1Fn()(yg.tensors[l]->view3(),parts[l]->part3_view(),x.parts[l]->part3_view(),getk());
     }
 
 
@@ -103,6 +103,13 @@ namespace GElib{
       return l;
     }
 
+    // Planar (split real/imag) layout: the real and imaginary parts
+    // live in two separate planes and the channel dimension has unit
+    // stride, so each plane is addressed by contiguous float loads.
+    bool is_planar() const{
+      return s1==1 && arrc!=arr+1;
+    }
+
     complex<float> operator()(const int m, const int i1){
       int t=s0*m+s1*i1;
       return complex<float>(ar[t],ac[t]);
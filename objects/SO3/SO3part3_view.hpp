@@ -84,6 +84,17 @@ namespace GElib{
       ac=arrc+l*s1;
     }
 
+    // Planar (split real/imag) view over separate real and imaginary
+    // planes, each laid out as [b][2l+1][n] with unit channel stride.
+    // Because the view machinery addresses the two parts through the
+    // independent arr/arrc pointers, a planar view flows through the
+    // entire CGproduct/Fproduct kernel family unchanged; the
+    // vectorized CPU kernels additionally recognize it (is_planar())
+    // and switch to fully contiguous loads.
+    static SO3part3_view planar(float* _re, float* _im, const int _b, const int _l, const int _n, const int _dev=0){
+      return SO3part3_view(_re,_im,_b,2*_l+1,_n,(2*_l+1)*_n,_n,1,_dev);
+    }
+
   public: // ---- Conversions ------------------------------------------------------------------------------
 
 
@@ -95,6 +106,12 @@ namespace GElib{
       return l;
     }
 
+    // Planar (split real/imag) layout: separate real and imaginary
+    // planes with unit channel stride. slice0 preserves the property.
+    bool is_planar() const{
+      return s2==1 && arrc!=arr+1;
+    }
+
     complex<float> operator()(const int i0, const int m, const int i2){
       int t=s0*i0+s1*m+s2*i2;
       return complex<float>(ar[t],ac[t]);
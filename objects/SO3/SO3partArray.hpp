@@ -362,18 +362,28 @@ namespace GElib{
   public: // ---- Cellwise arithmetic -------------------------------------------------------------------------
 
 
-    SO3partArray operator+(const SO3partArray& y) const{
+    SO3partArray operator+(const SO3partArray& y) const &{
       SO3partArray R(*this);
       R.add(y);
       return R;
     }
 
-    SO3partArray operator-(const SO3partArray& y) const{
+    SO3partArray operator+(const SO3partArray& y) &&{
+      add(y);
+      return std::move(*this);
+    }
+
+    SO3partArray operator-(const SO3partArray& y) const &{
       SO3partArray R(*this);
       R.subtract(y);
       return R;
     }
 
+    SO3partArray operator-(const SO3partArray& y) &&{
+      subtract(y);
+      return std::move(*this);
+    }
+
     /*
     SO3partArray operator*(const CtensorArray& M) const{
       SO3partArray R(adims,l,M.get_dims()[0],nbu,cnine::fill::zero);
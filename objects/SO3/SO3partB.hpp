@@ -13,18 +13,26 @@
 
 #include "CtensorB.hpp"
 #include "SO3part3_view.hpp"
+#include "GElibExecutor.hpp"
+#include "GElibMemoryMonitor.hpp"
 //#include "FakeGrad.hpp"
 //#include "SO3Fpart3_view.hpp"
 
 #include "SO3part_addCGproductFn.hpp"
 #include "SO3part_addCGproduct_back0Fn.hpp"
 #include "SO3part_addCGproduct_back1Fn.hpp"
+#include "SO3part_addCGproduct_backFn.hpp"
+#include "SO3part_addCGproductMixFn.hpp"
+#include "SO3part_addCGproductMix_backFn.hpp"
 
 #include "SO3part_addBlockedCGproductFn.hpp"
 #include "SO3part_addBlockedCGproduct_back0Fn.hpp"
 #include "SO3part_addBlockedCGproduct_back1Fn.hpp"
 
 #include "SO3part_addCGsquareFn.hpp"
+#include "SO3part_addBispectrumFn.hpp"
+#include "SO3part_addRotateFn.hpp"
+#include "SO3part_addRotateZYZFn.hpp"
 
 #include "SO3part_addFproduct_Fn.hpp"
 //#include "SO3part_addFproductB_Fn.hpp"
@@ -37,6 +45,7 @@
 #include "SO3_SPHgen.hpp"
 #include "SO3element.hpp"
 #include "WignerMatrix.hpp"
+#include "WignerBank.hpp"
 
 extern GElib::SO3_CGbank SO3_cgbank;
 extern GElib::SO3_SPHgen SO3_sphGen;
@@ -64,6 +73,8 @@ namespace GElib{
     SO3partB* grad=nullptr;
 #endif 
 
+    GElibMemoryHold mem_hold;
+
     ~SO3partB(){
 #ifdef WITH_FAKE_GRAD
       if(!is_view) delete grad;
@@ -75,12 +86,16 @@ namespace GElib{
 
 
     SO3partB(const int b, const int l, const int n, const int _dev=0):
-      CtensorB(Gdims(b,2*l+1,n),_dev){}
+      CtensorB(Gdims(b,2*l+1,n),_dev){
+      mem_hold.set("SO3partB",dev,((long long)memsize)*sizeof(float));
+    }
 
     template<typename FILLTYPE, typename = typename 
 	     std::enable_if<std::is_base_of<fill_pattern, FILLTYPE>::value, FILLTYPE>::type>
     SO3partB(const int b, const int l, const int n, const FILLTYPE& dummy, const int _dev=0):
-      CtensorB(Gdims(b,2*l+1,n),dummy,_dev){}
+      CtensorB(Gdims(b,2*l+1,n),dummy,_dev){
+      mem_hold.set("SO3partB",dev,((long long)memsize)*sizeof(float));
+    }
 
 
   public: // ---- Named constructors -------------------------------------------------------------------------
@@ -109,18 +124,58 @@ namespace GElib{
       return SO3partB(b,l,2*l+1,cnine::fill_gaussian(),_dev);}
 
 
+  public: // ---- Adopting external buffers ------------------------------------------------------------------
+
+
+    // Wraps caller-owned memory in a non-owning part without copying:
+    // the buffer must hold the real [b][2l+1][n] block followed by the
+    // imaginary block (the regular cnine layout), live on device _dev
+    // and outlive the returned object. This is how data flows from an
+    // external arena or a torch tensor's storage into the kernels with
+    // zero copies.
+    static SO3partB view_of(const int b, const int l, const int n, float* _arr, const int _dev=0){
+      SO3partB R(b,l,n,cnine::fill_noalloc(),_dev);
+      R.mem_hold.release();   // non-owning: not counted by gelib_memory
+      if(_dev==0) R.arr=_arr;
+      else R.arrg=_arr;
+      R.is_view=true;
+      return R;
+    }
+
+    // Same, with caller-specified strides (in floats) for the three
+    // dimensions and an explicit imaginary-plane offset.
+    static SO3partB view_of(const int b, const int l, const int n, float* _arr,
+      const cnine::Gstrides& _strides, const int _coffs, const int _dev=0){
+      SO3partB R=view_of(b,l,n,_arr,_dev);
+      R.strides=_strides;
+      R.coffs=_coffs;
+      return R;
+    }
+
+    // Non-owning view of batch rows [beg,end): shares this part's
+    // buffer, so microbatch slices cost nothing. The strides and the
+    // imaginary-plane offset are inherited, so the view is accepted by
+    // the whole Fn kernel surface like any other part. The parent must
+    // outlive the view.
+    SO3partB batch_slice(const int beg, const int end) const{
+      GELIB_ASSRT(0<=beg && beg<=end && end<=getb());
+      float* a=(dev==0? arr : arrg)+beg*strides[0];
+      return view_of(end-beg,getl(),getn(),a,strides,coffs,dev);
+    }
+
+
   public: // ---- Copying ------------------------------------------------------------------------------------
     // only needed for grad
 
     #ifdef WITH_FAKE_GRAD
     SO3partB(const SO3partB& x):
-      CtensorB(x){
+      CtensorB(x), mem_hold(x.mem_hold){
       GELIB_COPY_WARNING();
       if(x.grad) grad=new SO3partB(*x.grad);
     }
       
     SO3partB(SO3partB&& x):
-      CtensorB(std::move(x)){
+      CtensorB(std::move(x)), mem_hold(std::move(x.mem_hold)){
       GELIB_MOVE_WARNING();
       grad=x.grad;
       x.grad=nullptr;
@@ -135,6 +190,7 @@ namespace GElib{
       GELIB_CONVERT_WARNING(x);
       assert(dims.size()==3);
       assert(dims(1)%2==1);
+      if(!is_view) mem_hold.set("SO3partB",dev,((long long)memsize)*sizeof(float));
     }
       
     SO3partB(CtensorB&& x):
@@ -142,6 +198,7 @@ namespace GElib{
       GELIB_MCONVERT_WARNING(x);
       assert(dims.size()==3);
       assert(dims(1)%2==1);
+      if(!is_view) mem_hold.set("SO3partB",dev,((long long)memsize)*sizeof(float));
     }
       
 
@@ -242,19 +299,26 @@ namespace GElib{
 
 
     SO3partB rotate(const SO3element& r){
-      CtensorB D(WignerMatrix<float>(getl(),r),dev);
+      CtensorB& D=const_cast<CtensorB&>(SO3_wignerBank(getl(),r,dev));
       SO3partB R=SO3partB::zero(getb(),getl(),getn(),dev);
+      SO3part_addRotateFn()(R.view3(),view3(),D.view2());
+      return R;
+    }
 
-      int B=getb();
-      auto dv=D.view2D();
-      auto xv=this->view3D();
-      auto rv=R.view3D();
-      
-      for(int b=0; b<B; b++){
-	auto v=rv.slice0(b);
-	cnine::Ctensor_add_mprod_AA()(v,dv,xv.slice0(b));
-      }
+    // Accumulating form writing into an existing part, for callers that
+    // reuse their output buffers.
+    void add_rotate(const SO3partB& x, const SO3element& r){
+      CtensorB& D=const_cast<CtensorB&>(SO3_wignerBank(getl(),r,dev));
+      SO3part_addRotateFn()(view3(),const_cast<SO3partB&>(x).view3(),D.view2());
+    }
 
+    // Factored ZYZ variant: no dense Wigner matrix is built, so for
+    // fresh rotations at high l this avoids the construction cost that
+    // dominates rotate(); host only (see SO3part_addRotateZYZFn).
+    SO3partB rotateZYZ(const SO3element& r){
+      GELIB_ASSRT(dev==0);
+      SO3partB R=SO3partB::zero(getb(),getl(),getn(),dev);
+      SO3part_addRotateZYZFn()(R.view3(),view3(),r.phi,r.theta,r.psi);
       return R;
     }
 
@@ -397,8 +461,13 @@ namespace GElib{
     
     SO3partB CGproduct(const SO3partB& y, const int l) const{
       assert(l>=abs(getl()-y.getl()) && l<=getl()+y.getl());
-      SO3partB R=SO3partB::zero(getb(),l,getn()*y.getn(),get_dev());
-      R.add_CGproduct(*this,y);
+      if(get_dev()>0){
+	SO3partB R=SO3partB::zero(getb(),l,getn()*y.getn(),get_dev());
+	R.add_CGproduct(*this,y);
+	return R;
+      }
+      SO3partB R=SO3partB::raw(getb(),l,getn()*y.getn(),get_dev());
+      R.set_CGproduct(*this,y);
       return R;
     }
 
@@ -406,6 +475,27 @@ namespace GElib{
       SO3part_addCGproductFn()(*this,x,y,_offs);
     }
 
+    // Write-mode form: overwrites this with the product instead of
+    // accumulating, so the result can be allocated raw and the separate
+    // zero-fill pass -- a full extra write of the output -- disappears
+    // (see SO3part_addCGproductFn). Off the host fast path it falls
+    // back to zero-then-accumulate.
+    void set_CGproduct(const SO3partB& x, const SO3partB& y, const int _offs=0){
+      if(get_dev()>0){
+	set_zero();
+	add_CGproduct(x,y,_offs);
+	return;
+      }
+      SO3part_addCGproductFn(true)(*this,x,y,_offs);
+    }
+
+    // Out-parameter form: writes the product into caller-owned,
+    // preallocated storage so steady-state loops allocate nothing.
+    static void CGproduct_into(SO3partB& r, const SO3partB& x, const SO3partB& y, const int _offs=0){
+      r.set_zero();
+      r.add_CGproduct(x,y,_offs);
+    }
+
     void add_CGproduct_back0(const SO3partB& g, const SO3partB& y, const int _offs=0){
       SO3part_addCGproduct_back0Fn()(*this,g,y,_offs);
     }
@@ -414,8 +504,94 @@ namespace GElib{
       SO3part_addCGproduct_back1Fn()(*this,g,x,_offs);
     }
 
+    static void add_CGproduct_back(SO3partB& xg, SO3partB& yg, const SO3partB& g,
+      const SO3partB& x, const SO3partB& y, const int _offs=0){
+      SO3part_addCGproduct_backFn()(xg,yg,g,x,y,_offs);
+    }
+
+
+    // Fused third-order invariant: returns the (b,n_x*n_y,n_z) table
+    // of bispectrum-style contractions of this part with y and z,
+    // computed directly from the three operands without materializing
+    // the intermediate CG product (see SO3part_addBispectrumFn).
+    cnine::CtensorB bispectrum(const SO3partB& y, const SO3partB& z) const{
+      assert(z.getl()>=abs(getl()-y.getl()) && z.getl()<=getl()+y.getl());
+      cnine::CtensorB R=cnine::CtensorB::zero(Gdims(getb(),getn()*y.getn(),z.getn()),get_dev());
+      SO3part_addBispectrumFn()(R.view3(),const_cast<SO3partB*>(this)->view3(),
+	const_cast<SO3partB&>(y).view3(),const_cast<SO3partB&>(z).view3());
+      return R;
+    }
 
-    // ---- BlockedCGproduct 
+
+    // ---- Fused CGproduct + mix
+
+
+    SO3partB CGproduct_mix(const SO3partB& y, const CtensorB& w, const int l) const{
+      assert(l>=abs(getl()-y.getl()) && l<=getl()+y.getl());
+      assert(w.ndims()==2 && w.dims(0)==getn()*y.getn());
+      SO3partB R=SO3partB::zero(getb(),l,w.dims(1),get_dev());
+      R.add_CGproduct_mix(*this,y,w);
+      return R;
+    }
+
+    // Fuses the CG product with a following channel mix so the full
+    // (2l+1) x N1*N2 product intermediate is never materialized (see
+    // SO3part_addCGproductMixFn). On the device the two steps run
+    // unfused with a materialized intermediate.
+    void add_CGproduct_mix(const SO3partB& x, const SO3partB& y, const CtensorB& w, const int _offs=0){
+      if(get_dev()>0){
+	GELIB_ASSRT(_offs==0);
+	SO3partB T=x.CGproduct(y,getl());
+	add_mprod(T,w);
+	return;
+      }
+      SO3part_addCGproductMixFn()(*this,x,y,const_cast<CtensorB&>(w).view2(),_offs);
+    }
+
+    // Fused backward: accumulates the gradients of x, y and w in one
+    // tiled sweep (see SO3part_addCGproductMix_backFn). CPU only.
+    static void add_CGproduct_mix_back(SO3partB& xg, SO3partB& yg, CtensorB& wg, const SO3partB& g,
+      const SO3partB& x, const SO3partB& y, const CtensorB& w, const int _offs=0){
+      SO3part_addCGproductMix_backFn()(xg,yg,wg.view2(),g,x,y,const_cast<CtensorB&>(w).view2(),_offs);
+    }
+
+
+    // Asynchronous variants: the operation is queued on the session
+    // executor and the returned future resolves when it has run.
+    // Conflicting operations (detected from the operand tensors) execute
+    // in submission order, independent ones overlap. The operands must
+    // stay alive until the future is ready; call wait() or
+    // gelib_executor->sync() before reading the result.
+
+    GElibExecutor::Future add_CGproduct_async(const SO3partB& x, const SO3partB& y, const int _offs=0){
+      return submit_async([this,&x,&y,_offs](){add_CGproduct(x,y,_offs);},x,y);
+    }
+
+    GElibExecutor::Future add_CGproduct_back0_async(const SO3partB& g, const SO3partB& y, const int _offs=0){
+      return submit_async([this,&g,&y,_offs](){add_CGproduct_back0(g,y,_offs);},g,y);
+    }
+
+    GElibExecutor::Future add_CGproduct_back1_async(const SO3partB& g, const SO3partB& x, const int _offs=0){
+      return submit_async([this,&g,&x,_offs](){add_CGproduct_back1(g,x,_offs);},g,x);
+    }
+
+    GElibExecutor::Future add_Fproduct_async(const SO3partB& x, const SO3partB& y){
+      return submit_async([this,&x,&y](){add_Fproduct(x,y);},x,y);
+    }
+
+  private:
+
+    GElibExecutor::Future submit_async(std::function<void()> fn, const SO3partB& x, const SO3partB& y){
+      if(!gelib_executor){fn(); return GElibExecutor::Future();}
+      return gelib_executor->submit(std::move(fn),
+	{GElibExecutor::Region(&x),GElibExecutor::Region(&y)},
+	{GElibExecutor::Region(this)});
+    }
+
+  public:
+
+
+    // ---- BlockedCGproduct
 
 
     SO3partB BlockedCGproduct(const SO3partB& y, const int bsize, const int l) const{
@@ -503,6 +679,48 @@ namespace GElib{
       SO3part_addFproduct_back1Fn(0,1)(view3(),g.view3(),x.view3());
     }
 
+    // Autotuned variants: the kernel method is chosen by
+    // SO3Fproduct_tuner, which benchmarks the candidates the first time
+    // each shape is seen on a device (see SO3FproductTuner).
+
+    void add_Fproduct_auto(const SO3partB& x, const SO3partB& y){
+      const int m=SO3Fproduct_tuner.method(SO3FproductTuner::FWD,x.getl(),y.getl(),getl(),getb(),dev);
+      SO3part_addFproduct_Fn(0,m)(view3(),x.view3(),y.view3());
+    }
+
+    void add_Fproduct_auto_back0(const SO3partB& g, const SO3partB& y){
+      const int m=SO3Fproduct_tuner.method(SO3FproductTuner::BACK0,getl(),y.getl(),g.getl(),getb(),dev);
+      SO3part_addFproduct_back0Fn(0,m)(view3(),g.view3(),y.view3());
+    }
+
+    void add_Fproduct_auto_back1(const SO3partB& g, const SO3partB& x){
+      const int m=SO3Fproduct_tuner.method(SO3FproductTuner::BACK1,x.getl(),getl(),g.getl(),getb(),dev);
+      SO3part_addFproduct_back1Fn(0,m)(view3(),g.view3(),x.view3());
+    }
+
+    // Truncated variants: coefficients beyond the given effective
+    // bandlimits are skipped; pass -1 to leave an operand untruncated
+    // and see SO3Fpart_effective_bandlimit for deriving limits from an
+    // energy threshold.
+
+    void add_Fproduct_trunc(const SO3partB& x, const SO3partB& y, const int xlimit, const int ylimit, const int rlimit=-1){
+      SO3part_addFproduct_Fn fn;
+      fn.xlimit=xlimit; fn.ylimit=ylimit; fn.rlimit=rlimit;
+      fn(view3(),x.view3(),y.view3());
+    }
+
+    void add_Fproduct_trunc_back0(const SO3partB& g, const SO3partB& y, const int xlimit, const int ylimit, const int rlimit=-1){
+      SO3part_addFproduct_back0Fn fn;
+      fn.xlimit=xlimit; fn.ylimit=ylimit; fn.rlimit=rlimit;
+      fn(view3(),g.view3(),y.view3());
+    }
+
+    void add_Fproduct_trunc_back1(const SO3partB& g, const SO3partB& x, const int xlimit, const int ylimit, const int rlimit=-1){
+      SO3part_addFproduct_back1Fn fn;
+      fn.xlimit=xlimit; fn.ylimit=ylimit; fn.rlimit=rlimit;
+      fn(view3(),g.view3(),x.view3());
+    }
+
 
   public: // ---- CGtransform --------------------------------------------------------------------------------
 
@@ -547,6 +765,56 @@ namespace GElib{
 
   };
 
+
+  // ---- Batched entry points -------------------------------------------------------------------------------
+
+
+  // Executes a whole list of CG-product accumulations r[i]+=CG(x[i],y[i])
+  // at fragment offsets offs[i] in a single native call. Each pair is
+  // routed through the session executor, so independent products overlap
+  // on the thread pool (and on separate CUDA streams through the usual
+  // stream pool) while pairs writing into the same output part keep
+  // their submission order; the call returns once every product has run.
+  // Intended primarily for language bindings: a layer that issues
+  // hundreds of small products per step crosses the interpreter boundary
+  // once instead of once per product. An empty offs is treated as all
+  // zeros.
+  inline void add_CGproduct_batch(const vector<SO3partB*>& r, const vector<SO3partB*>& x,
+    const vector<SO3partB*>& y, const vector<int>& offs=vector<int>()){
+    const int N=r.size();
+    assert((int)x.size()==N && (int)y.size()==N);
+    assert(offs.size()==0 || (int)offs.size()==N);
+    vector<GElibExecutor::Future> futures;
+    futures.reserve(N);
+    for(int i=0; i<N; i++)
+      futures.push_back(r[i]->add_CGproduct_async(*x[i],*y[i],offs.size()>0? offs[i]: 0));
+    for(auto& f: futures) f.wait();
+  }
+
+  inline void add_CGproduct_batch_back0(const vector<SO3partB*>& xg, const vector<SO3partB*>& g,
+    const vector<SO3partB*>& y, const vector<int>& offs=vector<int>()){
+    const int N=xg.size();
+    assert((int)g.size()==N && (int)y.size()==N);
+    assert(offs.size()==0 || (int)offs.size()==N);
+    vector<GElibExecutor::Future> futures;
+    futures.reserve(N);
+    for(int i=0; i<N; i++)
+      futures.push_back(xg[i]->add_CGproduct_back0_async(*g[i],*y[i],offs.size()>0? offs[i]: 0));
+    for(auto& f: futures) f.wait();
+  }
+
+  inline void add_CGproduct_batch_back1(const vector<SO3partB*>& yg, const vector<SO3partB*>& g,
+    const vector<SO3partB*>& x, const vector<int>& offs=vector<int>()){
+    const int N=yg.size();
+    assert((int)g.size()==N && (int)x.size()==N);
+    assert(offs.size()==0 || (int)offs.size()==N);
+    vector<GElibExecutor::Future> futures;
+    futures.reserve(N);
+    for(int i=0; i<N; i++)
+      futures.push_back(yg[i]->add_CGproduct_back1_async(*g[i],*x[i],offs.size()>0? offs[i]: 0));
+    for(auto& f: futures) f.wait();
+  }
+
 }
 
 #endif 
@@ -18,6 +18,11 @@
 #include "SO3part4_view.hpp"
 #include "SO3partB.hpp"
 
+#include "GElibMemoryMonitor.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibCellOffsets.hpp"
+#include "GElibCellMask.hpp"
+
 #include "SO3part_addSpharmFn.hpp"
 #include "SO3part_addCGproductFn.hpp"
 #include "SO3part_addCGproduct_back0Fn.hpp"
@@ -29,9 +34,13 @@
 #include "SO3part_addDiagCGproductBFn.hpp"
 #include "SO3part_addDiagCGproductB_back0Fn.hpp"
 #include "SO3part_addDiagCGproductB_back1Fn.hpp"
+#include "SO3part_addDiagCGproductMixFn.hpp"
+#include "SO3part_addRotateFn.hpp"
+#include "SO3part_addCGproduct_gemmFn.hpp"
 
 #include "SO3element.hpp"
 #include "WignerMatrix.hpp"
+#include "WignerBank.hpp"
 
 extern GElib::SO3_CGbank SO3_cgbank;
 extern GElib::SO3_SPHgen SO3_sphGen;
@@ -55,7 +64,15 @@ namespace GElib{
 
     using CtensorArrayB::CtensorArrayB;
 
-    
+    GElibMemoryHold mem_hold;
+
+    // Optional validity mask over the flat cell grid: when set, the
+    // masked host paths and for_each_cell skip invalid (padding) cells
+    // entirely. Shared, so copies and products of the array refer to
+    // the same mask.
+    std::shared_ptr<GElibCellMask> cell_mask;
+
+
   public: // ---- Constructors -------------------------------------------------------------------------------
 
 
@@ -68,18 +85,23 @@ namespace GElib{
     //CtensorArrayB({N},{b,2*l+1,n},dummy,_dev){}
 
     SO3partB_array(const Gdims& _adims, const int l, const int n, const int _dev=0):
-      CtensorArrayB(_adims,{2*l+1,n},_dev){}
+      CtensorArrayB(_adims,{2*l+1,n},_dev){
+      mem_hold.set("SO3partB_array",dev,((long long)memsize)*sizeof(float));
+    }
 
     template<typename FILLTYPE, typename = typename 
 	     std::enable_if<std::is_base_of<fill_pattern, FILLTYPE>::value, FILLTYPE>::type>
     SO3partB_array(const Gdims& _adims, const int l, const int n, const FILLTYPE& dummy, const int _dev=0):
-      CtensorArrayB(_adims,{2*l+1,n},dummy,_dev){}
+      CtensorArrayB(_adims,{2*l+1,n},dummy,_dev){
+      mem_hold.set("SO3partB_array",dev,((long long)memsize)*sizeof(float));
+    }
 
     template<typename FILLTYPE, typename = typename 
 	     std::enable_if<std::is_base_of<fill_pattern, FILLTYPE>::value, FILLTYPE>::type>
     SO3partB_array(const int b, const Gdims& _adims, const int l, const int n, const FILLTYPE& dummy, const int _dev=0):
       CtensorArrayB(_adims.prepend(b),{2*l+1,n},dummy,_dev){
       batched=true;
+      mem_hold.set("SO3partB_array",dev,((long long)memsize)*sizeof(float));
     }
 
     
@@ -118,17 +140,105 @@ namespace GElib{
     }
 
 
+  public: // ---- Adopting external buffers ------------------------------------------------------------------
+
+
+    // Wraps a caller-owned buffer as a non-owning cell array without
+    // copying; the buffer must follow the regular cell layout on
+    // device _dev and outlive the returned object (see
+    // SO3partB::view_of).
+    static SO3partB_array view_of(const Gdims& _adims, const int l, const int n, float* _arr, const int _dev=0){
+      SO3partB_array R(_adims,l,n,cnine::fill_noalloc(),_dev);
+      R.mem_hold.release();   // non-owning: not counted by gelib_memory
+      if(_dev==0) R.arr=_arr;
+      else R.arrg=_arr;
+      R.is_view=true;
+      return R;
+    }
+
+    // Same, with caller-specified strides (in floats) and an explicit
+    // imaginary-plane offset.
+    static SO3partB_array view_of(const Gdims& _adims, const int l, const int n, float* _arr,
+      const Gstrides& _strides, const int _coffs, const int _dev=0){
+      SO3partB_array R=view_of(_adims,l,n,_arr,_dev);
+      R.strides=_strides;
+      R.coffs=_coffs;
+      return R;
+    }
+
+    // Non-owning view of batch rows [beg,end): shares the underlying
+    // buffer with inherited strides and imaginary-plane offset, so
+    // microbatch slices cost nothing. The parent must outlive the view.
+    SO3partB_array batch_slice(const int beg, const int end) const{
+      GELIB_ASSRT(0<=beg && beg<=end && end<=getb());
+      SO3partB_array R(end-beg,get_adims(),getl(),getn(),cnine::fill_noalloc(),dev);
+      R.mem_hold.release();   // non-owning: not counted by gelib_memory
+      if(dev==0) R.arr=arr+beg*strides[0];
+      else R.arrg=arrg+beg*strides[0];
+      R.strides=strides;
+      R.coffs=coffs;
+      R.is_view=true;
+      return R;
+    }
+
+
+    // Parallel ingestion from a raw caller buffer: src holds the cells
+    // in flat grid order, each cell a (2l+1) x n complex matrix with
+    // interleaved real/imaginary parts -- the layout of a contiguous
+    // numpy/torch complex64 array. The scatter into the native cell
+    // layout runs one cell per thread-pool task, so a dataloader batch
+    // ingests at memory bandwidth instead of through a single-threaded
+    // copy loop. For a device array the cells are scattered directly
+    // into a leased pinned staging buffer and shipped with a single
+    // transfer, avoiding both the pageable-copy stall and a second
+    // host-side pass.
+    void ingest(const float* src){
+      const int nm=dims.back(1);
+      const int nn=dims.back(0);
+      const size_t cellfloats=2*((size_t)nm)*nn;
+      const int N=getN();
+      const size_t scell=strides.back(2);
+      const size_t sm=strides.back(1);
+      const size_t sn=strides.back(0);
+
+      auto scatter=[&](float* dst){
+	GElibMultiLoop(N,[&](const int i){
+	    const float* s=src+i*cellfloats;
+	    float* d=dst+i*scell;
+	    for(int m=0; m<nm; m++)
+	      for(int j=0; j<nn; j++){
+		d[m*sm+j*sn]=s[2*(m*nn+j)];
+		d[m*sm+j*sn+coffs]=s[2*(m*nn+j)+1];
+	      }
+	  });
+      };
+
+      if(dev==0){
+	scatter(arr);
+	return;
+      }
+#ifdef _WITH_CUDA
+      GElibCudaStagingPool::BufferSet* set=gelib_cuda_staging.acquire(memsize,0,0);
+      scatter(set->xstage);
+      CUDA_SAFE(cudaMemcpy(arrg,set->xstage,memsize*sizeof(float),cudaMemcpyHostToDevice));
+      gelib_cuda_staging.release(set);
+#else
+      GELIB_ASSRT(dev==0);
+#endif
+    }
+
+
   public: // ---- Copying ------------------------------------------------------------------------------------
 
 
     SO3partB_array(const SO3partB_array& x):
-      CtensorArrayB(x){
+      CtensorArrayB(x), mem_hold(x.mem_hold){
       //CtensorArrayB(x,-2){
       GELIB_COPY_WARNING();
     }
       
     SO3partB_array(SO3partB_array&& x):
-      CtensorArrayB(std::move(x)){
+      CtensorArrayB(std::move(x)), mem_hold(std::move(x.mem_hold)){
       //CtensorArrayB(std::move(x),-2){
       GELIB_MOVE_WARNING();
     }
@@ -232,6 +342,44 @@ namespace GElib{
 	Gstrides({strides.back(2),strides.back(1),strides.back(0)}),coffs,dev);
     }
 
+    void set_cell_mask(const GElibCellMask& mask){
+      GELIB_ASSRT(mask.size()==getN());
+      cell_mask=std::make_shared<GElibCellMask>(mask);
+    }
+
+    bool has_cell_mask() const{
+      return (bool)cell_mask;
+    }
+
+
+    // Stride-0 broadcast of a single (b=1) part across this array's
+    // fused cell grid: every cell slice aliases the same data, so
+    // broadcast products read the shared operand in place instead of
+    // replicating it into a full array. Both the host kernels (which
+    // address cells through slice0) and the strided-batched GEMM paths
+    // accept the zero batch stride unchanged.
+    SO3part3_view broadcast_part3_view(const SO3partB& y) const{
+      cnine::Ctensor3_view v=const_cast<SO3partB&>(y).view3();
+      GELIB_ASSRT(v.n0==1);
+      GELIB_ASSRT(y.get_dev()==dev);
+      return SO3part3_view(v.arr,v.arrc,getN(),v.n1,v.n2,0,v.s1,v.s2,v.dev);
+    }
+
+
+    // Runs lambda over the (batch-flattened) cell grid in parallel on
+    // the session thread pool, handing each call the cell index and a
+    // 2D view of that cell. grain sets how many consecutive cells a
+    // thread claims at a time; the default lets the pool pick a chunk
+    // size that amortizes claiming overhead over large grids, which is
+    // what lets a 10k-cell CG product saturate all cores. CPU only.
+    void for_each_cell(const std::function<void(const int, const SO3part2_view&)>& lambda, const int grain=0) const{
+      GELIB_CHECK(dev==0,"for_each_cell is CPU only");
+      const SO3part3_view v=part3_view();
+      GElibMultiLoop(v.n0,[&](const int i){
+	  if(cell_mask && !(*cell_mask)(i)) return;
+	  lambda(i,v.slice0(i));},grain);
+    }
+
     /*
     SO3part4_view part4_view() const{
       GELIB_ASSRT(dims.size()>=4);
@@ -275,19 +423,9 @@ namespace GElib{
 
 
     SO3partB_array rotate(const SO3element& r) const{
-      CtensorB D(WignerMatrix<float>(getl(),r),dev);
+      CtensorB& D=const_cast<CtensorB&>(SO3_wignerBank(getl(),r,dev));
       SO3partB_array R=SO3partB_array::zeros_like(*this);
-
-      auto dv=D.view2D();
-      auto xv=fused_view().view3();
-      auto rv=R.fused_view().view3();
-      
-      int B=rv.n0;
-      for(int b=0; b<B; b++){
-	auto v=rv.slice0(b);
-	cnine::Ctensor_add_mprod_AA()(v,dv,xv.slice0(b));
-      }
-
+      SO3part_addRotateFn()(R.fused_view().view3(),fused_view().view3(),D.view2());
       return R;
     }
 
@@ -307,6 +445,302 @@ namespace GElib{
       }
     }
 
+
+  public: // ---- Gather/scatter operations -------------------------------------------------------------------
+
+
+    // Returns a flat length-E array whose cell e is a copy of cell
+    // ix[e]; indices address the batch-flattened cell grid, as in
+    // for_each_cell. This materializes the gathered copies -- when they
+    // would only feed a CG product, add_CGproduct_edges fuses the
+    // gather into the product instead.
+    SO3partB_array gather_rows(const vector<int>& ix) const{
+      GELIB_CHECK(dev==0,"gather_rows is CPU only");
+      const int l=getl();
+      const int n=getn();
+      SO3partB_array R=SO3partB_array::zero(Gdims({(int)ix.size()}),l,n,dev);
+      const SO3part3_view xv=part3_view();
+      const SO3part3_view rv=R.part3_view();
+      GElibMultiLoop((int)ix.size(),[&](const int e){
+	  GELIB_ASSRT(ix[e]>=0 && ix[e]<xv.n0);
+	  SO3part2_view r=rv.slice0(e);
+	  SO3part2_view x=xv.slice0(ix[e]);
+	  for(int m=-l; m<=l; m++)
+	    for(int i=0; i<n; i++)
+	      r.set(m,i,x(m,i));
+	});
+      return R;
+    }
+
+
+    // Accumulates cell e of x into cell ix[e] of this array. The edges
+    // are bucketed by destination and the destinations distributed over
+    // the thread pool, so no two threads write the same cell and the
+    // accumulation order within a cell is deterministic.
+    void scatter_add_rows(const SO3partB_array& x, const vector<int>& ix){
+      GELIB_CHECK(dev==0,"scatter_add_rows is CPU only");
+      GELIB_ASSRT(x.getl()==getl() && x.getn()==getn());
+      const int l=getl();
+      const int n=getn();
+      const SO3part3_view xv=x.part3_view();
+      const SO3part3_view rv=part3_view();
+      GELIB_ASSRT((int)ix.size()==xv.n0);
+
+      vector<vector<int> > buckets(rv.n0);
+      for(int e=0; e<(int)ix.size(); e++){
+	GELIB_ASSRT(ix[e]>=0 && ix[e]<rv.n0);
+	buckets[ix[e]].push_back(e);
+      }
+
+      GElibMultiLoop(rv.n0,[&](const int d){
+	  if(buckets[d].size()==0) return;
+	  SO3part2_view r=rv.slice0(d);
+	  for(auto e:buckets[d]){
+	    SO3part2_view v=xv.slice0(e);
+	    for(int m=-l; m<=l; m++)
+	      for(int i=0; i<n; i++)
+		r.inc(m,i,v(m,i));
+	  }
+	});
+    }
+
+
+    // Zeros the listed cells in place, leaving the rest untouched; this
+    // is what the delta recomputation path runs before re-accumulating
+    // just the changed cells.
+    void zero_cells(const vector<int>& ix){
+      GELIB_CHECK(dev==0,"zero_cells is CPU only");
+      const int l=getl();
+      const int n=getn();
+      const SO3part3_view rv=part3_view();
+      GElibMultiLoop((int)ix.size(),[&](const int e){
+	  GELIB_ASSRT(ix[e]>=0 && ix[e]<rv.n0);
+	  SO3part2_view r=rv.slice0(ix[e]);
+	  for(int m=-l; m<=l; m++)
+	    for(int i=0; i<n; i++)
+	      r.set(m,i,complex<float>(0,0));
+	});
+    }
+
+
+    // Fused gather -> CGproduct -> scatter_add over an edge list: for
+    // each edge e adds the CG product of cell src[e] of x with cell
+    // dst[e] of y into cell dst[e] of this array, so neighborhood
+    // aggregation never materializes the gathered neighbor tensor.
+    // Destination bucketing keeps the per-thread writes disjoint, as in
+    // scatter_add_rows; within a bucket each edge runs the same
+    // nonzero-list loop as SO3part_addCGproductFn.
+    void add_CGproduct_edges(const SO3partB_array& x, const SO3partB_array& y,
+      const vector<int>& src, const vector<int>& dst, const int _offs=0){
+      GELIB_CHECK(dev==0,"add_CGproduct_edges is CPU only");
+      GELIB_ASSRT(src.size()==dst.size());
+
+      const int l=getl();
+      const int l1=x.getl();
+      const int l2=y.getl();
+      const int N1=x.getn();
+      const int N2=y.getn();
+      GELIB_ASSRT(l>=abs(l1-l2) && l<=l1+l2);
+      GELIB_ASSRT(_offs+N1*N2<=getn());
+
+      auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+      const SO3part3_view xv=x.part3_view();
+      const SO3part3_view yv=y.part3_view();
+      const SO3part3_view rv=part3_view();
+      GELIB_ASSRT(yv.n0==rv.n0);
+
+      vector<vector<int> > buckets(rv.n0);
+      for(int e=0; e<(int)dst.size(); e++){
+	GELIB_ASSRT(src[e]>=0 && src[e]<xv.n0);
+	GELIB_ASSRT(dst[e]>=0 && dst[e]<rv.n0);
+	buckets[dst[e]].push_back(e);
+      }
+
+      GElibMultiLoop(rv.n0,[&](const int d){
+	  if(buckets[d].size()==0) return;
+	  SO3part2_view r=rv.slice0(d);
+	  SO3part2_view yd=yv.slice0(d);
+	  for(auto e:buckets[d]){
+	    SO3part2_view xs=xv.slice0(src[e]);
+	    int offs=_offs;
+	    for(int n1=0; n1<N1; n1++){
+	      for(auto& p:C.nonzeros){
+		const complex<float> t=p.c*xs(p.m1-l1,n1);
+		for(int n2=0; n2<N2; n2++)
+		  r.inc(p.m-l,offs+n2,t*yd(p.m2-l2,n2));
+	      }
+	      offs+=N2;
+	    }
+	  }
+	});
+    }
+
+
+    // Fused stencil convolution on a grid-structured array: for every
+    // grid cell i this adds sum_s CGproduct(x_cell(i+offsets[s]),w[s]),
+    // where w holds one broadcast (b=1) filter part per stencil offset
+    // and offsets are multi-index displacements over the array's adims
+    // grid. Neighbors falling outside the grid contribute nothing
+    // (zero padding). The gather is folded into the product -- each
+    // output cell walks its stencil reading the neighbor cells in
+    // place -- so no shifted copy of the array is ever materialized,
+    // the im2col-free analogue of the explicit shifted-copy
+    // convolution. Each task owns one output cell, so the writes are
+    // disjoint and the accumulation order is deterministic. CPU only.
+    void add_CGproduct_stencil(const SO3partB_array& x, const vector<SO3partB*>& w,
+      const vector<vector<int> >& offsets, const int _offs=0){
+      GELIB_CHECK(dev==0,"add_CGproduct_stencil is CPU only");
+      GELIB_ASSRT(w.size()==offsets.size());
+      GELIB_ASSRT(w.size()>0);
+
+      const int l=getl();
+      const int l1=x.getl();
+      const int l2=w[0]->getl();
+      const int N1=x.getn();
+      const int N2=w[0]->getn();
+      GELIB_ASSRT(l>=abs(l1-l2) && l<=l1+l2);
+      GELIB_ASSRT(_offs+N1*N2<=getn());
+
+      auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+
+      vector<SO3part2_view> wv;
+      for(auto p:w){
+	GELIB_ASSRT(p->getl()==l2 && p->getn()==N2 && p->getb()==1);
+	wv.push_back(SO3part2_view(p->view3().slice0(0)));
+      }
+
+      const Gdims adims=get_adims();
+      const int k=adims.size();
+      const int A=adims.total();
+      vector<int> gs(k);
+      gs[k-1]=1;
+      for(int d=k-2; d>=0; d--) gs[d]=gs[d+1]*adims[d+1];
+      for(auto& o:offsets) GELIB_ASSRT((int)o.size()==k);
+
+      const SO3part3_view xv=x.part3_view();
+      const SO3part3_view rv=part3_view();
+      GELIB_ASSRT(xv.n0==rv.n0);
+      GELIB_ASSRT(rv.n0%A==0);
+
+      GElibMultiLoop(rv.n0,[&](const int i){
+	  if(cell_mask && !(*cell_mask)(i)) return;
+	  const int base=i-i%A;
+	  int rem=i%A;
+	  vector<int> ix(k);
+	  for(int d=0; d<k; d++){
+	    ix[d]=rem/gs[d];
+	    rem=rem%gs[d];
+	  }
+	  SO3part2_view r=rv.slice0(i);
+
+	  for(int s=0; s<(int)offsets.size(); s++){
+	    int nbr=0;
+	    bool inside=true;
+	    for(int d=0; d<k; d++){
+	      const int t=ix[d]+offsets[s][d];
+	      if(t<0 || t>=adims[d]){inside=false; break;}
+	      nbr+=t*gs[d];
+	    }
+	    if(!inside) continue;
+	    SO3part2_view xs=xv.slice0(base+nbr);
+	    SO3part2_view wd=wv[s];
+	    int offs=_offs;
+	    for(int n1=0; n1<N1; n1++){
+	      for(auto& p:C.nonzeros){
+		const complex<float> t=p.c*xs(p.m1-l1,n1);
+		for(int n2=0; n2<N2; n2++)
+		  r.inc(p.m-l,offs+n2,t*wd(p.m2-l2,n2));
+	      }
+	      offs+=N2;
+	    }
+	  }
+	});
+    }
+
+
+  public: // ---- Ragged operations --------------------------------------------------------------------------
+
+
+    // Per-sample reduction of a ragged (CSR-packed) array: sums the
+    // cell range of each sample into one cell of the result, so a
+    // variable-atom-count batch reduces without touching padding.
+    // Conversion from a padded rectangular grid to the packed layout
+    // is gather_rows(offsets.pack_indices(maxcells)).
+    SO3partB_array reduce_cells(const GElibCellOffsets& offsets) const{
+      GELIB_CHECK(dev==0,"reduce_cells is CPU only");
+      const int l=getl();
+      const int n=getn();
+      const SO3part3_view xv=part3_view();
+      GELIB_ASSRT(offsets.ncells()==xv.n0);
+      SO3partB_array R=SO3partB_array::zero(Gdims({offsets.nsamples()}),l,n,dev);
+      const SO3part3_view rv=R.part3_view();
+      GElibMultiLoop(offsets.nsamples(),[&](const int s){
+	  SO3part2_view r=rv.slice0(s);
+	  for(int c=offsets.start(s); c<offsets.start(s)+offsets.size(s); c++){
+	    SO3part2_view v=xv.slice0(c);
+	    for(int m=-l; m<=l; m++)
+	      for(int i=0; i<n; i++)
+		r.inc(m,i,v(m,i));
+	  }
+	});
+      return R;
+    }
+
+
+    // Delta refresh of a previously computed reduce_cells result: only
+    // the listed samples are rebuilt, each from its full cell range of
+    // x, so when a handful of cells changed the dependent reduction
+    // costs O(affected samples) instead of O(samples).
+    void update_reduced_cells(const SO3partB_array& x, const GElibCellOffsets& offsets, const vector<int>& samples){
+      GELIB_CHECK(dev==0,"update_reduced_cells is CPU only");
+      GELIB_ASSRT(x.getl()==getl() && x.getn()==getn());
+      const int l=getl();
+      const int n=getn();
+      const SO3part3_view xv=x.part3_view();
+      const SO3part3_view rv=part3_view();
+      GELIB_ASSRT(offsets.ncells()==xv.n0);
+      GELIB_ASSRT(offsets.nsamples()==rv.n0);
+      GElibMultiLoop((int)samples.size(),[&](const int e){
+	  const int s=samples[e];
+	  GELIB_ASSRT(s>=0 && s<rv.n0);
+	  SO3part2_view r=rv.slice0(s);
+	  for(int m=-l; m<=l; m++)
+	    for(int i=0; i<n; i++)
+	      r.set(m,i,complex<float>(0,0));
+	  for(int c=offsets.start(s); c<offsets.start(s)+offsets.size(s); c++){
+	    SO3part2_view v=xv.slice0(c);
+	    for(int m=-l; m<=l; m++)
+	      for(int i=0; i<n; i++)
+		r.inc(m,i,v(m,i));
+	  }
+	});
+    }
+
+
+    // Transpose of reduce_cells: adds cell s of x to every cell of
+    // sample s of this ragged array. Samples own disjoint cell ranges,
+    // so the loop parallelizes over samples without write conflicts.
+    void broadcast_add_cells(const SO3partB_array& x, const GElibCellOffsets& offsets){
+      GELIB_CHECK(dev==0,"broadcast_add_cells is CPU only");
+      GELIB_ASSRT(x.getl()==getl() && x.getn()==getn());
+      const int l=getl();
+      const int n=getn();
+      const SO3part3_view xv=x.part3_view();
+      const SO3part3_view rv=part3_view();
+      GELIB_ASSRT(offsets.ncells()==rv.n0);
+      GELIB_ASSRT(offsets.nsamples()==xv.n0);
+      GElibMultiLoop(offsets.nsamples(),[&](const int s){
+	  SO3part2_view v=xv.slice0(s);
+	  for(int c=offsets.start(s); c<offsets.start(s)+offsets.size(s); c++){
+	    SO3part2_view r=rv.slice0(c);
+	    for(int m=-l; m<=l; m++)
+	      for(int i=0; i<n; i++)
+		r.inc(m,i,v(m,i));
+	  }
+	});
+    }
+
+
     /*
     SO3partB_array mprod(const CtensorB& y){
       assert(y.ndims()==2);
@@ -393,6 +827,37 @@ namespace GElib{
     }
 
 
+    // Batched-GEMM variant for the rectangular (identical adims) case:
+    // lowers the cellwise product onto strided-batched GEMM over the
+    // fused batch x cell dimension (see SO3part_addCGproduct_gemmFn).
+    void add_CGproduct_gemm(const SO3partB_array& x, const SO3partB_array& y, const int _offs=0){
+      GELIB_ASSRT(get_adims()==x.get_adims() && get_adims()==y.get_adims());
+      auto v=this->part3_view();
+      SO3part_addCGproduct_gemmFn()(v,x.part3_view(),y.part3_view(),_offs);
+    }
+
+
+    // Broadcast variants: one operand is a single part shared by every
+    // cell, read in place through a stride-0 view (broadcast_part3_view)
+    // with no O(cells) replication.
+    SO3partB_array CGproduct(const SO3partB& y, const int l) const{
+      assert(l>=abs(getl()-y.getl()) && l<=getl()+y.getl());
+      SO3partB_array R=SO3partB_array::zero(getb(),get_adims(),l,getn()*y.getn(),get_dev());
+      R.add_CGproduct(*this,y);
+      return R;
+    }
+
+    void add_CGproduct(const SO3partB_array& x, const SO3partB& y, const int _offs=0){
+      auto v=this->part3_view();
+      SO3part_addCGproductFn()(v,x.part3_view(),x.broadcast_part3_view(y),_offs);
+    }
+
+    void add_CGproduct(const SO3partB& x, const SO3partB_array& y, const int _offs=0){
+      auto v=this->part3_view();
+      SO3part_addCGproductFn()(v,y.broadcast_part3_view(x),y.part3_view(),_offs);
+    }
+
+
     void add_CGproduct(const SO3partB_array& x, const SO3partB_array& y, const int _offs=0){
       auto adims=get_adims();
       auto xadims=x.get_adims();
@@ -400,9 +865,13 @@ namespace GElib{
       int d=adims.size();
 
       if(adims==xadims && adims==yadims){
+	if(dev==0 && (cell_mask || x.cell_mask || y.cell_mask)){
+	  add_CGproduct_masked(x,y,_offs);
+	  return;
+	}
 	auto v=this->part3_view();
 	SO3part_addCGproductFn()(v,x.part3_view(),y.part3_view(),_offs);
-	return; 
+	return;
       }
       
       // matrix/vector case
@@ -429,6 +898,46 @@ namespace GElib{
 
     }
 
+    // Masked cellwise CG product: iterates the compact list of valid
+    // cells only, so padding cells cost nothing. The output inherits
+    // the mask (its invalid cells stay zero). The device kernels are
+    // dense, so masked arrays on the GPU go through the full grid.
+    void add_CGproduct_masked(const SO3partB_array& x, const SO3partB_array& y, const int _offs=0){
+      GELIB_CHECK(dev==0,"masked CGproduct is CPU only");
+      if(!cell_mask) cell_mask=(x.cell_mask? x.cell_mask: y.cell_mask);
+      const GElibCellMask& mask=*cell_mask;
+
+      const int l=getl();
+      const int l1=x.getl();
+      const int l2=y.getl();
+      const int N1=x.getn();
+      const int N2=y.getn();
+
+      auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+      const SO3part3_view xv=x.part3_view();
+      const SO3part3_view yv=y.part3_view();
+      const SO3part3_view rv=part3_view();
+      GELIB_ASSRT(mask.size()==rv.n0);
+
+      const vector<int>& act=mask.active();
+      GElibMultiLoop((int)act.size(),[&](const int i){
+	  const int b=act[i];
+	  SO3part2_view r=rv.slice0(b);
+	  SO3part2_view xs=xv.slice0(b);
+	  SO3part2_view ys=yv.slice0(b);
+	  int offs=_offs;
+	  for(int n1=0; n1<N1; n1++){
+	    for(auto& p:C.nonzeros){
+	      const complex<float> t=p.c*xs(p.m1-l1,n1);
+	      for(int n2=0; n2<N2; n2++)
+		r.inc(p.m-l,offs+n2,t*ys(p.m2-l2,n2));
+	    }
+	    offs+=N2;
+	  }
+	});
+    }
+
+
     void add_CGproduct_back0(const SO3partB_array& g, const SO3partB_array& y, const int _offs=0){
       auto v=this->part3_view();
       SO3part_addCGproduct_back0Fn()(v,g.part3_view(),y.part3_view(),_offs);
@@ -452,9 +961,46 @@ namespace GElib{
     }
 
     void add_BlockedCGproduct(const SO3partB_array& x, const SO3partB_array& y, const int bsize, const int _offs=0){
+      if(bsize==1 && dev==0 && (cell_mask || x.cell_mask || y.cell_mask)){
+	add_DiagCGproduct_masked(x,y,_offs);
+	return;
+      }
       SO3part_addBlockedCGproductFn()(part3_view(),x.part3_view(),y.part3_view(),bsize,_offs);
     }
 
+    // Masked diagonal CG product, as add_CGproduct_masked above.
+    void add_DiagCGproduct_masked(const SO3partB_array& x, const SO3partB_array& y, const int _offs=0){
+      GELIB_CHECK(dev==0,"masked DiagCGproduct is CPU only");
+      if(!cell_mask) cell_mask=(x.cell_mask? x.cell_mask: y.cell_mask);
+      const GElibCellMask& mask=*cell_mask;
+
+      const int l=getl();
+      const int l1=x.getl();
+      const int l2=y.getl();
+      const int N=x.getn();
+      GELIB_ASSRT(y.getn()==N);
+
+      auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+      const SO3part3_view xv=x.part3_view();
+      const SO3part3_view yv=y.part3_view();
+      const SO3part3_view rv=part3_view();
+      GELIB_ASSRT(mask.size()==rv.n0);
+
+      const vector<int>& act=mask.active();
+      GElibMultiLoop((int)act.size(),[&](const int i){
+	  const int b=act[i];
+	  SO3part2_view r=rv.slice0(b);
+	  SO3part2_view xs=xv.slice0(b);
+	  SO3part2_view ys=yv.slice0(b);
+	  for(int m1=-l1; m1<=l1; m1++)
+	    for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++){
+	      const float c=C(m1+l1,m2+l2);
+	      for(int n=0; n<N; n++)
+		r.inc(m1+m2,_offs+n,c*xs(m1,n)*ys(m2,n));
+	    }
+	});
+    }
+
     void add_BlockedCGproduct_back0(const SO3partB_array& g, const SO3partB_array& y, const int bsize, const int _offs=0){
       SO3part_addBlockedCGproduct_back0Fn()(part3_view(),g.part3_view(),y.part3_view(),bsize,_offs);
     }
@@ -475,6 +1021,15 @@ namespace GElib{
       add_BlockedCGproduct(x,y,1,_offs);
     }
 
+    // Broadcast variants, as for add_CGproduct above.
+    void add_DiagCGproduct(const SO3partB_array& x, const SO3partB& y, const int _offs=0){
+      SO3part_addBlockedCGproductFn()(part3_view(),x.part3_view(),x.broadcast_part3_view(y),1,_offs);
+    }
+
+    void add_DiagCGproduct(const SO3partB& x, const SO3partB_array& y, const int _offs=0){
+      SO3part_addBlockedCGproductFn()(part3_view(),y.broadcast_part3_view(x),y.part3_view(),1,_offs);
+    }
+
     void add_DiagCGproduct_back0(const SO3partB_array& g, const SO3partB_array& y, const int _offs=0){
       add_BlockedCGproduct_back0(g,y,1,_offs);
     }
@@ -524,6 +1079,33 @@ namespace GElib{
     }
 
 
+    // ---- Fused DiagCGproduct + mix ------------------------------------------------------------------------
+
+
+    SO3partB_array DiagCGproduct_mix(const SO3partB_array& y, const CtensorB& w, const int l) const{
+      assert(l>=abs(getl()-y.getl()) && l<=getl()+y.getl());
+      assert(getn()==y.getn());
+      assert(w.ndims()==2 && w.dims(0)==getn());
+      SO3partB_array R=SO3partB_array::zero(getb(),get_adims(),l,w.dims(1),get_dev());
+      R.add_DiagCGproduct_mix(*this,y,w);
+      return R;
+    }
+
+    // Fuses the diagonal CG product with a following channel mix into
+    // one pass per cell on the host, so the product fragment never
+    // leaves L1 (see SO3part_addDiagCGproductMixFn). On the device the
+    // two steps run unfused with a materialized intermediate.
+    void add_DiagCGproduct_mix(const SO3partB_array& x, const SO3partB_array& y, const CtensorB& w, const int _offs=0){
+      if(dev>0){
+	GELIB_ASSRT(_offs==0);
+	SO3partB_array T=x.DiagCGproductB(y,getl());
+	fused_view().add_mprod(T.fused_view(),w);
+	return;
+      }
+      SO3part_addDiagCGproductMixFn()(part3_view(),x.part3_view(),y.part3_view(),const_cast<CtensorB&>(w).view2(),_offs);
+    }
+
+
 
   public: // ---- I/O ----------------------------------------------------------------------------------------
 
@@ -0,0 +1,183 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3partB_int8
+#define _SO3partB_int8
+
+#include "GElib_base.hpp"
+#include "SO3partB.hpp"
+
+
+namespace GElib{
+
+  // Int8-quantized SO3partB for throughput-tier inference. Values are
+  // stored as interleaved re/im int8 pairs in a batched [b][2l+1][n][2]
+  // array with one float scale per part (value = scale*q, q in
+  // [-127,127]; -128 is never produced so negation is always safe).
+  // The cnine views are float-only, so like the half-precision path
+  // this is a self-contained container rather than a view type:
+  // quantize() converts from a host SO3partB, dequantize() back, and
+  // to_device()/to_host() move the raw buffer for the int8 CG kernels
+  // (see SO3part_addCGproductInt8Fn).
+
+  class SO3partB_int8{
+  public:
+
+    int b=0;
+    int l=0;
+    int n=0;
+    int dev=0;
+    float scale=1.0;
+
+    vector<int8_t> host;
+    int8_t* devptr=nullptr;
+
+
+    SO3partB_int8(){}
+
+    SO3partB_int8(const int _b, const int _l, const int _n, const float _scale, const int _dev=0):
+      b(_b), l(_l), n(_n), dev(_dev), scale(_scale){
+      if(dev==0) host.assign(asize(),0);
+#ifdef _WITH_CUDA
+      else{
+	CUDA_SAFE(cudaMalloc(&devptr,asize()));
+	CUDA_SAFE(cudaMemset(devptr,0,asize()));
+      }
+#endif
+    }
+
+    ~SO3partB_int8(){
+#ifdef _WITH_CUDA
+      if(devptr) cudaFree(devptr);
+#endif
+    }
+
+    SO3partB_int8(const SO3partB_int8& x)=delete;
+    SO3partB_int8& operator=(const SO3partB_int8& x)=delete;
+
+    SO3partB_int8(SO3partB_int8&& x):
+      b(x.b), l(x.l), n(x.n), dev(x.dev), scale(x.scale),
+      host(std::move(x.host)), devptr(x.devptr){
+      x.devptr=nullptr;
+    }
+
+    SO3partB_int8& operator=(SO3partB_int8&& x){
+#ifdef _WITH_CUDA
+      if(devptr) cudaFree(devptr);
+#endif
+      b=x.b; l=x.l; n=x.n; dev=x.dev; scale=x.scale;
+      host=std::move(x.host);
+      devptr=x.devptr;
+      x.devptr=nullptr;
+      return *this;
+    }
+
+
+  public: // ---- Quantization -------------------------------------------------------------------------------
+
+
+    // Symmetric per-part quantization: the scale is the absmax of the
+    // real and imaginary components over the whole part divided by 127.
+    static SO3partB_int8 quantize(const SO3partB& x){
+      GELIB_ASSRT(x.get_dev()==0);
+      const int l=x.getl();
+      const SO3part3_view xv=x.view();
+
+      float mx=0;
+      for(int _b=0; _b<xv.n0; _b++){
+	SO3part2_view v=xv.slice0(_b);
+	for(int m=-l; m<=l; m++)
+	  for(int i=0; i<xv.n2; i++){
+	    const complex<float> t=v(m,i);
+	    mx=std::max(mx,std::max(std::abs(t.real()),std::abs(t.imag())));
+	  }
+      }
+
+      SO3partB_int8 R(xv.n0,l,xv.n2,mx>0? mx/127.0f : 1.0f,0);
+      for(int _b=0; _b<xv.n0; _b++){
+	SO3part2_view v=xv.slice0(_b);
+	int8_t* p=R.host.data()+((size_t)_b)*(2*l+1)*R.n*2;
+	for(int m=-l; m<=l; m++)
+	  for(int i=0; i<xv.n2; i++){
+	    const complex<float> t=v(m,i);
+	    p[((m+l)*R.n+i)*2]=qround(t.real()/R.scale);
+	    p[((m+l)*R.n+i)*2+1]=qround(t.imag()/R.scale);
+	  }
+      }
+      return R;
+    }
+
+    SO3partB dequantize() const{
+      GELIB_ASSRT(dev==0);
+      SO3partB R(b,l,n,cnine::fill_zero(),0);
+      const SO3part3_view rv=R.view();
+      for(int _b=0; _b<b; _b++){
+	SO3part2_view v=rv.slice0(_b);
+	const int8_t* p=host.data()+((size_t)_b)*(2*l+1)*n*2;
+	for(int m=-l; m<=l; m++)
+	  for(int i=0; i<n; i++)
+	    v.set(m,i,scale*complex<float>(p[((m+l)*n+i)*2],p[((m+l)*n+i)*2+1]));
+      }
+      return R;
+    }
+
+
+  public: // ---- Transport ----------------------------------------------------------------------------------
+
+
+    SO3partB_int8 to_device(const int _dev) const{
+      SO3partB_int8 R(b,l,n,scale,_dev);
+#ifdef _WITH_CUDA
+      if(dev==0 && _dev>0){
+	CUDA_SAFE(cudaMemcpy(R.devptr,host.data(),asize(),cudaMemcpyHostToDevice));
+	return R;
+      }
+      if(dev>0 && _dev==0){
+	CUDA_SAFE(cudaMemcpy(R.host.data(),devptr,asize(),cudaMemcpyDeviceToHost));
+	return R;
+      }
+      if(dev>0 && _dev>0){
+	CUDA_SAFE(cudaMemcpy(R.devptr,devptr,asize(),cudaMemcpyDeviceToDevice));
+	return R;
+      }
+#endif
+      GELIB_ASSRT(dev==0 && _dev==0);
+      R.host=host;
+      return R;
+    }
+
+
+  public: // ---- Access -------------------------------------------------------------------------------------
+
+
+    size_t asize() const{
+      return ((size_t)b)*(2*l+1)*n*2;
+    }
+
+    int8_t* get_arr(){
+      if(dev==0) return host.data();
+      return devptr;
+    }
+
+    const int8_t* get_arr() const{
+      if(dev==0) return host.data();
+      return devptr;
+    }
+
+    static int8_t qround(const float x){
+      const long t=std::lround(x);
+      return (int8_t)std::max<long>(-127,std::min<long>(127,t));
+    }
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,224 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3partB_real
+#define _SO3partB_real
+
+#include <cstdlib>
+#include <cstring>
+
+#include "GElib_base.hpp"
+#include "GElibMemoryMonitor.hpp"
+#include "GElibThreadPool.hpp"
+#include "SO3part3_view.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+
+
+namespace GElib{
+
+  // Conjugate-symmetry compressed part for real signals. The Fourier
+  // coefficients of a real spherical field satisfy
+  //
+  //   f(l,-m) = (-1)^m conj(f(l,m))
+  //
+  // (Condon-Shortley convention), so only the m>=0 rows carry
+  // information; this container stores just those l+1 rows in the
+  // planar layout [b][l+1][n], real plane followed by imaginary,
+  // roughly halving memory and bandwidth relative to SO3partB. Rows
+  // are indexed by m=0..l; the accessor materializes negative m
+  // through the symmetry.
+  //
+  // add_CGproduct consumes and produces compressed parts directly: the
+  // CG product of two real fields is again real, so only the m>=0
+  // output rows are computed, with negative-m input values derived on
+  // the fly -- the symmetry halves the arithmetic as well as the
+  // storage. Ops without a symmetry-aware kernel yet (the Fproduct and
+  // FFT families) interoperate through expand_into()/compress(), which
+  // keeps fields compressed at rest and expands per call. CPU only.
+
+  class SO3partB_real{
+  public:
+
+    int b;
+    int l;
+    int n;
+    float* arr=nullptr;
+    size_t plane=0;   // floats per plane, b*(l+1)*n
+    GElibMemoryHold mem_hold;
+
+
+    SO3partB_real(){}
+
+    SO3partB_real(const int _b, const int _l, const int _n):
+      b(_b), l(_l), n(_n){
+      plane=((size_t)b)*(l+1)*n;
+      arr=(float*)std::aligned_alloc(64,((2*plane*sizeof(float)+63)/64)*64);
+      std::memset(arr,0,2*plane*sizeof(float));
+      mem_hold.set("SO3partB_real",0,((long long)2*plane)*sizeof(float));
+    }
+
+    ~SO3partB_real(){
+      if(arr) std::free(arr);
+    }
+
+    SO3partB_real(const SO3partB_real& x):
+      SO3partB_real(x.b,x.l,x.n){
+      GELIB_COPY_WARNING();
+      std::memcpy(arr,x.arr,2*plane*sizeof(float));
+    }
+
+    SO3partB_real(SO3partB_real&& x):
+      b(x.b), l(x.l), n(x.n), arr(x.arr), plane(x.plane), mem_hold(std::move(x.mem_hold)){
+      x.arr=nullptr;
+    }
+
+    SO3partB_real& operator=(const SO3partB_real& x)=delete;
+
+    static SO3partB_real zero(const int _b, const int _l, const int _n){
+      return SO3partB_real(_b,_l,_n);
+    }
+
+    // Keeps the m>=0 rows of a full part; the caller is responsible
+    // for x actually representing a real signal.
+    static SO3partB_real compress(const SO3part3_view& x){
+      GELIB_CHECK(x.dev==0,"SO3partB_real is CPU only");
+      SO3partB_real R(x.n0,x.getl(),x.n2);
+      for(int ib=0; ib<R.b; ib++)
+	for(int m=0; m<=R.l; m++)
+	  for(int i=0; i<R.n; i++)
+	    R.set(ib,m,i,const_cast<SO3part3_view&>(x)(ib,m,i));
+      return R;
+    }
+
+    // Materializes the full 2l+1 rows into a preallocated part view,
+    // deriving the m<0 rows through the conjugate symmetry.
+    void expand_into(const SO3part3_view& r) const{
+      GELIB_CHECK(r.dev==0,"SO3partB_real is CPU only");
+      GELIB_ASSRT(r.n0==b && r.getl()==l && r.n2==n);
+      SO3part3_view& rr=const_cast<SO3part3_view&>(r);
+      for(int ib=0; ib<b; ib++)
+	for(int m=0; m<=l; m++){
+	  const float sg=(m%2==0)? 1 : -1;
+	  for(int i=0; i<n; i++){
+	    const complex<float> v=(*this)(ib,m,i);
+	    rr.set(ib,m,i,v);
+	    if(m>0) rr.set(ib,-m,i,sg*std::conj(v));
+	  }
+	}
+    }
+
+
+  public: // ---- Access -------------------------------------------------------------------------------------
+
+
+    int getb() const{
+      return b;
+    }
+
+    int getl() const{
+      return l;
+    }
+
+    int getn() const{
+      return n;
+    }
+
+    // m may be negative; the symmetry is applied on the fly.
+    complex<float> operator()(const int ib, const int m, const int i) const{
+      if(m>=0){
+	const size_t t=(((size_t)ib)*(l+1)+m)*n+i;
+	return complex<float>(arr[t],arr[plane+t]);
+      }
+      const size_t t=(((size_t)ib)*(l+1)-m)*n+i;
+      const float sg=(m%2==0)? 1 : -1;
+      return complex<float>(sg*arr[t],-sg*arr[plane+t]);
+    }
+
+    // m>=0 only.
+    void set(const int ib, const int m, const int i, const complex<float> v){
+      const size_t t=(((size_t)ib)*(l+1)+m)*n+i;
+      arr[t]=std::real(v);
+      arr[plane+t]=std::imag(v);
+    }
+
+    void inc(const int ib, const int m, const int i, const complex<float> v){
+      const size_t t=(((size_t)ib)*(l+1)+m)*n+i;
+      arr[t]+=std::real(v);
+      arr[plane+t]+=std::imag(v);
+    }
+
+
+  public: // ---- Operations ---------------------------------------------------------------------------------
+
+
+    // r += CG(x,y) restricted to the m>=0 output rows, the rest being
+    // implied. The nonzero sweep is the same as in the full kernel but
+    // skips the negative output m entirely and reads negative-m input
+    // values through the symmetry accessor, so both the arithmetic and
+    // the traffic are roughly halved. offs is the output channel
+    // offset, as in the full Fn.
+    void add_CGproduct(const SO3partB_real& x, const SO3partB_real& y, const int _offs=0){
+      const int l1=x.l;
+      const int l2=y.l;
+      GELIB_ASSRT(l>=std::abs(l1-l2) && l<=l1+l2);
+      GELIB_ASSRT(x.b==b && y.b==b);
+      GELIB_ASSRT(_offs+x.n*y.n<=n);
+
+      auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+      const int N1=x.n;
+      const int N2=y.n;
+
+      GElibMultiLoop(b,[&](const int ib){
+	  int offs=_offs;
+	  for(int n1=0; n1<N1; n1++){
+	    for(auto& e:C.nonzeros){
+	      if(e.m-l<0) continue;
+	      const complex<float> u=e.c*x(ib,e.m1-l1,n1);
+	      for(int n2=0; n2<N2; n2++)
+		inc(ib,e.m-l,offs+n2,u*y(ib,e.m2-l2,n2));
+	    }
+	    offs+=N2;
+	  }
+	});
+    }
+
+    SO3partB_real CGproduct(const SO3partB_real& y, const int _l) const{
+      SO3partB_real R(b,_l,n*y.n);
+      R.add_CGproduct(*this,y);
+      return R;
+    }
+
+
+  public: // ---- I/O ----------------------------------------------------------------------------------------
+
+
+    string str(const string indent="") const{
+      ostringstream oss;
+      for(int ib=0; ib<b; ib++){
+	oss<<indent<<"b="<<ib<<":"<<endl;
+	for(int m=0; m<=l; m++){
+	  oss<<indent<<"  [ ";
+	  for(int i=0; i<n; i++) oss<<(*this)(ib,m,i)<<" ";
+	  oss<<"]"<<endl;
+	}
+      }
+      return oss.str();
+    }
+
+    friend ostream& operator<<(ostream& stream, const SO3partB_real& x){
+      stream<<x.str(); return stream;
+    }
+
+  };
+
+}
+
+#endif
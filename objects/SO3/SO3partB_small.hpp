@@ -0,0 +1,172 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3partB_small
+#define _SO3partB_small
+
+#include <cstring>
+
+#include "GElib_base.hpp"
+#include "GElibConfig.hpp"
+#include "GElibMemoryMonitor.hpp"
+#include "SO3part3_view.hpp"
+#include "SO3part_addCGproductFn.hpp"
+
+extern default_random_engine rndGen;
+
+
+namespace GElib{
+
+  // Small-buffer counterpart of SO3partB for the l<=1 parts that
+  // models create by the millions as scalars and vectors: as long as
+  // both complex planes fit in GELIB_SO3PART_SMALL_BYTES the data
+  // lives in a buffer embedded in the object itself, so constructing
+  // and destroying the part touches no allocator at all. Larger parts
+  // transparently fall back to the heap. SO3partB itself cannot carry
+  // an inline mode because its storage is managed by the cnine tensor
+  // base class, so this is a drop-in host-side type instead: it
+  // exposes the same [b][2l+1][n] shape as an SO3part3_view (in the
+  // planar layout, see SO3part3_view::planar()), through which the
+  // entire Fn kernel layer operates on it unchanged.
+
+  class SO3partB_small{
+  public:
+
+    static constexpr size_t small_floats=GELIB_SO3PART_SMALL_BYTES/sizeof(float);
+
+    int b;
+    int l;
+    int n;
+    size_t asize=0;    // total floats, both planes
+    float* arr=nullptr;
+    float buf[small_floats];
+    GElibMemoryHold mem_hold;
+
+
+    SO3partB_small(const int _b, const int _l, const int _n):
+      b(_b), l(_l), n(_n){
+      asize=2*((size_t)b)*(2*l+1)*n;
+      if(asize<=small_floats) arr=buf;
+      else arr=new float[asize];
+      std::memset(arr,0,asize*sizeof(float));
+      mem_hold.set("SO3partB_small",0,((long long)asize)*sizeof(float));
+    }
+
+    ~SO3partB_small(){
+      if(arr && arr!=buf) delete[] arr;
+    }
+
+    SO3partB_small(const SO3partB_small& x):
+      SO3partB_small(x.b,x.l,x.n){
+      std::memcpy(arr,x.arr,asize*sizeof(float));
+    }
+
+    SO3partB_small(SO3partB_small&& x):
+      b(x.b), l(x.l), n(x.n), asize(x.asize), mem_hold(std::move(x.mem_hold)){
+      if(x.arr==x.buf){
+	arr=buf;
+	std::memcpy(buf,x.buf,asize*sizeof(float));
+      }else{
+	arr=x.arr;
+	x.arr=nullptr;
+      }
+    }
+
+    SO3partB_small& operator=(const SO3partB_small& x)=delete;
+
+
+  public: // ---- Named constructors -------------------------------------------------------------------------
+
+
+    static SO3partB_small zero(const int _b, const int _l, const int _n){
+      return SO3partB_small(_b,_l,_n);
+    }
+
+    static SO3partB_small gaussian(const int _b, const int _l, const int _n){
+      SO3partB_small R(_b,_l,_n);
+      normal_distribution<double> distr;
+      for(size_t i=0; i<R.asize; i++) R.arr[i]=distr(rndGen);
+      return R;
+    }
+
+
+  public: // ---- Access ------------------------------------------------------------------------------------
+
+
+    int getb() const{
+      return b;
+    }
+
+    int getl() const{
+      return l;
+    }
+
+    int getn() const{
+      return n;
+    }
+
+    bool is_small() const{
+      return arr==buf;
+    }
+
+    // Number of floats in one plane.
+    size_t plane_size() const{
+      return ((size_t)b)*(2*l+1)*n;
+    }
+
+    SO3part3_view view() const{
+      return SO3part3_view(arr,arr+plane_size(),b,2*l+1,n,(2*l+1)*n,n,1,0);
+    }
+
+    complex<float> operator()(const int _b, const int m, const int i) const{
+      return view()(_b,m,i);
+    }
+
+
+  public: // ---- Operations ---------------------------------------------------------------------------------
+
+
+    void set_zero(){
+      std::memset(arr,0,asize*sizeof(float));
+    }
+
+    void add(const SO3partB_small& x, const float c=1.0){
+      GELIB_ASSRT(x.asize==asize);
+      for(size_t i=0; i<asize; i++) arr[i]+=c*x.arr[i];
+    }
+
+    void add_CGproduct(const SO3partB_small& x, const SO3partB_small& y, const int _offs=0){
+      SO3part_addCGproductFn()(view(),x.view(),y.view(),_offs);
+    }
+
+    SO3partB_small CGproduct(const SO3partB_small& y, const int _l) const{
+      GELIB_ASSRT(_l>=abs(l-y.l) && _l<=l+y.l);
+      SO3partB_small R(b,_l,n*y.n);
+      R.add_CGproduct(*this,y);
+      return R;
+    }
+
+
+  public: // ---- I/O ----------------------------------------------------------------------------------------
+
+
+    string str(const string indent="") const{
+      return view().str(indent);
+    }
+
+    friend ostream& operator<<(ostream& stream, const SO3partB_small& x){
+      stream<<x.str(); return stream;
+    }
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,161 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3rotationGridBank
+#define _SO3rotationGridBank
+
+#include "CtensorB.hpp"
+#include "SO3element.hpp"
+#include "WignerMatrix.hpp"
+#include "SO3partB.hpp"
+#include "SO3vecB.hpp"
+#include "SO3part_addRotateFn.hpp"
+
+
+namespace GElib{
+
+  // Precomputed rotation grid for data augmentation. Where WignerBank
+  // caches the D-matrices of whatever rotations it happens to see,
+  // this bank fixes a quasi-uniform grid of SO3 elements up front and
+  // precomputes their Wigner matrices for every l<=maxl, stacked per l
+  // into one (ngrid,2l+1,2l+1) tensor with a lazily created
+  // device-resident copy. Augmentation then draws a rotation by index:
+  // no Euler angles are sampled, no Wigner recursions run and nothing
+  // is uploaded at batch time -- applying the rotation is the same
+  // batched GEMM as SO3part_addRotateFn against a slice of the
+  // resident stack.
+  //
+  // The grid follows the R3 low-discrepancy sequence in
+  // (phi, cos(theta), psi), the coordinates in which the Haar measure
+  // of SO(3) is uniform, so any contiguous index range is itself a
+  // near-uniform cover of the group.
+
+  class SO3rotationGridBank{
+  private:
+
+    typedef cnine::CtensorB Ctensor;
+
+    int ngrid=0;
+    int maxl=0;
+
+    vector<SO3element> elements;
+    vector<Ctensor*> stacks;     // per l: (ngrid,2l+1,2l+1), host
+    vector<Ctensor*> stacksC;    // device copies, created on first use
+
+    mutex safety_mxC;
+
+
+  public:
+
+    SO3rotationGridBank(const int _ngrid, const int _maxl):
+      ngrid(_ngrid), maxl(_maxl), stacksC(_maxl+1,nullptr){
+
+      // Plastic-number (R3) sequence over the unit cube.
+      const double g=1.2207440846057595;
+      const double a1=1.0/g;
+      const double a2=1.0/(g*g);
+      const double a3=1.0/(g*g*g);
+      for(int i=0; i<ngrid; i++){
+	const double u=std::fmod(0.5+a1*(i+1),1.0);
+	const double v=std::fmod(0.5+a2*(i+1),1.0);
+	const double w=std::fmod(0.5+a3*(i+1),1.0);
+	elements.push_back(SO3element(2.0*M_PI*u,std::acos(1.0-2.0*v),2.0*M_PI*w));
+      }
+
+      for(int l=0; l<=maxl; l++){
+	Ctensor* S=new Ctensor(cnine::Gdims(ngrid,2*l+1,2*l+1),cnine::fill_zero(),0);
+	auto v=S->view3();
+	for(int i=0; i<ngrid; i++){
+	  WignerMatrix<float> D(l,elements[i]);
+	  for(int m1=0; m1<2*l+1; m1++)
+	    for(int m2=0; m2<2*l+1; m2++)
+	      v.inc(i,m1,m2,D(m1,m2));
+	}
+	stacks.push_back(S);
+      }
+    }
+
+    ~SO3rotationGridBank(){
+      for(auto p:stacks) delete p;
+      for(auto p:stacksC) delete p;
+    }
+
+    SO3rotationGridBank(const SO3rotationGridBank& x)=delete;
+    SO3rotationGridBank& operator=(const SO3rotationGridBank& x)=delete;
+
+
+  public: // ---- Access -------------------------------------------------------------------------------------
+
+
+    int size() const{
+      return ngrid;
+    }
+
+    int get_maxl() const{
+      return maxl;
+    }
+
+    const SO3element& element(const int i) const{
+      GELIB_ASSRT(i>=0 && i<ngrid);
+      return elements[i];
+    }
+
+    // The full (ngrid,2l+1,2l+1) stack for batched-GEMM consumers.
+    const Ctensor& Dstack(const int l, const int dev=0){
+      GELIB_ASSRT(l>=0 && l<=maxl);
+      if(dev==0) return *stacks[l];
+      lock_guard<mutex> lock(safety_mxC);
+      if(!stacksC[l]) stacksC[l]=new Ctensor(*stacks[l],dev);
+      return *stacksC[l];
+    }
+
+    cnine::Ctensor2_view D(const int l, const int i, const int dev=0){
+      GELIB_ASSRT(i>=0 && i<ngrid);
+      return const_cast<Ctensor&>(Dstack(l,dev)).view3().slice0(i);
+    }
+
+
+  public: // ---- Operations ---------------------------------------------------------------------------------
+
+
+    SO3partB rotate(const SO3partB& x, const int i){
+      SO3partB R=SO3partB::zero(x.getb(),x.getl(),x.getn(),x.get_dev());
+      SO3part_addRotateFn()(R.view3(),x.view3(),D(x.getl(),i,x.get_dev()));
+      return R;
+    }
+
+    SO3vecB rotate(const SO3vecB& x, const int i){
+      SO3vecB R;
+      for(int l=0; l<(int)x.parts.size(); l++)
+	if(x.parts[l]) R.parts.push_back(new SO3partB(rotate(*x.parts[l],i)));
+	else R.parts.push_back(nullptr);
+      return R;
+    }
+
+    // Per-sample draw: batch row b is rotated by grid element ix[b].
+    SO3vecB rotate(const SO3vecB& x, const vector<int>& ix){
+      GELIB_ASSRT((int)ix.size()==x.getb());
+      SO3vecB R=SO3vecB::zero(x.getb(),x.get_tau(),x.get_dev());
+      for(int l=0; l<(int)x.parts.size(); l++){
+	if(!x.parts[l]) continue;
+	for(int b=0; b<x.getb(); b++){
+	  SO3partB rb=R.parts[l]->batch_slice(b,b+1);
+	  SO3partB xb=x.parts[l]->batch_slice(b,b+1);
+	  SO3part_addRotateFn()(rb.view3(),xb.view3(),D(l,ix[b],x.get_dev()));
+	}
+      }
+      return R;
+    }
+
+  };
+
+}
+
+#endif
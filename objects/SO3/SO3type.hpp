@@ -11,6 +11,9 @@
 #ifndef _SO3type
 #define _SO3type
 
+#include <unordered_set>
+#include <tuple>
+
 #include "GElib_base.hpp"
 #include "GdimsPack.hpp"
 #include "CtensorPackObj.hpp"
@@ -272,6 +275,67 @@ namespace std{
 }
 
 
+namespace GElib{
+
+  // ---- Interned types and memoized shape inference --------------------------------------------------------
+
+
+  // Hash-consed type pool backing the memoized shape arithmetic below:
+  // intern() returns the unique pooled copy of a type, giving repeated
+  // shape inference a stable address to key on instead of re-deriving
+  // whole vectors. Pooled entries are never freed (the set of distinct
+  // types a program uses is small), so the returned references stay
+  // valid for the life of the process. Guarded by a plain mutex: shape
+  // inference runs in the layer-call driver loop, never inside the
+  // kernel hot paths.
+  class SO3typePool{
+  public:
+
+    mutex mx;
+    std::unordered_set<SO3type> types;
+    std::map<std::tuple<const SO3type*,const SO3type*,int>,const SO3type*> products;
+
+    const SO3type& intern(const SO3type& tau){
+      lock_guard<mutex> lock(mx);
+      return *types.insert(tau).first;
+    }
+
+    const SO3type& cg_product(const SO3type& t1, const SO3type& t2, const int maxl){
+      const SO3type* p1;
+      const SO3type* p2;
+      {
+	lock_guard<mutex> lock(mx);
+	p1=&*types.insert(t1).first;
+	p2=&*types.insert(t2).first;
+	auto it=products.find(std::make_tuple(p1,p2,maxl));
+	if(it!=products.end()) return *it->second;
+      }
+      const SO3type R=CGproduct(*p1,*p2,maxl);
+      lock_guard<mutex> lock(mx);
+      const SO3type* rp=&*types.insert(R).first;
+      products[std::make_tuple(p1,p2,maxl)]=rp;
+      return *rp;
+    }
+
+  };
+
+  inline SO3typePool SO3type_pool;
+
+  inline const SO3type& SO3type_intern(const SO3type& tau){
+    return SO3type_pool.intern(tau);
+  }
+
+  // Memoized CGproduct type arithmetic: after the first call with a
+  // given (tau1,tau2,maxl) the output type is a pooled lookup with no
+  // recomputation, so a layer re-deriving its shapes on every call
+  // pays two set probes instead of the triple l-loop.
+  inline const SO3type& CGproduct_cached(const SO3type& t1, const SO3type& t2, const int _maxl=-1){
+    return SO3type_pool.cg_product(t1,t2,_maxl);
+  }
+
+}
+
+
 
 
 #endif
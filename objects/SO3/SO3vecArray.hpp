@@ -477,18 +477,28 @@ namespace GElib{
   public: // ---- Binary operators ---------------------------------------------------------------------------
 
 
-    SO3vecArray operator+(const SO3vecArray& y) const{
+    SO3vecArray operator+(const SO3vecArray& y) const &{
       SO3vecArray R(*this);
       R.add(y);
       return R;
     }
 
-    SO3vecArray operator-( const SO3vecArray& y) const{
+    SO3vecArray operator+(const SO3vecArray& y) &&{
+      add(y);
+      return std::move(*this);
+    }
+
+    SO3vecArray operator-( const SO3vecArray& y) const &{
       SO3vecArray R(*this);
       R.subtract(y);
       return R;
     }
 
+    SO3vecArray operator-(const SO3vecArray& y) &&{
+      subtract(y);
+      return std::move(*this);
+    }
+
     SO3vecArray operator*(const cscalar& c) const{
       SO3vecArray R(*this,cnine::fill::zero);
       R.add(*this,c);
@@ -19,6 +19,13 @@
 
 #include "SO3_addFFT_Fn.hpp"
 #include "SO3_addIFFT_Fn.hpp"
+#include "SO3FFTPlan.hpp"
+#include "SO3vec_addCGproductFn.hpp"
+#include "SO3vec_inpTableFn.hpp"
+#include "GElibGradArena.hpp"
+#include "SO3CGproductPlan.hpp"
+#include "GElibTaskGraph.hpp"
+#include "ArithmeticExpr.hpp"
 
 #include "CtensorPackObj.hpp"
 
@@ -115,6 +122,18 @@ namespace GElib{
       return SO3vecB(b,tau,cnine::fill_gaussian(),_dev);}
     
 
+    // Wraps caller-owned per-part buffers in a non-owning vector
+    // without copying; arrs[l] must follow the layout documented in
+    // SO3partB::view_of and outlive the returned object.
+    static SO3vecB view_of(const int b, const SO3type& tau, const vector<float*>& arrs, const int _dev=0){
+      GELIB_ASSRT(arrs.size()==tau.size());
+      SO3vecB R;
+      for(int l=0; l<tau.size(); l++)
+	R.parts.push_back(new SO3partB(SO3partB::view_of(b,l,tau[l],arrs[l],_dev)));
+      return R;
+    }
+
+
     static SO3vecB Fraw(const int maxl){
       return SO3vecB(1,maxl,cnine::fill_raw());}
     static SO3vecB Fzero(const int maxl){
@@ -202,6 +221,104 @@ namespace GElib{
     }
 
 
+    // Whole-object transport: all parts are packed into one leased
+    // pinned buffer and cross the bus in a single transfer, then
+    // unpacked on the far side with device-local copies, so a 12-part
+    // vec pays one transfer latency instead of twelve. Device-device
+    // moves and non-CUDA builds fall back to the per-part path (a
+    // per-part cudaMemcpy between devices is already peer-to-peer and
+    // carries no bus latency to amortize).
+    SO3vecB to_device_fused(const int _dev) const{
+#ifdef _WITH_CUDA
+      const int cur=get_dev();
+      if(parts.size()>0 && cur!=_dev && (cur==0)!=(_dev==0)){
+	SO3vecB R;
+	R.parts=fused_transport(parts,_dev);
+	return R;
+      }
+#endif
+      return to_device(_dev);
+    }
+
+
+    // Batched variant: every part of every vec crosses the bus in the
+    // same single transfer, so a whole model's worth of handoffs pays
+    // one latency. The vecs must live on a common device.
+    static vector<SO3vecB*> batch_to_device(const vector<SO3vecB*>& xs, const int _dev){
+      vector<SO3vecB*> R;
+#ifdef _WITH_CUDA
+      if(xs.size()>0 && xs[0]->parts.size()>0){
+	const int cur=xs[0]->get_dev();
+	if(cur!=_dev && (cur==0)!=(_dev==0)){
+	  vector<SO3partB*> flat;
+	  for(auto v:xs){
+	    GELIB_ASSRT(v->get_dev()==cur);
+	    for(auto p:v->parts) flat.push_back(p);
+	  }
+	  vector<SO3partB*> moved=fused_transport(flat,_dev);
+	  int i=0;
+	  for(auto v:xs){
+	    SO3vecB* r=new SO3vecB();
+	    for(int l=0; l<(int)v->parts.size(); l++)
+	      r->parts.push_back(moved[i++]);
+	    R.push_back(r);
+	  }
+	  return R;
+	}
+      }
+#endif
+      for(auto v:xs) R.push_back(new SO3vecB(v->to_device(_dev)));
+      return R;
+    }
+
+
+#ifdef _WITH_CUDA
+  private:
+
+    // Shared core of the fused transport paths: copies each source
+    // part into a new part on _dev, staging every payload through one
+    // pinned buffer so only a single cudaMemcpy crosses the bus; the
+    // pack/unpack on the host side runs on the thread pool and on the
+    // device side as cheap device-local copies.
+    static vector<SO3partB*> fused_transport(const vector<SO3partB*>& srcs, const int _dev){
+      const int cur=srcs[0]->get_dev();
+      size_t total=0;
+      vector<size_t> offs;
+      for(auto p:srcs){
+	GELIB_ASSRT(p->get_dev()==cur);
+	offs.push_back(total);
+	total+=p->memsize;
+      }
+
+      GElibCudaStagingPool::BufferSet* set=gelib_cuda_staging.acquire(total,0,0);
+      vector<SO3partB*> R;
+      for(auto p:srcs)
+	R.push_back(new SO3partB(SO3partB::raw(p->getb(),p->getl(),p->getn(),_dev)));
+
+      if(cur==0){
+	GElibMultiLoop((int)srcs.size(),[&](const int i){
+	    std::memcpy(set->xstage+offs[i],srcs[i]->arr,srcs[i]->memsize*sizeof(float));
+	  });
+	CUDA_SAFE(cudaMemcpy(set->xbuf,set->xstage,total*sizeof(float),cudaMemcpyHostToDevice));
+	for(int i=0; i<(int)srcs.size(); i++)
+	  CUDA_SAFE(cudaMemcpy(R[i]->arrg,set->xbuf+offs[i],srcs[i]->memsize*sizeof(float),cudaMemcpyDeviceToDevice));
+      }else{
+	for(int i=0; i<(int)srcs.size(); i++)
+	  CUDA_SAFE(cudaMemcpy(set->xbuf+offs[i],srcs[i]->arrg,srcs[i]->memsize*sizeof(float),cudaMemcpyDeviceToDevice));
+	CUDA_SAFE(cudaMemcpy(set->xstage,set->xbuf,total*sizeof(float),cudaMemcpyDeviceToHost));
+	GElibMultiLoop((int)srcs.size(),[&](const int i){
+	    std::memcpy(R[i]->arr,set->xstage+offs[i],srcs[i]->memsize*sizeof(float));
+	  });
+      }
+
+      gelib_cuda_staging.release(set);
+      return R;
+    }
+
+  public:
+#endif
+
+
   public: // ---- ATen --------------------------------------------------------------------------------------
 
 
@@ -289,11 +406,72 @@ namespace GElib{
 	parts[l]->add(*x.parts[l]);
     }
 
+    // Coefficient-weighted accumulation; also the per-term primitive of
+    // the lazy LinearVecExpr layer (see ArithmeticExpr.hpp).
+    void add(const SO3vecB& x, const complex<float> c){
+      assert(parts.size()==x.parts.size());
+      for(int l=0; l<parts.size(); l++)
+	parts[l]->add(*x.parts[l],c);
+    }
+
+    // Fused linear combination: accumulates sum_i c_i*v_i into this in
+    // a single sweep over the output. Term-by-term adds re-read and
+    // re-write every part once per operand; here each output page is
+    // walked across all operands while it sits in cache, so optimizer
+    // updates and residual connections touch memory once however many
+    // terms they combine. This is what LinearVecExpr evaluates into.
+    // On the device the terms fall back to part-level adds.
+    void add_linear(const vector<std::pair<complex<float>,const SO3vecB*> >& terms){
+      if(get_dev()>0){
+	for(auto& t:terms) add(*t.second,t.first);
+	return;
+      }
+      const int nterms=terms.size();
+      for(int l=0; l<parts.size(); l++){
+	SO3partB& r=*parts[l];
+	const long n=r.dims.total();
+	vector<const float*> xre(nterms);
+	vector<const float*> xim(nterms);
+	for(int i=0; i<nterms; i++){
+	  const SO3partB& x=*terms[i].second->parts[l];
+	  assert(x.dims==r.dims);
+	  xre[i]=x.arr;
+	  xim[i]=x.arr+x.coffs;
+	}
+	float* rre=r.arr;
+	float* rim=r.arr+r.coffs;
+	const long page_floats=4096/sizeof(float);
+	const long npages=(n+page_floats-1)/page_floats;
+	GElibMultiLoopStatic(npages,[&](const int p){
+	    const long beg=((long)p)*page_floats;
+	    const long end=std::min<long>(beg+page_floats,n);
+	    for(int i=0; i<nterms; i++){
+	      const float cr=terms[i].first.real();
+	      const float ci=terms[i].first.imag();
+	      const float* ar=xre[i];
+	      const float* ai=xim[i];
+	      if(ci==0){
+		for(long j=beg; j<end; j++) rre[j]+=cr*ar[j];
+		for(long j=beg; j<end; j++) rim[j]+=cr*ai[j];
+	      }else{
+		for(long j=beg; j<end; j++) rre[j]+=cr*ar[j]-ci*ai[j];
+		for(long j=beg; j<end; j++) rim[j]+=cr*ai[j]+ci*ar[j];
+	      }
+	    }
+	  });
+      }
+    }
+
+    void set_zero(){
+      for(auto p:parts)
+	p->set_zero();
+    }
+
 
     // ---- Operations ---------------------------------------------------------------------------------------
 
 
-    SO3vecB operator+(const SO3vecB& y) const{
+    SO3vecB operator+(const SO3vecB& y) const &{
       SO3vecB R;
       for(int l=0; l<parts.size(); l++){
 	R.parts.push_back(new SO3partB((*parts[l])+(*y.parts[l])));
@@ -301,8 +479,16 @@ namespace GElib{
       return R;
     }
 
+    // When the left operand is a temporary (as in chained expressions
+    // like x.CGproduct(y)+r) its buffers are reused in place instead of
+    // materializing a fresh vector.
+    SO3vecB operator+(const SO3vecB& y) &&{
+      add(y);
+      return std::move(*this);
+    }
+
 
-    SO3vecB operator-(const SO3vecB& y) const{
+    SO3vecB operator-(const SO3vecB& y) const &{
       SO3vecB R;
       for(int l=0; l<parts.size(); l++){
 	R.parts.push_back(new SO3partB((*parts[l])-(*y.parts[l])));
@@ -310,6 +496,13 @@ namespace GElib{
       return R;
     }
 
+    SO3vecB operator-(const SO3vecB& y) &&{
+      assert(parts.size()==y.parts.size());
+      for(int l=0; l<parts.size(); l++)
+	parts[l]->subtract(*y.parts[l]);
+      return std::move(*this);
+    }
+
     SO3vecB operator/(const SO3vecB& y) const{
       SO3vecB R;
       assert(y.parts.size()==parts.size());
@@ -320,6 +513,36 @@ namespace GElib{
     }
 
 
+    // ---- Lazy expressions ---------------------------------------------------------------------------------
+
+
+    // Scalar multiples and sums or differences of scalar multiples
+    // build a lazy LinearVecExpr instead of evaluating node by node;
+    // the whole chain collapses into a single accumulation sweep when
+    // the expression is assigned back to an SO3vecB (see
+    // ArithmeticExpr.hpp), so a+2.0f*b-0.5f*c materializes one vector.
+
+    LinearVecExpr<SO3vecB> operator*(const complex<float> c) const{
+      return LinearVecExpr<SO3vecB>(*this,c);
+    }
+
+    friend LinearVecExpr<SO3vecB> operator*(const complex<float> c, const SO3vecB& x){
+      return LinearVecExpr<SO3vecB>(x,c);
+    }
+
+    LinearVecExpr<SO3vecB> operator+(const LinearVecExpr<SO3vecB>& y) const{
+      return LinearVecExpr<SO3vecB>(*this)+y;
+    }
+
+    LinearVecExpr<SO3vecB> operator-(const LinearVecExpr<SO3vecB>& y) const{
+      return LinearVecExpr<SO3vecB>(*this)-y;
+    }
+
+    void operator+=(const LinearVecExpr<SO3vecB>& e){
+      e.add_into(*this);
+    }
+
+
     // ---- Products -----------------------------------------------------------------------------------------
 
 
@@ -368,6 +591,48 @@ namespace GElib{
     }
 
 
+    // ---- Batch slicing ------------------------------------------------------------------------------------
+
+
+    // Non-owning view of batch rows [beg,end): every part shares the
+    // parent's buffer (see SO3partB::batch_slice), so microbatching for
+    // gradient accumulation slices the data for free instead of
+    // materializing sub-tensors. The returned vec is accepted by the
+    // whole Fn kernel surface; the parent must outlive it.
+    SO3vecB batch_slice(const int beg, const int end) const{
+      SO3vecB R;
+      for(auto p:parts)
+	R.parts.push_back(new SO3partB(p->batch_slice(beg,end)));
+      return R;
+    }
+
+
+    // ---- Invariants ---------------------------------------------------------------------------------------
+
+
+    // Invariant inner-product table: a b x sum_l tau_l tensor with
+    // T(b,offs_l+c)=sum_m conj(x_l(b,m,c))*y_l(b,m,c), filled for all
+    // parts in one fused pass (see SO3vec_inpTableFn) instead of one
+    // synchronized per-part reduction per l.
+    cnine::CtensorB inp_table(const SO3vecB& y) const{
+      assert(parts.size()==y.parts.size());
+      int total=0;
+      for(auto p:parts) total+=p->getn();
+      cnine::CtensorB R=cnine::CtensorB::zero(cnine::Gdims(getb(),total),get_dev());
+      vector<SO3part3_view> xv; for(auto p:parts) xv.push_back(*p);
+      vector<SO3part3_view> yv; for(auto p:y.parts) yv.push_back(*p);
+      SO3vec_inpTableFn()(R.view2(),xv,yv);
+      return R;
+    }
+
+    // Per-(l,channel) squared norms -- the rotation-invariant features
+    // of the vec -- in the real plane of the table; the imaginary plane
+    // vanishes.
+    cnine::CtensorB norm2_table() const{
+      return inp_table(*this);
+    }
+
+
     // ---- Rotations ----------------------------------------------------------------------------------------
 
 
@@ -379,6 +644,14 @@ namespace GElib{
       return R;
     }
 
+    SO3vecB rotateZYZ(const SO3element& r){
+      SO3vecB R;
+      for(int l=0; l<parts.size(); l++)
+	if(parts[l]) R.parts.push_back(new SO3partB(parts[l]->rotateZYZ(r)));
+	else R.parts.push_back(nullptr);
+      return R;
+    }
+
     
     // ---- CG-products ---------------------------------------------------------------------------------------
 
@@ -386,69 +659,354 @@ namespace GElib{
     SO3vecB CGproduct(const SO3vecB& y, const int maxl=-1) const{
       assert(getb()==y.getb());
 
-      SO3vecB R=SO3vecB::zero(getb(),GElib::CGproduct(get_tau(),y.get_tau(),maxl),get_dev());
-      R.add_CGproduct(*this,y);
+      if(get_dev()>0){
+	SO3vecB R=SO3vecB::zero(getb(),GElib::CGproduct_cached(get_tau(),y.get_tau(),maxl),get_dev());
+	R.add_CGproduct(*this,y);
+	return R;
+      }
+      SO3vecB R=SO3vecB::raw(getb(),GElib::CGproduct_cached(get_tau(),y.get_tau(),maxl),get_dev());
+      R.set_CGproduct(*this,y);
       return R;
     }
 
+    // Write-mode form: overwrites this with the product so the result
+    // can be allocated raw, eliminating the zero-fill pass (see
+    // SO3vec_addCGproductFn). On the device it falls back to
+    // zero-then-accumulate.
+    void set_CGproduct(const SO3vecB& x, const SO3vecB& y){
+      assert(get_tau()==GElib::CGproduct(x.get_tau(),y.get_tau(),get_maxl()));
+
+      if(get_dev()>0){
+	set_zero();
+	add_CGproduct(x,y);
+	return;
+      }
+      vector<SO3part3_view> rv; for(auto p:parts) rv.push_back(*p);
+      vector<SO3part3_view> xv; for(auto p:x.parts) xv.push_back(*p);
+      vector<SO3part3_view> yv; for(auto p:y.parts) yv.push_back(*p);
+      SO3vec_addCGproductFn(true)(rv,xv,yv);
+    }
+
+
+    // Out-parameter form of CGproduct: writes into caller-owned,
+    // preallocated r (of the matching product tau) so steady-state
+    // loops run with zero allocations per step.
+    static void CGproduct_into(SO3vecB& r, const SO3vecB& x, const SO3vecB& y){
+      r.set_zero();
+      r.add_CGproduct(x,y);
+    }
 
     void add_CGproduct(const SO3vecB& x, const SO3vecB& y){
       assert(get_tau()==GElib::CGproduct(x.get_tau(),y.get_tau(),get_maxl()));
 
-      int L1=x.get_maxl(); 
+      vector<SO3part3_view> rv; for(auto p:parts) rv.push_back(*p);
+      vector<SO3part3_view> xv; for(auto p:x.parts) xv.push_back(*p);
+      vector<SO3part3_view> yv; for(auto p:y.parts) yv.push_back(*p);
+      SO3vec_addCGproductFn()(rv,xv,yv);
+    }
+
+
+    // Plan forms: the output type, per-triple offsets and CG table
+    // pointers come from a plan memoized in SO3CGplans, so a call that
+    // repeats a (tau1,tau2,maxl) signature pays only a table walk
+    // before touching data (see SO3CGproductPlan).
+
+    SO3vecB CGproduct(const SO3vecB& y, const SO3CGproductPlan& plan) const{
+      assert(getb()==y.getb());
+      assert(get_tau()==plan.tau1 && y.get_tau()==plan.tau2);
+
+      SO3vecB R=SO3vecB::zero(getb(),plan.tau,get_dev());
+      R.add_CGproduct(*this,y,plan);
+      return R;
+    }
+
+    void add_CGproduct(const SO3vecB& x, const SO3vecB& y, const SO3CGproductPlan& plan){
+      assert(get_tau()==plan.tau);
+
+      vector<SO3part3_view> rv; for(auto p:parts) rv.push_back(*p);
+      vector<SO3part3_view> xv; for(auto p:x.parts) xv.push_back(*p);
+      vector<SO3part3_view> yv; for(auto p:y.parts) yv.push_back(*p);
+      plan(rv,xv,yv);
+    }
+
+      
+    // The backward passes below record the part-level calls for the
+    // (l1,l2,l) triples in a task graph keyed by their read/write sets
+    // and execute independent ones concurrently: triples only conflict
+    // when they accumulate into the same gradient part, so most of them
+    // can run in parallel on top of the batch-level parallelism inside
+    // each call. On GPU the triples are issued sequentially as before.
+
+    void add_CGproduct_back0(const SO3vecB& g, const SO3vecB& y){
+      assert(g.get_tau()==GElib::CGproduct(get_tau(),y.get_tau(),g.get_maxl()));
+
+      int L1=get_maxl();
       int L2=y.get_maxl();
-      int L=get_maxl();
-      vector<int> offs(parts.size(),0);
-	
+      int L=g.get_maxl();
+      vector<int> offs(g.parts.size(),0);
+
+      GElibTaskGraph graph;
       for(int l1=0; l1<=L1; l1++){
 	for(int l2=0; l2<=L2; l2++){
 	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
-	    parts[l]->add_CGproduct(*x.parts[l1],*y.parts[l2],offs[l]);
-	    offs[l]+=(x.parts[l1]->getn())*(y.parts[l2]->getn());
+	    const int n=(parts[l1]->getn())*(y.parts[l2]->getn());
+	    if(get_dev()>0){
+	      parts[l1]->add_CGproduct_back0(*g.parts[l],*y.parts[l2],offs[l]);
+	    }else{
+	      const int o=offs[l];
+	      graph.add([this,&g,&y,l1,l2,l,o](){
+		  parts[l1]->add_CGproduct_back0(*g.parts[l],*y.parts[l2],o);},
+		{GElibTaskGraph::Region(g.parts[l],o,o+n),GElibTaskGraph::Region(y.parts[l2])},
+		{GElibTaskGraph::Region(parts[l1])});
+	    }
+	    offs[l]+=n;
 	  }
 	}
       }
+      graph.run();
     }
 
-      
-    void add_CGproduct_back0(const SO3vecB& g, const SO3vecB& y){
-      assert(g.get_tau()==GElib::CGproduct(get_tau(),y.get_tau(),g.get_maxl()));
 
-      int L1=get_maxl(); 
+    void add_CGproduct_back1(const SO3vecB& g, const SO3vecB& x){
+      assert(g.get_tau()==GElib::CGproduct(x.get_tau(),get_tau(),g.get_maxl()));
+
+      int L1=x.get_maxl();
+      int L2=get_maxl();
+      int L=g.get_maxl();
+      vector<int> offs(g.parts.size(),0);
+
+      GElibTaskGraph graph;
+      for(int l1=0; l1<=L1; l1++){
+	for(int l2=0; l2<=L2; l2++){
+	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
+	    const int n=(x.parts[l1]->getn())*(parts[l2]->getn());
+	    if(get_dev()>0){
+	      parts[l2]->add_CGproduct_back1(*g.parts[l],*x.parts[l1],offs[l]);
+	    }else{
+	      const int o=offs[l];
+	      graph.add([this,&g,&x,l1,l2,l,o](){
+		  parts[l2]->add_CGproduct_back1(*g.parts[l],*x.parts[l1],o);},
+		{GElibTaskGraph::Region(g.parts[l],o,o+n),GElibTaskGraph::Region(x.parts[l1])},
+		{GElibTaskGraph::Region(parts[l2])});
+	    }
+	    offs[l]+=n;
+	  }
+	}
+      }
+      graph.run();
+    }
+
+
+    // Fused backward: accumulates both operand gradients in a single
+    // sweep over g, x and y instead of separate back0/back1 passes.
+    static void add_CGproduct_back(SO3vecB& xg, SO3vecB& yg, const SO3vecB& g,
+      const SO3vecB& x, const SO3vecB& y){
+      assert(g.get_tau()==GElib::CGproduct(x.get_tau(),y.get_tau(),g.get_maxl()));
+
+      int L1=x.get_maxl();
       int L2=y.get_maxl();
       int L=g.get_maxl();
       vector<int> offs(g.parts.size(),0);
-	
+
+      GElibTaskGraph graph;
       for(int l1=0; l1<=L1; l1++){
 	for(int l2=0; l2<=L2; l2++){
 	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
-	    parts[l1]->add_CGproduct_back0(*g.parts[l],*y.parts[l2],offs[l]);
-	    offs[l]+=(parts[l1]->getn())*(y.parts[l2]->getn());
+	    const int n=(x.parts[l1]->getn())*(y.parts[l2]->getn());
+	    if(g.get_dev()>0){
+	      SO3partB::add_CGproduct_back(*xg.parts[l1],*yg.parts[l2],*g.parts[l],
+		*x.parts[l1],*y.parts[l2],offs[l]);
+	    }else{
+	      const int o=offs[l];
+	      graph.add([&xg,&yg,&g,&x,&y,l1,l2,l,o](){
+		  SO3partB::add_CGproduct_back(*xg.parts[l1],*yg.parts[l2],*g.parts[l],
+		    *x.parts[l1],*y.parts[l2],o);},
+		{GElibTaskGraph::Region(g.parts[l],o,o+n),GElibTaskGraph::Region(x.parts[l1]),
+		  GElibTaskGraph::Region(y.parts[l2])},
+		{GElibTaskGraph::Region(xg.parts[l1]),GElibTaskGraph::Region(yg.parts[l2])});
+	    }
+	    offs[l]+=n;
 	  }
 	}
       }
+      graph.run();
     }
 
-      
-    void add_CGproduct_back1(const SO3vecB& g, const SO3vecB& x){
-      assert(g.get_tau()==GElib::CGproduct(x.get_tau(),get_tau(),g.get_maxl()));
 
-      int L1=x.get_maxl(); 
-      int L2=get_maxl();
+    // ---- Masked CG-products -------------------------------------------------------------------------------
+
+
+    // Masked forms: mask[l]!=0 selects which output l's are computed;
+    // the rest are skipped entirely rather than produced and discarded,
+    // so a model that only consumes a subset of the admissible outputs
+    // (typically dropping high l) pays no flops for the dead fragments.
+    // Masked-out parts of the result have zero channels. The backward
+    // passes must be called with the same mask so that the traversals
+    // line up.
+
+    SO3vecB CGproduct(const SO3vecB& y, const vector<int>& mask) const{
+      assert(getb()==y.getb());
+
+      SO3type ptau=GElib::CGproduct(get_tau(),y.get_tau(),(int)mask.size()-1);
+      SO3type tau;
+      for(int l=0; l<ptau.size(); l++)
+	tau.push_back((l<mask.size() && mask[l])?ptau[l]:0);
+      SO3vecB R=SO3vecB::zero(getb(),tau,get_dev());
+      R.add_CGproduct(*this,y,mask);
+      return R;
+    }
+
+
+    void add_CGproduct(const SO3vecB& x, const SO3vecB& y, const vector<int>& mask){
+      int L1=x.get_maxl();
+      int L2=y.get_maxl();
+      int L=get_maxl();
+
+      vector<SO3CGtriple> triples;
+      vector<int> offs(parts.size(),0);
+      for(int l1=0; l1<=L1; l1++)
+	for(int l2=0; l2<=L2; l2++)
+	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
+	    if(l>=mask.size() || !mask[l]) continue;
+	    triples.push_back(SO3CGtriple{l1,l2,l,offs[l],&SO3_cgbank_cached<float>(CGindex(l1,l2,l))});
+	    offs[l]+=(x.parts[l1]->getn())*(y.parts[l2]->getn());
+	  }
+
+      vector<SO3part3_view> rv; for(auto p:parts) rv.push_back(*p);
+      vector<SO3part3_view> xv; for(auto p:x.parts) xv.push_back(*p);
+      vector<SO3part3_view> yv; for(auto p:y.parts) yv.push_back(*p);
+      SO3vec_addCGproductFn()(rv,xv,yv,triples);
+    }
+
+
+    static void add_CGproduct_back(SO3vecB& xg, SO3vecB& yg, const SO3vecB& g,
+      const SO3vecB& x, const SO3vecB& y, const vector<int>& mask){
+
+      int L1=x.get_maxl();
+      int L2=y.get_maxl();
       int L=g.get_maxl();
       vector<int> offs(g.parts.size(),0);
-	
+
+      GElibTaskGraph graph;
       for(int l1=0; l1<=L1; l1++){
 	for(int l2=0; l2<=L2; l2++){
 	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
-	    parts[l2]->add_CGproduct_back1(*g.parts[l],*x.parts[l1],offs[l]);
-	    offs[l]+=(x.parts[l1]->getn())*(parts[l2]->getn());
+	    if(l>=mask.size() || !mask[l]) continue;
+	    const int n=(x.parts[l1]->getn())*(y.parts[l2]->getn());
+	    if(g.get_dev()>0){
+	      SO3partB::add_CGproduct_back(*xg.parts[l1],*yg.parts[l2],*g.parts[l],
+		*x.parts[l1],*y.parts[l2],offs[l]);
+	    }else{
+	      const int o=offs[l];
+	      graph.add([&xg,&yg,&g,&x,&y,l1,l2,l,o](){
+		  SO3partB::add_CGproduct_back(*xg.parts[l1],*yg.parts[l2],*g.parts[l],
+		    *x.parts[l1],*y.parts[l2],o);},
+		{GElibTaskGraph::Region(g.parts[l],o,o+n),GElibTaskGraph::Region(x.parts[l1]),
+		  GElibTaskGraph::Region(y.parts[l2])},
+		{GElibTaskGraph::Region(xg.parts[l1]),GElibTaskGraph::Region(yg.parts[l2])});
+	    }
+	    offs[l]+=n;
 	  }
 	}
       }
+      graph.run();
     }
 
-      
+
+    // ---- Fused CG-products + mix --------------------------------------------------------------------------
+
+
+    // Fused CGproduct followed by a learned per-l channel mix: for each
+    // output l the rows of w.tensors[l] index the (l1,l2) fragments in
+    // the same order in which add_CGproduct concatenates them, so the
+    // result equals CGproduct(y,maxl)*w without the CG output -- whose
+    // N1*N2 channel dimension makes it the widest tensor in a typical
+    // network -- ever being materialized (see SO3part_addCGproductMixFn).
+
+    SO3vecB CGproduct_mix(const SO3vecB& y, const cnine::CtensorPackObj& w, const int maxl=-1) const{
+      assert(getb()==y.getb());
+      SO3type ptau=GElib::CGproduct(get_tau(),y.get_tau(),maxl);
+      assert(w.tensors.size()==ptau.size());
+      SO3type tau;
+      for(int l=0; l<ptau.size(); l++){
+	assert(w.tensors[l]->get_dim(0)==ptau[l]);
+	tau.push_back(w.tensors[l]->get_dim(1));
+      }
+      SO3vecB R=SO3vecB::zero(getb(),tau,get_dev());
+      R.add_CGproduct_mix(*this,y,w);
+      return R;
+    }
+
+
+    void add_CGproduct_mix(const SO3vecB& x, const SO3vecB& y, const cnine::CtensorPackObj& w){
+      int L1=x.get_maxl();
+      int L2=y.get_maxl();
+      int L=get_maxl();
+
+      if(get_dev()>0){
+	SO3vecB T=x.CGproduct(y,L);
+	add_mprod(T,w);
+	return;
+      }
+
+      vector<int> roffs(parts.size(),0);
+      for(int l1=0; l1<=L1; l1++){
+	for(int l2=0; l2<=L2; l2++){
+	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
+	    const int n=(x.parts[l1]->getn())*(y.parts[l2]->getn());
+	    cnine::Ctensor2_view wv=const_cast<cnine::CtensorObj&>(*w.tensors[l]).view2();
+	    wv.arr+=roffs[l]*wv.s0;
+	    wv.arrc+=roffs[l]*wv.s0;
+	    wv.n0=n;
+	    SO3part_addCGproductMixFn()(*parts[l],*x.parts[l1],*y.parts[l2],wv);
+	    roffs[l]+=n;
+	  }
+	}
+      }
+    }
+
+
+    // Fused backward: accumulates xg, yg and wg in a single sweep per
+    // (l1,l2,l) triple without materializing the CG output or its
+    // gradient. On GPU the unfused path is taken and the intermediate
+    // pair is materialized.
+    static void add_CGproduct_mix_back(SO3vecB& xg, SO3vecB& yg, cnine::CtensorPackObj& wg, const SO3vecB& g,
+      const SO3vecB& x, const SO3vecB& y, const cnine::CtensorPackObj& w){
+      int L1=x.get_maxl();
+      int L2=y.get_maxl();
+      int L=g.get_maxl();
+
+      if(g.get_dev()>0){
+	SO3vecB T=x.CGproduct(y,L);
+	SO3vecB Tg=SO3vecB::zero(g.getb(),T.get_tau(),g.get_dev());
+	Tg.add_mprod_back0(g,w);
+	g.add_mprod_back1_into(wg,T);
+	SO3vecB::add_CGproduct_back(xg,yg,Tg,x,y);
+	return;
+      }
+
+      vector<int> roffs(g.parts.size(),0);
+      for(int l1=0; l1<=L1; l1++){
+	for(int l2=0; l2<=L2; l2++){
+	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
+	    const int n=(x.parts[l1]->getn())*(y.parts[l2]->getn());
+	    cnine::Ctensor2_view wv=const_cast<cnine::CtensorObj&>(*w.tensors[l]).view2();
+	    wv.arr+=roffs[l]*wv.s0;
+	    wv.arrc+=roffs[l]*wv.s0;
+	    wv.n0=n;
+	    cnine::Ctensor2_view wgv=wg.tensors[l]->view2();
+	    wgv.arr+=roffs[l]*wgv.s0;
+	    wgv.arrc+=roffs[l]*wgv.s0;
+	    wgv.n0=n;
+	    SO3part_addCGproductMix_backFn()(*xg.parts[l1],*yg.parts[l2],wgv,
+	      *g.parts[l],*x.parts[l1],*y.parts[l2],wv);
+	    roffs[l]+=n;
+	  }
+	}
+      }
+    }
+
+
     // ---- Blocked CG-products ------------------------------------------------------------------------------
 
 
@@ -754,33 +1312,65 @@ namespace GElib{
 	});
     }
 
+    // Planned variants: resolve tables and workspaces once through
+    // SO3FFTplans and reuse them across calls (see SO3FFTPlan).
+    void add_iFFT_to(cnine::CtensorB& R, SO3FFTPlan& plan) const{
+      forall_parts([&](const SO3partB& x){
+	  plan.execute_inverse(R.view4(),x.view3());
+	});
+    }
+
+    void add_FFT(const cnine::CtensorB& R, SO3FFTPlan& plan){
+      forall_parts([&](const SO3partB& x){
+	  plan.execute(x.view3(),R.view4());
+	});
+    }
+
 
   public: // ---- Experimental -------------------------------------------------------------------------------
 
 
 
     #ifdef WITH_FAKE_GRAD
+
+    // Lazy gradient storage: when the session-owned gradient arena is
+    // installed (see GElibGradArena), the grad's parts are non-owning
+    // views carved contiguously from it, so zeroing and accumulating
+    // the gradients of a whole model are single fused sweeps over the
+    // arena; otherwise each vec owns a separate zero-filled grad.
+    SO3vecB* new_grad() const{
+      if(gelib_grad_arena && get_dev()==gelib_grad_arena->dev){
+	SO3vecB* R=new SO3vecB();
+	for(auto p:parts){
+	  float* a=gelib_grad_arena->alloc(2*((size_t)p->getb())*(2*p->getl()+1)*p->getn());
+	  R->parts.push_back(new SO3partB(SO3partB::view_of(p->getb(),p->getl(),p->getn(),a,gelib_grad_arena->dev)));
+	}
+	return R;
+      }
+      return new SO3vecB(SO3vecB::zeros_like(*this));
+    }
+
     void add_to_grad(const SO3vecB& x){
-      if(grad) grad->add(x);
-      else grad=new SO3vecB(x);
+      if(!grad) grad=new_grad();
+      grad->add(x);
     }
 
     void add_to_part_of_grad(const int l, const SO3partB& x){
-      if(!grad) grad=new SO3vecB(SO3vecB::zeros_like(*this));
+      if(!grad) grad=new_grad();
       grad->parts[l]->add(x);
     }
 
     SO3vecB& get_grad(){
-      if(!grad) grad=new SO3vecB(SO3vecB::zeros_like(*this));
+      if(!grad) grad=new_grad();
       return *grad;
     }
 
     SO3vecB view_of_grad(){
       cout<<"view"<<endl;
-      if(!grad) grad=new SO3vecB(SO3vecB::zeros_like(*this));
+      if(!grad) grad=new_grad();
       return grad->view();
     }
-    #endif 
+    #endif
 
 
   public: // ---- I/O ---------------------------------------------------------------------------------------
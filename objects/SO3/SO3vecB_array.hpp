@@ -16,8 +16,10 @@
 #include "SO3type.hpp"
 #include "CtensorB_multiArray.hpp"
 #include "SO3partB_array.hpp"
+#include "SO3vecB.hpp"
 #include "SO3element.hpp"
 #include "GElibTimer.hpp"
+#include "GElibThreadPool.hpp"
 
 namespace GElib{
 
@@ -204,6 +206,20 @@ namespace GElib{
     }
 
 
+  public: // ---- Ingestion -----------------------------------------------------------------------------------------
+
+
+    // Parallel ingestion of a whole vector from raw caller buffers,
+    // one per part in flat cell order with interleaved complex entries
+    // (see SO3partB_array::ingest for the layout and the pinned GPU
+    // path).
+    void ingest(const vector<const float*>& srcs){
+      GELIB_ASSRT(srcs.size()==parts.size());
+      for(int l=0; l<(int)parts.size(); l++)
+	if(parts[l]) parts[l]->ingest(srcs[l]);
+    }
+
+
   public: // ---- Transport -----------------------------------------------------------------------------------------
 
 
@@ -275,7 +291,31 @@ namespace GElib{
     //return 0;
     //}
 
-    
+
+  public: // ---- Memory placement ----------------------------------------------------------------------------------
+
+
+    // Faults the pages of each part's cell storage in a statically
+    // partitioned parallel sweep, so that with a NUMA-pinned thread
+    // pool (GELIB_NUMA_PIN) each socket's memory holds the cells its
+    // own threads will process, instead of all storage landing on
+    // whichever node the allocating thread ran on. Call right after
+    // constructing a raw or zero filled array, before it is written.
+    void numa_first_touch(){
+      if(get_dev()>0) return;
+      const long page_floats=4096/sizeof(float);
+      for(auto p:parts){
+	if(!p) continue;
+	float* a=p->arr;
+	const long npages=(p->memsize+page_floats-1)/page_floats;
+	GElibMultiLoopStatic(npages,[&](const int i){
+	    volatile float* t=a+((long)i)*page_floats;
+	    *t=*t;
+	  });
+      }
+    }
+
+
 
   public: // ---- Operations ---------------------------------------------------------------------------------------
 
@@ -310,8 +350,266 @@ namespace GElib{
     //for(int l=0; l<parts.size(); l++)
     //parts[l]->add_gather(*x.parts[l],mask);
     //}
-    
-    
+
+
+    // Fused linear combination: accumulates sum_i c_i*v_i into this in
+    // a single sweep over the output, walking each output page across
+    // all operands while it sits in cache instead of re-reading and
+    // re-writing every part once per term (same scheme as
+    // SO3vecB::add_linear). On the device the terms fall back to
+    // part-level adds.
+    void add_linear(const vector<std::pair<complex<float>,const SO3vecB_array*> >& terms){
+      if(get_dev()>0){
+	for(auto& t:terms)
+	  for(int l=0; l<parts.size(); l++)
+	    parts[l]->add(*t.second->parts[l],t.first);
+	return;
+      }
+      const int nterms=terms.size();
+      for(int l=0; l<parts.size(); l++){
+	if(!parts[l]) continue;
+	SO3partB_array& r=*parts[l];
+	const long n=r.dims.total();
+	vector<const float*> xre(nterms);
+	vector<const float*> xim(nterms);
+	for(int i=0; i<nterms; i++){
+	  const SO3partB_array& x=*terms[i].second->parts[l];
+	  assert(x.dims==r.dims);
+	  xre[i]=x.arr;
+	  xim[i]=x.arr+x.coffs;
+	}
+	float* rre=r.arr;
+	float* rim=r.arr+r.coffs;
+	const long page_floats=4096/sizeof(float);
+	const long npages=(n+page_floats-1)/page_floats;
+	GElibMultiLoopStatic(npages,[&](const int p){
+	    const long beg=((long)p)*page_floats;
+	    const long end=std::min<long>(beg+page_floats,n);
+	    for(int i=0; i<nterms; i++){
+	      const float cr=terms[i].first.real();
+	      const float ci=terms[i].first.imag();
+	      const float* ar=xre[i];
+	      const float* ai=xim[i];
+	      if(ci==0){
+		for(long j=beg; j<end; j++) rre[j]+=cr*ar[j];
+		for(long j=beg; j<end; j++) rim[j]+=cr*ai[j];
+	      }else{
+		for(long j=beg; j<end; j++) rre[j]+=cr*ar[j]-ci*ai[j];
+		for(long j=beg; j<end; j++) rim[j]+=cr*ai[j]+ci*ar[j];
+	      }
+	    }
+	  });
+      }
+    }
+
+
+  public: // ---- Batch slicing ------------------------------------------------------------------------------------
+
+
+    // Non-owning view of batch rows [beg,end): every part shares the
+    // parent's buffer (see SO3partB_array::batch_slice), so microbatch
+    // scheduling slices the data for free. The parent must outlive the
+    // view.
+    SO3vecB_array batch_slice(const int beg, const int end) const{
+      SO3vecB_array R;
+      for(auto p:parts)
+	R.parts.push_back(new SO3partB_array(p->batch_slice(beg,end)));
+      return R;
+    }
+
+
+  public: // ---- Invariants ---------------------------------------------------------------------------------------
+
+
+    // Invariant inner-product table over all cells: rows are indexed by
+    // the flattened (batch,cell) index and columns by (l,channel), with
+    // T(i,offs_l+c)=sum_m conj(x_l(i,m,c))*y_l(i,m,c), filled for every
+    // part in one fused pass (see SO3vec_inpTableFn).
+    cnine::CtensorB inp_table(const SO3vecB_array& y) const{
+      assert(parts.size()==y.parts.size());
+      int total=0;
+      for(auto p:parts) total+=p->getn();
+      const int N=parts[0]->getN();
+      cnine::CtensorB R=cnine::CtensorB::zero(cnine::Gdims(N,total),get_dev());
+      vector<SO3part3_view> xv; for(auto p:parts) xv.push_back(p->part3_view());
+      vector<SO3part3_view> yv; for(auto p:y.parts) yv.push_back(p->part3_view());
+      SO3vec_inpTableFn()(R.view2(),xv,yv);
+      return R;
+    }
+
+    cnine::CtensorB norm2_table() const{
+      return inp_table(*this);
+    }
+
+
+  public: // ---- Gather/scatter operations -------------------------------------------------------------------------
+
+
+    SO3vecB_array gather_rows(const vector<int>& ix) const{
+      SO3vecB_array R;
+      for(int l=0; l<parts.size(); l++)
+	if(parts[l]) R.parts.push_back(new SO3partB_array(parts[l]->gather_rows(ix)));
+	else R.parts.push_back(nullptr);
+      return R;
+    }
+
+
+    void scatter_add_rows(const SO3vecB_array& x, const vector<int>& ix){
+      assert(parts.size()==x.parts.size());
+      for(int l=0; l<parts.size(); l++)
+	if(parts[l]) parts[l]->scatter_add_rows(*x.parts[l],ix);
+    }
+
+
+    // Fused gather->CGproduct->scatter_add over an edge list: for each
+    // edge e the CG product of cell src[e] of this vector with cell
+    // dst[e] of y is accumulated into cell dst[e] of the result, with
+    // the same fragment offsets as CGproduct but no materialized
+    // neighbor tensor.
+    SO3vecB_array CGproduct_edges(const SO3vecB_array& y,
+      const vector<int>& src, const vector<int>& dst, const int maxl=-1) const{
+      SO3vecB_array R=SO3vecB_array::zero(y.getb(),y.get_adims(),GElib::CGproduct(get_tau(),y.get_tau(),maxl),y.get_dev());
+      R.add_CGproduct_edges(*this,y,src,dst);
+      return R;
+    }
+
+
+    // Ragged (CSR-packed) per-sample reduction and its transpose; see
+    // GElibCellOffsets for the packed layout. The cellwise products
+    // above already run on packed arrays unchanged.
+    SO3vecB_array reduce_cells(const GElibCellOffsets& offsets) const{
+      SO3vecB_array R;
+      for(int l=0; l<parts.size(); l++)
+	if(parts[l]) R.parts.push_back(new SO3partB_array(parts[l]->reduce_cells(offsets)));
+	else R.parts.push_back(nullptr);
+      return R;
+    }
+
+
+    void broadcast_add_cells(const SO3vecB_array& x, const GElibCellOffsets& offsets){
+      assert(parts.size()==x.parts.size());
+      for(int l=0; l<parts.size(); l++)
+	if(parts[l]) parts[l]->broadcast_add_cells(*x.parts[l],offsets);
+    }
+
+
+    void add_CGproduct_edges(const SO3vecB_array& x, const SO3vecB_array& y,
+      const vector<int>& src, const vector<int>& dst){
+      assert(get_tau()==GElib::CGproduct(x.get_tau(),y.get_tau(),get_maxl()));
+
+      int L1=x.get_maxl();
+      int L2=y.get_maxl();
+      int L=get_maxl();
+      vector<int> offs(parts.size(),0);
+
+      for(int l1=0; l1<=L1; l1++){
+	for(int l2=0; l2<=L2; l2++){
+	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
+	    parts[l]->add_CGproduct_edges(*x.parts[l1],*y.parts[l2],src,dst,offs[l]);
+	    offs[l]+=(x.parts[l1]->getn())*(y.parts[l2]->getn());
+	  }
+	}
+      }
+    }
+
+
+  public: // ---- Dirty-cell tracking -------------------------------------------------------------------------------
+
+
+    // Dirty-cell set for local-update workloads (active-learning loops,
+    // MD local moves): callers mark the cells they changed and the
+    // delta variants below recompute only those, so the per-step cost
+    // of the cellwise products drops from O(cells) to O(changed). The
+    // tracking is entirely passive -- the regular full-array ops ignore
+    // it and the set survives until clear_dirty().
+
+    vector<bool> dirty_flags;
+    vector<int> dirty_list;
+
+    void mark_dirty(const int i){
+      const int N=get_adims().total();
+      GELIB_ASSRT(i>=0 && i<N);
+      if((int)dirty_flags.size()!=N) dirty_flags.assign(N,false);
+      if(dirty_flags[i]) return;
+      dirty_flags[i]=true;
+      dirty_list.push_back(i);
+    }
+
+    void mark_dirty(const vector<int>& ix){
+      for(auto i:ix) mark_dirty(i);
+    }
+
+    void clear_dirty(){
+      dirty_flags.assign(dirty_flags.size(),false);
+      dirty_list.clear();
+    }
+
+    int n_dirty() const{
+      return dirty_list.size();
+    }
+
+    const vector<int>& dirty_cells() const{
+      return dirty_list;
+    }
+
+    // Zeros the listed cells of every part, leaving the rest untouched.
+    void zero_cells(const vector<int>& ix){
+      for(int l=0; l<parts.size(); l++)
+	if(parts[l]) parts[l]->zero_cells(ix);
+    }
+
+
+    // Delta variant of the cellwise CG product: assumes this array
+    // already holds CGproduct(x,y) for the unlisted cells and
+    // recomputes only the listed ones, reusing the edge kernel with
+    // src=dst since the cellwise product is cell-diagonal. The
+    // refreshed cells are marked dirty on the output so a dependent
+    // reduce_cells_delta can pick them up.
+    void add_CGproduct_delta(const SO3vecB_array& x, const SO3vecB_array& y, const vector<int>& cells){
+      assert(get_tau()==GElib::CGproduct(x.get_tau(),y.get_tau(),get_maxl()));
+      zero_cells(cells);
+
+      int L1=x.get_maxl();
+      int L2=y.get_maxl();
+      int L=get_maxl();
+      vector<int> offs(parts.size(),0);
+
+      for(int l1=0; l1<=L1; l1++){
+	for(int l2=0; l2<=L2; l2++){
+	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
+	    parts[l]->add_CGproduct_edges(*x.parts[l1],*y.parts[l2],cells,cells,offs[l]);
+	    offs[l]+=(x.parts[l1]->getn())*(y.parts[l2]->getn());
+	  }
+	}
+      }
+      mark_dirty(cells);
+    }
+
+    // Convenience form driven by the inputs' own dirty sets.
+    void add_CGproduct_delta(const SO3vecB_array& x, const SO3vecB_array& y){
+      vector<int> cells=x.dirty_list;
+      for(auto i:y.dirty_list)
+	if(std::find(cells.begin(),cells.end(),i)==cells.end()) cells.push_back(i);
+      add_CGproduct_delta(x,y,cells);
+    }
+
+
+    // Delta refresh of a reduce_cells result r: only the samples owning
+    // a dirty cell of this (packed) array are rebuilt. Does not clear
+    // the dirty set; callers do so once every dependent consumer has
+    // caught up.
+    void reduce_cells_delta(SO3vecB_array& r, const GElibCellOffsets& offsets) const{
+      assert(parts.size()==r.parts.size());
+      vector<int> samples;
+      for(auto c:dirty_list){
+	const int s=std::upper_bound(offsets.offs.begin(),offsets.offs.end(),c)-offsets.offs.begin()-1;
+	if(std::find(samples.begin(),samples.end(),s)==samples.end()) samples.push_back(s);
+      }
+      for(int l=0; l<parts.size(); l++)
+	if(parts[l]) r.parts[l]->update_reduced_cells(*parts[l],offsets,samples);
+    }
+
+
   public: // ---- CG-products ---------------------------------------------------------------------------------------
 
 
@@ -323,6 +621,39 @@ namespace GElib{
     }
 
 
+    static void CGproduct_into(SO3vecB_array& r, const SO3vecB_array& x, const SO3vecB_array& y){
+      r.set_zero();
+      r.add_CGproduct(x,y);
+    }
+
+
+    // Broadcast variant: y is a single vector shared by every cell,
+    // read in place through stride-0 views instead of being replicated
+    // into a full array first.
+    SO3vecB_array CGproduct(const SO3vecB& y, const int maxl=-1) const{
+      SO3vecB_array R=SO3vecB_array::zero(getb(),get_adims(),GElib::CGproduct(get_tau(),y.get_tau(),maxl),get_dev());
+      R.add_CGproduct(*this,y);
+      return R;
+    }
+
+    void add_CGproduct(const SO3vecB_array& x, const SO3vecB& y){
+      assert(get_tau()==GElib::CGproduct(x.get_tau(),y.get_tau(),get_maxl()));
+
+      int L1=x.get_maxl();
+      int L2=y.get_maxl();
+      int L=get_maxl();
+      vector<int> offs(parts.size(),0);
+
+      for(int l1=0; l1<=L1; l1++){
+	for(int l2=0; l2<=L2; l2++){
+	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
+	    parts[l]->add_CGproduct(*x.parts[l1],*y.parts[l2],offs[l]);
+	    offs[l]+=(x.parts[l1]->getn())*(y.parts[l2]->getn());
+	  }
+	}
+      }
+    }
+
     void add_CGproduct(const SO3vecB_array& x, const SO3vecB_array& y){
       assert(get_tau()==GElib::CGproduct(x.get_tau(),y.get_tau(),get_maxl()));
       LoggedTimer timer("CGproduct("+x.get_tau().str()+","+y.get_tau().str()+","+get_tau().str()+")[b="+to_string(getb())+","+get_adims().str()+",dev="+to_string(get_dev())+"]");
@@ -486,6 +817,30 @@ namespace GElib{
       add_BlockedCGproduct_back1(g,x,1);
     }
 
+
+    // Broadcast variant, as for CGproduct above.
+    SO3vecB_array DiagCGproduct(const SO3vecB& y, const int maxl=-1) const{
+      SO3vecB_array R=SO3vecB_array::zero(getb(),get_adims(),GElib::DiagCGproduct(get_tau(),y.get_tau(),1,maxl),get_dev());
+      R.add_DiagCGproduct(*this,y);
+      return R;
+    }
+
+    void add_DiagCGproduct(const SO3vecB_array& x, const SO3vecB& y){
+      int L1=x.get_maxl();
+      int L2=y.get_maxl();
+      int L=get_maxl();
+      vector<int> offs(parts.size(),0);
+
+      for(int l1=0; l1<=L1; l1++){
+	for(int l2=0; l2<=L2; l2++){
+	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
+	    parts[l]->add_DiagCGproduct(*x.parts[l1],*y.parts[l2],offs[l]);
+	    offs[l]+=x.parts[l1]->getn();
+	  }
+	}
+      }
+    }
+
     
 
     /*
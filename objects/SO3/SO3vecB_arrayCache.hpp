@@ -0,0 +1,162 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3vecB_arrayCache
+#define _SO3vecB_arrayCache
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "SO3vecB_array.hpp"
+
+
+namespace GElib{
+
+  // In-memory LRU cache of decoded SO3vecB_array records, keyed by
+  // record identity. Training epochs re-read the same precomputed
+  // features; when the dataset is larger than RAM the page cache
+  // thrashes blindly because it caches file pages, not records, and a
+  // hit still pays the decode. This cache sits in front of the record
+  // loader (SO3vecB_io / SO3vecB_arrayStream) and keeps fully decoded,
+  // device-ready arrays under an explicit byte budget with
+  // least-recently-used eviction, so hot records skip both disk and
+  // decoding. Entries are handed out as shared_ptr -- a record evicted
+  // while a consumer still holds it stays alive until released. The
+  // key type is pluggable; file paths are the usual choice.
+
+  template<typename KEY=string>
+  class SO3vecB_arrayCache{
+  private:
+
+    struct Entry{
+      std::shared_ptr<SO3vecB_array> v;
+      size_t bytes;
+      typename std::list<KEY>::iterator pos;
+    };
+
+    size_t budget;
+    size_t used=0;
+
+    std::list<KEY> lru;   // most recently used at the front
+    std::map<KEY,Entry> entries;
+
+    mutable std::mutex mx;
+
+    long nhits=0;
+    long nmisses=0;
+
+
+  public:
+
+    SO3vecB_arrayCache(const size_t budget_bytes):
+      budget(budget_bytes){}
+
+    SO3vecB_arrayCache(const SO3vecB_arrayCache& x)=delete;
+    SO3vecB_arrayCache& operator=(const SO3vecB_arrayCache& x)=delete;
+
+
+  public: // ---- Access -------------------------------------------------------------------------------------
+
+
+    size_t size() const{
+      std::lock_guard<std::mutex> lock(mx);
+      return entries.size();
+    }
+
+    size_t bytes() const{
+      std::lock_guard<std::mutex> lock(mx);
+      return used;
+    }
+
+    long hits() const{
+      return nhits;
+    }
+
+    long misses() const{
+      return nmisses;
+    }
+
+    void clear(){
+      std::lock_guard<std::mutex> lock(mx);
+      entries.clear();
+      lru.clear();
+      used=0;
+    }
+
+
+  public: // ---- Operations ---------------------------------------------------------------------------------
+
+
+    // The main entry point: returns the cached record or runs the
+    // loader (disk read + decode + optional transport) and caches its
+    // result. The loader runs outside the lock, so concurrent misses
+    // on different keys load in parallel; concurrent misses on the
+    // same key may both load, with one result winning.
+    std::shared_ptr<SO3vecB_array> operator()(const KEY& key, const std::function<SO3vecB_array()>& loader){
+      if(auto p=get(key)) return p;
+      auto p=std::make_shared<SO3vecB_array>(loader());
+      put(key,p);
+      return p;
+    }
+
+    // Returns the cached record and marks it most recently used, or
+    // nullptr on a miss.
+    std::shared_ptr<SO3vecB_array> get(const KEY& key){
+      std::lock_guard<std::mutex> lock(mx);
+      auto it=entries.find(key);
+      if(it==entries.end()){
+	nmisses++;
+	return nullptr;
+      }
+      nhits++;
+      lru.erase(it->second.pos);
+      lru.push_front(key);
+      it->second.pos=lru.begin();
+      return it->second.v;
+    }
+
+    void put(const KEY& key, const std::shared_ptr<SO3vecB_array>& v){
+      const size_t b=record_bytes(*v);
+      std::lock_guard<std::mutex> lock(mx);
+      if(b>budget) return;   // never cache a record that exceeds the whole budget
+      auto it=entries.find(key);
+      if(it!=entries.end()){
+	used-=it->second.bytes;
+	lru.erase(it->second.pos);
+	entries.erase(it);
+      }
+      while(used+b>budget){
+	auto victim=entries.find(lru.back());
+	used-=victim->second.bytes;
+	entries.erase(victim);
+	lru.pop_back();
+      }
+      lru.push_front(key);
+      entries[key]=Entry{v,b,lru.begin()};
+      used+=b;
+    }
+
+
+  private:
+
+    static size_t record_bytes(const SO3vecB_array& v){
+      size_t r=0;
+      for(auto p:v.parts)
+	if(p) r+=2*p->dims.total()*sizeof(float);
+      return r;
+    }
+
+  };
+
+}
+
+#endif
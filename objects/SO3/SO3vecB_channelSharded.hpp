@@ -0,0 +1,246 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3vecB_channelSharded
+#define _SO3vecB_channelSharded
+
+#include "GElib_base.hpp"
+#include "SO3vecB.hpp"
+#include "SO3weights.hpp"
+#include "GElibThreadPool.hpp"
+
+
+namespace GElib{
+
+  // Model-parallel wrapper around SO3vecB for layers whose N1*N2
+  // post-CG channel dimension exceeds one GPU's memory. Where
+  // SO3vecB_shardedArray splits the cells (data parallelism), this
+  // splits the channel dimension of every part across the devices: each
+  // shard holds a contiguous channel slice of x, and because the
+  // CGproduct kernels address each (l1,l2) fragment through a column
+  // offset, restricting the n1 channels of x restricts every fragment
+  // to a contiguous block of the product's columns. The fused
+  // CGproduct+mix then runs shard-locally against a per-device replica
+  // of y and the matching row block of the mixing weights, each device
+  // producing a full-width partial of the (narrow) mixed output, and
+  // only that reduced output is communicated and summed -- the wide CG
+  // channel dimension never exists on any single device.
+
+  class SO3vecB_channelSharded{
+  public:
+
+    vector<int> gpus;
+    vector<vector<int> > chan_offs;  // per part: start channel of each shard, total at the end
+    vector<SO3vecB*> shards;
+
+
+    SO3vecB_channelSharded(){}
+
+    ~SO3vecB_channelSharded(){
+      for(auto p:shards) delete p;
+    }
+
+    SO3vecB_channelSharded(const SO3vecB_channelSharded& x)=delete;
+    SO3vecB_channelSharded& operator=(const SO3vecB_channelSharded& x)=delete;
+
+    SO3vecB_channelSharded(SO3vecB_channelSharded&& x):
+      gpus(std::move(x.gpus)), chan_offs(std::move(x.chan_offs)), shards(std::move(x.shards)){
+      x.shards.clear();
+    }
+
+
+    // Scatter x from the host across the given devices, each shard
+    // taking a contiguous channel slice of every part.
+    SO3vecB_channelSharded(const SO3vecB& x, const vector<int>& _gpus):
+      gpus(_gpus){
+      GELIB_ASSRT(gpus.size()>0);
+      GELIB_ASSRT(x.get_dev()==0);
+
+      const int nshards=gpus.size();
+      const SO3type tau=x.get_tau();
+      chan_offs.resize(tau.size());
+      for(int l=0; l<(int)tau.size(); l++){
+	chan_offs[l].resize(nshards+1);
+	for(int i=0; i<=nshards; i++) chan_offs[l][i]=((long)tau[l]*i)/nshards;
+      }
+
+      for(int i=0; i<nshards; i++){
+	SO3type taui;
+	for(int l=0; l<(int)tau.size(); l++) taui.push_back(chan_offs[l][i+1]-chan_offs[l][i]);
+	SO3vecB s=SO3vecB::zero(x.getb(),taui,0);
+	for(int l=0; l<(int)tau.size(); l++)
+	  copy_channels(*s.parts[l],0,*x.parts[l],chan_offs[l][i],taui[l]);
+	set_device(gpus[i]);
+	shards.push_back(new SO3vecB(s.to_device(devflag(gpus[i]))));
+      }
+    }
+
+
+  public: // ---- Access -------------------------------------------------------------------------------------
+
+
+    int nshards() const{
+      return shards.size();
+    }
+
+    // Full (unsharded) type.
+    SO3type get_tau() const{
+      GELIB_ASSRT(chan_offs.size()>0);
+      SO3type R;
+      for(auto& v:chan_offs) R.push_back(v.back());
+      return R;
+    }
+
+
+  public: // ---- Operations ---------------------------------------------------------------------------------
+
+
+    // Fused CGproduct+mix with the channel dimension sharded: each
+    // device forms the CG product of its channel slice of x with a
+    // local replica of y -- only the shard's block of the product's
+    // columns -- and mixes it through the matching rows of w, so every
+    // device produces a full-width partial of the narrow mixed output.
+    // Those partials are the only cross-device traffic; they are summed
+    // on the host and the total returned there.
+    SO3vecB CGproduct_mix(const SO3vecB& y, const SO3weights& w, const int maxl=-1) const{
+      GELIB_ASSRT(shards.size()>0);
+      GELIB_ASSRT(y.get_dev()==0);
+
+      vector<SO3vecB*> partials(shards.size(),nullptr);
+      GElibMultiLoop(shards.size(),[&](const int i){
+	  set_device(gpus[i]);
+	  SO3vecB yi=y.to_device(devflag(gpus[i]));
+	  SO3weights wi=to_device(shard_weights(w,y.get_tau(),maxl,i),devflag(gpus[i]));
+	  partials[i]=new SO3vecB(shards[i]->CGproduct_mix(yi,wi,maxl));
+	},1);
+
+      SO3vecB R=partials[0]->to_device(0);
+      delete partials[0];
+      for(int i=1; i<(int)partials.size(); i++){
+	R.add(partials[i]->to_device(0));
+	delete partials[i];
+      }
+      return R;
+    }
+
+
+    // The rows of w.tensors[l] index the (l1,l2) fragments of the full
+    // CG product in concatenation order; shard i's slice of the n1
+    // channels covers rows [a*N2,b*N2) of each fragment, so its weight
+    // block is those row runs stacked in the same fragment order.
+    SO3weights shard_weights(const SO3weights& w, const SO3type& ytau, const int maxl, const int i) const{
+      const SO3type tau=get_tau();
+      const int L1=tau.size()-1;
+      const int L2=ytau.size()-1;
+      const SO3type ptau=GElib::CGproduct(tau,ytau,maxl);
+      const int L=ptau.size()-1;
+      GELIB_ASSRT((int)w.tensors.size()==ptau.size());
+
+      SO3type ptaui;
+      for(int l=0; l<=L; l++) ptaui.push_back(0);
+      for(int l1=0; l1<=L1; l1++)
+	for(int l2=0; l2<=L2; l2++)
+	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++)
+	    ptaui[l]+=(chan_offs[l1][i+1]-chan_offs[l1][i])*ytau[l2];
+
+      SO3type wtau;
+      for(int l=0; l<=L; l++) wtau.push_back(w.tensors[l]->get_dim(1));
+      SO3weights R=SO3weights::zero(ptaui,wtau,0);
+
+      vector<int> roffs(L+1,0);
+      vector<int> loffs(L+1,0);
+      for(int l1=0; l1<=L1; l1++){
+	for(int l2=0; l2<=L2; l2++){
+	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
+	    const int N2=ytau[l2];
+	    const int a=chan_offs[l1][i];
+	    const int b=chan_offs[l1][i+1];
+	    copy_rows(*R.tensors[l],loffs[l],*w.tensors[l],roffs[l]+a*N2,(b-a)*N2);
+	    roffs[l]+=tau[l1]*N2;
+	    loffs[l]+=(b-a)*N2;
+	  }
+	}
+      }
+      return R;
+    }
+
+
+    // Reassemble the full vector on the host.
+    SO3vecB gather() const{
+      GELIB_ASSRT(shards.size()>0);
+      SO3vecB R=SO3vecB::zero(shards[0]->getb(),get_tau(),0);
+      for(int i=0; i<(int)shards.size(); i++){
+	set_device(gpus[i]);
+	SO3vecB s=shards[i]->to_device(0);
+	for(int l=0; l<(int)R.parts.size(); l++)
+	  copy_channels(*R.parts[l],chan_offs[l][i],*s.parts[l],0,chan_offs[l][i+1]-chan_offs[l][i]);
+      }
+      return R;
+    }
+
+
+  private: // ---- Transport ---------------------------------------------------------------------------------
+
+
+    static void set_device(const int gpu){
+#ifdef _WITH_CUDA
+      if(gpu>=0) CUDA_SAFE(cudaSetDevice(gpu));
+#endif
+    }
+
+    static int devflag(const int gpu){
+#ifdef _WITH_CUDA
+      return gpu>=0? 1:0;
+#else
+      return 0;
+#endif
+    }
+
+    static SO3weights to_device(const SO3weights& w, const int _dev){
+      if(_dev==0) return w;
+      cnine::CtensorPackObj R;
+      for(auto t:w.tensors)
+	R.tensors.push_back(new cnine::CtensorObj(*t,_dev));
+      return R;
+    }
+
+    // Copies nch channels of every (batch,m) row; host only.
+    static void copy_channels(SO3partB& dst, const int doff,
+      const SO3partB& src, const int soff, const int nch){
+      const int l=src.getl();
+      const SO3part3_view sv=src.view();
+      const SO3part3_view dv=dst.view();
+      GELIB_ASSRT(sv.n0==dv.n0);
+      for(int b=0; b<sv.n0; b++){
+	SO3part2_view d2=dv.slice0(b);
+	SO3part2_view s2=sv.slice0(b);
+	for(int m=-l; m<=l; m++)
+	  for(int j=0; j<nch; j++)
+	    d2.set(m,doff+j,s2(m,soff+j));
+      }
+    }
+
+    // Copies a contiguous row block between freshly constructed
+    // (contiguous, row-major) weight tensors; host only.
+    static void copy_rows(cnine::CtensorObj& dst, const int doff,
+      const cnine::CtensorObj& src, const int soff, const int nrows){
+      const int nc=src.get_dim(1);
+      GELIB_ASSRT(dst.get_dim(1)==nc);
+      GELIB_ASSRT(doff+nrows<=dst.get_dim(0));
+      GELIB_ASSRT(soff+nrows<=src.get_dim(0));
+      std::memcpy(dst.arr+((long)doff)*nc,src.arr+((long)soff)*nc,((long)nrows)*nc*sizeof(float));
+      std::memcpy(dst.arr+dst.coffs+((long)doff)*nc,src.arr+src.coffs+((long)soff)*nc,((long)nrows)*nc*sizeof(float));
+    }
+
+  };
+
+}
+
+#endif
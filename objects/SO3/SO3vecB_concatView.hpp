@@ -0,0 +1,275 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3vecB_concatView
+#define _SO3vecB_concatView
+
+#include "GElib_base.hpp"
+#include "SO3vecB.hpp"
+
+
+namespace GElib{
+
+  // Zero-copy concatenation of several SO3vecB's along the channel
+  // dimension, the standard skip-connection pattern. Forming the
+  // concatenation for real copies every part into a fresh allocation,
+  // yet the op the concatenated vector is usually fed to -- the next
+  // CG product -- already addresses each (l1,l2) fragment of its
+  // output through a column offset. Restricting the n1 channels of x
+  // to one source restricts every fragment to a contiguous column
+  // block of the product, so the sources can be fed to the part-level
+  // kernels one by one, each at the offset its channels would occupy
+  // after a real concatenation, and the result is identical to the
+  // product against the materialized vector. The view holds only
+  // pointers to the sources; materialize() is the escape hatch for
+  // downstream ops that genuinely need one contiguous object.
+
+  class SO3vecB_concatView{
+  public:
+
+    vector<SO3vecB*> sources;  // not owned
+
+
+    SO3vecB_concatView(const vector<SO3vecB*>& _sources):
+      sources(_sources){
+      GELIB_ASSRT(sources.size()>0);
+      for(auto p:sources){
+	GELIB_ASSRT(p->getb()==sources[0]->getb());
+	GELIB_ASSRT(p->get_dev()==sources[0]->get_dev());
+      }
+    }
+
+    SO3vecB_concatView(SO3vecB& x, SO3vecB& y):
+      SO3vecB_concatView(vector<SO3vecB*>({&x,&y})){}
+
+
+  public: // ---- Access -------------------------------------------------------------------------------------
+
+
+    int getb() const{
+      return sources[0]->getb();
+    }
+
+    int get_dev() const{
+      return sources[0]->get_dev();
+    }
+
+    int get_maxl() const{
+      int r=0;
+      for(auto p:sources) r=std::max(r,p->get_maxl());
+      return r;
+    }
+
+    // Type of the concatenated vector: per l, the sum of the sources'
+    // channel counts.
+    SO3type get_tau() const{
+      SO3type R(get_maxl()+1,cnine::fill_raw());
+      for(auto p:sources)
+	for(int l=0; l<(int)p->parts.size(); l++)
+	  R[l]+=p->parts[l]->getn();
+      return R;
+    }
+
+    // Number of channels source s contributes at l.
+    int nch(const int s, const int l) const{
+      if(l>=(int)sources[s]->parts.size()) return 0;
+      return sources[s]->parts[l]->getn();
+    }
+
+
+  public: // ---- CG-products --------------------------------------------------------------------------------
+
+
+    SO3vecB CGproduct(const SO3vecB& y, const int maxl=-1) const{
+      GELIB_ASSRT(getb()==y.getb());
+      SO3vecB R=SO3vecB::zero(getb(),GElib::CGproduct_cached(get_tau(),y.get_tau(),maxl),get_dev());
+      add_CGproduct_to(R,y);
+      return R;
+    }
+
+    // Forward product with this as the left operand: each (l1,l2,l)
+    // triple is issued once per source, offset past the columns of the
+    // sources before it, so r matches r.add_CGproduct(materialize(),y)
+    // without the concatenation ever being formed. On the CPU the
+    // per-source calls write disjoint column blocks, so they run
+    // concurrently through the task graph like the backward passes.
+    void add_CGproduct_to(SO3vecB& r, const SO3vecB& y) const{
+      const SO3type tau=get_tau();
+      assert(r.get_tau()==GElib::CGproduct(tau,y.get_tau(),r.get_maxl()));
+
+      const int L1=tau.size()-1;
+      const int L2=y.get_maxl();
+      const int L=r.get_maxl();
+      vector<int> offs(r.parts.size(),0);
+
+      GElibTaskGraph graph;
+      for(int l1=0; l1<=L1; l1++){
+	for(int l2=0; l2<=L2; l2++){
+	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
+	    const int N2=y.parts[l2]->getn();
+	    int cum=0;
+	    for(int s=0; s<(int)sources.size(); s++){
+	      const int n1=nch(s,l1);
+	      if(n1==0) continue;
+	      const int o=offs[l]+cum*N2;
+	      if(get_dev()>0){
+		r.parts[l]->add_CGproduct(*sources[s]->parts[l1],*y.parts[l2],o);
+	      }else{
+		SO3partB* xp=sources[s]->parts[l1];
+		graph.add([&r,&y,xp,l2,l,o](){
+		    r.parts[l]->add_CGproduct(*xp,*y.parts[l2],o);},
+		  {GElibTaskGraph::Region(xp),GElibTaskGraph::Region(y.parts[l2])},
+		  {GElibTaskGraph::Region(r.parts[l],o,o+n1*N2)});
+	      }
+	      cum+=n1;
+	    }
+	    offs[l]+=tau[l1]*N2;
+	  }
+	}
+      }
+      graph.run();
+    }
+
+
+    // Backward to the left operand: this is a concat-view over the
+    // sources' gradient vecs, and each fragment call accumulates
+    // straight into the source gradient it belongs to -- the
+    // concatenated gradient never exists either.
+    void add_CGproduct_back0(const SO3vecB& g, const SO3vecB& y){
+      const SO3type tau=get_tau();
+      assert(g.get_tau()==GElib::CGproduct(tau,y.get_tau(),g.get_maxl()));
+
+      const int L1=tau.size()-1;
+      const int L2=y.get_maxl();
+      const int L=g.get_maxl();
+      vector<int> offs(g.parts.size(),0);
+
+      GElibTaskGraph graph;
+      for(int l1=0; l1<=L1; l1++){
+	for(int l2=0; l2<=L2; l2++){
+	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
+	    const int N2=y.parts[l2]->getn();
+	    int cum=0;
+	    for(int s=0; s<(int)sources.size(); s++){
+	      const int n1=nch(s,l1);
+	      if(n1==0) continue;
+	      const int o=offs[l]+cum*N2;
+	      if(get_dev()>0){
+		sources[s]->parts[l1]->add_CGproduct_back0(*g.parts[l],*y.parts[l2],o);
+	      }else{
+		SO3partB* xp=sources[s]->parts[l1];
+		graph.add([&g,&y,xp,l2,l,o](){
+		    xp->add_CGproduct_back0(*g.parts[l],*y.parts[l2],o);},
+		  {GElibTaskGraph::Region(g.parts[l],o,o+n1*N2),GElibTaskGraph::Region(y.parts[l2])},
+		  {GElibTaskGraph::Region(xp)});
+	      }
+	      cum+=n1;
+	    }
+	    offs[l]+=tau[l1]*N2;
+	  }
+	}
+      }
+      graph.run();
+    }
+
+
+    // Backward to the right operand, accumulated into yg.
+    void add_CGproduct_back1(SO3vecB& yg, const SO3vecB& g) const{
+      const SO3type tau=get_tau();
+      assert(g.get_tau()==GElib::CGproduct(tau,yg.get_tau(),g.get_maxl()));
+
+      const int L1=tau.size()-1;
+      const int L2=yg.get_maxl();
+      const int L=g.get_maxl();
+      vector<int> offs(g.parts.size(),0);
+
+      GElibTaskGraph graph;
+      for(int l1=0; l1<=L1; l1++){
+	for(int l2=0; l2<=L2; l2++){
+	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
+	    const int N2=yg.parts[l2]->getn();
+	    int cum=0;
+	    for(int s=0; s<(int)sources.size(); s++){
+	      const int n1=nch(s,l1);
+	      if(n1==0) continue;
+	      const int o=offs[l]+cum*N2;
+	      if(get_dev()>0){
+		yg.parts[l2]->add_CGproduct_back1(*g.parts[l],*sources[s]->parts[l1],o);
+	      }else{
+		SO3partB* xp=sources[s]->parts[l1];
+		graph.add([&yg,&g,xp,l2,l,o](){
+		    yg.parts[l2]->add_CGproduct_back1(*g.parts[l],*xp,o);},
+		  {GElibTaskGraph::Region(g.parts[l],o,o+n1*N2),GElibTaskGraph::Region(xp)},
+		  {GElibTaskGraph::Region(yg.parts[l2])});
+	      }
+	      cum+=n1;
+	    }
+	    offs[l]+=tau[l1]*N2;
+	  }
+	}
+      }
+      graph.run();
+    }
+
+
+  public: // ---- Materialization ----------------------------------------------------------------------------
+
+
+    // Copies the sources into one contiguous SO3vecB, for downstream
+    // ops that address the channels of a part through a single view.
+    // Host only, like the channel copies in SO3vecB_channelSharded;
+    // on the device the CG-product forms above consume the view
+    // directly and no materialization is needed.
+    SO3vecB materialize() const{
+      GELIB_ASSRT(get_dev()==0);
+      SO3vecB R=SO3vecB::zero(getb(),get_tau(),0);
+      for(int l=0; l<(int)R.parts.size(); l++){
+	const SO3part3_view dv=R.parts[l]->view();
+	int cum=0;
+	for(int s=0; s<(int)sources.size(); s++){
+	  const int n1=nch(s,l);
+	  if(n1==0) continue;
+	  const SO3part3_view sv=sources[s]->parts[l]->view();
+	  const int doff=cum;
+	  GElibMultiLoop(dv.n0,[&](const int b){
+	      SO3part2_view d2=dv.slice0(b);
+	      SO3part2_view s2=sv.slice0(b);
+	      for(int m=-l; m<=l; m++)
+		for(int j=0; j<n1; j++)
+		  d2.set(m,doff+j,s2(m,j));
+	    });
+	  cum+=n1;
+	}
+      }
+      return R;
+    }
+
+
+  public: // ---- I/O ----------------------------------------------------------------------------------------
+
+
+    string classname() const{
+      return "GElib::SO3vecB_concatView";
+    }
+
+    string repr(const string indent="") const{
+      return indent+"<GElib::SO3vecB_concatView of "+to_string(sources.size())+
+	" sources, tau="+get_tau().str()+">";
+    }
+
+    friend ostream& operator<<(ostream& stream, const SO3vecB_concatView& x){
+      stream<<x.repr(); return stream;
+    }
+
+  };
+
+}
+
+#endif
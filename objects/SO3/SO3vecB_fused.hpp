@@ -0,0 +1,255 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3vecB_fused
+#define _SO3vecB_fused
+
+#include <cstdlib>
+#include <cstring>
+
+#include "GElib_base.hpp"
+#include "GElibCudaArena.hpp"
+#include "GElibMemoryMonitor.hpp"
+#include "GElibScratchArena.hpp"
+#include "GElibThreadPool.hpp"
+#include "SO3part3_view.hpp"
+#include "SO3type.hpp"
+#include "SO3vec_addCGproductFn.hpp"
+
+
+namespace GElib{
+
+  // Fused-buffer SO(3)-vector: all parts live in a single allocation
+  // with an offset table, instead of one heap/device allocation per l
+  // as in SO3vecB. Each part is exposed as an SO3part3_view into the
+  // buffer, so the whole view-based Fn layer operates on it unchanged,
+  // while whole-vector operations (zeroing, axpy, copy) become one
+  // sweep over a contiguous range rather than parts.size() separate
+  // launches. Layout per part: [b][2l+1][n] real plane followed by the
+  // imaginary plane (coffs = part size), i.e. the planar layout of
+  // SO3part3_view::is_planar(), so the vectorized CPU kernels use
+  // fully contiguous loads on these vectors.
+  //
+  // The optional padded layout additionally rounds each channel row up
+  // to 16 floats, so with the 64-byte aligned base every (b,m) row
+  // starts on a 64-byte boundary and the SIMD kernels run aligned and
+  // full-width with no scalar epilogues. The padding is carried purely
+  // in the view strides -- view extents, indexing and the API are
+  // unchanged -- and the pad columns are zero-initialized and never
+  // written by the kernels, so the whole-buffer sweeps (zeroing, axpy,
+  // copy) remain plain contiguous passes.
+
+  class SO3vecB_fused{
+  public:
+
+    static const int pad_floats=16;  // 64 bytes
+
+    int b;
+    int dev;
+    SO3type tau;
+    float* arr=nullptr;
+    size_t asize=0;           // total floats, both planes of all parts
+    vector<size_t> offs;      // start of each part within arr, in floats
+    bool owns=true;
+    bool padded=false;
+    GElibMemoryHold mem_hold;
+
+
+    SO3vecB_fused(){}
+
+    SO3vecB_fused(const int _b, const SO3type& _tau, const int _dev=0, const bool _padded=false):
+      b(_b), dev(_dev), tau(_tau), padded(_padded){
+      offs.resize(tau.size());
+      size_t t=0;
+      for(int l=0; l<(int)tau.size(); l++){
+	offs[l]=t;
+	t+=2*((size_t)b)*(2*l+1)*row_floats(l);
+      }
+      asize=t;
+      if(dev==0){
+	arr=(float*)std::aligned_alloc(64,((asize*sizeof(float)+63)/64)*64);
+	std::memset(arr,0,asize*sizeof(float));
+      }
+#ifdef _WITH_CUDA
+      else{
+	arr=(float*)gelib_cuda_arena.alloc(asize*sizeof(float));
+	CUDA_SAFE(cudaMemset(arr,0,asize*sizeof(float)));
+      }
+#endif
+      mem_hold.set("SO3vecB_fused",dev,((long long)asize)*sizeof(float));
+    }
+
+    static SO3vecB_fused padded_zero(const int _b, const SO3type& _tau, const int _dev=0){
+      return SO3vecB_fused(_b,_tau,_dev,true);
+    }
+
+    ~SO3vecB_fused(){
+      if(!arr || !owns) return;
+      if(dev==0) std::free(arr);
+#ifdef _WITH_CUDA
+      else gelib_cuda_arena.free(arr);
+#endif
+    }
+
+    SO3vecB_fused(const SO3vecB_fused& x):
+      SO3vecB_fused(x.b,x.tau,x.dev,x.padded){
+      GELIB_COPY_WARNING();
+      copy_buffer(x);
+    }
+
+    SO3vecB_fused(SO3vecB_fused&& x):
+      b(x.b), dev(x.dev), tau(x.tau), arr(x.arr), asize(x.asize), offs(std::move(x.offs)), owns(x.owns),
+      padded(x.padded), mem_hold(std::move(x.mem_hold)){
+      x.arr=nullptr;
+    }
+
+    // Backed by the thread-local scratch arena: must not outlive the
+    // enclosing GElibScratchArena::scope. Host only.
+    static SO3vecB_fused scratch(const int _b, const SO3type& _tau){
+      SO3vecB_fused R;
+      R.b=_b;
+      R.dev=0;
+      R.tau=_tau;
+      R.offs.resize(_tau.size());
+      size_t t=0;
+      for(int l=0; l<(int)_tau.size(); l++){
+	R.offs[l]=t;
+	t+=2*((size_t)_b)*(2*l+1)*_tau[l];
+      }
+      R.asize=t;
+      R.arr=(float*)gelib_scratch.alloc(t*sizeof(float));
+      std::memset(R.arr,0,t*sizeof(float));
+      R.owns=false;
+      return R;
+    }
+
+    SO3vecB_fused& operator=(const SO3vecB_fused& x)=delete;
+
+
+  public: // ---- Access -------------------------------------------------------------------------------------
+
+
+    int getb() const{
+      return b;
+    }
+
+    int get_dev() const{
+      return dev;
+    }
+
+    SO3type get_tau() const{
+      return tau;
+    }
+
+    int get_maxl() const{
+      return tau.size()-1;
+    }
+
+    // Stored length of one channel row of part l, including padding.
+    int row_floats(const int l) const{
+      if(padded) return ((tau[l]+pad_floats-1)/pad_floats)*pad_floats;
+      return tau[l];
+    }
+
+    // Number of floats in one plane of part l.
+    size_t part_size(const int l) const{
+      return ((size_t)b)*(2*l+1)*row_floats(l);
+    }
+
+    SO3part3_view part_view(const int l) const{
+      const int n=tau[l];
+      const int rn=row_floats(l);
+      return SO3part3_view(arr+offs[l],cnine::Gdims({b,2*l+1,n}),
+	cnine::Gstrides({(2*l+1)*rn,rn,1}),part_size(l),dev);
+    }
+
+    vector<SO3part3_view> part_views() const{
+      vector<SO3part3_view> R;
+      for(int l=0; l<(int)tau.size(); l++)
+	R.push_back(part_view(l));
+      return R;
+    }
+
+
+  public: // ---- Whole-vector operations --------------------------------------------------------------------
+
+
+    void set_zero(){
+      if(dev==0){
+	std::memset(arr,0,asize*sizeof(float));
+	return;
+      }
+#ifdef _WITH_CUDA
+      CUDA_SAFE(cudaMemset(arr,0,asize*sizeof(float)));
+#endif
+    }
+
+    void copy_buffer(const SO3vecB_fused& x){
+      GELIB_ASSRT(x.asize==asize);
+      GELIB_ASSRT(x.dev==dev);
+      if(dev==0){
+	std::memcpy(arr,x.arr,asize*sizeof(float));
+	return;
+      }
+#ifdef _WITH_CUDA
+      CUDA_SAFE(cudaMemcpy(arr,x.arr,asize*sizeof(float),cudaMemcpyDeviceToDevice));
+#endif
+    }
+
+    void add(const SO3vecB_fused& x, const float c=1.0){
+      GELIB_ASSRT(x.asize==asize);
+      GELIB_ASSRT(dev==0);   // on the GPU, go through the view-level Fns
+      float* a=arr;
+      const float* xa=x.arr;
+      const long page_floats=4096/sizeof(float);
+      const long npages=(asize+page_floats-1)/page_floats;
+      GElibMultiLoopStatic(npages,[&](const int i){
+	  const long beg=((long)i)*page_floats;
+	  const long end=std::min<long>(beg+page_floats,asize);
+	  for(long j=beg; j<end; j++) a[j]+=c*xa[j];
+	});
+    }
+
+
+  public: // ---- Operations ---------------------------------------------------------------------------------
+
+
+    void add_CGproduct(const SO3vecB_fused& x, const SO3vecB_fused& y){
+      SO3vec_addCGproductFn()(part_views(),x.part_views(),y.part_views());
+    }
+
+    SO3vecB_fused CGproduct(const SO3vecB_fused& y, const int maxl=-1) const{
+      SO3vecB_fused R(b,GElib::CGproduct_cached(tau,y.tau,maxl),dev);
+      R.add_CGproduct(*this,y);
+      return R;
+    }
+
+
+  public: // ---- I/O ----------------------------------------------------------------------------------------
+
+
+    string str(const string indent="") const{
+      ostringstream oss;
+      for(int l=0; l<(int)tau.size(); l++){
+	oss<<indent<<"Part l="<<l<<":"<<endl;
+	oss<<part_view(l).str(indent+"  ");
+      }
+      return oss.str();
+    }
+
+    friend ostream& operator<<(ostream& stream, const SO3vecB_fused& x){
+      stream<<x.str(); return stream;
+    }
+
+  };
+
+}
+
+#endif
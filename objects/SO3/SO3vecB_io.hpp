@@ -0,0 +1,499 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3vecB_io
+#define _SO3vecB_io
+
+#include <fstream>
+#include <cstring>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(__F16C__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "SO3vecB.hpp"
+#include "SO3vecB_array.hpp"
+
+
+namespace GElib{
+
+  // Native binary storage for precomputed SO3vecB / SO3vecB_array
+  // datasets, so feature files are read back with a single mapping or
+  // memcpy per part instead of a round trip through pickled arrays.
+  //
+  // File layout: 8-byte magic "GELIBVEC", uint32 version (1), uint32
+  // dtype, int32 kind (0 = SO3vecB, 1 = SO3vecB_array), int32 b, int32
+  // nadims followed by nadims int32 array dimensions (nadims=0 for
+  // plain vectors), int32 nparts, then for each part int32 l, int32 n
+  // and a uint64 payload offset from the start of the file. Each
+  // payload begins on a 64-byte boundary and holds the part's real
+  // plane followed by its imaginary plane, i.e. the regular cnine
+  // layout, so a float32 part can view the bytes in place.
+  //
+  // dtype selects the on-disk element representation: 0 = raw float32,
+  // 1 = fp16, 2 = int8 with a per-part scale (the payload then starts
+  // with a 64-byte block whose first float is the scale, followed by
+  // the planes). Quantized files are dequantized into fp32 parts at
+  // load with the vectorized converters below; they halve or quarter
+  // archive bandwidth at the cost of losing the mmap zero-copy mode,
+  // which requires dtype 0.
+
+  const uint32_t SO3vecB_io_fp32=0;
+  const uint32_t SO3vecB_io_fp16=1;
+  const uint32_t SO3vecB_io_int8=2;
+
+  const int SO3vecB_io_align=64;
+
+  inline size_t SO3vecB_io_header_size(const int nadims, const int nparts){
+    return 8+4+4+4+4+4*(size_t)nadims+4+16*(size_t)nparts;
+  }
+
+  inline size_t SO3vecB_io_round_up(const size_t x){
+    return (x+SO3vecB_io_align-1)/SO3vecB_io_align*SO3vecB_io_align;
+  }
+
+  // Bytes occupied by one part payload (both planes, plus the scale
+  // block for int8), before alignment padding.
+  inline size_t SO3vecB_io_payload_bytes(const size_t asize, const uint32_t dtype){
+    if(dtype==SO3vecB_io_fp16) return 2*asize*sizeof(uint16_t);
+    if(dtype==SO3vecB_io_int8) return SO3vecB_io_align+2*asize;
+    return 2*asize*sizeof(float);
+  }
+
+
+  // ---- Quantized element conversion -----------------------------------------------------------------------
+
+
+  // Scalar fallback matching the F16C conversion exactly: NaNs keep
+  // their (truncated) payload instead of collapsing to Inf, and ties
+  // round to nearest-even, so a buffer converts identically whether an
+  // element lands in the vector body or the scalar tail.
+  inline uint16_t SO3vecB_io_float_to_half(const float x){
+    uint32_t u;
+    std::memcpy(&u,&x,4);
+    const uint16_t sign=(u>>16)&0x8000;
+    const int32_t e=((u>>23)&0xff)-127+15;
+    uint32_t m=u&0x7fffff;
+    if(((u>>23)&0xff)==0xff){
+      if(m) return sign|0x7c00|(m>>13)|1;
+      return sign|0x7c00;
+    }
+    if(e>=31) return sign|0x7c00;
+    if(e<=0){
+      if(e<-10) return sign;
+      m|=0x800000;
+      const int shift=14-e;
+      uint16_t q=m>>shift;
+      const uint32_t rem=m&((1u<<shift)-1);
+      const uint32_t half=1u<<(shift-1);
+      if(rem>half || (rem==half && (q&1))) q++;
+      return sign|q;
+    }
+    uint16_t q=sign|(e<<10)|(m>>13);
+    const uint32_t rem=m&0x1fff;
+    if(rem>0x1000 || (rem==0x1000 && (q&1))) q++;
+    return q;
+  }
+
+  inline float SO3vecB_io_half_to_float(const uint16_t h){
+    const uint32_t sign=((uint32_t)(h&0x8000))<<16;
+    uint32_t e=(h>>10)&0x1f;
+    uint32_t m=h&0x3ff;
+    uint32_t u;
+    if(e==0){
+      if(m==0) u=sign;
+      else{
+	e=113;
+	while(!(m&0x400)){m<<=1; e--;}
+	u=sign|(e<<23)|((m&0x3ff)<<13);
+      }
+    }
+    else if(e==31) u=sign|0x7f800000|(m<<13);
+    else u=sign|((e+112)<<23)|(m<<13);
+    float r;
+    std::memcpy(&r,&u,4);
+    return r;
+  }
+
+  inline void SO3vecB_io_quant_fp16(const float* src, uint16_t* dst, const size_t n){
+    size_t i=0;
+#ifdef __F16C__
+    for(; i+8<=n; i+=8)
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst+i),
+	_mm256_cvtps_ph(_mm256_loadu_ps(src+i),_MM_FROUND_TO_NEAREST_INT));
+#endif
+    for(; i<n; i++) dst[i]=SO3vecB_io_float_to_half(src[i]);
+  }
+
+  inline void SO3vecB_io_dequant_fp16(const uint16_t* src, float* dst, const size_t n){
+    size_t i=0;
+#ifdef __F16C__
+    for(; i+8<=n; i+=8)
+      _mm256_storeu_ps(dst+i,
+	_mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i))));
+#endif
+    for(; i<n; i++) dst[i]=SO3vecB_io_half_to_float(src[i]);
+  }
+
+  inline void SO3vecB_io_quant_int8(const float* src, int8_t* dst, const size_t n, const float scale){
+    const float iscale=(scale>0? 1.0f/scale : 0.0f);
+    for(size_t i=0; i<n; i++){
+      int q=(int)std::lrintf(src[i]*iscale);
+      if(q>127) q=127;
+      if(q<-127) q=-127;
+      dst[i]=(int8_t)q;
+    }
+  }
+
+  inline void SO3vecB_io_dequant_int8(const int8_t* src, float* dst, const size_t n, const float scale){
+    for(size_t i=0; i<n; i++) dst[i]=scale*src[i];
+  }
+
+
+  // ---- Saving ---------------------------------------------------------------------------------------------
+
+
+  // Writes one part payload (real plane, then imaginary plane, in the
+  // requested dtype) at the current position, which must be 64-byte
+  // aligned. For int8 the payload starts with a 64-byte scale block.
+  inline void SO3vecB_io_write_part(std::ofstream& out, const float* arr, const int coffs, const size_t asize,
+    const uint32_t dtype=SO3vecB_io_fp32){
+
+    if(dtype==SO3vecB_io_fp32){
+      out.write(reinterpret_cast<const char*>(arr),asize*sizeof(float));
+      out.write(reinterpret_cast<const char*>(arr+coffs),asize*sizeof(float));
+      return;
+    }
+
+    if(dtype==SO3vecB_io_fp16){
+      vector<uint16_t> buf(asize);
+      SO3vecB_io_quant_fp16(arr,buf.data(),asize);
+      out.write(reinterpret_cast<const char*>(buf.data()),asize*sizeof(uint16_t));
+      SO3vecB_io_quant_fp16(arr+coffs,buf.data(),asize);
+      out.write(reinterpret_cast<const char*>(buf.data()),asize*sizeof(uint16_t));
+      return;
+    }
+
+    if(dtype==SO3vecB_io_int8){
+      float amax=0;
+      for(size_t i=0; i<asize; i++) amax=std::max(amax,std::abs(arr[i]));
+      for(size_t i=0; i<asize; i++) amax=std::max(amax,std::abs(arr[coffs+i]));
+      float block[SO3vecB_io_align/sizeof(float)]={};
+      block[0]=amax/127;
+      out.write(reinterpret_cast<const char*>(block),SO3vecB_io_align);
+      vector<int8_t> buf(asize);
+      SO3vecB_io_quant_int8(arr,buf.data(),asize,block[0]);
+      out.write(reinterpret_cast<const char*>(buf.data()),asize);
+      SO3vecB_io_quant_int8(arr+coffs,buf.data(),asize,block[0]);
+      out.write(reinterpret_cast<const char*>(buf.data()),asize);
+      return;
+    }
+
+    GELIB_ERROR("Unknown dtype "+to_string(dtype));
+  }
+
+  inline void SO3vecB_io_pad(std::ofstream& out, size_t& pos, const size_t target){
+    static const char zeros[SO3vecB_io_align]={};
+    out.write(zeros,target-pos);
+    pos=target;
+  }
+
+  // The payload writer assumes the split-planar layout of natively
+  // allocated parts (real plane at arr, imaginary plane at arr+asize).
+  // Torch-viewed parts store interleaved complex entries (coffs=1);
+  // those are de-interleaved through a temporary here. Any other
+  // layout is an error rather than garbage on disk.
+  inline void SO3vecB_io_write_part_checked(std::ofstream& out, const cnine::CtensorB& P,
+    const uint32_t dtype){
+    const size_t asize=P.dims.total();
+    if(P.coffs==(int)asize){
+      SO3vecB_io_write_part(out,P.arr,P.coffs,asize,dtype);
+      return;
+    }
+    GELIB_CHECK(P.coffs==1,"save: unsupported part layout (coffs="+to_string(P.coffs)+").");
+    vector<float> tmp(2*asize);
+    for(size_t i=0; i<asize; i++){
+      tmp[i]=P.arr[2*i];
+      tmp[asize+i]=P.arr[2*i+1];
+    }
+    SO3vecB_io_write_part(out,tmp.data(),asize,asize,dtype);
+  }
+
+  inline void save(const SO3vecB& v, const string& path, const uint32_t dtype=SO3vecB_io_fp32){
+    GELIB_ASSRT(v.get_dev()==0);
+    GELIB_ASSRT(dtype<=SO3vecB_io_int8);
+    const int nparts=v.parts.size();
+    std::ofstream out(path,std::ios::binary|std::ios::trunc);
+    GELIB_CHECK(out.good(),"save: cannot open "+path+" for writing.");
+
+    const uint32_t version=1;
+    const int32_t kind=0;
+    const int32_t b=v.getb();
+    const int32_t nadims=0;
+    const int32_t np=nparts;
+    out.write("GELIBVEC",8);
+    out.write(reinterpret_cast<const char*>(&version),4);
+    out.write(reinterpret_cast<const char*>(&dtype),4);
+    out.write(reinterpret_cast<const char*>(&kind),4);
+    out.write(reinterpret_cast<const char*>(&b),4);
+    out.write(reinterpret_cast<const char*>(&nadims),4);
+    out.write(reinterpret_cast<const char*>(&np),4);
+
+    size_t offs=SO3vecB_io_round_up(SO3vecB_io_header_size(0,nparts));
+    for(int l=0; l<nparts; l++){
+      const int32_t _l=v.parts[l]->getl();
+      const int32_t _n=v.parts[l]->getn();
+      const uint64_t _o=offs;
+      out.write(reinterpret_cast<const char*>(&_l),4);
+      out.write(reinterpret_cast<const char*>(&_n),4);
+      out.write(reinterpret_cast<const char*>(&_o),8);
+      offs=SO3vecB_io_round_up(offs+SO3vecB_io_payload_bytes(v.parts[l]->dims.total(),dtype));
+    }
+
+    size_t pos=SO3vecB_io_header_size(0,nparts);
+    for(int l=0; l<nparts; l++){
+      SO3vecB_io_pad(out,pos,SO3vecB_io_round_up(pos));
+      const size_t asize=v.parts[l]->dims.total();
+      SO3vecB_io_write_part_checked(out,*v.parts[l],dtype);
+      pos+=SO3vecB_io_payload_bytes(asize,dtype);
+    }
+  }
+
+  inline void save(const SO3vecB_array& v, const string& path, const uint32_t dtype=SO3vecB_io_fp32){
+    GELIB_ASSRT(v.get_dev()==0);
+    GELIB_ASSRT(dtype<=SO3vecB_io_int8);
+    const int nparts=v.parts.size();
+    const cnine::Gdims adims=v.get_adims();
+    std::ofstream out(path,std::ios::binary|std::ios::trunc);
+    GELIB_CHECK(out.good(),"save: cannot open "+path+" for writing.");
+
+    const uint32_t version=1;
+    const int32_t kind=1;
+    const int32_t b=v.getb();
+    const int32_t nadims=adims.size();
+    const int32_t np=nparts;
+    out.write("GELIBVEC",8);
+    out.write(reinterpret_cast<const char*>(&version),4);
+    out.write(reinterpret_cast<const char*>(&dtype),4);
+    out.write(reinterpret_cast<const char*>(&kind),4);
+    out.write(reinterpret_cast<const char*>(&b),4);
+    out.write(reinterpret_cast<const char*>(&nadims),4);
+    for(int i=0; i<nadims; i++){
+      const int32_t d=adims(i);
+      out.write(reinterpret_cast<const char*>(&d),4);
+    }
+    out.write(reinterpret_cast<const char*>(&np),4);
+
+    size_t offs=SO3vecB_io_round_up(SO3vecB_io_header_size(nadims,nparts));
+    for(int l=0; l<nparts; l++){
+      const int32_t _l=v.parts[l]->getl();
+      const int32_t _n=v.parts[l]->getn();
+      const uint64_t _o=offs;
+      out.write(reinterpret_cast<const char*>(&_l),4);
+      out.write(reinterpret_cast<const char*>(&_n),4);
+      out.write(reinterpret_cast<const char*>(&_o),8);
+      offs=SO3vecB_io_round_up(offs+SO3vecB_io_payload_bytes(v.parts[l]->dims.total(),dtype));
+    }
+
+    size_t pos=SO3vecB_io_header_size(nadims,nparts);
+    for(int l=0; l<nparts; l++){
+      SO3vecB_io_pad(out,pos,SO3vecB_io_round_up(pos));
+      const size_t asize=v.parts[l]->dims.total();
+      SO3vecB_io_write_part_checked(out,*v.parts[l],dtype);
+      pos+=SO3vecB_io_payload_bytes(asize,dtype);
+    }
+  }
+
+
+  // ---- Loading --------------------------------------------------------------------------------------------
+
+
+  struct SO3vecB_io_header{
+    uint32_t version;
+    uint32_t dtype;
+    int32_t kind;
+    int32_t b;
+    vector<int> adims;
+    vector<int32_t> ls;
+    vector<int32_t> ns;
+    vector<uint64_t> offsets;
+    size_t size=0;
+
+    bool read(std::istream& in){
+      char magic[8];
+      in.read(magic,8);
+      in.read(reinterpret_cast<char*>(&version),4);
+      in.read(reinterpret_cast<char*>(&dtype),4);
+      in.read(reinterpret_cast<char*>(&kind),4);
+      in.read(reinterpret_cast<char*>(&b),4);
+      int32_t nadims;
+      in.read(reinterpret_cast<char*>(&nadims),4);
+      if(!in.good() || std::memcmp(magic,"GELIBVEC",8)!=0 || version!=1 || dtype>SO3vecB_io_int8 || nadims<0) return false;
+      for(int i=0; i<nadims; i++){
+	int32_t d;
+	in.read(reinterpret_cast<char*>(&d),4);
+	adims.push_back(d);
+      }
+      int32_t nparts;
+      in.read(reinterpret_cast<char*>(&nparts),4);
+      if(!in.good() || nparts<0) return false;
+      for(int l=0; l<nparts; l++){
+	int32_t _l, _n; uint64_t _o;
+	in.read(reinterpret_cast<char*>(&_l),4);
+	in.read(reinterpret_cast<char*>(&_n),4);
+	in.read(reinterpret_cast<char*>(&_o),8);
+	ls.push_back(_l);
+	ns.push_back(_n);
+	offsets.push_back(_o);
+      }
+      return in.good();
+    }
+  };
+
+  // Reads one part payload at the given offset into an fp32 part's two
+  // planes, dequantizing on the fly for fp16/int8 files.
+  inline void SO3vecB_io_read_part(std::ifstream& in, float* arr, const int coffs, const size_t asize,
+    const uint64_t offset, const uint32_t dtype){
+
+    in.seekg(offset);
+
+    if(dtype==SO3vecB_io_fp32){
+      in.read(reinterpret_cast<char*>(arr),asize*sizeof(float));
+      in.read(reinterpret_cast<char*>(arr+coffs),asize*sizeof(float));
+      return;
+    }
+
+    if(dtype==SO3vecB_io_fp16){
+      vector<uint16_t> buf(asize);
+      in.read(reinterpret_cast<char*>(buf.data()),asize*sizeof(uint16_t));
+      SO3vecB_io_dequant_fp16(buf.data(),arr,asize);
+      in.read(reinterpret_cast<char*>(buf.data()),asize*sizeof(uint16_t));
+      SO3vecB_io_dequant_fp16(buf.data(),arr+coffs,asize);
+      return;
+    }
+
+    if(dtype==SO3vecB_io_int8){
+      char block[SO3vecB_io_align];
+      in.read(block,SO3vecB_io_align);
+      float scale;
+      std::memcpy(&scale,block,4);
+      vector<int8_t> buf(asize);
+      in.read(reinterpret_cast<char*>(buf.data()),asize);
+      SO3vecB_io_dequant_int8(buf.data(),arr,asize,scale);
+      in.read(reinterpret_cast<char*>(buf.data()),asize);
+      SO3vecB_io_dequant_int8(buf.data(),arr+coffs,asize,scale);
+      return;
+    }
+
+    GELIB_ERROR("Unknown dtype "+to_string(dtype));
+  }
+
+  inline SO3vecB load_SO3vecB(const string& path){
+    std::ifstream in(path,std::ios::binary);
+    SO3vecB_io_header h;
+    if(!in.good() || !h.read(in)) GELIB_ERROR("Cannot read "+path);
+    GELIB_ASSRT(h.kind==0);
+    SO3vecB R;
+    for(int l=0; l<(int)h.ls.size(); l++){
+      SO3partB* p=new SO3partB(SO3partB::raw(h.b,h.ls[l],h.ns[l]));
+      SO3vecB_io_read_part(in,p->arr,p->coffs,p->dims.total(),h.offsets[l],h.dtype);
+      R.parts.push_back(p);
+    }
+    return R;
+  }
+
+  inline SO3vecB_array load_SO3vecB_array(const string& path){
+    std::ifstream in(path,std::ios::binary);
+    SO3vecB_io_header h;
+    if(!in.good() || !h.read(in)) GELIB_ERROR("Cannot read "+path);
+    GELIB_ASSRT(h.kind==1);
+    SO3type tau;
+    for(auto n:h.ns) tau.push_back(n);
+    SO3vecB_array R=SO3vecB_array::zero(h.b,cnine::Gdims(h.adims),tau,0);
+    for(int l=0; l<(int)h.ls.size(); l++)
+      SO3vecB_io_read_part(in,R.parts[l]->arr,R.parts[l]->coffs,R.parts[l]->dims.total(),h.offsets[l],h.dtype);
+    return R;
+  }
+
+
+  // ---- Mapped read mode -----------------------------------------------------------------------------------
+
+
+  // Maps a saved SO3vecB file and exposes the parts as zero-copy views
+  // of the mapping (see SO3partB::view_of). The mapping is private, so
+  // reads touch the page cache shared across processes while a write
+  // faults in a private copy of just the affected pages; the holder
+  // must outlive every use of vec().
+  class SO3vecB_mmap{
+  public:
+
+    SO3vecB v;
+
+    SO3vecB_mmap(const SO3vecB_mmap&)=delete;
+    SO3vecB_mmap& operator=(const SO3vecB_mmap&)=delete;
+
+    SO3vecB_mmap(const string& path){
+#ifdef __unix__
+      int fd=open(path.c_str(),O_RDONLY);
+      if(fd<0){GELIB_ERROR("Cannot open "+path); return;}
+      struct stat st;
+      if(fstat(fd,&st)<0){close(fd); GELIB_ERROR("Cannot stat "+path); return;}
+      mapsize=st.st_size;
+      map=mmap(nullptr,mapsize,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0);
+      close(fd);
+      if(map==MAP_FAILED){map=nullptr; GELIB_ERROR("Cannot map "+path); return;}
+
+      std::ifstream in(path,std::ios::binary);
+      SO3vecB_io_header h;
+      if(!h.read(in) || h.kind!=0) GELIB_ERROR("Cannot read "+path);
+      if(h.dtype!=SO3vecB_io_fp32) GELIB_ERROR("SO3vecB_mmap requires a float32 file; load "+path+" with load_SO3vecB instead.");
+      char* p=static_cast<char*>(map);
+      for(int l=0; l<(int)h.ls.size(); l++){
+	const int _l=h.ls[l];
+	const int _n=h.ns[l];
+	const int asize=h.b*(2*_l+1)*_n;
+	v.parts.push_back(new SO3partB(SO3partB::view_of(h.b,_l,_n,
+	      reinterpret_cast<float*>(p+h.offsets[l]),
+	      cnine::Gstrides({(2*_l+1)*_n,_n,1}),asize)));
+      }
+#else
+      GELIB_ERROR("SO3vecB_mmap requires a unix platform.");
+#endif
+    }
+
+    // v's own destructor deletes the view parts; only the mapping is
+    // released here.
+    ~SO3vecB_mmap(){
+#ifdef __unix__
+      if(map) munmap(map,mapsize);
+#endif
+    }
+
+    const SO3vecB& vec() const{
+      return v;
+    }
+
+  private:
+
+    void* map=nullptr;
+    size_t mapsize=0;
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,208 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3vecB_shardedArray
+#define _SO3vecB_shardedArray
+
+#include "GElib_base.hpp"
+#include "SO3vecB_array.hpp"
+#include "GElibThreadPool.hpp"
+
+
+namespace GElib{
+
+  // Data-parallel multi-device wrapper around SO3vecB_array. The cells
+  // are sharded along the leading array dimension into one contiguous
+  // chunk per CUDA device; cellwise operations such as the CG product
+  // then run shard-locally with no cross-device traffic, and gather()
+  // reassembles the full array on the host. Scatter and gather move
+  // each chunk with a single contiguous copy per part (real and
+  // imaginary halves separately), replacing the per-cell Python-side
+  // copies used previously.
+  //
+  // The shards are driven concurrently through GElibMultiLoop with the
+  // current CUDA device set per worker, so kernel launches on the
+  // different devices overlap.
+
+  class SO3vecB_shardedArray{
+  public:
+
+    vector<int> gpus;
+    vector<int> cell_offs;    // start cell of each shard; total cell count at the end
+    vector<SO3vecB_array*> shards;
+
+
+    SO3vecB_shardedArray(){}
+
+    ~SO3vecB_shardedArray(){
+      for(auto p:shards) delete p;
+    }
+
+    SO3vecB_shardedArray(const SO3vecB_shardedArray& x)=delete;
+    SO3vecB_shardedArray& operator=(const SO3vecB_shardedArray& x)=delete;
+
+    SO3vecB_shardedArray(SO3vecB_shardedArray&& x):
+      gpus(std::move(x.gpus)), cell_offs(std::move(x.cell_offs)), shards(std::move(x.shards)){
+      x.shards.clear();
+    }
+
+
+    // Scatter x from the host across the given devices.
+    SO3vecB_shardedArray(const SO3vecB_array& x, const vector<int>& _gpus):
+      gpus(_gpus){
+      GELIB_ASSRT(gpus.size()>0);
+      GELIB_ASSRT(x.get_dev()==0);
+
+      cnine::Gdims adims=x.get_adims();
+      const int N=adims(0);
+      const int nshards=gpus.size();
+      cell_offs.resize(nshards+1);
+      for(int i=0; i<=nshards; i++) cell_offs[i]=((long)N*i)/nshards;
+
+      const SO3type tau=x.get_tau();
+      for(int i=0; i<nshards; i++){
+	set_device(gpus[i]);
+	cnine::Gdims sdims(adims);
+	sdims[0]=cell_offs[i+1]-cell_offs[i];
+	SO3vecB_array* s=new SO3vecB_array(sdims,tau,cnine::fill_zero(),devflag(gpus[i]));
+	for(int l=0; l<(int)x.parts.size(); l++)
+	  copy_cells(*s->parts[l],0,*x.parts[l],cell_offs[i],cell_offs[i+1]-cell_offs[i]);
+	shards.push_back(s);
+      }
+    }
+
+
+  public: // ---- Access -------------------------------------------------------------------------------------
+
+
+    int nshards() const{
+      return shards.size();
+    }
+
+    SO3type get_tau() const{
+      GELIB_ASSRT(shards.size()>0);
+      return shards[0]->get_tau();
+    }
+
+
+  public: // ---- Operations ---------------------------------------------------------------------------------
+
+
+    SO3vecB_shardedArray CGproduct(const SO3vecB_shardedArray& y, const int maxl=-1) const{
+      GELIB_ASSRT(shards.size()==y.shards.size());
+      SO3vecB_shardedArray R;
+      R.gpus=gpus;
+      R.cell_offs=cell_offs;
+      R.shards.resize(shards.size(),nullptr);
+      const SO3type rtau=GElib::CGproduct(get_tau(),y.get_tau(),maxl);
+      GElibMultiLoop(shards.size(),[&](const int i){
+	  set_device(gpus[i]);
+	  SO3vecB_array* r=new SO3vecB_array(shards[i]->get_adims(),rtau,cnine::fill_zero(),shards[i]->get_dev());
+	  r->add_CGproduct(*shards[i],*y.shards[i]);
+	  R.shards[i]=r;
+	},1);
+      return R;
+    }
+
+    void add_CGproduct(const SO3vecB_shardedArray& x, const SO3vecB_shardedArray& y){
+      GELIB_ASSRT(shards.size()==x.shards.size());
+      GELIB_ASSRT(shards.size()==y.shards.size());
+      GElibMultiLoop(shards.size(),[&](const int i){
+	  set_device(gpus[i]);
+	  shards[i]->add_CGproduct(*x.shards[i],*y.shards[i]);
+	},1);
+    }
+
+
+    // Reassemble the full array on the host.
+    SO3vecB_array gather() const{
+      GELIB_ASSRT(shards.size()>0);
+      cnine::Gdims adims=shards[0]->get_adims();
+      adims[0]=cell_offs.back();
+      SO3vecB_array R(adims,get_tau(),cnine::fill_zero(),0);
+      for(int i=0; i<(int)shards.size(); i++){
+	set_device(gpus[i]);
+	for(int l=0; l<(int)R.parts.size(); l++)
+	  copy_cells(*R.parts[l],cell_offs[i],*shards[i]->parts[l],0,cell_offs[i+1]-cell_offs[i]);
+      }
+      return R;
+    }
+
+
+#ifdef WITH_FAKE_GRAD
+
+    // Data-parallel training replicates the weight vectors per device,
+    // so after backward each replica's WITH_FAKE_GRAD buffer holds a
+    // partial gradient. Sums the buffers across replicas and writes the
+    // total back into each, staging through the host. A communicator
+    // hook (e.g. an NCCL allreduce driven from the bindings) can be
+    // supplied to replace the host-staged default.
+    static void allreduce_grad(const vector<SO3vecB*>& replicas,
+      const std::function<void(const vector<SO3vecB*>&)>& hook=nullptr){
+      GELIB_ASSRT(replicas.size()>0);
+      if(hook){
+	hook(replicas);
+	return;
+      }
+      SO3vecB acc=replicas[0]->get_grad().to_device(0);
+      for(size_t i=1; i<replicas.size(); i++)
+	acc.add(replicas[i]->get_grad().to_device(0));
+      for(auto r:replicas){
+	SO3vecB* old=r->grad;
+	r->grad=new SO3vecB(acc.to_device(old? old->get_dev():0));
+	delete old;
+      }
+    }
+
+#endif
+
+
+  private: // ---- Transport ---------------------------------------------------------------------------------
+
+
+    static void set_device(const int gpu){
+#ifdef _WITH_CUDA
+      if(gpu>=0) CUDA_SAFE(cudaSetDevice(gpu));
+#endif
+    }
+
+    static int devflag(const int gpu){
+#ifdef _WITH_CUDA
+      return gpu>=0? 1:0;
+#else
+      return 0;
+#endif
+    }
+
+    // Copies ncells cells along the leading dimension, real and
+    // imaginary halves separately. Requires regular strides so that the
+    // chunk is contiguous.
+    static void copy_cells(SO3partB_array& dst, const int doff,
+      const SO3partB_array& src, const int soff, const int ncells){
+      const long n=((long)ncells)*src.strides[0];
+      GELIB_ASSRT(src.strides[0]==dst.strides[0]);
+#ifdef _WITH_CUDA
+      if(src.dev>0 || dst.dev>0){
+	CUDA_SAFE(cudaMemcpy(dst.arr+((long)doff)*dst.strides[0],src.arr+((long)soff)*src.strides[0],
+	    n*sizeof(float),cudaMemcpyDefault));
+	CUDA_SAFE(cudaMemcpy(dst.arr+dst.coffs+((long)doff)*dst.strides[0],src.arr+src.coffs+((long)soff)*src.strides[0],
+	    n*sizeof(float),cudaMemcpyDefault));
+	return;
+      }
+#endif
+      std::memcpy(dst.arr+((long)doff)*dst.strides[0],src.arr+((long)soff)*src.strides[0],n*sizeof(float));
+      std::memcpy(dst.arr+dst.coffs+((long)doff)*dst.strides[0],src.arr+src.coffs+((long)soff)*src.strides[0],n*sizeof(float));
+    }
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,132 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3vecB_stream
+#define _SO3vecB_stream
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+
+#include "SO3vecB_io.hpp"
+
+
+namespace GElib{
+
+  // Streams a sequence of SO3vecB_array record files (in the
+  // SO3vecB_io format) with background prefetch: a ring of reader
+  // threads loads up to `depth` records ahead of the consumer, so disk
+  // latency is hidden behind compute instead of stalling the first pass
+  // of every epoch. With pin=true (and CUDA) each loaded record's part
+  // buffers are page-locked before being handed out, so the subsequent
+  // host-to-device copies run asynchronously at full DMA bandwidth.
+  // Records are delivered strictly in file order.
+  class SO3vecB_arrayStream{
+  public:
+
+    // A loaded record; releasing the handle unpins the buffers.
+    struct Record{
+      SO3vecB_array v;
+      bool pinned=false;
+
+      Record(SO3vecB_array&& _v): v(std::move(_v)){}
+      Record(const Record&)=delete;
+
+      ~Record(){
+	#ifdef _WITH_CUDA
+	if(pinned)
+	  for(auto p:v.parts)
+	    cudaHostUnregister(p->arr);
+	#endif
+      }
+    };
+
+
+    SO3vecB_arrayStream(const vector<string>& _paths, const int nthreads=2, const int _depth=4, const bool _pin=false):
+      paths(_paths), depth(_depth), pin(_pin){
+      for(int i=0; i<nthreads; i++)
+	readers.push_back(std::thread([this](){read_loop();}));
+    }
+
+    SO3vecB_arrayStream(const SO3vecB_arrayStream&)=delete;
+    SO3vecB_arrayStream& operator=(const SO3vecB_arrayStream&)=delete;
+
+    ~SO3vecB_arrayStream(){
+      {
+	std::lock_guard<std::mutex> lock(mx);
+	stop=true;
+      }
+      cv.notify_all();
+      for(auto& t:readers) t.join();
+    }
+
+
+    // Returns the next record in file order, blocking until its reader
+    // has finished, or nullptr at the end of the sequence.
+    std::shared_ptr<Record> next(){
+      std::unique_lock<std::mutex> lock(mx);
+      if(head>=(int)paths.size()) return nullptr;
+      cv.wait(lock,[&](){return ready.find(head)!=ready.end();});
+      std::shared_ptr<Record> R=ready[head];
+      ready.erase(head);
+      head++;
+      cv.notify_all();
+      return R;
+    }
+
+
+  private:
+
+    void read_loop(){
+      while(true){
+	int i;
+	{
+	  std::unique_lock<std::mutex> lock(mx);
+	  cv.wait(lock,[&](){return stop || fetch_next<head+depth;});
+	  if(stop || fetch_next>=(int)paths.size()) return;
+	  i=fetch_next++;
+	}
+
+	auto R=std::make_shared<Record>(load_SO3vecB_array(paths[i]));
+	#ifdef _WITH_CUDA
+	if(pin){
+	  for(auto p:R->v.parts)
+	    CUDA_SAFE(cudaHostRegister(p->arr,2*p->dims.total()*sizeof(float),cudaHostRegisterDefault));
+	  R->pinned=true;
+	}
+	#endif
+
+	{
+	  std::lock_guard<std::mutex> lock(mx);
+	  ready[i]=R;
+	}
+	cv.notify_all();
+      }
+    }
+
+    vector<string> paths;
+    int depth;
+    bool pin;
+
+    std::mutex mx;
+    std::condition_variable cv;
+    std::map<int,std::shared_ptr<Record> > ready;
+    int head=0;
+    int fetch_next=0;
+    bool stop=false;
+
+    vector<std::thread> readers;
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,162 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3weightsOptimizer
+#define _SO3weightsOptimizer
+
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "GElib_base.hpp"
+#include "GElibThreadPool.hpp"
+#include "SO3weights.hpp"
+
+
+namespace GElib{
+
+  // One flat range of a fused optimizer step: pointers to the
+  // parameters, their gradient and the two moment buffers. Each complex
+  // plane of a weight tensor is one contiguous range of asize reals;
+  // the planes themselves may be padded apart, so they become separate
+  // items.
+  struct SO3adamItem{
+    float* w;
+    const float* g;
+    float* m;
+    float* v;
+    long n;
+  };
+
+  #ifdef _WITH_CUDA
+  void SO3weights_adam_cu(const std::vector<SO3adamItem>& items, const float a,
+    const float beta1, const float beta2, const float eps, const cudaStream_t& stream);
+  #endif
+
+
+  // Fused Adam for SO3weights. Driving the optimizer from Python means
+  // per-part tensor ops with separate passes for the first moment, the
+  // second moment and the parameter update -- O(passes x parts)
+  // traversals of the weights per step. Here the moment buffers are
+  // owned by the optimizer, carved contiguously across the pack, and
+  // one step makes a single pass: each element's moment updates and
+  // parameter step are computed together while it is in registers. On
+  // the host the pass is page-parallel; on the device it is one launch
+  // over an item table covering every part.
+
+  class SO3weightsAdam{
+  public:
+
+    float beta1;
+    float beta2;
+    float eps;
+    int t=0;
+    int dev=0;
+
+    size_t total=0;       // reals across both planes of all parts
+    vector<size_t> offs;  // start of each part within the moment buffers
+    float* m=nullptr;
+    float* v=nullptr;
+
+
+    SO3weightsAdam(const SO3weights& w, const float _beta1=0.9, const float _beta2=0.999, const float _eps=1e-8):
+      beta1(_beta1), beta2(_beta2), eps(_eps){
+      dev=w.tensors.size()>0? w.tensors[0]->get_dev() : 0;
+      offs.resize(w.tensors.size());
+      size_t s=0;
+      for(int i=0; i<(int)w.tensors.size(); i++){
+	offs[i]=s;
+	s+=2*((size_t)w.tensors[i]->dims.total());
+      }
+      total=s;
+      if(dev==0){
+	m=new float[total];
+	v=new float[total];
+	std::memset(m,0,total*sizeof(float));
+	std::memset(v,0,total*sizeof(float));
+      }
+#ifdef _WITH_CUDA
+      else{
+	CUDA_SAFE(cudaMalloc(&m,total*sizeof(float)));
+	CUDA_SAFE(cudaMalloc(&v,total*sizeof(float)));
+	CUDA_SAFE(cudaMemset(m,0,total*sizeof(float)));
+	CUDA_SAFE(cudaMemset(v,0,total*sizeof(float)));
+      }
+#endif
+    }
+
+    ~SO3weightsAdam(){
+      if(!m) return;
+      if(dev==0){
+	delete[] m;
+	delete[] v;
+      }
+#ifdef _WITH_CUDA
+      else{
+	cudaFree(m);
+	cudaFree(v);
+      }
+#endif
+    }
+
+    SO3weightsAdam(const SO3weightsAdam&)=delete;
+    SO3weightsAdam& operator=(const SO3weightsAdam&)=delete;
+
+
+  public: // ---- Stepping -----------------------------------------------------------------------------------
+
+
+    void step(SO3weights& w, const SO3weights& g, const float lr){
+      GELIB_ASSRT(w.tensors.size()==offs.size());
+      GELIB_ASSRT(g.tensors.size()==offs.size());
+      t++;
+      const float a=lr*std::sqrt(1.0f-std::pow(beta2,t))/(1.0f-std::pow(beta1,t));
+
+      std::vector<SO3adamItem> items;
+      for(int i=0; i<(int)w.tensors.size(); i++){
+	const long n=w.tensors[i]->dims.total();
+	GELIB_ASSRT(w.tensors[i]->get_dev()==dev && g.tensors[i]->get_dev()==dev);
+	GELIB_ASSRT(g.tensors[i]->dims.total()==n);
+	float* wp=(dev==0? w.tensors[i]->arr : w.tensors[i]->arrg);
+	const float* gp=(dev==0? g.tensors[i]->arr : g.tensors[i]->arrg);
+	items.push_back(SO3adamItem{wp,gp,m+offs[i],v+offs[i],n});
+	items.push_back(SO3adamItem{wp+w.tensors[i]->coffs,gp+g.tensors[i]->coffs,m+offs[i]+n,v+offs[i]+n,n});
+      }
+
+      if(dev>0){
+#ifdef _WITH_CUDA
+	CUDA_STREAM(SO3weights_adam_cu(items,a,beta1,beta2,eps,stream));
+#endif
+	return;
+      }
+
+      for(auto& it:items){
+	const long page_floats=4096/sizeof(float);
+	const long npages=(it.n+page_floats-1)/page_floats;
+	GElibMultiLoopStatic(npages,[&](const int p){
+	    const long beg=((long)p)*page_floats;
+	    const long end=std::min<long>(beg+page_floats,it.n);
+	    for(long j=beg; j<end; j++){
+	      const float gj=it.g[j];
+	      const float mj=beta1*it.m[j]+(1.0f-beta1)*gj;
+	      const float vj=beta2*it.v[j]+(1.0f-beta2)*gj*gj;
+	      it.m[j]=mj;
+	      it.v[j]=vj;
+	      it.w[j]-=a*mj/(std::sqrt(vj)+eps);
+	    }
+	  });
+      }
+    }
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,261 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3weights_io
+#define _SO3weights_io
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "SO3weights.hpp"
+#include "SO3vecB_io.hpp"
+
+
+namespace GElib{
+
+  // Native binary storage for SO3weights, so checkpointing does not go
+  // through Python serialization. The layout follows the GELIBVEC
+  // format: 8-byte magic "GELIBWTS", uint32 version (1), uint32 dtype
+  // (0 = planar complex float32), int32 ntensors, then for each tensor
+  // int32 ndims, ndims int32 dimensions and a uint64 payload offset
+  // from the start of the file. Payloads are 64-byte aligned and hold
+  // the real plane followed by the imaginary plane as raw floats.
+
+  inline size_t SO3weights_io_header_size(const vector<vector<int32_t> >& dims){
+    size_t s=8+4+4+4;
+    for(auto& d:dims) s+=4+4*d.size()+8;
+    return s;
+  }
+
+  inline size_t SO3weights_io_asize(const vector<int32_t>& dims){
+    size_t r=1;
+    for(auto d:dims) r*=d;
+    return r;
+  }
+
+  // Writes a complete weights file from per-tensor plane pointers; used
+  // both by the synchronous save() and by the checkpointer's background
+  // thread, which points it at the staging buffers.
+  inline void SO3weights_io_write(std::ofstream& out, const vector<vector<int32_t> >& dims,
+    const vector<const float*>& re, const vector<const float*>& im){
+
+    const int32_t nt=dims.size();
+    const uint32_t version=1;
+    const uint32_t dtype=0;
+    out.write("GELIBWTS",8);
+    out.write(reinterpret_cast<const char*>(&version),4);
+    out.write(reinterpret_cast<const char*>(&dtype),4);
+    out.write(reinterpret_cast<const char*>(&nt),4);
+
+    size_t offs=SO3vecB_io_round_up(SO3weights_io_header_size(dims));
+    for(int i=0; i<nt; i++){
+      const int32_t ndims=dims[i].size();
+      const uint64_t _o=offs;
+      out.write(reinterpret_cast<const char*>(&ndims),4);
+      out.write(reinterpret_cast<const char*>(dims[i].data()),4*ndims);
+      out.write(reinterpret_cast<const char*>(&_o),8);
+      offs=SO3vecB_io_round_up(offs+2*SO3weights_io_asize(dims[i])*sizeof(float));
+    }
+
+    size_t pos=SO3weights_io_header_size(dims);
+    for(int i=0; i<nt; i++){
+      SO3vecB_io_pad(out,pos,SO3vecB_io_round_up(pos));
+      const size_t asize=SO3weights_io_asize(dims[i]);
+      out.write(reinterpret_cast<const char*>(re[i]),asize*sizeof(float));
+      out.write(reinterpret_cast<const char*>(im[i]),asize*sizeof(float));
+      pos+=2*asize*sizeof(float);
+    }
+  }
+
+  inline void save(const SO3weights& w, const string& path){
+    GELIB_ASSRT(w.get_dev()==0);
+    std::ofstream out(path,std::ios::binary|std::ios::trunc);
+    if(!out.good()) return;
+    vector<vector<int32_t> > dims;
+    vector<const float*> re;
+    vector<const float*> im;
+    for(auto T:w.tensors){
+      vector<int32_t> d(T->dims.size());
+      for(int j=0; j<(int)d.size(); j++) d[j]=T->dims(j);
+      dims.push_back(d);
+      re.push_back(T->arr);
+      im.push_back(T->arr+T->coffs);
+    }
+    SO3weights_io_write(out,dims,re,im);
+  }
+
+
+  struct SO3weights_io_header{
+    uint32_t version;
+    uint32_t dtype;
+    vector<vector<int32_t> > dims;
+    vector<uint64_t> offsets;
+
+    bool read(std::istream& in){
+      char magic[8];
+      in.read(magic,8);
+      in.read(reinterpret_cast<char*>(&version),4);
+      in.read(reinterpret_cast<char*>(&dtype),4);
+      int32_t nt;
+      in.read(reinterpret_cast<char*>(&nt),4);
+      if(!in.good() || std::memcmp(magic,"GELIBWTS",8)!=0 || version!=1 || dtype!=0 || nt<0) return false;
+      for(int i=0; i<nt; i++){
+	int32_t ndims;
+	in.read(reinterpret_cast<char*>(&ndims),4);
+	if(!in.good() || ndims<0) return false;
+	vector<int32_t> d(ndims);
+	in.read(reinterpret_cast<char*>(d.data()),4*ndims);
+	uint64_t _o;
+	in.read(reinterpret_cast<char*>(&_o),8);
+	dims.push_back(d);
+	offsets.push_back(_o);
+      }
+      return in.good();
+    }
+  };
+
+  inline SO3weights load_SO3weights(const string& path){
+    std::ifstream in(path,std::ios::binary);
+    SO3weights_io_header h;
+    if(!in.good() || !h.read(in)) GELIB_ERROR("Cannot read "+path);
+    cnine::GdimsPack dpack;
+    for(auto& d:h.dims)
+      dpack.push_back(cnine::Gdims(vector<int>(d.begin(),d.end())));
+    SO3weights R(cnine::CtensorPackObj(dpack,cnine::fill_raw(),0,0));
+    for(int i=0; i<(int)h.dims.size(); i++){
+      auto& T=*R.tensors[i];
+      const size_t asize=SO3weights_io_asize(h.dims[i]);
+      in.seekg(h.offsets[i]);
+      in.read(reinterpret_cast<char*>(T.arr),asize*sizeof(float));
+      in.read(reinterpret_cast<char*>(T.arr+T.coffs),asize*sizeof(float));
+    }
+    return R;
+  }
+
+
+  // ---- Asynchronous checkpointing -------------------------------------------------------------------------
+
+
+  // Double-buffered background checkpointer: checkpoint() snapshots the
+  // weights into a host staging buffer and returns, so the training
+  // thread only pays for the memcpy, while a background thread writes
+  // the staged copy to disk. Two staging slots let a new snapshot be
+  // taken while the previous file is still being written; a third
+  // checkpoint arriving before either write has finished blocks. The
+  // staging buffers are reused across checkpoints, so steady-state
+  // operation allocates nothing.
+  class SO3weightsCheckpointer{
+  public:
+
+    SO3weightsCheckpointer(){
+      writer=std::thread([this](){write_loop();});
+    }
+
+    SO3weightsCheckpointer(const SO3weightsCheckpointer&)=delete;
+    SO3weightsCheckpointer& operator=(const SO3weightsCheckpointer&)=delete;
+
+    // Pending writes are flushed before shutdown.
+    ~SO3weightsCheckpointer(){
+      {
+	std::lock_guard<std::mutex> lock(mx);
+	stop=true;
+      }
+      cv.notify_all();
+      writer.join();
+    }
+
+
+    void checkpoint(const SO3weights& w, const string& path){
+      GELIB_ASSRT(w.get_dev()==0);
+      std::unique_lock<std::mutex> lock(mx);
+      cv.wait(lock,[&](){return !slots[0].pending || !slots[1].pending;});
+      Slot& s=slots[slots[0].pending? 1 : 0];
+
+      s.path=path;
+      const int nt=w.tensors.size();
+      s.dims.resize(nt);
+      s.planes.resize(nt);
+      for(int i=0; i<nt; i++){
+	auto& T=*w.tensors[i];
+	s.dims[i].resize(T.dims.size());
+	for(int j=0; j<(int)s.dims[i].size(); j++) s.dims[i][j]=T.dims(j);
+	const size_t asize=SO3weights_io_asize(s.dims[i]);
+	s.planes[i].resize(2*asize);
+	std::memcpy(s.planes[i].data(),T.arr,asize*sizeof(float));
+	std::memcpy(s.planes[i].data()+asize,T.arr+T.coffs,asize*sizeof(float));
+      }
+
+      s.pending=true;
+      cv.notify_all();
+    }
+
+    // Blocks until every staged checkpoint has been written out.
+    void wait(){
+      std::unique_lock<std::mutex> lock(mx);
+      cv.wait(lock,[&](){return !slots[0].pending && !slots[1].pending;});
+    }
+
+
+  private:
+
+    struct Slot{
+      bool pending=false;
+      string path;
+      vector<vector<int32_t> > dims;
+      vector<vector<float> > planes;
+    };
+
+    // A pending slot is owned by the writer thread, so its buffers are
+    // read outside the lock; only the pending flag needs it.
+    void write_loop(){
+      while(true){
+	int i;
+	{
+	  std::unique_lock<std::mutex> lock(mx);
+	  cv.wait(lock,[&](){return stop || slots[0].pending || slots[1].pending;});
+	  if(slots[0].pending) i=0;
+	  else if(slots[1].pending) i=1;
+	  else return;
+	}
+
+	Slot& s=slots[i];
+	std::ofstream out(s.path,std::ios::binary|std::ios::trunc);
+	if(out.good()){
+	  vector<const float*> re;
+	  vector<const float*> im;
+	  for(int t=0; t<(int)s.dims.size(); t++){
+	    re.push_back(s.planes[t].data());
+	    im.push_back(s.planes[t].data()+SO3weights_io_asize(s.dims[t]));
+	  }
+	  SO3weights_io_write(out,s.dims,re,im);
+	}
+
+	{
+	  std::lock_guard<std::mutex> lock(mx);
+	  s.pending=false;
+	}
+	cv.notify_all();
+      }
+    }
+
+    Slot slots[2];
+
+    std::mutex mx;
+    std::condition_variable cv;
+    bool stop=false;
+
+    std::thread writer;
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,100 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _WignerBank
+#define _WignerBank
+
+#include <map>
+#include <mutex>
+
+#include "CtensorB.hpp"
+#include "WignerMatrix.hpp"
+
+
+namespace GElib{
+
+  // Bank of Wigner D-matrices keyed by (l, rotation), in the mold of
+  // SO3_CGbank. Data augmentation applies the same rotation to
+  // thousands of parts, and rebuilding the matrix for each one --
+  // including its factorial and Jacobi polynomial evaluations --
+  // dominates the cost of the rotation itself. The Euler angles are
+  // quantized to 1e-6 radian steps to form the key, so rotations
+  // agreeing to within that tolerance (far below single precision at
+  // any realistic l) share one entry. Device copies are cached
+  // separately, as in SO3FourierMatrixBank.
+
+  class WignerBank{
+  private:
+
+    typedef cnine::CtensorB Ctensor;
+    typedef array<int,4> Windex;
+
+    static constexpr double resolution=1.0e-6;
+
+    mutex safety_mx;
+    mutex safety_mxC;
+
+    std::map<Windex,Ctensor*> matrices;
+    std::map<Windex,Ctensor*> matricesC;
+
+
+  public:
+
+    WignerBank(){}
+
+    WignerBank(const WignerBank& x)=delete;
+    WignerBank& operator=(const WignerBank& x)=delete;
+
+    ~WignerBank(){
+      for(auto p:matrices) delete p.second;
+      //for(auto p:matricesC) delete p.second; // trouble!
+    }
+
+
+  public:
+
+    const Ctensor& operator()(const int l, const SO3element& r, const int dev=0){
+      Windex ix({l,quantize(r.phi),quantize(r.theta),quantize(r.psi)});
+
+      if(dev==1){
+	lock_guard<mutex> lock(safety_mxC);
+	auto it=matricesC.find(ix);
+	if(it!=matricesC.end()) return *it->second;
+
+	Ctensor* D=new Ctensor((*this)(l,r,0),dev);
+	matricesC[ix]=D;
+	return *D;
+      }
+
+      lock_guard<mutex> lock(safety_mx);
+      auto it=matrices.find(ix);
+      if(it!=matrices.end()) return *it->second;
+
+      Ctensor* D=new Ctensor(WignerMatrix<float>(l,r));
+      matrices[ix]=D;
+      return *D;
+    }
+
+
+  private:
+
+    static int quantize(const double a){
+      return (int)std::lround(a/resolution);
+    }
+
+  };
+
+}
+
+
+extern GElib::WignerBank SO3_wignerBank;
+
+
+#endif
@@ -67,14 +67,16 @@ namespace GElib{
       }
 
       // check this!
+      const double a0=(logfact(l+m1)+logfact(l-m1)+logfact(l+m2)+logfact(l-m2))/2.0;
+      const double ch=cos(beta/2);
+      const double sh=sin(beta/2);
       for(int s=std::max(0,m1-m2); s<=std::min(l+m1,l-m2); s++){
-	double a=(lgamma(l+m1+1)+lgamma(l-m1+1)+lgamma(l+m2+1)+lgamma(l-m2+1))/2.0;
-	a-=lgamma(l+m1-s+1)+lgamma(s+1)+lgamma(m2-m1+s+1)+lgamma(l-m2-s+1);
+	double a=a0-(logfact(l+m1-s)+logfact(s)+logfact(m2-m1+s)+logfact(l-m2-s));
 	if(std::isnan(std::exp(a))) cout<<s<<" "<<l<<m1<<m2<<" "<<beta<<endl;
-	x+=(1-2*((m2-m1+s)%2))*std::pow(cos(beta/2),2*l+m1-m2-2*s)*std::pow(sin(beta/2),m2-m1+2*s)*std::exp(a);
+	x+=(1-2*((m2-m1+s)%2))*std::pow(ch,2*l+m1-m2-2*s)*std::pow(sh,m2-m1+2*s)*std::exp(a);
 	if(std::isnan(x)){
 	  cout<<l<<m1<<m2<<" "<<beta<<" ww "<<a<<" "<<std::exp(a)<<" "<<x<<" ";
-	  cout<<(2*(s%2)-1)*std::pow(cos(beta/2),2*l+m1-m2-2*s)*std::pow(sin(beta/2),m2-m1+2*s)<<endl;
+	  cout<<(2*(s%2)-1)*std::pow(ch,2*l+m1-m2-2*s)*std::pow(sh,m2-m1+2*s)<<endl;
 	}
       }
       if(std::isnan(x)) cout<<l<<m1<<m2<<" "<<beta<<endl;
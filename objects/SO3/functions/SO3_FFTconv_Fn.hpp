@@ -0,0 +1,137 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3_FFTconv_Fn
+#define _SO3_FFTconv_Fn
+
+#include "GElib_base.hpp"
+#include "CtensorB.hpp"
+#include "Ctensor4_view.hpp"
+#include "SO3FFTPlan.hpp"
+#include "SO3filterSpectrum.hpp"
+#include "SO3part_addFproduct_Fn.hpp"
+#include "GElibNvtx.hpp"
+
+
+namespace GElib{
+
+  // Fused spectral pipeline for functions sampled on an
+  // (Nphi,Ntheta,Npsi) grid over SO(3): forward transform of both
+  // operands, pointwise Fproduct in Fourier space, inverse transform
+  // of the result, accumulated into r.
+  //
+  // Run as three separate passes (add_FFT, add_Fproduct, add_iFFT_to)
+  // this materializes three full SO3vecB Fourier objects and allocates
+  // fresh transform workspaces for every part. Here the transforms run
+  // through a shared SO3FFTPlan, only the small per-l coefficient
+  // blocks of the operands are kept, and each output block is inverted
+  // back onto the grid and released as soon as its (l1,l2) sources are
+  // exhausted, so the full output Fourier object never exists and the
+  // grid tensors are traversed once per part instead of once per pass.
+
+  class SO3_FFTconv_Fn{
+  public:
+
+    typedef cnine::CtensorB Ctensor;
+
+    int maxl;
+    int conj=0;
+
+    SO3_FFTconv_Fn(const int _maxl): maxl(_maxl){}
+    SO3_FFTconv_Fn(const int _maxl, const int _conj): maxl(_maxl), conj(_conj){}
+
+  public:
+
+    void operator()(const cnine::Ctensor4_view& r, const cnine::Ctensor4_view& x, const cnine::Ctensor4_view& y){
+      GELIB_NVTX_RANGE("SO3_FFTconv");
+
+      const int b=x.n0;
+      const int Nphi=x.n1;
+      const int Ntheta=x.n2;
+      const int Npsi=x.n3;
+      const int dev=x.dev;
+
+      GELIB_ASSRT(y.n0==b && r.n0==b);
+      GELIB_ASSRT(y.n1==Nphi && y.n2==Ntheta && y.n3==Npsi);
+      GELIB_ASSRT(r.n1==Nphi && r.n2==Ntheta && r.n3==Npsi);
+      GELIB_ASSRT(y.dev==dev && r.dev==dev);
+
+      SO3FFTPlan& plan=SO3FFTplans(b,maxl,Nphi,Ntheta,Npsi,dev);
+
+      // Fourier blocks of the operands: one (2l+1) x (2l+1) matrix per
+      // l, small next to the grids and the plan workspaces.
+      vector<Ctensor*> Fx(maxl+1);
+      vector<Ctensor*> Fy(maxl+1);
+      for(int l=0; l<=maxl; l++){
+	Fx[l]=new Ctensor(Ctensor::zero(cnine::Gdims(b,2*l+1,2*l+1),dev));
+	Fy[l]=new Ctensor(Ctensor::zero(cnine::Gdims(b,2*l+1,2*l+1),dev));
+	plan.execute(Fx[l]->view3(),x);
+	plan.execute(Fy[l]->view3(),y);
+      }
+
+      // Each output block is completed, inverted onto the grid and
+      // released before the next one is started.
+      for(int l=0; l<=maxl; l++){
+	Ctensor Fr=Ctensor::zero(cnine::Gdims(b,2*l+1,2*l+1),dev);
+	for(int l1=0; l1<=maxl; l1++)
+	  for(int l2=std::abs(l-l1); l2<=std::min(maxl,l+l1); l2++)
+	    SO3part_addFproduct_Fn(conj)(Fr.view3(),Fx[l1]->view3(),Fy[l2]->view3());
+	plan.execute_inverse(r,Fr.view3());
+      }
+
+      for(auto p:Fx) delete p;
+      for(auto p:Fy) delete p;
+    }
+
+
+    // Fixed-filter variant: the y operand's spectrum is served from
+    // the filter's version-tagged cache (see SO3filterSpectrum), so
+    // only the forward transform of x and the inverse transform of r
+    // run per call -- one of the three transforms of the layer is
+    // removed in steady-state inference.
+    void operator()(const cnine::Ctensor4_view& r, const cnine::Ctensor4_view& x, SO3filterSpectrum& filter){
+      GELIB_NVTX_RANGE("SO3_FFTconv");
+
+      const int b=x.n0;
+      const int Nphi=x.n1;
+      const int Ntheta=x.n2;
+      const int Npsi=x.n3;
+      const int dev=x.dev;
+
+      GELIB_ASSRT(r.n0==b);
+      GELIB_ASSRT(r.n1==Nphi && r.n2==Ntheta && r.n3==Npsi);
+      GELIB_ASSRT(r.dev==dev);
+      GELIB_ASSRT(filter.maxl>=maxl);
+
+      SO3FFTPlan& plan=SO3FFTplans(b,maxl,Nphi,Ntheta,Npsi,dev);
+      const vector<Ctensor*>& Fy=filter.spectrum(plan);
+
+      vector<Ctensor*> Fx(maxl+1);
+      for(int l=0; l<=maxl; l++){
+	Fx[l]=new Ctensor(Ctensor::zero(cnine::Gdims(b,2*l+1,2*l+1),dev));
+	plan.execute(Fx[l]->view3(),x);
+      }
+
+      for(int l=0; l<=maxl; l++){
+	Ctensor Fr=Ctensor::zero(cnine::Gdims(b,2*l+1,2*l+1),dev);
+	for(int l1=0; l1<=maxl; l1++)
+	  for(int l2=std::abs(l-l1); l2<=std::min(maxl,l+l1); l2++)
+	    SO3part_addFproduct_Fn(conj)(Fr.view3(),Fx[l1]->view3(),Fy[l2]->view3());
+	plan.execute_inverse(r,Fr.view3());
+      }
+
+      for(auto p:Fx) delete p;
+    }
+
+  };
+
+}
+
+#endif
@@ -16,6 +16,9 @@
 #include "Ctensor4_view.hpp"
 #include "MultiLoop.hpp"
 #include "SO3FourierMatrixBank.hpp"
+#include "GElibOpStats.hpp"
+#include "GElibWorkspace.hpp"
+#include "GElibNvtx.hpp"
 
 extern GElib::SO3FourierMatrixBank SO3FourierMxBank;
 
@@ -28,8 +31,21 @@ namespace GElib{
 
     typedef cnine::CtensorB Ctensor;
 
+    // Optional caller-owned workspace for the two stage tensors; see
+    // GElibWorkspace for the protocol.
+    GElibWorkspace* workspace=nullptr;
+
+    SO3part_addFFT_Fn(GElibWorkspace* _workspace=nullptr): workspace(_workspace){}
+
+    // Float count of the temporaries for a (b,Nphi,Ntheta,Npsi) signal
+    // at bandwidth l, with L=2l+1.
+    static size_t workspace_size(const int b, const int L, const int Nphi, const int Ntheta){
+      return 2*(((size_t)b)*Nphi*Ntheta*L+((size_t)b)*L*Ntheta*L);
+    }
+
 
     void operator()(const cnine::Ctensor3_view& p, const cnine::Ctensor4_view& f){
+      GELIB_NVTX_RANGE("SO3_FFT");
       int dev=p.dev;
       assert(f.dev==dev);
 
@@ -41,19 +57,38 @@ namespace GElib{
       int Npsi=f.n3;
       int Ntheta=f.n2;
       int Nphi=f.n1;
-      SO3FourierMatrixBank& bank=SO3FourierMxBank;
 
-      //cout<<0<<endl;
-      Ctensor A=Ctensor::zero(cnine::Gdims(b,Nphi,Ntheta,L),dev);
-      A.view4().add_mix_3_0(f,bank.iFmatrix(l,Npsi,dev).view2());
-      //cout<<1<<endl;
+      gelib_op_stats.count(GElibOpStats::FFT,
+	((long)b)*Nphi*Ntheta*L*(Npsi+L+L),
+	8l*b*(Nphi*Ntheta*Npsi+L*L));
+
+      if(workspace){
+	GELIB_ASSRT(workspace->dev==dev);
+	workspace->reset();
+	const size_t asizeA=((size_t)b)*Nphi*Ntheta*L;
+	const size_t asizeB=((size_t)b)*L*Ntheta*L;
+	float* Aarr=workspace->take_zeroed(2*asizeA);
+	float* Barr=workspace->take_zeroed(2*asizeB);
+	cnine::Ctensor4_view Av(Aarr,Aarr+asizeA,b,Nphi,Ntheta,L,Nphi*Ntheta*L,Ntheta*L,L,1,dev);
+	cnine::Ctensor4_view Bv(Barr,Barr+asizeB,b,L,Ntheta,L,L*Ntheta*L,Ntheta*L,L,1,dev);
+	run(p,f,Av,Bv,l,Npsi,Nphi,Ntheta,dev);
+	return;
+      }
 
+      Ctensor A=Ctensor::zero(cnine::Gdims(b,Nphi,Ntheta,L),dev);
       Ctensor B=Ctensor::zero(cnine::Gdims(b,L,Ntheta,L),dev);
-      B.view4().add_mix_1_0(A.view4(),bank.iFmatrix(l,Nphi,dev).view2());
-      //cout<<2<<endl;
+      run(p,f,A.view4(),B.view4(),l,Npsi,Nphi,Ntheta,dev);
+    }
+
+
+  private:
 
-      B.view4().add_contract_abic_bic_abc_to(p,bank.Dmatrix(l,Ntheta,dev).view3());
-      //cout<<3<<endl;
+    void run(const cnine::Ctensor3_view& p, const cnine::Ctensor4_view& f,
+      const cnine::Ctensor4_view& A, const cnine::Ctensor4_view& B,
+      const int l, const int Npsi, const int Nphi, const int Ntheta, const int dev){
+      A.add_mix_3_0(f,SO3iFmatrix_cached(l,Npsi,dev).view2());
+      B.add_mix_1_0(A,SO3iFmatrix_cached(l,Nphi,dev).view2());
+      B.add_contract_abic_bic_abc_to(p,SO3Dmatrix_cached(l,Ntheta,dev).view3());
     }
 
   };
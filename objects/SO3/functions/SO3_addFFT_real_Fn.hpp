@@ -0,0 +1,120 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3_addFFT_real_Fn
+#define _SO3_addFFT_real_Fn
+
+#include "GElib_base.hpp"
+#include "CtensorB.hpp"
+#include "Rtensor4_view.hpp"
+#include "GElibThreadPool.hpp"
+#include "SO3FourierMatrixBank.hpp"
+#include "SO3Fpart2_view.hpp"
+#include "GElibNvtx.hpp"
+
+extern GElib::SO3FourierMatrixBank SO3FourierMxBank;
+
+
+namespace GElib{
+
+  // Forward SO(3) Fourier transform specialized to real-valued input
+  // signals. For real f the coefficients obey the conjugate symmetry
+  //
+  //   F(l,-m,-m') = (-1)^(m-m') conj(F(l,m,m')),
+  //
+  // so only the columns m'>=0 are independent; this Fn consumes the
+  // real sample grid directly (no complex promotion) and computes only
+  // that half, writing into a b x (2l+1) x (l+1) block whose column j
+  // holds m'=j. Compared to SO3part_addFFT_Fn this halves both the
+  // arithmetic and the stored coefficients. SO3Fpart_expand_real
+  // reconstitutes a full part for consumers that need it; the Fproduct
+  // family can instead run directly at half cost via its real_sym
+  // mode, since products of real functions are again real.
+
+  class SO3part_addFFT_real_Fn{
+  public:
+
+    void operator()(const cnine::Ctensor3_view& p, const cnine::Rtensor4_view& f){
+      GELIB_NVTX_RANGE("SO3_FFT_real");
+
+      const int b=f.n0;
+      const int Nphi=f.n1;
+      const int Ntheta=f.n2;
+      const int Npsi=f.n3;
+      const int L=p.n1;
+      const int l=(L-1)/2;
+
+      GELIB_ASSRT(p.n0==b);
+      GELIB_ASSRT(p.n2==l+1);
+      GELIB_ASSRT(p.dev==0 && f.dev==0);
+
+      SO3FourierMatrixBank& bank=SO3FourierMxBank;
+      const cnine::Ctensor2_view iFpsi=bank.iFmatrix(l,Npsi,0).view2();
+      const cnine::Ctensor2_view iFphi=bank.iFmatrix(l,Nphi,0).view2();
+      const cnine::Ctensor3_view D=bank.Dmatrix(l,Ntheta,0).view3();
+
+      GElibMultiLoop(b,[&](const int ib){
+
+	  // psi-transform, m'=0..l only (the m'<0 half is conjugate).
+	  vector<complex<float> > A(((size_t)Nphi)*Ntheta*(l+1));
+	  for(int i=0; i<Nphi; i++)
+	    for(int j=0; j<Ntheta; j++)
+	      for(int mp=0; mp<=l; mp++){
+		complex<float> t=0;
+		for(int k=0; k<Npsi; k++)
+		  t+=f(ib,i,j,k)*iFpsi(k,mp+l);
+		A[(i*Ntheta+j)*(l+1)+mp]=t;
+	      }
+
+	  // phi-transform over the full range of m.
+	  vector<complex<float> > B(((size_t)L)*Ntheta*(l+1));
+	  for(int m=0; m<L; m++)
+	    for(int j=0; j<Ntheta; j++)
+	      for(int mp=0; mp<=l; mp++){
+		complex<float> t=0;
+		for(int i=0; i<Nphi; i++)
+		  t+=A[(i*Ntheta+j)*(l+1)+mp]*iFphi(i,m);
+		B[(m*Ntheta+j)*(l+1)+mp]=t;
+	      }
+
+	  // theta-contraction against the Wigner-d tables.
+	  for(int m=0; m<L; m++)
+	    for(int mp=0; mp<=l; mp++){
+	      complex<float> t=0;
+	      for(int j=0; j<Ntheta; j++)
+		t+=B[(m*Ntheta+j)*(l+1)+mp]*D(m,j,mp+l);
+	      p.inc(ib,m,mp,t);
+	    }
+	});
+    }
+
+  };
+
+
+  // Reconstitutes a full (2l+1) x (2l+1) part from the non-redundant
+  // half produced by SO3part_addFFT_real_Fn, applying the conjugate
+  // symmetry for the m'<0 columns. h is indexed (m+l, m').
+  inline void SO3Fpart_expand_real(const SO3Fpart2_view& r, const cnine::Ctensor2_view& h){
+    const int l=r.getl();
+    SO3Fpart2_view& rr=const_cast<SO3Fpart2_view&>(r);
+    for(int m=-l; m<=l; m++)
+      for(int mp=0; mp<=l; mp++){
+	const complex<float> v=const_cast<cnine::Ctensor2_view&>(h)(m+l,mp);
+	rr.set(m,mp,v);
+	if(mp>0){
+	  const float s=1-2*(((m-mp)%2+2)%2);
+	  rr.set(-m,-mp,s*std::conj(v));
+	}
+      }
+  }
+
+}
+
+#endif
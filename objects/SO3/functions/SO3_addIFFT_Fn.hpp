@@ -16,6 +16,8 @@
 #include "Ctensor4_view.hpp"
 #include "MultiLoop.hpp"
 #include "SO3FourierMatrixBank.hpp"
+#include "GElibWorkspace.hpp"
+#include "GElibNvtx.hpp"
 
 extern GElib::SO3FourierMatrixBank SO3FourierMxBank;
 
@@ -28,8 +30,21 @@ namespace GElib{
 
     typedef cnine::CtensorB Ctensor;
 
+    // Optional caller-owned workspace for the two stage tensors; see
+    // GElibWorkspace for the protocol.
+    GElibWorkspace* workspace=nullptr;
+
+    SO3part_addIFFT_Fn(GElibWorkspace* _workspace=nullptr): workspace(_workspace){}
+
+    // Float count of the temporaries; same stage shapes as the forward
+    // transform, so the two directions can share one workspace.
+    static size_t workspace_size(const int b, const int L, const int Nphi, const int Ntheta){
+      return 2*(((size_t)b)*L*Ntheta*L+((size_t)b)*Nphi*Ntheta*L);
+    }
+
 
     void operator()(const cnine::Ctensor4_view& f, const cnine::Ctensor3_view& p){
+      GELIB_NVTX_RANGE("SO3_iFFT");
       int dev=p.dev;
       assert(f.dev==dev);
 
@@ -41,20 +56,34 @@ namespace GElib{
       int Npsi=f.n3;
       int Ntheta=f.n2;
       int Nphi=f.n1;
-      SO3FourierMatrixBank& bank=SO3FourierMxBank;
 
-      //cout<<0<<endl;
-      Ctensor A=Ctensor::zero(cnine::Gdims(b,L,Ntheta,L),dev);
-      A.view4().add_expand_2(p,bank.Dmatrix(l,Ntheta,dev).view3());
-      //cout<<1<<endl;
+      if(workspace){
+	GELIB_ASSRT(workspace->dev==dev);
+	workspace->reset();
+	const size_t asizeA=((size_t)b)*L*Ntheta*L;
+	const size_t asizeB=((size_t)b)*Nphi*Ntheta*L;
+	float* Aarr=workspace->take_zeroed(2*asizeA);
+	float* Barr=workspace->take_zeroed(2*asizeB);
+	cnine::Ctensor4_view Av(Aarr,Aarr+asizeA,b,L,Ntheta,L,L*Ntheta*L,Ntheta*L,L,1,dev);
+	cnine::Ctensor4_view Bv(Barr,Barr+asizeB,b,Nphi,Ntheta,L,Nphi*Ntheta*L,Ntheta*L,L,1,dev);
+	run(f,p,Av,Bv,l,Npsi,Nphi,Ntheta,dev);
+	return;
+      }
 
+      Ctensor A=Ctensor::zero(cnine::Gdims(b,L,Ntheta,L),dev);
       Ctensor B=Ctensor::zero(cnine::Gdims(b,Nphi,Ntheta,L),dev);
-      B.view4().add_mix_1_0(A.view4(),bank.Fmatrix(l,Nphi,dev).view2());
-      //cout<<2<<endl;
+      run(f,p,A.view4(),B.view4(),l,Npsi,Nphi,Ntheta,dev);
+    }
+
 
-      f.add_mix_3_0(B.view4(),bank.Fmatrix(l,Npsi,dev).view2());
-      //cout<<3<<endl;
+  private:
 
+    void run(const cnine::Ctensor4_view& f, const cnine::Ctensor3_view& p,
+      const cnine::Ctensor4_view& A, const cnine::Ctensor4_view& B,
+      const int l, const int Npsi, const int Nphi, const int Ntheta, const int dev){
+      A.add_expand_2(p,SO3Dmatrix_cached(l,Ntheta,dev).view3());
+      B.add_mix_1_0(A,SO3Fmatrix_cached(l,Nphi,dev).view2());
+      f.add_mix_3_0(B,SO3Fmatrix_cached(l,Npsi,dev).view2());
     }
 
   };
@@ -0,0 +1,129 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3mvec_addMprodFn
+#define _SO3mvec_addMprodFn
+
+#include "GElib_base.hpp"
+#include "Ctensor3_view.hpp"
+#include "GElibThreadPool.hpp"
+
+#if defined(_WITH_CUDA) && defined(_WITH_CUBLAS)
+#include <cublas_v2.h>
+#include "GElibNvtx.hpp"
+#endif
+
+
+namespace GElib{
+
+  // Applies the per-m weight matrices of one part of an SO3mweights
+  // pack: r_{t} += x_{t} w_{t%k} for every fused (batch,m) row t, where
+  // x_{t} is the (2l+1) x n_in slice of the operand and w_{d} the
+  // n_in x n_out matrix of m-slot d. Naively this is one small GEMM per
+  // (sample,m) pair; here the weight pointer only varies with the m
+  // slot, so on the device each slot becomes one strided-batched SGEMM
+  // over the whole sample dimension (times the four real plane combos),
+  // and on the host the rows are one grouped sweep over the thread
+  // pool.
+
+  class SO3mvec_addMprodFn{
+  public:
+
+    void operator()(const cnine::Ctensor3_view& r, const cnine::Ctensor3_view& x,
+      const cnine::Ctensor3_view& w, const int k){
+
+      const int N=x.n0;
+      const int L=x.n1;
+      const int nin=x.n2;
+      const int nout=r.n2;
+
+      GELIB_ASSRT(N%k==0);
+      GELIB_ASSRT(r.n0==N && r.n1==L);
+      GELIB_ASSRT(w.n0==k && w.n1==nin && w.n2==nout);
+      GELIB_ASSRT(r.dev==x.dev && w.dev==x.dev);
+
+#if defined(_WITH_CUDA) && defined(_WITH_CUBLAS)
+      if(r.dev>0){
+	cublas(r,x,w,k,N/k,L,nin,nout);
+	return;
+      }
+#endif
+
+      GElibMultiLoop(N,[&](const int t){
+	  const int d=t%k;
+	  const float* xr=x.arr+t*x.s0;
+	  const float* xi=x.arrc+t*x.s0;
+	  const float* wr=w.arr+d*w.s0;
+	  const float* wi=w.arrc+d*w.s0;
+	  float* rr=r.arr+t*r.s0;
+	  float* ri=r.arrc+t*r.s0;
+	  for(int m=0; m<L; m++)
+	    for(int c=0; c<nout; c++){
+	      float sr=0;
+	      float si=0;
+	      for(int i=0; i<nin; i++){
+		const float ar=xr[m*x.s1+i*x.s2];
+		const float ai=xi[m*x.s1+i*x.s2];
+		const float br=wr[i*w.s1+c*w.s2];
+		const float bi=wi[i*w.s1+c*w.s2];
+		sr+=ar*br-ai*bi;
+		si+=ar*bi+ai*br;
+	      }
+	      rr[m*r.s1+c*r.s2]+=sr;
+	      ri[m*r.s1+c*r.s2]+=si;
+	    }
+	});
+    }
+
+
+  private: // ---- cuBLAS backend ----------------------------------------------------------------------------
+
+
+#if defined(_WITH_CUDA) && defined(_WITH_CUBLAS)
+
+    // Row-major r_t=x_t w_d is column-major r_t^T=w_d^T x_t^T, which is
+    // what the buffers already hold when read with their row strides as
+    // leading dimensions. The batch runs over the samples of one m
+    // slot, whose slices sit k rows apart in the fused view.
+    void cublas(const cnine::Ctensor3_view& r, const cnine::Ctensor3_view& x, const cnine::Ctensor3_view& w,
+      const int k, const int B, const int L, const int nin, const int nout){
+      GELIB_NVTX_RANGE("SO3mvec_mprod");
+
+      GELIB_ASSRT(x.s2==1 && r.s2==1 && w.s2==1);
+
+      static cublasHandle_t handle=[](){cublasHandle_t h; cublasCreate(&h); return h;}();
+      const float one=1.0;
+      const float mone=-1.0;
+
+      for(int d=0; d<k; d++){
+	auto gemm=[&](const float* A, const float* W, float* C, const float* alpha){
+	  GELIB_ASSRT(cublasSgemmStridedBatched(handle,CUBLAS_OP_N,CUBLAS_OP_N,nout,L,nin,
+	      alpha,W,w.s1,0,A+d*x.s0,x.s1,(long long)k*x.s0,&one,C+d*r.s0,r.s1,(long long)k*r.s0,B)
+	    ==CUBLAS_STATUS_SUCCESS);
+	};
+
+	const float* Wd=w.arr+d*w.s0;
+	const float* Wdc=w.arrc+d*w.s0;
+
+	// re(r) += re(x) re(w) - im(x) im(w); im(r) += re(x) im(w) + im(x) re(w)
+	gemm(x.arr,Wd,r.arr,&one);
+	gemm(x.arrc,Wdc,r.arr,&mone);
+	gemm(x.arr,Wdc,r.arrc,&one);
+	gemm(x.arrc,Wd,r.arrc,&one);
+      }
+    }
+
+#endif
+
+  };
+
+}
+
+#endif
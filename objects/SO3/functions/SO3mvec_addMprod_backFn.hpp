@@ -0,0 +1,222 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3mvec_addMprod_backFn
+#define _SO3mvec_addMprod_backFn
+
+#include "GElib_base.hpp"
+#include "Ctensor3_view.hpp"
+#include "GElibThreadPool.hpp"
+
+#if defined(_WITH_CUDA) && defined(_WITH_CUBLAS)
+#include <cublas_v2.h>
+#include "GElibNvtx.hpp"
+#endif
+
+
+namespace GElib{
+
+  // Backward of the per-m weight application (see SO3mvec_addMprodFn),
+  // grouped the same way as the forward: xg_{t} += g_{t} w_{t%k}^H with
+  // one strided-batched SGEMM per m slot on the device and one grouped
+  // sweep over the fused rows on the host.
+
+  class SO3mvec_addMprod_back0Fn{
+  public:
+
+    void operator()(const cnine::Ctensor3_view& xg, const cnine::Ctensor3_view& g,
+      const cnine::Ctensor3_view& w, const int k){
+
+      const int N=xg.n0;
+      const int L=xg.n1;
+      const int nin=xg.n2;
+      const int nout=g.n2;
+
+      GELIB_ASSRT(N%k==0);
+      GELIB_ASSRT(g.n0==N && g.n1==L);
+      GELIB_ASSRT(w.n0==k && w.n1==nin && w.n2==nout);
+      GELIB_ASSRT(xg.dev==g.dev && w.dev==g.dev);
+
+#if defined(_WITH_CUDA) && defined(_WITH_CUBLAS)
+      if(g.dev>0){
+	cublas(xg,g,w,k,N/k,L,nin,nout);
+	return;
+      }
+#endif
+
+      GElibMultiLoop(N,[&](const int t){
+	  const int d=t%k;
+	  const float* gr=g.arr+t*g.s0;
+	  const float* gi=g.arrc+t*g.s0;
+	  const float* wr=w.arr+d*w.s0;
+	  const float* wi=w.arrc+d*w.s0;
+	  float* xr=xg.arr+t*xg.s0;
+	  float* xi=xg.arrc+t*xg.s0;
+	  for(int m=0; m<L; m++)
+	    for(int i=0; i<nin; i++){
+	      float sr=0;
+	      float si=0;
+	      for(int c=0; c<nout; c++){
+		const float ar=gr[m*g.s1+c*g.s2];
+		const float ai=gi[m*g.s1+c*g.s2];
+		const float br=wr[i*w.s1+c*w.s2];
+		const float bi=wi[i*w.s1+c*w.s2];
+		sr+=ar*br+ai*bi;
+		si+=ai*br-ar*bi;
+	      }
+	      xr[m*xg.s1+i*xg.s2]+=sr;
+	      xi[m*xg.s1+i*xg.s2]+=si;
+	    }
+	});
+    }
+
+
+  private: // ---- cuBLAS backend ----------------------------------------------------------------------------
+
+
+#if defined(_WITH_CUDA) && defined(_WITH_CUBLAS)
+
+    // Row-major xg_t=g_t w_d^H is column-major xg_t^T=conj(w_d) g_t^T;
+    // the conjugation is carried by the signs of the four real plane
+    // products, so only the transposition of the weight view appears in
+    // the call.
+    void cublas(const cnine::Ctensor3_view& xg, const cnine::Ctensor3_view& g, const cnine::Ctensor3_view& w,
+      const int k, const int B, const int L, const int nin, const int nout){
+      GELIB_NVTX_RANGE("SO3mvec_mprod_back0");
+
+      GELIB_ASSRT(g.s2==1 && xg.s2==1 && w.s2==1);
+
+      static cublasHandle_t handle=[](){cublasHandle_t h; cublasCreate(&h); return h;}();
+      const float one=1.0;
+      const float mone=-1.0;
+
+      for(int d=0; d<k; d++){
+	auto gemm=[&](const float* W, const float* G, float* C, const float* alpha){
+	  GELIB_ASSRT(cublasSgemmStridedBatched(handle,CUBLAS_OP_T,CUBLAS_OP_N,nin,L,nout,
+	      alpha,W,w.s1,0,G+d*g.s0,g.s1,(long long)k*g.s0,&one,C+d*xg.s0,xg.s1,(long long)k*xg.s0,B)
+	    ==CUBLAS_STATUS_SUCCESS);
+	};
+
+	const float* Wd=w.arr+d*w.s0;
+	const float* Wdc=w.arrc+d*w.s0;
+
+	// re(xg) += re(g) re(w)^T + im(g) im(w)^T; im(xg) += im(g) re(w)^T - re(g) im(w)^T
+	gemm(Wd,g.arr,xg.arr,&one);
+	gemm(Wdc,g.arrc,xg.arr,&one);
+	gemm(Wd,g.arrc,xg.arrc,&one);
+	gemm(Wdc,g.arr,xg.arrc,&mone);
+      }
+    }
+
+#endif
+
+  };
+
+
+  // Weight gradient of the per-m application: wg_{d} += sum_a x_t^H g_t
+  // over the samples of each m slot. The slots write disjoint weight
+  // fragments, so on the host they are one grouped parallel loop; on
+  // the device each sample contributes one strided-batched SGEMM over
+  // all k slots, accumulated in order on the stream.
+
+  class SO3mvec_addMprod_back1Fn{
+  public:
+
+    void operator()(const cnine::Ctensor3_view& wg, const cnine::Ctensor3_view& g,
+      const cnine::Ctensor3_view& x, const int k){
+
+      const int N=x.n0;
+      const int L=x.n1;
+      const int nin=x.n2;
+      const int nout=g.n2;
+
+      GELIB_ASSRT(N%k==0);
+      GELIB_ASSRT(g.n0==N && g.n1==L);
+      GELIB_ASSRT(wg.n0==k && wg.n1==nin && wg.n2==nout);
+      GELIB_ASSRT(wg.dev==g.dev && x.dev==g.dev);
+
+#if defined(_WITH_CUDA) && defined(_WITH_CUBLAS)
+      if(g.dev>0){
+	cublas(wg,g,x,k,N/k,L,nin,nout);
+	return;
+      }
+#endif
+
+      GElibMultiLoop(k,[&](const int d){
+	  float* wr=wg.arr+d*wg.s0;
+	  float* wi=wg.arrc+d*wg.s0;
+	  for(int a=0; a<N/k; a++){
+	    const int t=a*k+d;
+	    const float* xr=x.arr+t*x.s0;
+	    const float* xi=x.arrc+t*x.s0;
+	    const float* gr=g.arr+t*g.s0;
+	    const float* gi=g.arrc+t*g.s0;
+	    for(int i=0; i<nin; i++)
+	      for(int c=0; c<nout; c++){
+		float sr=0;
+		float si=0;
+		for(int m=0; m<L; m++){
+		  const float ar=xr[m*x.s1+i*x.s2];
+		  const float ai=xi[m*x.s1+i*x.s2];
+		  const float br=gr[m*g.s1+c*g.s2];
+		  const float bi=gi[m*g.s1+c*g.s2];
+		  sr+=ar*br+ai*bi;
+		  si+=ar*bi-ai*br;
+		}
+		wr[i*wg.s1+c*wg.s2]+=sr;
+		wi[i*wg.s1+c*wg.s2]+=si;
+	      }
+	  }
+	});
+    }
+
+
+  private: // ---- cuBLAS backend ----------------------------------------------------------------------------
+
+
+#if defined(_WITH_CUDA) && defined(_WITH_CUBLAS)
+
+    // Row-major wg_d=x_t^H g_t is column-major wg_d^T=g_t^T conj(x_t).
+    // Here the batch runs over the k slots of one sample, whose weight
+    // fragments sit wg.s0 apart; samples accumulate in order since the
+    // launches share the stream.
+    void cublas(const cnine::Ctensor3_view& wg, const cnine::Ctensor3_view& g, const cnine::Ctensor3_view& x,
+      const int k, const int B, const int L, const int nin, const int nout){
+      GELIB_NVTX_RANGE("SO3mvec_mprod_back1");
+
+      GELIB_ASSRT(g.s2==1 && x.s2==1 && wg.s2==1);
+
+      static cublasHandle_t handle=[](){cublasHandle_t h; cublasCreate(&h); return h;}();
+      const float one=1.0;
+      const float mone=-1.0;
+
+      for(int a=0; a<B; a++){
+	const int t=a*k;
+	auto gemm=[&](const float* G, const float* X, float* C, const float* alpha){
+	  GELIB_ASSRT(cublasSgemmStridedBatched(handle,CUBLAS_OP_N,CUBLAS_OP_T,nout,nin,L,
+	      alpha,G+t*g.s0,g.s1,g.s0,X+t*x.s0,x.s1,x.s0,&one,C,wg.s1,wg.s0,k)
+	    ==CUBLAS_STATUS_SUCCESS);
+	};
+
+	// re(wg) += re(x)^T re(g) + im(x)^T im(g); im(wg) += re(x)^T im(g) - im(x)^T re(g)
+	gemm(g.arr,x.arr,wg.arr,&one);
+	gemm(g.arrc,x.arrc,wg.arr,&one);
+	gemm(g.arrc,x.arr,wg.arrc,&one);
+	gemm(g.arr,x.arrc,wg.arrc,&mone);
+      }
+    }
+
+#endif
+
+  };
+
+}
+
+#endif
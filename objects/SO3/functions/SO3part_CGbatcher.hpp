@@ -0,0 +1,172 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3part_CGbatcher
+#define _SO3part_CGbatcher
+
+#include <array>
+
+#include "GElib_base.hpp"
+#include "GElibConfig.hpp"
+#include "GElibCudaGraphs.hpp"
+#include "GElibThreadPool.hpp"
+#include "SO3part3_view.hpp"
+#include "SO3_CGbank.hpp"
+#include "SO3part_addCGproduct_simd.hpp"
+#include "SO3vec_addCGproduct_persistentFn.hpp"
+
+extern GElib::GElibConfig* gelib_config;
+extern GElib::SO3_CGbank SO3_cgbank;
+
+
+namespace GElib{
+
+#ifdef _WITH_CUDA
+  void SO3partB_addCGproduct_cu(cnine::Ctensor3_view r, const cnine::Ctensor3_view& x, const cnine::Ctensor3_view& y,
+    const int offs, const cudaStream_t& stream);
+#endif
+
+
+  // Megabatching layer for part-level CG products. Workloads such as
+  // small-molecule inference issue thousands of products individually
+  // too small to fill the GPU or even one core's vector units, so the
+  // per-launch and per-loop overheads dominate. Within an
+  // SO3partCGbatchScope the part-level Fn only records each op; at
+  // scope exit the collected ops are grouped by shape
+  // (l1,l2,l,B,N1,N2,dev) and executed together: device groups within
+  // the persistent kernel's l range become work items of its
+  // pointer-array queue and go out in a single launch across all
+  // groups, larger device groups fan out over the stream pool, and
+  // host groups run as one parallel loop over all collected
+  // (task,batch) slices instead of one tiny loop per op. Operand
+  // buffers must stay alive until the scope closes; overwrite-mode ops
+  // bypass the batcher.
+
+  class SO3partCGbatcher{
+  public:
+
+    struct task{
+      SO3part3_view r;
+      SO3part3_view x;
+      SO3part3_view y;
+      int offs;
+    };
+
+    typedef std::array<int,7> key;
+
+    map<key,vector<task> > groups;
+
+    void submit(const SO3part3_view& r, const SO3part3_view& x, const SO3part3_view& y, const int offs){
+      groups[key({x.getl(),y.getl(),r.getl(),x.n0,x.n2,y.n2,r.dev})].push_back(task{r,x,y,offs});
+    }
+
+    void flush(){
+#ifdef _WITH_CUDA
+      vector<SO3CGworkItem> items;
+#endif
+      for(auto& g:groups){
+	const key& k=g.first;
+	vector<task>& tasks=g.second;
+	const int l1=k[0], l2=k[1], l=k[2], B=k[3], N1=k[4], N2=k[5], dev=k[6];
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+
+	if(dev==0){
+	  const int T=tasks.size();
+	  GElibMultiLoop(T*B,[&](const int i){
+	      task& t=tasks[i/B];
+	      const int b=i%B;
+	      SO3part2_view r=t.r.slice0(b);
+	      SO3part2_view x=t.x.slice0(b);
+	      SO3part2_view y=t.y.slice0(b);
+	      if(SO3part_addCGproduct_simd(r,x,y,C,t.offs)) return;
+	      int offs=t.offs;
+	      for(int n1=0; n1<N1; n1++){
+		for(auto& e:C.nonzeros){
+		  const complex<float> u=e.c*x(e.m1-l1,n1);
+		  for(int n2=0; n2<N2; n2++)
+		    r.inc(e.m-l,offs+n2,u*y(e.m2-l2,n2));
+		}
+		offs+=N2;
+	      }
+	    });
+	  continue;
+	}
+
+#ifdef _WITH_CUDA
+	if(l1<=SO3vec_addCGproduct_persistentFn::maxl && l2<=SO3vec_addCGproduct_persistentFn::maxl &&
+	  l<=SO3vec_addCGproduct_persistentFn::maxl){
+	  const int32_t* dix;
+	  const float* dc;
+	  SO3vecB_persistent_cgtable(l1,l2,l,C.packed_ix.data(),C.packed_c.data(),C.packed_ix.size(),&dix,&dc);
+	  for(auto& t:tasks){
+	    SO3CGworkItem w;
+	    w.rarr=t.r.arr; w.rarrc=t.r.arrc;
+	    w.xarr=t.x.arr; w.xarrc=t.x.arrc;
+	    w.yarr=t.y.arr; w.yarrc=t.y.arrc;
+	    w.b0=0; w.nb=B;
+	    w.l1=l1; w.l2=l2; w.l=l;
+	    w.N1=N1; w.N2=N2;
+	    w.rs0=t.r.s0; w.rs1=t.r.s1; w.rs2=t.r.s2;
+	    w.xs0=t.x.s0; w.xs1=t.x.s1; w.xs2=t.x.s2;
+	    w.ys0=t.y.s0; w.ys1=t.y.s1; w.ys2=t.y.s2;
+	    w.offs=t.offs;
+	    w.nzix=dix; w.nzc=dc; w.nnz=C.packed_ix.size();
+	    items.push_back(w);
+	  }
+	  continue;
+	}
+
+	// Beyond the persistent kernel's l range the group still avoids
+	// serialization by fanning out over the stream pool.
+	const int nstreams=gelib_config? gelib_config->cuda_nstreams : 1;
+	int si=0;
+	for(auto& t:tasks)
+	  SO3partB_addCGproduct_cu(t.r,t.x,t.y,t.offs,gelib_cuda_streams.get(si++,nstreams));
+	gelib_cuda_streams.sync(nstreams);
+#endif
+      }
+
+#ifdef _WITH_CUDA
+      if(items.size()>0)
+	GELIB_CUDA_STREAM(SO3vecB_addCGproduct_persistent_cu(items,stream));
+#endif
+      groups.clear();
+    }
+
+  };
+
+
+  inline thread_local SO3partCGbatcher* gelib_cg_batcher=nullptr;
+
+
+  // Scoped activation: part-level CG products submitted on this thread
+  // while the scope is alive are collected and executed together when
+  // it closes. Scopes nest; each flushes only its own ops.
+  class SO3partCGbatchScope{
+  public:
+
+    SO3partCGbatcher batcher;
+    SO3partCGbatcher* prev;
+
+    SO3partCGbatchScope(){
+      prev=gelib_cg_batcher;
+      gelib_cg_batcher=&batcher;
+    }
+
+    ~SO3partCGbatchScope(){
+      gelib_cg_batcher=prev;
+      batcher.flush();
+    }
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,94 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3part_addBispectrumFn
+#define _SO3part_addBispectrumFn
+
+#include "GElib_base.hpp"
+#include "CtensorB.hpp"
+#include "SO3part2_view.hpp"
+#include "SO3part3_view.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibNvtx.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+
+
+namespace GElib{
+
+  // Fused bispectrum-style triple contraction: accumulates the
+  // invariant table
+  //
+  //   r(b,n1*N2+n2,n3) += sum_m [sum_{m1+m2=m} C^{l1,l2,l}_{m1,m2,m}
+  //                        x(m1,n1) y(m2,n2)] conj(z(m,n3))
+  //
+  // directly from the three operands. The materialized route first
+  // builds the full (2l+1) x N1*N2 CG product -- the largest tensor in
+  // the computation, existing only to be contracted against z -- and
+  // then reduces it away; here the only intermediate is one
+  // (2l+1)-vector per (n1,n2) pair, which stays in registers/L1, so
+  // the memory traffic drops to the operands plus the (much smaller)
+  // invariant output. The bracketed sum is rotation-covariant and the
+  // m-contraction against conj(z) makes each entry of r an invariant;
+  // with z drawn from the same vec as x and y this is the bispectrum.
+
+  class SO3part_addBispectrumFn{
+  public:
+
+    void operator()(const cnine::Ctensor3_view& _r, const SO3part3_view& _x,
+      const SO3part3_view& _y, const SO3part3_view& _z){
+      GELIB_NVTX_RANGE("Bispectrum",_x.getl(),_y.getl(),_z.getl(),_x.n0);
+
+      const int l=_z.getl();
+      const int l1=_x.getl();
+      const int l2=_y.getl();
+
+      const int N1=_x.n2;
+      const int N2=_y.n2;
+      const int N3=_z.n2;
+      const int B=_x.n0;
+      const int dev=_r.dev;
+
+      CNINE_CHECK_DEV3(_x,_y,_z);
+      GELIB_CHECK(dev==0,"SO3part_addBispectrumFn is CPU only");
+      GELIB_ASSRT(_r.n0==B && _z.n0==B && _y.n0==B);
+      GELIB_ASSRT(_r.n1==N1*N2 && _r.n2==N3);
+      GELIB_ASSRT(l>=abs(l1-l2) && l<=l1+l2);
+
+      auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+
+      GElibMultiLoop(B,[&](const int b){
+	  cnine::Ctensor2_view r=_r.slice0(b);
+	  SO3part2_view x=_x.slice0(b);
+	  SO3part2_view y=_y.slice0(b);
+	  SO3part2_view z=_z.slice0(b);
+
+	  vector<complex<float> > p(2*l+1);
+	  for(int n1=0; n1<N1; n1++){
+	    for(int n2=0; n2<N2; n2++){
+	      std::fill(p.begin(),p.end(),complex<float>(0));
+	      for(auto& e:C.nonzeros)
+		p[e.m]+=e.c*x(e.m1-l1,n1)*y(e.m2-l2,n2);
+	      for(int n3=0; n3<N3; n3++){
+		complex<float> s=0;
+		for(int m=-l; m<=l; m++)
+		  s+=p[m+l]*std::conj(z(m,n3));
+		r.inc(n1*N2+n2,n3,s);
+	      }
+	    }
+	  }
+	});
+    }
+
+  };
+
+}
+
+#endif
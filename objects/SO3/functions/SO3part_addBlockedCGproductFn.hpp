@@ -15,9 +15,13 @@
 #include "CtensorB.hpp"
 #include "SO3part3_view.hpp"
 #include "SO3part4_view.hpp"
-#include "MultiLoop.hpp"
+#include "GElibThreadPool.hpp"
 #include "GElibTimer.hpp"
+#include "GElibConfig.hpp"
+#include "GElibOpStats.hpp"
+#include "GElibNvtx.hpp"
 
+extern GElib::GElibConfig* gelib_config;
 extern GElib::SO3_CGbank SO3_cgbank;
 extern GElib::SO3_SPHgen SO3_sphGen;
 
@@ -25,8 +29,10 @@ extern GElib::SO3_SPHgen SO3_sphGen;
 namespace GElib{
 
   #ifdef _WITH_CUDA
-  void SO3partB_addDiagCGproduct_cu(cnine::Ctensor3_view r, const cnine::Ctensor3_view& x, const cnine::Ctensor3_view& y, 
+  void SO3partB_addDiagCGproduct_cu(cnine::Ctensor3_view r, const cnine::Ctensor3_view& x, const cnine::Ctensor3_view& y,
     const int offs, const cudaStream_t& stream);
+  void SO3partB_addBlockedCGproduct_cu(cnine::Ctensor3_view r, const cnine::Ctensor3_view& x, const cnine::Ctensor3_view& y,
+    const int bsize, const int offs, const cudaStream_t& stream);
   #endif
 
 
@@ -34,6 +40,7 @@ namespace GElib{
   public:
 
     void operator()(const SO3part3_view& _r, const SO3part3_view& _x, const SO3part3_view& _y, const int bsize, const int _offs=0){
+      GELIB_NVTX_RANGE("DiagCGproduct",_x.getl(),_y.getl(),_r.getl(),_x.n0);
 
       const int l=_r.getl(); 
       const int l1=_x.getl(); 
@@ -53,33 +60,52 @@ namespace GElib{
       assert(_x.n2==_y.n2);
       assert(_x.n2%bsize==0);
 
+      int count=0; for(int i=-l1; i<=l1; i++) count+=std::min(l2,l-i)-std::max(-l2,-l-i)+(i<=l);
+      gelib_op_stats.count(GElibOpStats::DiagCGproduct,((long)B)*count*N*bsize*bsize,
+	8l*B*(_x.n1*_x.n2+_y.n1*_y.n2+_r.n1*_r.n2));
+
       if(dev==0){
 
-	auto& C=SO3_cgbank.getf(CGindex(l1,l2,l));
-	cnine::MultiLoop(B,[&](const int b){
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+
+	// Tile the n1 channels and the CG nonzero list so that the x rows
+	// of one tile and the r/y rows they touch stay cache-resident for
+	// the whole tile instead of being streamed once per (n1,m1,m2).
+	const int TN=gelib_config? gelib_config->SO3part_CGtile_channels : 32;
+	const int TM=gelib_config? gelib_config->SO3part_CGtile_nonzeros : 64;
+	const int nnz=C.nonzeros.size();
+
+	GElibMultiLoop(B,[&](const int b){
 	    SO3part2_view r=_r.slice0(b);
 	    SO3part2_view x=_x.slice0(b);
 	    SO3part2_view y=_y.slice0(b);
-	    int offs=_offs;
-	    
+
 	    for(int n=0; n<N; n++){
-	      for(int n1=0; n1<N1; n1++){
-		for(int n2=0; n2<N2; n2++){
-		  for(int m1=-l1; m1<=l1; m1++){
-		    for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++){
-		      r.inc(m1+m2,offs+n2,C(m1+l1,m2+l2)*x(m1,n1+n*bsize)*y(m2,n2+n*bsize));
+	      for(int n1t=0; n1t<N1; n1t+=TN){
+		const int n1e=std::min(n1t+TN,N1);
+		for(int et=0; et<nnz; et+=TM){
+		  const int ee=std::min(et+TM,nnz);
+		  for(int n1=n1t; n1<n1e; n1++){
+		    const int offs=_offs+(n*N1+n1)*N2;
+		    for(int ei=et; ei<ee; ei++){
+		      const auto& e=C.nonzeros[ei];
+		      const complex<float> t=e.c*x(e.m1-l1,n1+n*bsize);
+		      for(int n2=0; n2<N2; n2++)
+			r.inc(e.m-l,offs+n2,t*y(e.m2-l2,n2+n*bsize));
 		    }
 		  }
 		}
-		offs+=N2;
 	      }
 	    }
 	  });
 
       }
       else{
-	assert(bsize==1);
-	CUDA_STREAM(SO3partB_addDiagCGproduct_cu(_r,_x,_y,_offs,stream));
+	if(bsize==1){
+	  CUDA_STREAM(SO3partB_addDiagCGproduct_cu(_r,_x,_y,_offs,stream));
+	}else{
+	  CUDA_STREAM(SO3partB_addBlockedCGproduct_cu(_r,_x,_y,bsize,_offs,stream));
+	}
       }
     }
 
@@ -14,7 +14,8 @@
 #include "GElib_base.hpp"
 #include "CtensorB.hpp"
 #include "SO3part3_view.hpp"
-#include "MultiLoop.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibNvtx.hpp"
 
 extern GElib::SO3_CGbank SO3_cgbank;
 extern GElib::SO3_SPHgen SO3_sphGen;
@@ -23,8 +24,10 @@ extern GElib::SO3_SPHgen SO3_sphGen;
 namespace GElib{
 
   #ifdef _WITH_CUDA
-  void SO3partB_addDiagCGproduct_back0_cu(const cnine::Ctensor3_view& xg, cnine::Ctensor3_view rg, const cnine::Ctensor3_view& y, 
+  void SO3partB_addDiagCGproduct_back0_cu(const cnine::Ctensor3_view& xg, cnine::Ctensor3_view rg, const cnine::Ctensor3_view& y,
     const int offs, const cudaStream_t& stream);
+  void SO3partB_addBlockedCGproduct_back0_cu(cnine::Ctensor3_view xg, const cnine::Ctensor3_view& g, const cnine::Ctensor3_view& y,
+    const int bsize, const int offs, const cudaStream_t& stream);
   #endif
 
 
@@ -33,6 +36,7 @@ namespace GElib{
 
 
     void operator()(const SO3part3_view& _xg, const SO3part3_view& _g, const SO3part3_view& _y, const int bsize, const int _offs=0){
+      GELIB_NVTX_RANGE("DiagCGproduct_back0",_xg.getl(),_y.getl(),_g.getl(),_g.n0);
 
       const int l=_g.getl(); 
       const int l1=_xg.getl(); 
@@ -55,8 +59,8 @@ namespace GElib{
 
       if(dev==0){
 	
-	auto& C=SO3_cgbank.getf(CGindex(l1,l2,l));
-	cnine::MultiLoop(B,[&](const int b){
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+	GElibMultiLoop(B,[&](const int b){
 	    SO3part2_view g=_g.slice0(b);
 	    SO3part2_view xg=_xg.slice0(b);
 	    SO3part2_view y=_y.slice0(b);
@@ -77,8 +81,11 @@ namespace GElib{
 	  });
       }
       else{
-	assert(bsize==1);
-	CUDA_STREAM(SO3partB_addDiagCGproduct_back0_cu(_xg,_g,_y,_offs,stream));
+	if(bsize==1){
+	  CUDA_STREAM(SO3partB_addDiagCGproduct_back0_cu(_xg,_g,_y,_offs,stream));
+	}else{
+	  CUDA_STREAM(SO3partB_addBlockedCGproduct_back0_cu(_xg,_g,_y,bsize,_offs,stream));
+	}
       }
 
     }
@@ -14,7 +14,8 @@
 #include "GElib_base.hpp"
 #include "CtensorB.hpp"
 #include "SO3part3_view.hpp"
-#include "MultiLoop.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibNvtx.hpp"
 
 extern GElib::SO3_CGbank SO3_cgbank;
 extern GElib::SO3_SPHgen SO3_sphGen;
@@ -23,8 +24,10 @@ extern GElib::SO3_SPHgen SO3_sphGen;
 namespace GElib{
 
   #ifdef _WITH_CUDA
-  void SO3partB_addDiagCGproduct_back1_cu(const cnine::Ctensor3_view& yg, cnine::Ctensor3_view g, const cnine::Ctensor3_view& x, 
+  void SO3partB_addDiagCGproduct_back1_cu(const cnine::Ctensor3_view& yg, cnine::Ctensor3_view g, const cnine::Ctensor3_view& x,
     const int offs, const cudaStream_t& stream);
+  void SO3partB_addBlockedCGproduct_back1_cu(cnine::Ctensor3_view yg, const cnine::Ctensor3_view& g, const cnine::Ctensor3_view& x,
+    const int bsize, const int offs, const cudaStream_t& stream);
   #endif
 
 
@@ -32,6 +35,7 @@ namespace GElib{
   public:
 
     void operator()(const SO3part3_view& _yg, const SO3part3_view& _g, const SO3part3_view& _x, const int bsize, const int _offs=0){
+      GELIB_NVTX_RANGE("DiagCGproduct_back1",_x.getl(),_yg.getl(),_g.getl(),_g.n0);
 
       const int l=_g.getl();
       const int l1=_x.getl(); 
@@ -52,8 +56,8 @@ namespace GElib{
 
       if(dev==0){
 
-	auto& C=SO3_cgbank.getf(CGindex(l1,l2,l));
-	cnine::MultiLoop(B,[&](const int b){
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+	GElibMultiLoop(B,[&](const int b){
 	    SO3part2_view g=_g.slice0(b);
 	    SO3part2_view x=_x.slice0(b);
 	    SO3part2_view yg=_yg.slice0(b);
@@ -74,8 +78,11 @@ namespace GElib{
 	  });
 
       }else{
-	assert(bsize==1);
-	CUDA_STREAM(SO3partB_addDiagCGproduct_back1_cu(_yg,_g,_x,_offs,stream));
+	if(bsize==1){
+	  CUDA_STREAM(SO3partB_addDiagCGproduct_back1_cu(_yg,_g,_x,_offs,stream));
+	}else{
+	  CUDA_STREAM(SO3partB_addBlockedCGproduct_back1_cu(_yg,_g,_x,bsize,_offs,stream));
+	}
       }
 
     }
@@ -12,15 +12,30 @@
 #define _SO3part_addCGproductFn
 
 #include "GElib_base.hpp"
+#include "GElibCudaGraphs.hpp"
+#include "GElibCudaStagingPool.hpp"
+#include "GElibManagedMemory.hpp"
 #include "CtensorB.hpp"
 #include "SO3part2_view.hpp"
 #include "SO3part4_view.hpp"
-#include "MultiLoop.hpp"
+#include "GElibThreadPool.hpp"
 #include "GElibTimer.hpp"
 #include "WorkStreamLoop.hpp"
+#include "SO3part_addCGproduct_simd.hpp"
+#include "SO3part_addCGproduct_largeB.hpp"
+#include "SO3part_CGbatcher.hpp"
+#include "SO3part_addCGproduct_smallFn.hpp"
+#include "SO3part_addCGproduct_gemm.hpp"
+#include "GElibConfig.hpp"
+#include "GElibOpStats.hpp"
+#include "SO3CGkernelDispatcher.hpp"
+#include "SO3CGjitKernelBank.hpp"
+#include "GElibNvtx.hpp"
 
 extern thread_local cnine::DeviceSelector cnine::dev_selector;
 
+extern GElib::GElibConfig* gelib_config;
+extern GElib::SO3CGkernelDispatcher SO3_CGdispatcher;
 extern GElib::SO3_CGbank SO3_cgbank;
 extern GElib::SO3_SPHgen SO3_sphGen;
 
@@ -30,15 +45,107 @@ namespace GElib{
   #ifdef _WITH_CUDA
   void SO3partB_addCGproduct_cu(cnine::Ctensor3_view r, const cnine::Ctensor3_view& x, const cnine::Ctensor3_view& y, 
     const int offs, const cudaStream_t& stream);
-  void SO3partB_addDiagCGproduct_cu(cnine::Ctensor3_view r, const cnine::Ctensor3_view& x, const cnine::Ctensor3_view& y, 
+  void SO3partB_addDiagCGproduct_cu(cnine::Ctensor3_view r, const cnine::Ctensor3_view& x, const cnine::Ctensor3_view& y,
     const int offs, const cudaStream_t& stream);
+  void SO3partB_addReducingCGproduct_cu(const cnine::Ctensor4_view& r, const cnine::Ctensor5_view& x,
+    const cnine::Ctensor4_view& y, const int offs, const cudaStream_t& stream);
   #endif
 
 
+  // Online chunk tuner for the streaming branch below. The chunk count
+  // that best overlaps transfer with compute depends on the copy and
+  // kernel rates of the actual shapes and host, which a fixed formula
+  // cannot anticipate, so each distinct row size hill-climbs its own
+  // chunk count: every streamed call is timed end to end, nb is doubled
+  // or halved while the measured throughput keeps improving, and the
+  // search then pins the best size. If throughput later drifts well
+  // below the pinned rate (contention, clock changes) the search
+  // reopens. Decisions go through gelib_log rather than stdout.
+  class SO3streamChunkTuner{
+  public:
+
+    struct state{
+      int nb=0;
+      int best_nb=0;
+      double best_rate=0;
+      int dir=1;
+      bool settled=false;
+    };
+
+    map<size_t,state> states;
+
+    int get(const size_t row_floats, const int max_nb){
+      state& s=states[row_floats];
+      if(s.nb==0){
+	s.nb=std::max(1,max_nb/4);
+	s.best_nb=s.nb;
+      }
+      return std::max(std::min(s.nb,max_nb),1);
+    }
+
+    void report(const size_t row_floats, const int used_nb, const int max_nb, const size_t floats, const double secs){
+      if(secs<=0) return;
+      state& s=states[row_floats];
+      const double rate=floats/secs;
+      if(s.settled){
+	if(rate<0.8*s.best_rate){
+	  s.settled=false;
+	  s.best_rate=rate;
+	  s.dir=1;
+	  if(gelib_log) (*gelib_log)("Streaming CGproduct chunk search reopened after throughput drop, row size "+
+	    to_string(row_floats));
+	}
+	return;
+      }
+      if(rate>1.02*s.best_rate){
+	s.best_rate=rate;
+	s.best_nb=used_nb;
+	const int next=(s.dir>0)? std::min(2*used_nb,max_nb) : std::max(used_nb/2,1);
+	if(next==used_nb){settle(s,row_floats); return;}
+	s.nb=next;
+	return;
+      }
+      if(s.dir>0){
+	s.dir=-1;
+	const int next=std::max(s.best_nb/2,1);
+	if(next==s.best_nb){settle(s,row_floats); return;}
+	s.nb=next;
+	return;
+      }
+      settle(s,row_floats);
+    }
+
+  private:
+
+    void settle(state& s, const size_t row_floats){
+      s.nb=s.best_nb;
+      s.settled=true;
+      if(gelib_log) (*gelib_log)("Streaming CGproduct chunk size settled at nb="+to_string(s.nb)+
+	" ("+to_string((long)(s.best_rate/1e6))+" Mfloats/s) for row size "+to_string(row_floats));
+    }
+
+  };
+
+  inline thread_local SO3streamChunkTuner SO3stream_chunk_tuner;
+
+
   class SO3part_addCGproductFn{
   public:
 
+    // In overwrite mode the output fragment is written directly instead
+    // of accumulated into, eliminating the caller's zero-fill pass: each
+    // batch slice is zeroed inside the parallel loop immediately before
+    // it is accumulated into, so the zero stores are absorbed by the
+    // cache instead of costing the result a second trip through memory.
+    // Only the host paths honor the flag; the device and streaming
+    // wrappers keep a zero-filled result.
+    bool overwrite=false;
+
+    SO3part_addCGproductFn(const bool _overwrite=false): overwrite(_overwrite){}
+
+
     void operator()(const SO3part3_view& _r, const SO3part3_view& _x, const SO3part3_view& _y, const int _offs=0){
+      GELIB_NVTX_RANGE("CGproduct",_x.getl(),_y.getl(),_r.getl(),_x.n0);
 
 
       const int l=_r.getl(); 
@@ -57,75 +164,179 @@ namespace GElib{
       assert(l>=abs(l1-l2) && l<=l1+l2);
 
       int count=0; for(int i=-l1; i<=l1; i++) count+=std::min(l2,l-i)-std::max(-l2,-l-i)+(i<=l);
-      CGproductTimer(l1,l2,l,B,N1,N2,dev,B*count*N1*N2);
-      
+      if(dev==0) CGproductTimer(l1,l2,l,B,N1,N2,dev,B*count*N1*N2);
+      gelib_op_stats.count(GElibOpStats::CGproduct,((long)B)*count*N1*N2,
+	8l*B*(_x.n1*N1+_y.n1*N2+_r.n1*N1*N2));
+
+      // Inside an SO3partCGbatchScope the op is only recorded; the whole
+      // same-shape group executes together at scope exit.
+      if(gelib_cg_batcher && !overwrite){
+	gelib_cg_batcher->submit(_r,_x,_y,_offs);
+	return;
+      }
+
+
       if(dev==0 && cnine::dev_selector.dev>0){
 	int sdev=cnine::dev_selector.dev;
 
+	// The streamed chunks accumulate on the device, so overwrite mode
+	// falls back to zeroing the host fragment up front.
+	if(overwrite)
+	  GElibMultiLoop(B,[&](const int b){
+	      SO3part2_view r=_r.slice0(b);
+	      for(int m=-l; m<=l; m++)
+		for(int j=0; j<N1*N2; j++)
+		  r.set(m,_offs+j,0);
+	    });
+
 	if(!_r.is_regular() || !_x.is_regular() || !_y.is_regular()){
 	  gelib_log->error(__PRETTY_FUNCTION__,"Arguments of streaming operation must have regular strides. Skipping this operation."); return;}
 
-	int nb=std::min((cnine::dev_selector.max_mem<<18)/(2*_x.n1*_x.n2+2*_y.n1*_y.n2+2*_r.n1*_x.n2*_y.n2),_r.n0);
-	cout<<"nb="<<nb;
-	cnine::ArrayOnDevice<float> xbuf(2*nb*_x.n1*_x.n2);
-	cnine::ArrayOnDevice<float> ybuf(2*nb*_y.n1*_y.n2);
-	cnine::ArrayOnDevice<float> rbuf(2*nb*_r.n1*_x.n2*_y.n2);
-	cnine::Ctensor3_view xv(xbuf,nb,_x.n1,_x.n2,_x.s0,_x.s1,_x.s2,1,sdev);
-	cnine::Ctensor3_view yv(ybuf,nb,_y.n1,_y.n2,_y.s0,_y.s1,_y.s2,1,sdev);
-	cnine::Ctensor3_view rv(rbuf,nb,_r.n1,_x.n2*_y.n2,_r.s0,_r.s1,_r.s2,1,sdev);
+	// The staging budget only bounds the chunk size; within it the
+	// online tuner picks nb from measured throughput.
+	const int row_floats=2*_x.n1*_x.n2+2*_y.n1*_y.n2+2*_r.n1*_x.n2*_y.n2;
+	const int max_nb=std::max(std::min((cnine::dev_selector.max_mem<<18)/row_floats,_r.n0),1);
+	const int nb=SO3stream_chunk_tuner.get(row_floats,max_nb);
 
 #ifdef _WITH_CUDA
-	cu_stream stream;
-	//cudaStream_t stream;
-	//CUDA_SAFE(cudaStreamCreate(&stream));
-	for(int i=0; i<cnine::roundup(_r.n0,nb)/nb; i++){
-	
-	  int _nb=std::max(nb,_x.n0-i*nb);
-	  if(_nb<nb){
-	    xv.n0=_nb;
-	    yv.n0=_nb;
-	    rv.n0=_nb;
+	// The chunks are staged through leased pinned host buffers:
+	// cudaMemcpyAsync from pageable memory is silently synchronous,
+	// which defeated the pipeline, and the device buffers are reused
+	// across calls instead of being reallocated each invocation.
+	// Two buffer sets on two streams are interleaved so that chunk
+	// i+1 is transferred while chunk i computes; a stream is only
+	// drained (and its result copied out) when its buffers are about
+	// to be reused, so throughput approaches max(copy,compute).
+	GElibCudaStagingPool::BufferSet* sets[2]={
+	  gelib_cuda_staging.acquire(2*nb*_x.n1*_x.n2,2*nb*_y.n1*_y.n2,2*nb*_r.n1*_x.n2*_y.n2),
+	  gelib_cuda_staging.acquire(2*nb*_x.n1*_x.n2,2*nb*_y.n1*_y.n2,2*nb*_r.n1*_x.n2*_y.n2)};
+	cnine::Ctensor3_view xv[2]={
+	  cnine::Ctensor3_view(sets[0]->xbuf,nb,_x.n1,_x.n2,_x.s0,_x.s1,_x.s2,1,sdev),
+	  cnine::Ctensor3_view(sets[1]->xbuf,nb,_x.n1,_x.n2,_x.s0,_x.s1,_x.s2,1,sdev)};
+	cnine::Ctensor3_view yv[2]={
+	  cnine::Ctensor3_view(sets[0]->ybuf,nb,_y.n1,_y.n2,_y.s0,_y.s1,_y.s2,1,sdev),
+	  cnine::Ctensor3_view(sets[1]->ybuf,nb,_y.n1,_y.n2,_y.s0,_y.s1,_y.s2,1,sdev)};
+	cnine::Ctensor3_view rv[2]={
+	  cnine::Ctensor3_view(sets[0]->rbuf,nb,_r.n1,_x.n2*_y.n2,_r.s0,_r.s1,_r.s2,1,sdev),
+	  cnine::Ctensor3_view(sets[1]->rbuf,nb,_r.n1,_x.n2*_y.n2,_r.s0,_r.s1,_r.s2,1,sdev)};
+
+	cu_stream streams[2];
+	const int nchunks=cnine::roundup(_r.n0,nb)/nb;
+	int inflight[2]={0,0};
+	const auto tuner_t0=std::chrono::steady_clock::now();
+
+	for(int i=0; i<nchunks; i++){
+	  const int s=i%2;
+
+	  if(i>=2){
+	    CUDA_SAFE(cudaStreamSynchronize(streams[s]));
+	    std::memcpy(_r.arr+(i-2)*nb*_r.s0+2*_offs,sets[s]->rstage,inflight[s]*_r.s0*sizeof(float));
 	  }
-	  CUDA_SAFE(cudaMemcpyAsync(xbuf, _x.arr+i*nb*_x.s0, _nb*_x.s0*sizeof(float), cudaMemcpyHostToDevice, stream));
-	  CUDA_SAFE(cudaMemcpyAsync(ybuf, _y.arr+i*nb*_y.s0, _nb*_y.s0*sizeof(float), cudaMemcpyHostToDevice, stream));
-	  CUDA_SAFE(cudaMemcpyAsync(rbuf, _r.arr+i*nb*_r.s0+2*_offs, _nb*_r.s0*sizeof(float), cudaMemcpyHostToDevice, stream));
-	  SO3partB_addCGproduct_cu(rbuf,xbuf,ybuf,0,stream);
-	  CUDA_SAFE(cudaMemcpyAsync(_r.arr+i*nb*_r.s0+2*_offs, rbuf, _nb*_r.s0*sizeof(float), cudaMemcpyDeviceToHost, stream));
+
+	  const int _nb=std::min(nb,_x.n0-i*nb);
+	  inflight[s]=_nb;
+	  xv[s].n0=_nb;
+	  yv[s].n0=_nb;
+	  rv[s].n0=_nb;
+
+	  std::memcpy(sets[s]->xstage,_x.arr+i*nb*_x.s0,_nb*_x.s0*sizeof(float));
+	  std::memcpy(sets[s]->ystage,_y.arr+i*nb*_y.s0,_nb*_y.s0*sizeof(float));
+	  std::memcpy(sets[s]->rstage,_r.arr+i*nb*_r.s0+2*_offs,_nb*_r.s0*sizeof(float));
+	  CUDA_SAFE(cudaMemcpyAsync(sets[s]->xbuf,sets[s]->xstage,_nb*_x.s0*sizeof(float),cudaMemcpyHostToDevice,streams[s]));
+	  CUDA_SAFE(cudaMemcpyAsync(sets[s]->ybuf,sets[s]->ystage,_nb*_y.s0*sizeof(float),cudaMemcpyHostToDevice,streams[s]));
+	  CUDA_SAFE(cudaMemcpyAsync(sets[s]->rbuf,sets[s]->rstage,_nb*_r.s0*sizeof(float),cudaMemcpyHostToDevice,streams[s]));
+	  SO3partB_addCGproduct_cu(rv[s],xv[s],yv[s],0,streams[s]);
+	  CUDA_SAFE(cudaMemcpyAsync(sets[s]->rstage,sets[s]->rbuf,_nb*_r.s0*sizeof(float),cudaMemcpyDeviceToHost,streams[s]));
+	}
+
+	for(int i=std::max(0,nchunks-2); i<nchunks; i++){
+	  const int s=i%2;
+	  CUDA_SAFE(cudaStreamSynchronize(streams[s]));
+	  std::memcpy(_r.arr+i*nb*_r.s0+2*_offs,sets[s]->rstage,inflight[s]*_r.s0*sizeof(float));
 	}
-	//CUDA_SAFE(cudaStreamSynchronize(stream));
-	//CUDA_SAFE(cudaStreamDestroy(stream));
+
+	gelib_cuda_staging.release(sets[0]);
+	gelib_cuda_staging.release(sets[1]);
+	SO3stream_chunk_tuner.report(row_floats,nb,max_nb,((size_t)_r.n0)*row_floats,
+	  std::chrono::duration<double>(std::chrono::steady_clock::now()-tuner_t0).count());
+	return;
 #endif
 
       }
 
       if(dev==0){
 
-	auto& C=SO3_cgbank.getf(CGindex(l1,l2,l));
-	cnine::MultiLoop(B,[&](const int b){
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+	const SO3CGkernel kernel=SO3_CGdispatcher(SO3CGproductShape(l1,l2,l,B,N1,N2,dev));
+
+	if(kernel==SO3CGkernel::gemm){
+	  if(overwrite)
+	    GElibMultiLoop(B,[&](const int b){
+		SO3part2_view r=_r.slice0(b);
+		for(int m=-l; m<=l; m++)
+		  for(int j=0; j<N1*N2; j++)
+		    r.set(m,_offs+j,0);
+	      });
+	  SO3part_addCGproduct_gemm(_r,_x,_y,C,_offs);
+	  return;
+	}
+
+	// Beyond the large-batch threshold the data streams through
+	// memory once and the streaming kernel's prefetches and
+	// non-temporal output stores beat the cache-friendly kernels.
+	const int largeB=gelib_config? gelib_config->SO3part_CGproduct_largeB_threshold : 16384;
+	if(kernel==SO3CGkernel::simd && B>=largeB &&
+	  SO3part_addCGproduct_largeB(_r,_x,_y,C,_offs,overwrite)) return;
+
+	GElibMultiLoop(B,[&](const int b){
 	    SO3part2_view r=_r.slice0(b);
 	    SO3part2_view x=_x.slice0(b);
 	    SO3part2_view y=_y.slice0(b);
 	    int offs=_offs;
-	    
+
+	    if(overwrite)
+	      for(int m=-l; m<=l; m++)
+		for(int j=0; j<N1*N2; j++)
+		  r.set(m,_offs+j,0);
+
+	    if(kernel==SO3CGkernel::simd && SO3part_addCGproduct_simd(r,x,y,C,offs)) return;
+	    if(SO3part_addCGproduct_small(l1,l2,l,r,x,y,offs)) return;
+
 	    for(int n1=0; n1<N1; n1++){
-	      for(int n2=0; n2<N2; n2++){
-		for(int m1=-l1; m1<=l1; m1++){
-		  for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++){
-		    r.inc(m1+m2,offs+n2,C(m1+l1,m2+l2)*x(m1,n1)*y(m2,n2));
-		  }
-		}
+	      for(auto& e:C.nonzeros){
+		const complex<float> t=e.c*x(e.m1-l1,n1);
+		for(int n2=0; n2<N2; n2++)
+		  r.inc(e.m-l,offs+n2,t*y(e.m2-l2,n2));
 	      }
 	      offs+=N2;
 	    }
 	  });
       }
 
-      else CUDA_STREAM(SO3partB_addCGproduct_cu(_r,_x,_y,_offs,stream));
+      // On the device the wall clock only sees the launch; the event timer
+      // brackets the work on the op's stream and the elapsed time is
+      // harvested later by the logger thread (see GElibCudaEventPool).
+      else{
+	GELIB_CHECK(!overwrite,"overwrite mode of SO3part_addCGproductFn is CPU only");
+#if defined(_WITH_CUDA) && defined(_WITH_NVRTC)
+	if(gelib_config && gelib_config->SO3part_CGjit_kernels){
+	  bool done=false;
+	  GELIB_CUDA_STREAM(GELIB_PREFETCH_MANAGED3(_r,_x,_y,dev,stream);
+	    CGproductEventTimer timer(l1,l2,l,B,N1,N2,dev,B*count*N1*N2,stream);
+	    done=SO3CGjit_bank(_r,_x,_y,_offs,stream));
+	  if(done) return;
+	}
+#endif
+	GELIB_CUDA_STREAM(GELIB_PREFETCH_MANAGED3(_r,_x,_y,dev,stream);
+	  CGproductEventTimer timer(l1,l2,l,B,N1,N2,dev,B*count*N1*N2,stream);
+	  SO3partB_addCGproduct_cu(_r,_x,_y,_offs,stream));
+      }
 
     }
 
 
     void operator()(const cnine::Ctensor4_view& _r, const cnine::Ctensor5_view& _x, const cnine::Ctensor4_view& _y, const int _offs=0){
+      GELIB_NVTX_RANGE("ReducingCGproduct",(_x.n3-1)/2,(_r.n2-1)/2,(_r.n2-1)/2,_x.n0);
 
       const int l=(_r.n2-1)/2;
       const int l1=(_x.n3-1)/2;
@@ -150,7 +361,7 @@ namespace GElib{
 
       if(dev==0){
 
-	auto& C=SO3_cgbank.getf(CGindex(l1,l2,l));
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
 	batched_cmvprod(_r,_x,_y,[&](const cnine::Ctensor2_view& _r, const cnine::Ctensor2_view& _x, const cnine::Ctensor2_view& _y){
 	    SO3part2_view r(_r);
 	    SO3part2_view x(_x);
@@ -158,19 +369,18 @@ namespace GElib{
 
 	    int offs=_offs;
 	    for(int n1=0; n1<N1; n1++){
-	      for(int n2=0; n2<N2; n2++){
-		for(int m1=-l1; m1<=l1; m1++){
-		  for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++){
-		    r.inc(m1+m2,offs+n2,C(m1+l1,m2+l2)*x(m1,n1)*y(m2,n2));
-		  }
-		}
+	      for(auto& e:C.nonzeros){
+		const complex<float> t=e.c*x(e.m1-l1,n1);
+		for(int n2=0; n2<N2; n2++)
+		  r.inc(e.m-l,offs+n2,t*y(e.m2-l2,n2));
 	      }
 	      offs+=N2;
 	    }
 	  });
 
       }
-      //else CUDA_STREAM(SO3partB_addReducingCGproduct_cu(_r,_x,_y,_offs,stream));
+
+      else GELIB_CUDA_STREAM(SO3partB_addReducingCGproduct_cu(_r,_x,_y,_offs,stream));
 
     }
 
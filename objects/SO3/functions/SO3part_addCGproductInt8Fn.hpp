@@ -0,0 +1,128 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3part_addCGproductInt8Fn
+#define _SO3part_addCGproductInt8Fn
+
+#include "GElib_base.hpp"
+#include "SO3_CGbank.hpp"
+#include "SO3partB_int8.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibNvtx.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+
+
+namespace GElib{
+
+#ifdef _WITH_CUDA
+  void SO3partB_addCGproduct_int8_cu(int8_t* rarr, const int8_t* xarr, const int8_t* yarr,
+    const int b, const int N1, const int N2, const int rn2,
+    const int l1, const int l2, const int l, const int offs, const float requant,
+    const int32_t* nzix, const int32_t* nzc, const int nnz, const cudaStream_t& stream);
+#endif
+
+
+  // Int8 CG product for inference: int8 operands, int32 accumulation,
+  // int8 result. The CG coefficients are quantized once per table to
+  // 8.8 fixed point (|c|<=1, so c_fx=round(256*c) keeps 8 fractional
+  // bits); a term contributes at most 2*127^2*256 < 2^24, and with at
+  // most a few dozen nonzeros per output m the int32 accumulator never
+  // overflows. The float scales fold into a single requantization
+  // factor x.scale*y.scale/(256*r.scale) applied on the final store.
+  //
+  // On GPU each complex multiply-accumulate runs as two DP4A byte-dot
+  // instructions on [re,im] pairs (see SO3partB_addCGproduct_int8.cu).
+  // The VNNI byte dots contract four bytes the same way, but the CG
+  // product has no contraction over the channel axis -- each output
+  // column is an outer product -- so on CPU the win is the halved
+  // operand width and the plain int16/int32 multiplies below, which
+  // the compiler vectorizes without needing the dot-product ISA.
+
+  class SO3part_addCGproductInt8Fn{
+  public:
+
+    void operator()(SO3partB_int8& r, const SO3partB_int8& x, const SO3partB_int8& y, const int offs=0){
+      const int l=r.l;
+      const int l1=x.l;
+      const int l2=y.l;
+      const int N1=x.n;
+      const int N2=y.n;
+      const int B=x.b;
+      GELIB_NVTX_RANGE("CGproductInt8",l1,l2,l,B);
+
+      GELIB_ASSRT(l>=std::abs(l1-l2) && l<=l1+l2);
+      GELIB_ASSRT(r.b==B && y.b==B);
+      GELIB_ASSRT(offs+N1*N2<=r.n);
+      GELIB_ASSRT(r.dev==x.dev && r.dev==y.dev);
+
+      auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+      const int nnz=C.packed_ix.size();
+      vector<int32_t> cfx(nnz);
+      for(int k=0; k<nnz; k++) cfx[k]=std::lround(256.0f*C.packed_c[k]);
+      const float requant=x.scale*y.scale/(256.0f*r.scale);
+
+      if(r.dev>0){
+#ifdef _WITH_CUDA
+	GELIB_CUDA_STREAM(SO3partB_addCGproduct_int8_cu(r.get_arr(),x.get_arr(),y.get_arr(),
+	    B,N1,N2,r.n,l1,l2,l,offs,requant,C.packed_ix.data(),cfx.data(),nnz,stream));
+#else
+	GELIB_ERROR("GElib was compiled without CUDA support");
+#endif
+	return;
+      }
+
+      const int rn=r.n;
+      GElibMultiLoop(B,[&](const int _b){
+	  const int8_t* xp=x.get_arr()+((size_t)_b)*(2*l1+1)*N1*2;
+	  const int8_t* yp=y.get_arr()+((size_t)_b)*(2*l2+1)*N2*2;
+	  int8_t* rp=r.get_arr()+((size_t)_b)*(2*l+1)*rn*2;
+
+	  vector<int32_t> acc(2*(2*l+1)*N2);
+	  for(int n1=0; n1<N1; n1++){
+	    std::fill(acc.begin(),acc.end(),0);
+
+	    for(int k=0; k<nnz; k++){
+	      const int32_t ix=C.packed_ix[k];
+	      const int m1=(ix>>16)&255;
+	      const int m2=(ix>>8)&255;
+	      const int m=ix&255;
+	      const int32_t c=cfx[k];
+	      const int32_t xr=c*xp[(m1*N1+n1)*2];
+	      const int32_t xi=c*xp[(m1*N1+n1)*2+1];
+	      const int8_t* yrow=yp+m2*N2*2;
+	      int32_t* are=acc.data()+2*m*N2;
+	      int32_t* aim=are+N2;
+	      for(int n2=0; n2<N2; n2++){
+		const int32_t yr=yrow[n2*2];
+		const int32_t yi=yrow[n2*2+1];
+		are[n2]+=xr*yr-xi*yi;
+		aim[n2]+=xr*yi+xi*yr;
+	      }
+	    }
+
+	    for(int m=0; m<2*l+1; m++){
+	      int8_t* p=rp+(m*rn+offs+n1*N2)*2;
+	      const int32_t* are=acc.data()+2*m*N2;
+	      const int32_t* aim=are+N2;
+	      for(int n2=0; n2<N2; n2++){
+		p[n2*2]=SO3partB_int8::qround(p[n2*2]+requant*are[n2]);
+		p[n2*2+1]=SO3partB_int8::qround(p[n2*2+1]+requant*aim[n2]);
+	      }
+	    }
+	  }
+	});
+    }
+
+  };
+
+}
+
+#endif
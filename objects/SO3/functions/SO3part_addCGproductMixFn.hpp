@@ -0,0 +1,94 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3part_addCGproductMixFn
+#define _SO3part_addCGproductMixFn
+
+#include "GElib_base.hpp"
+#include "CtensorB.hpp"
+#include "SO3part3_view.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibNvtx.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+
+
+namespace GElib{
+
+  // Fused CGproduct + channel mix: r[:,offs:offs+nout] += (x (*) y) w in
+  // one pass, where (*) is the full CG product and w is an (N1*N2) x
+  // nout complex weight matrix. Run separately, the product
+  // materializes a (2l+1) x N1*N2 intermediate -- typically the widest
+  // tensor in the network -- only for the mix to contract it away. Here
+  // the product is computed one n1 column group at a time into a
+  // (2l+1) x N2 stack-side tile that the mix consumes while it is still
+  // in L1, so the intermediate never exists and a full memory round
+  // trip is saved. CPU only -- on the device the wrapper falls back to
+  // the unfused pair.
+
+  class SO3part_addCGproductMixFn{
+  public:
+
+    void operator()(const SO3part3_view& _r, const SO3part3_view& _x, const SO3part3_view& _y,
+      const cnine::Ctensor2_view& _w, const int _offs=0){
+      GELIB_NVTX_RANGE("CGproduct_mix",_x.getl(),_y.getl(),_r.getl(),_x.n0);
+
+      const int l=_r.getl();
+      const int l1=_x.getl();
+      const int l2=_y.getl();
+
+      const int N1=_x.n2;
+      const int N2=_y.n2;
+      const int nout=_w.n1;
+      const int B=_x.n0;
+
+      CNINE_CHECK_DEV3(_r,_x,_y)
+      CNINE_CHECK_BATCH3(_r,_x,_y)
+      GELIB_CHECK(_r.dev==0,"SO3part_addCGproductMixFn is CPU only");
+      assert(l>=abs(l1-l2) && l<=l1+l2);
+      GELIB_ASSRT(_w.n0==N1*N2);
+      GELIB_ASSRT(_offs+nout<=_r.n2);
+
+      auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+      cnine::Ctensor2_view w=_w;
+
+      GElibMultiLoop(B,[&](const int b){
+	  SO3part2_view r=_r.slice0(b);
+	  SO3part2_view x=_x.slice0(b);
+	  SO3part2_view y=_y.slice0(b);
+
+	  vector<complex<float> > t((2*l+1)*N2);
+
+	  for(int n1=0; n1<N1; n1++){
+
+	    std::fill(t.begin(),t.end(),complex<float>(0));
+	    for(auto& e: C.nonzeros){
+	      const complex<float> xv=e.c*x(e.m1-l1,n1);
+	      for(int n2=0; n2<N2; n2++)
+		t[e.m*N2+n2]+=xv*y(e.m2-l2,n2);
+	    }
+
+	    for(int m=-l; m<=l; m++){
+	      for(int j=0; j<nout; j++){
+		complex<float> s=0;
+		for(int n2=0; n2<N2; n2++)
+		  s+=t[(m+l)*N2+n2]*w(n1*N2+n2,j);
+		r.inc(m,_offs+j,s);
+	      }
+	    }
+	  }
+	});
+    }
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,160 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3part_addCGproductMix_backFn
+#define _SO3part_addCGproductMix_backFn
+
+#include <mutex>
+
+#include "GElib_base.hpp"
+#include "CtensorB.hpp"
+#include "SO3part3_view.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibConfig.hpp"
+#include "GElibNvtx.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+extern GElib::GElibConfig* gelib_config;
+
+
+namespace GElib{
+
+  // Fused backward of SO3part_addCGproductMixFn: accumulates all three
+  // gradients xg, yg and wg of r+=(x (*) y) w in one tiled sweep. Per
+  // n1 column group two (2l+1) x N2 stack-side tiles are formed -- the
+  // forward product fragment (needed for wg) and the mixed-back
+  // gradient g w^H (needed for xg and yg) -- and consumed in place, so
+  // like the forward pass the full (2l+1) x N1*N2 intermediate never
+  // materializes. The batch loop is parallel; wg is shared across
+  // batches, so its per-tile flush is serialized by a mutex while the
+  // xg/yg accumulations stay lock-free. The mutex order follows thread
+  // completion, so in deterministic mode (GElibConfig::deterministic)
+  // each batch instead accumulates wg into its own partial buffer and
+  // the B partials are folded through the fixed schedule of
+  // GElibTreeReduce -- bitwise reproducible at the cost of B extra
+  // wg-sized buffers. CPU only, like the forward Fn.
+
+  class SO3part_addCGproductMix_backFn{
+  public:
+
+    void operator()(const SO3part3_view& _xg, const SO3part3_view& _yg, const cnine::Ctensor2_view& _wg,
+      const SO3part3_view& _g, const SO3part3_view& _x, const SO3part3_view& _y,
+      const cnine::Ctensor2_view& _w, const int _offs=0){
+      GELIB_NVTX_RANGE("CGproduct_mix_back",_x.getl(),_y.getl(),_g.getl(),_x.n0);
+
+      const int l=_g.getl();
+      const int l1=_x.getl();
+      const int l2=_y.getl();
+
+      const int N1=_x.n2;
+      const int N2=_y.n2;
+      const int nout=_w.n1;
+      const int B=_x.n0;
+
+      CNINE_CHECK_DEV3(_g,_x,_y)
+      CNINE_CHECK_BATCH3(_g,_x,_y)
+      GELIB_CHECK(_g.dev==0,"SO3part_addCGproductMix_backFn is CPU only");
+      assert(l>=abs(l1-l2) && l<=l1+l2);
+      GELIB_ASSRT(_w.n0==N1*N2);
+      GELIB_ASSRT(_wg.n0==N1*N2 && _wg.n1==nout);
+      GELIB_ASSRT(_offs+nout<=_g.n2);
+
+      auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+      cnine::Ctensor2_view w=_w;
+      cnine::Ctensor2_view wg=_wg;
+      std::mutex wg_mx;
+
+      const bool deterministic=gelib_config && gelib_config->deterministic;
+      vector<vector<complex<float> > > wgpart;
+      if(deterministic)
+	wgpart=vector<vector<complex<float> > >(B,vector<complex<float> >(N1*N2*nout,complex<float>(0)));
+
+      GElibMultiLoop(B,[&](const int b){
+	  SO3part2_view g=_g.slice0(b);
+	  SO3part2_view xg=_xg.slice0(b);
+	  SO3part2_view yg=_yg.slice0(b);
+	  SO3part2_view x=_x.slice0(b);
+	  SO3part2_view y=_y.slice0(b);
+
+	  vector<complex<float> > t((2*l+1)*N2);
+	  vector<complex<float> > gw((2*l+1)*N2);
+
+	  for(int n1=0; n1<N1; n1++){
+
+	    // Forward product fragment of this column group and the
+	    // gradient mixed back through w.
+	    std::fill(t.begin(),t.end(),complex<float>(0));
+	    for(auto& e: C.nonzeros){
+	      const complex<float> xv=e.c*x(e.m1-l1,n1);
+	      for(int n2=0; n2<N2; n2++)
+		t[e.m*N2+n2]+=xv*y(e.m2-l2,n2);
+	    }
+	    for(int m=0; m<2*l+1; m++)
+	      for(int n2=0; n2<N2; n2++){
+		complex<float> s=0;
+		for(int j=0; j<nout; j++)
+		  s+=g(m-l,_offs+j)*std::conj(w(n1*N2+n2,j));
+		gw[m*N2+n2]=s;
+	      }
+
+	    for(auto& e: C.nonzeros){
+	      complex<float> s=0;
+	      const complex<float> xv=std::conj(e.c*x(e.m1-l1,n1));
+	      for(int n2=0; n2<N2; n2++){
+		s+=gw[e.m*N2+n2]*std::conj(y(e.m2-l2,n2));
+		yg.inc(e.m2-l2,n2,gw[e.m*N2+n2]*xv);
+	      }
+	      xg.inc(e.m1-l1,n1,e.c*s);
+	    }
+
+	    if(deterministic){
+	      complex<float>* wgb=wgpart[b].data();
+	      for(int n2=0; n2<N2; n2++)
+		for(int j=0; j<nout; j++){
+		  complex<float> s=0;
+		  for(int m=0; m<2*l+1; m++)
+		    s+=std::conj(t[m*N2+n2])*g(m-l,_offs+j);
+		  wgb[(n1*N2+n2)*nout+j]+=s;
+		}
+	    }else{
+	      std::lock_guard<std::mutex> lock(wg_mx);
+	      for(int n2=0; n2<N2; n2++)
+		for(int j=0; j<nout; j++){
+		  complex<float> s=0;
+		  for(int m=0; m<2*l+1; m++)
+		    s+=std::conj(t[m*N2+n2])*g(m-l,_offs+j);
+		  wg.inc(n1*N2+n2,j,s);
+		}
+	    }
+	  }
+	});
+
+      // Fold the per-batch wg partials in fixed tree order and flush the
+      // total with disjoint-row writes; neither step depends on thread
+      // scheduling.
+      if(deterministic){
+	GElibTreeReduce(B,[&](const int a, const int b){
+	    complex<float>* pa=wgpart[a].data();
+	    const complex<float>* pb=wgpart[b].data();
+	    for(int i=0; i<N1*N2*nout; i++) pa[i]+=pb[i];
+	  });
+	const complex<float>* p0=wgpart[0].data();
+	GElibMultiLoop(N1*N2,[&](const int i){
+	    for(int j=0; j<nout; j++)
+	      wg.inc(i,j,p0[i*nout+j]);
+	  });
+      }
+    }
+
+  };
+
+}
+
+#endif
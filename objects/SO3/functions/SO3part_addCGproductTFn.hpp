@@ -0,0 +1,158 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3part_addCGproductTFn
+#define _SO3part_addCGproductTFn
+
+#include "GElib_base.hpp"
+#include "TensorView.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibNvtx.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+
+
+namespace GElib{
+
+  // Scalar-type-generic CPU kernels for the CG product family, written
+  // against cnine::TensorView<complex<TYPE> > so that double (and any
+  // future scalar type) runs natively instead of being upcast around a
+  // float-only kernel. The float specialization of the view classes
+  // keeps its dedicated SIMD/GEMM paths; these kernels are the native
+  // backend for everything else.
+
+  template<typename TYPE>
+  inline const SO3_CGcoeffs<TYPE>& SO3_cgcoeffs(const int l1, const int l2, const int l){
+    return SO3_cgbank_cached<TYPE>(CGindex(l1,l2,l));
+  }
+
+
+  template<typename TYPE>
+  class SO3part_addCGproductTFn{
+  public:
+
+    typedef cnine::TensorView<complex<TYPE> > TENSOR;
+
+    void operator()(const TENSOR& _r, const TENSOR& _x, const TENSOR& _y, const int _offs=0){
+      GELIB_NVTX_RANGE("CGproductT");
+
+      CNINE_ASSRT(_r.ndims()==3);
+      CNINE_ASSRT(_x.ndims()==3);
+      CNINE_ASSRT(_y.ndims()==3);
+      GELIB_CHECK((_r.get_dev()==0),"generic scalar type CG product is CPU only");
+
+      const int l=(_r.dim(1)-1)/2;
+      const int l1=(_x.dim(1)-1)/2;
+      const int l2=(_y.dim(1)-1)/2;
+      const int N1=_x.dim(2);
+      const int N2=_y.dim(2);
+      const int B=_x.dim(0);
+
+      CNINE_ASSRT(_offs+N1*N2<=_r.dim(2));
+      CNINE_ASSRT(l>=abs(l1-l2) && l<=l1+l2);
+
+      auto& C=SO3_cgcoeffs<TYPE>(l1,l2,l);
+      GElibMultiLoop(B,[&](const int b){
+	  int offs=_offs;
+	  for(int n1=0; n1<N1; n1++){
+	    for(auto& e:C.nonzeros){
+	      const complex<TYPE> t=e.c*_x(b,e.m1,n1);
+	      for(int n2=0; n2<N2; n2++)
+		_r.inc(b,e.m,offs+n2,t*_y(b,e.m2,n2));
+	    }
+	    offs+=N2;
+	  }
+	});
+    }
+
+  };
+
+
+  template<typename TYPE>
+  class SO3part_addCGproduct_back0TFn{
+  public:
+
+    typedef cnine::TensorView<complex<TYPE> > TENSOR;
+
+    void operator()(const TENSOR& _xg, const TENSOR& _g, const TENSOR& _y, const int _offs=0){
+      GELIB_NVTX_RANGE("CGproductT_back0");
+
+      CNINE_ASSRT(_g.ndims()==3);
+      GELIB_CHECK((_g.get_dev()==0),"generic scalar type CG product is CPU only");
+
+      const int l=(_g.dim(1)-1)/2;
+      const int l1=(_xg.dim(1)-1)/2;
+      const int l2=(_y.dim(1)-1)/2;
+      const int N1=_xg.dim(2);
+      const int N2=_y.dim(2);
+      const int B=_xg.dim(0);
+
+      CNINE_ASSRT(_offs+N1*N2<=_g.dim(2));
+      CNINE_ASSRT(l>=abs(l1-l2) && l<=l1+l2);
+
+      auto& C=SO3_cgcoeffs<TYPE>(l1,l2,l);
+      GElibMultiLoop(B,[&](const int b){
+	  int offs=_offs;
+	  for(int n1=0; n1<N1; n1++){
+	    for(auto& e:C.nonzeros){
+	      complex<TYPE> xacc=0;
+	      for(int n2=0; n2<N2; n2++)
+		xacc+=e.c*_g(b,e.m,offs+n2)*std::conj(_y(b,e.m2,n2));
+	      _xg.inc(b,e.m1,n1,xacc);
+	    }
+	    offs+=N2;
+	  }
+	});
+    }
+
+  };
+
+
+  template<typename TYPE>
+  class SO3part_addCGproduct_back1TFn{
+  public:
+
+    typedef cnine::TensorView<complex<TYPE> > TENSOR;
+
+    void operator()(const TENSOR& _yg, const TENSOR& _g, const TENSOR& _x, const int _offs=0){
+      GELIB_NVTX_RANGE("CGproductT_back1");
+
+      CNINE_ASSRT(_g.ndims()==3);
+      GELIB_CHECK((_g.get_dev()==0),"generic scalar type CG product is CPU only");
+
+      const int l=(_g.dim(1)-1)/2;
+      const int l1=(_x.dim(1)-1)/2;
+      const int l2=(_yg.dim(1)-1)/2;
+      const int N1=_x.dim(2);
+      const int N2=_yg.dim(2);
+      const int B=_x.dim(0);
+
+      CNINE_ASSRT(_offs+N1*N2<=_g.dim(2));
+      CNINE_ASSRT(l>=abs(l1-l2) && l<=l1+l2);
+
+      auto& C=SO3_cgcoeffs<TYPE>(l1,l2,l);
+      GElibMultiLoop(B,[&](const int b){
+	  int offs=_offs;
+	  for(int n1=0; n1<N1; n1++){
+	    for(auto& e:C.nonzeros){
+	      const complex<TYPE> xc=std::conj(_x(b,e.m1,n1));
+	      for(int n2=0; n2<N2; n2++)
+		_yg.inc(b,e.m2,n2,e.c*_g(b,e.m,offs+n2)*xc);
+	    }
+	    offs+=N2;
+	  }
+	});
+    }
+
+  };
+
+}
+
+#endif
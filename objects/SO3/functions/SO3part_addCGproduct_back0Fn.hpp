@@ -12,9 +12,11 @@
 #define _SO3part_addCGproduct_back0Fn
 
 #include "GElib_base.hpp"
+#include "GElibCudaGraphs.hpp"
 #include "CtensorB.hpp"
 #include "SO3part3_view.hpp"
-#include "MultiLoop.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibNvtx.hpp"
 
 extern GElib::SO3_CGbank SO3_cgbank;
 extern GElib::SO3_SPHgen SO3_sphGen;
@@ -35,6 +37,7 @@ namespace GElib{
 
 
     void operator()(const SO3part3_view& _xg, const SO3part3_view& _g, const SO3part3_view& _y, const int _offs=0){
+      GELIB_NVTX_RANGE("CGproduct_back0",_xg.getl(),_y.getl(),_g.getl(),_g.n0);
 
       const int l=_g.getl(); 
       const int l1=_xg.getl(); 
@@ -58,8 +61,8 @@ namespace GElib{
 
       if(dev==0){
 	
-	auto& C=SO3_cgbank.getf(CGindex(l1,l2,l));
-	cnine::MultiLoop(B,[&](const int b){
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+	GElibMultiLoop(B,[&](const int b){
 	    SO3part2_view g=_g.slice0(b);
 	    SO3part2_view xg=_xg.slice0(b);
 	    SO3part2_view y=_y.slice0(b);
@@ -79,7 +82,7 @@ namespace GElib{
 
       }
       else{
-	CUDA_STREAM(SO3partB_addCGproduct_back0_cu(_xg,_g,_y,_offs,stream));
+	GELIB_CUDA_STREAM(SO3partB_addCGproduct_back0_cu(_xg,_g,_y,_offs,stream));
       }
 
     }
@@ -0,0 +1,97 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3part_addCGproduct_backFn
+#define _SO3part_addCGproduct_backFn
+
+#include "GElib_base.hpp"
+#include "CtensorB.hpp"
+#include "SO3part3_view.hpp"
+#include "SO3part_addCGproduct_back0Fn.hpp"
+#include "SO3part_addCGproduct_back1Fn.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibNvtx.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+extern GElib::SO3_SPHgen SO3_sphGen;
+
+
+namespace GElib{
+
+  // Fused backward pass of the CG product. Computes the gradients of
+  // both operands in a single sweep over g, x and y: each gradient
+  // entry g(m,offs+n2) is loaded once and contributes to xg and yg in
+  // the same innermost iteration, halving the memory traffic of running
+  // the back0 and back1 kernels as separate passes. On the GPU the two
+  // existing kernels are issued back to back instead.
+
+  class SO3part_addCGproduct_backFn{
+  public:
+
+    void operator()(const SO3part3_view& _xg, const SO3part3_view& _yg, const SO3part3_view& _g,
+      const SO3part3_view& _x, const SO3part3_view& _y, const int _offs=0){
+      GELIB_NVTX_RANGE("CGproduct_back",_xg.getl(),_yg.getl(),_g.getl(),_g.n0);
+
+      const int l=_g.getl();
+      const int l1=_x.getl();
+      const int l2=_y.getl();
+
+      const int N1=_x.n2;
+      const int N2=_y.n2;
+      const int B=_x.n0;
+      const int dev=_g.dev;
+
+      CNINE_CHECK_DEV3(_xg,_g,_y);
+      CNINE_CHECK_BATCH3(_xg,_g,_y);
+      GELIB_CHECK((_offs+N1*N2<=_g.n2),"channel index out of range");
+      GELIB_CHECK((l>=abs(l1-l2) && l<=l1+l2),"l index out of range");
+
+      LoggedTimer timer("  CGproductBack("+to_string(l1)+","+to_string(l2)+","+to_string(l)+
+	")[b="+to_string(B)+",n1="+to_string(N1)+",n2="+to_string(N2)+",dev="+to_string(dev)+"]",
+	2*B*(2*l1+1)*(2*l2+1)*N1*N2);
+
+      if(dev==0){
+
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+	GElibMultiLoop(B,[&](const int b){
+	    SO3part2_view g=_g.slice0(b);
+	    SO3part2_view xg=_xg.slice0(b);
+	    SO3part2_view yg=_yg.slice0(b);
+	    SO3part2_view x=_x.slice0(b);
+	    SO3part2_view y=_y.slice0(b);
+	    int offs=_offs;
+	    for(int n1=0; n1<N1; n1++){
+	      for(auto& e:C.nonzeros){
+		const complex<float> xc=std::conj(x(e.m1-l1,n1));
+		complex<float> xacc=0;
+		for(int n2=0; n2<N2; n2++){
+		  const complex<float> t=e.c*g(e.m-l,offs+n2);
+		  xacc+=t*std::conj(y(e.m2-l2,n2));
+		  yg.inc(e.m2-l2,n2,t*xc);
+		}
+		xg.inc(e.m1-l1,n1,xacc);
+	      }
+	      offs+=N2;
+	    }
+	  });
+
+      }
+      else{
+	SO3part_addCGproduct_back0Fn()(_xg,_g,_y,_offs);
+	SO3part_addCGproduct_back1Fn()(_yg,_g,_x,_offs);
+      }
+
+    }
+
+  };
+
+}
+
+#endif
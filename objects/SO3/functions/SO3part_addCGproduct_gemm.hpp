@@ -0,0 +1,74 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3part_addCGproduct_gemm
+#define _SO3part_addCGproduct_gemm
+
+#include "GElib_base.hpp"
+#include "CtensorB.hpp"
+#include "SO3part3_view.hpp"
+#include "GElibThreadPool.hpp"
+
+
+namespace GElib{
+
+  // GEMM lowering of the Clebsch-Gordan product. The (m1,m2)->m
+  // contraction is recast as a single matrix product
+  //
+  //   R[m, n1*N2+n2] += Cmat[m, m1*M2+m2] * Z[m1*M2+m2, n1*N2+n2]
+  //
+  // where Z is the Kronecker product of the x and y channel blocks and
+  // Cmat is the CG table unrolled along its (m1,m2) indices. Forming Z
+  // costs the same number of multiplications as the scalar loop but is
+  // a dense streaming pass, and the contraction itself runs through the
+  // BLAS-backed Ctensor_add_mprod_AA. This wins once N1*N2 is large
+  // enough to amortize the Z materialization.
+
+  template<typename CMAT>
+  inline void SO3part_addCGproduct_gemm(const SO3part3_view& _r, const SO3part3_view& _x, const SO3part3_view& _y,
+    const CMAT& C, const int _offs){
+
+    const int l=_r.getl();
+    const int l1=_x.getl();
+    const int l2=_y.getl();
+    const int M1=2*l1+1;
+    const int M2=2*l2+1;
+    const int N1=_x.n2;
+    const int N2=_y.n2;
+    const int B=_x.n0;
+
+    cnine::CtensorB Cmat(cnine::Gdims(2*l+1,M1*M2),cnine::fill_zero(),0);
+    auto cv=Cmat.view2D();
+    for(auto& e:C.nonzeros)
+      cv.set(e.m,e.m1*M2+e.m2,complex<float>(e.c,0));
+
+    GElibMultiLoop(B,[&](const int b){
+	SO3part2_view x=_x.slice0(b);
+	SO3part2_view y=_y.slice0(b);
+
+	cnine::CtensorB Z(cnine::Gdims(M1*M2,N1*N2),cnine::fill_raw(),0);
+	auto zv=Z.view2D();
+	for(int m1=0; m1<M1; m1++)
+	  for(int n1=0; n1<N1; n1++){
+	    const complex<float> t=x(m1-l1,n1);
+	    for(int m2=0; m2<M2; m2++)
+	      for(int n2=0; n2<N2; n2++)
+		zv.set(m1*M2+m2,n1*N2+n2,t*y(m2-l2,n2));
+	  }
+
+	cnine::Ctensor2_view rv(_r.arr+b*_r.s0+_offs*_r.s2,_r.arrc+b*_r.s0+_offs*_r.s2,
+	  2*l+1,N1*N2,_r.s1,_r.s2,_r.dev);
+	cnine::Ctensor_add_mprod_AA()(rv,cv,zv);
+      });
+  }
+
+}
+
+#endif
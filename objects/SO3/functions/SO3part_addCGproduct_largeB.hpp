@@ -0,0 +1,164 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3part_addCGproduct_largeB
+#define _SO3part_addCGproduct_largeB
+
+#include "GElib_base.hpp"
+#include "SO3part3_view.hpp"
+#include "GElibThreadPool.hpp"
+#include "SO3part_addCGproduct_simd.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+
+namespace GElib{
+
+  // Streaming CPU kernel for the CG product at very large batch sizes.
+  // When B is in the tens of thousands the operands and the result
+  // stream through memory once and the per-slice CG working set (one x
+  // slice, one y slice, the coefficient list) is the only thing worth
+  // keeping cache-resident. The per-slice kernels above this size leave
+  // two kinds of bandwidth on the table: the output fragment is
+  // accumulated into with ordinary stores, so every result line is
+  // first read for ownership and then lingers in the cache evicting the
+  // operands, and the hardware prefetchers restart their stride
+  // detection at every slice boundary. This kernel therefore (a)
+  // issues software prefetches for the next batch slice of x and y
+  // while the current slice computes, and (b) accumulates the output
+  // fragment in a slice-sized thread-local scratch buffer and writes it
+  // to the result exactly once per slice with non-temporal stores,
+  // which go around the cache entirely. In overwrite mode the result is
+  // never read at all; in accumulate mode each line is read once, added
+  // to and streamed back out, so it still does not stay resident.
+  //
+  // Non-temporal stores only pay off when the lines will not be re-read
+  // soon, which is exactly the large-B regime: the gate in
+  // SO3part_addCGproductFn (SO3part_CGproduct_largeB_threshold) keeps
+  // small and medium batches on the cache-friendly kernels.
+
+
+#if defined(__x86_64__)
+
+  // Prefetch a whole upcoming slice into L2 (T1: the data is for the
+  // next slice, not the current inner loop, so L1 is left alone).
+  inline void SO3part_prefetch_slice(const float* p, const int floats){
+    for(int i=0; i<floats; i+=16)
+      _mm_prefetch((const char*)(p+i),_MM_HINT_T1);
+  }
+
+  // Non-temporal row copy. movntps needs 16-byte alignment, so the
+  // head and tail are peeled off as ordinary stores; the wider AVX
+  // variants buy nothing here because non-temporal traffic is bound by
+  // the write-combining buffers, not the store width.
+  inline void SO3part_stream_row(float* dst, const float* src, const int floats){
+    int i=0;
+    for(; i<floats && (((uintptr_t)(dst+i))&15); i++) dst[i]=src[i];
+    for(; i+4<=floats; i+=4)
+      _mm_stream_ps(dst+i,_mm_loadu_ps(src+i));
+    for(; i<floats; i++) dst[i]=src[i];
+  }
+
+  // Accumulating variant: each destination line is read once, added to
+  // and streamed back out, so it is evicted rather than kept resident.
+  inline void SO3part_stream_add_row(float* dst, const float* src, const int floats){
+    int i=0;
+    for(; i<floats && (((uintptr_t)(dst+i))&15); i++) dst[i]+=src[i];
+    for(; i+4<=floats; i+=4)
+      _mm_stream_ps(dst+i,_mm_add_ps(_mm_loadu_ps(dst+i),_mm_loadu_ps(src+i)));
+    for(; i<floats; i++) dst[i]+=src[i];
+  }
+
+  // Non-temporal stores are weakly ordered: fence once per slice so the
+  // results are globally visible before the thread pool join publishes
+  // them.
+  inline void SO3part_stream_fence(){
+    _mm_sfence();
+  }
+
+#else
+
+  inline void SO3part_prefetch_slice(const float* p, const int floats){
+    for(int i=0; i<floats; i+=16)
+      __builtin_prefetch(p+i,0,2);
+  }
+
+  inline void SO3part_stream_row(float* dst, const float* src, const int floats){
+    std::memcpy(dst,src,floats*sizeof(float));
+  }
+
+  inline void SO3part_stream_add_row(float* dst, const float* src, const int floats){
+    for(int i=0; i<floats; i++) dst[i]+=src[i];
+  }
+
+  inline void SO3part_stream_fence(){}
+
+#endif
+
+
+  // Returns false if the views do not have the regular interleaved
+  // layout, or if the per-slice scratch fragment would itself overflow
+  // the cache (in which case the blocked kernels are the better fit).
+  template<typename CMAT>
+  inline bool SO3part_addCGproduct_largeB(const SO3part3_view& _r, const SO3part3_view& _x, const SO3part3_view& _y,
+    const CMAT& C, const int _offs, const bool overwrite){
+
+    if(_r.s2!=2 || _x.s2!=2 || _y.s2!=2) return false;
+    if(_r.arrc!=_r.arr+1 || _x.arrc!=_x.arr+1 || _y.arrc!=_y.arr+1) return false;
+
+    const int l=_r.getl();
+    const int N1=_x.n2;
+    const int N2=_y.n2;
+    const int B=_x.n0;
+
+    const int frow=2*N1*N2;              // one m row of the fragment, in floats
+    const size_t fragment=((size_t)(2*l+1))*frow;
+    if(fragment>(1<<16)) return false;   // keep the scratch L2-resident
+
+    const int xslice=_x.n1*_x.s1;
+    const int yslice=_y.n1*_y.s1;
+
+    GElibMultiLoop(B,[&](const int b){
+	if(b+1<B){
+	  SO3part_prefetch_slice(_x.arr+(b+1)*_x.s0,xslice);
+	  SO3part_prefetch_slice(_y.arr+(b+1)*_y.s0,yslice);
+	}
+
+	static thread_local vector<float> scratch;
+	if((size_t)scratch.size()<fragment) scratch.resize(fragment);
+	std::memset(scratch.data(),0,fragment*sizeof(float));
+
+	SO3part2_view x=_x.slice0(b);
+	SO3part2_view y=_y.slice0(b);
+
+	for(int n1=0; n1<N1; n1++){
+	  for(auto& e:C.nonzeros){
+	    const float xr=x.arr[e.m1*x.s0+2*n1];
+	    const float xi=x.arr[e.m1*x.s0+2*n1+1];
+	    SO3part_cmadd(scratch.data()+e.m*frow+2*n1*N2,y.arr+e.m2*y.s0,e.c*xr,e.c*xi,N2);
+	  }
+	}
+
+	float* rbase=_r.arr+b*_r.s0+2*_offs;
+	for(int m=0; m<2*l+1; m++){
+	  if(overwrite) SO3part_stream_row(rbase+m*_r.s1,scratch.data()+m*frow,frow);
+	  else SO3part_stream_add_row(rbase+m*_r.s1,scratch.data()+m*frow,frow);
+	}
+	SO3part_stream_fence();
+      });
+
+    return true;
+  }
+
+}
+
+#endif
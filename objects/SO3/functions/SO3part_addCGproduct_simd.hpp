@@ -0,0 +1,367 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3part_addCGproduct_simd
+#define _SO3part_addCGproduct_simd
+
+#include "GElib_base.hpp"
+#include "SO3part2_view.hpp"
+
+#if defined(__x86_64__) && (defined(__AVX2__) || defined(__AVX512F__))
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_SVE)
+#include <arm_sve.h>
+#endif
+
+
+namespace GElib{
+
+  // Vectorized CPU kernels for the Clebsch-Gordan product. The kernels
+  // vectorize along the channel (n2) dimension of the views: a single
+  // coefficient C(m1,m2)*x(m1,n1) is broadcast against a contiguous run
+  // of complex entries of y and accumulated into r. Two layouts are
+  // handled: the regular interleaved layout (innermost stride 2,
+  // arrc=arr+1), where each step needs a lane shuffle to pair real and
+  // imaginary parts, and the planar split real/imag layout (innermost
+  // stride 1, see SO3part2_view::is_planar()), where the two planes
+  // are processed by plain contiguous loads and FMAs at the full SIMD
+  // width. The Fn classes fall back to the scalar loop for any other
+  // strides.
+  //
+  // This header is the abstraction point for the channel-broadcast
+  // vectorized CPU paths (CGproduct, RCGproduct and CGtransform all
+  // funnel through SO3part_cmadd and SO3part_cmadd_planar), so
+  // supporting a new ISA means adding one interleaved/planar kernel
+  // pair and two dispatch lines below, plus the weighted row kernels
+  // of the Fproduct family in SO3part_addFproduct_simd.hpp, which
+  // share the SO3part_simd_level() selector. AVX2, AVX-512 (x86, picked at
+  // runtime), NEON and SVE (aarch64, picked at compile time -- NEON is
+  // architectural and SVE implies the build targets it) are provided.
+
+
+  inline int SO3part_simd_level(){
+#if defined(__x86_64__) && (defined(__AVX2__) || defined(__AVX512F__))
+    static const int level=[](){
+#if defined(__AVX512F__)
+      if(__builtin_cpu_supports("avx512f")) return 2;
+#endif
+#if defined(__AVX2__)
+      if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return 1;
+#endif
+      return 0;
+    }();
+    return level;
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_SVE)
+    return 2;
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    return 1;
+#else
+    return 0;
+#endif
+  }
+
+
+#if defined(__x86_64__) && defined(__AVX2__)
+
+  // r[0..2n) += (cr,ci)*y[0..2n) on interleaved complex data, 4 complex
+  // entries per AVX2 step.
+  inline void SO3part_cmadd_avx2(float* r, const float* y, const float cr, const float ci, const int n){
+    const __m256 vcr=_mm256_set1_ps(cr);
+    const __m256 vci=_mm256_set1_ps(ci);
+    int i=0;
+    for(; i+8<=2*n; i+=8){
+      __m256 vy=_mm256_loadu_ps(y+i);
+      __m256 vys=_mm256_permute_ps(vy,0xB1);
+      __m256 t=_mm256_mul_ps(vys,vci);
+      __m256 p=_mm256_fmaddsub_ps(vy,vcr,t);
+      _mm256_storeu_ps(r+i,_mm256_add_ps(_mm256_loadu_ps(r+i),p));
+    }
+    for(; i<2*n; i+=2){
+      const float yr=y[i];
+      const float yi=y[i+1];
+      r[i]+=cr*yr-ci*yi;
+      r[i+1]+=cr*yi+ci*yr;
+    }
+  }
+
+#endif
+
+
+#if defined(__x86_64__) && defined(__AVX512F__)
+
+  // Same as the AVX2 kernel but 8 complex entries per step.
+  inline void SO3part_cmadd_avx512(float* r, const float* y, const float cr, const float ci, const int n){
+    const __m512 vcr=_mm512_set1_ps(cr);
+    const __m512 vci=_mm512_set1_ps(ci);
+    int i=0;
+    for(; i+16<=2*n; i+=16){
+      __m512 vy=_mm512_loadu_ps(y+i);
+      __m512 vys=_mm512_permute_ps(vy,0xB1);
+      __m512 t=_mm512_mul_ps(vys,vci);
+      __m512 p=_mm512_fmaddsub_ps(vy,vcr,t);
+      _mm512_storeu_ps(r+i,_mm512_add_ps(_mm512_loadu_ps(r+i),p));
+    }
+    for(; i<2*n; i+=2){
+      const float yr=y[i];
+      const float yi=y[i+1];
+      r[i]+=cr*yr-ci*yi;
+      r[i+1]+=cr*yi+ci*yr;
+    }
+  }
+
+#endif
+
+
+#if defined(__x86_64__) && defined(__AVX2__)
+
+  // Planar variant: rr/ri and yr/yi are separate contiguous real and
+  // imaginary planes, 8 complex entries per AVX2 step with no shuffles.
+  inline void SO3part_cmadd_planar_avx2(float* rr, float* ri, const float* yr, const float* yi,
+    const float cr, const float ci, const int n){
+    const __m256 vcr=_mm256_set1_ps(cr);
+    const __m256 vci=_mm256_set1_ps(ci);
+    int i=0;
+    for(; i+8<=n; i+=8){
+      __m256 vyr=_mm256_loadu_ps(yr+i);
+      __m256 vyi=_mm256_loadu_ps(yi+i);
+      __m256 tr=_mm256_fmsub_ps(vcr,vyr,_mm256_mul_ps(vci,vyi));
+      __m256 ti=_mm256_fmadd_ps(vcr,vyi,_mm256_mul_ps(vci,vyr));
+      _mm256_storeu_ps(rr+i,_mm256_add_ps(_mm256_loadu_ps(rr+i),tr));
+      _mm256_storeu_ps(ri+i,_mm256_add_ps(_mm256_loadu_ps(ri+i),ti));
+    }
+    for(; i<n; i++){
+      rr[i]+=cr*yr[i]-ci*yi[i];
+      ri[i]+=cr*yi[i]+ci*yr[i];
+    }
+  }
+
+#endif
+
+
+#if defined(__x86_64__) && defined(__AVX512F__)
+
+  // Same as the planar AVX2 kernel but 16 complex entries per step.
+  inline void SO3part_cmadd_planar_avx512(float* rr, float* ri, const float* yr, const float* yi,
+    const float cr, const float ci, const int n){
+    const __m512 vcr=_mm512_set1_ps(cr);
+    const __m512 vci=_mm512_set1_ps(ci);
+    int i=0;
+    for(; i+16<=n; i+=16){
+      __m512 vyr=_mm512_loadu_ps(yr+i);
+      __m512 vyi=_mm512_loadu_ps(yi+i);
+      __m512 tr=_mm512_fmsub_ps(vcr,vyr,_mm512_mul_ps(vci,vyi));
+      __m512 ti=_mm512_fmadd_ps(vcr,vyi,_mm512_mul_ps(vci,vyr));
+      _mm512_storeu_ps(rr+i,_mm512_add_ps(_mm512_loadu_ps(rr+i),tr));
+      _mm512_storeu_ps(ri+i,_mm512_add_ps(_mm512_loadu_ps(ri+i),ti));
+    }
+    for(; i<n; i++){
+      rr[i]+=cr*yr[i]-ci*yi[i];
+      ri[i]+=cr*yi[i]+ci*yr[i];
+    }
+  }
+
+#endif
+
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+
+  // NEON interleaved kernel, 4 complex entries per step: vld2
+  // deinterleaves the pairs into separate real/imaginary registers, so
+  // the arithmetic is the same as in the planar kernels.
+  inline void SO3part_cmadd_neon(float* r, const float* y, const float cr, const float ci, const int n){
+    const float32x4_t vcr=vdupq_n_f32(cr);
+    const float32x4_t vci=vdupq_n_f32(ci);
+    int i=0;
+    for(; i+8<=2*n; i+=8){
+      float32x4x2_t vy=vld2q_f32(y+i);
+      float32x4x2_t vr=vld2q_f32(r+i);
+      vr.val[0]=vfmaq_f32(vr.val[0],vcr,vy.val[0]);
+      vr.val[0]=vfmsq_f32(vr.val[0],vci,vy.val[1]);
+      vr.val[1]=vfmaq_f32(vr.val[1],vcr,vy.val[1]);
+      vr.val[1]=vfmaq_f32(vr.val[1],vci,vy.val[0]);
+      vst2q_f32(r+i,vr);
+    }
+    for(; i<2*n; i+=2){
+      const float yr=y[i];
+      const float yi=y[i+1];
+      r[i]+=cr*yr-ci*yi;
+      r[i+1]+=cr*yi+ci*yr;
+    }
+  }
+
+  // Planar NEON variant, contiguous loads and FMAs with no shuffles.
+  inline void SO3part_cmadd_planar_neon(float* rr, float* ri, const float* yr, const float* yi,
+    const float cr, const float ci, const int n){
+    const float32x4_t vcr=vdupq_n_f32(cr);
+    const float32x4_t vci=vdupq_n_f32(ci);
+    int i=0;
+    for(; i+4<=n; i+=4){
+      float32x4_t vyr=vld1q_f32(yr+i);
+      float32x4_t vyi=vld1q_f32(yi+i);
+      float32x4_t vrr=vld1q_f32(rr+i);
+      float32x4_t vri=vld1q_f32(ri+i);
+      vrr=vfmaq_f32(vrr,vcr,vyr);
+      vrr=vfmsq_f32(vrr,vci,vyi);
+      vri=vfmaq_f32(vri,vcr,vyi);
+      vri=vfmaq_f32(vri,vci,vyr);
+      vst1q_f32(rr+i,vrr);
+      vst1q_f32(ri+i,vri);
+    }
+    for(; i<n; i++){
+      rr[i]+=cr*yr[i]-ci*yi[i];
+      ri[i]+=cr*yi[i]+ci*yr[i];
+    }
+  }
+
+#endif
+
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_SVE)
+
+  // SVE interleaved kernel, vector-length agnostic: svld2
+  // deinterleaves and the whilelt predicate absorbs the tail, so there
+  // is no scalar remainder loop.
+  inline void SO3part_cmadd_sve(float* r, const float* y, const float cr, const float ci, const int n){
+    const svfloat32_t vcr=svdup_n_f32(cr);
+    const svfloat32_t vci=svdup_n_f32(ci);
+    const int w=(int)svcntw();
+    for(int i=0; i<n; i+=w){
+      const svbool_t pg=svwhilelt_b32_s32(i,n);
+      svfloat32x2_t vy=svld2_f32(pg,y+2*i);
+      svfloat32x2_t vr=svld2_f32(pg,r+2*i);
+      svfloat32_t rr=svget2_f32(vr,0);
+      svfloat32_t ri=svget2_f32(vr,1);
+      rr=svmla_f32_x(pg,rr,vcr,svget2_f32(vy,0));
+      rr=svmls_f32_x(pg,rr,vci,svget2_f32(vy,1));
+      ri=svmla_f32_x(pg,ri,vcr,svget2_f32(vy,1));
+      ri=svmla_f32_x(pg,ri,vci,svget2_f32(vy,0));
+      svst2_f32(pg,r+2*i,svcreate2_f32(rr,ri));
+    }
+  }
+
+  // Planar SVE variant.
+  inline void SO3part_cmadd_planar_sve(float* rr, float* ri, const float* yr, const float* yi,
+    const float cr, const float ci, const int n){
+    const svfloat32_t vcr=svdup_n_f32(cr);
+    const svfloat32_t vci=svdup_n_f32(ci);
+    const int w=(int)svcntw();
+    for(int i=0; i<n; i+=w){
+      const svbool_t pg=svwhilelt_b32_s32(i,n);
+      svfloat32_t vyr=svld1_f32(pg,yr+i);
+      svfloat32_t vyi=svld1_f32(pg,yi+i);
+      svfloat32_t vrr=svld1_f32(pg,rr+i);
+      svfloat32_t vri=svld1_f32(pg,ri+i);
+      vrr=svmla_f32_x(pg,vrr,vcr,vyr);
+      vrr=svmls_f32_x(pg,vrr,vci,vyi);
+      vri=svmla_f32_x(pg,vri,vcr,vyi);
+      vri=svmla_f32_x(pg,vri,vci,vyr);
+      svst1_f32(pg,rr+i,vrr);
+      svst1_f32(pg,ri+i,vri);
+    }
+  }
+
+#endif
+
+
+  inline void SO3part_cmadd_scalar(float* r, const float* y, const float cr, const float ci, const int n){
+    for(int i=0; i<2*n; i+=2){
+      const float yr=y[i];
+      const float yi=y[i+1];
+      r[i]+=cr*yr-ci*yi;
+      r[i+1]+=cr*yi+ci*yr;
+    }
+  }
+
+
+  inline void SO3part_cmadd(float* r, const float* y, const float cr, const float ci, const int n){
+#if defined(__x86_64__) && defined(__AVX512F__)
+    if(SO3part_simd_level()>=2){SO3part_cmadd_avx512(r,y,cr,ci,n); return;}
+#endif
+#if defined(__x86_64__) && defined(__AVX2__)
+    if(SO3part_simd_level()>=1){SO3part_cmadd_avx2(r,y,cr,ci,n); return;}
+#endif
+#if defined(__aarch64__) && defined(__ARM_FEATURE_SVE)
+    SO3part_cmadd_sve(r,y,cr,ci,n); return;
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+    SO3part_cmadd_neon(r,y,cr,ci,n); return;
+#endif
+    SO3part_cmadd_scalar(r,y,cr,ci,n);
+  }
+
+
+  inline void SO3part_cmadd_planar(float* rr, float* ri, const float* yr, const float* yi,
+    const float cr, const float ci, const int n){
+#if defined(__x86_64__) && defined(__AVX512F__)
+    if(SO3part_simd_level()>=2){SO3part_cmadd_planar_avx512(rr,ri,yr,yi,cr,ci,n); return;}
+#endif
+#if defined(__x86_64__) && defined(__AVX2__)
+    if(SO3part_simd_level()>=1){SO3part_cmadd_planar_avx2(rr,ri,yr,yi,cr,ci,n); return;}
+#endif
+#if defined(__aarch64__) && defined(__ARM_FEATURE_SVE)
+    SO3part_cmadd_planar_sve(rr,ri,yr,yi,cr,ci,n); return;
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+    SO3part_cmadd_planar_neon(rr,ri,yr,yi,cr,ci,n); return;
+#endif
+    for(int i=0; i<n; i++){
+      rr[i]+=cr*yr[i]-ci*yi[i];
+      ri[i]+=cr*yi[i]+ci*yr[i];
+    }
+  }
+
+
+  // Returns false if the views have neither the regular interleaved
+  // layout nor the planar layout that the vectorized kernels handle.
+  template<typename CMAT>
+  inline bool SO3part_addCGproduct_simd(const SO3part2_view& r, const SO3part2_view& x, const SO3part2_view& y,
+    const CMAT& C, const int _offs){
+
+    const int N1=x.n1;
+    const int N2=y.n1;
+
+    if(r.is_planar() && x.is_planar() && y.is_planar()){
+      int offs=_offs;
+      for(int n1=0; n1<N1; n1++){
+	for(auto& e:C.nonzeros){
+	  const float xr=x.arr[e.m1*x.s0+n1];
+	  const float xi=x.arrc[e.m1*x.s0+n1];
+	  SO3part_cmadd_planar(r.arr+e.m*r.s0+offs,r.arrc+e.m*r.s0+offs,
+	    y.arr+e.m2*y.s0,y.arrc+e.m2*y.s0,e.c*xr,e.c*xi,N2);
+	}
+	offs+=N2;
+      }
+      return true;
+    }
+
+    if(r.s1!=2 || x.s1!=2 || y.s1!=2) return false;
+    if(r.arrc!=r.arr+1 || x.arrc!=x.arr+1 || y.arrc!=y.arr+1) return false;
+
+    int offs=_offs;
+    for(int n1=0; n1<N1; n1++){
+      for(auto& e:C.nonzeros){
+	const float xr=x.arr[e.m1*x.s0+2*n1];
+	const float xi=x.arr[e.m1*x.s0+2*n1+1];
+	SO3part_cmadd(r.arr+e.m*r.s0+2*offs,y.arr+e.m2*y.s0,e.c*xr,e.c*xi,N2);
+      }
+      offs+=N2;
+    }
+    return true;
+  }
+
+}
+
+#endif
@@ -0,0 +1,120 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3part_addCGproduct_smallFn
+#define _SO3part_addCGproduct_smallFn
+
+#include "GElib_base.hpp"
+#include "GElibFnTemplates.hpp"
+#include "SO3part2_view.hpp"
+
+
+namespace GElib{
+
+  // Compile-time CG coefficient tables for small l. For l1,l2<=3 the
+  // tables are tiny and fixed, so they are evaluated as constexpr arrays
+  // baked into the binary: the specialized kernels below carry their
+  // coefficients as immediates with fully static loop bounds, letting
+  // the compiler unroll and vectorize the m-loops completely and
+  // bypassing the hash/lock/map path through SO3_CGbank.
+
+
+  constexpr double SO3_cgfact(const int n){
+    double r=1;
+    for(int i=2; i<=n; i++) r*=i;
+    return r;
+  }
+
+  constexpr double SO3_cgsqrt(const double x){
+    double g=x>1? x : 1;
+    for(int i=0; i<64; i++) g=(g+x/g)/2;
+    return g;
+  }
+
+  constexpr double SO3_cgplusminus(const int k){
+    return ((k%2+2)%2==1)? -1 : 1;
+  }
+
+  // constexpr port of SO3_CGcoeffs::slowCG, with plain factorials in
+  // place of lgamma (exact in double for the l<=6 range this is used in).
+  constexpr double SO3_cgcoeff(const int l1, const int l2, const int l, const int m1, const int m2){
+    const int m=m1+m2;
+    if(m<-l || m>l) return 0;
+    const int m3=-m;
+    const int t1=l2-m1-l;
+    const int t2=l1+m2-l;
+    const int t3=l1+l2-l;
+    const int t4=l1-m1;
+    const int t5=l2+m2;
+
+    const int tmin=std::max(0,std::max(t1,t2));
+    const int tmax=std::min(t3,std::min(t4,t5));
+
+    const double A=SO3_cgsqrt(SO3_cgfact(l1+l2-l)*SO3_cgfact(l1-l2+l)*SO3_cgfact(-l1+l2+l)/SO3_cgfact(l1+l2+l+1))*
+      SO3_cgsqrt(SO3_cgfact(l1+m1)*SO3_cgfact(l1-m1)*SO3_cgfact(l2+m2)*SO3_cgfact(l2-m2)*SO3_cgfact(l+m3)*SO3_cgfact(l-m3));
+
+    double wigner=0;
+    for(int t=tmin; t<=tmax; t++){
+      const double B=SO3_cgfact(t)*SO3_cgfact(t-t1)*SO3_cgfact(t-t2)*SO3_cgfact(t3-t)*SO3_cgfact(t4-t)*SO3_cgfact(t5-t);
+      wigner+=SO3_cgplusminus(t)*A/B;
+    }
+
+    return SO3_cgplusminus(l1-l2-m3)*SO3_cgplusminus(l1-l2+m)*SO3_cgsqrt(2*l+1)*wigner;
+  }
+
+
+  template<int L1, int L2, int L>
+  struct SO3_smallCGtable{
+    float c[2*L1+1][2*L2+1]={};
+    constexpr SO3_smallCGtable(){
+      for(int m1=-L1; m1<=L1; m1++)
+	for(int m2=std::max(-L2,-L-m1); m2<=std::min(L2,L-m1); m2++)
+	  c[m1+L1][m2+L2]=(float)SO3_cgcoeff(L1,L2,L,m1,m2);
+    }
+  };
+
+
+  template<int L1, int L2, int L>
+  class SO3part_addCGproduct_smallFn{
+  public:
+
+    void operator()(const SO3part2_view& r, const SO3part2_view& x, const SO3part2_view& y, const int _offs=0){
+      static constexpr SO3_smallCGtable<L1,L2,L> C{};
+      const int N1=x.n1;
+      const int N2=y.n1;
+
+      int offs=_offs;
+      for(int n1=0; n1<N1; n1++){
+	for(int m1=0; m1<2*L1+1; m1++){
+	  const complex<float> xv=x(m1-L1,n1);
+	  for(int m2=0; m2<2*L2+1; m2++){
+	    if(C.c[m1][m2]==0) continue;
+	    const complex<float> t=C.c[m1][m2]*xv;
+	    for(int n2=0; n2<N2; n2++)
+	      r.inc(m1+m2-L1-L2,offs+n2,t*y(m2-L2,n2));
+	  }
+	}
+	offs+=N2;
+      }
+    }
+
+  };
+
+
+  // Runtime (l1,l2,l) -> compile-time kernel dispatch; returns false for
+  // shapes outside the specialized range.
+  inline bool SO3part_addCGproduct_small(const int l1, const int l2, const int l,
+    const SO3part2_view& r, const SO3part2_view& x, const SO3part2_view& y, const int offs=0){
+    return dispatch_small_l<SO3part_addCGproduct_smallFn>(l1,l2,l,r,x,y,offs);
+  }
+
+}
+
+#endif
@@ -14,7 +14,8 @@
 #include "GElib_base.hpp"
 #include "CtensorB.hpp"
 #include "SO3part3_view.hpp"
-#include "MultiLoop.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibNvtx.hpp"
 
 extern GElib::SO3_CGbank SO3_cgbank;
 extern GElib::SO3_SPHgen SO3_sphGen;
@@ -32,6 +33,7 @@ namespace GElib{
   public:
 
     void operator()(const SO3part3_view& _r, const SO3part3_view& _x, const int _offs=0){
+      GELIB_NVTX_RANGE("CGsquare",_x.getl(),_x.getl(),_r.getl(),_x.n0);
 
       const int l=_r.getl(); 
       const int l1=_x.getl(); 
@@ -49,18 +51,30 @@ namespace GElib{
 
       if(dev==0){
 
-	auto& C=SO3_cgbank.getf(CGindex(l1,l1,l));
-	cnine::MultiLoop(B,[&](const int b){
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l1,l));
+
+	// For x==y the table obeys C(m2,m1)=(-1)^l C(m1,m2), so only the
+	// upper triangle of the (m1,m2) space is iterated and each entry
+	// serves both orderings. The diagonal m1==m2 entries vanish for
+	// odd l and are filtered out with everything else that is zero.
+	const float parity=(l%2==0)? 1 : -1;
+	vector<SO3_CGnonzero<float> > upper;
+	for(auto& e:C.nonzeros)
+	  if(e.m1<=e.m2) upper.push_back(e);
+
+	GElibMultiLoop(B,[&](const int b){
 	    SO3part2_view r=_r.slice0(b);
 	    SO3part2_view x=_x.slice0(b);
 	    int offs=_offs;
-	    
+
 	    for(int n1=0; n1<N1; n1++){
 	      for(int n2=0; n2<n1+diag; n2++){
-		for(int m1=-l1; m1<=l1; m1++){
-		  for(int m2=std::max(-l1,-l-m1); m2<=std::min(l1,l-m1); m2++){
-		    r.inc(m1+m2,offs+n2,C(m1+l1,m2+l1)*x(m1,n1)*x(m2,n2));
+		for(auto& e:upper){
+		  if(e.m1==e.m2){
+		    r.inc(e.m-l,offs+n2,e.c*x(e.m1-l1,n1)*x(e.m1-l1,n2));
+		    continue;
 		  }
+		  r.inc(e.m-l,offs+n2,e.c*(x(e.m1-l1,n1)*x(e.m2-l1,n2)+parity*x(e.m2-l1,n1)*x(e.m1-l1,n2)));
 		}
 	      }
 	      offs+=n1+diag;
@@ -1,6 +1,6 @@
 // This file is part of GElib, a C++/CUDA library for group
-// equivariant tensor operations. 
-// 
+// equivariant tensor operations.
+//
 // Copyright (c) 2023, Imre Risi Kondor
 //
 // This Source Code Form is subject to the terms of the Mozilla
@@ -15,7 +15,9 @@
 //#include "CtensorB.hpp"
 #include "SO3part3_view.hpp"
 #include "Ctensor4_view.hpp"
-#include "MultiLoop.hpp"
+#include "SO3part_addCGproduct_simd.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibNvtx.hpp"
 
 extern GElib::SO3_CGbank SO3_cgbank;
 extern GElib::SO3_SPHgen SO3_sphGen;
@@ -24,10 +26,8 @@ extern GElib::SO3_SPHgen SO3_sphGen;
 namespace GElib{
 
   #ifdef _WITH_CUDA
-  //void SO3partB_addCGproduct_cu(cnine::Ctensor3_view r, const cnine::Ctensor3_view& x, const cnine::Ctensor3_view& y, 
-  //const int offs, const cudaStream_t& stream);
-  //void SO3partB_addDiagCGproduct_cu(cnine::Ctensor3_view r, const cnine::Ctensor3_view& x, const cnine::Ctensor3_view& y, 
-  //const int offs, const cudaStream_t& stream);
+  void SO3part_addCGtransform_back_cu(cnine::Ctensor4_view x, cnine::Ctensor3_view r,
+    const int offs, const cudaStream_t& stream);
   #endif
 
 
@@ -35,33 +35,54 @@ namespace GElib{
   public:
 
 
-    void operator()(const Ctensor4_view& _x, const cnine::SO3part3_view& _x, const int offs=0){
+    void operator()(const cnine::Ctensor4_view& _x, const SO3part3_view& _r, const int offs=0){
+      GELIB_NVTX_RANGE("CGtransform_back");
 
-      const int l=_r.getl(); 
-      const int l1=(_x.n1-1)/2; 
-      const int l2=(_x.n2-1)/2; 
+      const int l=_r.getl();
+      const int l1=(_x.n1-1)/2;
+      const int l2=(_x.n2-1)/2;
       const int N=_x.n3;
       const int B=_x.n0;
       const int dev=_r.dev;
 
       CNINE_CHECK_DEV2(_r,_x);
       CNINE_CHECK_BATCH2(_r,_x);
-      CNINE_ASSRT(r.n2==N);
+      GELIB_ASSRT(l<=l1+l2 && l>=std::abs(l1-l2));
 
       if(dev==0){
 
-	auto& C=SO3_cgbank.getf(CGindex(l1,l2,l));
-	cnine::MultiLoop(B,[&](const int b){
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+	GElibMultiLoop(B,[&](const int b){
 	    cnine::Ctensor2_view r=_r.slice0(b);
 	    cnine::Ctensor3_view x=_x.slice0(b);
+
+	    // Mirror of the forward fast path: each nonzero broadcasts a
+	    // row of the gradient into one (m1,m2) cell of x as a
+	    // vectorized real-coefficient axpy over the channels.
+	    if(r.s1==1 && x.s2==1){
+	      for(auto& nz: C.nonzeros)
+		SO3part_cmadd_planar(x.arr+nz.m1*x.s0+nz.m2*x.s1,x.arrc+nz.m1*x.s0+nz.m2*x.s1,
+		  r.arr+nz.m*r.s0+offs,r.arrc+nz.m*r.s0+offs,nz.c,0,N);
+	      return;
+	    }
+	    if(r.s1==2 && r.arrc==r.arr+1 && x.s2==2 && x.arrc==x.arr+1){
+	      for(auto& nz: C.nonzeros)
+		SO3part_cmadd(x.arr+nz.m1*x.s0+nz.m2*x.s1,
+		  r.arr+nz.m*r.s0+2*offs,nz.c,0,N);
+	      return;
+	    }
+
 	    for(int i=0; i<N; i++)
-	      for(int m1=-l1; m1<l1; m1++)
+	      for(int m1=-l1; m1<=l1; m1++)
 		for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++)
 		  x.inc(m1+l1,m2+l2,i,C(m1+l1,m2+l2)*r(m1+m2+l,offs+i));
 	  });
-	  
-      }
 
+      }else{
+	#ifdef _WITH_CUDA
+	CUDA_STREAM(SO3part_addCGtransform_back_cu(_x,_r,offs,stream));
+	#endif
+      }
 
     }
 
@@ -69,4 +90,4 @@ namespace GElib{
 
 }
 
-#endif 
+#endif
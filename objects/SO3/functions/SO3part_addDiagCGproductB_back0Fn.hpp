@@ -15,8 +15,9 @@
 #include "CtensorB.hpp"
 #include "SO3part3_view.hpp"
 #include "SO3part4_view.hpp"
-#include "MultiLoop.hpp"
+#include "GElibThreadPool.hpp"
 #include "GElibTimer.hpp"
+#include "GElibNvtx.hpp"
 
 extern GElib::SO3_CGbank SO3_cgbank;
 extern GElib::SO3_SPHgen SO3_sphGen;
@@ -36,6 +37,7 @@ namespace GElib{
   public:
 
     void operator()(const SO3part3_view& _x, const SO3part3_view& _r, const SO3part3_view& _y, const int _offs=0){
+      GELIB_NVTX_RANGE("DiagCGproductB_back0",_x.getl(),_y.getl(),_r.getl(),_r.n0);
 
       const int l=_r.getl(); 
       const int l1=_x.getl(); 
@@ -51,8 +53,8 @@ namespace GElib{
       assert(_x.n2==_y.n2);
 
       if(dev==0){
-	auto& C=SO3_cgbank.getf(CGindex(l1,l2,l));
-	cnine::MultiLoop(B,[&](const int b){
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+	GElibMultiLoop(B,[&](const int b){
 	    SO3part2_view r=_r.slice0(b);
 	    SO3part2_view x=_x.slice0(b);
 	    SO3part2_view y=_y.slice0(b);
@@ -70,7 +72,7 @@ namespace GElib{
 #ifdef _WITH_CUDA
 	cudaStream_t stream;
 	CUDA_SAFE(cudaStreamCreate(&stream));
-	auto& C=SO3_cgbank.getf(CGindex(l1,l2,l));
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
 	for(int m1=-l1; m1<=l1; m1++){
 	  for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++){
 	    cnine::Ctensor2_view r(_r.arr+_r.s1*(m1+m2+l)+_offs*_r.s2,_r.arrc+_r.s1*(m1+m2+l)+_offs*_r.s2,
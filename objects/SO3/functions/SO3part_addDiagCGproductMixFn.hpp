@@ -0,0 +1,91 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3part_addDiagCGproductMixFn
+#define _SO3part_addDiagCGproductMixFn
+
+#include "GElib_base.hpp"
+#include "CtensorB.hpp"
+#include "SO3part3_view.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibNvtx.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+
+
+namespace GElib{
+
+  // Fused DiagCGproduct + channel mix: r[:,offs:offs+nout] += (x <> y) w
+  // in one pass per cell, where <> is the diagonal CG product and w is
+  // an N x nout complex weight matrix. Run separately, the two steps
+  // are full-array passes with a materialized intermediate the size of
+  // the whole product; here the (2l+1) x N product fragment of each
+  // cell lives in a small stack-side buffer and is consumed by the mix
+  // while still in L1, which is the dominant two-pass chain in
+  // Cormorant-style models. CPU only -- on the device the array-level
+  // wrapper falls back to the unfused pair.
+
+  class SO3part_addDiagCGproductMixFn{
+  public:
+
+    void operator()(const SO3part3_view& _r, const SO3part3_view& _x, const SO3part3_view& _y,
+      const cnine::Ctensor2_view& _w, const int _offs=0){
+      GELIB_NVTX_RANGE("DiagCGproduct_mix",_x.getl(),_y.getl(),_r.getl(),_x.n0);
+
+      const int l=_r.getl();
+      const int l1=_x.getl();
+      const int l2=_y.getl();
+
+      const int N=_x.n2;
+      const int nout=_w.n1;
+      const int B=_x.n0;
+
+      CNINE_CHECK_DEV3(_r,_x,_y)
+      CNINE_CHECK_BATCH3(_r,_x,_y)
+      GELIB_CHECK(_r.dev==0,"SO3part_addDiagCGproductMixFn is CPU only");
+      assert(l>=abs(l1-l2) && l<=l1+l2);
+      assert(_x.n2==_y.n2);
+      GELIB_ASSRT(_w.n0==N);
+      GELIB_ASSRT(_offs+nout<=_r.n2);
+
+      auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+      cnine::Ctensor2_view w=_w;
+
+      GElibMultiLoop(B,[&](const int b){
+	  SO3part2_view r=_r.slice0(b);
+	  SO3part2_view x=_x.slice0(b);
+	  SO3part2_view y=_y.slice0(b);
+
+	  vector<complex<float> > t((2*l+1)*N,complex<float>(0));
+
+	  for(int m1=-l1; m1<=l1; m1++){
+	    for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++){
+	      const float c=C(m1+l1,m2+l2);
+	      for(int n=0; n<N; n++)
+		t[(m1+m2+l)*N+n]+=c*x(m1,n)*y(m2,n);
+	    }
+	  }
+
+	  for(int m=-l; m<=l; m++){
+	    for(int j=0; j<nout; j++){
+	      complex<float> s=0;
+	      for(int n=0; n<N; n++)
+		s+=t[(m+l)*N+n]*w(n,j);
+	      r.inc(m,_offs+j,s);
+	    }
+	  }
+	});
+    }
+
+  };
+
+}
+
+#endif
@@ -14,7 +14,11 @@
 #include "GElib_base.hpp"
 #include "CtensorB.hpp"
 #include "SO3Fpart2_view.hpp"
+#include "SO3part_addFproduct_simd.hpp"
 #include "Ctensor3_view.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibOpStats.hpp"
+#include "GElibNvtx.hpp"
 
 extern GElib::SO3_CGbank SO3_cgbank;
 extern GElib::SO3_SPHgen SO3_sphGen;
@@ -34,12 +38,34 @@ namespace GElib{
     int conj=0;
     int method=0;
 
+    // When set, x and y are assumed to carry the conjugate symmetry of
+    // real-valued signals, F(-m,-m')=(-1)^(m-m') conj(F(m,m')) (see
+    // SO3part_addFFT_real_Fn). The product of real functions is again
+    // real, so only the non-redundant half of r is computed and the
+    // other half is filled in by the symmetry, halving the work of the
+    // quadruple loop.
+    int real_sym=0;
+
+    // Effective bandlimits for truncated products: when set to a
+    // nonnegative value, coefficients of x with |m|>xlimit (likewise y
+    // with ylimit) are treated as zero, and output coefficients with
+    // |m|>rlimit are not computed. In our correlation workloads most
+    // spectral energy lives at low m, so truncating to the effective
+    // bandwidth skips the blocks that contribute nothing; use
+    // SO3Fpart_effective_bandlimit to derive a limit from an energy
+    // threshold. The GPU kernels do not take the limits yet and
+    // compute the full product.
+    int xlimit=-1;
+    int ylimit=-1;
+    int rlimit=-1;
+
     SO3part_addFproduct_Fn(){}
     SO3part_addFproduct_Fn(const int _conj, const int _method=0): conj(_conj), method(_method){}
 
   public:
 
     void operator()(const cnine::Ctensor3_view& _r, const cnine::Ctensor3_view& _x, const cnine::Ctensor3_view& _y){
+      GELIB_NVTX_RANGE("Fproduct",(_x.n1-1)/2,(_y.n1-1)/2,(_r.n1-1)/2,_r.n0);
 
       const int l=(_r.n1-1)/2; //_r.getl(); 
       const int l1=(_x.n1-1)/2; //_x.getl(); 
@@ -51,20 +77,60 @@ namespace GElib{
       CNINE_CHECK_BATCH3(_r,_x,_y)
       assert(l>=abs(l1-l2) && l<=l1+l2);
 
-      auto& C=SO3_cgbank.getf(CGindex(l1,l2,l));
+      auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
       const float c=((2.0*l1+1)*(2.0*l2+1))/(2.0*l+1);
 
+      // Effective loop bounds after truncation; the CG coefficients are
+      // still those of the full (l1,l2,l) triple.
+      const int L1=(xlimit>=0 && xlimit<l1)? xlimit : l1;
+      const int L2=(ylimit>=0 && ylimit<l2)? ylimit : l2;
+      const int Lr=(rlimit>=0 && rlimit<l)? rlimit : l;
+
+      gelib_op_stats.count(GElibOpStats::Fproduct,
+	((long)B)*(2*L1+1)*(2*L1+1)*(2*L2+1)*(2*L2+1),
+	8l*B*(_x.n1*_x.n2+_y.n1*_y.n2+_r.n1*_r.n2));
+
       if(dev==0)
-	cnine::MultiLoop(B,[&](const int b){
+	GElibMultiLoop(B,[&](const int b){
 	    SO3Fpart2_view r=_r.slice0(b);
 	    SO3Fpart2_view x=_x.slice0(b);
 	    SO3Fpart2_view y=_y.slice0(b);
+	    if(real_sym && conj%2==0){
+	      // Accumulate only the terms landing on M>0, or M=0 with
+	      // m>=0, into local scratch; the (-M,-m) half of this
+	      // call's contribution is its conjugate image.
+	      const int L=2*l+1;
+	      vector<complex<float> > acc(((size_t)L)*L,complex<float>(0));
+	      for(int M1=-L1; M1<=L1; M1++){
+		for(int M2=std::max({-L2,-Lr-M1,-M1}); M2<=std::min(L2,Lr-M1); M2++){
+		  const int M=M1+M2;
+		  float t=C(M1+l1,M2+l2)*c;
+		  for(int m1=-L1; m1<=L1; m1++){
+		    for(int m2=std::max(-L2,-Lr-m1); m2<=std::min(L2,Lr-m1); m2++){
+		      if(M==0 && m1+m2<0) continue;
+		      acc[(M+l)*L+(m1+m2+l)]+=t*C(m1+l1,m2+l2)*x(M1,m1)*y(M2,m2);
+		    }
+		  }
+		}
+	      }
+	      for(int M=0; M<=Lr; M++)
+		for(int m=(M==0? 0:-Lr); m<=Lr; m++){
+		  const complex<float> v=acc[(M+l)*L+(m+l)];
+		  r.inc(M,m,v);
+		  if(M>0 || m>0){
+		    const float s=1-2*(((M-m)%2+2)%2);
+		    r.inc(-M,-m,s*std::conj(v));
+		  }
+		}
+	      return;
+	    }
+	    if(SO3Fpart_addFproduct_simd(r,x,y,C,c,L1,L2,Lr,conj)) return;
 	    if(conj%2==0){
-	      for(int M1=-l1; M1<=l1; M1++){
-		for(int M2=std::max(-l2,-l-M1); M2<=std::min(l2,l-M1); M2++){
+	      for(int M1=-L1; M1<=L1; M1++){
+		for(int M2=std::max(-L2,-Lr-M1); M2<=std::min(L2,Lr-M1); M2++){
 		  float t=C(M1+l1,M2+l2)*c;
-		  for(int m1=-l1; m1<=l1; m1++){
-		    for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++){
+		  for(int m1=-L1; m1<=L1; m1++){
+		    for(int m2=std::max(-L2,-Lr-m1); m2<=std::min(L2,Lr-m1); m2++){
 		      //cout<<"   "<<n1<<" "<<n2<<" "<<m1<<" "<<m2<<endl;
 		      r.inc(M1+M2,m1+m2,t*C(m1+l1,m2+l2)*x(M1,m1)*y(M2,m2));
 		    }
@@ -72,11 +138,11 @@ namespace GElib{
 		}
 	      }
 	    }else{
-	      for(int M1=-l1; M1<=l1; M1++){
-		for(int M2=std::max(-l2,-l-M1); M2<=std::min(l2,l-M1); M2++){
+	      for(int M1=-L1; M1<=L1; M1++){
+		for(int M2=std::max(-L2,-Lr-M1); M2<=std::min(L2,Lr-M1); M2++){
 		  float t=C(M1+l1,M2+l2)*c;
-		  for(int m1=-l1; m1<=l1; m1++){
-		    for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++){
+		  for(int m1=-L1; m1<=L1; m1++){
+		    for(int m2=std::max(-L2,-Lr-m1); m2<=std::min(L2,Lr-m1); m2++){
 		      r.inc(M1+M2,m1+m2,t*C(m1+l1,m2+l2)*x(M1,m1)*std::conj(y(M2,m2)));
 		    }
 		  }
@@ -88,10 +154,39 @@ namespace GElib{
 	CUDA_STREAM(SO3Fpart_addFproduct_cu(_r,_x,_y,conj,method,stream));
       }
     }
-    
+
   };
 
 
+  // Smallest L such that the coefficients of x outside the centered
+  // (2L+1)x(2L+1) block carry at most a thresh fraction of the total
+  // spectral energy, maximized over the batch. Feed the result into
+  // the xlimit/ylimit/rlimit fields above to truncate products to the
+  // bandwidth the data actually uses.
+  inline int SO3Fpart_effective_bandlimit(const cnine::Ctensor3_view& _x, const float thresh){
+    GELIB_ASSRT(_x.dev==0);
+    const int l=(_x.n1-1)/2;
+    const int B=_x.n0;
+    int r=0;
+    for(int b=0; b<B; b++){
+      SO3Fpart2_view x=const_cast<cnine::Ctensor3_view&>(_x).slice0(b);
+      vector<double> shell(l+1,0);
+      double total=0;
+      for(int M=-l; M<=l; M++)
+	for(int m=-l; m<=l; m++){
+	  const double e=std::norm(x(M,m));
+	  shell[std::max(std::abs(M),std::abs(m))]+=e;
+	  total+=e;
+	}
+      double tail=0;
+      int L=l;
+      while(L>0 && tail+shell[L]<=thresh*total){tail+=shell[L]; L--;}
+      r=std::max(r,L);
+    }
+    return r;
+  }
+
+
 }
 
 #endif
@@ -14,7 +14,10 @@
 #include "GElib_base.hpp"
 #include "CtensorB.hpp"
 #include "SO3Fpart2_view.hpp"
+#include "SO3part_addFproduct_simd.hpp"
 #include "Ctensor3_view.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibNvtx.hpp"
 
 extern GElib::SO3_CGbank SO3_cgbank;
 extern GElib::SO3_SPHgen SO3_sphGen;
@@ -34,6 +37,12 @@ namespace GElib{
     int conj=0;
     int method=0;
 
+    // Effective bandlimits for truncated products, matching the limits
+    // used in the forward call; see SO3part_addFproduct_Fn.
+    int xlimit=-1;
+    int ylimit=-1;
+    int rlimit=-1;
+
     SO3part_addFproduct_back1Fn(){}
     SO3part_addFproduct_back1Fn(const int _conj, const int _method=0): conj(_conj), method(_method){}
 
@@ -41,6 +50,7 @@ namespace GElib{
   public:
 
     void operator()(const cnine::Ctensor3_view& _yg, const cnine::Ctensor3_view& _g, const cnine::Ctensor3_view& _x){
+      GELIB_NVTX_RANGE("Fproduct_back1",(_x.n1-1)/2,(_yg.n1-1)/2,(_g.n1-1)/2,_g.n0);
 
       const int l=(_g.n1-1)/2;
       const int l1=(_x.n1-1)/2; 
@@ -52,31 +62,38 @@ namespace GElib{
       CNINE_CHECK_BATCH3(_g,_x,_yg)
       assert(l>=abs(l1-l2) && l<=l1+l2);
 
-      auto& C=SO3_cgbank.getf(CGindex(l1,l2,l));
+      auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
       const float c=((2.0*l1+1)*(2.0*l2+1))/(2.0*l+1);
 
+      // Effective loop bounds after truncation; the CG coefficients are
+      // still those of the full (l1,l2,l) triple.
+      const int L1=(xlimit>=0 && xlimit<l1)? xlimit : l1;
+      const int L2=(ylimit>=0 && ylimit<l2)? ylimit : l2;
+      const int Lr=(rlimit>=0 && rlimit<l)? rlimit : l;
+
       if(dev==0)
-	cnine::MultiLoop(B,[&](const int b){
+	GElibMultiLoop(B,[&](const int b){
 	    SO3Fpart2_view g=_g.slice0(b);
 	    SO3Fpart2_view x=_x.slice0(b);
 	    SO3Fpart2_view yg=_yg.slice0(b);
+	    if(SO3Fpart_addFproduct_back1_simd(yg,g,x,C,c,L1,L2,Lr,conj)) return;
 	    if(conj%2==0){
-	      for(int M1=-l1; M1<=l1; M1++){
-		for(int M2=std::max(-l2,-l-M1); M2<=std::min(l2,l-M1); M2++){
+	      for(int M1=-L1; M1<=L1; M1++){
+		for(int M2=std::max(-L2,-Lr-M1); M2<=std::min(L2,Lr-M1); M2++){
 		  float t=C(M1+l1,M2+l2)*c;
-		  for(int m1=-l1; m1<=l1; m1++){
-		    for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++){
+		  for(int m1=-L1; m1<=L1; m1++){
+		    for(int m2=std::max(-L2,-Lr-m1); m2<=std::min(L2,Lr-m1); m2++){
 		      yg.inc(M2,m2,t*C(m1+l1,m2+l2)*g(M1+M2,m1+m2)*std::conj(x(M1,m1)));
 		    }
 		  }
 		}
 	      }
 	    }else{
-	      for(int M1=-l1; M1<=l1; M1++){
-		for(int M2=std::max(-l2,-l-M1); M2<=std::min(l2,l-M1); M2++){
+	      for(int M1=-L1; M1<=L1; M1++){
+		for(int M2=std::max(-L2,-Lr-M1); M2<=std::min(L2,Lr-M1); M2++){
 		  float t=C(M1+l1,M2+l2)*c;
-		  for(int m1=-l1; m1<=l1; m1++){
-		    for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++){
+		  for(int m1=-L1; m1<=L1; m1++){
+		    for(int m2=std::max(-L2,-Lr-m1); m2<=std::min(L2,Lr-m1); m2++){
 		      yg.inc(M2,m2,std::conj(t*C(m1+l1,m2+l2)*g(M1+M2,m1+m2)*std::conj(x(M1,m1))));
 		    }
 		  }
@@ -0,0 +1,404 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3part_addFproduct_simd
+#define _SO3part_addFproduct_simd
+
+#include "GElib_base.hpp"
+#include "SO3Fpart2_view.hpp"
+#include "SO3part_addCGproduct_simd.hpp"
+
+
+namespace GElib{
+
+  // Vectorized CPU kernels for the Fproduct family. Unlike the
+  // CGproduct kernels, which broadcast a single coefficient against a
+  // run of channels, here the vector axis is the m' Fourier index
+  // itself: for fixed (M,M',m) the inner m' loop advances the output
+  // column, the second operand's column and the CG coefficient in
+  // lockstep, the coefficient row being contiguous in the dense
+  // coefficient table. So the primitives below carry a per-lane real
+  // weight: row_cmadd accumulates w[k]*a*y[k] into an output row
+  // (forward and back1), and row_cdot reduces w[k]*g[k]*y[k] to a
+  // single complex number (back0, where the output index is fixed
+  // while g and y slide). The sg argument is +-1 and conjugates the
+  // second complex operand, absorbing the conj variants of the Fns.
+  // The kernels read the split real/imaginary planes of
+  // SO3Fpart2_view through its centered ar/ac pointers and require
+  // unit inner stride; the Fn classes fall back to the scalar loops
+  // for any other layout (including flipped views). ISA selection
+  // follows SO3part_simd_level() in SO3part_addCGproduct_simd.hpp.
+
+
+#if defined(__x86_64__) && defined(__AVX2__)
+
+  // r[0..n) += w[0..n)*(ar,ai)*(yr,sg*yi)[0..n), 8 lanes per AVX2 step.
+  inline void SO3Fpart_row_cmadd_avx2(float* rr, float* ri, const float* w, const float* yr, const float* yi,
+    const float ar, const float ai, const float sg, const int n){
+    const __m256 var=_mm256_set1_ps(ar);
+    const __m256 vai=_mm256_set1_ps(ai);
+    const __m256 vsg=_mm256_set1_ps(sg);
+    int i=0;
+    for(; i+8<=n; i+=8){
+      const __m256 vw=_mm256_loadu_ps(w+i);
+      const __m256 vyr=_mm256_loadu_ps(yr+i);
+      const __m256 vyi=_mm256_mul_ps(vsg,_mm256_loadu_ps(yi+i));
+      const __m256 tr=_mm256_fmsub_ps(var,vyr,_mm256_mul_ps(vai,vyi));
+      const __m256 ti=_mm256_fmadd_ps(var,vyi,_mm256_mul_ps(vai,vyr));
+      _mm256_storeu_ps(rr+i,_mm256_fmadd_ps(vw,tr,_mm256_loadu_ps(rr+i)));
+      _mm256_storeu_ps(ri+i,_mm256_fmadd_ps(vw,ti,_mm256_loadu_ps(ri+i)));
+    }
+    for(; i<n; i++){
+      const float v=sg*yi[i];
+      rr[i]+=w[i]*(ar*yr[i]-ai*v);
+      ri[i]+=w[i]*(ar*v+ai*yr[i]);
+    }
+  }
+
+  // (sr,si) += sum_k w[k]*(gr,gi)[k]*(yr,sg*yi)[k].
+  inline void SO3Fpart_row_cdot_avx2(const float* w, const float* gr, const float* gi,
+    const float* yr, const float* yi, const float sg, const int n, float& sr, float& si){
+    const __m256 vsg=_mm256_set1_ps(sg);
+    __m256 vsr=_mm256_setzero_ps();
+    __m256 vsi=_mm256_setzero_ps();
+    int i=0;
+    for(; i+8<=n; i+=8){
+      const __m256 vw=_mm256_loadu_ps(w+i);
+      const __m256 vgr=_mm256_loadu_ps(gr+i);
+      const __m256 vgi=_mm256_loadu_ps(gi+i);
+      const __m256 vyr=_mm256_loadu_ps(yr+i);
+      const __m256 vyi=_mm256_mul_ps(vsg,_mm256_loadu_ps(yi+i));
+      const __m256 tr=_mm256_fmsub_ps(vgr,vyr,_mm256_mul_ps(vgi,vyi));
+      const __m256 ti=_mm256_fmadd_ps(vgr,vyi,_mm256_mul_ps(vgi,vyr));
+      vsr=_mm256_fmadd_ps(vw,tr,vsr);
+      vsi=_mm256_fmadd_ps(vw,ti,vsi);
+    }
+    float bufr[8];
+    float bufi[8];
+    _mm256_storeu_ps(bufr,vsr);
+    _mm256_storeu_ps(bufi,vsi);
+    for(int j=0; j<8; j++){sr+=bufr[j]; si+=bufi[j];}
+    for(; i<n; i++){
+      const float v=sg*yi[i];
+      sr+=w[i]*(gr[i]*yr[i]-gi[i]*v);
+      si+=w[i]*(gr[i]*v+gi[i]*yr[i]);
+    }
+  }
+
+#endif
+
+
+#if defined(__x86_64__) && defined(__AVX512F__)
+
+  // Same as the AVX2 kernels but 16 lanes per step.
+  inline void SO3Fpart_row_cmadd_avx512(float* rr, float* ri, const float* w, const float* yr, const float* yi,
+    const float ar, const float ai, const float sg, const int n){
+    const __m512 var=_mm512_set1_ps(ar);
+    const __m512 vai=_mm512_set1_ps(ai);
+    const __m512 vsg=_mm512_set1_ps(sg);
+    int i=0;
+    for(; i+16<=n; i+=16){
+      const __m512 vw=_mm512_loadu_ps(w+i);
+      const __m512 vyr=_mm512_loadu_ps(yr+i);
+      const __m512 vyi=_mm512_mul_ps(vsg,_mm512_loadu_ps(yi+i));
+      const __m512 tr=_mm512_fmsub_ps(var,vyr,_mm512_mul_ps(vai,vyi));
+      const __m512 ti=_mm512_fmadd_ps(var,vyi,_mm512_mul_ps(vai,vyr));
+      _mm512_storeu_ps(rr+i,_mm512_fmadd_ps(vw,tr,_mm512_loadu_ps(rr+i)));
+      _mm512_storeu_ps(ri+i,_mm512_fmadd_ps(vw,ti,_mm512_loadu_ps(ri+i)));
+    }
+    for(; i<n; i++){
+      const float v=sg*yi[i];
+      rr[i]+=w[i]*(ar*yr[i]-ai*v);
+      ri[i]+=w[i]*(ar*v+ai*yr[i]);
+    }
+  }
+
+  inline void SO3Fpart_row_cdot_avx512(const float* w, const float* gr, const float* gi,
+    const float* yr, const float* yi, const float sg, const int n, float& sr, float& si){
+    const __m512 vsg=_mm512_set1_ps(sg);
+    __m512 vsr=_mm512_setzero_ps();
+    __m512 vsi=_mm512_setzero_ps();
+    int i=0;
+    for(; i+16<=n; i+=16){
+      const __m512 vw=_mm512_loadu_ps(w+i);
+      const __m512 vgr=_mm512_loadu_ps(gr+i);
+      const __m512 vgi=_mm512_loadu_ps(gi+i);
+      const __m512 vyr=_mm512_loadu_ps(yr+i);
+      const __m512 vyi=_mm512_mul_ps(vsg,_mm512_loadu_ps(yi+i));
+      const __m512 tr=_mm512_fmsub_ps(vgr,vyr,_mm512_mul_ps(vgi,vyi));
+      const __m512 ti=_mm512_fmadd_ps(vgr,vyi,_mm512_mul_ps(vgi,vyr));
+      vsr=_mm512_fmadd_ps(vw,tr,vsr);
+      vsi=_mm512_fmadd_ps(vw,ti,vsi);
+    }
+    sr+=_mm512_reduce_add_ps(vsr);
+    si+=_mm512_reduce_add_ps(vsi);
+    for(; i<n; i++){
+      const float v=sg*yi[i];
+      sr+=w[i]*(gr[i]*yr[i]-gi[i]*v);
+      si+=w[i]*(gr[i]*v+gi[i]*yr[i]);
+    }
+  }
+
+#endif
+
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+
+  inline void SO3Fpart_row_cmadd_neon(float* rr, float* ri, const float* w, const float* yr, const float* yi,
+    const float ar, const float ai, const float sg, const int n){
+    const float32x4_t var=vdupq_n_f32(ar);
+    const float32x4_t vai=vdupq_n_f32(ai);
+    const float32x4_t vsg=vdupq_n_f32(sg);
+    int i=0;
+    for(; i+4<=n; i+=4){
+      const float32x4_t vw=vld1q_f32(w+i);
+      const float32x4_t vyr=vld1q_f32(yr+i);
+      const float32x4_t vyi=vmulq_f32(vsg,vld1q_f32(yi+i));
+      float32x4_t tr=vmulq_f32(var,vyr);
+      tr=vfmsq_f32(tr,vai,vyi);
+      float32x4_t ti=vmulq_f32(var,vyi);
+      ti=vfmaq_f32(ti,vai,vyr);
+      vst1q_f32(rr+i,vfmaq_f32(vld1q_f32(rr+i),vw,tr));
+      vst1q_f32(ri+i,vfmaq_f32(vld1q_f32(ri+i),vw,ti));
+    }
+    for(; i<n; i++){
+      const float v=sg*yi[i];
+      rr[i]+=w[i]*(ar*yr[i]-ai*v);
+      ri[i]+=w[i]*(ar*v+ai*yr[i]);
+    }
+  }
+
+  inline void SO3Fpart_row_cdot_neon(const float* w, const float* gr, const float* gi,
+    const float* yr, const float* yi, const float sg, const int n, float& sr, float& si){
+    const float32x4_t vsg=vdupq_n_f32(sg);
+    float32x4_t vsr=vdupq_n_f32(0);
+    float32x4_t vsi=vdupq_n_f32(0);
+    int i=0;
+    for(; i+4<=n; i+=4){
+      const float32x4_t vw=vld1q_f32(w+i);
+      const float32x4_t vgr=vld1q_f32(gr+i);
+      const float32x4_t vgi=vld1q_f32(gi+i);
+      const float32x4_t vyr=vld1q_f32(yr+i);
+      const float32x4_t vyi=vmulq_f32(vsg,vld1q_f32(yi+i));
+      float32x4_t tr=vmulq_f32(vgr,vyr);
+      tr=vfmsq_f32(tr,vgi,vyi);
+      float32x4_t ti=vmulq_f32(vgr,vyi);
+      ti=vfmaq_f32(ti,vgi,vyr);
+      vsr=vfmaq_f32(vsr,vw,tr);
+      vsi=vfmaq_f32(vsi,vw,ti);
+    }
+    sr+=vaddvq_f32(vsr);
+    si+=vaddvq_f32(vsi);
+    for(; i<n; i++){
+      const float v=sg*yi[i];
+      sr+=w[i]*(gr[i]*yr[i]-gi[i]*v);
+      si+=w[i]*(gr[i]*v+gi[i]*yr[i]);
+    }
+  }
+
+#endif
+
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_SVE)
+
+  // Vector-length agnostic; the whilelt predicate absorbs the tail.
+  inline void SO3Fpart_row_cmadd_sve(float* rr, float* ri, const float* w, const float* yr, const float* yi,
+    const float ar, const float ai, const float sg, const int n){
+    const svfloat32_t var=svdup_n_f32(ar);
+    const svfloat32_t vai=svdup_n_f32(ai);
+    const svfloat32_t vsg=svdup_n_f32(sg);
+    const int vw_=(int)svcntw();
+    for(int i=0; i<n; i+=vw_){
+      const svbool_t pg=svwhilelt_b32_s32(i,n);
+      const svfloat32_t vw=svld1_f32(pg,w+i);
+      const svfloat32_t vyr=svld1_f32(pg,yr+i);
+      const svfloat32_t vyi=svmul_f32_x(pg,vsg,svld1_f32(pg,yi+i));
+      svfloat32_t tr=svmul_f32_x(pg,var,vyr);
+      tr=svmls_f32_x(pg,tr,vai,vyi);
+      svfloat32_t ti=svmul_f32_x(pg,var,vyi);
+      ti=svmla_f32_x(pg,ti,vai,vyr);
+      svst1_f32(pg,rr+i,svmla_f32_x(pg,svld1_f32(pg,rr+i),vw,tr));
+      svst1_f32(pg,ri+i,svmla_f32_x(pg,svld1_f32(pg,ri+i),vw,ti));
+    }
+  }
+
+  inline void SO3Fpart_row_cdot_sve(const float* w, const float* gr, const float* gi,
+    const float* yr, const float* yi, const float sg, const int n, float& sr, float& si){
+    const svfloat32_t vsg=svdup_n_f32(sg);
+    svfloat32_t vsr=svdup_n_f32(0);
+    svfloat32_t vsi=svdup_n_f32(0);
+    const int vw_=(int)svcntw();
+    for(int i=0; i<n; i+=vw_){
+      const svbool_t pg=svwhilelt_b32_s32(i,n);
+      const svfloat32_t vw=svld1_f32(pg,w+i);
+      const svfloat32_t vgr=svld1_f32(pg,gr+i);
+      const svfloat32_t vgi=svld1_f32(pg,gi+i);
+      const svfloat32_t vyr=svld1_f32(pg,yr+i);
+      const svfloat32_t vyi=svmul_f32_x(pg,vsg,svld1_f32(pg,yi+i));
+      svfloat32_t tr=svmul_f32_x(pg,vgr,vyr);
+      tr=svmls_f32_x(pg,tr,vgi,vyi);
+      svfloat32_t ti=svmul_f32_x(pg,vgr,vyi);
+      ti=svmla_f32_x(pg,ti,vgi,vyr);
+      vsr=svmla_f32_m(pg,vsr,vw,tr);
+      vsi=svmla_f32_m(pg,vsi,vw,ti);
+    }
+    sr+=svaddv_f32(svptrue_b32(),vsr);
+    si+=svaddv_f32(svptrue_b32(),vsi);
+  }
+
+#endif
+
+
+  inline void SO3Fpart_row_cmadd_scalar(float* rr, float* ri, const float* w, const float* yr, const float* yi,
+    const float ar, const float ai, const float sg, const int n){
+    for(int i=0; i<n; i++){
+      const float v=sg*yi[i];
+      rr[i]+=w[i]*(ar*yr[i]-ai*v);
+      ri[i]+=w[i]*(ar*v+ai*yr[i]);
+    }
+  }
+
+  inline void SO3Fpart_row_cdot_scalar(const float* w, const float* gr, const float* gi,
+    const float* yr, const float* yi, const float sg, const int n, float& sr, float& si){
+    for(int i=0; i<n; i++){
+      const float v=sg*yi[i];
+      sr+=w[i]*(gr[i]*yr[i]-gi[i]*v);
+      si+=w[i]*(gr[i]*v+gi[i]*yr[i]);
+    }
+  }
+
+
+  inline void SO3Fpart_row_cmadd(float* rr, float* ri, const float* w, const float* yr, const float* yi,
+    const float ar, const float ai, const float sg, const int n){
+#if defined(__x86_64__) && defined(__AVX512F__)
+    if(SO3part_simd_level()>=2){SO3Fpart_row_cmadd_avx512(rr,ri,w,yr,yi,ar,ai,sg,n); return;}
+#endif
+#if defined(__x86_64__) && defined(__AVX2__)
+    if(SO3part_simd_level()>=1){SO3Fpart_row_cmadd_avx2(rr,ri,w,yr,yi,ar,ai,sg,n); return;}
+#endif
+#if defined(__aarch64__) && defined(__ARM_FEATURE_SVE)
+    SO3Fpart_row_cmadd_sve(rr,ri,w,yr,yi,ar,ai,sg,n); return;
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+    SO3Fpart_row_cmadd_neon(rr,ri,w,yr,yi,ar,ai,sg,n); return;
+#endif
+    SO3Fpart_row_cmadd_scalar(rr,ri,w,yr,yi,ar,ai,sg,n);
+  }
+
+
+  inline void SO3Fpart_row_cdot(const float* w, const float* gr, const float* gi,
+    const float* yr, const float* yi, const float sg, const int n, float& sr, float& si){
+#if defined(__x86_64__) && defined(__AVX512F__)
+    if(SO3part_simd_level()>=2){SO3Fpart_row_cdot_avx512(w,gr,gi,yr,yi,sg,n,sr,si); return;}
+#endif
+#if defined(__x86_64__) && defined(__AVX2__)
+    if(SO3part_simd_level()>=1){SO3Fpart_row_cdot_avx2(w,gr,gi,yr,yi,sg,n,sr,si); return;}
+#endif
+#if defined(__aarch64__) && defined(__ARM_FEATURE_SVE)
+    SO3Fpart_row_cdot_sve(w,gr,gi,yr,yi,sg,n,sr,si); return;
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+    SO3Fpart_row_cdot_neon(w,gr,gi,yr,yi,sg,n,sr,si); return;
+#endif
+    SO3Fpart_row_cdot_scalar(w,gr,gi,yr,yi,sg,n,sr,si);
+  }
+
+
+  // ---- Drivers --------------------------------------------------------------------------------------------
+
+
+  // Forward product r(M1+M2,m1+m2) += t*C(m1,m2)*x(M1,m1)*y(M2,m2),
+  // vectorized over m2; the conj variant conjugates y. Returns false
+  // if the output or second operand rows are not unit-stride.
+  template<typename CMAT>
+  inline bool SO3Fpart_addFproduct_simd(SO3Fpart2_view r, SO3Fpart2_view x, SO3Fpart2_view y,
+    const CMAT& C, const float c, const int L1, const int L2, const int Lr, const int conj){
+    if(r.s1!=1 || y.s1!=1) return false;
+    const int l1=x.l;
+    const int l2=y.l;
+    const float sg=(conj%2==0)? 1.0f: -1.0f;
+    for(int M1=-L1; M1<=L1; M1++){
+      for(int M2=std::max(-L2,-Lr-M1); M2<=std::min(L2,Lr-M1); M2++){
+	const float t=C(M1+l1,M2+l2)*c;
+	float* rr=r.ar+(M1+M2)*r.s0;
+	float* ri=r.ac+(M1+M2)*r.s0;
+	for(int m1=-L1; m1<=L1; m1++){
+	  const int lo=std::max(-L2,-Lr-m1);
+	  const int hi=std::min(L2,Lr-m1);
+	  if(hi<lo) continue;
+	  const complex<float> a=t*x(M1,m1);
+	  SO3Fpart_row_cmadd(rr+m1+lo,ri+m1+lo,C.arr+(m1+l1)*(2*l2+1)+lo+l2,
+	    y.ar+M2*y.s0+lo,y.ac+M2*y.s0+lo,a.real(),a.imag(),sg,hi-lo+1);
+	}
+      }
+    }
+    return true;
+  }
+
+  // Backprop to x: the output element is fixed while the g and y rows
+  // slide together, so each (M1,M2,m1) is a weighted dot product.
+  template<typename CMAT>
+  inline bool SO3Fpart_addFproduct_back0_simd(SO3Fpart2_view xg, SO3Fpart2_view g, SO3Fpart2_view y,
+    const CMAT& C, const float c, const int L1, const int L2, const int Lr, const int conj){
+    if(g.s1!=1 || y.s1!=1) return false;
+    const int l1=xg.l;
+    const int l2=y.l;
+    const float sg=(conj%2==0)? -1.0f: 1.0f;
+    for(int M1=-L1; M1<=L1; M1++){
+      for(int M2=std::max(-L2,-Lr-M1); M2<=std::min(L2,Lr-M1); M2++){
+	const float t=C(M1+l1,M2+l2)*c;
+	for(int m1=-L1; m1<=L1; m1++){
+	  const int lo=std::max(-L2,-Lr-m1);
+	  const int hi=std::min(L2,Lr-m1);
+	  if(hi<lo) continue;
+	  float sr=0;
+	  float si=0;
+	  SO3Fpart_row_cdot(C.arr+(m1+l1)*(2*l2+1)+lo+l2,
+	    g.ar+(M1+M2)*g.s0+m1+lo,g.ac+(M1+M2)*g.s0+m1+lo,
+	    y.ar+M2*y.s0+lo,y.ac+M2*y.s0+lo,sg,hi-lo+1,sr,si);
+	  xg.inc(M1,m1,complex<float>(t*sr,t*si));
+	}
+      }
+    }
+    return true;
+  }
+
+  // Backprop to y: same row structure as the forward product with the
+  // roles of the operands exchanged. The conj variant conjugates the
+  // whole contribution, which distributes as conj(a*g)=conj(a)*conj(g).
+  template<typename CMAT>
+  inline bool SO3Fpart_addFproduct_back1_simd(SO3Fpart2_view yg, SO3Fpart2_view g, SO3Fpart2_view x,
+    const CMAT& C, const float c, const int L1, const int L2, const int Lr, const int conj){
+    if(yg.s1!=1 || g.s1!=1) return false;
+    const int l1=x.l;
+    const int l2=yg.l;
+    for(int M1=-L1; M1<=L1; M1++){
+      for(int M2=std::max(-L2,-Lr-M1); M2<=std::min(L2,Lr-M1); M2++){
+	const float t=C(M1+l1,M2+l2)*c;
+	float* rr=yg.ar+M2*yg.s0;
+	float* ri=yg.ac+M2*yg.s0;
+	for(int m1=-L1; m1<=L1; m1++){
+	  const int lo=std::max(-L2,-Lr-m1);
+	  const int hi=std::min(L2,Lr-m1);
+	  if(hi<lo) continue;
+	  complex<float> a=t*std::conj(x(M1,m1));
+	  float sg=1.0f;
+	  if(conj%2!=0){a=std::conj(a); sg=-1.0f;}
+	  SO3Fpart_row_cmadd(rr+lo,ri+lo,C.arr+(m1+l1)*(2*l2+1)+lo+l2,
+	    g.ar+(M1+M2)*g.s0+m1+lo,g.ac+(M1+M2)*g.s0+m1+lo,a.real(),a.imag(),sg,hi-lo+1);
+	}
+      }
+    }
+    return true;
+  }
+
+}
+
+#endif
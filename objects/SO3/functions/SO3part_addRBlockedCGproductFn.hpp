@@ -0,0 +1,106 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef _SO3part_addRBlockedCGproductFn
+#define _SO3part_addRBlockedCGproductFn
+
+#include "GElib_base.hpp"
+#include "CtensorB.hpp"
+#include "SO3part2_view.hpp"
+#include "MultiLoop.hpp"
+#include "GElibTimer.hpp"
+#include "CellFnTemplates.hpp"
+#include "GElibNvtx.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+extern GElib::SO3_SPHgen SO3_sphGen;
+
+
+namespace GElib{
+
+  #ifdef _WITH_CUDA
+  void SO3partB_addDiagCGproduct_cu(cnine::Ctensor3_view r, const cnine::Ctensor3_view& x, const cnine::Ctensor3_view& y,
+    const int offs, const cudaStream_t& stream);
+  #endif
+
+
+  // Cellwise blocked (block-diagonal) CG-product for the SO3n array
+  // view classes; the bsize=1 case is the DiagCGproduct.
+  class SO3part_addRBlockedCGproductFn{
+  public:
+
+    typedef cnine::TensorView<complex<float> > TENSOR;
+
+    void operator()(const TENSOR& _r, const TENSOR& _x, const TENSOR& _y, const int bsize, const int _offs=0){
+      GELIB_NVTX_RANGE("RBlockedCGproduct");
+
+      CNINE_ASSRT(_r.ndims()==5);
+      CNINE_ASSRT(_x.ndims()==5);
+      CNINE_ASSRT(_y.ndims()==5);
+
+      const int l=(_r.dim(3)-1)/2;
+      const int l1=(_x.dim(3)-1)/2;
+      const int l2=(_y.dim(3)-1)/2;
+
+      const int N=_x.dim(4)/bsize;
+      const int dev=_r.dev;
+
+      CNINE_ASSRT(_x.dim(4)==_y.dim(4));
+      CNINE_ASSRT(_x.dim(4)%bsize==0);
+      CNINE_ASSRT(_offs+N*bsize*bsize<=_r.dim(4));
+      CNINE_ASSRT(l>=abs(l1-l2) && l<=l1+l2);
+
+      if(dev==0){
+
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+	cnine::batched_mprod<TENSOR>(_r,_x,_y,
+	  [&](const TENSOR& _r, const TENSOR& _x, const TENSOR& _y){
+	    SO3part2_view r(_r);
+	    SO3part2_view x(_x);
+	    SO3part2_view y(_y);
+
+	    for(int n=0; n<N; n++){
+	      for(int n1=0; n1<bsize; n1++){
+		const int offs=_offs+(n*bsize+n1)*bsize;
+		for(auto& e:C.nonzeros){
+		  const complex<float> t=e.c*x(e.m1-l1,n1+n*bsize);
+		  for(int n2=0; n2<bsize; n2++)
+		    r.inc(e.m-l,offs+n2,t*y(e.m2-l2,n2+n*bsize));
+		}
+	      }
+	    }
+	  });
+
+      }
+
+      // Per-cell launches of the flat diagonal kernel with a singleton
+      // batch dimension; see SO3part_addRCGproductFn.
+      else{
+	assert(bsize==1);
+	#ifdef _WITH_CUDA
+	cnine::batched_mprod<TENSOR>(_r,_x,_y,
+	  [&](const TENSOR& _r, const TENSOR& _x, const TENSOR& _y){
+	    SO3part2_view r(_r);
+	    SO3part2_view x(_x);
+	    SO3part2_view y(_y);
+	    cnine::Ctensor3_view rv(r.arr,{1,r.n0,r.n1},{0,r.s0,r.s1},(int)(r.arrc-r.arr),dev);
+	    cnine::Ctensor3_view xv(x.arr,{1,x.n0,x.n1},{0,x.s0,x.s1},(int)(x.arrc-x.arr),dev);
+	    cnine::Ctensor3_view yv(y.arr,{1,y.n0,y.n1},{0,y.s0,y.s1},(int)(y.arrc-y.arr),dev);
+	    GELIB_CUDA_STREAM(SO3partB_addDiagCGproduct_cu(rv,xv,yv,_offs,stream));
+	  });
+	#endif
+      }
+
+    }
+
+  };
+
+}
+
+#endif
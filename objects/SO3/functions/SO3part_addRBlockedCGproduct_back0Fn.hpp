@@ -0,0 +1,103 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef _SO3part_addRBlockedCGproduct_back0Fn
+#define _SO3part_addRBlockedCGproduct_back0Fn
+
+#include "GElib_base.hpp"
+#include "SO3part2_view.hpp"
+#include "CellFnTemplates.hpp"
+#include "GElibNvtx.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+extern GElib::SO3_SPHgen SO3_sphGen;
+
+
+namespace GElib{
+
+  #ifdef _WITH_CUDA
+  void SO3partB_addDiagCGproduct_back0_cu(const cnine::Ctensor3_view& xg, cnine::Ctensor3_view rg, const cnine::Ctensor3_view& y,
+    const int offs, const cudaStream_t& stream);
+  #endif
+
+
+  class SO3part_addRBlockedCGproduct_back0Fn{
+  public:
+
+    typedef cnine::TensorView<complex<float> > TENSOR;
+
+    void operator()(const TENSOR& _xg, const TENSOR& _g, const TENSOR& _y, const int bsize, const int _offs=0){
+      GELIB_NVTX_RANGE("RBlockedCGproduct_back0");
+
+      CNINE_ASSRT(_xg.ndims()==5);
+      CNINE_ASSRT(_g.ndims()==5);
+      CNINE_ASSRT(_y.ndims()==5);
+
+      const int l=(_g.dim(3)-1)/2;
+      const int l1=(_xg.dim(3)-1)/2;
+      const int l2=(_y.dim(3)-1)/2;
+
+      const int N=_xg.dim(4)/bsize;
+      const int dev=_g.dev;
+
+      CNINE_ASSRT(_xg.dim(4)==_y.dim(4));
+      CNINE_ASSRT(_xg.dim(4)%bsize==0);
+      CNINE_ASSRT(_offs+N*bsize*bsize<=_g.dim(4));
+      CNINE_ASSRT(l>=abs(l1-l2) && l<=l1+l2);
+
+      if(dev==0){
+
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+	cnine::batched_mprod<TENSOR>(_xg,_g,_y,
+	  [&](const TENSOR& _xg, const TENSOR& _g, const TENSOR& _y){
+	    SO3part2_view xg(_xg);
+	    SO3part2_view g(_g);
+	    SO3part2_view y(_y);
+
+	    for(int n=0; n<N; n++){
+	      for(int n1=0; n1<bsize; n1++){
+		const int offs=_offs+(n*bsize+n1)*bsize;
+		for(int n2=0; n2<bsize; n2++){
+		  for(int m1=-l1; m1<=l1; m1++){
+		    for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++){
+		      xg.inc(m1,n1+n*bsize,C(m1+l1,m2+l2)*g(m1+m2,offs+n2)*std::conj(y(m2,n2+n*bsize)));
+		    }
+		  }
+		}
+	      }
+	    }
+	  });
+
+      }
+
+      // Per-cell launches of the flat diagonal backward kernel; see
+      // SO3part_addRCGproductFn.
+      else{
+	assert(bsize==1);
+	#ifdef _WITH_CUDA
+	cnine::batched_mprod<TENSOR>(_xg,_g,_y,
+	  [&](const TENSOR& _xg, const TENSOR& _g, const TENSOR& _y){
+	    SO3part2_view xg(_xg);
+	    SO3part2_view g(_g);
+	    SO3part2_view y(_y);
+	    cnine::Ctensor3_view xgv(xg.arr,{1,xg.n0,xg.n1},{0,xg.s0,xg.s1},(int)(xg.arrc-xg.arr),dev);
+	    cnine::Ctensor3_view gv(g.arr,{1,g.n0,g.n1},{0,g.s0,g.s1},(int)(g.arrc-g.arr),dev);
+	    cnine::Ctensor3_view yv(y.arr,{1,y.n0,y.n1},{0,y.s0,y.s1},(int)(y.arrc-y.arr),dev);
+	    GELIB_CUDA_STREAM(SO3partB_addDiagCGproduct_back0_cu(xgv,gv,yv,_offs,stream));
+	  });
+	#endif
+      }
+
+    }
+
+  };
+
+}
+
+#endif
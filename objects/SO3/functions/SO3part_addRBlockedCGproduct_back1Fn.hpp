@@ -0,0 +1,103 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef _SO3part_addRBlockedCGproduct_back1Fn
+#define _SO3part_addRBlockedCGproduct_back1Fn
+
+#include "GElib_base.hpp"
+#include "SO3part2_view.hpp"
+#include "CellFnTemplates.hpp"
+#include "GElibNvtx.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+extern GElib::SO3_SPHgen SO3_sphGen;
+
+
+namespace GElib{
+
+  #ifdef _WITH_CUDA
+  void SO3partB_addDiagCGproduct_back1_cu(const cnine::Ctensor3_view& yg, cnine::Ctensor3_view g, const cnine::Ctensor3_view& x,
+    const int offs, const cudaStream_t& stream);
+  #endif
+
+
+  class SO3part_addRBlockedCGproduct_back1Fn{
+  public:
+
+    typedef cnine::TensorView<complex<float> > TENSOR;
+
+    void operator()(const TENSOR& _yg, const TENSOR& _g, const TENSOR& _x, const int bsize, const int _offs=0){
+      GELIB_NVTX_RANGE("RBlockedCGproduct_back1");
+
+      CNINE_ASSRT(_yg.ndims()==5);
+      CNINE_ASSRT(_g.ndims()==5);
+      CNINE_ASSRT(_x.ndims()==5);
+
+      const int l=(_g.dim(3)-1)/2;
+      const int l1=(_x.dim(3)-1)/2;
+      const int l2=(_yg.dim(3)-1)/2;
+
+      const int N=_x.dim(4)/bsize;
+      const int dev=_g.dev;
+
+      CNINE_ASSRT(_x.dim(4)==_yg.dim(4));
+      CNINE_ASSRT(_x.dim(4)%bsize==0);
+      CNINE_ASSRT(_offs+N*bsize*bsize<=_g.dim(4));
+      CNINE_ASSRT(l>=abs(l1-l2) && l<=l1+l2);
+
+      if(dev==0){
+
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+	cnine::batched_mprod<TENSOR>(_yg,_g,_x,
+	  [&](const TENSOR& _yg, const TENSOR& _g, const TENSOR& _x){
+	    SO3part2_view yg(_yg);
+	    SO3part2_view g(_g);
+	    SO3part2_view x(_x);
+
+	    for(int n=0; n<N; n++){
+	      for(int n1=0; n1<bsize; n1++){
+		const int offs=_offs+(n*bsize+n1)*bsize;
+		for(int n2=0; n2<bsize; n2++){
+		  for(int m1=-l1; m1<=l1; m1++){
+		    for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++){
+		      yg.inc(m2,n2+n*bsize,C(m1+l1,m2+l2)*g(m1+m2,offs+n2)*std::conj(x(m1,n1+n*bsize)));
+		    }
+		  }
+		}
+	      }
+	    }
+	  });
+
+      }
+
+      // Per-cell launches of the flat diagonal backward kernel; see
+      // SO3part_addRCGproductFn.
+      else{
+	assert(bsize==1);
+	#ifdef _WITH_CUDA
+	cnine::batched_mprod<TENSOR>(_yg,_g,_x,
+	  [&](const TENSOR& _yg, const TENSOR& _g, const TENSOR& _x){
+	    SO3part2_view yg(_yg);
+	    SO3part2_view g(_g);
+	    SO3part2_view x(_x);
+	    cnine::Ctensor3_view ygv(yg.arr,{1,yg.n0,yg.n1},{0,yg.s0,yg.s1},(int)(yg.arrc-yg.arr),dev);
+	    cnine::Ctensor3_view gv(g.arr,{1,g.n0,g.n1},{0,g.s0,g.s1},(int)(g.arrc-g.arr),dev);
+	    cnine::Ctensor3_view xv(x.arr,{1,x.n0,x.n1},{0,x.s0,x.s1},(int)(x.arrc-x.arr),dev);
+	    GELIB_CUDA_STREAM(SO3partB_addDiagCGproduct_back1_cu(ygv,gv,xv,_offs,stream));
+	  });
+	#endif
+      }
+
+    }
+
+  };
+
+}
+
+#endif
@@ -17,6 +17,9 @@
 #include "MultiLoop.hpp"
 #include "GElibTimer.hpp"
 #include "CellFnTemplates.hpp"
+#include "SO3part_addCGproduct_simd.hpp"
+#include "SO3part_addCGproduct_smallFn.hpp"
+#include "GElibNvtx.hpp"
 
 extern GElib::SO3_CGbank SO3_cgbank;
 extern GElib::SO3_SPHgen SO3_sphGen;
@@ -25,9 +28,9 @@ extern GElib::SO3_SPHgen SO3_sphGen;
 namespace GElib{
 
   #ifdef _WITH_CUDA
-  void SO3partB_addCGproduct_cu(cnine::Ctensor3_view r, const cnine::Ctensor3_view& x, const cnine::Ctensor3_view& y, 
-    const int offs, const cudaStream_t& stream);
-  #endif 
+  void SO3partB_addRCGproduct_cu(const std::vector<cnine::Ctensor2_view>& r, const std::vector<cnine::Ctensor2_view>& x,
+    const std::vector<cnine::Ctensor2_view>& y, const int offs, const cudaStream_t& stream);
+  #endif
 
 
   class SO3part_addRCGproductFn{
@@ -36,6 +39,7 @@ namespace GElib{
     typedef cnine::TensorView<complex<float> > TENSOR;
 
     void operator()(const TENSOR& _r, const TENSOR& _x, const TENSOR& _y, const int _offs=0){
+      GELIB_NVTX_RANGE("RCGproduct");
 
       CNINE_ASSRT(_r.ndims()==5);
       CNINE_ASSRT(_x.ndims()==5);
@@ -64,28 +68,49 @@ namespace GElib{
 
       if(dev==0){
 
-	auto& C=SO3_cgbank.getf(CGindex(l1,l2,l));
+	// Same kernel ladder as the flat SO3part path: the vectorized
+	// kernel when the cell layout admits it, the fully unrolled
+	// small-l kernel next, and the cached nonzero sweep as the
+	// general case, so the cellwise products of the SO3n generation
+	// run at the same per-cell speed as SO3partB.
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
 	cnine::batched_mprod<TENSOR>(_r,_x,_y,
 	  [&](const TENSOR& _r, const TENSOR& _x, const TENSOR& _y){
 	    SO3part2_view r(_r);
 	    SO3part2_view x(_x);
 	    SO3part2_view y(_y);
-
 	    int offs=_offs;
+
+	    if(SO3part_addCGproduct_simd(r,x,y,C,offs)) return;
+	    if(SO3part_addCGproduct_small(l1,l2,l,r,x,y,offs)) return;
+
 	    for(int n1=0; n1<N1; n1++){
-	      for(int n2=0; n2<N2; n2++){
-		for(int m1=-l1; m1<=l1; m1++){
-		  for(int m2=std::max(-l2,-l-m1); m2<=std::min(l2,l-m1); m2++){
-		    r.inc(m1+m2,offs+n2,C(m1+l1,m2+l2)*x(m1,n1)*y(m2,n2));
-		  }
-		}
+	      for(auto& e:C.nonzeros){
+		const complex<float> t=e.c*x(e.m1-l1,n1);
+		for(int n2=0; n2<N2; n2++)
+		  r.inc(e.m-l,offs+n2,t*y(e.m2-l2,n2));
 	      }
 	      offs+=N2;
 	    }
 	  });
 
       }
-      //else CUDA_STREAM(SO3partB_addReducingCGproduct_cu(_r,_x,_y,_offs,stream));
+
+      // The cells share one shape and one set of strides, so they are
+      // collected and handed to the cellwise kernel as a single launch
+      // instead of one flat-kernel launch per cell pair.
+      else{
+	#ifdef _WITH_CUDA
+	std::vector<cnine::Ctensor2_view> rv, xv, yv;
+	cnine::batched_mprod<TENSOR>(_r,_x,_y,
+	  [&](const TENSOR& _r, const TENSOR& _x, const TENSOR& _y){
+	    rv.push_back(SO3part2_view(_r));
+	    xv.push_back(SO3part2_view(_x));
+	    yv.push_back(SO3part2_view(_y));
+	  });
+	GELIB_CUDA_STREAM(SO3partB_addRCGproduct_cu(rv,xv,yv,_offs,stream));
+	#endif
+      }
 
     }
 
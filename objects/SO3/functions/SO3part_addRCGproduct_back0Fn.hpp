@@ -13,6 +13,7 @@
 #include "GElib_base.hpp"
 #include "SO3part2_view.hpp"
 #include "CellFnTemplates.hpp"
+#include "GElibNvtx.hpp"
 
 extern GElib::SO3_CGbank SO3_cgbank;
 extern GElib::SO3_SPHgen SO3_sphGen;
@@ -21,8 +22,8 @@ extern GElib::SO3_SPHgen SO3_sphGen;
 namespace GElib{
 
   #ifdef _WITH_CUDA
-  void SO3partB_addCGproduct_back0_cu(const cnine::Ctensor3_view& xg, cnine::Ctensor3_view rg, const cnine::Ctensor3_view& y, 
-    const int offs, const cudaStream_t& stream);
+  void SO3partB_addRCGproduct_back0_cu(const std::vector<cnine::Ctensor2_view>& xg, const std::vector<cnine::Ctensor2_view>& g,
+    const std::vector<cnine::Ctensor2_view>& y, const int offs, const cudaStream_t& stream);
   #endif
 
 
@@ -32,6 +33,7 @@ namespace GElib{
     typedef cnine::TensorView<complex<float> > TENSOR;
 
     void operator()(const TENSOR& _xg, const TENSOR& _g, const TENSOR& _y, const int _offs=0){
+      GELIB_NVTX_RANGE("RCGproduct_back0");
 
       CNINE_ASSRT(_xg.ndims()==5);
       CNINE_ASSRT(_g.ndims()==5);
@@ -53,7 +55,7 @@ namespace GElib{
 
       if(dev==0){
 	
-	auto& C=SO3_cgbank.getf(CGindex(l1,l2,l));
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
 	cnine::batched_mprod<TENSOR>(_xg,_g,_y,
 	  [&](const TENSOR& _xg, const TENSOR& _g, const TENSOR& _y){
 	    SO3part2_view xg(_xg);
@@ -73,8 +75,20 @@ namespace GElib{
 	  });
 
       }
+
+      // All cells go out in a single launch of the cellwise backward
+      // kernel; see SO3part_addRCGproductFn.
       else{
-	//CUDA_STREAM(SO3partB_addCGproduct_back0_cu(_xg,_g,_y,_offs,stream));
+	#ifdef _WITH_CUDA
+	std::vector<cnine::Ctensor2_view> xgv, gv, yv;
+	cnine::batched_mprod<TENSOR>(_xg,_g,_y,
+	  [&](const TENSOR& _xg, const TENSOR& _g, const TENSOR& _y){
+	    xgv.push_back(SO3part2_view(_xg));
+	    gv.push_back(SO3part2_view(_g));
+	    yv.push_back(SO3part2_view(_y));
+	  });
+	GELIB_CUDA_STREAM(SO3partB_addRCGproduct_back0_cu(xgv,gv,yv,_offs,stream));
+	#endif
       }
 
     }
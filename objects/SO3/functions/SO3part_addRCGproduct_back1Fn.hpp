@@ -13,6 +13,7 @@
 #include "GElib_base.hpp"
 #include "SO3part2_view.hpp"
 #include "CellFnTemplates.hpp"
+#include "GElibNvtx.hpp"
 
 extern GElib::SO3_CGbank SO3_cgbank;
 extern GElib::SO3_SPHgen SO3_sphGen;
@@ -21,8 +22,8 @@ extern GElib::SO3_SPHgen SO3_sphGen;
 namespace GElib{
 
   #ifdef _WITH_CUDA
-  void SO3partB_addCGproduct_back1_cu(const cnine::Ctensor3_view& yg, cnine::Ctensor3_view g, const cnine::Ctensor3_view& x, 
-    const int offs, const cudaStream_t& stream);
+  void SO3partB_addRCGproduct_back1_cu(const std::vector<cnine::Ctensor2_view>& yg, const std::vector<cnine::Ctensor2_view>& g,
+    const std::vector<cnine::Ctensor2_view>& x, const int offs, const cudaStream_t& stream);
   #endif
 
 
@@ -32,6 +33,7 @@ namespace GElib{
     typedef cnine::TensorView<complex<float> > TENSOR;
 
     void operator()(const TENSOR& _yg, const TENSOR& _g, const TENSOR& _x, const int _offs=0){
+      GELIB_NVTX_RANGE("RCGproduct_back1");
 
       CNINE_ASSRT(_g.ndims()==5);
       CNINE_ASSRT(_x.ndims()==5);
@@ -54,7 +56,7 @@ namespace GElib{
 
       if(dev==0){
 	
-	auto& C=SO3_cgbank.getf(CGindex(l1,l2,l));
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
 	cnine::batched_mprod<TENSOR>(_yg,_g,_x,
 	  [&](const TENSOR& _yg, const TENSOR& _g, const TENSOR& _x){
 	    SO3part2_view yg(_yg);
@@ -73,8 +75,21 @@ namespace GElib{
 	    }
 	  });
 
-      }else{
-	//CUDA_STREAM(SO3partB_addCGproduct_back1_cu(_yg,_g,_x,_offs,stream));
+      }
+
+      // All cells go out in a single launch of the cellwise backward
+      // kernel; see SO3part_addRCGproductFn.
+      else{
+	#ifdef _WITH_CUDA
+	std::vector<cnine::Ctensor2_view> ygv, gv, xv;
+	cnine::batched_mprod<TENSOR>(_yg,_g,_x,
+	  [&](const TENSOR& _yg, const TENSOR& _g, const TENSOR& _x){
+	    ygv.push_back(SO3part2_view(_yg));
+	    gv.push_back(SO3part2_view(_g));
+	    xv.push_back(SO3part2_view(_x));
+	  });
+	GELIB_CUDA_STREAM(SO3partB_addRCGproduct_back1_cu(ygv,gv,xv,_offs,stream));
+	#endif
       }
 
     }
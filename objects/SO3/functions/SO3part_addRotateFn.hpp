@@ -0,0 +1,100 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3part_addRotateFn
+#define _SO3part_addRotateFn
+
+#include "GElib_base.hpp"
+#include "CtensorB.hpp"
+#include "Ctensor2_view.hpp"
+#include "Ctensor3_view.hpp"
+#include "GElibThreadPool.hpp"
+
+#if defined(_WITH_CUDA) && defined(_WITH_CUBLAS)
+#include <cublas_v2.h>
+#include "GElibNvtx.hpp"
+#endif
+
+
+namespace GElib{
+
+  // Applies one Wigner D-matrix to every batch/cell slice of a part:
+  // r_b += D x_b for b=0,...,B-1, where B may be the fused batch x cell
+  // dimension of an SO3partB_array. On the host the slices are
+  // distributed over the thread pool; on the device the whole
+  // operation is four strided-batched SGEMMs (the real decomposition
+  // of the complex product over cnine's separate re/im planes), so an
+  // augmentation pass over an entire array is a single batched GEMM
+  // call instead of a per-sample host-side loop.
+
+  class SO3part_addRotateFn{
+  public:
+
+    void operator()(const cnine::Ctensor3_view& r, const cnine::Ctensor3_view& x, const cnine::Ctensor2_view& D){
+      GELIB_NVTX_RANGE("SO3rotate");
+
+      const int B=x.n0;
+      const int L=x.n1;
+      const int n=x.n2;
+
+      GELIB_ASSRT(r.n0==B && r.n1==L && r.n2==n);
+      GELIB_ASSRT(D.n0==L && D.n1==L);
+      GELIB_ASSRT(r.dev==x.dev && D.dev==x.dev);
+
+#if defined(_WITH_CUDA) && defined(_WITH_CUBLAS)
+      if(r.dev>0){
+	cublas(r,x,D,B,L,n);
+	return;
+      }
+#endif
+
+      GElibMultiLoop(B,[&](const int b){
+	  auto v=r.slice0(b);
+	  cnine::Ctensor_add_mprod_AA()(v,D,x.slice0(b));
+	});
+    }
+
+
+  private: // ---- cuBLAS backend ----------------------------------------------------------------------------
+
+
+#if defined(_WITH_CUDA) && defined(_WITH_CUBLAS)
+
+    // Row-major r_b=D x_b is column-major r_b^T=x_b^T D^T, which is
+    // what the buffers already hold when read with their row strides
+    // as leading dimensions, so no transposition is needed.
+    void cublas(const cnine::Ctensor3_view& r, const cnine::Ctensor3_view& x, const cnine::Ctensor2_view& D,
+      const int B, const int L, const int n){
+
+      GELIB_ASSRT(x.s2==1 && r.s2==1 && D.s1==1);
+
+      static cublasHandle_t handle=[](){cublasHandle_t h; cublasCreate(&h); return h;}();
+      const float one=1.0;
+      const float mone=-1.0;
+
+      auto gemm=[&](const float* A, const long long sA, const float* Bm, float* C, const long long sC, const float* alpha){
+	GELIB_ASSRT(cublasSgemmStridedBatched(handle,CUBLAS_OP_N,CUBLAS_OP_N,n,L,L,
+	    alpha,A,x.s1,sA,Bm,D.s0,0,&one,C,r.s1,sC,B)==CUBLAS_STATUS_SUCCESS);
+      };
+
+      // re(r) += re(D) re(x) - im(D) im(x); im(r) += re(D) im(x) + im(D) re(x)
+      gemm(x.arr,x.s0,D.arr,r.arr,r.s0,&one);
+      gemm(x.arrc,x.s0,D.arrc,r.arr,r.s0,&mone);
+      gemm(x.arrc,x.s0,D.arr,r.arrc,r.s0,&one);
+      gemm(x.arr,x.s0,D.arrc,r.arrc,r.s0,&one);
+    }
+
+#endif
+
+  };
+
+}
+
+#endif
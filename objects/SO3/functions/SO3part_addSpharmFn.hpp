@@ -12,24 +12,36 @@
 #define _SO3part_addSpharmFn
 
 #include "GElib_base.hpp"
+#include "GElibCudaGraphs.hpp"
 #include "CtensorB.hpp"
 #include "SO3part3_view.hpp"
 #include "MultiLoop.hpp"
+#include "GElibNvtx.hpp"
 
 extern GElib::SO3_SPHgen SO3_sphGen;
 
 
 namespace GElib{
 
+  #ifdef _WITH_CUDA
+  void SO3partB_addSpharm_cu(const SO3part3_view& r, const cnine::Rtensor3_view& x, const cudaStream_t& stream);
+  #endif
+
 
   class SO3part_addSpharmFn{
   public:
 
     void operator()(SO3part3_view& r, const cnine::Rtensor3_view& x){
+      GELIB_NVTX_RANGE("Spharm");
 
       //cout<<x.n0<<" "<<x.n1<<" "<<x.n2<<" "<<x.s0<<" "<<x.s1<<" "<<x.s2<<endl;
 
-      CNINE_ASSRT(r.dev==0);
+      if(r.dev>0){
+	CNINE_ASSRT(x.dev>0);
+	GELIB_CUDA_STREAM(SO3partB_addSpharm_cu(r,x,stream));
+	return;
+      }
+
       CNINE_ASSRT(x.dev==0);
       int l=r.getl();
       int B=r.n0;
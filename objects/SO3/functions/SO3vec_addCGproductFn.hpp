@@ -0,0 +1,333 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3vec_addCGproductFn
+#define _SO3vec_addCGproductFn
+
+#include <algorithm>
+
+#include "GElib_base.hpp"
+#include "SO3part3_view.hpp"
+#include "SO3part_addCGproductFn.hpp"
+#include "SO3vec_addCGproduct_persistentFn.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibCudaGraphs.hpp"
+#include "GElibConfig.hpp"
+#include "GElibTimer.hpp"
+#include "GElibNvtx.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+extern GElib::GElibConfig* gelib_config;
+
+
+namespace GElib{
+
+  // One (l1,l2,l) term of a vec-level CG product: the output channel
+  // offset of its fragment and its CG table, resolved up front so that
+  // the bank's lock is never taken inside a parallel loop. A table of
+  // these fully describes the traversal for a (tau1,tau2,maxl)
+  // signature; SO3CGproductPlan memoizes such tables across calls.
+  struct SO3CGtriple{
+    int l1,l2,l,offs;
+    const SO3_CGcoeffs<float>* C;
+  };
+
+
+  // Fused vec-level CG product. Instead of issuing an independent
+  // part-level call for each (l1,l2,l) triple, which re-reads the same
+  // x and y parts from memory once per admissible output l, this kernel
+  // walks the triples (l1,l2)-major within a single batchwise traversal,
+  // so each input part pair is streamed once and every output l it feeds
+  // is computed while the pair is still in cache.
+
+  class SO3vec_addCGproductFn{
+  public:
+
+    // In overwrite mode the output parts are written directly instead of
+    // accumulated into: each batch slice is zeroed inside the parallel
+    // loop just before its triples run, so the caller can allocate the
+    // result raw and the usual full-tensor zero-fill pass disappears.
+    // CPU only; the device paths expect a zero-filled result.
+    bool overwrite=false;
+
+    SO3vec_addCGproductFn(const bool _overwrite=false): overwrite(_overwrite){}
+
+
+    void operator()(const vector<SO3part3_view>& r, const vector<SO3part3_view>& x,
+      const vector<SO3part3_view>& y){
+
+      const int L1=x.size()-1;
+      const int L2=y.size()-1;
+      const int L=r.size()-1;
+
+      vector<SO3CGtriple> triples;
+      vector<int> offs(r.size(),0);
+      for(int l1=0; l1<=L1; l1++)
+	for(int l2=0; l2<=L2; l2++)
+	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
+	    triples.push_back(SO3CGtriple{l1,l2,l,offs[l],&SO3_cgbank_cached<float>(CGindex(l1,l2,l))});
+	    offs[l]+=x[l1].n2*y[l2].n2;
+	  }
+
+      (*this)(r,x,y,triples);
+    }
+
+
+    // Precomputed-traversal form used by SO3CGproductPlan: the triple
+    // table is taken as given, so a repeated call pays only the
+    // dispatch below.
+    void operator()(const vector<SO3part3_view>& r, const vector<SO3part3_view>& x,
+      const vector<SO3part3_view>& y, const vector<SO3CGtriple>& triples){
+      GELIB_NVTX_RANGE("SO3vec_CGproduct");
+
+      const int L1=x.size()-1;
+      const int L2=y.size()-1;
+      const int L=r.size()-1;
+      const int B=x[0].n0;
+      const int dev=x[0].dev;
+
+      if(dev>0){
+	GELIB_CHECK(!overwrite,"overwrite mode of SO3vec_addCGproductFn is CPU only");
+#ifdef _WITH_CUDA
+	// Small-l, very-high-batch products are drained by a single
+	// persistent kernel launch instead of one launch per triple;
+	// see SO3vec_addCGproduct_persistentFn.
+	if(gelib_config && B>=gelib_config->SO3vec_CGproduct_persistent_batch &&
+	  L1<=SO3vec_addCGproduct_persistentFn::maxl && L2<=SO3vec_addCGproduct_persistentFn::maxl &&
+	  L<=SO3vec_addCGproduct_persistentFn::maxl && gelib_cuda_current_stream==0){
+	  SO3vec_addCGproduct_persistentFn()(r,x,y);
+	  return;
+	}
+
+	// Heterogeneous co-scheduling: the smallest fragments, whose
+	// kernels cannot fill the GPU anyway, are staged to the host and
+	// computed on the thread pool while the large ones run on the
+	// stream pool; see coschedule() below.
+	if(gelib_config && gelib_config->hetero_coschedule && gelib_cuda_current_stream==0 &&
+	  coschedule(r,x,y,triples)) return;
+
+	// The triples write disjoint output regions, so their kernels
+	// can run concurrently: fan them out round-robin over a pool of
+	// streams and join at the end. Small kernels that individually
+	// cannot fill the GPU then overlap. Disabled while an external
+	// stream (graph capture) is active.
+	const int nstreams=gelib_config? gelib_config->cuda_nstreams : 1;
+	if(nstreams>1 && gelib_cuda_current_stream==0){
+	  int i=0;
+	  for(auto& t:triples){
+	    gelib_cuda_current_stream=gelib_cuda_streams.get(i++,nstreams);
+	    SO3part_addCGproductFn()(r[t.l],x[t.l1],y[t.l2],t.offs);
+	  }
+	  gelib_cuda_current_stream=0;
+	  gelib_cuda_streams.sync(nstreams);
+	  return;
+	}
+#endif
+	for(auto& t:triples)
+	  SO3part_addCGproductFn()(r[t.l],x[t.l1],y[t.l2],t.offs);
+	return;
+      }
+
+      GElibMultiLoop(B,[&](const int b){
+	  if(overwrite)
+	    for(int l=0; l<=L; l++){
+	      SO3part2_view rs=r[l].slice0(b);
+	      for(int m=-l; m<=l; m++)
+		for(int j=0; j<rs.n1; j++)
+		  rs.set(m,j,0);
+	    }
+	  for(auto& t:triples){
+	    SO3part2_view rs=r[t.l].slice0(b);
+	    SO3part2_view xs=x[t.l1].slice0(b);
+	    SO3part2_view ys=y[t.l2].slice0(b);
+	    const auto& C=*t.C;
+	    const int N1=xs.n1;
+	    const int N2=ys.n1;
+
+	    if(SO3part_addCGproduct_simd(rs,xs,ys,C,t.offs)) continue;
+
+	    int offs=t.offs;
+	    for(int n1=0; n1<N1; n1++){
+	      for(auto& e:C.nonzeros){
+		const complex<float> u=e.c*xs(e.m1-t.l1,n1);
+		for(int n2=0; n2<N2; n2++)
+		  rs.inc(e.m-t.l,offs+n2,u*ys(e.m2-t.l2,n2));
+	      }
+	      offs+=N2;
+	    }
+	  }
+	});
+    }
+
+
+  private: // ---- Heterogeneous co-scheduling ---------------------------------------------------------------
+
+#ifdef _WITH_CUDA
+
+    // Splits the triples between host and device by predicted cost and
+    // runs the two shares concurrently. Per-triple times on each
+    // processor are predicted from the observed throughput history in
+    // gelib_roofline (falling back to the configured peaks before any
+    // history exists); triples are moved to the host, smallest GPU cost
+    // first, as long as the host share's predicted time stays below the
+    // device share's, so neither processor becomes the critical path.
+    // The host share's inputs and output fragments are staged through a
+    // dedicated copy stream after the device share has been launched,
+    // computed with the same per-batch kernels as the CPU path (timed
+    // through CGproductTimer, which is what keeps the cost model
+    // calibrated), and the fragments copied back. Returns false -- and
+    // the caller falls through to the plain stream fan-out -- when the
+    // split assigns nothing to the host or the views are not regular
+    // enough for the 2D fragment copies.
+    bool coschedule(const vector<SO3part3_view>& r, const vector<SO3part3_view>& x,
+      const vector<SO3part3_view>& y, const vector<SO3CGtriple>& triples){
+
+      const int B=x[0].n0;
+      const int dev=x[0].dev;
+      const int T=triples.size();
+
+      for(auto& p:r) if(!p.is_regular()) return false;
+      for(auto& p:x) if(!p.is_regular()) return false;
+      for(auto& p:y) if(!p.is_regular()) return false;
+
+      vector<double> tcpu(T);
+      vector<double> tgpu(T);
+      for(int i=0; i<T; i++){
+	const auto& t=triples[i];
+	const int N1=x[t.l1].n2;
+	const int N2=y[t.l2].n2;
+	const double ops=((double)B)*t.C->nonzeros.size()*N1*N2;
+	tcpu[i]=ops/gelib_roofline.rate(t.l1,t.l2,t.l,B,N1,N2,0);
+	tgpu[i]=ops/gelib_roofline.rate(t.l1,t.l2,t.l,B,N1,N2,dev);
+      }
+
+      vector<int> ix(T);
+      for(int i=0; i<T; i++) ix[i]=i;
+      std::sort(ix.begin(),ix.end(),[&](const int a, const int b){return tgpu[a]<tgpu[b];});
+
+      double gpu_time=0;
+      for(int i=0; i<T; i++) gpu_time+=tgpu[i];
+      double cpu_time=0;
+      vector<bool> on_cpu(T,false);
+      vector<int> cpuix;
+      for(auto i:ix){
+	if((int)cpuix.size()==T-1) break;
+	if(cpu_time+tcpu[i]>gpu_time-tgpu[i]) break;
+	on_cpu[i]=true;
+	cpuix.push_back(i);
+	cpu_time+=tcpu[i];
+	gpu_time-=tgpu[i];
+      }
+      if(cpuix.size()==0) return false;
+
+      // Device share first, so the GPU is busy while the host stages.
+      const int nstreams=std::max(1,gelib_config->cuda_nstreams);
+      int si=0;
+      for(int i=0; i<T; i++){
+	if(on_cpu[i]) continue;
+	const auto& t=triples[i];
+	gelib_cuda_current_stream=gelib_cuda_streams.get(si++,nstreams);
+	SO3part_addCGproductFn()(r[t.l],x[t.l1],y[t.l2],t.offs);
+      }
+      gelib_cuda_current_stream=0;
+
+      // Host copies of the input parts the host share reads, on a copy
+      // stream of their own so the compute streams are not serialized;
+      // the stream is synchronized before the host compute starts, so
+      // pageable buffers suffice.
+      cudaStream_t cstream=gelib_cuda_streams.get(nstreams,nstreams+1);
+      vector<char> xneed(x.size(),0);
+      vector<char> yneed(y.size(),0);
+      for(auto i:cpuix){xneed[triples[i].l1]=1; yneed[triples[i].l2]=1;}
+      vector<vector<float> > xbuf(x.size());
+      vector<vector<float> > ybuf(y.size());
+      for(int l1=0; l1<(int)x.size(); l1++)
+	if(xneed[l1]){
+	  const size_t n=((size_t)x[l1].n0)*x[l1].s0;
+	  xbuf[l1].resize(2*n);
+	  CUDA_SAFE(cudaMemcpyAsync(xbuf[l1].data(),x[l1].arr,n*sizeof(float),cudaMemcpyDeviceToHost,cstream));
+	  CUDA_SAFE(cudaMemcpyAsync(xbuf[l1].data()+n,x[l1].arrc,n*sizeof(float),cudaMemcpyDeviceToHost,cstream));
+	}
+      for(int l2=0; l2<(int)y.size(); l2++)
+	if(yneed[l2]){
+	  const size_t n=((size_t)y[l2].n0)*y[l2].s0;
+	  ybuf[l2].resize(2*n);
+	  CUDA_SAFE(cudaMemcpyAsync(ybuf[l2].data(),y[l2].arr,n*sizeof(float),cudaMemcpyDeviceToHost,cstream));
+	  CUDA_SAFE(cudaMemcpyAsync(ybuf[l2].data()+n,y[l2].arrc,n*sizeof(float),cudaMemcpyDeviceToHost,cstream));
+	}
+
+      // The output fragments are strided column ranges of their r part,
+      // brought down into compact planar buffers with 2D copies and
+      // accumulated into in place; the GPU share writes disjoint column
+      // ranges, so copying them back while it runs is safe.
+      vector<vector<float> > fbuf(cpuix.size());
+      for(int j=0; j<(int)cpuix.size(); j++){
+	const auto& t=triples[cpuix[j]];
+	const SO3part3_view& R=r[t.l];
+	const int n=x[t.l1].n2*y[t.l2].n2;
+	const size_t rows=((size_t)R.n0)*R.n1;
+	fbuf[j].resize(2*rows*n);
+	CUDA_SAFE(cudaMemcpy2DAsync(fbuf[j].data(),n*sizeof(float),R.arr+t.offs,R.s1*sizeof(float),
+	    n*sizeof(float),rows,cudaMemcpyDeviceToHost,cstream));
+	CUDA_SAFE(cudaMemcpy2DAsync(fbuf[j].data()+rows*n,n*sizeof(float),R.arrc+t.offs,R.s1*sizeof(float),
+	    n*sizeof(float),rows,cudaMemcpyDeviceToHost,cstream));
+      }
+      CUDA_SAFE(cudaStreamSynchronize(cstream));
+
+      for(int j=0; j<(int)cpuix.size(); j++){
+	const auto& t=triples[cpuix[j]];
+	const int N1=x[t.l1].n2;
+	const int N2=y[t.l2].n2;
+	const int n=N1*N2;
+	const size_t rows=((size_t)r[t.l].n0)*r[t.l].n1;
+	SO3part3_view xv=SO3part3_view::planar(xbuf[t.l1].data(),xbuf[t.l1].data()+xbuf[t.l1].size()/2,B,t.l1,N1);
+	SO3part3_view yv=SO3part3_view::planar(ybuf[t.l2].data(),ybuf[t.l2].data()+ybuf[t.l2].size()/2,B,t.l2,N2);
+	SO3part3_view rv=SO3part3_view::planar(fbuf[j].data(),fbuf[j].data()+rows*n,B,t.l,n);
+	const auto& C=*t.C;
+	CGproductTimer timer(t.l1,t.l2,t.l,B,N1,N2,0,B*C.nonzeros.size()*N1*N2);
+	GElibMultiLoop(B,[&](const int b){
+	    SO3part2_view rs=rv.slice0(b);
+	    SO3part2_view xs=xv.slice0(b);
+	    SO3part2_view ys=yv.slice0(b);
+	    if(SO3part_addCGproduct_simd(rs,xs,ys,C,0)) return;
+	    int offs=0;
+	    for(int n1=0; n1<N1; n1++){
+	      for(auto& e:C.nonzeros){
+		const complex<float> u=e.c*xs(e.m1-t.l1,n1);
+		for(int n2=0; n2<N2; n2++)
+		  rs.inc(e.m-t.l,offs+n2,u*ys(e.m2-t.l2,n2));
+	      }
+	      offs+=N2;
+	    }
+	  });
+      }
+
+      for(int j=0; j<(int)cpuix.size(); j++){
+	const auto& t=triples[cpuix[j]];
+	const SO3part3_view& R=r[t.l];
+	const int n=x[t.l1].n2*y[t.l2].n2;
+	const size_t rows=((size_t)R.n0)*R.n1;
+	CUDA_SAFE(cudaMemcpy2DAsync(R.arr+t.offs,R.s1*sizeof(float),fbuf[j].data(),n*sizeof(float),
+	    n*sizeof(float),rows,cudaMemcpyHostToDevice,cstream));
+	CUDA_SAFE(cudaMemcpy2DAsync(R.arrc+t.offs,R.s1*sizeof(float),fbuf[j].data()+rows*n,n*sizeof(float),
+	    n*sizeof(float),rows,cudaMemcpyHostToDevice,cstream));
+      }
+      CUDA_SAFE(cudaStreamSynchronize(cstream));
+      gelib_cuda_streams.sync(nstreams);
+      return true;
+    }
+
+#endif
+
+  };
+
+}
+
+#endif
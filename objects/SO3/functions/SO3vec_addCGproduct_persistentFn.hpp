@@ -0,0 +1,111 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3vec_addCGproduct_persistentFn
+#define _SO3vec_addCGproduct_persistentFn
+
+#include "GElib_base.hpp"
+#include "GElibCudaGraphs.hpp"
+#include "SO3part3_view.hpp"
+#include "SO3_CGbank.hpp"
+#include "GElibNvtx.hpp"
+
+extern GElib::SO3_CGbank SO3_cgbank;
+
+
+namespace GElib{
+
+#ifdef _WITH_CUDA
+
+  // One unit of work for the persistent CG product kernel: a batch
+  // chunk of a single (l1,l2,l) combination, with the operand pointers,
+  // strides and the device-side packed CG table resolved on the host.
+
+  struct SO3CGworkItem{
+    float* rarr; float* rarrc;
+    const float* xarr; const float* xarrc;
+    const float* yarr; const float* yarrc;
+    int b0, nb;
+    int l1, l2, l;
+    int N1, N2;
+    int rs0, rs1, rs2;
+    int xs0, xs1, xs2;
+    int ys0, ys1, ys2;
+    int offs;
+    const int32_t* nzix;
+    const float* nzc;
+    int nnz;
+  };
+
+  void SO3vecB_addCGproduct_persistent_cu(const vector<SO3CGworkItem>& items, const cudaStream_t& stream);
+  void SO3vecB_persistent_cgtable(const int l1, const int l2, const int l,
+    const int32_t* hix, const float* hc, const int nnz, const int32_t** dix, const float** dc);
+
+
+  // Persistent-kernel execution of a whole vec-level CG product: a
+  // fixed grid of CTAs drains a work queue of (batch-chunk,
+  // l-combination) items in a single launch. For l<=2 with batch sizes
+  // in the tens of thousands this removes the per-combination launch
+  // overhead and tail effects that dominate the individual kernels.
+
+  class SO3vec_addCGproduct_persistentFn{
+  public:
+
+    static constexpr int maxl=2;
+    static constexpr int chunk=4096;
+
+    void operator()(const vector<SO3part3_view>& r, const vector<SO3part3_view>& x,
+      const vector<SO3part3_view>& y){
+      GELIB_NVTX_RANGE("SO3vec_CGproduct_persistent");
+
+      const int L1=x.size()-1;
+      const int L2=y.size()-1;
+      const int L=r.size()-1;
+      const int B=x[0].n0;
+
+      GELIB_ASSRT(L1<=maxl && L2<=maxl && L<=maxl);
+
+      vector<SO3CGworkItem> items;
+      vector<int> offs(r.size(),0);
+      for(int l1=0; l1<=L1; l1++)
+	for(int l2=0; l2<=L2; l2++)
+	  for(int l=std::abs(l2-l1); l<=l1+l2 && l<=L; l++){
+	    auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+	    const int32_t* dix;
+	    const float* dc;
+	    SO3vecB_persistent_cgtable(l1,l2,l,C.packed_ix.data(),C.packed_c.data(),C.packed_ix.size(),&dix,&dc);
+	    for(int b0=0; b0<B; b0+=chunk){
+	      SO3CGworkItem w;
+	      w.rarr=r[l].arr; w.rarrc=r[l].arrc;
+	      w.xarr=x[l1].arr; w.xarrc=x[l1].arrc;
+	      w.yarr=y[l2].arr; w.yarrc=y[l2].arrc;
+	      w.b0=b0; w.nb=std::min(chunk,B-b0);
+	      w.l1=l1; w.l2=l2; w.l=l;
+	      w.N1=x[l1].n2; w.N2=y[l2].n2;
+	      w.rs0=r[l].s0; w.rs1=r[l].s1; w.rs2=r[l].s2;
+	      w.xs0=x[l1].s0; w.xs1=x[l1].s1; w.xs2=x[l1].s2;
+	      w.ys0=y[l2].s0; w.ys1=y[l2].s1; w.ys2=y[l2].s2;
+	      w.offs=offs[l];
+	      w.nzix=dix; w.nzc=dc; w.nnz=C.packed_ix.size();
+	      items.push_back(w);
+	    }
+	    offs[l]+=x[l1].n2*y[l2].n2;
+	  }
+
+      GELIB_CUDA_STREAM(SO3vecB_addCGproduct_persistent_cu(items,stream));
+    }
+
+  };
+
+#endif
+
+}
+
+#endif
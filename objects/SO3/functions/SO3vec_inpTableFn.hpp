@@ -0,0 +1,106 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3vec_inpTableFn
+#define _SO3vec_inpTableFn
+
+#include "GElib_base.hpp"
+#include "CtensorB.hpp"
+#include "SO3part3_view.hpp"
+#include "GElibThreadPool.hpp"
+#include "GElibNvtx.hpp"
+
+
+namespace GElib{
+
+  // One part of a fused vec-level invariant reduction: input pointers
+  // and strides of the x and y operands plus the part's column offset
+  // in the output table. A vector of these describes the whole vec, so
+  // the device reduction runs as a single launch.
+  struct SO3redItem{
+    const float* xr; const float* xi;
+    const float* yr; const float* yi;
+    int xs0,xs1,xs2;
+    int ys0,ys1,ys2;
+    int m21;    // 2l+1
+    int n;      // number of channels
+    int offs;   // column offset of this part in the table
+  };
+
+  #ifdef _WITH_CUDA
+  void SO3vecB_inp_table_cu(const cnine::Ctensor2_view& r, const std::vector<SO3redItem>& items,
+    const cudaStream_t& stream);
+  #endif
+
+
+  // Fused invariant reduction: fills the full per-(l,channel) table
+  // r(b,offs_l+c)=sum_m conj(x_l(b,m,c))*y_l(b,m,c) for every part of
+  // the vec in a single pass -- one kernel launch on the device, one
+  // batch-parallel sweep on the host -- instead of one per-part
+  // reduction with a host synchronization between each. With y==x the
+  // real plane of the table holds the per-channel squared norms and
+  // the imaginary plane vanishes.
+
+  class SO3vec_inpTableFn{
+  public:
+
+    void operator()(const cnine::Ctensor2_view& _r, const vector<SO3part3_view>& x,
+      const vector<SO3part3_view>& y){
+      GELIB_NVTX_RANGE("SO3vec_inp_table");
+
+      const int L=x.size()-1;
+      const int B=x[0].n0;
+      const int dev=_r.dev;
+      GELIB_ASSRT(x.size()==y.size());
+      GELIB_ASSRT(_r.n0==B);
+
+      vector<int> offs(x.size(),0);
+      int total=0;
+      for(int l=0; l<=L; l++){
+	GELIB_ASSRT(x[l].n2==y[l].n2);
+	offs[l]=total;
+	total+=x[l].n2;
+      }
+      GELIB_ASSRT(_r.n1==total);
+
+      if(dev>0){
+#ifdef _WITH_CUDA
+	std::vector<SO3redItem> items;
+	for(int l=0; l<=L; l++){
+	  if(x[l].n2==0) continue;
+	  items.push_back(SO3redItem{x[l].arr,x[l].arrc,y[l].arr,y[l].arrc,
+	      x[l].s0,x[l].s1,x[l].s2,y[l].s0,y[l].s1,y[l].s2,2*l+1,x[l].n2,offs[l]});
+	}
+	CUDA_STREAM(SO3vecB_inp_table_cu(_r,items,stream));
+#endif
+	return;
+      }
+
+      cnine::Ctensor2_view r=_r;
+      GElibMultiLoop(B,[&](const int b){
+	  for(int l=0; l<=L; l++){
+	    SO3part2_view xs=x[l].slice0(b);
+	    SO3part2_view ys=y[l].slice0(b);
+	    const int n=x[l].n2;
+	    for(int c=0; c<n; c++){
+	      complex<float> s=0;
+	      for(int m=-l; m<=l; m++)
+		s+=std::conj(xs(m,c))*ys(m,c);
+	      r.set(b,offs[l]+c,s);
+	    }
+	  }
+	});
+    }
+
+  };
+
+}
+
+#endif
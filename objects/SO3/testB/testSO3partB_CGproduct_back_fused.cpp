@@ -0,0 +1,53 @@
+#include "GElib_base.cpp"
+#include "SO3partB.hpp"
+#include "GElibSession.hpp"
+
+
+using namespace cnine;
+using namespace GElib;
+
+
+// The fused backward pass add_CGproduct_back computes both operand
+// gradients from a single sweep over the coefficient nonzeros; it must
+// agree with the two-pass baseline of separate add_CGproduct_back0 and
+// add_CGproduct_back1 calls.
+
+int main(int argc, char** argv){
+  GElibSession session;
+  cout<<endl;
+
+  const int b=2;
+  const int n1=3;
+  const int n2=2;
+
+  double err=0;
+  for(int l1=1; l1<=3; l1++)
+    for(int l2=1; l2<=3; l2++)
+      for(int l=std::abs(l1-l2); l<=l1+l2; l++){
+
+	SO3partB x=SO3partB::gaussian(b,l1,n1);
+	SO3partB y=SO3partB::gaussian(b,l2,n2);
+	SO3partB g=SO3partB::gaussian(b,l,n1*n2);
+
+	SO3partB xg0=SO3partB::zero(b,l1,n1);
+	SO3partB yg0=SO3partB::zero(b,l2,n2);
+	SO3partB::add_CGproduct_back(xg0,yg0,g,x,y);
+
+	SO3partB xg1=SO3partB::zero(b,l1,n1);
+	SO3partB yg1=SO3partB::zero(b,l2,n2);
+	xg1.add_CGproduct_back0(g,y);
+	yg1.add_CGproduct_back1(g,x);
+
+	const double d0=sqrt(xg0.diff2(xg1))/sqrt(xg1.norm2());
+	const double d1=sqrt(yg0.diff2(yg1))/sqrt(yg1.norm2());
+	cout<<l1<<" "<<l2<<" "<<l<<": diff2="<<d0<<" "<<d1<<endl;
+	err=std::max(err,std::max(d0,d1));
+      }
+  cout<<endl;
+
+  if(err>1e-5){
+    cout<<"FAILED"<<endl;
+    return 1;
+  }
+  cout<<endl;
+}
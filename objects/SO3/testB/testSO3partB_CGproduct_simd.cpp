@@ -0,0 +1,91 @@
+#include "GElib_base.cpp"
+#include "SO3partB.hpp"
+#include "GElibSession.hpp"
+
+
+using namespace cnine;
+using namespace GElib;
+
+extern GElib::SO3_CGbank SO3_cgbank;
+
+
+// Agreement of the vectorized CPU CG kernels with the scalar reference:
+// first the SO3part_cmadd / SO3part_cmadd_planar primitives against
+// their scalar loops on odd lengths (so both the vector body and the
+// remainder are covered), then a full part-level CG product against an
+// explicit loop over the coefficient nonzeros.
+
+int main(int argc, char** argv){
+  GElibSession session;
+  cout<<endl;
+
+  cout<<"SIMD level: "<<SO3part_simd_level()<<endl<<endl;
+
+  double err=0;
+
+  for(int n=1; n<=37; n+=3){
+    vector<float> y(2*n), r1(2*n), r2(2*n);
+    vector<float> yr(n), yi(n), rr1(n), ri1(n), rr2(n), ri2(n);
+    for(int i=0; i<2*n; i++){
+      y[i]=((i*2654435761u)%1000)/500.0-1.0;
+      r1[i]=r2[i]=((i*40503u)%1000)/500.0-1.0;
+    }
+    for(int i=0; i<n; i++){
+      yr[i]=y[2*i]; yi[i]=y[2*i+1];
+      rr1[i]=rr2[i]=r1[2*i]; ri1[i]=ri2[i]=r1[2*i+1];
+    }
+    const float cr=0.7, ci=-0.4;
+
+    SO3part_cmadd(r1.data(),y.data(),cr,ci,n);
+    SO3part_cmadd_scalar(r2.data(),y.data(),cr,ci,n);
+    for(int i=0; i<2*n; i++) err=std::max(err,(double)std::abs(r1[i]-r2[i]));
+
+    SO3part_cmadd_planar(rr1.data(),ri1.data(),yr.data(),yi.data(),cr,ci,n);
+    for(int i=0; i<n; i++){
+      rr2[i]+=cr*yr[i]-ci*yi[i];
+      ri2[i]+=cr*yi[i]+ci*yr[i];
+    }
+    for(int i=0; i<n; i++){
+      err=std::max(err,(double)std::abs(rr1[i]-rr2[i]));
+      err=std::max(err,(double)std::abs(ri1[i]-ri2[i]));
+    }
+  }
+  cout<<"cmadd vs scalar: max err="<<err<<endl<<endl;
+
+  const int b=2;
+  const int l1=2;
+  const int l2=3;
+  const int n1=3;
+  const int n2=5;
+
+  double err2=0;
+  for(int l=l2-l1; l<=l1+l2; l++){
+    SO3partB x=SO3partB::gaussian(b,l1,n1);
+    SO3partB y=SO3partB::gaussian(b,l2,n2);
+
+    SO3partB w=x.CGproduct(y,l);
+
+    SO3partB ref=SO3partB::zero(b,l,n1*n2);
+    auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+    for(int _b=0; _b<b; _b++){
+      SO3part2_view rv=ref.view3().slice0(_b);
+      SO3part2_view xv=x.view3().slice0(_b);
+      SO3part2_view yv=y.view3().slice0(_b);
+      for(int i=0; i<n1; i++)
+	for(int j=0; j<n2; j++)
+	  for(auto& e:C.nonzeros)
+	    rv.inc(e.m-l,i*n2+j,e.c*xv(e.m1-l1,i)*yv(e.m2-l2,j));
+    }
+
+    const double d=sqrt(w.diff2(ref))/sqrt(ref.norm2());
+    cout<<l1<<" "<<l2<<" "<<l<<": diff2="<<d<<endl;
+    err2=std::max(err2,d);
+  }
+  cout<<endl;
+
+  if(err>1e-5 || err2>1e-5){
+    cout<<"FAILED"<<endl;
+    return 1;
+  }
+  cout<<endl;
+}
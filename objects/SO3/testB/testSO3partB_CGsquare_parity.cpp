@@ -0,0 +1,59 @@
+#include "GElib_base.cpp"
+#include "SO3partB.hpp"
+#include "GElibSession.hpp"
+
+
+using namespace cnine;
+using namespace GElib;
+
+
+// The CG square exploits the parity symmetry C(m2,m1)=(-1)^l C(m1,m2)
+// of the x==y coefficient table: only the upper triangle of the (m1,m2)
+// space is iterated and only the unique channel pairs (n1,n2) with
+// n2<n1+diag are emitted, where the diagonal pairs survive only for
+// even l. Each retained column must match the corresponding column of
+// the full CG product of x with itself.
+
+int main(int argc, char** argv){
+  GElibSession session;
+  cout<<endl;
+
+  const int b=2;
+  const int N=3;
+
+  double err=0;
+  for(int l1=1; l1<=3; l1++)
+    for(int l=0; l<=2*l1; l++){
+      const int diag=1-l%2;
+
+      SO3partB x=SO3partB::gaussian(b,l1,N);
+      SO3partB sq=x.CGsquare(l);
+      SO3partB full=x.CGproduct(x,l);
+
+      double d=0;
+      double nrm=0;
+      for(int _b=0; _b<b; _b++){
+	SO3part2_view sv=sq.view3().slice0(_b);
+	SO3part2_view fv=full.view3().slice0(_b);
+	for(int n1=0; n1<N; n1++)
+	  for(int n2=0; n2<n1+diag; n2++){
+	    const int cs=(n1*(n1-1))/2+n1*diag+n2;
+	    const int cf=n1*N+n2;
+	    for(int m=-l; m<=l; m++){
+	      d+=std::norm(sv(m,cs)-fv(m,cf));
+	      nrm+=std::norm(fv(m,cf));
+	    }
+	  }
+      }
+      const double rel=(nrm>0? sqrt(d/nrm) : sqrt(d));
+      cout<<l1<<" "<<l<<": diff2="<<rel<<endl;
+      err=std::max(err,rel);
+    }
+  cout<<endl;
+
+  if(err>1e-5){
+    cout<<"FAILED"<<endl;
+    return 1;
+  }
+  cout<<endl;
+}
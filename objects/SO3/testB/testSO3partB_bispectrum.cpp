@@ -0,0 +1,52 @@
+#include "GElib_base.cpp"
+#include "SO3partB.hpp"
+#include "GElibSession.hpp"
+
+
+using namespace cnine;
+using namespace GElib;
+
+
+// Each entry of the fused bispectrum-style triple contraction is a
+// rotation invariant: recomputing the table from rotated operands must
+// reproduce it up to roundoff.
+
+int main(int argc, char** argv){
+  GElibSession session;
+  cout<<endl;
+
+  const int b=2;
+  const int l1=2;
+  const int l2=2;
+  const int n1=2;
+  const int n2=2;
+  const int n3=3;
+
+  SO3element R(fill::uniform);
+
+  double err=0;
+  for(int l=std::abs(l1-l2); l<=l1+l2; l++){
+
+    SO3partB x=SO3partB::gaussian(b,l1,n1);
+    SO3partB y=SO3partB::gaussian(b,l2,n2);
+    SO3partB z=SO3partB::gaussian(b,l,n3);
+
+    CtensorB B0=x.bispectrum(y,z);
+
+    SO3partB xR=x.rotate(R);
+    SO3partB yR=y.rotate(R);
+    SO3partB zR=z.rotate(R);
+    CtensorB B1=xR.bispectrum(yR,zR);
+
+    const double d=sqrt(B0.diff2(B1))/sqrt(B0.norm2());
+    cout<<l1<<" "<<l2<<" "<<l<<": diff2="<<d<<endl;
+    err=std::max(err,d);
+  }
+  cout<<endl;
+
+  if(err>1e-4){
+    cout<<"FAILED"<<endl;
+    return 1;
+  }
+  cout<<endl;
+}
@@ -0,0 +1,43 @@
+#include "GElib_base.cpp"
+#include "SO3partB.hpp"
+#include "GElibSession.hpp"
+
+
+using namespace cnine;
+using namespace GElib;
+
+
+// The factored ZYZ rotation path builds no dense Wigner matrix; it must
+// agree with the dense rotate() across l (the tables and arithmetic are
+// single precision, so agreement is to float roundoff, not machine
+// epsilon).
+
+int main(int argc, char** argv){
+  GElibSession session;
+  cout<<endl;
+
+  const int b=2;
+  const int n=3;
+
+  SO3element R(fill::uniform);
+
+  double err=0;
+  for(int l=0; l<=8; l++){
+
+    SO3partB x=SO3partB::gaussian(b,l,n);
+
+    SO3partB w=x.rotate(R);
+    SO3partB wz=x.rotateZYZ(R);
+
+    const double d=sqrt(w.diff2(wz))/sqrt(w.norm2());
+    cout<<"l="<<l<<": diff2="<<d<<endl;
+    err=std::max(err,d);
+  }
+  cout<<endl;
+
+  if(err>1e-4){
+    cout<<"FAILED"<<endl;
+    return 1;
+  }
+  cout<<endl;
+}
@@ -0,0 +1,51 @@
+#include "GElib_base.cpp"
+#include "SO3vecB.hpp"
+#include "SO3vecB_io.hpp"
+#include "GElibSession.hpp"
+
+#include <cstdio>
+
+
+using namespace cnine;
+using namespace GElib;
+
+
+// Round trip through the on-disk vec format: fp32 must reproduce the
+// vector bit for bit; the fp16 and int8 encodings are lossy and must
+// come back within the tolerance their element formats allow.
+
+int main(int argc, char** argv){
+  GElibSession session;
+  cout<<endl;
+
+  const int b=2;
+  SO3type tau({2,3,1});
+  const string path="testSO3vecB_io.tmp";
+
+  SO3vecB v=SO3vecB::gaussian(b,tau);
+
+  bool failed=false;
+  for(auto dtype:{SO3vecB_io_fp32,SO3vecB_io_fp16,SO3vecB_io_int8}){
+    save(v,path,dtype);
+    SO3vecB w=load_SO3vecB(path);
+
+    GELIB_ASSRT(w.getb()==b);
+    GELIB_ASSRT(w.get_tau()==tau);
+
+    double err=0;
+    for(int l=0; l<(int)tau.size(); l++)
+      err=std::max(err,sqrt(v.parts[l]->diff2(*w.parts[l]))/sqrt(v.parts[l]->norm2()));
+    cout<<"dtype="<<dtype<<": diff2="<<err<<endl;
+
+    const double tol=(dtype==SO3vecB_io_fp32? 0 : (dtype==SO3vecB_io_fp16? 2e-3 : 5e-2));
+    if(err>tol) failed=true;
+  }
+  std::remove(path.c_str());
+  cout<<endl;
+
+  if(failed){
+    cout<<"FAILED"<<endl;
+    return 1;
+  }
+  cout<<endl;
+}
@@ -17,6 +17,7 @@
 #include "TensorArrayVirtual.hpp"
 #include "SO3partArrayC.hpp"
 #include "SO3templates.hpp"
+#include "SO3bipartArray_reduceFn.hpp"
 
 
 namespace GElib{
@@ -108,6 +109,38 @@ namespace GElib{
 
 
 
+  public: // ---- Reductions ----------------------------------------------------------------------------------
+
+
+    // Reductions along array dimension d (see SO3bipartArray_reduceFn):
+    // each output cell is reduced by a single owner in a fixed order,
+    // so the results are deterministic on both CPU and GPU.
+
+    SO3bipartArray reduce_sum(const int d) const{
+      return reduce(d,SO3bipartArray_reduceFn::SUM);
+    }
+
+    SO3bipartArray reduce_mean(const int d) const{
+      return reduce(d,SO3bipartArray_reduceFn::MEAN);
+    }
+
+    // Elementwise max by complex modulus.
+    SO3bipartArray reduce_max(const int d) const{
+      return reduce(d,SO3bipartArray_reduceFn::MAX);
+    }
+
+    SO3bipartArray reduce(const int d, const int op) const{
+      Gdims adims=this->get_adims();
+      GELIB_ASSRT(d>=0 && d<(int)adims.size());
+      vector<int> radims;
+      for(int i=0; i<(int)adims.size(); i++)
+	if(i!=d) radims.push_back(adims[i]);
+      SO3bipartArray R=SO3bipartArray::zero(this->getb(),Gdims(radims),getl1(),getl2(),getn(),this->device());
+      SO3bipartArray_reduceFn()(R,*this,d,op);
+      return R;
+    }
+
+
   public: // ---- CG-products --------------------------------------------------------------------------------
 
 
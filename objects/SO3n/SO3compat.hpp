@@ -0,0 +1,77 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3compat
+#define _SO3compat
+
+#include "GElib_base.hpp"
+#include "SO3partB.hpp"
+#include "SO3vecB.hpp"
+#include "SO3partC.hpp"
+#include "SO3vecC.hpp"
+
+
+namespace GElib{
+
+  // Adapters between the legacy SO3partB/SO3vecB generation and the
+  // SO3n (SO3part/SO3vec) classes, for pipelines that straddle both
+  // APIs during migration.
+  //
+  // Towards the legacy types the adaptation is zero-copy: an SO3n view
+  // stores interleaved complex elements, which SO3partB::view_of
+  // represents exactly with float strides doubled and the imaginary
+  // offset set to 1, so as_SO3partB/as_SO3vecB return non-owning
+  // wrappers over the same storage and the whole B-generation API
+  // operates on it in place. The SO3n object must outlive the wrapper.
+  //
+  // The opposite direction cannot be zero-copy in general: a natively
+  // allocated SO3partB keeps its real block followed by its imaginary
+  // block, and the SO3n view types address whole complex elements, so
+  // no stride assignment makes one alias the other. to_SO3part/
+  // to_SO3vec therefore convert by copy; code that wants to avoid the
+  // copy should pass B-generation data to the kernel layer through the
+  // SO3part3_view conversions both generations share, which is free.
+
+  inline SO3partB as_SO3partB(const SO3partView<float>& x){
+    return SO3partB::view_of(x.dims[0],x.getl(),x.getn(),
+      const_cast<SO3partView<float>&>(x).arr.template ptr_as<float>(),
+      cnine::Gstrides({2*x.strides[0],2*x.strides[1],2*x.strides[2]}),1,x.device());
+  }
+
+  inline SO3vecB as_SO3vecB(const SO3vecView<float>& x){
+    SO3vecB R;
+    for(auto& p:x.parts)
+      R.parts.push_back(new SO3partB(as_SO3partB(*p.second)));
+    return R;
+  }
+
+  inline SO3part<float> to_SO3part(const SO3partB& x){
+    GELIB_CHECK(x.dev==0,"to_SO3part: layout conversion is CPU only; move the part to the host first");
+    SO3part<float> R=SO3part<float>::raw(x.getb(),x.getl(),x.getn(),0);
+    SO3part3_view rv=R;
+    SO3part3_view xv=x;
+    const int l=x.getl();
+    for(int b=0; b<x.getb(); b++)
+      for(int m=-l; m<=l; m++)
+	for(int i=0; i<x.getn(); i++)
+	  rv.set(b,m,i,xv(b,m,i));
+    return R;
+  }
+
+  inline SO3vec<float> to_SO3vec(const SO3vecB& x){
+    SO3vec<float> R;
+    for(int l=0; l<(int)x.parts.size(); l++)
+      R.parts[l]=new SO3partView<float>(to_SO3part(*x.parts[l]));
+    return R;
+  }
+
+}
+
+#endif
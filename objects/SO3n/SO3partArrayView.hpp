@@ -30,6 +30,10 @@
 #include "SO3part_addBlockedCGproduct_back0Fn.hpp"
 #include "SO3part_addBlockedCGproduct_back1Fn.hpp"
 
+#include "SO3part_addRBlockedCGproductFn.hpp"
+#include "SO3part_addRBlockedCGproduct_back0Fn.hpp"
+#include "SO3part_addRBlockedCGproduct_back1Fn.hpp"
+
 
 namespace GElib{
 
@@ -160,9 +164,87 @@ namespace GElib{
     }
 
 
+  public: // ---- Layout adapters ----------------------------------------------------------------------------
+
+
+    // Zero-copy layout adapters: each returns a view over the same
+    // buffer with transformed dims/strides. The Fn kernels address
+    // cells and channels through explicit strides, so the resulting
+    // non-canonical layouts flow through the kernel family without a
+    // repacking copy.
+
+
+    // Replaces the cell grid dims with _adims of the same total;
+    // requires the cell dims to be contiguous among themselves.
+    SO3partArrayView<RTYPE> reshape_adims(const Gdims& _adims) const{
+      GELIB_ASSRT(_adims.total()==get_adims().total());
+      const int K=nadims();
+      for(int i=1; i<K; i++)
+	GELIB_ASSRT(strides[i]==strides[i+1]*dims[i+1]);
+
+      vector<int> D;
+      vector<int> S;
+      D.push_back(dims[0]); S.push_back(strides[0]);
+      int s=strides[K];
+      for(int i=_adims.size()-1; i>=0; i--){
+	D.insert(D.begin()+1,_adims[i]);
+	S.insert(S.begin()+1,s);
+	s*=_adims[i];
+      }
+      D.push_back(dims(-2)); S.push_back(strides(-2));
+      D.push_back(dims(-1)); S.push_back(strides(-1));
+      return SO3partArrayView<RTYPE>(arr,_adims.size(),Gdims(D),cnine::GstridesB(S));
+    }
+
+
+    // Merges all cell dims into one flat cell dimension.
+    SO3partArrayView<RTYPE> fuse_cells() const{
+      return reshape_adims(Gdims({get_adims().total()}));
+    }
+
+
+    // Reorders the cell dims; a pure restride, so any layout is
+    // admissible.
+    SO3partArrayView<RTYPE> permute_adims(const vector<int>& pi) const{
+      const int K=nadims();
+      GELIB_ASSRT((int)pi.size()==K);
+      vector<int> D;
+      vector<int> S;
+      D.push_back(dims[0]); S.push_back(strides[0]);
+      for(int i=0; i<K; i++){
+	D.push_back(dims[1+pi[i]]);
+	S.push_back(strides[1+pi[i]]);
+      }
+      D.push_back(dims(-2)); S.push_back(strides(-2));
+      D.push_back(dims(-1)); S.push_back(strides(-1));
+      return SO3partArrayView<RTYPE>(arr,K,Gdims(D),cnine::GstridesB(S));
+    }
+
+
+    // Splits the channel dimension into h heads of n/h channels each,
+    // exposing the head index as an extra (innermost) cell dimension,
+    // so per-head products run as ordinary cellwise ops over a larger
+    // grid without slicing copies.
+    SO3partArrayView<RTYPE> split_channels(const int h) const{
+      const int n=getn();
+      GELIB_ASSRT(h>0 && n%h==0);
+      const int K=nadims();
+      vector<int> D;
+      vector<int> S;
+      for(int i=0; i<=K; i++){
+	D.push_back(dims[i]);
+	S.push_back(strides[i]);
+      }
+      D.push_back(h); S.push_back((n/h)*strides(-1));
+      D.push_back(dims(-2)); S.push_back(strides(-2));
+      D.push_back(n/h); S.push_back(strides(-1));
+      return SO3partArrayView<RTYPE>(arr,K+1,Gdims(D),cnine::GstridesB(S));
+    }
+
+
   public: // ---- CG-products --------------------------------------------------------------------------------
 
-    
+
     void add_CGproduct(const SO3partArrayView& x, const SO3partArrayView& y, const int _offs=0) const{
       cnine::reconcile_batched_array<SO3partArrayView>(*this,x,y,
 	[&](const auto& r, const auto& x, const auto& y){SO3part_addCGproductFn()(r,x,y,_offs);},
@@ -184,28 +266,19 @@ namespace GElib{
     void add_DiagCGproduct(const SO3partArrayView& x, const SO3partArrayView& y, const int _offs=0) const{
       cnine::reconcile_batched_array<SO3partArrayView>(*this,x,y,
 	[&](const auto& r, const auto& x, const auto& y){SO3part_addBlockedCGproductFn()(r,x,y,1,_offs);},
-	[&](const auto& r, const auto& x, const auto& y){
-	  GELIB_UNIMPL();
-	  //SO3part_addRBlockedCGproductFn()(r,x,y,1,_offs);
-	});
+	[&](const auto& r, const auto& x, const auto& y){SO3part_addRBlockedCGproductFn()(r,x,y,1,_offs);});
     }
 
     void add_DiagCGproduct_back0(const SO3partArrayView& g, const SO3partArrayView& y, const int _offs=0){
       cnine::reconcile_batched_array<SO3partArrayView>(*this,g,y,
 	[&](const auto& xg, const auto& g, const auto& y){SO3part_addBlockedCGproduct_back0Fn()(xg,g,y,1,_offs);},
-	[&](const auto& xg, const auto& g, const auto& y){
-	  GELIB_UNIMPL();
-	  //SO3part_addRBlockedCGproduct_back0Fn()(xg,g,y,1,_offs);
-	});
+	[&](const auto& xg, const auto& g, const auto& y){SO3part_addRBlockedCGproduct_back0Fn()(xg,g,y,1,_offs);});
     }
 
     void add_DiagCGproduct_back1(const SO3partArrayView& g, const SO3partArrayView& x, const int _offs=0){
       cnine::reconcile_batched_array<SO3partArrayView>(*this,g,x,
 	[&](const auto& yg, const auto& g, const auto& x){SO3part_addBlockedCGproduct_back1Fn()(yg,g,x,1,_offs);},
-	[&](const auto& yg, const auto& g, const auto& x){
-	  GELIB_UNIMPL();
-	  //SO3part_addRBlockedCGproduct_back1Fn()(yg,g,x,1,_offs);
-	});
+	[&](const auto& yg, const auto& g, const auto& x){SO3part_addRBlockedCGproduct_back1Fn()(yg,g,x,1,_offs);});
     }
 
 
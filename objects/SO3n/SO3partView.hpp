@@ -22,6 +22,7 @@
 #include "SO3part_addCGproductFn.hpp"
 #include "SO3part_addCGproduct_back0Fn.hpp"
 #include "SO3part_addCGproduct_back1Fn.hpp"
+#include "SO3part_addCGproductTFn.hpp"
 
 #include "SO3part_addRCGproductFn.hpp"
 #include "SO3part_addRCGproduct_back0Fn.hpp"
@@ -92,21 +93,36 @@ namespace GElib{
 
     
     void add_CGproduct(const SO3partView& x, const SO3partView& y, const int _offs=0) const{
-      cnine::reconcile_batches<SO3partView>(*this,x,y,
-	[&](const auto& r, const auto& x, const auto& y){SO3part_addCGproductFn()(r,x,y,_offs);},
-	[&](const auto& r, const auto& x, const auto& y){SO3part_addRCGproductFn()(r,x,y,_offs);});
+      if constexpr(!std::is_same<RTYPE,float>::value){
+	SO3part_addCGproductTFn<RTYPE>()(*this,x,y,_offs);
+	return;
+      }else{
+	cnine::reconcile_batches<SO3partView>(*this,x,y,
+	  [&](const auto& r, const auto& x, const auto& y){SO3part_addCGproductFn()(r,x,y,_offs);},
+	  [&](const auto& r, const auto& x, const auto& y){SO3part_addRCGproductFn()(r,x,y,_offs);});
+      }
     }
 
     void add_CGproduct_back0(const SO3partView& g, const SO3partView& y, const int _offs=0){
-      cnine::reconcile_batches<SO3partView>(*this,g,y,
-	[&](const auto& xg, const auto& g, const auto& y){SO3part_addCGproduct_back0Fn()(xg,g,y,_offs);},
-	[&](const auto& xg, const auto& g, const auto& y){SO3part_addRCGproduct_back0Fn()(xg,g,y,_offs);});
+      if constexpr(!std::is_same<RTYPE,float>::value){
+	SO3part_addCGproduct_back0TFn<RTYPE>()(*this,g,y,_offs);
+	return;
+      }else{
+	cnine::reconcile_batches<SO3partView>(*this,g,y,
+	  [&](const auto& xg, const auto& g, const auto& y){SO3part_addCGproduct_back0Fn()(xg,g,y,_offs);},
+	  [&](const auto& xg, const auto& g, const auto& y){SO3part_addRCGproduct_back0Fn()(xg,g,y,_offs);});
+      }
     }
 
     void add_CGproduct_back1(const SO3partView& g, const SO3partView& x, const int _offs=0){
-      cnine::reconcile_batches<SO3partView>(*this,g,x,
-	[&](const auto& yg, const auto& g, const auto& x){SO3part_addCGproduct_back1Fn()(yg,g,x,_offs);},
-	[&](const auto& yg, const auto& g, const auto& x){SO3part_addRCGproduct_back1Fn()(yg,g,x,_offs);});
+      if constexpr(!std::is_same<RTYPE,float>::value){
+	SO3part_addCGproduct_back1TFn<RTYPE>()(*this,g,x,_offs);
+	return;
+      }else{
+	cnine::reconcile_batches<SO3partView>(*this,g,x,
+	  [&](const auto& yg, const auto& g, const auto& x){SO3part_addCGproduct_back1Fn()(yg,g,x,_offs);},
+	  [&](const auto& yg, const auto& g, const auto& x){SO3part_addRCGproduct_back1Fn()(yg,g,x,_offs);});
+      }
     }
 
 
@@ -113,7 +113,7 @@ namespace GElib{
   template<typename TYPE>
   inline SO3vec<TYPE> CGproduct(const SO3vecView<TYPE>& x, const SO3vecView<TYPE>& y, const int maxl=-1){
     GELIB_ASSRT(x.getb()==y.getb());
-    SO3vec<TYPE> R=SO3vec<TYPE>::zero(x.getb(),GElib::CGproduct(x.get_tau(),y.get_tau(),maxl),x.device());
+    SO3vec<TYPE> R=SO3vec<TYPE>::zero(x.getb(),GElib::CGproduct_cached(x.get_tau(),y.get_tau(),maxl),x.device());
     R.add_CGproduct(x,y);
     //add_vCGproduct(R,x,y);
     return R;
@@ -0,0 +1,118 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _SO3bipartArray_reduceFn
+#define _SO3bipartArray_reduceFn
+
+#include "GElib_base.hpp"
+#include "SO3bipartArrayView.hpp"
+#include "GElibThreadPool.hpp"
+
+
+namespace GElib{
+
+#ifdef _WITH_CUDA
+  void SO3bipartArray_reduce_cu(float* rarr, const float* xarr, const int P, const int K,
+    const int S, const int D, const int op, const cudaStream_t& stream);
+#endif
+
+
+  // Reduction of an SO3bipartArray along one of its array dimensions:
+  // sum, mean, or elementwise max (by complex modulus) over the K
+  // cells of the reduced dimension, e.g. summing per-edge bipart
+  // features into per-node features. The cell grid is decomposed as
+  // (P,K,S) around the reduced dimension; each output cell is owned by
+  // one thread and reduced in a fixed accumulation order, so the
+  // result is deterministic by construction -- no atomics on either
+  // device. Requires the canonical contiguous layout of an owning
+  // array.
+
+  class SO3bipartArray_reduceFn{
+  public:
+
+    static constexpr int SUM=0;
+    static constexpr int MEAN=1;
+    static constexpr int MAX=2;
+
+    template<typename RTYPE>
+    void operator()(const SO3bipartArrayView<RTYPE>& r, const SO3bipartArrayView<RTYPE>& x,
+      const int d, const int op){
+
+      const int nad=x.nadims();
+      GELIB_ASSRT(d>=0 && d<nad);
+      GELIB_ASSRT(r.nadims()==nad-1);
+      GELIB_ASSRT(r.getb()==x.getb());
+      GELIB_ASSRT(r.get_ddims()==x.get_ddims());
+      GELIB_ASSRT(r.device()==x.device());
+
+      for(int i=0; i<x.ndims()-1; i++)
+	GELIB_ASSRT(x.strides[i]==x.strides[i+1]*x.dims[i+1]);
+      for(int i=0; i<r.ndims()-1; i++)
+	GELIB_ASSRT(r.strides[i]==r.strides[i+1]*r.dims[i+1]);
+      GELIB_ASSRT(x.strides(-1)==1 && r.strides(-1)==1);
+
+      int P=x.dims[0];
+      for(int i=0; i<d; i++) P*=x.dims[1+i];
+      const int K=x.dims[1+d];
+      int S=1;
+      for(int i=d+1; i<nad; i++) S*=x.dims[1+i];
+      const int D=2*x.get_ddims().total();
+
+      RTYPE* rarr=r.arr.template ptr_as<RTYPE>();
+      const RTYPE* xarr=x.arr.template ptr_as<RTYPE>();
+
+      if(r.device()>0){
+#ifdef _WITH_CUDA
+	CUDA_STREAM(SO3bipartArray_reduce_cu(rarr,xarr,P,K,S,D,op,stream));
+#else
+	GELIB_ERROR("GElib was compiled without CUDA support.");
+#endif
+	return;
+      }
+
+      const RTYPE c=RTYPE(1.0)/K;
+      GElibMultiLoop(P*S,[&](const int t){
+	  const int p=t/S;
+	  const int s=t%S;
+	  RTYPE* rr=rarr+((long long)(p*S+s))*D;
+	  const RTYPE* xx=xarr+((long long)((p*K)*S+s))*D;
+
+	  if(op==MAX){
+	    for(int j=0; j<D; j+=2){
+	      RTYPE re=xx[j];
+	      RTYPE im=xx[j+1];
+	      RTYPE best=re*re+im*im;
+	      for(int k=1; k<K; k++){
+		const RTYPE* row=xx+((long long)k)*S*D;
+		const RTYPE nrm=row[j]*row[j]+row[j+1]*row[j+1];
+		if(nrm>best){best=nrm; re=row[j]; im=row[j+1];}
+	      }
+	      rr[j]=re;
+	      rr[j+1]=im;
+	    }
+	    return;
+	  }
+
+	  for(int k=0; k<K; k++){
+	    const RTYPE* row=xx+((long long)k)*S*D;
+	    for(int j=0; j<D; j++)
+	      rr[j]+=row[j];
+	  }
+	  if(op==MEAN)
+	    for(int j=0; j<D; j++)
+	      rr[j]*=c;
+	});
+    }
+
+  };
+
+}
+
+#endif
@@ -15,8 +15,9 @@
 #include "CtensorB.hpp"
 #include "Ctensor3_view.hpp"
 #include "Ctensor4_view.hpp"
-#include "MultiLoop.hpp"
+#include "GElibThreadPool.hpp"
 #include "GElibTimer.hpp"
+#include "SO3part_addCGproduct_simd.hpp"
 
 extern GElib::SO3_CGbank SO3_cgbank;
 extern GElib::SO3_SPHgen SO3_sphGen;
@@ -35,7 +36,7 @@ namespace GElib{
       const int l=(_r.n1-1)/2;
       const int l1=(_x.n1-1)/2;
       const int l2=(_x.n2-1)/2;
- 
+
       const int N=_x.n3;
       const int B=_x.n0;
       const int dev=_r.dev;
@@ -46,12 +47,29 @@ namespace GElib{
 
       if(dev==0){
 
-	auto& C=SO3_cgbank.getf(CGindex(l1,l2,l));
-	cnine::MultiLoop(B,[&](const int b){
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+	GElibMultiLoop(B,[&](const int b){
 	    cnine::Ctensor2_view r=_r.slice0(b);
+	    cnine::Ctensor3_view x=_x.slice0(b);
+
+	    // Each nonzero is a real-coefficient axpy across the channel
+	    // axis, so when the channels are contiguous the sweep runs
+	    // through the vectorized cmadd kernels (zero-based indices).
+	    if(r.s1==1 && x.s2==1){
+	      for(auto& nz: C.nonzeros)
+		SO3part_cmadd_planar(r.arr+nz.m*r.s0+offs,r.arrc+nz.m*r.s0+offs,
+		  x.arr+nz.m1*x.s0+nz.m2*x.s1,x.arrc+nz.m1*x.s0+nz.m2*x.s1,nz.c,0,N);
+	      return;
+	    }
+	    if(r.s1==2 && r.arrc==r.arr+1 && x.s2==2 && x.arrc==x.arr+1){
+	      for(auto& nz: C.nonzeros)
+		SO3part_cmadd(r.arr+nz.m*r.s0+2*offs,
+		  x.arr+nz.m1*x.s0+nz.m2*x.s1,nz.c,0,N);
+	      return;
+	    }
+
 	    r.arr+=l*r.s0+offs*r.s1;
 	    r.arrc+=l*r.s0+offs*r.s1;
-	    cnine::Ctensor3_view x=_x.slice0(b);
 	    x.arr=x.arr+l1*x.s0+l2*x.s1;
 	    x.arrc=x.arrc+l1*x.s0+l2*x.s1;
 	    for(int m1=-l1; m1<=l1; m1++){
@@ -15,8 +15,9 @@
 #include "CtensorB.hpp"
 #include "Ctensor3_view.hpp"
 #include "Ctensor4_view.hpp"
-#include "MultiLoop.hpp"
+#include "GElibThreadPool.hpp"
 #include "GElibTimer.hpp"
+#include "SO3part_addCGproduct_simd.hpp"
 
 extern GElib::SO3_CGbank SO3_cgbank;
 extern GElib::SO3_SPHgen SO3_sphGen;
@@ -24,6 +25,10 @@ extern GElib::SO3_SPHgen SO3_sphGen;
 
 namespace GElib{
 
+  #ifdef _WITH_CUDA
+  void SO3part_addCGtransform_back_cu(cnine::Ctensor4_view x, cnine::Ctensor3_view r, const int offs, const cudaStream_t& stream);
+  #endif
+
   class SO3part_addCGtransform_backFn{
   public:
 
@@ -43,12 +48,29 @@ namespace GElib{
 
       if(dev==0){
 
-	auto& C=SO3_cgbank.getf(CGindex(l1,l2,l));
-	cnine::MultiLoop(B,[&](const int b){
+	auto& C=SO3_cgbank_cached<float>(CGindex(l1,l2,l));
+	GElibMultiLoop(B,[&](const int b){
 	    cnine::Ctensor2_view r=_r.slice0(b);
+	    cnine::Ctensor3_view x=_x.slice0(b);
+
+	    // Mirror of the forward fast path: each nonzero broadcasts a
+	    // row of the gradient into one (m1,m2) cell of x as a
+	    // vectorized real-coefficient axpy over the channels.
+	    if(r.s1==1 && x.s2==1){
+	      for(auto& nz: C.nonzeros)
+		SO3part_cmadd_planar(x.arr+nz.m1*x.s0+nz.m2*x.s1,x.arrc+nz.m1*x.s0+nz.m2*x.s1,
+		  r.arr+nz.m*r.s0+offs,r.arrc+nz.m*r.s0+offs,nz.c,0,N);
+	      return;
+	    }
+	    if(r.s1==2 && r.arrc==r.arr+1 && x.s2==2 && x.arrc==x.arr+1){
+	      for(auto& nz: C.nonzeros)
+		SO3part_cmadd(x.arr+nz.m1*x.s0+nz.m2*x.s1,
+		  r.arr+nz.m*r.s0+2*offs,nz.c,0,N);
+	      return;
+	    }
+
 	    r.arr+=l*r.s0+offs*r.s1;
 	    r.arrc+=l*r.s0+offs*r.s1;
-	    cnine::Ctensor3_view x=_x.slice0(b);
 	    x.arr=x.arr+l1*x.s0+l2*x.s1;
 	    x.arrc=x.arrc+l1*x.s0+l2*x.s1;
 	    for(int m1=-l1; m1<=l1; m1++){
@@ -61,7 +83,7 @@ namespace GElib{
 	  });
 
       }else{
-	GELIB_UNIMPL();
+	CUDA_STREAM(SO3part_addCGtransform_back_cu(_x,_r,offs,stream));
       }
 
     }
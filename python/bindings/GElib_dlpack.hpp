@@ -0,0 +1,138 @@
+// This file is part of GElib, a C++/CUDA library for group
+// equivariant tensor operations.
+//
+// Copyright (c) 2025, Imre Risi Kondor
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+
+#ifndef _GElib_dlpack
+#define _GElib_dlpack
+
+#include <ATen/DLConvertor.h>
+#include <cstring>
+
+// DLPack exchange for the bindings. Export is zero-copy when the part
+// has interleaved complex storage (innermost float stride 2,
+// arrc=arr+1, i.e. torch-viewed buffers): the view is wrapped directly
+// in a DLManagedTensor (complex64, strides converted from float to
+// complex units). Natively allocated parts store the real and
+// imaginary planes separately, which no DLPack dtype can describe, so
+// for those the export interleaves into a copy owned by the capsule --
+// correct but not aliased, writes by the consumer do not reach the
+// producing object. Either way the capsule's deleter holds a Python
+// reference to the producer, so the exported buffer stays alive for as
+// long as any consumer (torch.from_dlpack, jax, ...) uses it. Import
+// goes through at::fromDLPack, which adopts the producer's buffer
+// without copying, on CPU and CUDA alike.
+
+namespace GElib{
+
+  struct GElib_dlpack_ctx{
+    pybind11::object holder;
+    DLManagedTensor tensor;
+    std::vector<int64_t> shape;
+    std::vector<int64_t> strides;
+    std::vector<float> buf;
+    float* dev_buf=nullptr;
+  };
+
+  inline pybind11::capsule GElib_to_dlpack(pybind11::object holder, float* arr, float* arrc,
+    const std::vector<int64_t>& dims, const std::vector<int64_t>& fstrides, const int dev){
+
+    GElib_dlpack_ctx* ctx=new GElib_dlpack_ctx();
+    ctx->holder=holder;
+    ctx->shape=dims;
+
+    const bool interleaved=(fstrides.back()==2 && arrc==arr+1);
+    float* data=arr;
+
+    if(interleaved){
+      ctx->strides.resize(fstrides.size());
+      for(std::size_t i=0; i<fstrides.size(); i++)
+	ctx->strides[i]=fstrides[i]/2;
+    }
+    else{
+      // Split-planar storage: interleave into a copy with standard
+      // contiguous complex strides.
+      int64_t total=1;
+      ctx->strides.resize(dims.size());
+      for(int i=(int)dims.size()-1; i>=0; i--){
+	ctx->strides[i]=total;
+	total*=dims[i];
+      }
+      if(dev==0){
+	ctx->buf.resize(2*total);
+	for(int64_t i=0; i<dims[0]; i++)
+	  for(int64_t j=0; j<dims[1]; j++)
+	    for(int64_t k=0; k<dims[2]; k++){
+	      const int64_t src=i*fstrides[0]+j*fstrides[1]+k*fstrides[2];
+	      const int64_t dst=(i*dims[1]+j)*dims[2]+k;
+	      ctx->buf[2*dst]=arr[src];
+	      ctx->buf[2*dst+1]=arrc[src];
+	    }
+	data=ctx->buf.data();
+      }
+      else{
+#ifdef _WITH_CUDA
+	GELIB_CHECK(fstrides[2]==1 && fstrides[1]==dims[2] && fstrides[0]==dims[1]*dims[2],
+	  "GElib_to_dlpack: device part is neither interleaved nor contiguous split-planar.");
+	CUDA_SAFE(cudaMalloc(&ctx->dev_buf,2*total*sizeof(float)));
+	CUDA_SAFE(cudaMemcpy2D(ctx->dev_buf,2*sizeof(float),arr,sizeof(float),
+	    sizeof(float),total,cudaMemcpyDeviceToDevice));
+	CUDA_SAFE(cudaMemcpy2D(ctx->dev_buf+1,2*sizeof(float),arrc,sizeof(float),
+	    sizeof(float),total,cudaMemcpyDeviceToDevice));
+	data=ctx->dev_buf;
+#else
+	GELIB_ERROR("GElib_to_dlpack: CUDA part in a build without CUDA support.");
+#endif
+      }
+    }
+
+    DLManagedTensor& t=ctx->tensor;
+    t.dl_tensor.data=data;
+    t.dl_tensor.device.device_type=static_cast<DLDeviceType>(dev>0? 2: 1); // kDLCUDA : kDLCPU
+    t.dl_tensor.device.device_id=(dev>0? dev-1: 0);
+    t.dl_tensor.ndim=ctx->shape.size();
+    t.dl_tensor.dtype.code=kDLComplex;
+    t.dl_tensor.dtype.bits=64;
+    t.dl_tensor.dtype.lanes=1;
+    t.dl_tensor.shape=ctx->shape.data();
+    t.dl_tensor.strides=ctx->strides.data();
+    t.dl_tensor.byte_offset=0;
+    t.manager_ctx=ctx;
+    t.deleter=[](DLManagedTensor* self){
+      GElib_dlpack_ctx* _ctx=(GElib_dlpack_ctx*)self->manager_ctx;
+#ifdef _WITH_CUDA
+      if(_ctx->dev_buf) cudaFree(_ctx->dev_buf);
+#endif
+      pybind11::gil_scoped_acquire gil;
+      delete _ctx;
+    };
+
+    // An unconsumed capsule (name still "dltensor") owns the tensor and
+    // must run the deleter itself; a consumer renames it to
+    // "used_dltensor" and takes over that responsibility.
+    return pybind11::capsule(&ctx->tensor,"dltensor",[](PyObject* cap){
+	if(std::strcmp(PyCapsule_GetName(cap),"dltensor")!=0) return;
+	DLManagedTensor* t=(DLManagedTensor*)PyCapsule_GetPointer(cap,"dltensor");
+	if(t && t->deleter) t->deleter(t);
+      });
+  }
+
+
+  inline at::Tensor GElib_from_dlpack(pybind11::object src){
+    pybind11::object ocap=pybind11::hasattr(src,"__dlpack__")? src.attr("__dlpack__")() : src;
+    pybind11::capsule cap=ocap.cast<pybind11::capsule>();
+    GELIB_ASSRT(std::strcmp(cap.name(),"dltensor")==0);
+    DLManagedTensor* t=(DLManagedTensor*)cap.get_pointer();
+    at::Tensor T=at::fromDLPack(t);
+    cap.set_name("used_dltensor");
+    return T;
+  }
+
+}
+
+#endif
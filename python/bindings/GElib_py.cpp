@@ -17,6 +17,7 @@
 
 #include "GElib_base.cpp"
 #include "GElibSession.hpp"
+#include "GElib_dlpack.hpp"
 #include "diff_class.hpp"
 
 #include "RtensorObj.hpp"
@@ -30,6 +31,7 @@
 //#include "SO3vecArray.hpp"
 
 #include "SO3partB.hpp"
+#include "SO3part_addCGproductHalfFn.hpp"
 #include "SO3vecB.hpp"
 #include "SO3mvec.hpp"
 #include "SO3weights.hpp"
@@ -142,6 +144,41 @@ PYBIND11_MODULE(TORCH_EXTENSION_NAME, m) {
       R+=SO3CGtensor(l1,l2,l);
     });
 
+#ifdef _WITH_CUDA
+  // Reduced-precision CG product on torch half/bfloat16 CUDA tensors of
+  // shape (b,2l+1,n,2) with interleaved re/im in the last axis -- the
+  // layout torch.view_as_real gives for a complex tensor. The result is
+  // accumulated into r at column offset offs; arithmetic runs in fp32
+  // on the device, rounding once on the final store (see
+  // SO3part_addCGproductHalfFn).
+  m.def("addCGproductHalf",[](at::Tensor r, const at::Tensor& x, const at::Tensor& y, const int offs){
+      GELIB_ASSRT(r.dim()==4 && x.dim()==4 && y.dim()==4);
+      GELIB_ASSRT(r.size(3)==2 && x.size(3)==2 && y.size(3)==2);
+      GELIB_ASSRT(r.is_cuda() && x.is_cuda() && y.is_cuda());
+      GELIB_ASSRT(r.is_contiguous() && x.is_contiguous() && y.is_contiguous());
+      GELIB_ASSRT(x.scalar_type()==y.scalar_type() && x.scalar_type()==r.scalar_type());
+      const int b=x.size(0);
+      const int l1=(x.size(1)-1)/2;
+      const int l2=(y.size(1)-1)/2;
+      const int l=(r.size(1)-1)/2;
+      const int N1=x.size(2);
+      const int N2=y.size(2);
+      const int rn2=r.size(2);
+      GELIB_ASSRT(y.size(0)==b && r.size(0)==b);
+      GELIB_ASSRT(offs>=0 && offs+N1*N2<=rn2);
+      if(x.scalar_type()==at::kHalf)
+	SO3part_addCGproductHalfFn()(reinterpret_cast<__half*>(r.data_ptr()),
+	  reinterpret_cast<const __half*>(x.data_ptr()),
+	  reinterpret_cast<const __half*>(y.data_ptr()),b,N1,N2,rn2,l1,l2,l,offs);
+      else if(x.scalar_type()==at::kBFloat16)
+	SO3part_addCGproductHalfFn()(reinterpret_cast<__nv_bfloat16*>(r.data_ptr()),
+	  reinterpret_cast<const __nv_bfloat16*>(x.data_ptr()),
+	  reinterpret_cast<const __nv_bfloat16*>(y.data_ptr()),b,N1,N2,rn2,l1,l2,l,offs);
+      else
+	GELIB_ERROR("addCGproductHalf requires half or bfloat16 tensors.");
+    },py::arg("r"),py::arg("x"),py::arg("y"),py::arg("offs")=0,py::call_guard<py::gil_scoped_release>());
+#endif
+
   #include "SO3partB_py.cpp"
   #include "SO3vecB_py.cpp"
   #include "SO3mvec_py.cpp"
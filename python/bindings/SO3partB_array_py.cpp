@@ -56,7 +56,7 @@ pybind11::class_<SO3partB_array>(m,"SO3partB_array",
 //.def("reduce",&SO3partB_array::reduce)
 
 //.def("apply",&SO3partB_array::rotate)
-  .def("rotate",[](const SO3partB_array& x, const SO3element& R){return SO3partB_array(x.rotate(R));})
+  .def("rotate",[](const SO3partB_array& x, const SO3element& R){return SO3partB_array(x.rotate(R));},py::call_guard<py::gil_scoped_release>())
 
   .def("gather",&SO3partB_array::add_gather,py::arg("x"),py::arg("mask"))
   .def("add_gather",[](SO3partB_array& r, const SO3partB_array& x, const cnine::Rmask1& mask){
@@ -64,15 +64,15 @@ pybind11::class_<SO3partB_array>(m,"SO3partB_array",
 
   .def("add_spharm",[](SO3partB_array& obj, at::Tensor& _X){
       RtensorA X=RtensorA::view(_X);
-      obj.add_spharm(X);})
+      obj.add_spharm(X);},py::call_guard<py::gil_scoped_release>())
 
-  .def("addCGproduct",&SO3partB_array::add_CGproduct,py::arg("x"),py::arg("y"),py::arg("offs")=0)
-  .def("addCGproduct_back0",&SO3partB_array::add_CGproduct_back0,py::arg("g"),py::arg("y"),py::arg("offs")=0)
-  .def("addCGproduct_back1",&SO3partB_array::add_CGproduct_back1,py::arg("g"),py::arg("x"),py::arg("offs")=0)
+  .def("addCGproduct",&SO3partB_array::add_CGproduct,py::arg("x"),py::arg("y"),py::arg("offs")=0,py::call_guard<py::gil_scoped_release>())
+  .def("addCGproduct_back0",&SO3partB_array::add_CGproduct_back0,py::arg("g"),py::arg("y"),py::arg("offs")=0,py::call_guard<py::gil_scoped_release>())
+  .def("addCGproduct_back1",&SO3partB_array::add_CGproduct_back1,py::arg("g"),py::arg("x"),py::arg("offs")=0,py::call_guard<py::gil_scoped_release>())
 
-  .def("addDiagCGproduct",&SO3partB_array::add_DiagCGproduct,py::arg("x"),py::arg("y"),py::arg("offs")=0)
-  .def("addDiagCGproduct_back0",&SO3partB_array::add_DiagCGproduct_back0,py::arg("g"),py::arg("y"),py::arg("offs")=0)
-  .def("addDiagCGproduct_back1",&SO3partB_array::add_DiagCGproduct_back1,py::arg("g"),py::arg("x"),py::arg("offs")=0)
+  .def("addDiagCGproduct",&SO3partB_array::add_DiagCGproduct,py::arg("x"),py::arg("y"),py::arg("offs")=0,py::call_guard<py::gil_scoped_release>())
+  .def("addDiagCGproduct_back0",&SO3partB_array::add_DiagCGproduct_back0,py::arg("g"),py::arg("y"),py::arg("offs")=0,py::call_guard<py::gil_scoped_release>())
+  .def("addDiagCGproduct_back1",&SO3partB_array::add_DiagCGproduct_back1,py::arg("g"),py::arg("x"),py::arg("offs")=0,py::call_guard<py::gil_scoped_release>())
 
   .def("add_conterpolate2d",[](SO3partB_array& r, const SO3partB_array& x, const RtensorObj& M){
       
@@ -45,6 +45,18 @@ py::class_<SO3partB>(m,"SO3partB",
 //.def("torch",&cnine::CtensorObj::torch)
   .def("torch",[](const SO3partB& x){return x.torch();})
 
+// ---- Zero-copy DLPack exchange (see GElib_dlpack.hpp) ----
+  .def("__dlpack__",[](py::object self, py::object stream){
+      SO3partB& x=self.cast<SO3partB&>();
+      cnine::Ctensor3_view v=x.view3();
+      return GElib_to_dlpack(self,v.arr,v.arrc,{v.n0,v.n1,v.n2},{v.s0,v.s1,v.s2},x.get_dev());
+    },py::arg("stream")=py::none())
+  .def("__dlpack_device__",[](const SO3partB& x){
+      return py::make_tuple((int)(x.get_dev()>0? 2: 1),(int)(x.get_dev()>0? x.get_dev()-1: 0));})
+  .def_static("from_dlpack",[](py::object src){
+      at::Tensor T=GElib_from_dlpack(src);
+      return SO3partB(cnine::CtensorB::view(T));})
+
   .def("add_to_grad",&SO3partB::add_to_grad)
   .def("get_grad",&SO3partB::get_grad)
   .def("view_of_grad",&SO3partB::view_of_grad)
@@ -67,29 +79,44 @@ py::class_<SO3partB>(m,"SO3partB",
 //  .def("add_mprod_back0",&SO3partB::add_mprod_back0)
 //  .def("add_mprod_back1",&SO3partB::add_mprod_back1)
 
-  .def("mprod",static_cast<SO3partB(SO3partB::*)(const cnine::CtensorB&)>(&SO3partB::mprod))
-  .def("add_mprod",static_cast<void(SO3partB::*)(const SO3partB&, const cnine::CtensorB&)>(&SO3partB::add_mprod))
-  .def("add_mprod_back0",static_cast<void(SO3partB::*)(const SO3partB&, const cnine::CtensorB&)>(&SO3partB::add_mprod_back0))
-  .def("add_mprod_back1_into",static_cast<void(SO3partB::*)(cnine::CtensorB&, const SO3partB&) const>(&SO3partB::add_mprod_back1_into))
+  .def("mprod",static_cast<SO3partB(SO3partB::*)(const cnine::CtensorB&)>(&SO3partB::mprod),py::call_guard<py::gil_scoped_release>())
+
+// ---- out= overloads: the result is written into a caller-provided
+// tensor through the zero-copy view path instead of allocating a fresh
+// tensor and GElib object per call, so a steady-state Python step loop
+// that preallocates its outputs runs allocation-free.
+  .def("mprod",[](SO3partB& x, const cnine::CtensorB& w, at::Tensor& out){
+      SO3partB r(cnine::CtensorB::view(out));
+      r.set_zero();
+      r.add_mprod(x,w);},
+    py::arg("w"),py::arg("out"),py::call_guard<py::gil_scoped_release>())
+  .def("add_mprod",static_cast<void(SO3partB::*)(const SO3partB&, const cnine::CtensorB&)>(&SO3partB::add_mprod),py::call_guard<py::gil_scoped_release>())
+  .def("add_mprod_back0",static_cast<void(SO3partB::*)(const SO3partB&, const cnine::CtensorB&)>(&SO3partB::add_mprod_back0),py::call_guard<py::gil_scoped_release>())
+  .def("add_mprod_back1_into",static_cast<void(SO3partB::*)(cnine::CtensorB&, const SO3partB&) const>(&SO3partB::add_mprod_back1_into),py::call_guard<py::gil_scoped_release>())
 
   .def("add_spharm",[](SO3partB& obj, const float x, const float y, const float z){
-    obj.add_spharm(x,y,z);})
+    obj.add_spharm(x,y,z);},py::call_guard<py::gil_scoped_release>())
   .def("add_spharm",[](SO3partB& obj, at::Tensor& _X){
       RtensorA X=RtensorA::view(_X);
-      obj.add_spharm(X);})
+      obj.add_spharm(X);},py::call_guard<py::gil_scoped_release>())
   .def("add_spharmB",[](SO3partB& obj, at::Tensor& _X){
       RtensorA X=RtensorA::view(_X);
-      obj.add_spharmB(X);})
+      obj.add_spharmB(X);},py::call_guard<py::gil_scoped_release>())
 
-  .def("addCGproduct",&SO3partB::add_CGproduct,py::arg("x"),py::arg("y"),py::arg("offs")=0)
-  .def("addCGproduct_back0",&SO3partB::add_CGproduct_back0,py::arg("g"),py::arg("y"),py::arg("offs")=0)
-  .def("addCGproduct_back1",&SO3partB::add_CGproduct_back1,py::arg("g"),py::arg("x"),py::arg("offs")=0)
+  .def("addCGproduct",&SO3partB::add_CGproduct,py::arg("x"),py::arg("y"),py::arg("offs")=0,py::call_guard<py::gil_scoped_release>())
+  .def("addCGproduct_back0",&SO3partB::add_CGproduct_back0,py::arg("g"),py::arg("y"),py::arg("offs")=0,py::call_guard<py::gil_scoped_release>())
+  .def("addCGproduct_back1",&SO3partB::add_CGproduct_back1,py::arg("g"),py::arg("x"),py::arg("offs")=0,py::call_guard<py::gil_scoped_release>())
 
-  .def("addDiagCGproduct",&SO3partB::add_DiagCGproduct,py::arg("x"),py::arg("y"),py::arg("offs")=0)
-  .def("addDiagCGproduct_back0",&SO3partB::add_DiagCGproduct_back0,py::arg("g"),py::arg("y"),py::arg("offs")=0)
-  .def("addDiagCGproduct_back1",&SO3partB::add_DiagCGproduct_back1,py::arg("g"),py::arg("x"),py::arg("offs")=0)
+  .def("addDiagCGproduct",&SO3partB::add_DiagCGproduct,py::arg("x"),py::arg("y"),py::arg("offs")=0,py::call_guard<py::gil_scoped_release>())
+  .def("addDiagCGproduct_back0",&SO3partB::add_DiagCGproduct_back0,py::arg("g"),py::arg("y"),py::arg("offs")=0,py::call_guard<py::gil_scoped_release>())
+  .def("addDiagCGproduct_back1",&SO3partB::add_DiagCGproduct_back1,py::arg("g"),py::arg("x"),py::arg("offs")=0,py::call_guard<py::gil_scoped_release>())
 
-  .def("apply",&SO3partB::rotate)
+  .def("apply",&SO3partB::rotate,py::call_guard<py::gil_scoped_release>())
+  .def("apply",[](SO3partB& x, const SO3element& R, at::Tensor& out){
+      SO3partB r(cnine::CtensorB::view(out));
+      r.set_zero();
+      r.add_rotate(x,R);},
+    py::arg("R"),py::arg("out"),py::call_guard<py::gil_scoped_release>())
 
   .def("device",&SO3partB::get_device)
   .def("to",&SO3partB::to_device)
@@ -105,5 +132,26 @@ py::class_<SO3partB>(m,"SO3partB",
 // ---- Stand-alone functions --------------------------------------------------------------------------------
 
     
-m.def("CGproduct",[](const SO3partB& x, const SO3partB& y, const int l){return x.CGproduct(y,l);});
+m.def("CGproduct",[](const SO3partB& x, const SO3partB& y, const int l){return x.CGproduct(y,l);},py::call_guard<py::gil_scoped_release>());
+
+// out= form: overwrites the caller-provided tensor through the
+// zero-copy view path (see the method-level out= overloads above).
+m.def("CGproduct",[](const SO3partB& x, const SO3partB& y, const int l, at::Tensor& out){
+    SO3partB r(cnine::CtensorB::view(out));
+    r.set_CGproduct(x,y);},
+  py::arg("x"),py::arg("y"),py::arg("l"),py::arg("out"),py::call_guard<py::gil_scoped_release>());
+
+// Batched forms: a whole list of operand pairs plus output offsets is
+// executed in one native call with the GIL released (see
+// add_CGproduct_batch in SO3partB.hpp), so per-product binding overhead
+// is paid once per list rather than once per product.
+m.def("addCGproduct_batch",[](vector<SO3partB*>& r, vector<SO3partB*>& x, vector<SO3partB*>& y, vector<int>& offs){
+    add_CGproduct_batch(r,x,y,offs);},
+  py::arg("r"),py::arg("x"),py::arg("y"),py::arg("offs")=vector<int>(),py::call_guard<py::gil_scoped_release>());
+m.def("addCGproduct_batch_back0",[](vector<SO3partB*>& xg, vector<SO3partB*>& g, vector<SO3partB*>& y, vector<int>& offs){
+    add_CGproduct_batch_back0(xg,g,y,offs);},
+  py::arg("xg"),py::arg("g"),py::arg("y"),py::arg("offs")=vector<int>(),py::call_guard<py::gil_scoped_release>());
+m.def("addCGproduct_batch_back1",[](vector<SO3partB*>& yg, vector<SO3partB*>& g, vector<SO3partB*>& x, vector<int>& offs){
+    add_CGproduct_batch_back1(yg,g,x,offs);},
+  py::arg("yg"),py::arg("g"),py::arg("x"),py::arg("offs")=vector<int>(),py::call_guard<py::gil_scoped_release>());
 
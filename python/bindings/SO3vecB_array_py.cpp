@@ -26,33 +26,57 @@ py::class_<SO3vecB_array>(m,"SO3vecB_array",
       return r;
     })
 
-  .def("apply",&SO3vecB_array::rotate)
+// ---- Parallel ingestion: scatters raw dataloader buffers (one
+// contiguous complex64 tensor per part, cells in flat grid order) into
+// the native cell layout across the thread pool, with the GIL
+// released; device arrays stage through a leased pinned buffer. See
+// SO3partB_array::ingest.
+  .def("ingest",[](SO3vecB_array& x, vector<at::Tensor>& srcs){
+      vector<const float*> ptrs;
+      for(auto& s:srcs) ptrs.push_back((const float*)s.data_ptr());
+      x.ingest(ptrs);},
+    py::arg("srcs"),py::call_guard<py::gil_scoped_release>())
 
-  .def("addCGproduct",&SO3vecB_array::add_CGproduct,py::arg("x"),py::arg("y"))
-  .def("addCGproduct_back0",&SO3vecB_array::add_CGproduct_back0,py::arg("g"),py::arg("y"))
-  .def("addCGproduct_back1",&SO3vecB_array::add_CGproduct_back1,py::arg("g"),py::arg("x"))
+  .def("apply",&SO3vecB_array::rotate,py::call_guard<py::gil_scoped_release>())
 
-  .def("addDiagCGproduct",&SO3vecB_array::add_DiagCGproduct,py::arg("x"),py::arg("y"))
-  .def("addDiagCGproduct_back0",&SO3vecB_array::add_DiagCGproduct_back0,py::arg("g"),py::arg("y"))
-  .def("addDiagCGproduct_back1",&SO3vecB_array::add_DiagCGproduct_back1,py::arg("g"),py::arg("x"))
+  .def("addCGproduct",&SO3vecB_array::add_CGproduct,py::arg("x"),py::arg("y"),py::call_guard<py::gil_scoped_release>())
+  .def("addCGproduct_back0",&SO3vecB_array::add_CGproduct_back0,py::arg("g"),py::arg("y"),py::call_guard<py::gil_scoped_release>())
+  .def("addCGproduct_back1",&SO3vecB_array::add_CGproduct_back1,py::arg("g"),py::arg("x"),py::call_guard<py::gil_scoped_release>())
 
-  .def("addDiagCGproductB",&SO3vecB_array::add_DiagCGproductB,py::arg("x"),py::arg("y"))
-  .def("addDiagCGproductB_back0",&SO3vecB_array::add_DiagCGproductB_back0,py::arg("g"),py::arg("y"))
-  .def("addDiagCGproductB_back1",&SO3vecB_array::add_DiagCGproductB_back1,py::arg("g"),py::arg("x"))
+  .def("addDiagCGproduct",&SO3vecB_array::add_DiagCGproduct,py::arg("x"),py::arg("y"),py::call_guard<py::gil_scoped_release>())
+  .def("addDiagCGproduct_back0",&SO3vecB_array::add_DiagCGproduct_back0,py::arg("g"),py::arg("y"),py::call_guard<py::gil_scoped_release>())
+  .def("addDiagCGproduct_back1",&SO3vecB_array::add_DiagCGproduct_back1,py::arg("g"),py::arg("x"),py::call_guard<py::gil_scoped_release>())
 
-  .def("addDDiagCGproduct",&SO3vecB_array::add_DDiagCGproduct,py::arg("x"),py::arg("y"))
-  .def("addDDiagCGproduct_back0",&SO3vecB_array::add_DDiagCGproduct_back0,py::arg("g"),py::arg("y"))
-  .def("addDDiagCGproduct_back1",&SO3vecB_array::add_DDiagCGproduct_back1,py::arg("g"),py::arg("x"))
+  .def("addDiagCGproductB",&SO3vecB_array::add_DiagCGproductB,py::arg("x"),py::arg("y"),py::call_guard<py::gil_scoped_release>())
+  .def("addDiagCGproductB_back0",&SO3vecB_array::add_DiagCGproductB_back0,py::arg("g"),py::arg("y"),py::call_guard<py::gil_scoped_release>())
+  .def("addDiagCGproductB_back1",&SO3vecB_array::add_DiagCGproductB_back1,py::arg("g"),py::arg("x"),py::call_guard<py::gil_scoped_release>())
 
-  .def("Fproduct",&SO3vecB_array::Fproduct,py::arg("y"),py::arg("maxl")=-1)
-  .def("addFproduct",&SO3vecB_array::add_Fproduct,py::arg("x"),py::arg("y"),py::arg("method")=0)
-  .def("addFproduct_back0",&SO3vecB_array::add_Fproduct_back0,py::arg("g"),py::arg("y"),py::arg("method")=0)
-  .def("addFproduct_back1",&SO3vecB_array::add_Fproduct_back1,py::arg("g"),py::arg("x"))
+  .def("addDDiagCGproduct",&SO3vecB_array::add_DDiagCGproduct,py::arg("x"),py::arg("y"),py::call_guard<py::gil_scoped_release>())
+  .def("addDDiagCGproduct_back0",&SO3vecB_array::add_DDiagCGproduct_back0,py::arg("g"),py::arg("y"),py::call_guard<py::gil_scoped_release>())
+  .def("addDDiagCGproduct_back1",&SO3vecB_array::add_DDiagCGproduct_back1,py::arg("g"),py::arg("x"),py::call_guard<py::gil_scoped_release>())
+
+  .def("Fproduct",&SO3vecB_array::Fproduct,py::arg("y"),py::arg("maxl")=-1,py::call_guard<py::gil_scoped_release>())
+  .def("addFproduct",&SO3vecB_array::add_Fproduct,py::arg("x"),py::arg("y"),py::arg("method")=0,py::call_guard<py::gil_scoped_release>())
+  .def("addFproduct_back0",&SO3vecB_array::add_Fproduct_back0,py::arg("g"),py::arg("y"),py::arg("method")=0,py::call_guard<py::gil_scoped_release>())
+  .def("addFproduct_back1",&SO3vecB_array::add_Fproduct_back1,py::arg("g"),py::arg("x"),py::call_guard<py::gil_scoped_release>())
 
 //.def("gather",&SO3vecB_array::add_gather,py::arg("x"),py::arg("mask"))
   .def("add_gather",[](SO3vecB_array& x, const SO3vecB_array& y, const cnine::Rmask1& mask){
       x.add_gather(y,mask);},py::arg("x"),py::arg("mask"))
 
+  .def("gather_rows",&SO3vecB_array::gather_rows,py::arg("ix"),py::call_guard<py::gil_scoped_release>())
+  .def("scatter_add_rows",&SO3vecB_array::scatter_add_rows,py::arg("x"),py::arg("ix"),py::call_guard<py::gil_scoped_release>())
+  .def("CGproduct_edges",&SO3vecB_array::CGproduct_edges,
+    py::arg("y"),py::arg("src"),py::arg("dst"),py::arg("maxl")=-1,py::call_guard<py::gil_scoped_release>())
+  .def("addCGproduct_edges",&SO3vecB_array::add_CGproduct_edges,
+    py::arg("x"),py::arg("y"),py::arg("src"),py::arg("dst"),py::call_guard<py::gil_scoped_release>())
+  .def("reduce_cells",[](const SO3vecB_array& x, const vector<int>& offs){
+      return x.reduce_cells(GElibCellOffsets(offs));},py::arg("offsets"),py::call_guard<py::gil_scoped_release>())
+  .def("broadcast_add_cells",[](SO3vecB_array& r, const SO3vecB_array& x, const vector<int>& offs){
+      r.broadcast_add_cells(x,GElibCellOffsets(offs));},py::arg("x"),py::arg("offsets"),py::call_guard<py::gil_scoped_release>())
+
+  .def("torch",[](SO3vecB_array& x){return x.torch();})
+
   .def("device",&SO3vecB_array::get_device)
   .def("to",&SO3vecB_array::to_device)
   .def("to_device",&SO3vecB_array::to_device)
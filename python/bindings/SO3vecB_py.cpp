@@ -49,6 +49,21 @@ py::class_<SO3vecB>(m,"SO3vecB",
 
   .def("torch",&SO3vecB::torch)
 
+// ---- Zero-copy DLPack exchange (see GElib_dlpack.hpp) ----
+  .def("part_dlpack",[](py::object self, const int l, py::object stream){
+      SO3vecB& x=self.cast<SO3vecB&>();
+      cnine::Ctensor3_view v=x.parts[l]->view3();
+      return GElib_to_dlpack(self,v.arr,v.arrc,{v.n0,v.n1,v.n2},{v.s0,v.s1,v.s2},x.get_dev());
+    },py::arg("l"),py::arg("stream")=py::none())
+  .def_static("from_dlpack",[](vector<py::object>& srcs){
+      SO3vecB r;
+      for(auto& s: srcs){
+	at::Tensor T=GElib_from_dlpack(s);
+	r.parts.push_back(static_cast<SO3partB*>(cnine::CtensorB::viewp(T)));
+      }
+      return r;
+    })
+
   .def("add_to_grad",&SO3vecB::add_to_grad)
   .def("add_to_part_of_grad",&SO3vecB::add_to_part_of_grad)
   .def("get_grad",&SO3vecB::get_grad)
@@ -60,29 +75,53 @@ py::class_<SO3vecB>(m,"SO3vecB",
   .def("get_maxl",&SO3vecB::get_maxl)
   .def("get_part",&SO3vecB::get_part)
 
-  .def("apply",&SO3vecB::rotate)
-
-  .def("CGproduct",&SO3vecB::CGproduct,py::arg("y"),py::arg("maxl")=-1)
-  .def("addCGproduct",&SO3vecB::add_CGproduct,py::arg("x"),py::arg("y"))
-  .def("addCGproduct_back0",&SO3vecB::add_CGproduct_back0,py::arg("g"),py::arg("y"))
-  .def("addCGproduct_back1",&SO3vecB::add_CGproduct_back1,py::arg("g"),py::arg("x"))
+  .def("apply",&SO3vecB::rotate,py::call_guard<py::gil_scoped_release>())
 
-  .def("DiagCGproduct",&SO3vecB::CGproduct,py::arg("y"),py::arg("maxl")=-1)
-  .def("addDiagCGproduct",&SO3vecB::add_DiagCGproduct,py::arg("x"),py::arg("y"))
-  .def("addDiagCGproduct_back0",&SO3vecB::add_DiagCGproduct_back0,py::arg("g"),py::arg("y"))
-  .def("addDiagCGproduct_back1",&SO3vecB::add_DiagCGproduct_back1,py::arg("g"),py::arg("x"))
-
-  .def("Fproduct",&SO3vecB::Fproduct,py::arg("y"),py::arg("maxl")=-1)
-  .def("addFproduct",&SO3vecB::add_Fproduct,py::arg("x"),py::arg("y"),py::arg("method")=0)
-  .def("addFproduct_back0",&SO3vecB::add_Fproduct_back0,py::arg("g"),py::arg("y"),py::arg("method")=0)
-  .def("addFproduct_back1",&SO3vecB::add_Fproduct_back1,py::arg("g"),py::arg("x"))
+// ---- out= overloads: the result is written into caller-provided
+// tensors through the zero-copy view path, one per part, instead of
+// allocating fresh tensors and GElib objects per call; preallocating
+// the outputs makes a steady-state Python step loop allocation-free.
+  .def("apply",[](SO3vecB& x, const SO3element& R, vector<at::Tensor>& out){
+      SO3vecB r;
+      for(auto& p:out)
+	r.parts.push_back(static_cast<SO3partB*>(cnine::CtensorB::viewp(p)));
+      r.set_zero();
+      for(int l=0; l<(int)r.parts.size(); l++)
+	r.parts[l]->add_rotate(*x.parts[l],R);},
+    py::arg("R"),py::arg("out"),py::call_guard<py::gil_scoped_release>())
 
-  .def("add_iFFT_to",&SO3vecB::add_iFFT_to)
-  .def("add_FFT",&SO3vecB::add_FFT)
+  .def("CGproduct",&SO3vecB::CGproduct,py::arg("y"),py::arg("maxl")=-1,py::call_guard<py::gil_scoped_release>())
+  .def("CGproduct",[](const SO3vecB& x, const SO3vecB& y, vector<at::Tensor>& out){
+      SO3vecB r;
+      for(auto& p:out)
+	r.parts.push_back(static_cast<SO3partB*>(cnine::CtensorB::viewp(p)));
+      r.set_CGproduct(x,y);},
+    py::arg("y"),py::arg("out"),py::call_guard<py::gil_scoped_release>())
+  .def("addCGproduct",&SO3vecB::add_CGproduct,py::arg("x"),py::arg("y"),py::call_guard<py::gil_scoped_release>())
+  .def("addCGproduct_back0",&SO3vecB::add_CGproduct_back0,py::arg("g"),py::arg("y"),py::call_guard<py::gil_scoped_release>())
+  .def("addCGproduct_back1",&SO3vecB::add_CGproduct_back1,py::arg("g"),py::arg("x"),py::call_guard<py::gil_scoped_release>())
+  .def_static("addCGproduct_back",&SO3vecB::add_CGproduct_back,
+    py::arg("xg"),py::arg("yg"),py::arg("g"),py::arg("x"),py::arg("y"),py::call_guard<py::gil_scoped_release>())
+
+  .def("DiagCGproduct",&SO3vecB::CGproduct,py::arg("y"),py::arg("maxl")=-1,py::call_guard<py::gil_scoped_release>())
+  .def("addDiagCGproduct",&SO3vecB::add_DiagCGproduct,py::arg("x"),py::arg("y"),py::call_guard<py::gil_scoped_release>())
+  .def("addDiagCGproduct_back0",&SO3vecB::add_DiagCGproduct_back0,py::arg("g"),py::arg("y"),py::call_guard<py::gil_scoped_release>())
+  .def("addDiagCGproduct_back1",&SO3vecB::add_DiagCGproduct_back1,py::arg("g"),py::arg("x"),py::call_guard<py::gil_scoped_release>())
+
+  .def("Fproduct",&SO3vecB::Fproduct,py::arg("y"),py::arg("maxl")=-1,py::call_guard<py::gil_scoped_release>())
+  .def("addFproduct",&SO3vecB::add_Fproduct,py::arg("x"),py::arg("y"),py::arg("method")=0,py::call_guard<py::gil_scoped_release>())
+  .def("addFproduct_back0",&SO3vecB::add_Fproduct_back0,py::arg("g"),py::arg("y"),py::arg("method")=0,py::call_guard<py::gil_scoped_release>())
+  .def("addFproduct_back1",&SO3vecB::add_Fproduct_back1,py::arg("g"),py::arg("x"),py::call_guard<py::gil_scoped_release>())
+
+  .def("add_iFFT_to",&SO3vecB::add_iFFT_to,py::call_guard<py::gil_scoped_release>())
+  .def("add_FFT",&SO3vecB::add_FFT,py::call_guard<py::gil_scoped_release>())
 
   .def("device",&SO3vecB::get_device)
   .def("to",&SO3vecB::to_device)
   .def("to_device",&SO3vecB::to_device)
+// Single-transfer whole-object movement: all parts cross the bus in
+// one staged copy (see SO3vecB::to_device_fused).
+  .def("to_fused",&SO3vecB::to_device_fused,py::call_guard<py::gil_scoped_release>())
 //.def("move_to",[](SO3vecB& x, const int _dev){x.move_to_device(_dev);})
 
   .def("str",&SO3vecB::str,py::arg("indent")="")
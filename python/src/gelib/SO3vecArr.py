@@ -144,8 +144,7 @@ class SO3vecArr:
     def rotate(self,R):
         "Apply the group element to this vector"
         r=SO3vecArr()
-        for l in range(0,len(self.parts)):
-            r.parts.append(_SO3partB_array.view(self.parts[l]).rotate(R).torch())
+        r.parts=list(_SO3vecB_array.view(self.parts).apply(R).torch())
         return r
 
     def __add__(self, y):
@@ -218,8 +217,39 @@ class SO3vecArr:
         r=SO3vecArr()
         r.parts=list(SO3vecArr_GatherFn.apply(_mask,*(self.parts)))
         return r
-        
-        
+
+
+    def gather_rows(self,ix):
+        """
+        Gather the listed cells into a new flat SO3vecArr; one native call covers all parts.
+        """
+        r=SO3vecArr()
+        r.parts=list(_SO3vecB_array.view(self.parts).gather_rows(ix).torch())
+        return r
+
+    def CGproduct_edges(self,y,src,dst,maxl=-1):
+        """
+        Fused gather->CGproduct->scatter_add over an edge list; one native call covers all parts.
+        """
+        r=SO3vecArr()
+        r.parts=list(_SO3vecB_array.view(self.parts).CGproduct_edges(_SO3vecB_array.view(y.parts),src,dst,maxl).torch())
+        return r
+
+    def reduce_cells(self,offsets):
+        """
+        Per-sample reduction of a CSR-packed array; offsets is the list of sample boundaries.
+        """
+        r=SO3vecArr()
+        r.parts=list(_SO3vecB_array.view(self.parts).reduce_cells(offsets).torch())
+        return r
+
+    def broadcast_add_cells(self,x,offsets):
+        """
+        Transpose of reduce_cells: adds cell s of x to every cell of sample s of this array.
+        """
+        _SO3vecB_array.view(self.parts).broadcast_add_cells(_SO3vecB_array.view(x.parts),offsets)
+
+
     ## ---- Products -----------------------------------------------------------------------------------------
 
 
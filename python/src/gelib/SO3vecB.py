@@ -84,6 +84,18 @@ class SO3vecB(torch.Tensor):
         R.obj=_SO3vecB.Fgaussian(b,_tau,_dev)
         return R
 
+    @classmethod
+    def pinned_zeros(self, b, _tau):
+        """
+        Construct a zero SO3vec object of given type _tau backed by pinned (page-locked)
+        host memory, so that a subsequent to(device,non_blocking=True) transfers each part
+        with an asynchronous copy that overlaps with compute.
+        """
+        R = SO3vecB(1)
+        R._host_tensors=[t.pin_memory() for t in _SO3vecB.zero(b,_tau,0).torch()]
+        R.obj=_SO3vecB.view(R._host_tensors)
+        return R
+
     @classmethod
     def fromTorch(self, *args):
         return SO3vecB_InitFromTorchTensorsFn.apply(*args)
@@ -140,6 +152,22 @@ class SO3vecB(torch.Tensor):
     def torch(self):
         return SO3vecB_ToTorchTensorsFn.apply(self)
 
+    def to(self, _dev, non_blocking=False):
+        """
+        Move the vector to device _dev (0=CPU, 1=first GPU, ...). When the vector is backed
+        by pinned host tensors (see pinned_zeros) the parts are transferred with torch's
+        asynchronous copy on the current stream and rewrapped on the device without a
+        further copy; otherwise this falls back to the ordinary synchronous transfer.
+        """
+        R=SO3vecB(1)
+        if _dev>0 and getattr(self,"_host_tensors",None) is not None:
+            device=torch.device("cuda",_dev-1)
+            R._device_tensors=[t.to(device,non_blocking=non_blocking) for t in self._host_tensors]
+            R.obj=_SO3vecB.view(R._device_tensors)
+            return R
+        R.obj=self.obj.to_device(_dev)
+        return R
+
     def requires_gradient_():
         pass
 
@@ -209,8 +237,11 @@ class SO3vecB_CGproductFn(torch.autograd.Function):
     def backward(ctx, g):
         xg=SO3vecB(1)
         yg=SO3vecB(1)
-        ctx.x._view_of_grad().addCGproduct_back0(ctx.r._get_grad(),ctx.y.obj)
-        ctx.y._view_of_grad().addCGproduct_back1(ctx.r._get_grad(),ctx.x.obj)
+        # Single native call for the whole vec-level backward: both
+        # operand gradients are accumulated in one fused sweep on the
+        # C++ side instead of separate back0/back1 dispatches per part.
+        _SO3vecB.addCGproduct_back(ctx.x._view_of_grad(),ctx.y._view_of_grad(),
+                                   ctx.r._get_grad(),ctx.x.obj,ctx.y.obj)
         return xg,yg,None
 
 